@@ -0,0 +1,386 @@
+#include <string.h>
+#include "xil_io.h"
+#include "pl_dev_trace.h"
+
+#if defined(__arm__)
+
+/** order an entry's words against the sequence publishing them */
+#define PL_DEV_TRACE_BARRIER() __asm__ volatile ("dmb" ::: "memory")
+
+/** wait for an access to complete before reading the counter again */
+#define PL_DEV_TRACE_SETTLE() __asm__ volatile ("dsb" ::: "memory")
+
+#else
+#include <time.h>
+
+#define PL_DEV_TRACE_BARRIER() __sync_synchronize()
+#define PL_DEV_TRACE_SETTLE()
+#endif
+
+/* an entry, complete once seq is one past its index in the ring */
+typedef struct _PlDevTraceSlot
+{
+    volatile Xuint32 seq;
+    PlDevTraceEntry entry;
+} PlDevTraceSlot;
+
+/* producers reserve at head with a compare and swap, the collector
+   alone moves tail, both only ever grow */
+typedef struct _PlDevTraceRing
+{
+    volatile Xuint32 head;
+    volatile Xuint32 tail;
+    volatile Xuint32 dropped;
+    PlDevTraceSlot slots[PL_DEV_TRACE_ENTRIES];
+} PlDevTraceRing;
+
+static PlDevTraceRing pl_dev_trace_rings[PL_DEV_TRACE_CPUS];
+static volatile int pl_dev_trace_on = 0;
+
+/* only the collector touches these */
+static PlDevTraceHistogram pl_dev_trace_table[PL_DEV_TRACE_REGS];
+static int pl_dev_trace_used = 0;
+static Xuint32 pl_dev_trace_spilled = 0;
+
+/* one past a register's place in the table, by hash, 0 for none */
+static unsigned short pl_dev_trace_index[2 * PL_DEV_TRACE_REGS];
+
+#if defined(__arm__)
+
+/// PMCCNTR
+static Xuint32 pl_dev_trace_cycles(void)
+{
+    Xuint32 cycles;
+
+    __asm__ volatile ("mrc p15, 0, %0, c9, c13, 0" : "=r" (cycles));
+
+    return cycles;
+}
+
+/// set PMCR.E and PMCNTENSET.C, leaving the count as it is
+static void pl_dev_trace_counter(void)
+{
+    Xuint32 pmcr;
+
+    __asm__ volatile ("mrc p15, 0, %0, c9, c12, 0" : "=r" (pmcr));
+    __asm__ volatile ("mcr p15, 0, %0, c9, c12, 0" :: "r" (pmcr | 1));
+    __asm__ volatile ("mcr p15, 0, %0, c9, c12, 1" :: "r" (0x80000000));
+}
+
+/// MPIDR's CPU id
+static Xuint32 pl_dev_trace_cpu(void)
+{
+    Xuint32 mpidr;
+
+    __asm__ volatile ("mrc p15, 0, %0, c0, c0, 5" : "=r" (mpidr));
+    mpidr &= 3;
+
+    return mpidr < PL_DEV_TRACE_CPUS ? mpidr : PL_DEV_TRACE_CPUS - 1;
+}
+
+#else
+
+/// the time stamp counter, or nanoseconds
+static Xuint32 pl_dev_trace_cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return (Xuint32) __builtin_ia32_rdtsc();
+#else
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (Xuint32) (now.tv_sec * 1000000000ULL + now.tv_nsec);
+#endif
+}
+
+/// always running
+static void pl_dev_trace_counter(void)
+{
+}
+
+/// the bus model is single threaded
+static Xuint32 pl_dev_trace_cpu(void)
+{
+    return 0;
+}
+
+#endif
+
+/// reserve an entry in this CPU's ring, fill it, then publish it
+static void pl_dev_trace_record(PL_DEV_TRACE_KIND kind, Xuint32 base,
+        Xuint32 offset, Xuint32 value, Xuint32 stamp, Xuint32 cycles)
+{
+    Xuint32 cpu = pl_dev_trace_cpu(), head;
+    PlDevTraceRing *ring = &pl_dev_trace_rings[cpu];
+    PlDevTraceSlot *slot;
+
+    do
+    {
+        head = ring->head;
+        if (head - ring->tail >= PL_DEV_TRACE_ENTRIES)
+        {
+            __sync_fetch_and_add(&ring->dropped, 1);
+            return;
+        }
+    } while (! __sync_bool_compare_and_swap(&ring->head, head, head + 1));
+
+    slot = &ring->slots[head & (PL_DEV_TRACE_ENTRIES - 1)];
+    slot->entry.kind   = kind;
+    slot->entry.cpu    = cpu;
+    slot->entry.base   = base;
+    slot->entry.reg    = offset / 4;
+    slot->entry.value  = value;
+    slot->entry.stamp  = stamp;
+    slot->entry.cycles = cycles;
+    PL_DEV_TRACE_BARRIER();
+    slot->seq = head + 1;
+}
+
+/// the histogram of a register, made on its first access
+static PlDevTraceHistogram * pl_dev_trace_find(Xuint32 base, Xuint32 reg)
+{
+    PlDevTraceHistogram *histogram;
+    Xuint32 i = ((base >> 12) ^ (reg * 0x9E3779B1)) >> 16;
+
+    /* probe on from the hash, the index being never more than half full */
+    for (;; i++)
+    {
+        i &= 2 * PL_DEV_TRACE_REGS - 1;
+        if (! pl_dev_trace_index[i])
+        {
+            break;
+        }
+        histogram = &pl_dev_trace_table[pl_dev_trace_index[i] - 1];
+        if (histogram->base == base && histogram->reg == reg)
+        {
+            return histogram;
+        }
+    }
+    if (pl_dev_trace_used == PL_DEV_TRACE_REGS)
+    {
+        return NULL;
+    }
+
+    pl_dev_trace_index[i] = (unsigned short) (pl_dev_trace_used + 1);
+    histogram = &pl_dev_trace_table[pl_dev_trace_used++];
+    memset(histogram, 0, sizeof(*histogram));
+    histogram->base = base;
+    histogram->reg = reg;
+    histogram->min_cycles = 0xFFFFFFFF;
+
+    return histogram;
+}
+
+/// add an entry to its register's histogram
+static void pl_dev_trace_fold(const PlDevTraceEntry *entry)
+{
+    PlDevTraceHistogram *histogram;
+    Xuint32 bucket, cycles;
+
+    if (! (histogram = pl_dev_trace_find(entry->base, entry->reg)))
+    {
+        pl_dev_trace_spilled++;
+        return;
+    }
+
+    for (bucket = 0, cycles = entry->cycles; cycles; cycles >>= 1)
+    {
+        bucket++;
+    }
+    if (bucket >= PL_DEV_TRACE_BUCKETS)
+    {
+        bucket = PL_DEV_TRACE_BUCKETS - 1;
+    }
+
+    histogram->count[entry->kind]++;
+    histogram->last = entry->value;
+    histogram->total_cycles += entry->cycles;
+    histogram->buckets[bucket]++;
+    if (entry->cycles < histogram->min_cycles)
+    {
+        histogram->min_cycles = entry->cycles;
+    }
+    if (entry->cycles > histogram->max_cycles)
+    {
+        histogram->max_cycles = entry->cycles;
+    }
+}
+
+/// empty everything and record from now on
+void pl_dev_trace_start(void)
+{
+    pl_dev_trace_on = 0;
+    PL_DEV_TRACE_BARRIER();
+    memset(pl_dev_trace_rings, 0, sizeof(pl_dev_trace_rings));
+    memset(pl_dev_trace_index, 0, sizeof(pl_dev_trace_index));
+    pl_dev_trace_used = 0;
+    pl_dev_trace_spilled = 0;
+    PL_DEV_TRACE_BARRIER();
+    pl_dev_trace_enable(1);
+}
+
+/// stop or restart recording
+void pl_dev_trace_enable(int enabled)
+{
+    if (enabled)
+    {
+        pl_dev_trace_counter();
+    }
+    pl_dev_trace_on = enabled;
+}
+
+/// drain every ring up to its first entry still being written
+int pl_dev_trace_collect(PlDevTraceEntry *entries, int max_entries)
+{
+    PlDevTraceRing *ring;
+    PlDevTraceSlot *slot;
+    Xuint32 tail;
+    int cpu, moved = 0;
+
+    for (cpu = 0; cpu < PL_DEV_TRACE_CPUS; cpu++)
+    {
+        ring = &pl_dev_trace_rings[cpu];
+        for (tail = ring->tail; tail != ring->head; tail++, moved++)
+        {
+            slot = &ring->slots[tail & (PL_DEV_TRACE_ENTRIES - 1)];
+            if (slot->seq != tail + 1)
+            {
+                break;
+            }
+            PL_DEV_TRACE_BARRIER();
+            pl_dev_trace_fold(&slot->entry);
+            if (entries && moved < max_entries)
+            {
+                entries[moved] = slot->entry;
+            }
+        }
+        PL_DEV_TRACE_BARRIER();
+        ring->tail = tail;
+    }
+
+    return moved;
+}
+
+/// every register seen so far
+int pl_dev_trace_histograms(const PlDevTraceHistogram **histograms)
+{
+    *histograms = pl_dev_trace_table;
+
+    return pl_dev_trace_used;
+}
+
+/// add up the registers of one peripheral
+int pl_dev_trace_peripheral(Xuint32 base, PlDevTraceHistogram *out)
+{
+    const PlDevTraceHistogram *histogram;
+    int i, j, regs = 0;
+
+    memset(out, 0, sizeof(*out));
+    out->base = base;
+    out->min_cycles = 0xFFFFFFFF;
+    for (i = 0; i < pl_dev_trace_used; i++)
+    {
+        histogram = &pl_dev_trace_table[i];
+        if (histogram->base != base)
+        {
+            continue;
+        }
+        for (j = 0; j < PL_DEV_TRACE_KINDS; j++)
+        {
+            out->count[j] += histogram->count[j];
+        }
+        for (j = 0; j < PL_DEV_TRACE_BUCKETS; j++)
+        {
+            out->buckets[j] += histogram->buckets[j];
+        }
+        out->last = histogram->last;
+        out->total_cycles += histogram->total_cycles;
+        if (histogram->min_cycles < out->min_cycles)
+        {
+            out->min_cycles = histogram->min_cycles;
+        }
+        if (histogram->max_cycles > out->max_cycles)
+        {
+            out->max_cycles = histogram->max_cycles;
+        }
+        regs++;
+    }
+
+    return regs;
+}
+
+/// entries which found their ring full
+Xuint32 pl_dev_trace_dropped(void)
+{
+    Xuint32 dropped = 0;
+    int cpu;
+
+    for (cpu = 0; cpu < PL_DEV_TRACE_CPUS; cpu++)
+    {
+        dropped += pl_dev_trace_rings[cpu].dropped;
+    }
+
+    return dropped;
+}
+
+/// entries which found the histograms full
+Xuint32 pl_dev_trace_unbinned(void)
+{
+    return pl_dev_trace_spilled;
+}
+
+/// PL_DEV_mReadReg, timed
+Xuint32 pl_dev_trace_read(Xuint32 base, Xuint32 offset)
+{
+    Xuint32 stamp, value;
+
+    if (! pl_dev_trace_on)
+    {
+        return Xil_In32(base + offset);
+    }
+
+    stamp = pl_dev_trace_cycles();
+    value = Xil_In32(base + offset);
+    PL_DEV_TRACE_SETTLE();
+    pl_dev_trace_record(PL_DEV_TRACE_READ, base, offset, value, stamp,
+            pl_dev_trace_cycles() - stamp);
+
+    return value;
+}
+
+/// PL_DEV_mWriteReg, timed
+void pl_dev_trace_write(Xuint32 base, Xuint32 offset, Xuint32 data)
+{
+    Xuint32 stamp;
+
+    if (! pl_dev_trace_on)
+    {
+        Xil_Out32(base + offset, data);
+        return;
+    }
+
+    stamp = pl_dev_trace_cycles();
+    Xil_Out32(base + offset, data);
+    PL_DEV_TRACE_SETTLE();
+    pl_dev_trace_record(PL_DEV_TRACE_WRITE, base, offset, data, stamp,
+            pl_dev_trace_cycles() - stamp);
+}
+
+/// PL_DEV_mReset, timed
+void pl_dev_trace_reset(Xuint32 base, Xuint32 offset, Xuint32 data)
+{
+    Xuint32 stamp;
+
+    if (! pl_dev_trace_on)
+    {
+        Xil_Out32(base + offset, data);
+        return;
+    }
+
+    stamp = pl_dev_trace_cycles();
+    Xil_Out32(base + offset, data);
+    PL_DEV_TRACE_SETTLE();
+    pl_dev_trace_record(PL_DEV_TRACE_RESET, base, offset, data, stamp,
+            pl_dev_trace_cycles() - stamp);
+}
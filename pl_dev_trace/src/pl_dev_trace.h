@@ -0,0 +1,184 @@
+/**
+ * @file pl_dev_trace.h
+ * Tracing of every PL_DEV_mWriteReg, PL_DEV_mReadReg and PL_DEV_mReset,
+ *   built in only with PL_DEV_TRACE defined. pl_dev_driver.h otherwise
+ *   expands those macros to the plain Xil_Out32 and Xil_In32 they have
+ *   always been, and nothing here is compiled in.
+ *
+ * Each access is timed with the cycle counter of the CPU making it and
+ *   recorded into that CPU's ring. A ring has one consumer,
+ *   pl_dev_trace_collect, and its producers are the code and interrupt
+ *   handlers of one CPU, which reserve entries with an atomic compare
+ *   and swap rather than a lock, so tracing never waits. Entries which
+ *   do not fit are dropped and counted. Collecting folds the entries
+ *   into a histogram per peripheral register, and hands them back in
+ *   the order each CPU made them.
+ *
+ * On target, the cycle counter is the Cortex-A9's PMCCNTR, started by
+ *   pl_dev_trace_enable on the CPU calling it, so each CPU which traces
+ *   has to call it, or pl_dev_trace_start. On the host HAL the counter
+ *   is the time stamp counter, or nanoseconds where there is none, and
+ *   every access is CPU 0's, the bus model being single threaded.
+ *
+ * One copy serves every application using pl_dev_driver.h: a build
+ *   with PL_DEV_TRACE adds this directory to its include path and
+ *   pl_dev_trace.c to its sources. It needs only xil_io.h.
+ *
+ * Copyright (c) 2026 Assured Information Security
+ *   All rights reserved.
+ *
+ * @author agent <agent@local>
+ * @version 1.00
+ */
+#include "xbasic_types.h"
+
+#ifndef PL_DEV_TRACE_H
+#define PL_DEV_TRACE_H
+
+/** CPUs with a ring of their own, higher numbered CPUs share the last */
+#define PL_DEV_TRACE_CPUS 2
+
+/** Entries a ring holds, a power of 2 */
+#define PL_DEV_TRACE_ENTRIES 1024
+
+/** Peripheral registers with a histogram, a power of 2, the rest are
+    only counted */
+#define PL_DEV_TRACE_REGS 128
+
+/** Latency buckets, bucket b counting accesses of 2^(b-1) to 2^b - 1
+    cycles, bucket 0 those of none and the last everything longer */
+#define PL_DEV_TRACE_BUCKETS 16
+
+/** What an access was */
+typedef enum _PL_DEV_TRACE_KIND
+{
+    PL_DEV_TRACE_READ,   /** PL_DEV_mReadReg   */
+    PL_DEV_TRACE_WRITE,  /** PL_DEV_mWriteReg  */
+    PL_DEV_TRACE_RESET,  /** PL_DEV_mReset     */
+    PL_DEV_TRACE_KINDS
+} PL_DEV_TRACE_KIND;
+
+/** One access, as collected */
+typedef struct _PlDevTraceEntry
+{
+    /** PL_DEV_TRACE_KIND */
+    Xuint32 kind;
+
+    /** CPU which made it */
+    Xuint32 cpu;
+
+    /** peripheral base address, and the register within it. A reset
+        is to pl_dev_driver.h's PL_DEV_SOFT_RST_SPACE_OFFSET */
+    Xuint32 base;
+    Xuint32 reg;
+
+    /** data written, or read back */
+    Xuint32 value;
+
+    /** cycle count as the access started, and cycles it took */
+    Xuint32 stamp;
+    Xuint32 cycles;
+} PlDevTraceEntry;
+
+/** Everything collected for one peripheral register */
+typedef struct _PlDevTraceHistogram
+{
+    Xuint32 base;
+    Xuint32 reg;
+
+    /** accesses of each PL_DEV_TRACE_KIND */
+    Xuint32 count[PL_DEV_TRACE_KINDS];
+
+    /** the last value written or read */
+    Xuint32 last;
+
+    /** fewest, most and all cycles an access took */
+    Xuint32 min_cycles;
+    Xuint32 max_cycles;
+    Xuint32 total_cycles;
+
+    /** accesses by cycles taken, see PL_DEV_TRACE_BUCKETS */
+    Xuint32 buckets[PL_DEV_TRACE_BUCKETS];
+} PlDevTraceHistogram;
+
+/**
+ * Empty every ring and histogram, then pl_dev_trace_enable(1). Call
+ *   before any other CPU starts tracing.
+ */
+void pl_dev_trace_start(void);
+
+/**
+ * Stop or restart recording, accesses still being made while stopped.
+ *   Restarting also starts the calling CPU's cycle counter.
+ *
+ * @param enabled non-zero to record, zero to stop
+ */
+void pl_dev_trace_enable(int enabled);
+
+/**
+ * Move the complete entries out of every ring, CPU by CPU, each in the
+ *   order it made them, into the histograms. Only one CPU may collect.
+ *
+ * @param entries where to copy them to, or NULL for histograms only
+ * @param max_entries room in entries, more are still folded in
+ * @return number of entries moved
+ */
+int pl_dev_trace_collect(PlDevTraceEntry *entries, int max_entries);
+
+/**
+ * Histograms of the peripheral registers accessed so far, in the order
+ *   their first access was collected
+ *
+ * @param histograms set to the first of them
+ * @return how many there are
+ */
+int pl_dev_trace_histograms(const PlDevTraceHistogram **histograms);
+
+/**
+ * The histograms of one peripheral's registers added up
+ *
+ * @param base peripheral base address
+ * @param out where to add them up, reg set to 0
+ * @return number of registers added up
+ */
+int pl_dev_trace_peripheral(Xuint32 base, PlDevTraceHistogram *out);
+
+/**
+ * @return entries dropped from full rings since pl_dev_trace_start
+ */
+Xuint32 pl_dev_trace_dropped(void);
+
+/**
+ * @return entries collected without a histogram, all PL_DEV_TRACE_REGS
+ *   being taken by other registers
+ */
+Xuint32 pl_dev_trace_unbinned(void);
+
+/**
+ * Traced PL_DEV_mReadReg
+ *
+ * @param base peripheral base address
+ * @param offset byte offset of the register
+ * @return the word read
+ */
+Xuint32 pl_dev_trace_read(Xuint32 base, Xuint32 offset);
+
+/**
+ * Traced PL_DEV_mWriteReg
+ *
+ * @param base peripheral base address
+ * @param offset byte offset of the register
+ * @param data the word to write
+ */
+void pl_dev_trace_write(Xuint32 base, Xuint32 offset, Xuint32 data);
+
+/**
+ * Traced PL_DEV_mReset, a write recorded as a reset
+ *
+ * @param base peripheral base address
+ * @param offset byte offset of the soft reset register
+ * @param data the reset mask to write
+ */
+void pl_dev_trace_reset(Xuint32 base, Xuint32 offset, Xuint32 data);
+
+#endif /* PL_DEV_TRACE_H */
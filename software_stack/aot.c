@@ -0,0 +1,746 @@
+#include <dlfcn.h>
+#include "aot.h"
+
+/* method forward decls */
+int Aot_translate(Aot *self, FILE *out, const char *symbol);
+Aot * Aot_bind(Aot *self, void *library, const char *symbol);
+unsigned long long Aot_run(Aot *self, Core *core, u32 *pc,
+    unsigned long long steps);
+Aot * Aot_free(Aot *self);
+
+/* what a halfword does to the PC */
+typedef enum _AotBranch
+{
+  AOT_NONE = 0,
+  AOT_B,
+  AOT_BCOND,
+  AOT_BX,
+  AOT_BLX
+} AotBranch;
+
+/* 11100 B, 1101 B<cond> but AL and SWI, 010001110 BX, 010001111 BLX */
+static AotBranch aot_branch(unsigned instruction)
+{
+  if ((instruction >> 11) == 0x1C)
+  {
+    return AOT_B;
+  }
+  if ((instruction >> 12) == 0xD && ((instruction >> 8) & 15) < 14)
+  {
+    return AOT_BCOND;
+  }
+  if ((instruction & 0xFF07) == 0x4700)
+  {
+    return instruction & 0x80 ? AOT_BLX : AOT_BX;
+  }
+
+  return AOT_NONE;
+}
+
+/* destination of a B or B<cond> at a byte address */
+static u32 aot_target(unsigned instruction, u32 address)
+{
+  int offset = (instruction >> 11) == 0x1C
+    ? (int) ((instruction & 0x7FF) ^ 0x400) - 0x400
+    : (int) ((instruction & 0xFF) ^ 0x80) - 0x80;
+
+  return address + 4 + 2 * offset;
+}
+
+/* B<cond> conditions, as C over the flags, and the flags they read */
+static const char *aot_conds[14] =
+{
+  "z", "! z", "c", "! c", "n", "! n", "v", "! v",
+  "c && ! z", "! c || z", "n == v", "n != v", "! z && n == v", "z || n != v"
+};
+static const unsigned aot_condReads[14] =
+{
+  AOT_Z, AOT_Z, AOT_C, AOT_C, AOT_N, AOT_N, AOT_V, AOT_V,
+  AOT_C | AOT_Z, AOT_C | AOT_Z, AOT_N | AOT_V, AOT_N | AOT_V,
+  AOT_N | AOT_Z | AOT_V, AOT_N | AOT_Z | AOT_V
+};
+
+/* the same conditions, for the interpreter */
+static int aot_taken(CoreState *state, unsigned cond)
+{
+  switch (cond)
+  {
+    case 0:  return state->z;
+    case 1:  return ! state->z;
+    case 2:  return state->c;
+    case 3:  return ! state->c;
+    case 4:  return state->n;
+    case 5:  return ! state->n;
+    case 6:  return state->v;
+    case 7:  return ! state->v;
+    case 8:  return state->c && ! state->z;
+    case 9:  return ! state->c || state->z;
+    case 10: return state->n == state->v;
+    case 11: return state->n != state->v;
+    case 12: return ! state->z && state->n == state->v;
+    default: return state->z || state->n != state->v;
+  }
+}
+
+/* flags an instruction always writes, and those it reads */
+static unsigned aot_flags(unsigned instruction, unsigned *reads)
+{
+  *reads = 0;
+  switch (aot_branch(instruction))
+  {
+    case AOT_BCOND:
+      *reads = aot_condReads[(instruction >> 8) & 15];
+      return 0;
+    case AOT_NONE:
+      break;
+    default:
+      return 0;
+  }
+
+  switch (core_opcode(instruction))
+  {
+    case CORE_LSL_RD_RM_I:
+      return (instruction >> 6) & 31 ? AOT_N | AOT_Z | AOT_C : AOT_N | AOT_Z;
+    case CORE_LSR_RD_RM_I:
+    case CORE_ASR_RD_RM_I:
+      return AOT_N | AOT_Z | AOT_C;
+
+    /* a shift by a register of 0 leaves C alone */
+    case CORE_MOV_RD_I:
+    case CORE_AND_RD_RM:
+    case CORE_EOR_RD_RM:
+    case CORE_LSL_RD_RS:
+    case CORE_LSR_RD_RS:
+    case CORE_ASR_RD_RS:
+    case CORE_ROR_RD_RS:
+    case CORE_TST_RM_RN:
+    case CORE_ORR_RD_RM:
+    case CORE_MUL_RD_RM:
+    case CORE_BIC_RM_RN:
+    case CORE_MVN_RD_RM:
+      return AOT_N | AOT_Z;
+
+    case CORE_ADC_RD_RM:
+    case CORE_SBC_RD_RM:
+      *reads = AOT_C;
+      return AOT_NZCV;
+
+    case CORE_ADD_RD_RM:
+    case CORE_MOV_RD_RM:
+    case CORE_NUM_OPCODES:
+      return 0;
+
+    default:
+      return AOT_NZCV;
+  }
+}
+
+/* constructor */
+Aot * newAot(const unsigned char *bytes, size_t count)
+{
+  Aot *self = (Aot *) malloc(sizeof(Aot));
+  unsigned i;
+  u32 target;
+
+  /* out of memory */
+  if (! self)
+  {
+    return NULL;
+  }
+
+  /* zero */
+  memset(self, 0, sizeof(Aot));
+
+  /* bind methods */
+  self->translate = Aot_translate;
+  self->bind      = Aot_bind;
+  self->run       = Aot_run;
+  self->free      = Aot_free;
+
+  if (
+         ! (self->code = (unsigned short *)
+            calloc(count + 1, sizeof(unsigned short)))
+      || ! (self->leader = (unsigned char *) calloc(count + 1, 1))
+      )
+  {
+    return self->free(self);
+  }
+  self->count = count;
+
+  /* blocks start at 0, at static destinations, and after branches */
+  for (i = 0; i < count; i++)
+  {
+    self->code[i] = bytes[2 * i] | (bytes[2 * i + 1] << 8);
+  }
+  self->leader[0] = 1;
+  for (i = 0; i < count; i++)
+  {
+    switch (aot_branch(self->code[i]))
+    {
+      case AOT_B:
+      case AOT_BCOND:
+        target = aot_target(self->code[i], 2 * i);
+        if (target / 2 < count)
+        {
+          self->leader[target / 2] = 1;
+        }
+        self->leader[i + 1] = 1;
+        break;
+      case AOT_BX:
+      case AOT_BLX:
+        self->leader[i + 1] = 1;
+        break;
+      default:
+        break;
+    }
+  }
+  for (i = 0; i < count; i++)
+  {
+    self->blocks += self->leader[i];
+  }
+
+  return self;
+}
+
+/* constructor */
+Aot * newAotFromStack(Stack *stack)
+{
+  Instruction *instruction;
+  unsigned char *bytes;
+  size_t count = 0;
+  Aot *self;
+
+  for (instruction = stack->trunk; instruction;
+      instruction = instruction->next)
+  {
+    count++;
+  }
+  if (! (bytes = (unsigned char *) malloc(2 * count + 2)))
+  {
+    return NULL;
+  }
+  count = 0;
+  for (instruction = stack->trunk; instruction;
+      instruction = instruction->next)
+  {
+    bytes[2 * count]     = instruction->binary & 0xFF;
+    bytes[2 * count + 1] = (instruction->binary >> 8) & 0xFF;
+    count++;
+  }
+  self = newAot(bytes, count);
+  free(bytes);
+
+  return self;
+}
+
+/* a step at a time, branches here and everything else on the Core */
+unsigned long long aot_interpret(Core *core, const unsigned short *code,
+    unsigned count, u32 *pc, unsigned long long steps)
+{
+  CoreState *state = &core->state;
+  unsigned long long done = 0;
+  unsigned instruction;
+  u32 target;
+
+  while (done < steps && *pc / 2 < count)
+  {
+    instruction = code[*pc / 2];
+    done++;
+    switch (aot_branch(instruction))
+    {
+      case AOT_B:
+        *pc = aot_target(instruction, *pc);
+        break;
+      case AOT_BCOND:
+        *pc = aot_taken(state, (instruction >> 8) & 15)
+          ? aot_target(instruction, *pc) : *pc + 2;
+        break;
+      case AOT_BX:
+        *pc = state->r[(instruction >> 3) & 15] & ~1U;
+        break;
+      case AOT_BLX:
+        target = state->r[(instruction >> 3) & 15] & ~1U;
+        state->r[14] = (*pc + 2) | 1;
+        *pc = target;
+        break;
+      default:
+        core->step(core, instruction);
+        *pc += 2;
+        break;
+    }
+  }
+
+  return done;
+}
+
+/* the shift helper ThumbCore_shift is, for shifts by a register */
+int aot_preamble(FILE *out)
+{
+  fprintf(out,
+      "/* translated by aot.c, do not edit */\n"
+      "#include \"core.h\"\n"
+      "\n"
+      "/* 0 LSL, 1 LSR, 2 ASR, 3 ROR, C left alone for 0 */\n"
+      "static inline u32 aot_shift(unsigned kind, u32 a, unsigned amount,\n"
+      "    u32 *c)\n"
+      "{\n"
+      "  unsigned rotate = amount & 31;\n"
+      "\n"
+      "  if (! amount)\n"
+      "  {\n"
+      "    return a;\n"
+      "  }\n"
+      "  switch (kind)\n"
+      "  {\n"
+      "    case 0:\n"
+      "      *c = amount > 32 ? 0 : (u32) (((unsigned long long) a\n"
+      "          << amount) >> 32) & 1;\n"
+      "      return amount >= 32 ? 0 : a << amount;\n"
+      "    case 1:\n"
+      "      *c = amount > 32 ? 0 : (a >> (amount - 1)) & 1;\n"
+      "      return amount >= 32 ? 0 : a >> amount;\n"
+      "    case 2:\n"
+      "      if (amount >= 32)\n"
+      "      {\n"
+      "        *c = a >> 31;\n"
+      "        return *c ? 0xFFFFFFFF : 0;\n"
+      "      }\n"
+      "      *c = (a >> (amount - 1)) & 1;\n"
+      "      return (a >> amount) | (a >> 31 ? ~(0xFFFFFFFF >> amount) "
+      ": 0);\n"
+      "    default:\n"
+      "      a = rotate ? (a >> rotate) | (a << (32 - rotate)) : a;\n"
+      "      *c = a >> 31;\n"
+      "      return a;\n"
+      "  }\n"
+      "}\n");
+
+  return ferror(out);
+}
+
+/* N and Z of t_, where live */
+static void aot_emitNZ(FILE *out, unsigned live)
+{
+  if (live & AOT_N)
+  {
+    fprintf(out, " n = t_ >> 31;");
+  }
+  if (live & AOT_Z)
+  {
+    fprintf(out, " z = ! t_;");
+  }
+}
+
+/* a + b + carry, into register dest unless it is negative */
+static void aot_emitAdd(FILE *out, unsigned live, const char *a,
+    const char *b, const char *carry, int dest)
+{
+  fprintf(out, "  { u32 a_ = %s, b_ = %s, i_ = %s, t_ = a_ + b_ + i_;", a,
+      b, carry);
+  if (live & AOT_C)
+  {
+    fprintf(out, " c = (u32) (((unsigned long long) a_ + b_ + i_) >> 32);");
+  }
+  if (live & AOT_V)
+  {
+    fprintf(out, " v = (~(a_ ^ b_) & (a_ ^ t_)) >> 31;");
+  }
+  aot_emitNZ(out, live);
+  if (dest >= 0)
+  {
+    fprintf(out, " r%d = t_;", dest);
+  }
+  fprintf(out, " }\n");
+}
+
+/* t_ from an expression, setting N and Z, into dest unless negative */
+static void aot_emitLogic(FILE *out, unsigned live, const char *expression,
+    int dest)
+{
+  fprintf(out, "  { u32 t_ = %s;", expression);
+  aot_emitNZ(out, live);
+  if (dest >= 0)
+  {
+    fprintf(out, " r%d = t_;", dest);
+  }
+  fprintf(out, " }\n");
+}
+
+/* a data processing instruction, as ThumbCore_step executes it */
+static void aot_emit(FILE *out, unsigned instruction, unsigned live)
+{
+  CoreOpcode op = core_opcode(instruction);
+  int rd = instruction & 7;
+  int rm = (instruction >> 3) & 7;
+  int rn = (instruction >> 6) & 7;
+  int r8 = (instruction >> 8) & 7;
+  unsigned imm5 = (instruction >> 6) & 31;
+  unsigned imm8 = instruction & 0xFF;
+  int hd = rd | ((instruction >> 4) & 8);
+  int hm = rm | ((instruction >> 3) & 8);
+  char a[32], b[32];
+
+  switch (op)
+  {
+    case CORE_LSL_RD_RM_I:
+      fprintf(out, "  { u32 a_ = r%d, t_ = a_ << %u;", rm, imm5);
+      if (imm5 && live & AOT_C)
+      {
+        fprintf(out, " c = (a_ >> %u) & 1;", 32 - imm5);
+      }
+      aot_emitNZ(out, live);
+      fprintf(out, " r%d = t_; }\n", rd);
+      break;
+    case CORE_LSR_RD_RM_I:
+      imm5 = imm5 ? imm5 : 32;
+      if (imm5 == 32)
+      {
+        fprintf(out, "  { u32 a_ = r%d, t_ = 0;", rm);
+      }
+      else
+      {
+        fprintf(out, "  { u32 a_ = r%d, t_ = a_ >> %u;", rm, imm5);
+      }
+      if (live & AOT_C)
+      {
+        fprintf(out, " c = (a_ >> %u) & 1;", imm5 - 1);
+      }
+      aot_emitNZ(out, live);
+      fprintf(out, " r%d = t_; }\n", rd);
+      break;
+    case CORE_ASR_RD_RM_I:
+      imm5 = imm5 ? imm5 : 32;
+      if (imm5 == 32)
+      {
+        fprintf(out, "  { u32 a_ = r%d, t_ = a_ >> 31 ? 0xFFFFFFFFu : 0;",
+            rm);
+      }
+      else
+      {
+        fprintf(out, "  { u32 a_ = r%d, t_ = (a_ >> %u) | (a_ >> 31 ? "
+            "0x%08Xu : 0);", rm, imm5, ~(0xFFFFFFFFu >> imm5));
+      }
+      if (live & AOT_C)
+      {
+        fprintf(out, " c = (a_ >> %u) & 1;", imm5 - 1);
+      }
+      aot_emitNZ(out, live);
+      fprintf(out, " r%d = t_; }\n", rd);
+      break;
+
+    case CORE_ADD_RD_RM_RN:
+      sprintf(a, "r%d", rm);
+      sprintf(b, "r%d", rn);
+      aot_emitAdd(out, live, a, b, "0", rd);
+      break;
+    case CORE_SUB_RD_RM_RN:
+      sprintf(a, "r%d", rm);
+      sprintf(b, "~r%d", rn);
+      aot_emitAdd(out, live, a, b, "1", rd);
+      break;
+    case CORE_ADD_RD_RN_I:
+      sprintf(a, "r%d", rm);
+      sprintf(b, "%uu", (unsigned) rn);
+      aot_emitAdd(out, live, a, b, "0", rd);
+      break;
+    case CORE_SUB_RD_RN_I:
+      sprintf(a, "r%d", rm);
+      sprintf(b, "0x%08Xu", ~(unsigned) rn);
+      aot_emitAdd(out, live, a, b, "1", rd);
+      break;
+
+    case CORE_MOV_RD_I:
+      sprintf(a, "%uu", imm8);
+      aot_emitLogic(out, live, a, r8);
+      break;
+    case CORE_CMP_RN_I:
+    case CORE_SUB_RD_I:
+      sprintf(a, "r%d", r8);
+      sprintf(b, "0x%08Xu", ~imm8);
+      aot_emitAdd(out, live, a, b, "1", op == CORE_SUB_RD_I ? r8 : -1);
+      break;
+    case CORE_ADD_RD_I:
+      sprintf(a, "r%d", r8);
+      sprintf(b, "%uu", imm8);
+      aot_emitAdd(out, live, a, b, "0", r8);
+      break;
+
+    case CORE_AND_RD_RM:
+    case CORE_TST_RM_RN:
+      sprintf(a, "r%d & r%d", rd, rm);
+      aot_emitLogic(out, live, a, op == CORE_AND_RD_RM ? rd : -1);
+      break;
+    case CORE_EOR_RD_RM:
+      sprintf(a, "r%d ^ r%d", rd, rm);
+      aot_emitLogic(out, live, a, rd);
+      break;
+    case CORE_ORR_RD_RM:
+      sprintf(a, "r%d | r%d", rd, rm);
+      aot_emitLogic(out, live, a, rd);
+      break;
+    case CORE_MUL_RD_RM:
+      sprintf(a, "r%d * r%d", rd, rm);
+      aot_emitLogic(out, live, a, rd);
+      break;
+    case CORE_BIC_RM_RN:
+      sprintf(a, "r%d & ~r%d", rd, rm);
+      aot_emitLogic(out, live, a, rd);
+      break;
+    case CORE_MVN_RD_RM:
+      sprintf(a, "~r%d", rm);
+      aot_emitLogic(out, live, a, rd);
+      break;
+
+    case CORE_LSL_RD_RS:
+    case CORE_LSR_RD_RS:
+    case CORE_ASR_RD_RS:
+    case CORE_ROR_RD_RS:
+      fprintf(out, "  { u32 k_ = c, t_ = aot_shift(%d, r%d, r%d & 0xFF, "
+          "&k_);", op == CORE_ROR_RD_RS ? 3 : op - CORE_LSL_RD_RS, rd, rm);
+      if (live & AOT_C)
+      {
+        fprintf(out, " c = k_;");
+      }
+      aot_emitNZ(out, live);
+      fprintf(out, " r%d = t_; }\n", rd);
+      break;
+
+    case CORE_ADC_RD_RM:
+    case CORE_SBC_RD_RM:
+      sprintf(a, "r%d", rd);
+      sprintf(b, "%sr%d", op == CORE_SBC_RD_RM ? "~" : "", rm);
+      aot_emitAdd(out, live, a, b, "c", rd);
+      break;
+    case CORE_NEG_RD_RM:
+      sprintf(b, "~r%d", rm);
+      aot_emitAdd(out, live, "0", b, "1", rd);
+      break;
+    case CORE_CMP_RM_RN:
+      sprintf(a, "r%d", rd);
+      sprintf(b, "~r%d", rm);
+      aot_emitAdd(out, live, a, b, "1", -1);
+      break;
+    case CORE_CMN_RM_RN:
+      sprintf(a, "r%d", rd);
+      sprintf(b, "r%d", rm);
+      aot_emitAdd(out, live, a, b, "0", -1);
+      break;
+
+    case CORE_ADD_RD_RM:
+      fprintf(out, "  r%d += r%d;\n", hd, hm);
+      break;
+    case CORE_CMP_RM_RN_2:
+      sprintf(a, "r%d", hd);
+      sprintf(b, "~r%d", hm);
+      aot_emitAdd(out, live, a, b, "1", -1);
+      break;
+    case CORE_MOV_RD_RM:
+      fprintf(out, "  r%d = r%d;\n", hd, hm);
+      break;
+
+    /* nothing, as on the Core */
+    default:
+      break;
+  }
+}
+
+/* jump to a byte address known at translation time */
+static void aot_emitGoto(Aot *self, FILE *out, const char *indent, u32 target)
+{
+  if (target / 2 < self->count)
+  {
+    fprintf(out, "%sgoto b_%X;\n", indent, target);
+  }
+  else
+  {
+    fprintf(out, "%s{ pc_ = 0x%Xu; goto out; }\n", indent, target);
+  }
+}
+
+/* a label per block, liveness of the flags run backwards over each */
+int Aot_translate(Aot *self, FILE *out, const char *symbol)
+{
+  unsigned *live, reads, writes, flags, i, start, end, instruction;
+  int indirect = 0;
+  AotBranch branch;
+
+  if (! (live = (unsigned *) malloc((self->count + 1) * sizeof(unsigned))))
+  {
+    return -1;
+  }
+  for (i = 0; i < self->count; i++)
+  {
+    indirect |= aot_branch(self->code[i]) >= AOT_BX;
+  }
+
+  fprintf(out, "\n/* %u halfwords, %u blocks */\n", self->count,
+      self->blocks);
+  fprintf(out, "unsigned long long %s(CoreState *state, u32 *pc,\n"
+      "    unsigned long long budget)\n{\n", symbol);
+  for (i = 0; i < CORE_NUM_REGS; i++)
+  {
+    fprintf(out, "  u32 r%u = state->r[%u];\n", i, i);
+  }
+  fprintf(out, "  u32 n = state->n, z = state->z, c = state->c, "
+      "v = state->v;\n");
+  fprintf(out, "  unsigned long long steps = 0;\n  u32 pc_ = *pc;\n\n");
+
+  /* every block is an entry point, and where BX and BLX go */
+  fprintf(out, "%s  switch (pc_)\n  {\n", indirect ? "dispatch:\n" : "");
+  for (i = 0; i < self->count; i++)
+  {
+    if (self->leader[i])
+    {
+      fprintf(out, "    case 0x%X: goto b_%X;\n", 2 * i, 2 * i);
+    }
+  }
+  fprintf(out, "    default: goto out;\n  }\n");
+
+  for (start = 0; start < self->count; start = end)
+  {
+    for (end = start + 1; end < self->count && ! self->leader[end]; end++);
+
+    /* flags live after each instruction, all of them leaving the block */
+    for (flags = AOT_NZCV, i = end; i-- > start;)
+    {
+      live[i] = flags;
+      writes = aot_flags(self->code[i], &reads);
+      flags = (flags & ~writes) | reads;
+    }
+
+    fprintf(out, "\nb_%X:\n", 2 * start);
+    fprintf(out, "  if (budget - steps < %u) { pc_ = 0x%Xu; goto out; }\n",
+        end - start, 2 * start);
+    fprintf(out, "  steps += %u;\n", end - start);
+    for (i = start; i < end; i++)
+    {
+      aot_emit(out, self->code[i], live[i]);
+    }
+
+    instruction = self->code[end - 1];
+    branch = aot_branch(instruction);
+    switch (branch)
+    {
+      case AOT_B:
+        aot_emitGoto(self, out, "  ", aot_target(instruction, 2 * end - 2));
+        continue;
+      case AOT_BCOND:
+        fprintf(out, "  if (%s)\n", aot_conds[(instruction >> 8) & 15]);
+        aot_emitGoto(self, out, "    ",
+            aot_target(instruction, 2 * end - 2));
+        break;
+      case AOT_BX:
+      case AOT_BLX:
+        fprintf(out, "  pc_ = r%u & ~1u;\n", (instruction >> 3) & 15);
+        if (branch == AOT_BLX)
+        {
+          fprintf(out, "  r14 = 0x%Xu;\n", (2 * end) | 1);
+        }
+        fprintf(out, "  goto dispatch;\n");
+        continue;
+      default:
+        break;
+    }
+
+    /* falling through */
+    if (end == self->count)
+    {
+      fprintf(out, "  pc_ = 0x%Xu;\n  goto out;\n", 2 * end);
+    }
+  }
+
+  fprintf(out, "\nout:\n");
+  for (i = 0; i < CORE_NUM_REGS; i++)
+  {
+    fprintf(out, "  state->r[%u] = r%u;\n", i, i);
+  }
+  fprintf(out, "  state->n = n;\n  state->z = z;\n  state->c = c;\n"
+      "  state->v = v;\n  *pc = pc_;\n\n  return steps;\n}\n");
+  free(live);
+
+  return ferror(out);
+}
+
+/* look the function up */
+Aot * Aot_bind(Aot *self, void *library, const char *symbol)
+{
+  if (! library || ! (self->entry = (AotEntry) dlsym(library, symbol)))
+  {
+    return NULL;
+  }
+
+  return self;
+}
+
+/* translated code as far as it goes, the interpreter for the rest */
+unsigned long long Aot_run(Aot *self, Core *core, u32 *pc,
+    unsigned long long steps)
+{
+  unsigned long long done = 0, ran;
+
+  while (done < steps && *pc / 2 < self->count)
+  {
+    if (self->entry && (ran = self->entry(&core->state, pc, steps - done)))
+    {
+      done += ran;
+      continue;
+    }
+
+    /* not the start of a block, or less budget than the next one needs */
+    done += aot_interpret(core, self->code, self->count, pc, 1);
+  }
+
+  return done;
+}
+
+/* destructor */
+Aot * Aot_free(Aot *self)
+{
+  free(self->leader);
+  free(self->code);
+  free(self);
+
+  return NULL;
+}
+
+/* cc, then dlopen */
+void * aot_compile(const char *c_path, const char *so_path,
+    const char *cflags, int *status)
+{
+  char *command, *path;
+  void *library;
+  int built;
+
+  if (status)
+  {
+    *status = -1;
+  }
+  if (! (command = (char *) malloc(strlen(c_path) + strlen(so_path)
+          + strlen(cflags) + 64)))
+  {
+    return NULL;
+  }
+  sprintf(command, "cc %s -shared -fPIC -o '%s' '%s'", cflags, so_path,
+      c_path);
+  built = system(command);
+  free(command);
+  if (status)
+  {
+    *status = built;
+  }
+  if (built)
+  {
+    return NULL;
+  }
+
+  /* dlopen only looks in the current directory given a slash */
+  if (! (path = (char *) malloc(strlen(so_path) + 3)))
+  {
+    return NULL;
+  }
+  sprintf(path, "%s%s", strchr(so_path, '/') ? "" : "./", so_path);
+  library = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+  free(path);
+
+  return library;
+}
@@ -0,0 +1,147 @@
+#ifndef __SOFT_STACK_AOT
+#define __SOFT_STACK_AOT
+
+#include "core.h"
+#include "stack.h"
+
+/** Flags, as liveness masks */
+#define AOT_N 1
+#define AOT_Z 2
+#define AOT_C 4
+#define AOT_V 8
+#define AOT_NZCV (AOT_N | AOT_Z | AOT_C | AOT_V)
+
+/**
+ * Translated code of a program: runs from the byte address in pc for at
+ *  most budget instructions, leaving pc where it stopped. It stops early,
+ *  for whoever called it to carry on interpreting, where pc is not the
+ *  start of a basic block or the next block is longer than what is left
+ *  of the budget.
+ *
+ * @param state registers and flags
+ * @param pc byte address of the next instruction
+ * @param budget most instructions to run
+ * @return instructions run
+ */
+typedef unsigned long long (*AotEntry)(CoreState *state, u32 *pc,
+    unsigned long long budget);
+
+/**
+ * An Aot translates a fixed Thumb program ahead of time into C, a function
+ *  with a label per basic block. The data processing instructions, formats
+ *  1 to 5, do what newThumbCore's Core does, each flag being computed only
+ *  where a later instruction or the end of the block can see it. B and
+ *  B<cond> become gotos, BX and BLX a switch over every block, and
+ *  anything else takes an instruction and does nothing, as the Core does.
+ *  The C is built with the host compiler into a shared object and bound
+ *  back, and run falls back to aot_interpret wherever the translated code
+ *  stops early.
+ */
+typedef struct _Aot
+{
+  /** the program, halfwords by address / 2 */
+  unsigned short *code;
+  unsigned count;
+
+  /** non-zero for every instruction starting a basic block */
+  unsigned char *leader;
+  unsigned blocks;
+
+  /** translated code once bound, or NULL to only interpret */
+  AotEntry entry;
+
+  /**
+   * Write the program as a C function, after aot_preamble in the same file
+   *
+   * @param out file to write to
+   * @param symbol name of the function
+   * @return 0, or non-zero if out could not be written
+   */
+  int (*translate)(struct _Aot *self, FILE *out, const char *symbol);
+
+  /**
+   * Run this program's translated code from a loaded shared object
+   *
+   * @param library handle from aot_compile
+   * @param symbol name translate was given
+   * @return this Aot, or NULL if there is no such symbol
+   */
+  struct _Aot * (*bind)(struct _Aot *self, void *library, const char *symbol);
+
+  /**
+   * Run on a Core's state, translated where possible and interpreted
+   *  elsewhere, until the PC leaves the program or the steps run out
+   *
+   * @param core Core, newThumbCore's, whose state the program runs on
+   * @param pc byte address of the first instruction, where it stopped after
+   * @param steps most instructions to run
+   * @return instructions run
+   */
+  unsigned long long (*run)(struct _Aot *self, Core *core, u32 *pc,
+      unsigned long long steps);
+
+  /**
+   * Destructor, the shared object stays loaded
+   *
+   * @return NULL
+   */
+  struct _Aot * (*free)(struct _Aot *self);
+
+} Aot;
+
+/**
+ * Constructor, finds the basic blocks of a binary image
+ *
+ * @param bytes little-endian instruction halfwords
+ * @param count number of halfwords
+ * @return a new Aot, or NULL if out of memory
+ */
+Aot * newAot(const unsigned char *bytes, size_t count);
+
+/**
+ * Constructor, finds the basic blocks of a Stack's Instructions in list
+ *  order
+ *
+ * @param stack Stack of the program
+ * @return a new Aot, or NULL if out of memory
+ */
+Aot * newAotFromStack(Stack *stack);
+
+/**
+ * The reference the translated code has to match: steps a Core through a
+ *  program one instruction at a time, taking B, B<cond>, BX and BLX itself
+ *
+ * @param core Core whose state the program runs on
+ * @param code halfwords of the program
+ * @param count number of halfwords
+ * @param pc byte address of the first instruction, where it stopped after
+ * @param steps most instructions to run
+ * @return instructions run
+ */
+unsigned long long aot_interpret(Core *core, const unsigned short *code,
+    unsigned count, u32 *pc, unsigned long long steps);
+
+/**
+ * Write what every translated function in a file needs, once at the top
+ *
+ * @param out file to write to
+ * @return 0, or non-zero if out could not be written
+ */
+int aot_preamble(FILE *out);
+
+/**
+ * Build a translated C file into a shared object with the host compiler,
+ *  and load it
+ *
+ * @param c_path C file holding aot_preamble and translate output
+ * @param so_path shared object to write
+ * @param cflags compiler flags, including -I for core.h
+ * @param status the compiler's wait status, 0 once it built, -1 if it
+ *  could not be run, may be NULL
+ * @return a dlopen handle, or NULL if it did not build or load, dlerror
+ *  saying why only if status is 0
+ */
+void * aot_compile(const char *c_path, const char *so_path,
+    const char *cflags, int *status);
+
+#endif /* __SOFT_STACK_AOT */
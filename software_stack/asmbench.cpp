@@ -0,0 +1,282 @@
+/*
+ * Checks thumb_asm.hpp against the run time decoder and measures what
+ *  baking the decoded table into the binary saves at start up.
+ *
+ * main.c's test_instructions, written out as mnemonics, assemble at
+ *  compile time to the very bytes main.c spells by hand, or the build
+ *  fails. Then at run time: opcode_of, which the compiler decoded with,
+ *  has to agree with decode_opcode on every halfword; each mistake the
+ *  assembler is meant to refuse has to throw; and the same program is
+ *  loaded -p times each through newStack, a thumb::Program decoding its
+ *  bytes, and a thumb::Program copying the constant table.
+ *
+ * Building with -DASMBENCH_BROKEN adds a shift by 32 to the program, which
+ *  has to stop the build with operand_out_of_range.
+ *
+ * usage: asmbench [-p passes]
+ *
+ * build: cc -O2 -c stack.c decode.c
+ *        c++ -O2 -std=c++17 -I . -o asmbench asmbench.cpp stack.o decode.o
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "bench.h"
+#include "thumb_asm.hpp"
+
+/* main.c's test_instructions, a line for each pair of bytes */
+static constexpr char asmbench_source[] = R"(
+        LSL    r2, r1, #31
+        LSR    r2, r1, #31
+        ASR    r2, r1, #31
+        ADD    r3, r2, r1
+        SUB    r3, r2, r1
+        ADD    r2, r1, #7
+        SUB    r2, r1, #7
+        MOV    r1, #255
+        CMP    r1, #255
+        ADD    r1, #255
+        SUB    r1, #255
+        AND    r2, r1
+        EOR    r2, r1
+        LSL    r2, r1
+        LSR    r2, r1
+        ASR    r2, r1
+        ADC    r2, r1
+        SBC    r2, r1
+        ROR    r2, r1
+        TST    r2, r1
+        NEG    r2, r1
+        CMP    r2, r1
+        CMN    r2, r1
+        ORR    r2, r1
+        MUL    r2, r1
+        BIC    r2, r1
+        MVN    r2, r1
+        ADD    r10, r9
+        CMP    r10, r9
+        MOV    r10, r9
+        BX     r9
+        BLX    r9
+        LDR    r1, [pc, #1020]
+        STR    r3, [r2, r1]
+        STRH   r3, [r2, r1]
+        STRB   r3, [r2, r1]
+        LDRSB  r3, [r2, r1]
+        LDR    r3, [r2, r1]
+        LDRH   r3, [r2, r1]
+        LDRB   r3, [r2, r1]
+        LDRSH  r3, [r2, r1]
+        STR    r2, [r1, #124]
+        LDR    r2, [r1, #124]
+        STRB   r2, [r1, #31]
+        LDRB   r2, [r1, #31]
+        STRH   r2, [r1, #62]
+        LDRH   r2, [r1, #62]
+        STR    r1, [sp, #1020]
+        LDR    r1, [sp, #1020]
+        ADD    r1, pc, #1020
+        ADD    r1, sp, #1020
+        SUB    sp, #508
+        PUSH   {r0-r7, lr}
+        POP    {r0-r7, pc}
+        BKPT   #255
+        STMIA  r1!, {r0-r7}
+        LDMIA  r1!, {r0-r7}
+        BLE    .+2
+        .hword 0xDEFF              @ unused
+        SWI    #255
+        B      .+2
+        .hword 0xEFFF              @ the low half of a BLX, alone
+        BL     .+2                 @ 0xF7FF then 0xFFFF
+)"
+#ifdef ASMBENCH_BROKEN
+"        LSL    r2, r1, #32\n"
+#endif
+;
+
+/* the same bytes as main.c has them */
+static constexpr unsigned char asmbench_expected[] = {
+  0xCA, 0x07, 0xCA, 0x0F, 0xCA, 0x17, 0x53, 0x18, 0x53, 0x1A, 0xCA, 0x1D,
+  0xCA, 0x1F, 0xFF, 0x21, 0xFF, 0x29, 0xFF, 0x31, 0xFF, 0x39, 0x0A, 0x40,
+  0x4A, 0x40, 0x8A, 0x40, 0xCA, 0x40, 0x0A, 0x41, 0x4A, 0x41, 0x8A, 0x41,
+  0xCA, 0x41, 0x0A, 0x42, 0x4A, 0x42, 0x8A, 0x42, 0xCA, 0x42, 0x0A, 0x43,
+  0x4A, 0x43, 0x8A, 0x43, 0xCA, 0x43, 0xCA, 0x44, 0xCA, 0x45, 0xCA, 0x46,
+  0x48, 0x47, 0xC8, 0x47, 0xFF, 0x49, 0x53, 0x50, 0x53, 0x52, 0x53, 0x54,
+  0x53, 0x56, 0x53, 0x58, 0x53, 0x5A, 0x53, 0x5C, 0x53, 0x5E, 0xCA, 0x67,
+  0xCA, 0x6F, 0xCA, 0x77, 0xCA, 0x7F, 0xCA, 0x87, 0xCA, 0x8F, 0xFF, 0x91,
+  0xFF, 0x99, 0xFF, 0xA1, 0xFF, 0xA9, 0xFF, 0xB0, 0xFF, 0xB5, 0xFF, 0xBD,
+  0xFF, 0xBE, 0xFF, 0xC1, 0xFF, 0xC9, 0xFF, 0xDD, 0xFF, 0xDE, 0xFF, 0xDF,
+  0xFF, 0xE7, 0xFF, 0xEF, 0xFF, 0xF7, 0xFF, 0xFF
+};
+
+static constexpr auto asmbench_image = THUMB_ASSEMBLE(asmbench_source);
+
+/* labels, forward and back, and a BL pair reaching past its own halves */
+static constexpr char asmbench_loop[] = R"(
+        MOV    r3, #1
+loop:   MUL    r3, r2              @ r3 = r3 * r2
+        SUB    r1, #1
+        BNE    loop
+        BL     done
+        B      loop
+done:   BX     lr
+)";
+
+static constexpr auto asmbench_loopImage = THUMB_ASSEMBLE(asmbench_loop);
+
+template <std::size_t N>
+static constexpr bool asmbench_matches(const thumb::Image<N> &image,
+    const unsigned char *bytes, std::size_t size)
+{
+  if (size != image.bytes.size())
+  {
+    return false;
+  }
+  for (std::size_t i = 0; i < size; i++)
+  {
+    if (image.bytes[i] != bytes[i])
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+static_assert(asmbench_matches(asmbench_image, asmbench_expected,
+    sizeof(asmbench_expected)), "mnemonics differ from main.c's bytes");
+static_assert(asmbench_image.size() == 64
+    && asmbench_image[63].opcode == BL_IM8, "BL is a pair of halfwords");
+static_assert(asmbench_loopImage[3].binary == 0xD1FC
+    && asmbench_loopImage[4].binary == 0xF000
+    && asmbench_loopImage[5].binary == 0xF801, "labels resolve");
+
+/* a mistake, and what the assembler has to say about it */
+struct AsmbenchRefusal
+{
+  const char *line;
+  const char *what;
+};
+
+static const AsmbenchRefusal asmbench_refusals[] =
+{
+  { "LSL r2, r1, #32",      "operand out of range" },
+  { "ADD r2, r1, #8",       "operand out of range" },
+  { "MOV r1, #256",         "operand out of range" },
+  { "LDR r2, [r1, #126]",   "operand misaligned" },
+  { "LDRH r2, [r1, #64]",   "operand out of range" },
+  { "SUB sp, #512",         "operand out of range" },
+  { "AND r8, r1",           "only r0-r7 fit here" },
+  { "PUSH {r0, pc}",        "operands do not fit the mnemonic" },
+  { "LDMIA r1, {r0}",       "operands do not fit the mnemonic" },
+  { "LDRSB r3, [r2, #1]",   "operands do not fit the mnemonic" },
+  { "B nowhere",            "undefined label" },
+  { "B .+4096",             "operand out of range" },
+  { "BEQ .+3",              "operand misaligned" },
+  { "MOVS r1, #1",          "unknown mnemonic" },
+  { "LDR r1, [r16]",        "syntax error" },
+  { ".hword 0x10000",       "operand out of range" }
+};
+
+int main(int argc, char **argv)
+{
+  unsigned long passes = 100000, pass, sum = 0, disagree = 0, refused = 0;
+  unsigned binary;
+  double started, seconds[3];
+  Stack *stack;
+  int a;
+
+  /* options */
+  for (a = 1; a + 1 < argc && argv[a][0] == '-'; a += 2)
+  {
+    switch (argv[a][1])
+    {
+      case 'p': passes = strtoul(argv[a + 1], NULL, 0);  break;
+      default:  a = argc;                                break;
+    }
+  }
+  if (a != argc || ! passes)
+  {
+    fprintf(stderr, "usage: %s [-p passes]\n", argv[0]);
+    return 1;
+  }
+
+  /* what the compiler decoded with, against what the loader decodes with */
+  for (binary = 0; binary < 0x10000; binary++)
+  {
+    disagree += thumb::opcode_of(binary) != decode_opcode(binary);
+  }
+
+  /* the same checks, at run time, as exceptions */
+  for (const AsmbenchRefusal &refusal : asmbench_refusals)
+  {
+    try
+    {
+      thumb::assemble<1>(refusal.line);
+      printf("  accepted \"%s\"\n", refusal.line);
+    }
+    catch (const thumb::AsmError &error)
+    {
+      if (strcmp(error.what(), refusal.what))
+      {
+        printf("  \"%s\": %s\n", refusal.line, error.what());
+        continue;
+      }
+      refused++;
+    }
+  }
+
+  /* newStack, an Instruction allocated and decoded per halfword */
+  started = bench_now();
+  for (pass = 0; pass < passes; pass++)
+  {
+    stack = newStack(const_cast<unsigned char *>(
+        asmbench_image.bytes.data()), asmbench_image.size());
+    sum += stack->trunk->binary;
+    stack->free(stack);
+  }
+  seconds[0] = bench_now() - started;
+
+  /* a flat Program, decoding the bytes */
+  started = bench_now();
+  for (pass = 0; pass < passes; pass++)
+  {
+    thumb::Program program(asmbench_image.bytes.data(),
+        asmbench_image.size());
+    sum += program[pass % program.size()].opcode;
+  }
+  seconds[1] = bench_now() - started;
+
+  /* a flat Program, copying the table the compiler decoded */
+  started = bench_now();
+  for (pass = 0; pass < passes; pass++)
+  {
+    thumb::Program program = asmbench_image.program();
+    sum += program[pass % program.size()].opcode;
+  }
+  seconds[2] = bench_now() - started;
+
+  printf("program           %lu halfwords, %lu bytes of table, bytes match "
+      "main.c\n", (unsigned long) asmbench_image.size(),
+      (unsigned long) sizeof(asmbench_image.instrs));
+  printf("decoders          %lu of 65536 halfwords disagree\n", disagree);
+  printf("refusals          %lu of %lu mistakes refused as expected\n",
+      refused, (unsigned long) (sizeof(asmbench_refusals)
+      / sizeof(asmbench_refusals[0])));
+  printf("ns/program        %.1f newStack, %.1f Program decoding, "
+      "%.1f Program from table\n", seconds[0] * 1e9 / passes,
+      seconds[1] * 1e9 / passes, seconds[2] * 1e9 / passes);
+  printf("ns/instruction    %.2f, %.2f, %.2f\n",
+      seconds[0] * 1e9 / passes / asmbench_image.size(),
+      seconds[1] * 1e9 / passes / asmbench_image.size(),
+      seconds[2] * 1e9 / passes / asmbench_image.size());
+
+  /* keep the loads from being optimized away */
+  if (! sum)
+  {
+    printf("\n");
+  }
+
+  return disagree || refused != sizeof(asmbench_refusals)
+    / sizeof(asmbench_refusals[0]);
+}
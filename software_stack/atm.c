@@ -0,0 +1,175 @@
+#include "atm.h"
+
+/* method forward decls */
+u32 AtmServer_serve(AtmServer *self, AtmRequest *request, u32 clock,
+    AtmResult *result);
+AtmServer * AtmServer_free(AtmServer *self);
+
+/* a nibble, balances sign extended */
+int atm_nibble(u32 word, unsigned shift)
+{
+  int nibble = (word >> shift) & 0xF;
+
+  if (
+         (shift == ATM_CHECKING_SHIFT || shift == ATM_SAVINGS_SHIFT)
+      && nibble & 0x8
+      )
+  {
+    nibble -= 0x10;
+  }
+
+  return nibble;
+}
+
+/* constructor */
+AtmServer * newAtmServer(ConnectorModel *connector, u32 seed)
+{
+  AtmServer *self = connector ? (AtmServer *) malloc(sizeof(AtmServer))
+    : NULL;
+  unsigned i;
+
+  /* out of memory */
+  if (! self)
+  {
+    return NULL;
+  }
+
+  /* zero */
+  memset(self, 0, sizeof(AtmServer));
+
+  /* bind methods */
+  self->serve          = AtmServer_serve;
+  self->free           = AtmServer_free;
+  self->connector      = connector;
+  self->compare_clocks = 4;
+  self->update_clocks  = 8;
+
+  /* xorshift for the IDs and PINs, balances start at 0 */
+  seed = seed ? seed : 1;
+  for (i = 0; i < ATM_NUM_ACCOUNTS; i++)
+  {
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    self->accounts[i] = ((seed & 0xF) << ATM_ID_SHIFT)
+      | (((seed >> 4) & 0xF) << ATM_PIN_SHIFT);
+  }
+
+  return self;
+}
+
+/* a single word of the table over AXI, returns the clock it completes on */
+static u32 AtmServer_access(AtmServer *self, unsigned write,
+    unsigned account, u32 clock, int *denied)
+{
+  unsigned long before = self->connector->stats.denied;
+  AxiTxn txn;
+
+  txn.cycle = clock;
+  txn.write = write;
+  txn.addr  = ATM_TABLE_BASE + 4 * account;
+  txn.beats = 1;
+  txn.prot  = 0;
+  txn.user  = 0;
+  clock = self->connector->transfer(self->connector, &txn);
+  *denied = self->connector->stats.denied != before;
+
+  return clock;
+}
+
+/*
+ * Account ID -> R1, sent in ID -> R2, compare, then the same for the PIN.
+ *  A wrong ID returns straight away, as the server design has it.
+ */
+static int AtmServer_authenticate(AtmServer *self, u32 word,
+    const AtmRequest *request, u32 *clock)
+{
+  *clock += self->compare_clocks;
+  if ((unsigned) atm_nibble(word, ATM_ID_SHIFT) != request->id)
+  {
+    return 0;
+  }
+
+  *clock += self->compare_clocks;
+
+  return (unsigned) atm_nibble(word, ATM_PIN_SHIFT) == request->pin;
+}
+
+/* authenticate, then read or update a balance */
+u32 AtmServer_serve(AtmServer *self, AtmRequest *request, u32 clock,
+    AtmResult *result)
+{
+  unsigned account = request->account % ATM_NUM_ACCOUNTS;
+  unsigned shift = request->savings ? ATM_SAVINGS_SHIFT : ATM_CHECKING_SHIFT;
+  int denied, balance;
+  u32 word;
+
+  self->served[request->op]++;
+
+  clock = AtmServer_access(self, 0, account, clock, &denied);
+  word = self->accounts[account];
+  if (denied)
+  {
+    *result = ATM_DENIED;
+  }
+  else if (! AtmServer_authenticate(self, word, request, &clock))
+  {
+    *result = ATM_BAD_AUTH;
+  }
+  else if (request->op == ATM_AUTH)
+  {
+    *result = ATM_OK;
+  }
+  else
+  {
+    /* balance -> R1, add the signed amount, R1 -> balance */
+    balance = atm_nibble(word, shift);
+    if (request->op == ATM_WITHDRAW)
+    {
+      balance -= request->amount;
+    }
+    else if (request->op == ATM_DEPOSIT)
+    {
+      balance += request->amount;
+    }
+    clock += self->update_clocks;
+
+    if (balance < ATM_BALANCE_MIN || balance > ATM_BALANCE_MAX)
+    {
+      *result = ATM_REFUSED;
+      balance = atm_nibble(word, shift);
+    }
+    else if (request->op == ATM_BALANCE)
+    {
+      *result = ATM_OK;
+    }
+    else
+    {
+      clock = AtmServer_access(self, 1, account, clock, &denied);
+      if (denied)
+      {
+        *result = ATM_DENIED;
+        balance = atm_nibble(word, shift);
+      }
+      else
+      {
+        *result = ATM_OK;
+        self->accounts[account] = (word & ~(0xFU << shift))
+          | (((u32) balance & 0xF) << shift);
+      }
+    }
+    request->balance = balance;
+  }
+
+  self->results[*result]++;
+
+  return clock;
+}
+
+/* destructor */
+AtmServer * AtmServer_free(AtmServer *self)
+{
+  free(self);
+
+  return NULL;
+}
@@ -0,0 +1,133 @@
+#ifndef __SOFT_STACK_ATM
+#define __SOFT_STACK_ATM
+
+#include "connector.h"
+
+/** Accounts the bank server holds, doc/atm-descrip.txt */
+#define ATM_NUM_ACCOUNTS 64
+
+/** Nibbles of an account word */
+#define ATM_ID_SHIFT       0
+#define ATM_CHECKING_SHIFT 4
+#define ATM_SAVINGS_SHIFT  8
+#define ATM_PIN_SHIFT      12
+
+/** Balances are signed nibbles */
+#define ATM_BALANCE_MIN (-8)
+#define ATM_BALANCE_MAX 7
+
+/** Where the account table sits behind the connector, a word per account */
+#define ATM_TABLE_BASE 0x10000000
+
+/** What an ATM can ask the bank for */
+typedef enum _AtmOp
+{
+  ATM_AUTH = 0,
+  ATM_WITHDRAW,
+  ATM_DEPOSIT,
+  ATM_BALANCE,
+  ATM_NUM_OPS
+} AtmOp;
+
+/** How the bank answered */
+typedef enum _AtmResult
+{
+  /** done */
+  ATM_OK = 0,
+
+  /** the ID or PIN sent in did not match */
+  ATM_BAD_AUTH,
+
+  /** the balance would leave the range of a signed nibble */
+  ATM_REFUSED,
+
+  /** the gate denied an access to the account table */
+  ATM_DENIED,
+
+  ATM_NUM_RESULTS
+} AtmResult;
+
+/** A single request, as the ATM sends it after reading a card */
+typedef struct _AtmRequest
+{
+  AtmOp op;
+
+  /** account the card is for, its ID and the PIN the user typed */
+  unsigned account;
+  unsigned id;
+  unsigned pin;
+
+  /** non-zero for savings, zero for checking */
+  unsigned savings;
+
+  /** amount to withdraw or deposit */
+  int amount;
+
+  /** balance after the request, filled in by the bank */
+  int balance;
+
+} AtmRequest;
+
+/**
+ * An AtmServer is the bank server of doc/atm-descrip.txt. It holds the
+ *  account table, authenticates by comparing the account's ID then PIN
+ *  nibble against those sent in, and updates balances as signed nibbles.
+ *  Every table access is an AXI transaction through the connector and
+ *  gate, issued with secure AxPROT, so it only gets through while a
+ *  critical key is on KEY_IN.
+ */
+typedef struct _AtmServer
+{
+  /** the account table, the low 16 bits of each word */
+  u32 accounts[ATM_NUM_ACCOUNTS];
+
+  /** path to the table */
+  ConnectorModel *connector;
+
+  /** clocks of software around each compare and each balance update */
+  unsigned compare_clocks;
+  unsigned update_clocks;
+
+  /** requests served, by op and by result */
+  unsigned long served[ATM_NUM_OPS];
+  unsigned long results[ATM_NUM_RESULTS];
+
+  /**
+   * Serve a request
+   *
+   * @param request request, its balance is filled in
+   * @param clock clock the server starts on
+   * @param result how the request went
+   * @return clock the server finishes on
+   */
+  u32 (*serve)(struct _AtmServer *self, AtmRequest *request, u32 clock,
+      AtmResult *result);
+
+  /**
+   * Destructor, leaves the ConnectorModel alone
+   *
+   * @return NULL
+   */
+  struct _AtmServer * (*free)(struct _AtmServer *self);
+
+} AtmServer;
+
+/**
+ * Constructor, every account gets a random ID and PIN and zero balances
+ *
+ * @param connector path to the account table
+ * @param seed seed for the IDs and PINs
+ * @return a new AtmServer, or NULL if out of memory
+ */
+AtmServer * newAtmServer(ConnectorModel *connector, u32 seed);
+
+/**
+ * A nibble of an account word
+ *
+ * @param word account word
+ * @param shift one of the ATM_*_SHIFT values
+ * @return the nibble, sign extended for the balances
+ */
+int atm_nibble(u32 word, unsigned shift);
+
+#endif /* __SOFT_STACK_ATM */
@@ -0,0 +1,397 @@
+/*
+ * Load generator for the ATM reference workload on the TEE models.
+ *
+ * A number of ATMs run in the normal world, each thinking for a while
+ *  then sending the bank server a session drawn from a mix of
+ *  authentications, withdrawals, deposits and balance checks. The server
+ *  takes sessions in arrival order: it switches to the secure world
+ *  through trusted_key, serves the session over AXI through the connector
+ *  and gate, and switches back before replying. Sessions per second and
+ *  the latency the ATMs see, queueing included, show what the gate and
+ *  world switches cost end to end.
+ *
+ * usage: atmload [-a ATMs] [-c clocks] [-t mean think clocks]
+ *                [-w world switch clocks] [-m auth:withdraw:deposit:balance]
+ *                [-b bad PIN %] [-r rogue %] [-f ACLK MHz]
+ *  -w is the software cost of each switch, trusted_key itself needs 2
+ *  -r is the share of sessions served without switching worlds, which
+ *     the gate should deny
+ *
+ * build: cc -O2 -I . -I <chase_led/src> -o atmload atmload.c atm.c sim.c
+ *         key.c gate.c connector.c hal.c
+ */
+#include <time.h>
+#include "bench.h"
+#include "atm.h"
+#include "key.h"
+#include "trusted_key.h"
+
+/* keys, and the gate registers which grant their permissions */
+#define ATM_SECURE_KEY   0x5EC0E000
+#define ATM_SECURE_PERMS 0x1F
+#define ATM_NORMAL_KEY   0x0000A5A5
+#define ATM_NORMAL_PERMS TRUSTED_KEY_PERM_USER_AW
+
+/* a session from request to reply */
+typedef struct _AtmSession
+{
+  AtmRequest request;
+  AtmResult result;
+  SimTime submitted;
+  int rogue;
+} AtmSession;
+
+/* everything wired together */
+typedef struct _AtmBench
+{
+  Sim *sim;
+  KeyModel *key;
+  GateModel *gate;
+  ConnectorModel *connector;
+  AtmServer *server;
+
+  /* configuration */
+  unsigned atms;
+  SimTime end;
+  unsigned think;
+  unsigned switch_clocks;
+  unsigned mix[ATM_NUM_OPS];
+  unsigned mix_total;
+  unsigned bad_pin;
+  unsigned rogue;
+
+  /* a session per ATM, and the ATMs waiting on the server */
+  AtmSession *sessions;
+  unsigned *queue;
+  unsigned queue_head;
+  unsigned queue_count;
+  int busy;
+  SimTime busy_since;
+
+  /* results */
+  u32 *latency;
+  unsigned long completed;
+  unsigned long by_result[ATM_NUM_RESULTS];
+  unsigned long long busy_clocks;
+  unsigned long long switching_clocks;
+  SimTime last;
+} AtmBench;
+
+static void atm_enter(Sim *sim, void *owner, u32 data);
+
+/* KEY_OUT is wired to KEY_IN */
+static void atm_keyOut(KeyModel *key, u32 value)
+{
+  ConnectorModel *connector = (ConnectorModel *) key->owner;
+
+  connector->setKey(connector, value);
+}
+
+/* an ATM has thought of its next session, 'data' is the ATM */
+static void atm_submit(Sim *sim, void *owner, u32 data)
+{
+  AtmBench *bench = (AtmBench *) owner;
+  AtmSession *session = &bench->sessions[data];
+  AtmRequest *request = &session->request;
+  u32 r = bench_random(), word;
+  unsigned pick = r % bench->mix_total;
+
+  /* pick from the mix */
+  for (request->op = ATM_AUTH; pick >= bench->mix[request->op]; request->op++)
+  {
+    pick -= bench->mix[request->op];
+  }
+
+  /* the card has the account and its ID, the user types the PIN */
+  r = bench_random();
+  request->account = r % ATM_NUM_ACCOUNTS;
+  word = bench->server->accounts[request->account];
+  request->id      = (unsigned) atm_nibble(word, ATM_ID_SHIFT);
+  request->pin     = (unsigned) atm_nibble(word, ATM_PIN_SHIFT);
+  request->savings = (r >> 6) & 1;
+  request->amount  = 1 + (r >> 7) % 3;
+  if ((r >> 9) % 100 < bench->bad_pin)
+  {
+    request->pin ^= 1 + (r >> 16) % 15;
+  }
+  session->rogue = (r >> 20) % 100 < bench->rogue;
+  session->submitted = sim->now;
+
+  /* queue up, waking the server if it's idle */
+  bench->queue[(bench->queue_head + bench->queue_count++) % bench->atms] =
+    data;
+  if (! bench->busy)
+  {
+    bench->busy = 1;
+    bench->busy_since = sim->now;
+    sim->schedule(sim, 0, atm_enter, bench, 0);
+  }
+}
+
+/* the server has replied, 'data' is the ATM */
+static void atm_reply(Sim *sim, void *owner, u32 data)
+{
+  AtmBench *bench = (AtmBench *) owner;
+  AtmSession *session = &bench->sessions[data];
+
+  bench->latency[bench->completed++] = (u32) (sim->now - session->submitted);
+  bench->by_result[session->result]++;
+  bench->last = sim->now;
+
+  /* next session, unless the run is over */
+  if (sim->now < bench->end)
+  {
+    sim->schedule(sim, 1 + bench_random() % (2 * bench->think), atm_submit,
+        bench, data);
+  }
+
+  /* next in line, or idle */
+  if (bench->queue_count)
+  {
+    sim->schedule(sim, 0, atm_enter, bench, 0);
+  }
+  else
+  {
+    bench->busy = 0;
+    bench->busy_clocks += sim->now - bench->busy_since;
+  }
+}
+
+/* the server is done, back to the normal world, 'data' is the ATM */
+static void atm_exit(Sim *sim, void *owner, u32 data)
+{
+  AtmBench *bench = (AtmBench *) owner;
+
+  if (bench->sessions[data].rogue)
+  {
+    sim->schedule(sim, 0, atm_reply, bench, data);
+    return;
+  }
+
+  use_trusted_key(TRUSTED_KEY_ID_SIF);
+  bench->switching_clocks += bench->switch_clocks;
+  sim->schedule(sim, bench->switch_clocks, atm_reply, bench, data);
+}
+
+/* in the secure world, serve the session, 'data' is the ATM */
+static void atm_serve(Sim *sim, void *owner, u32 data)
+{
+  AtmBench *bench = (AtmBench *) owner;
+  AtmSession *session = &bench->sessions[data];
+  u32 done;
+
+  done = bench->server->serve(bench->server, &session->request,
+      (u32) sim->now, &session->result);
+  sim->schedule(sim, done - (u32) sim->now, atm_exit, bench, data);
+}
+
+/* take the next session off the queue and enter the secure world */
+static void atm_enter(Sim *sim, void *owner, u32 data)
+{
+  AtmBench *bench = (AtmBench *) owner;
+  unsigned atm = bench->queue[bench->queue_head];
+
+  (void) data;
+
+  bench->queue_head = (bench->queue_head + 1) % bench->atms;
+  bench->queue_count--;
+
+  /* a rogue session skips the switch */
+  if (bench->sessions[atm].rogue)
+  {
+    sim->schedule(sim, 0, atm_serve, bench, atm);
+    return;
+  }
+
+  use_trusted_key(TRUSTED_KEY_ID_CRIT);
+  bench->switching_clocks += bench->switch_clocks;
+  sim->schedule(sim, bench->switch_clocks, atm_serve, bench, atm);
+}
+
+/* ascending, for the percentiles */
+static int atm_compare(const void *a, const void *b)
+{
+  u32 x = *(const u32 *) a, y = *(const u32 *) b;
+
+  return x < y ? -1 : x > y;
+}
+
+/* latency at a percentile, of a sorted array */
+static u32 atm_percentile(AtmBench *bench, double percent)
+{
+  unsigned long at = (unsigned long) (bench->completed * percent / 100.0);
+
+  return bench->latency[at < bench->completed ? at : bench->completed - 1];
+}
+
+int main(int argc, char **argv)
+{
+  static const char *ops[ATM_NUM_OPS] =
+  {
+    "auth", "withdraw", "deposit", "balance"
+  };
+  static const char *results[ATM_NUM_RESULTS] =
+  {
+    "ok", "bad auth", "refused", "denied"
+  };
+  static const double percents[] = { 50, 90, 99, 99.9 };
+  AtmBench bench;
+  unsigned long long fired;
+  unsigned long max_sessions;
+  double mhz = 100, seconds;
+  clock_t started;
+  unsigned i;
+  int a;
+
+  memset(&bench, 0, sizeof(bench));
+  bench.atms          = 16;
+  bench.end           = 100000000;
+  bench.think         = 20000;
+  bench.switch_clocks = 200;
+  bench.mix[ATM_AUTH]     = 10;
+  bench.mix[ATM_WITHDRAW] = 30;
+  bench.mix[ATM_DEPOSIT]  = 30;
+  bench.mix[ATM_BALANCE]  = 30;
+  bench.bad_pin       = 2;
+
+  /* options */
+  for (a = 1; a + 1 < argc && argv[a][0] == '-'; a += 2)
+  {
+    switch (argv[a][1])
+    {
+      case 'a': bench.atms = strtoul(argv[a + 1], NULL, 0);           break;
+      case 'c': bench.end = strtoull(argv[a + 1], NULL, 0);           break;
+      case 't': bench.think = strtoul(argv[a + 1], NULL, 0);          break;
+      case 'w': bench.switch_clocks = strtoul(argv[a + 1], NULL, 0);  break;
+      case 'b': bench.bad_pin = strtoul(argv[a + 1], NULL, 0);        break;
+      case 'r': bench.rogue = strtoul(argv[a + 1], NULL, 0);          break;
+      case 'f': mhz = strtod(argv[a + 1], NULL);                      break;
+      case 'm':
+        if (
+               sscanf(argv[a + 1], "%u:%u:%u:%u", &bench.mix[ATM_AUTH],
+                   &bench.mix[ATM_WITHDRAW], &bench.mix[ATM_DEPOSIT],
+                   &bench.mix[ATM_BALANCE])
+            != ATM_NUM_OPS
+            )
+        {
+          a = argc;
+        }
+        break;
+      default:  a = argc;                                             break;
+    }
+  }
+  for (i = 0; i < ATM_NUM_OPS; i++)
+  {
+    bench.mix_total += bench.mix[i];
+  }
+  if (
+         a != argc
+      || ! bench.atms
+      || ! bench.think
+      || bench.switch_clocks < 2
+      || ! bench.mix_total
+      || bench.end > 0xFFFFFFFF
+      || mhz <= 0
+      )
+  {
+    fprintf(stderr, "usage: %s [-a ATMs] [-c clocks] [-t mean think clocks] "
+        "[-w world switch clocks >= 2] [-m auth:withdraw:deposit:balance] "
+        "[-b bad PIN %%] [-r rogue %%] [-f ACLK MHz]\n", argv[0]);
+    return 1;
+  }
+
+  /* every session takes at least 2 clocks, ATMs finish one past the end */
+  max_sessions = (unsigned long) (bench.end / 2) + bench.atms;
+
+  /* wire everything up */
+  if (
+         ! (bench.sim = newSim(bench.atms + 8))
+      || ! (bench.gate = newGateModel(XPAR_TRUSTED_GATE_0_BASEADDR))
+      || ! (bench.key = newKeyModel(XPAR_TRUSTED_KEY_0_BASEADDR, bench.sim))
+      || ! (bench.connector = newConnectorModel(bench.gate, 32, 8, 4, 0))
+      || ! (bench.server = newAtmServer(bench.connector, 0x5EED))
+      || ! (bench.sessions = (AtmSession *) calloc(bench.atms,
+              sizeof(AtmSession)))
+      || ! (bench.queue = (unsigned *) calloc(bench.atms, sizeof(unsigned)))
+      || ! (bench.latency = (u32 *) malloc(max_sessions * sizeof(u32)))
+      )
+  {
+    fprintf(stderr, "out of memory\n");
+    return 1;
+  }
+  bench.key->owner = bench.connector;
+  bench.key->onKey = atm_keyOut;
+
+  /* secure boot: a key per world, seal the table, enter the normal world */
+  init_trusted_key();
+  init_trusted_gate();
+  add_gate_permission(ATM_SECURE_PERMS, ATM_SECURE_KEY);
+  add_trusted_key(TRUSTED_KEY_ID_CRIT, ATM_SECURE_KEY);
+  add_gate_permission(ATM_NORMAL_PERMS, ATM_NORMAL_KEY);
+  add_trusted_key(TRUSTED_KEY_ID_SIF, ATM_NORMAL_KEY);
+  if (read_gate_key(0) != ATM_SECURE_KEY)
+  {
+    fprintf(stderr, "gate did not take the secure key\n");
+    return 1;
+  }
+  use_trusted_key(TRUSTED_KEY_ID_SIF);
+  bench.sim->run(bench.sim, 2);
+  bench.connector->clear(bench.connector);
+
+  /* the ATMs start out thinking, the run is over when the last replies */
+  for (i = 0; i < bench.atms; i++)
+  {
+    bench.sim->schedule(bench.sim, 1 + bench_random() % (2 * bench.think),
+        atm_submit, &bench, i);
+  }
+
+  started = clock();
+  fired = bench.sim->run(bench.sim, 0xFFFFFFFF);
+  seconds = (double) (clock() - started) / CLOCKS_PER_SEC;
+
+  /* report */
+  qsort(bench.latency, bench.completed, sizeof(u32), atm_compare);
+  printf("sessions          %lu over %llu clocks, %.0f/s at %.0f MHz\n",
+      bench.completed, bench.last,
+      bench.last ? bench.completed * mhz * 1e6 / bench.last : 0.0, mhz);
+  for (i = 0; i < ATM_NUM_OPS; i++)
+  {
+    printf("  %-15s %lu\n", ops[i], bench.server->served[i]);
+  }
+  for (i = 0; i < ATM_NUM_RESULTS; i++)
+  {
+    printf("  %-15s %lu\n", results[i], bench.by_result[i]);
+  }
+  if (bench.completed)
+  {
+    printf("latency           clocks    us\n");
+    for (i = 0; i < sizeof(percents) / sizeof(percents[0]); i++)
+    {
+      printf("  p%-14g %-9lu %.2f\n", percents[i],
+          (unsigned long) atm_percentile(&bench, percents[i]),
+          atm_percentile(&bench, percents[i]) / mhz);
+    }
+    printf("  %-15s %-9lu %.2f\n", "max",
+        (unsigned long) bench.latency[bench.completed - 1],
+        bench.latency[bench.completed - 1] / mhz);
+  }
+  printf("server busy       %.1f%% of clocks, %.1f%% of that switching "
+      "worlds\n",
+      bench.last ? 100.0 * bench.busy_clocks / bench.last : 0.0,
+      bench.busy_clocks ? 100.0 * bench.switching_clocks / bench.busy_clocks
+        : 0.0);
+  bench.connector->report(bench.connector, stdout, mhz * 1e6);
+  printf("host              %.2f M events/s\n",
+      seconds > 0 ? fired / seconds / 1e6 : 0.0);
+
+  free(bench.latency);
+  free(bench.queue);
+  free(bench.sessions);
+  bench.server->free(bench.server);
+  bench.connector->free(bench.connector);
+  bench.key->free(bench.key);
+  bench.gate->free(bench.gate);
+  bench.sim->free(bench.sim);
+
+  return 0;
+}
@@ -0,0 +1,153 @@
+#include "auth.h"
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+/* method forward decls */
+void Authenticator_load(Authenticator *self, const u32 *accounts);
+size_t Authenticator_check(Authenticator *self,
+    const unsigned short *requests, unsigned char *ok, size_t count);
+Authenticator * Authenticator_free(Authenticator *self);
+
+/* a field out of range sets every bit, without a branch */
+unsigned short auth_pack(unsigned account, unsigned id, unsigned pin)
+{
+  unsigned bad = (account >= ATM_NUM_ACCOUNTS) | (id > 15) | (pin > 15);
+
+  return (unsigned short) ((account << 8 | pin << 4 | id) | (0U - bad));
+}
+
+/* constructor */
+Authenticator * newAuthenticator()
+{
+  Authenticator *self = (Authenticator *) malloc(sizeof(Authenticator));
+
+  /* out of memory */
+  if (! self)
+  {
+    return NULL;
+  }
+
+  /* zero */
+  memset(self, 0, sizeof(Authenticator));
+
+  /* bind methods */
+  self->load  = Authenticator_load;
+  self->check = Authenticator_check;
+  self->free  = Authenticator_free;
+
+  /*
+   * AUTH_NO_MATCH is never an entry, so an empty table can use it as well,
+   *  every request would still be compared against it
+   */
+  memset(self->entries, 0xFF, sizeof(self->entries));
+
+  return self;
+}
+
+/* account word -> account << 8 | PIN << 4 | ID */
+void Authenticator_load(Authenticator *self, const u32 *accounts)
+{
+  unsigned i;
+
+  for (i = 0; i < ATM_NUM_ACCOUNTS; i++)
+  {
+    self->entries[i] = auth_pack(i, atm_nibble(accounts[i], ATM_ID_SHIFT),
+        atm_nibble(accounts[i], ATM_PIN_SHIFT));
+  }
+}
+
+#if defined(__AVX2__)
+
+/* AUTH_BATCH requests against every entry, returns how many passed */
+static size_t Authenticator_batch(Authenticator *self,
+    const unsigned short *requests, unsigned char *ok)
+{
+  __m256i x = _mm256_loadu_si256((const __m256i *) requests);
+  __m256i hit = _mm256_setzero_si256();
+  __m128i bytes;
+  unsigned i;
+
+  for (i = 0; i < ATM_NUM_ACCOUNTS; i++)
+  {
+    hit = _mm256_or_si256(hit,
+        _mm256_cmpeq_epi16(x, _mm256_set1_epi16((short) self->entries[i])));
+  }
+
+  /* 0xFFFF or 0 per request, down to 1 or 0 per byte */
+  bytes = _mm_packs_epi16(_mm256_castsi256_si128(hit),
+      _mm256_extracti128_si256(hit, 1));
+  _mm_storeu_si128((__m128i *) ok, _mm_and_si128(bytes, _mm_set1_epi8(1)));
+
+  return __builtin_popcount(_mm_movemask_epi8(bytes));
+}
+
+#elif defined(__SSE2__)
+
+/* AUTH_BATCH requests against every entry, returns how many passed */
+static size_t Authenticator_batch(Authenticator *self,
+    const unsigned short *requests, unsigned char *ok)
+{
+  __m128i a = _mm_loadu_si128((const __m128i *) requests);
+  __m128i b = _mm_loadu_si128((const __m128i *) (requests + 8));
+  __m128i hita = _mm_setzero_si128(), hitb = _mm_setzero_si128();
+  __m128i entry, bytes;
+  unsigned i;
+
+  for (i = 0; i < ATM_NUM_ACCOUNTS; i++)
+  {
+    entry = _mm_set1_epi16((short) self->entries[i]);
+    hita = _mm_or_si128(hita, _mm_cmpeq_epi16(a, entry));
+    hitb = _mm_or_si128(hitb, _mm_cmpeq_epi16(b, entry));
+  }
+
+  /* 0xFFFF or 0 per request, down to 1 or 0 per byte */
+  bytes = _mm_packs_epi16(hita, hitb);
+  _mm_storeu_si128((__m128i *) ok, _mm_and_si128(bytes, _mm_set1_epi8(1)));
+
+  return __builtin_popcount(_mm_movemask_epi8(bytes));
+}
+
+#endif
+
+/* every request against every entry */
+size_t Authenticator_check(Authenticator *self,
+    const unsigned short *requests, unsigned char *ok, size_t count)
+{
+  size_t passed = 0, i = 0;
+  unsigned j;
+  u32 hit;
+
+#if defined(__AVX2__) || defined(__SSE2__)
+  for (; i + AUTH_BATCH <= count; i += AUTH_BATCH)
+  {
+    passed += Authenticator_batch(self, requests + i, ok + i);
+  }
+#endif
+
+  /*
+   * whatever is left, or everything without a vector unit: x - 1 only
+   *  borrows into bit 31 when x is 0, so equality costs the same either way
+   */
+  for (; i < count; i++)
+  {
+    hit = 0;
+    for (j = 0; j < ATM_NUM_ACCOUNTS; j++)
+    {
+      hit |= ((u32) (requests[i] ^ self->entries[j]) - 1) >> 31;
+    }
+    ok[i] = (unsigned char) hit;
+    passed += hit;
+  }
+
+  return passed;
+}
+
+/* destructor */
+Authenticator * Authenticator_free(Authenticator *self)
+{
+  free(self);
+
+  return NULL;
+}
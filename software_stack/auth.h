@@ -0,0 +1,74 @@
+#ifndef __SOFT_STACK_AUTH
+#define __SOFT_STACK_AUTH
+
+#include "atm.h"
+
+/** Requests checked per pass of the vector paths */
+#define AUTH_BATCH 16
+
+/** A request which can never match, see auth_pack */
+#define AUTH_NO_MATCH 0xFFFF
+
+/**
+ * An Authenticator checks batches of ATM authentications against a packed
+ *  copy of the account table. Accounts and requests are both packed as
+ *  account << 8 | PIN << 4 | ID, so a request passes exactly when it is
+ *  equal to some entry, and every request is compared against every entry
+ *  without branching or indexing on its contents. How long a batch takes
+ *  depends only on its length, not on which accounts it names or whether
+ *  the IDs and PINs are right, unlike the one account at a time compare
+ *  of the server design which returns as soon as the ID is wrong.
+ *
+ * AVX2 and SSE2 builds check AUTH_BATCH requests at a time, anything else
+ *  falls back to a scalar loop using the same arithmetic compare.
+ */
+typedef struct _Authenticator
+{
+  /** packed entry of each account */
+  unsigned short entries[ATM_NUM_ACCOUNTS];
+
+  /**
+   * Pack an account table, as an AtmServer holds it
+   *
+   * @param accounts ATM_NUM_ACCOUNTS account words
+   */
+  void (*load)(struct _Authenticator *self, const u32 *accounts);
+
+  /**
+   * Check a batch of requests
+   *
+   * @param requests requests packed by auth_pack
+   * @param ok 1 for each request which passed, 0 for each which didn't
+   * @param count number of requests
+   * @return number of requests which passed
+   */
+  size_t (*check)(struct _Authenticator *self, const unsigned short *requests,
+      unsigned char *ok, size_t count);
+
+  /**
+   * Destructor
+   *
+   * @return NULL
+   */
+  struct _Authenticator * (*free)(struct _Authenticator *self);
+
+} Authenticator;
+
+/**
+ * Constructor, every entry starts out matching nothing
+ *
+ * @return a new Authenticator, or NULL if out of memory
+ */
+Authenticator * newAuthenticator();
+
+/**
+ * Pack a request, or an account table entry
+ *
+ * @param account account the card is for
+ * @param id ID sent in
+ * @param pin PIN sent in
+ * @return the packed request, AUTH_NO_MATCH if any field is out of range
+ */
+unsigned short auth_pack(unsigned account, unsigned id, unsigned pin);
+
+#endif /* __SOFT_STACK_AUTH */
@@ -0,0 +1,393 @@
+/*
+ * Measures the Authenticator, after checking it against the server's
+ *  compare, then looks for a timing leak. Batches which differ only in
+ *  which account they name, or in whether the ID or PIN is right, are
+ *  timed interleaved, the class of each measurement drawn at random and
+ *  its batch copied into the one buffer every measurement checks, so
+ *  the classes differ in nothing but their contents. The process is
+ *  pinned to one CPU, the first -w measurements of each run are thrown
+ *  away as warm-up, and the rest compared with Welch's t-test. The
+ *  server design's one account at a time compare goes through the same
+ *  test, to show what a leak looks like when there is one. The exit
+ *  status is 1 if the kernel leaks in any test.
+ *
+ * usage: authbench [-n requests] [-p passes] [-m measurements]
+ *                  [-b requests per measurement] [-w warm-up measurements]
+ *                  [-c CPU]
+ *  -c is the CPU to pin to, the one started on by default
+ *
+ * build: cc -O2 -march=native -I . -o authbench authbench.c auth.c atm.c
+ *         -lm
+ *  -march=native picks up the AVX2 path, SSE2 is the x86-64 default
+ */
+#define _GNU_SOURCE
+#include <math.h>
+#include <sched.h>
+#include "bench.h"
+#include "auth.h"
+
+/* |t| past this and the two classes take measurably different times */
+#define AUTHBENCH_T_LEAK 4.5
+
+/* two classes of batch to tell apart by timing */
+typedef enum _AuthbenchClass
+{
+  AUTHBENCH_FIRST_ACCOUNT = 0,
+  AUTHBENCH_LAST_ACCOUNT,
+  AUTHBENCH_RIGHT,
+  AUTHBENCH_WRONG_ID,
+  AUTHBENCH_WRONG_PIN
+} AuthbenchClass;
+
+/* keep to one CPU, so every measurement sees the same core and caches */
+static int authbench_pin(int cpu)
+{
+  cpu_set_t set;
+
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+
+  return sched_setaffinity(0, sizeof(set), &set);
+}
+
+/*
+ * The server design: walk the table loading each account into R1, and at
+ *  the one asked for compare the ID, then the PIN, returning at the first
+ *  answer. volatile keeps the walk a walk.
+ */
+static unsigned authbench_server(const volatile u32 *accounts,
+    unsigned account, unsigned id, unsigned pin)
+{
+  unsigned i;
+  u32 word;
+
+  for (i = 0; i < ATM_NUM_ACCOUNTS; i++)
+  {
+    word = accounts[i];
+    if (i == account)
+    {
+      if ((unsigned) atm_nibble(word, ATM_ID_SHIFT) != id)
+      {
+        return 0;
+      }
+
+      return (unsigned) atm_nibble(word, ATM_PIN_SHIFT) == pin;
+    }
+  }
+
+  return 0;
+}
+
+/* a batch of a class, as requests for both compares */
+static void authbench_fill(const u32 *accounts, AuthbenchClass which,
+    unsigned *account, unsigned *id, unsigned *pin, unsigned short *packed,
+    size_t count)
+{
+  size_t i;
+
+  for (i = 0; i < count; i++)
+  {
+    account[i] = bench_random() % ATM_NUM_ACCOUNTS;
+    if (which == AUTHBENCH_FIRST_ACCOUNT)
+    {
+      account[i] = 0;
+    }
+    else if (which == AUTHBENCH_LAST_ACCOUNT)
+    {
+      account[i] = ATM_NUM_ACCOUNTS - 1;
+    }
+    id[i] = atm_nibble(accounts[account[i]], ATM_ID_SHIFT);
+    pin[i] = atm_nibble(accounts[account[i]], ATM_PIN_SHIFT);
+    if (which == AUTHBENCH_WRONG_ID)
+    {
+      id[i] ^= 1 + bench_random() % 15;
+    }
+    else if (which == AUTHBENCH_WRONG_PIN)
+    {
+      pin[i] ^= 1 + bench_random() % 15;
+    }
+    packed[i] = auth_pack(account[i], id[i], pin[i]);
+  }
+}
+
+/* ascending, for the crop */
+static int authbench_compare(const void *a, const void *b)
+{
+  double x = *(const double *) a, y = *(const double *) b;
+
+  return x < y ? -1 : x > y;
+}
+
+/*
+ * Welch's t between the two classes, leaving out the slowest 5% of all
+ *  measurements, which are interrupts and the like rather than the compare
+ */
+static double authbench_welch(const double *ns, const unsigned char *in,
+    double *sorted, size_t count)
+{
+  double n[2] = { 0, 0 }, mean[2] = { 0, 0 }, m2[2] = { 0, 0 };
+  double crop, delta;
+  size_t i;
+  int c;
+
+  memcpy(sorted, ns, count * sizeof(double));
+  qsort(sorted, count, sizeof(double), authbench_compare);
+  crop = sorted[count * 95 / 100];
+
+  /* Welford's running mean and variance, per class */
+  for (i = 0; i < count; i++)
+  {
+    if (ns[i] <= crop)
+    {
+      c = in[i];
+      n[c]++;
+      delta = ns[i] - mean[c];
+      mean[c] += delta / n[c];
+      m2[c] += delta * (ns[i] - mean[c]);
+    }
+  }
+  if (n[0] < 2 || n[1] < 2)
+  {
+    return 0;
+  }
+
+  return (mean[0] - mean[1])
+    / sqrt(m2[0] / (n[0] - 1) / n[0] + m2[1] / (n[1] - 1) / n[1]);
+}
+
+int main(int argc, char **argv)
+{
+  static const struct
+  {
+    const char *name;
+    AuthbenchClass a;
+    AuthbenchClass b;
+  } tests[] =
+  {
+    { "first vs last account", AUTHBENCH_FIRST_ACCOUNT,
+        AUTHBENCH_LAST_ACCOUNT },
+    { "right vs wrong ID",     AUTHBENCH_RIGHT,    AUTHBENCH_WRONG_ID },
+    { "wrong ID vs wrong PIN", AUTHBENCH_WRONG_ID, AUTHBENCH_WRONG_PIN }
+  };
+  size_t requests = 1 << 20, measurements = 100000, batch = 256,
+         warmup = 1000, i, j, m;
+  unsigned long passes = 64, pass, errors = 0;
+  volatile unsigned long sum = 0;
+  unsigned *account, *id, *pin, *timed[3];
+  unsigned short *packed, *classes[2];
+  unsigned char *ok, *in;
+  double *ns, *sorted, started, seconds, serial, t[2];
+  u32 accounts[ATM_NUM_ACCOUNTS];
+  Authenticator *auth;
+  size_t passed;
+  unsigned test, c;
+  int a, cpu = sched_getcpu(), pinned, leaked = 0;
+
+  /* options */
+  for (a = 1; a + 1 < argc && argv[a][0] == '-'; a += 2)
+  {
+    switch (argv[a][1])
+    {
+      case 'n': requests     = strtoul(argv[a + 1], NULL, 0);  break;
+      case 'p': passes       = strtoul(argv[a + 1], NULL, 0);  break;
+      case 'm': measurements = strtoul(argv[a + 1], NULL, 0);  break;
+      case 'b': batch        = strtoul(argv[a + 1], NULL, 0);  break;
+      case 'w': warmup       = strtoul(argv[a + 1], NULL, 0);  break;
+      case 'c': cpu          = atoi(argv[a + 1]);              break;
+      default:  a = argc;                                      break;
+    }
+  }
+  if (
+         a != argc
+      || ! requests
+      || ! passes
+      || measurements < 100
+      || ! batch
+      || 3 * batch > requests
+      )
+  {
+    fprintf(stderr, "usage: %s [-n requests] [-p passes] "
+        "[-m measurements >= 100] [-b requests per measurement] "
+        "[-w warm-up measurements] [-c CPU]\n", argv[0]);
+    return 1;
+  }
+
+  if (
+         ! (account = (unsigned *) malloc(requests * sizeof(unsigned)))
+      || ! (id = (unsigned *) malloc(requests * sizeof(unsigned)))
+      || ! (pin = (unsigned *) malloc(requests * sizeof(unsigned)))
+      || ! (packed = (unsigned short *) malloc(requests * 2))
+      || ! (classes[0] = (unsigned short *) malloc(batch * 2))
+      || ! (classes[1] = (unsigned short *) malloc(batch * 2))
+      || ! (ok = (unsigned char *) malloc(requests))
+      || ! (in = (unsigned char *) malloc(measurements))
+      || ! (ns = (double *) malloc(measurements * sizeof(double)))
+      || ! (sorted = (double *) malloc(measurements * sizeof(double)))
+      || ! (auth = newAuthenticator())
+      )
+  {
+    fprintf(stderr, "out of memory\n");
+    return 1;
+  }
+
+  if (! (pinned = cpu >= 0 && ! authbench_pin(cpu)))
+  {
+    fprintf(stderr, "cannot pin to CPU %d, timing unpinned\n", cpu);
+  }
+
+  /* random IDs and PINs, as newAtmServer makes them */
+  for (i = 0; i < ATM_NUM_ACCOUNTS; i++)
+  {
+    accounts[i] = ((bench_random() & 0xF) << ATM_ID_SHIFT)
+      | ((bench_random() & 0xF) << ATM_PIN_SHIFT);
+  }
+  auth->load(auth, accounts);
+
+  /* a mix of everything, some accounts and nibbles out of range */
+  for (i = 0; i < requests; i++)
+  {
+    account[i] = bench_random() % (ATM_NUM_ACCOUNTS + 4);
+    id[i] = atm_nibble(accounts[account[i] % ATM_NUM_ACCOUNTS],
+        ATM_ID_SHIFT);
+    pin[i] = atm_nibble(accounts[account[i] % ATM_NUM_ACCOUNTS],
+        ATM_PIN_SHIFT);
+    switch (bench_random() % 8)
+    {
+      case 0: id[i] ^= 1 + bench_random() % 15;   break;
+      case 1: pin[i] ^= 1 + bench_random() % 15;  break;
+      case 2: pin[i] |= 0x10;                         break;
+      default:                                        break;
+    }
+    packed[i] = auth_pack(account[i], id[i], pin[i]);
+  }
+
+  /* every answer has to match before the speed means anything */
+  passed = auth->check(auth, packed, ok, requests);
+  for (i = 0; i < requests; i++)
+  {
+    if (ok[i] != authbench_server(accounts, account[i], id[i], pin[i]))
+    {
+      if (! errors++)
+      {
+        fprintf(stderr, "request %lu, account %u ID %u PIN %u, checked "
+            "wrong\n", (unsigned long) i, account[i], id[i], pin[i]);
+      }
+    }
+    sum += ok[i];
+  }
+  errors += passed != sum;
+
+  /* throughput, the kernel then the server design */
+  started = bench_now();
+  for (pass = 0; pass < passes; pass++)
+  {
+    sum += auth->check(auth, packed, ok, requests);
+  }
+  seconds = bench_now() - started;
+  started = bench_now();
+  for (i = 0; i < requests; i++)
+  {
+    sum += authbench_server(accounts, account[i], id[i], pin[i]);
+  }
+  serial = bench_now() - started;
+
+  printf("path              %s\n",
+#if defined(__AVX2__)
+      "AVX2"
+#elif defined(__SSE2__)
+      "SSE2"
+#else
+      "scalar"
+#endif
+      );
+  printf("requests          %lu x %lu passes, %lu passed, %lu wrong\n",
+      (unsigned long) requests, passes, (unsigned long) passed, errors);
+  printf("host              %.1f M auths/s, server design %.1f M auths/s "
+      "(%lx)\n",
+      seconds > 0 ? requests * (double) passes / seconds / 1e6 : 0.0,
+      serial > 0 ? requests / serial / 1e6 : 0.0, sum);
+
+  /*
+   * timing, each test against both compares, the server design's batch
+   *  copied into the third batch of requests along
+   */
+  timed[0] = account + 2 * batch;
+  timed[1] = id + 2 * batch;
+  timed[2] = pin + 2 * batch;
+  printf("timing            |t| under %.1f is no leak, %lu x %lu requests "
+      "after %lu warm-up, ", AUTHBENCH_T_LEAK, (unsigned long) measurements,
+      (unsigned long) batch, (unsigned long) warmup);
+  if (pinned)
+  {
+    printf("CPU %d\n", cpu);
+  }
+  else
+  {
+    printf("unpinned\n");
+  }
+  printf("                          kernel     server design\n");
+  for (test = 0; test < sizeof(tests) / sizeof(tests[0]); test++)
+  {
+    authbench_fill(accounts, tests[test].a, account, id, pin, classes[0],
+        batch);
+    authbench_fill(accounts, tests[test].b, account + batch, id + batch,
+        pin + batch, classes[1], batch);
+
+    /* the kernel, every class checked out of packed */
+    for (m = 0; m < warmup + measurements; m++)
+    {
+      c = bench_random() & 1;
+      memcpy(packed, classes[c], batch * 2);
+      started = bench_now();
+      sum += auth->check(auth, packed, ok, batch);
+      if (m >= warmup)
+      {
+        i = m - warmup;
+        in[i] = (unsigned char) c;
+        ns[i] = (bench_now() - started) * 1e9;
+      }
+    }
+    t[0] = authbench_welch(ns, in, sorted, measurements);
+
+    /* the server design, on the same requests */
+    for (m = 0; m < warmup + measurements; m++)
+    {
+      c = bench_random() & 1;
+      memcpy(timed[0], account + c * batch, batch * sizeof(unsigned));
+      memcpy(timed[1], id + c * batch, batch * sizeof(unsigned));
+      memcpy(timed[2], pin + c * batch, batch * sizeof(unsigned));
+      started = bench_now();
+      for (j = 0; j < batch; j++)
+      {
+        sum += authbench_server(accounts, timed[0][j], timed[1][j],
+            timed[2][j]);
+      }
+      if (m >= warmup)
+      {
+        i = m - warmup;
+        in[i] = (unsigned char) c;
+        ns[i] = (bench_now() - started) * 1e9;
+      }
+    }
+    t[1] = authbench_welch(ns, in, sorted, measurements);
+
+    leaked |= fabs(t[0]) >= AUTHBENCH_T_LEAK;
+    printf("  %-23s %8.2f %-4s %8.2f %s\n", tests[test].name, t[0],
+        fabs(t[0]) < AUTHBENCH_T_LEAK ? "" : "leak", t[1],
+        fabs(t[1]) < AUTHBENCH_T_LEAK ? "" : "leak");
+  }
+
+  auth->free(auth);
+  free(sorted);
+  free(ns);
+  free(in);
+  free(ok);
+  free(classes[1]);
+  free(classes[0]);
+  free(packed);
+  free(pin);
+  free(id);
+  free(account);
+
+  return errors != 0 || leaked;
+}
@@ -0,0 +1,238 @@
+#ifndef __SOFT_STACK_BENCH
+#define __SOFT_STACK_BENCH
+
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#include "main.h"
+
+/**
+ * What the host benches and checkers share: a reproducible random
+ *  sequence, a clock, and forked workers.
+ */
+
+/** xorshift, reproducible across hosts, the same sequence in every tool */
+static inline unsigned bench_random()
+{
+  static unsigned state = 0x2545F491;
+
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+
+  return state;
+}
+
+/** seconds, monotonic */
+static inline double bench_now()
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+/** A forked worker, as the parent sees it */
+typedef struct _BenchWorker
+{
+  /** the child */
+  pid_t pid;
+
+  /** read end of the pipe the child writes to */
+  int up;
+
+  /** write end of the pipe the child reads from */
+  int down;
+} BenchWorker;
+
+/**
+ * Forks a worker with a pipe each way. The child calls run with its ends
+ *  of the pipes and exits with what run returns, never returning here.
+ *  Flush stdout first, or the child inherits whatever is buffered.
+ *
+ * @param worker filled in for the parent
+ * @param w the worker's number, handed to run
+ * @param run the child's work, up is written and down is read
+ * @param context handed to run
+ * @return 0, or -1 with errno set if a pipe or the fork failed
+ */
+static inline int bench_spawn(BenchWorker *worker, unsigned long w,
+    int (*run)(unsigned long w, int up, int down, void *context),
+    void *context)
+{
+  int up[2], down[2];
+
+  if (pipe(up))
+  {
+    return -1;
+  }
+  if (pipe(down))
+  {
+    close(up[0]);
+    close(up[1]);
+    return -1;
+  }
+  if ((worker->pid = fork()) < 0)
+  {
+    close(up[0]);
+    close(up[1]);
+    close(down[0]);
+    close(down[1]);
+    return -1;
+  }
+  if (! worker->pid)
+  {
+    close(up[0]);
+    close(down[1]);
+    _exit(run(w, up[1], down[0], context));
+  }
+
+  close(up[1]);
+  close(down[0]);
+  worker->up = up[0];
+  worker->down = down[1];
+
+  return 0;
+}
+
+/**
+ * Closes the parent's ends of a worker's pipes and waits for it.
+ *
+ * @param stop non-zero to send it SIGTERM first
+ * @return its exit status, -1 if it did not exit normally
+ */
+static inline int bench_reap(BenchWorker *worker, int stop)
+{
+  int status;
+
+  close(worker->up);
+  close(worker->down);
+  if (stop)
+  {
+    kill(worker->pid, SIGTERM);
+  }
+  if (waitpid(worker->pid, &status, 0) < 0 || ! WIFEXITED(status))
+  {
+    return -1;
+  }
+
+  return WEXITSTATUS(status);
+}
+
+/* a bench_fork, as its workers see it */
+typedef struct _BenchForkJob
+{
+  unsigned long workers;
+  size_t size;
+  void *report;
+  void (*work)(unsigned long w, unsigned long workers, void *report,
+      void *context);
+  void *context;
+} BenchForkJob;
+
+/* a bench_fork worker: fill in a zeroed report and send it up */
+static inline int bench_forkRun(unsigned long w, int up, int down,
+    void *context)
+{
+  BenchForkJob *job = (BenchForkJob *) context;
+  const char *report = (const char *) job->report;
+  size_t left = job->size;
+  ssize_t wrote;
+
+  (void) down;
+  memset(job->report, 0, job->size);
+  job->work(w, job->workers, job->report, job->context);
+  for (; left; left -= (size_t) wrote, report += wrote)
+  {
+    if ((wrote = write(up, report, left)) <= 0)
+    {
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+/**
+ * Splits work across forked workers which each send back a fixed size
+ *  report, handed to gather in worker order.
+ *
+ * @param workers number of workers
+ * @param size bytes of a report
+ * @param work fills in worker w's report, zeroed beforehand
+ * @param gather adds up a report in the parent
+ * @param context handed to work and gather
+ * @return 0, or non-zero once a fork failed or a worker died, reported on
+ *  stderr
+ */
+static inline int bench_fork(unsigned long workers, size_t size,
+    void (*work)(unsigned long w, unsigned long workers, void *report,
+        void *context),
+    void (*gather)(unsigned long w, const void *report, void *context),
+    void *context)
+{
+  BenchForkJob job;
+  BenchWorker *children;
+  unsigned long w, spawned;
+  size_t got;
+  ssize_t n;
+  int failed = 0;
+
+  job.workers = workers;
+  job.size    = size;
+  job.work    = work;
+  job.context = context;
+  if (
+         ! (job.report = malloc(size))
+      || ! (children = (BenchWorker *) calloc(workers, sizeof(BenchWorker)))
+      )
+  {
+    fprintf(stderr, "out of memory\n");
+    free(job.report);
+    return 1;
+  }
+
+  fflush(stdout);
+  for (spawned = 0; spawned < workers; spawned++)
+  {
+    if (bench_spawn(&children[spawned], spawned, bench_forkRun, &job))
+    {
+      perror("fork");
+      failed = 1;
+      break;
+    }
+  }
+
+  /* gather in order, a report short of size is a worker which died */
+  for (w = 0; w < spawned; w++)
+  {
+    for (got = 0; ! failed && got < size; got += (size_t) n)
+    {
+      if ((n = read(children[w].up, (char *) job.report + got, size - got))
+          <= 0)
+      {
+        fprintf(stderr, "worker %lu died\n", w);
+        failed = 1;
+      }
+    }
+    if (! failed)
+    {
+      gather(w, job.report, context);
+    }
+    if (bench_reap(&children[w], failed) && ! failed)
+    {
+      fprintf(stderr, "worker %lu failed\n", w);
+      failed = 1;
+    }
+  }
+
+  free(children);
+  free(job.report);
+
+  return failed;
+}
+
+#endif /* __SOFT_STACK_BENCH */
@@ -0,0 +1,255 @@
+#include "bus.h"
+
+/* method forward decls */
+void * Bus_mapRam(Bus *self, u32 base, u32 size, void *host);
+BusDevice * Bus_attach(Bus *self, Device *device, const char *name);
+void Bus_report(Bus *self, FILE *out);
+Bus * Bus_free(Bus *self);
+
+/* constructor */
+Bus * newBus()
+{
+  Bus *self = (Bus *) malloc(sizeof(Bus));
+  unsigned i;
+
+  /* out of memory */
+  if (! self)
+  {
+    return NULL;
+  }
+
+  /* zero */
+  memset(self, 0, sizeof(Bus));
+
+  /* bind methods */
+  self->mapRam = Bus_mapRam;
+  self->attach = Bus_attach;
+  self->report = Bus_report;
+  self->free   = Bus_free;
+
+  /* nothing mapped, every lookup lands on an empty page */
+  for (i = 0; i < BUS_L1_SIZE; i++)
+  {
+    self->l1[i] = self->empty;
+  }
+
+  return self;
+}
+
+/* non-zero if any page of [first, last] is mapped */
+static int Bus_taken(Bus *self, u32 first, u32 last)
+{
+  BusPage *page;
+  u32 address = first;
+
+  for (;;)
+  {
+    page = bus_page(self, address);
+    if (page->host || page->device)
+    {
+      return 1;
+    }
+    if (last - address < BUS_PAGE_SIZE)
+    {
+      return 0;
+    }
+    address += BUS_PAGE_SIZE;
+  }
+}
+
+/* a writable page, giving the first level entry a table of its own */
+static BusPage * Bus_own(Bus *self, u32 address)
+{
+  BusPage **table = &self->l1[address >> BUS_L1_SHIFT];
+
+  if (*table == self->empty)
+  {
+    if (! (*table = (BusPage *) calloc(BUS_L2_SIZE, sizeof(BusPage))))
+    {
+      *table = self->empty;
+      return NULL;
+    }
+  }
+
+  return bus_page(self, address);
+}
+
+/* RAM, a page at a time */
+void * Bus_mapRam(Bus *self, u32 base, u32 size, void *host)
+{
+  void **owned;
+  u32 offset;
+  BusPage *page;
+  int allocated = ! host;
+
+  if (
+         ! size
+      || (base | size) & (BUS_PAGE_SIZE - 1)
+      || base + (size - 1) < base
+      || Bus_taken(self, base, base + (size - 1))
+      )
+  {
+    return NULL;
+  }
+
+  /* every table first, so a failure leaves nothing half mapped */
+  for (offset = 0; offset < size; offset += BUS_PAGE_SIZE)
+  {
+    if (! Bus_own(self, base + offset))
+    {
+      return NULL;
+    }
+  }
+  if (allocated)
+  {
+    if (
+           ! (owned = (void **) realloc(self->owned,
+               (self->num_owned + 1) * sizeof(void *)))
+        || ! (host = calloc(1, size))
+        )
+    {
+      self->owned = owned ? owned : self->owned;
+      return NULL;
+    }
+    self->owned = owned;
+    self->owned[self->num_owned++] = host;
+  }
+
+  for (offset = 0; offset < size; offset += BUS_PAGE_SIZE)
+  {
+    page = bus_page(self, base + offset);
+    page->host = (unsigned char *) host + offset;
+  }
+
+  /* the largest mapping is the one worth skipping the table for */
+  if (size > self->ram_size)
+  {
+    self->ram_base = base;
+    self->ram_size = size;
+    self->ram_host = (unsigned char *) host;
+  }
+
+  return host;
+}
+
+/* a Device's pages, dispatched to it */
+BusDevice * Bus_attach(Bus *self, Device *device, const char *name)
+{
+  BusDevice *found;
+  u32 first, last, address;
+
+  if (! device || ! device->size || self->num_devices == BUS_MAX_DEVICES)
+  {
+    return NULL;
+  }
+  first = device->base & ~(BUS_PAGE_SIZE - 1);
+  last = (device->base + (device->size - 1)) | (BUS_PAGE_SIZE - 1);
+  if (Bus_taken(self, first, last))
+  {
+    return NULL;
+  }
+  for (address = first; ; address += BUS_PAGE_SIZE)
+  {
+    if (! Bus_own(self, address))
+    {
+      return NULL;
+    }
+    if (last - address < BUS_PAGE_SIZE)
+    {
+      break;
+    }
+  }
+
+  found = &self->devices[self->num_devices++];
+  found->device = device;
+  found->name   = name;
+  found->reads  = 0;
+  found->writes = 0;
+  for (address = first; ; address += BUS_PAGE_SIZE)
+  {
+    bus_page(self, address)->device = found;
+    if (last - address < BUS_PAGE_SIZE)
+    {
+      break;
+    }
+  }
+
+  return found;
+}
+
+/* MMIO reads, or unmapped */
+u32 bus_dispatchRead(Bus *self, u32 address)
+{
+  BusDevice *found = bus_page(self, address)->device;
+  Device *device;
+
+  if (found)
+  {
+    device = found->device;
+    if (address - device->base < device->size && device->read)
+    {
+      found->reads++;
+      return device->read(device, address - device->base);
+    }
+  }
+
+  self->unmapped++;
+  return 0;
+}
+
+/* MMIO writes, or unmapped */
+void bus_dispatchWrite(Bus *self, u32 address, u32 data)
+{
+  BusDevice *found = bus_page(self, address)->device;
+  Device *device;
+
+  if (found)
+  {
+    device = found->device;
+    if (address - device->base < device->size && device->write)
+    {
+      found->writes++;
+      device->write(device, address - device->base, data);
+      return;
+    }
+  }
+
+  self->unmapped++;
+}
+
+/* one line per Device */
+void Bus_report(Bus *self, FILE *out)
+{
+  BusDevice *cur;
+  unsigned i;
+
+  for (i = 0; i < self->num_devices; i++)
+  {
+    cur = &self->devices[i];
+    fprintf(out, "%-17s 0x%08X  %llu reads, %llu writes\n", cur->name,
+        cur->device->base, cur->reads, cur->writes);
+  }
+  fprintf(out, "%-17s %llu accesses\n", "unmapped", self->unmapped);
+}
+
+/* destructor */
+Bus * Bus_free(Bus *self)
+{
+  unsigned i;
+
+  for (i = 0; i < BUS_L1_SIZE; i++)
+  {
+    if (self->l1[i] != self->empty)
+    {
+      free(self->l1[i]);
+    }
+  }
+  for (i = 0; i < self->num_owned; i++)
+  {
+    free(self->owned[i]);
+  }
+  free(self->owned);
+  free(self);
+
+  return NULL;
+}
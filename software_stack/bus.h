@@ -0,0 +1,258 @@
+#ifndef __SOFT_STACK_BUS
+#define __SOFT_STACK_BUS
+
+#include "hal.h"
+
+/** Address split: 1 MB first level entries, 4 KB pages below them */
+#define BUS_L1_SHIFT   20
+#define BUS_PAGE_SHIFT 12
+#define BUS_L1_SIZE    (1 << (32 - BUS_L1_SHIFT))
+#define BUS_L2_SIZE    (1 << (BUS_L1_SHIFT - BUS_PAGE_SHIFT))
+#define BUS_PAGE_SIZE  (1 << BUS_PAGE_SHIFT)
+
+/** Most Devices a Bus dispatches to */
+#define BUS_MAX_DEVICES 16
+
+/** A Device as a Bus sees it, with what reached it */
+typedef struct _BusDevice
+{
+  /** the handler, one of the models with a Device as first member */
+  Device *device;
+
+  /** short name used in reports */
+  const char *name;
+
+  /** word accesses dispatched to it */
+  unsigned long long reads;
+  unsigned long long writes;
+
+} BusDevice;
+
+/**
+ * What a 4 KB page is: RAM if host is set, the host address of the
+ *  page's first byte, MMIO if device is set, and unmapped otherwise
+ */
+typedef struct _BusPage
+{
+  unsigned char *host;
+  BusDevice *device;
+} BusPage;
+
+/**
+ * A Bus is the address map of an execution engine: a two-level page
+ *  table from guest addresses to either host memory or a Device. Every
+ *  first level entry points at a table of pages, unmapped ones at a
+ *  single shared table of empty pages, so a lookup is two loads with no
+ *  test. A RAM page is then a pointer add, inlined into the caller, and
+ *  anything else is dispatched to its Device out of line, counted per
+ *  Device. The largest RAM mapping is also kept as a window checked
+ *  before the table, so the guest's main memory costs one compare and
+ *  an add rather than the two dependent loads.
+ *
+ * Word accesses are aligned down, and halfword ones to the halfword, as
+ *  Thumb LDR and STR have no unaligned form on this core. Devices only
+ *  take words: narrower reads take their lane of the word, and narrower
+ *  writes write the word with the value in its lane and zeros elsewhere.
+ */
+typedef struct _Bus
+{
+  /** first level, BUS_L1_SIZE tables of BUS_L2_SIZE pages */
+  BusPage *l1[BUS_L1_SIZE];
+
+  /** what every unmapped first level entry points at */
+  BusPage empty[BUS_L2_SIZE];
+
+  /** attached Devices */
+  BusDevice devices[BUS_MAX_DEVICES];
+  unsigned num_devices;
+
+  /** the RAM window, the largest mapRam so far, ram_size 0 for none */
+  u32 ram_base;
+  u32 ram_size;
+  unsigned char *ram_host;
+
+  /** RAM allocated by mapRam, freed with the Bus */
+  void **owned;
+  unsigned num_owned;
+
+  /** accesses to unmapped pages, reads returning 0 and writes dropped */
+  unsigned long long unmapped;
+
+  /**
+   * Map RAM, page by page
+   *
+   * @param base guest byte address, page aligned
+   * @param size bytes, a whole number of pages
+   * @param host host memory of size bytes, or NULL to allocate it zeroed
+   * @return the host memory, or NULL if unaligned, overlapping something
+   *  mapped, or out of memory, leaving the map as it was
+   */
+  void * (*mapRam)(struct _Bus *self, u32 base, u32 size, void *host);
+
+  /**
+   * Dispatch a Device's pages to it, base and size rounded out to pages
+   *
+   * @param device Device, RegFile, GateModel, KeyModel or ViewerModel
+   * @param name short name for reports
+   * @return its BusDevice, or NULL if it overlaps something mapped or
+   *  there are BUS_MAX_DEVICES already, leaving the map as it was
+   */
+  BusDevice * (*attach)(struct _Bus *self, Device *device, const char *name);
+
+  /**
+   * Print the per-Device access counts
+   *
+   * @param out file to print to
+   */
+  void (*report)(struct _Bus *self, FILE *out);
+
+  /**
+   * Destructor, frees what mapRam allocated and leaves the Devices alone
+   *
+   * @return NULL
+   */
+  struct _Bus * (*free)(struct _Bus *self);
+
+} Bus;
+
+/**
+ * Constructor, with nothing mapped
+ *
+ * @return a new Bus, or NULL if out of memory
+ */
+Bus * newBus();
+
+/**
+ * The slow path, a word read from a page which is not RAM
+ *
+ * @param address byte address, word aligned
+ * @return the word, 0 if unmapped
+ */
+u32 bus_dispatchRead(Bus *self, u32 address);
+
+/**
+ * The slow path, a word write to a page which is not RAM
+ *
+ * @param address byte address, word aligned
+ * @param data the word
+ */
+void bus_dispatchWrite(Bus *self, u32 address, u32 data);
+
+/** the page of an address, never NULL */
+static inline BusPage * bus_page(Bus *self, u32 address)
+{
+  return &self->l1[address >> BUS_L1_SHIFT]
+    [(address >> BUS_PAGE_SHIFT) & (BUS_L2_SIZE - 1)];
+}
+
+/**
+ * The host byte of an address aligned down to 'align' bytes, from the RAM
+ *  window or else the page table
+ *
+ * @return the host byte, or NULL if the address is not RAM
+ */
+static inline unsigned char * bus_host(Bus *self, u32 address, u32 align)
+{
+  u32 offset = address - self->ram_base;
+  BusPage *page;
+
+  if (offset < self->ram_size)
+  {
+    return self->ram_host + (offset & ~(align - 1));
+  }
+
+  page = bus_page(self, address);
+  if (page->host)
+  {
+    return page->host + (address & (BUS_PAGE_SIZE - align));
+  }
+
+  return NULL;
+}
+
+/** LDR */
+static inline u32 bus_read32(Bus *self, u32 address)
+{
+  unsigned char *host = bus_host(self, address, 4);
+
+  if (host)
+  {
+    return *(u32 *) host;
+  }
+
+  return bus_dispatchRead(self, address & ~3U);
+}
+
+/** STR */
+static inline void bus_write32(Bus *self, u32 address, u32 data)
+{
+  unsigned char *host = bus_host(self, address, 4);
+
+  if (host)
+  {
+    *(u32 *) host = data;
+    return;
+  }
+
+  bus_dispatchWrite(self, address & ~3U, data);
+}
+
+/** LDRH */
+static inline u32 bus_read16(Bus *self, u32 address)
+{
+  unsigned char *host = bus_host(self, address, 2);
+
+  if (host)
+  {
+    return *(unsigned short *) host;
+  }
+
+  return (bus_dispatchRead(self, address & ~3U) >> ((address & 2) * 8))
+    & 0xFFFF;
+}
+
+/** STRH */
+static inline void bus_write16(Bus *self, u32 address, u32 data)
+{
+  unsigned char *host = bus_host(self, address, 2);
+
+  if (host)
+  {
+    *(unsigned short *) host = (unsigned short) data;
+    return;
+  }
+
+  bus_dispatchWrite(self, address & ~3U, (data & 0xFFFF)
+      << ((address & 2) * 8));
+}
+
+/** LDRB */
+static inline u32 bus_read8(Bus *self, u32 address)
+{
+  unsigned char *host = bus_host(self, address, 1);
+
+  if (host)
+  {
+    return *host;
+  }
+
+  return (bus_dispatchRead(self, address & ~3U) >> ((address & 3) * 8))
+    & 0xFF;
+}
+
+/** STRB */
+static inline void bus_write8(Bus *self, u32 address, u32 data)
+{
+  unsigned char *host = bus_host(self, address, 1);
+
+  if (host)
+  {
+    *host = (unsigned char) data;
+    return;
+  }
+
+  bus_dispatchWrite(self, address & ~3U, (data & 0xFF)
+      << ((address & 3) * 8));
+}
+
+#endif /* __SOFT_STACK_BUS */
@@ -0,0 +1,250 @@
+/*
+ * Measures what a Bus costs an execution engine. RAM only: -n word
+ *  loads and stores at random addresses of -m KB of RAM, straight into a
+ *  host array, through a Bus, and through hal's Device list with the RAM
+ *  as a Device, all three having to leave the same memory and sums. Then
+ *  -d rounds of what guest code does to the peripherals: storing table
+ *  entries to trusted_gate, keys and the control word to trusted_key,
+ *  words through edkregfile's side channel and reading them back, and
+ *  reading gate_viewer, all through the Bus with each read checked
+ *  against the model, and the per-Device counts reported.
+ *
+ * usage: busbench [-m RAM KB] [-n accesses] [-d device rounds]
+ *
+ * build: cc -O2 -o busbench busbench.c bus.c hal.c regfile.c gate.c key.c
+ *         viewer.c sim.c
+ */
+#include "bench.h"
+#include "bus.h"
+#include "regfile.h"
+#include "key.h"
+#include "viewer.h"
+#include "xparameters.h"
+
+/* where the guest's RAM sits */
+#define BUSBENCH_RAM_BASE 0x00100000
+
+/* random offsets, cycled through so the generator is not what is timed */
+#define BUSBENCH_OFFSETS (1 << 16)
+
+/* NUM_REGS in edkregfile's mpd */
+#define BUSBENCH_NUM_REGS 317
+
+/* RAM as hal sees it */
+typedef struct _BusBenchRam
+{
+  Device device;
+  u32 *words;
+} BusBenchRam;
+
+/* hal Device read of the RAM */
+static u32 busbench_ramRead(Device *device, u32 offset)
+{
+  return ((BusBenchRam *) device)->words[offset / 4];
+}
+
+/* hal Device write of the RAM */
+static void busbench_ramWrite(Device *device, u32 offset, u32 data)
+{
+  ((BusBenchRam *) device)->words[offset / 4] = data;
+}
+
+/*
+ * The RAM loops, each a load, an add and a store, out of main so the Bus
+ *  accessors are inlined as they are into an engine's step rather than
+ *  called, main being optimized as code run once
+ */
+static double busbench_host(u32 *host, const unsigned *offsets,
+    unsigned words, unsigned long accesses, u32 *sum)
+{
+  double started = bench_now();
+  unsigned long i;
+  unsigned reg;
+
+  for (i = 0; i < accesses; i++)
+  {
+    reg = offsets[i % BUSBENCH_OFFSETS];
+    *sum += host[reg];
+    host[(reg * 7) % words] = *sum;
+  }
+
+  return bench_now() - started;
+}
+
+static double busbench_bus(Bus *bus, const unsigned *offsets,
+    unsigned words, unsigned long accesses, u32 *sum)
+{
+  double started = bench_now();
+  unsigned long i;
+  unsigned reg;
+
+  for (i = 0; i < accesses; i++)
+  {
+    reg = offsets[i % BUSBENCH_OFFSETS];
+    *sum += bus_read32(bus, BUSBENCH_RAM_BASE + 4 * reg);
+    bus_write32(bus, BUSBENCH_RAM_BASE + 4 * ((reg * 7) % words), *sum);
+  }
+
+  return bench_now() - started;
+}
+
+static double busbench_hal(const unsigned *offsets, unsigned words,
+    unsigned long accesses, u32 *sum)
+{
+  double started = bench_now();
+  unsigned long i;
+  unsigned reg;
+
+  for (i = 0; i < accesses; i++)
+  {
+    reg = offsets[i % BUSBENCH_OFFSETS];
+    *sum += Xil_In32(BUSBENCH_RAM_BASE + 4 * reg);
+    Xil_Out32(BUSBENCH_RAM_BASE + 4 * ((reg * 7) % words), *sum);
+  }
+
+  return bench_now() - started;
+}
+
+int main(int argc, char **argv)
+{
+  unsigned long kb = 1024, accesses = 1 << 24, rounds = 100000, i,
+                errors = 0;
+  unsigned *offsets, reg, words;
+  u32 *host, *ram, sum[3] = { 0, 0, 0 }, address, value;
+  double seconds[3];
+  BusBenchRam device;
+  RegFile *regfile;
+  GateModel *gate;
+  KeyModel *key;
+  ViewerModel *viewer;
+  Bus *bus;
+  int a;
+
+  /* options */
+  for (a = 1; a + 1 < argc && argv[a][0] == '-'; a += 2)
+  {
+    switch (argv[a][1])
+    {
+      case 'm': kb       = strtoul(argv[a + 1], NULL, 0);  break;
+      case 'n': accesses = strtoul(argv[a + 1], NULL, 0);  break;
+      case 'd': rounds   = strtoul(argv[a + 1], NULL, 0);  break;
+      default:  a = argc;                                  break;
+    }
+  }
+  if (a != argc || kb < 4 || kb % 4 || kb > 0x100000 || ! accesses)
+  {
+    fprintf(stderr, "usage: %s [-m RAM KB, a multiple of 4] [-n accesses] "
+        "[-d device rounds]\n", argv[0]);
+    return 1;
+  }
+  words = kb * 256;
+
+  if (
+         ! (bus = newBus())
+      || ! (offsets = (unsigned *) malloc(BUSBENCH_OFFSETS * sizeof(unsigned)))
+      || ! (host = (u32 *) calloc(words, sizeof(u32)))
+      || ! (device.words = (u32 *) calloc(words, sizeof(u32)))
+      || ! (ram = (u32 *) bus->mapRam(bus, BUSBENCH_RAM_BASE, kb * 1024,
+            NULL))
+      )
+  {
+    fprintf(stderr, "out of memory\n");
+    return 1;
+  }
+  for (i = 0; i < BUSBENCH_OFFSETS; i++)
+  {
+    offsets[i] = bench_random() % words;
+  }
+
+  /* the peripherals, on hal's list already and now on the Bus */
+  device.device.base  = BUSBENCH_RAM_BASE;
+  device.device.size  = kb * 1024;
+  device.device.read  = busbench_ramRead;
+  device.device.write = busbench_ramWrite;
+  if (
+         ! (regfile = newRegFile(XPAR_EDKREGFILE_0_BASEADDR,
+             BUSBENCH_NUM_REGS))
+      || ! (gate = newGateModel(XPAR_TRUSTED_GATE_0_BASEADDR))
+      || ! (key = newKeyModel(XPAR_TRUSTED_KEY_0_BASEADDR, NULL))
+      || ! (viewer = newViewerModel(XPAR_GATE_VIEWER_0_BASEADDR, gate))
+      || hal_attach(&device.device)
+      || ! bus->attach(bus, &regfile->device, "edkregfile")
+      || ! bus->attach(bus, &key->device, "trusted_key")
+      || ! bus->attach(bus, &viewer->device, "gate_viewer")
+      || ! bus->attach(bus, &gate->device, "trusted_gate")
+      )
+  {
+    fprintf(stderr, "cannot map the peripherals\n");
+    return 1;
+  }
+
+  /* RAM three ways */
+  seconds[0] = busbench_host(host, offsets, words, accesses, &sum[0]);
+  seconds[1] = busbench_bus(bus, offsets, words, accesses, &sum[1]);
+  seconds[2] = busbench_hal(offsets, words, accesses, &sum[2]);
+
+  errors += sum[0] != sum[1] || sum[0] != sum[2]
+    || memcmp(host, ram, words * sizeof(u32))
+    || memcmp(host, device.words, words * sizeof(u32));
+  printf("RAM               %lu KB, %lu loads and stores each, %s\n", kb,
+      accesses, errors ? "wrong" : "right");
+  printf("host array        %.2f ns an access\n",
+      seconds[0] * 1e9 / (2 * accesses));
+  printf("Bus               %.2f ns an access, %+.1f%%\n",
+      seconds[1] * 1e9 / (2 * accesses),
+      100 * (seconds[1] - seconds[0]) / seconds[0]);
+  printf("hal Device        %.2f ns an access, %+.1f%%\n",
+      seconds[2] * 1e9 / (2 * accesses),
+      100 * (seconds[2] - seconds[0]) / seconds[0]);
+
+  /* guest peripheral traffic */
+  seconds[0] = bench_now();
+  for (i = 0; i < rounds; i++)
+  {
+    value = bench_random();
+
+    /* a gate table entry, read back sealing it, through the viewer too */
+    reg = bench_random() % GATE_NUM_KEYS;
+    bus_write32(bus, XPAR_TRUSTED_GATE_0_BASEADDR + 4 * reg, value);
+    errors += bus_read32(bus, XPAR_TRUSTED_GATE_0_BASEADDR + 4 * reg)
+      != gate->device.read(&gate->device, 4 * reg);
+    errors += bus_read32(bus, XPAR_GATE_VIEWER_0_BASEADDR + 4 * reg)
+      != viewer->device.read(&viewer->device, 4 * reg);
+
+    /* a key, then the control word picking it */
+    reg = 1 + bench_random() % (KEY_NUM_REGS - 1);
+    bus_write32(bus, XPAR_TRUSTED_KEY_0_BASEADDR + 4 * reg, value);
+    bus_write32(bus, XPAR_TRUSTED_KEY_0_BASEADDR, 1U << reg);
+    errors += key->regs[reg] != value
+      || bus_read32(bus, XPAR_TRUSTED_KEY_0_BASEADDR + 4 * reg) != value;
+
+    /* a word through the side channel and back */
+    address = bench_random() % BUSBENCH_NUM_REGS;
+    bus_write32(bus, XPAR_EDKREGFILE_0_BASEADDR + 4 * REGFILE_SET_ADDRESS,
+        address);
+    bus_write32(bus, XPAR_EDKREGFILE_0_BASEADDR + 4 * REGFILE_SET_DATA,
+        value);
+    bus_write32(bus, XPAR_EDKREGFILE_0_BASEADDR + 4 * REGFILE_PERFORM_OP, 0);
+    errors += bus_read32(bus, XPAR_EDKREGFILE_0_BASEADDR
+        + 4 * REGFILE_PERFORM_OP) != value || regfile->mem[address] != value;
+
+    /* nothing there */
+    bus_read32(bus, 0x80000000 + (bench_random() & 0x0FFFFFFC));
+  }
+  seconds[0] = bench_now() - seconds[0];
+  printf("devices           %lu rounds, %.2f ns an access, %lu wrong\n",
+      rounds, seconds[0] * 1e9 / (rounds ? rounds * 11 : 1), errors);
+  bus->report(bus, stdout);
+
+  viewer->free(viewer);
+  key->free(key);
+  gate->free(gate);
+  regfile->free(regfile);
+  hal_detach(&device.device);
+  bus->free(bus);
+  free(device.words);
+  free(host);
+  free(offsets);
+
+  return errors != 0;
+}
@@ -0,0 +1,410 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "checkpoint.h"
+
+/* method forward decls */
+int Checkpoint_verify(Checkpoint *self);
+int Checkpoint_restore(Checkpoint *self, RegFile *regfile, GateModel *gate,
+    KeyModel *key);
+Stack * Checkpoint_toStack(Checkpoint *self);
+Checkpoint * Checkpoint_free(Checkpoint *self);
+
+/* bytes rounded up to the next section */
+static u32 checkpoint_align(u32 bytes)
+{
+  return (bytes + CHECKPOINT_ALIGN - 1) & ~(u32) (CHECKPOINT_ALIGN - 1);
+}
+
+/* FNV-1a over every saved section, a word at a time */
+static u32 checkpoint_checksum(const CheckpointHeader *header)
+{
+  const unsigned char *base = (const unsigned char *) header;
+  const u32 *word;
+  u32 hash = 0x811C9DC5;
+  size_t i, n;
+  int s;
+
+  for (s = 0; s < CHECKPOINT_NUM_SECTIONS; s++)
+  {
+    word = (const u32 *) (base + header->sections[s].offset);
+    n = (header->sections[s].bytes + 3) / 4;
+    for (i = 0; i < n; i++)
+    {
+      hash = (hash ^ word[i]) * 0x01000193;
+    }
+  }
+
+  return hash;
+}
+
+/* section 's' if it was saved with 'bytes', or NULL */
+static const void * checkpoint_section(const CheckpointHeader *header,
+    CheckpointSectionId s, size_t bytes)
+{
+  const CheckpointSection *section = &header->sections[s];
+
+  if (! section->bytes || (bytes && section->bytes != bytes))
+  {
+    return NULL;
+  }
+
+  return (const unsigned char *) header + section->offset;
+}
+
+/* side channel and user space, the memory is copied apart */
+void checkpoint_saveRegFile(CheckpointRegFile *saved, const RegFile *regfile)
+{
+  saved->num_regs = regfile->num_regs;
+  saved->address  = regfile->address;
+  saved->data     = regfile->data;
+  saved->data_out = regfile->data_out;
+  saved->pulse    = regfile->pulse;
+  memcpy(saved->status, regfile->status, sizeof(saved->status));
+}
+
+void checkpoint_loadRegFile(RegFile *regfile, const CheckpointRegFile *saved)
+{
+  regfile->address  = saved->address;
+  regfile->data     = saved->data;
+  regfile->data_out = saved->data_out;
+  regfile->pulse    = saved->pulse;
+  memcpy(regfile->status, saved->status, sizeof(regfile->status));
+}
+
+/* everything but the bus and the methods */
+void checkpoint_saveGate(CheckpointGate *saved, const GateModel *gate)
+{
+  memcpy(saved->keys, gate->keys, sizeof(saved->keys));
+  memcpy(saved->perms, gate->perms, sizeof(saved->perms));
+  memcpy(saved->deny, gate->deny, sizeof(saved->deny));
+  saved->loaded         = gate->loaded;
+  saved->key_in         = gate->key_in;
+  saved->time           = gate->time;
+  saved->deny_head      = gate->deny_head;
+  saved->deny_count     = gate->deny_count;
+  saved->deny_overflow  = gate->deny_overflow;
+  saved->deny_watermark = gate->deny_watermark;
+  saved->checks         = gate->checks;
+  saved->denials        = gate->denials;
+}
+
+void checkpoint_loadGate(GateModel *gate, const CheckpointGate *saved)
+{
+  memcpy(gate->keys, saved->keys, sizeof(gate->keys));
+  memcpy(gate->perms, saved->perms, sizeof(gate->perms));
+  memcpy(gate->deny, saved->deny, sizeof(gate->deny));
+  gate->loaded         = saved->loaded;
+  gate->key_in         = saved->key_in;
+  gate->time           = saved->time;
+  gate->deny_head      = saved->deny_head;
+  gate->deny_count     = saved->deny_count;
+  gate->deny_overflow  = saved->deny_overflow;
+  gate->deny_watermark = saved->deny_watermark;
+  gate->checks         = saved->checks;
+  gate->denials        = saved->denials;
+  gate->stale          = 1;
+}
+
+void checkpoint_saveKey(CheckpointKey *saved, const KeyModel *key)
+{
+  memcpy(saved->regs, key->regs, sizeof(saved->regs));
+  memcpy(saved->bank, key->bank, sizeof(saved->bank));
+  saved->key_out     = key->key_out;
+  saved->bank_index  = key->bank_index;
+  saved->bank_select = key->bank_select;
+}
+
+void checkpoint_loadKey(KeyModel *key, const CheckpointKey *saved)
+{
+  memcpy(key->regs, saved->regs, sizeof(key->regs));
+  memcpy(key->bank, saved->bank, sizeof(key->bank));
+  key->key_out     = saved->key_out;
+  key->bank_index  = saved->bank_index;
+  key->bank_select = saved->bank_select;
+}
+
+/* constructor */
+Checkpoint * newCheckpoint(const char *path)
+{
+  Checkpoint *self = (Checkpoint *) malloc(sizeof(Checkpoint));
+  const CheckpointHeader *header;
+  struct stat st;
+  void *map;
+  int fd, s;
+
+  /* out of memory */
+  if (! self)
+  {
+    return NULL;
+  }
+
+  /* zero */
+  memset(self, 0, sizeof(Checkpoint));
+
+  /* bind methods */
+  self->verify  = Checkpoint_verify;
+  self->restore = Checkpoint_restore;
+  self->toStack = Checkpoint_toStack;
+  self->free    = Checkpoint_free;
+
+  /* map the whole file, the descriptor is not needed after that */
+  if ((fd = open(path, O_RDONLY)) < 0)
+  {
+    free(self);
+    return NULL;
+  }
+  if (
+         fstat(fd, &st)
+      || st.st_size < (off_t) sizeof(CheckpointHeader)
+      || (map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0))
+         == MAP_FAILED
+      )
+  {
+    close(fd);
+    free(self);
+    return NULL;
+  }
+  close(fd);
+  self->header = header = (const CheckpointHeader *) map;
+  self->size = st.st_size;
+
+  /* header, and every section inside the file */
+  if (
+         header->magic != CHECKPOINT_MAGIC
+      || header->version != CHECKPOINT_VERSION
+      || header->size != self->size
+      )
+  {
+    return self->free(self);
+  }
+  for (s = 0; s < CHECKPOINT_NUM_SECTIONS; s++)
+  {
+    if (
+           header->sections[s].bytes
+        && (
+               header->sections[s].offset % CHECKPOINT_ALIGN
+            || header->sections[s].offset > self->size
+            || header->sections[s].bytes
+               > self->size - header->sections[s].offset
+           )
+        )
+    {
+      return self->free(self);
+    }
+  }
+
+  /* point into the mapping */
+  self->code      = (const unsigned char *) checkpoint_section(header,
+      CHECKPOINT_CODE, 0);
+  self->halfwords = header->sections[CHECKPOINT_CODE].bytes / 2;
+  self->regfile   = (const CheckpointRegFile *) checkpoint_section(header,
+      CHECKPOINT_REGFILE, sizeof(CheckpointRegFile));
+  self->mem       = (const u32 *) checkpoint_section(header,
+      CHECKPOINT_MEM, self->regfile ? self->regfile->num_regs * 4 : 0);
+  self->gate      = (const CheckpointGate *) checkpoint_section(header,
+      CHECKPOINT_GATE, sizeof(CheckpointGate));
+  self->key       = (const CheckpointKey *) checkpoint_section(header,
+      CHECKPOINT_KEY, sizeof(CheckpointKey));
+
+  /* a RegFile comes with its memory */
+  if (! self->regfile != ! self->mem)
+  {
+    return self->free(self);
+  }
+
+  return self;
+}
+
+/* checksum every section */
+int Checkpoint_verify(Checkpoint *self)
+{
+  return checkpoint_checksum(self->header) == self->header->checksum;
+}
+
+/* copy sections back into the models */
+int Checkpoint_restore(Checkpoint *self, RegFile *regfile, GateModel *gate,
+    KeyModel *key)
+{
+  int errors = 0;
+
+  if (regfile)
+  {
+    if (! self->regfile || self->regfile->num_regs != regfile->num_regs)
+    {
+      errors++;
+    }
+    else
+    {
+      memcpy(regfile->mem, self->mem, regfile->num_regs * sizeof(u32));
+      checkpoint_loadRegFile(regfile, self->regfile);
+    }
+  }
+
+  if (gate)
+  {
+    if (! self->gate)
+    {
+      errors++;
+    }
+    else
+    {
+      checkpoint_loadGate(gate, self->gate);
+    }
+  }
+
+  if (key)
+  {
+    if (! self->key)
+    {
+      errors++;
+    }
+    else
+    {
+      checkpoint_loadKey(key, self->key);
+    }
+  }
+
+  return errors;
+}
+
+/* newStack straight from the mapping */
+Stack * Checkpoint_toStack(Checkpoint *self)
+{
+  Stack *stack;
+
+  if (
+         ! self->halfwords
+      || ! (stack = newStack((unsigned char *) self->code, self->halfwords))
+      )
+  {
+    return NULL;
+  }
+  stack->jump(stack, self->header->pc);
+
+  return stack;
+}
+
+/* destructor */
+Checkpoint * Checkpoint_free(Checkpoint *self)
+{
+  if (self->header)
+  {
+    munmap((void *) self->header, self->size);
+  }
+  free(self);
+
+  return NULL;
+}
+
+/* lay out, fill through a shared mapping, then rename into place */
+int checkpoint_save(const char *path, u32 sequence, Stack *stack,
+    RegFile *regfile, GateModel *gate, KeyModel *key, int sync)
+{
+  CheckpointHeader layout, *header;
+  Instruction *instruction;
+  unsigned char *map, *code;
+  char *temp;
+  u32 halfwords = 0, offset;
+  int fd, s, error;
+
+  memset(&layout, 0, sizeof(layout));
+  for (instruction = stack ? stack->trunk : NULL; instruction;
+      instruction = instruction->next)
+  {
+    halfwords++;
+  }
+  layout.sections[CHECKPOINT_CODE].bytes    = 2 * halfwords;
+  layout.sections[CHECKPOINT_REGFILE].bytes = regfile
+    ? sizeof(CheckpointRegFile) : 0;
+  layout.sections[CHECKPOINT_MEM].bytes     = regfile
+    ? regfile->num_regs * sizeof(u32) : 0;
+  layout.sections[CHECKPOINT_GATE].bytes    = gate
+    ? sizeof(CheckpointGate) : 0;
+  layout.sections[CHECKPOINT_KEY].bytes     = key
+    ? sizeof(CheckpointKey) : 0;
+  for (offset = checkpoint_align(sizeof(CheckpointHeader)), s = 0;
+      s < CHECKPOINT_NUM_SECTIONS; s++)
+  {
+    layout.sections[s].offset = layout.sections[s].bytes ? offset : 0;
+    offset += checkpoint_align(layout.sections[s].bytes);
+  }
+  layout.magic    = CHECKPOINT_MAGIC;
+  layout.version  = CHECKPOINT_VERSION;
+  layout.size     = offset;
+  layout.sequence = sequence;
+  layout.pc       = stack ? stack->PC() : 0;
+  layout.lr       = stack ? stack->LR() : 0;
+
+  /* a sparse file the size of the layout, padding reads back as zero */
+  if (! (temp = (char *) malloc(strlen(path) + 5)))
+  {
+    errno = ENOMEM;
+    return -1;
+  }
+  sprintf(temp, "%s.tmp", path);
+  if ((fd = open(temp, O_RDWR | O_CREAT | O_TRUNC, 0644)) < 0)
+  {
+    free(temp);
+    return -1;
+  }
+  if (
+         ftruncate(fd, layout.size)
+      || (map = (unsigned char *) mmap(NULL, layout.size,
+             PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)) == MAP_FAILED
+      )
+  {
+    error = errno;
+    close(fd);
+    unlink(temp);
+    free(temp);
+    errno = error;
+    return -1;
+  }
+  header = (CheckpointHeader *) map;
+  memcpy(header, &layout, sizeof(layout));
+
+  /* sections, code last Instruction first as newStack builds its list */
+  code = map + layout.sections[CHECKPOINT_CODE].offset + 2 * halfwords;
+  for (instruction = stack ? stack->trunk : NULL; instruction;
+      instruction = instruction->next)
+  {
+    *--code = (instruction->binary >> 8) & 0xFF;
+    *--code = instruction->binary & 0xFF;
+  }
+  if (regfile)
+  {
+    checkpoint_saveRegFile((CheckpointRegFile *)
+        (map + layout.sections[CHECKPOINT_REGFILE].offset), regfile);
+    memcpy(map + layout.sections[CHECKPOINT_MEM].offset, regfile->mem,
+        regfile->num_regs * sizeof(u32));
+  }
+  if (gate)
+  {
+    checkpoint_saveGate((CheckpointGate *)
+        (map + layout.sections[CHECKPOINT_GATE].offset), gate);
+  }
+  if (key)
+  {
+    checkpoint_saveKey((CheckpointKey *)
+        (map + layout.sections[CHECKPOINT_KEY].offset), key);
+  }
+  header->checksum = checkpoint_checksum(header);
+
+  /* only a complete file replaces the old one */
+  error = munmap(map, layout.size) || (sync && fsync(fd));
+  error = close(fd) || error;
+  if (error || rename(temp, path))
+  {
+    error = errno;
+    unlink(temp);
+    free(temp);
+    errno = error;
+    return -1;
+  }
+  free(temp);
+
+  return 0;
+}
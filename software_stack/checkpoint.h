@@ -0,0 +1,218 @@
+#ifndef __SOFT_STACK_CHECKPOINT
+#define __SOFT_STACK_CHECKPOINT
+
+#include "stack.h"
+#include "regfile.h"
+#include "gate.h"
+#include "key.h"
+
+/** First word of every checkpoint file, "TSCP" little-endian */
+#define CHECKPOINT_MAGIC 0x50435354
+
+/** Bumped whenever any layout below changes, older files are refused */
+#define CHECKPOINT_VERSION 1
+
+/** Every section starts on a page of its own */
+#define CHECKPOINT_ALIGN 4096
+
+/**
+ * Words of a RegFile's memory holding registers rather than data: r0-r15,
+ *  the instruction, the banked FIQ/IRQ/SVC/MON/ABT/UND registers, the CPSR
+ *  and the SPSRs, up to REG_BOUND of reg_file_constants.vhd
+ */
+#define CHECKPOINT_REG_WORDS 42
+
+/** Sections of a checkpoint file, in file order */
+typedef enum _CheckpointSectionId
+{
+  /** the Stack's Instruction binaries, as newStack takes them to rebuild it */
+  CHECKPOINT_CODE = 0,
+
+  /** a CheckpointRegFile */
+  CHECKPOINT_REGFILE,
+
+  /** the RegFile's memory words, registers first */
+  CHECKPOINT_MEM,
+
+  /** a CheckpointGate */
+  CHECKPOINT_GATE,
+
+  /** a CheckpointKey */
+  CHECKPOINT_KEY,
+
+  CHECKPOINT_NUM_SECTIONS
+
+} CheckpointSectionId;
+
+/** Where a section sits in the file, 0 bytes if it was not saved */
+typedef struct _CheckpointSection
+{
+  u32 offset;
+  u32 bytes;
+} CheckpointSection;
+
+/** First bytes of a checkpoint file */
+typedef struct _CheckpointHeader
+{
+  /** CHECKPOINT_MAGIC and CHECKPOINT_VERSION */
+  u32 magic;
+  u32 version;
+
+  /** bytes in the file */
+  u32 size;
+
+  /** caller's count of checkpoints taken, to tell them apart */
+  u32 sequence;
+
+  /** the Stack's PC and LR */
+  u32 pc;
+  u32 lr;
+
+  /** FNV-1a over every section's words */
+  u32 checksum;
+  u32 reserved;
+
+  CheckpointSection sections[CHECKPOINT_NUM_SECTIONS];
+
+} CheckpointHeader;
+
+/** A RegFile's side channel and user space, its memory is saved apart */
+typedef struct _CheckpointRegFile
+{
+  u32 num_regs;
+  u32 address;
+  u32 data;
+  u32 data_out;
+  u32 pulse;
+  u32 status[REGFILE_USER_N_REGS];
+  u32 reserved;
+} CheckpointRegFile;
+
+/** A GateModel's table, key lookup and denied access FIFO */
+typedef struct _CheckpointGate
+{
+  unsigned long long checks;
+  unsigned long long denials;
+  u32 keys[GATE_NUM_KEYS];
+  u32 perms[GATE_NUM_KEYS];
+  u32 loaded;
+  u32 key_in;
+  u32 time;
+  u32 deny_head;
+  u32 deny_count;
+  u32 deny_overflow;
+  u32 deny_watermark;
+  u32 reserved;
+  GateDenial deny[GATE_DENY_DEPTH];
+} CheckpointGate;
+
+/** A KeyModel's registers, KEY_OUT and key bank */
+typedef struct _CheckpointKey
+{
+  u32 regs[KEY_NUM_REGS];
+  u32 key_out;
+  u32 bank_index;
+  u32 bank_select;
+  u32 reserved;
+  u32 bank[KEY_BANK_DEPTH];
+} CheckpointKey;
+
+/**
+ * A Checkpoint is a checkpoint file mapped read-only. Opening one checks
+ *  the header and section bounds and nothing else, every section is used
+ *  straight from the mapping, so restoring costs a copy per model and no
+ *  parsing. Pending Sim events are not part of a checkpoint, take one
+ *  between transactions.
+ */
+typedef struct _Checkpoint
+{
+  /** the mapping, and its size */
+  const CheckpointHeader *header;
+  size_t size;
+
+  /** sections inside the mapping, NULL where they were not saved */
+  const unsigned char *code;
+  size_t halfwords;
+  const CheckpointRegFile *regfile;
+  const u32 *mem;
+  const CheckpointGate *gate;
+  const CheckpointKey *key;
+
+  /**
+   * Recompute the checksum, which touches every page
+   *
+   * @return non-zero if it matches the header's
+   */
+  int (*verify)(struct _Checkpoint *self);
+
+  /**
+   * Copy the saved state back into models, any of which may be NULL
+   *
+   * @param regfile RegFile with as many memory words as the one saved
+   * @param gate GateModel, its key lookup is redone on the next check
+   * @param key KeyModel, onKey is not called for the restored KEY_OUT
+   * @return 0, or non-zero if a model was passed but never saved, or the
+   *  RegFile is the wrong size, leaving that model as it was
+   */
+  int (*restore)(struct _Checkpoint *self, RegFile *regfile, GateModel *gate,
+      KeyModel *key);
+
+  /**
+   * A new Stack of the saved Instructions, jumped to the saved PC
+   *
+   * @return the Stack, or NULL if no code was saved or out of memory
+   */
+  Stack * (*toStack)(struct _Checkpoint *self);
+
+  /**
+   * Destructor, unmaps the file
+   *
+   * @return NULL
+   */
+  struct _Checkpoint * (*free)(struct _Checkpoint *self);
+
+} Checkpoint;
+
+/**
+ * Constructor, maps a checkpoint file
+ *
+ * @param path file written by checkpoint_save
+ * @return a new Checkpoint, or NULL if the file can not be mapped, is not
+ *  a checkpoint of this version, or is truncated
+ */
+Checkpoint * newCheckpoint(const char *path);
+
+/**
+ * Write a checkpoint file, any of the models may be NULL. The file is
+ *  written beside path and renamed over it, so a crash leaves either the
+ *  old checkpoint or the new one.
+ *
+ * @param path file to write
+ * @param sequence stored in the header
+ * @param stack Stack whose Instructions, PC and LR are saved
+ * @param regfile RegFile whose memory, side channel and user space are saved
+ * @param gate GateModel to save
+ * @param key KeyModel to save
+ * @param sync non-zero to fsync before the rename
+ * @return 0, or non-zero with errno set if the file could not be written
+ */
+int checkpoint_save(const char *path, u32 sequence, Stack *stack,
+    RegFile *regfile, GateModel *gate, KeyModel *key, int sync);
+
+/**
+ * Copy a model's state to or from its section layout, for anything else
+ *  which keeps model state by value. A RegFile's memory is not included.
+ *  Loading a GateModel has it redo its key lookup on the next check, and
+ *  loading a KeyModel does not call onKey.
+ *
+ * @param saved section layout
+ * @param regfile, gate, key the model
+ */
+void checkpoint_saveRegFile(CheckpointRegFile *saved, const RegFile *regfile);
+void checkpoint_loadRegFile(RegFile *regfile, const CheckpointRegFile *saved);
+void checkpoint_saveGate(CheckpointGate *saved, const GateModel *gate);
+void checkpoint_loadGate(GateModel *gate, const CheckpointGate *saved);
+void checkpoint_saveKey(CheckpointKey *saved, const KeyModel *key);
+void checkpoint_loadKey(KeyModel *key, const CheckpointKey *saved);
+
+#endif /* __SOFT_STACK_CHECKPOINT */
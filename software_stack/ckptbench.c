@@ -0,0 +1,287 @@
+/*
+ * Measures checkpoints of a running program: a Stack, a RegFile with its
+ *  registers and memory, a GateModel and a KeyModel filled at random are
+ *  saved, mapped back and restored into a second set of models, after
+ *  checking the two sets agree. Then a guest storing random words through
+ *  the RegFile's side channel runs with and without a checkpoint every -k
+ *  stores, to show what periodic checkpointing costs.
+ *
+ * usage: ckptbench [-m memory words] [-c halfwords] [-r restores]
+ *                  [-s stores] [-k stores per checkpoint] [-y fsync]
+ *                  [-f file]
+ *
+ * build: cc -O2 -o ckptbench ckptbench.c checkpoint.c stack.c decode.c
+ *         regfile.c gate.c key.c sim.c hal.c
+ */
+#include <unistd.h>
+#include "bench.h"
+#include "checkpoint.h"
+
+/* where each set of models sits on the bus */
+#define CKPT_REGFILE_BASE 0x40000000
+#define CKPT_GATE_BASE    0x41000000
+#define CKPT_KEY_BASE     0x42000000
+#define CKPT_RESTORED     0x00100000
+
+/* state worth restoring in every model */
+static void ckptbench_fill(RegFile *regfile, GateModel *gate, KeyModel *key)
+{
+  unsigned i;
+
+  for (i = 0; i < regfile->num_regs; i++)
+  {
+    regfile->mem[i] = bench_random();
+  }
+  for (i = 0; i < REGFILE_USER_N_REGS; i++)
+  {
+    regfile->status[i] = bench_random();
+  }
+  regfile->address = bench_random() % regfile->num_regs;
+  regfile->data    = bench_random();
+
+  for (i = 0; i < GATE_NUM_KEYS; i++)
+  {
+    gate->keys[i]  = bench_random();
+    gate->perms[i] = bench_random() & 0xFFF;
+  }
+  for (i = 0; i < GATE_DENY_DEPTH; i++)
+  {
+    gate->deny[i].time = bench_random();
+    gate->deny[i].key  = bench_random();
+    gate->deny[i].info = bench_random();
+    gate->deny[i].addr = bench_random();
+  }
+  gate->loaded     = GATE_NUM_KEYS;
+  gate->key_in     = gate->keys[bench_random() % GATE_NUM_KEYS];
+  gate->time       = bench_random();
+  gate->deny_head  = bench_random() % GATE_DENY_DEPTH;
+  gate->deny_count = bench_random() % GATE_DENY_DEPTH;
+  gate->checks     = bench_random();
+  gate->denials    = gate->checks / 3;
+  gate->stale      = 1;
+
+  for (i = 0; i < KEY_NUM_REGS; i++)
+  {
+    key->regs[i] = bench_random();
+  }
+  for (i = 0; i < KEY_BANK_DEPTH; i++)
+  {
+    key->bank[i] = bench_random();
+  }
+  key->key_out     = key->regs[1];
+  key->bank_index  = bench_random() % KEY_BANK_DEPTH;
+  key->bank_select = bench_random() % KEY_BANK_DEPTH;
+}
+
+/* number of words or fields which differ between two sets of models */
+static unsigned long ckptbench_compare(RegFile *ra, GateModel *ga,
+    KeyModel *ka, RegFile *rb, GateModel *gb, KeyModel *kb)
+{
+  unsigned long errors = 0;
+  unsigned i;
+
+  for (i = 0; i < ra->num_regs; i++)
+  {
+    errors += ra->mem[i] != rb->mem[i];
+  }
+  errors += !! memcmp(ra->status, rb->status, sizeof(ra->status));
+  errors += ra->address != rb->address || ra->data != rb->data
+    || ra->data_out != rb->data_out || ra->pulse != rb->pulse;
+
+  errors += !! memcmp(ga->keys, gb->keys, sizeof(ga->keys));
+  errors += !! memcmp(ga->perms, gb->perms, sizeof(ga->perms));
+  errors += !! memcmp(ga->deny, gb->deny, sizeof(ga->deny));
+  errors += ga->loaded != gb->loaded || ga->key_in != gb->key_in
+    || ga->time != gb->time || ga->deny_head != gb->deny_head
+    || ga->deny_count != gb->deny_count || ga->checks != gb->checks
+    || ga->denials != gb->denials;
+
+  errors += !! memcmp(ka->regs, kb->regs, sizeof(ka->regs));
+  errors += !! memcmp(ka->bank, kb->bank, sizeof(ka->bank));
+  errors += ka->key_out != kb->key_out || ka->bank_index != kb->bank_index
+    || ka->bank_select != kb->bank_select;
+
+  return errors;
+}
+
+/* Instructions which differ between two Stacks, or in number */
+static unsigned long ckptbench_compareStacks(Stack *a, Stack *b)
+{
+  Instruction *x = a ? a->trunk : NULL, *y = b ? b->trunk : NULL;
+  unsigned long errors = 0;
+
+  for (; x && y; x = x->next, y = y->next)
+  {
+    errors += x->binary != y->binary || x->opcode != y->opcode;
+  }
+
+  return errors + (x != NULL) + (y != NULL);
+}
+
+/* guest stores through the side channel, a checkpoint every 'every' */
+static double ckptbench_run(RegFile *regfile, Stack *stack, GateModel *gate,
+    KeyModel *key, const char *path, unsigned long stores,
+    unsigned long every, int sync, unsigned long *taken)
+{
+  u32 base = regfile->device.base;
+  double started = bench_now();
+  unsigned long i;
+
+  for (i = 1; i <= stores; i++)
+  {
+    Xil_Out32(base + REGFILE_SET_ADDRESS * 4,
+        bench_random() % regfile->num_regs);
+    Xil_Out32(base + REGFILE_SET_DATA * 4, i);
+    Xil_Out32(base + REGFILE_PERFORM_OP * 4, 0);
+    if (every && i % every == 0)
+    {
+      if (checkpoint_save(path, *taken, stack, regfile, gate, key, sync))
+      {
+        perror(path);
+        exit(1);
+      }
+      (*taken)++;
+    }
+  }
+
+  return bench_now() - started;
+}
+
+int main(int argc, char **argv)
+{
+  unsigned long words = 1 << 20, restores = 32, stores = 1 << 22,
+                every = 1 << 20, errors = 0, taken = 0, r;
+  size_t halfwords = 4096, i;
+  const char *path = "ckptbench.ckpt";
+  double started, save, map = 0, copy = 0, verify = 0, plain, periodic;
+  RegFile *regfile, *regfile2;
+  GateModel *gate, *gate2;
+  KeyModel *key, *key2;
+  Stack *stack, *restored;
+  Checkpoint *checkpoint;
+  unsigned char *image;
+  int sync = 0, a;
+
+  /* options */
+  for (a = 1; a + 1 < argc && argv[a][0] == '-'; a += 2)
+  {
+    switch (argv[a][1])
+    {
+      case 'm': words     = strtoul(argv[a + 1], NULL, 0);  break;
+      case 'c': halfwords = strtoul(argv[a + 1], NULL, 0);  break;
+      case 'r': restores  = strtoul(argv[a + 1], NULL, 0);  break;
+      case 's': stores    = strtoul(argv[a + 1], NULL, 0);  break;
+      case 'k': every     = strtoul(argv[a + 1], NULL, 0);  break;
+      case 'y': sync      = atoi(argv[a + 1]);              break;
+      case 'f': path      = argv[a + 1];                    break;
+      default:  a = argc;                                   break;
+    }
+  }
+  if (
+         a != argc
+      || words < CHECKPOINT_REG_WORDS
+      || ! halfwords
+      || ! restores
+      || ! stores
+      || ! every
+      )
+  {
+    fprintf(stderr, "usage: %s [-m memory words] [-c halfwords] "
+        "[-r restores] [-s stores] [-k stores per checkpoint] [-y fsync] "
+        "[-f file]\n", argv[0]);
+    return 1;
+  }
+
+  if (
+         ! (image = (unsigned char *) malloc(2 * halfwords))
+      || ! (regfile = newRegFile(CKPT_REGFILE_BASE, words))
+      || ! (gate = newGateModel(CKPT_GATE_BASE))
+      || ! (key = newKeyModel(CKPT_KEY_BASE, NULL))
+      || ! (regfile2 = newRegFile(CKPT_REGFILE_BASE + CKPT_RESTORED, words))
+      || ! (gate2 = newGateModel(CKPT_GATE_BASE + CKPT_RESTORED))
+      || ! (key2 = newKeyModel(CKPT_KEY_BASE + CKPT_RESTORED, NULL))
+      )
+  {
+    fprintf(stderr, "out of memory\n");
+    return 1;
+  }
+  for (i = 0; i < 2 * halfwords; i++)
+  {
+    image[i] = (unsigned char) bench_random();
+  }
+  if (! (stack = newStack(image, halfwords)))
+  {
+    fprintf(stderr, "out of memory\n");
+    return 1;
+  }
+  ckptbench_fill(regfile, gate, key);
+
+  /* save once, then map and restore into the second set */
+  started = bench_now();
+  if (checkpoint_save(path, 0, stack, regfile, gate, key, sync))
+  {
+    perror(path);
+    return 1;
+  }
+  save = bench_now() - started;
+  for (r = 0; r < restores; r++)
+  {
+    started = bench_now();
+    if (! (checkpoint = newCheckpoint(path)))
+    {
+      fprintf(stderr, "%s: not a checkpoint\n", path);
+      return 1;
+    }
+    map += bench_now() - started;
+
+    started = bench_now();
+    errors += checkpoint->restore(checkpoint, regfile2, gate2, key2) != 0;
+    copy += bench_now() - started;
+
+    started = bench_now();
+    errors += ! checkpoint->verify(checkpoint);
+    verify += bench_now() - started;
+
+    if (r == restores - 1)
+    {
+      restored = checkpoint->toStack(checkpoint);
+      errors += ckptbench_compareStacks(stack, restored);
+      if (restored)
+      {
+        restored->free(restored);
+      }
+    }
+    checkpoint->free(checkpoint);
+  }
+  errors += ckptbench_compare(regfile, gate, key, regfile2, gate2, key2);
+
+  /* the same guest, without and with periodic checkpoints */
+  plain = ckptbench_run(regfile, stack, gate, key, path, stores, 0, sync,
+      &taken);
+  periodic = ckptbench_run(regfile, stack, gate, key, path, stores, every,
+      sync, &taken);
+
+  printf("state             %.2f MB: %lu words, %lu halfwords, gate, key\n",
+      (words * 4.0 + halfwords * 2.0 + sizeof(CheckpointGate)
+       + sizeof(CheckpointKey)) / (1 << 20), words,
+      (unsigned long) halfwords);
+  printf("save              %.3f ms%s\n", save * 1e3, sync ? ", fsync" : "");
+  printf("restore           %.3f ms map, %.3f ms copy, %.3f ms verify, "
+      "%lu wrong\n", map * 1e3 / restores, copy * 1e3 / restores,
+      verify * 1e3 / restores, errors);
+  printf("periodic          every %lu stores: %+.1f%% (%lu checkpoints, "
+      "%.2f M stores/s plain)\n", every, 100.0 * (periodic - plain) / plain,
+      taken, stores / plain / 1e6);
+
+  unlink(path);
+  stack->free(stack);
+  key2->free(key2);
+  gate2->free(gate2);
+  regfile2->free(regfile2);
+  key->free(key);
+  gate->free(gate);
+  regfile->free(regfile);
+  free(image);
+
+  return errors != 0;
+}
@@ -0,0 +1,197 @@
+#include "connector.h"
+
+/* method forward decls */
+u32 ConnectorModel_transfer(ConnectorModel *self, AxiTxn *txn);
+ConnectorModel * ConnectorModel_setKey(ConnectorModel *self, u32 key);
+ConnectorModel * ConnectorModel_report(ConnectorModel *self, FILE *out,
+    double clock_hz);
+ConnectorModel * ConnectorModel_clear(ConnectorModel *self);
+ConnectorModel * ConnectorModel_free(ConnectorModel *self);
+
+/* the later of two clocks */
+static u32 ConnectorModel_later(u32 a, u32 b)
+{
+  return a > b ? a : b;
+}
+
+/* time a transaction along one path, returns the clock it completes on */
+static u32 ConnectorModel_time(ConnectorModel *self, AxiTimeline *path,
+    const AxiTxn *txn, unsigned extra)
+{
+  unsigned dir = txn->write ? 1 : 0;
+  u32 *slot = &path->done[dir][path->oldest[dir]];
+  u32 accept, data;
+
+  /* wait for the address channel and an outstanding slot */
+  accept = ConnectorModel_later(txn->cycle, path->addr_free[dir]);
+  accept = ConnectorModel_later(accept, *slot);
+  path->addr_free[dir] = accept + 1;
+  accept += extra;
+
+  /* write data follows the address, read data follows the slave */
+  if (txn->write)
+  {
+    data = ConnectorModel_later(accept, path->data_free[dir]);
+    path->data_free[dir] = data + txn->beats;
+    *slot = data + txn->beats + self->slave_latency;
+  }
+  else
+  {
+    data = ConnectorModel_later(accept + self->slave_latency,
+        path->data_free[dir]);
+    path->data_free[dir] = data + txn->beats;
+    *slot = data + txn->beats;
+  }
+
+  path->oldest[dir] = (path->oldest[dir] + 1) % self->acceptance;
+
+  return *slot;
+}
+
+/* constructor */
+ConnectorModel * newConnectorModel(GateModel *gate, unsigned data_width,
+    unsigned acceptance, unsigned slave_latency, unsigned gate_latency)
+{
+  ConnectorModel *self;
+
+  /* misconfigured */
+  if (
+         ! gate || data_width < 8 || data_width % 8
+      || ! acceptance || acceptance > CONNECTOR_MAX_OUTSTANDING
+      )
+  {
+    return NULL;
+  }
+
+  /* out of memory */
+  if (! (self = (ConnectorModel *) malloc(sizeof(ConnectorModel))))
+  {
+    return NULL;
+  }
+
+  /* zero */
+  memset(self, 0, sizeof(ConnectorModel));
+
+  self->gate           = gate;
+  self->bytes_per_beat = data_width / 8;
+  self->acceptance     = acceptance;
+  self->slave_latency  = slave_latency;
+  self->gate_latency   = gate_latency;
+
+  /* bind methods */
+  self->transfer = ConnectorModel_transfer;
+  self->setKey   = ConnectorModel_setKey;
+  self->report   = ConnectorModel_report;
+  self->clear    = ConnectorModel_clear;
+  self->free     = ConnectorModel_free;
+
+  return self->clear(self);
+}
+
+/* gate and time a transaction */
+u32 ConnectorModel_transfer(ConnectorModel *self, AxiTxn *txn)
+{
+  ConnectorStats *stats = &self->stats;
+  u32 done, bare, latency;
+
+  /* the gate sees the address phase as it is issued */
+  self->gate->time = txn->cycle;
+  if (self->gate->check(self->gate, txn))
+  {
+    stats->denied++;
+  }
+
+  done = ConnectorModel_time(self, &self->gated, txn, self->gate_latency);
+  bare = ConnectorModel_time(self, &self->bare, txn, 0);
+
+  /* totals */
+  if (! stats->txns++)
+  {
+    stats->first_cycle = txn->cycle;
+  }
+  if (txn->write)
+  {
+    stats->writes++;
+  }
+  else
+  {
+    stats->reads++;
+  }
+  stats->beats += txn->beats;
+
+  latency = done - txn->cycle;
+  stats->latency      += latency;
+  stats->bare_latency += bare - txn->cycle;
+  if (latency > stats->max_latency)
+  {
+    stats->max_latency = latency;
+  }
+  if (done - bare > stats->max_added && done > bare)
+  {
+    stats->max_added = done - bare;
+  }
+  stats->last_cycle = ConnectorModel_later(stats->last_cycle, done);
+
+  return done;
+}
+
+/* switch KEY_IN */
+ConnectorModel * ConnectorModel_setKey(ConnectorModel *self, u32 key)
+{
+  if (key != self->gate->key_in)
+  {
+    self->stats.key_switches++;
+  }
+  self->gate->setKey(self->gate, key);
+
+  return self;
+}
+
+/* print totals */
+ConnectorModel * ConnectorModel_report(ConnectorModel *self, FILE *out,
+    double clock_hz)
+{
+  ConnectorStats *stats = &self->stats;
+  double cycles = stats->txns
+    ? (double) (stats->last_cycle - stats->first_cycle) : 0.0;
+  double bytes = (double) stats->beats * self->bytes_per_beat;
+  double txns = stats->txns ? (double) stats->txns : 1.0;
+
+  fprintf(out, "transactions      %lu (%lu read, %lu write)\n",
+      stats->txns, stats->reads, stats->writes);
+  fprintf(out, "data beats        %lu\n", stats->beats);
+  fprintf(out, "clocks            %.0f\n", cycles);
+  fprintf(out, "bandwidth         %.3f bytes/clock, %.1f MB/s\n",
+      cycles ? bytes / cycles : 0.0,
+      cycles ? bytes / cycles * clock_hz / 1e6 : 0.0);
+  fprintf(out, "latency           %.2f clocks mean, %u worst\n",
+      stats->latency / txns, stats->max_latency);
+  fprintf(out, "added by gate     %.2f clocks mean, %u worst\n",
+      (stats->latency - stats->bare_latency) / txns, stats->max_added);
+  fprintf(out, "permission checks %lu, %.1f M/s at ACLK\n",
+      self->gate->checks,
+      cycles ? self->gate->checks / cycles * clock_hz / 1e6 : 0.0);
+  fprintf(out, "denied            %lu%s\n", stats->denied,
+      self->gate->deny_overflow ? ", deny FIFO overflowed" : "");
+  fprintf(out, "key switches      %lu\n", stats->key_switches);
+
+  return self;
+}
+
+/* empty every channel, zero the totals */
+ConnectorModel * ConnectorModel_clear(ConnectorModel *self)
+{
+  memset(&self->gated, 0, sizeof(AxiTimeline));
+  memset(&self->bare, 0, sizeof(AxiTimeline));
+  memset(&self->stats, 0, sizeof(ConnectorStats));
+  self->gate->checks = self->gate->denials = 0;
+
+  return self;
+}
+
+/* destructor */
+ConnectorModel * ConnectorModel_free(ConnectorModel *self)
+{
+  free(self);
+  return NULL;
+}
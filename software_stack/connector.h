@@ -0,0 +1,139 @@
+#ifndef __SOFT_STACK_CONNECTOR
+#define __SOFT_STACK_CONNECTOR
+
+#include "gate.h"
+
+/** Most outstanding transactions per direction a ConnectorModel tracks */
+#define CONNECTOR_MAX_OUTSTANDING 32
+
+/** Totals gathered by a ConnectorModel since it was last cleared */
+typedef struct _ConnectorStats
+{
+  /** transactions, split by direction, and data beats moved */
+  unsigned long txns;
+  unsigned long reads;
+  unsigned long writes;
+  unsigned long beats;
+
+  /** transactions the gate refused something, and KEY_IN changes */
+  unsigned long denied;
+  unsigned long key_switches;
+
+  /** latency summed over every transaction, with and without the gate */
+  unsigned long long latency;
+  unsigned long long bare_latency;
+
+  /** worst latency, and worst latency added by the gate */
+  u32 max_latency;
+  u32 max_added;
+
+  /** first clock a transaction was issued, last clock one completed */
+  u32 first_cycle;
+  u32 last_cycle;
+
+} ConnectorStats;
+
+/**
+ * Channel occupancy of one path through the connector: when each address
+ *  and data channel is next free, and when each outstanding transaction
+ *  completes, indexed by AxiTxn::write
+ */
+typedef struct _AxiTimeline
+{
+  u32 addr_free[2];
+  u32 data_free[2];
+  u32 done[2][CONNECTOR_MAX_OUTSTANDING];
+  unsigned oldest[2];
+} AxiTimeline;
+
+/**
+ * A ConnectorModel is a transaction level model of the axi2axi_connector
+ *  and trusted_gate path. Each transaction is timed twice, once through
+ *  the gate and once as if it were not there, so the latency the gate
+ *  adds falls out directly.
+ *
+ * Each direction accepts 1 address per clock and moves 1 data beat per
+ *  clock, with at most 'acceptance' transactions outstanding, as set by
+ *  C_INTERCONNECT_S_AXI_*_ACCEPTANCE. The slave answers 'slave_latency'
+ *  clocks after an address (reads) or the last data beat (writes).
+ *
+ * The connector is wired straight through and the gate rewrites AxPROT
+ *  and AxUSER combinationally, so the hardware as built adds no clocks;
+ *  'gate_latency' models a register slice in front of the gate.
+ */
+typedef struct _ConnectorModel
+{
+  /** gate on the address channels */
+  GateModel *gate;
+
+  /** configuration */
+  unsigned bytes_per_beat;
+  unsigned acceptance;
+  unsigned slave_latency;
+  unsigned gate_latency;
+
+  /** occupancy with and without the gate */
+  AxiTimeline gated;
+  AxiTimeline bare;
+
+  /** totals */
+  ConnectorStats stats;
+
+  /**
+   * Send a transaction through the gate and time it, transactions must
+   *  be sent in the order they are issued
+   *
+   * @param txn transaction, its AxPROT and AxUSER are rewritten
+   * @return clock the transaction completes on
+   */
+  u32 (*transfer)(struct _ConnectorModel *self, AxiTxn *txn);
+
+  /**
+   * Switch KEY_IN, counting the switch
+   *
+   * @param key the new key
+   * @return this ConnectorModel
+   */
+  struct _ConnectorModel * (*setKey)(struct _ConnectorModel *self, u32 key);
+
+  /**
+   * Print bandwidth, latency and permission check totals
+   *
+   * @param out stream to print to
+   * @param clock_hz ACLK frequency, C_S_AXI_ACLK_FREQ_HZ in the mpd
+   * @return this ConnectorModel
+   */
+  struct _ConnectorModel * (*report)(struct _ConnectorModel *self, FILE *out,
+      double clock_hz);
+
+  /**
+   * Empty every channel and zero the totals
+   *
+   * @return this ConnectorModel
+   */
+  struct _ConnectorModel * (*clear)(struct _ConnectorModel *self);
+
+  /**
+   * Destructor, leaves the GateModel alone
+   *
+   * @return NULL
+   */
+  struct _ConnectorModel * (*free)(struct _ConnectorModel *self);
+
+} ConnectorModel;
+
+/**
+ * Constructor
+ *
+ * @param gate gate on the address channels
+ * @param data_width C_S_AXI_DATA_WIDTH in bits
+ * @param acceptance outstanding transactions per direction, 1 through
+ *  CONNECTOR_MAX_OUTSTANDING
+ * @param slave_latency clocks the slave takes to answer
+ * @param gate_latency clocks added in front of the gate, 0 as built
+ * @return a new ConnectorModel, or NULL if out of memory or misconfigured
+ */
+ConnectorModel * newConnectorModel(GateModel *gate, unsigned data_width,
+    unsigned acceptance, unsigned slave_latency, unsigned gate_latency);
+
+#endif /* __SOFT_STACK_CONNECTOR */
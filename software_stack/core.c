@@ -0,0 +1,600 @@
+#include "core.h"
+
+/* method forward decls */
+CoreStatus ThumbCore_step(Core *self, unsigned instruction);
+CoreStatus RtlCore_step(Core *self, unsigned instruction);
+Core * Core_free(Core *self);
+
+/* sets of opcodes, for the lists alu.vhd and muxer.vhd test against */
+#define CORE_BIT(op) (1UL << (op))
+
+/* alu.vhd sets N and Z for everything but the high register ADD and MOV */
+#define RTL_SETS_NZ   ( \
+    ((1UL << CORE_NUM_OPCODES) - 1) \
+    & ~CORE_BIT(CORE_ADD_RD_RM) & ~CORE_BIT(CORE_MOV_RD_RM) \
+    )
+
+/* ...and C for those except MVN and TST */
+#define RTL_SETS_C    ( \
+    RTL_SETS_NZ & ~CORE_BIT(CORE_MVN_RD_RM) & ~CORE_BIT(CORE_TST_RM_RN) \
+    )
+
+/* V is clear on a signed overflow of an addition... */
+#define RTL_ADD_V     ( \
+      CORE_BIT(CORE_ADC_RD_RM)    | CORE_BIT(CORE_ADD_RD_I) \
+    | CORE_BIT(CORE_ADD_RD_RN_I)  | CORE_BIT(CORE_ADD_RD_RM_RN) \
+    | CORE_BIT(CORE_AND_RD_RM)    | CORE_BIT(CORE_EOR_RD_RM) \
+    | CORE_BIT(CORE_NEG_RD_RM) \
+    )
+
+/* ...or of a subtraction, and set otherwise */
+#define RTL_SUB_V     ( \
+      CORE_BIT(CORE_CMN_RM_RN)    | CORE_BIT(CORE_CMP_RM_RN) \
+    | CORE_BIT(CORE_CMP_RM_RN_2)  | CORE_BIT(CORE_CMP_RN_I) \
+    | CORE_BIT(CORE_SBC_RD_RM)    | CORE_BIT(CORE_SUB_RD_I) \
+    | CORE_BIT(CORE_SUB_RD_RN_I)  | CORE_BIT(CORE_SUB_RD_RM_RN) \
+    )
+
+/* muxer.vhd writes nothing back for these */
+#define RTL_EN_NONE   ( \
+      CORE_BIT(CORE_CMP_RN_I)     | CORE_BIT(CORE_TST_RM_RN) \
+    | CORE_BIT(CORE_CMP_RM_RN)    | CORE_BIT(CORE_CMN_RM_RN) \
+    | CORE_BIT(CORE_BIC_RM_RN)    | CORE_BIT(CORE_CMP_RM_RN_2) \
+    )
+
+/* 32-bit word sign extended to 64 bits, as alu.vhd's a_se and b_se */
+#define RTL_SE(x) \
+  ((unsigned long long) (x) | ((x) >> 31 ? 0xFFFFFFFF00000000ULL : 0))
+
+const char *core_opcodeNames[CORE_NUM_OPCODES] =
+{
+  "LSL_Rd_Rm_I",  "LSR_Rd_Rm_I",  "ASR_Rd_Rm_I",  "ADD_Rd_Rm_Rn",
+  "SUB_Rd_Rm_Rn", "ADD_Rd_Rn_I",  "SUB_Rd_Rn_I",  "MOV_Rd_I",
+  "CMP_Rn_I",     "ADD_Rd_I",     "SUB_Rd_I",     "AND_Rd_Rm",
+  "EOR_Rd_Rm",    "LSL_Rd_Rs",    "LSR_Rd_Rs",    "ASR_Rd_Rs",
+  "ADC_Rd_Rm",    "SBC_Rd_Rm",    "ROR_Rd_Rs",    "TST_Rm_Rn",
+  "NEG_Rd_Rm",    "CMP_Rm_Rn",    "CMN_Rm_Rn",    "ORR_Rd_Rm",
+  "MUL_Rd_Rm",    "BIC_Rm_Rn",    "MVN_Rd_Rm",    "ADD_Rd_Rm",
+  "CMP_Rm_Rn_2",  "MOV_Rd_Rm"
+};
+
+/* non-zero if a high register instruction names r13-r15 */
+static int core_namesBanked(unsigned instruction)
+{
+  return (instruction & 0x80 && (instruction & 7) >= 5)
+    || (instruction & 0x40 && ((instruction >> 3) & 7) >= 5);
+}
+
+/* decode the way decoder.vhd does */
+CoreOpcode core_opcode(unsigned instruction)
+{
+  static const CoreOpcode shift_add_sub[4] =
+  {
+    CORE_ADD_RD_RM_RN, CORE_SUB_RD_RM_RN, CORE_ADD_RD_RN_I, CORE_SUB_RD_RN_I
+  };
+  static const CoreOpcode immediate[4] =
+  {
+    CORE_MOV_RD_I, CORE_CMP_RN_I, CORE_ADD_RD_I, CORE_SUB_RD_I
+  };
+  static const CoreOpcode alu[16] =
+  {
+    CORE_AND_RD_RM, CORE_EOR_RD_RM, CORE_LSL_RD_RS, CORE_LSR_RD_RS,
+    CORE_ASR_RD_RS, CORE_ADC_RD_RM, CORE_SBC_RD_RM, CORE_ROR_RD_RS,
+    CORE_TST_RM_RN, CORE_NEG_RD_RM, CORE_CMP_RM_RN, CORE_CMN_RM_RN,
+    CORE_ORR_RD_RM, CORE_MUL_RD_RM, CORE_BIC_RM_RN, CORE_MVN_RD_RM
+  };
+  static const CoreOpcode high[3] =
+  {
+    CORE_ADD_RD_RM, CORE_CMP_RM_RN_2, CORE_MOV_RD_RM
+  };
+  unsigned data = instruction & 0xFFFF;
+
+  /* 000CCIIIIIMMMDDD LSL, LSR, ASR */
+  if ((data >> 13) == 0 && ((data >> 11) & 3) != 3)
+  {
+    return (CoreOpcode) ((data >> 11) & 3);
+  }
+
+  /* 00011CCMMMNNNDDD, 00011CCIIINNNDDD ADD, SUB */
+  if ((data >> 11) == 3)
+  {
+    return shift_add_sub[(data >> 9) & 3];
+  }
+
+  /* 001CCDDDIIIIIIII MOV, CMP, ADD, SUB */
+  if ((data >> 13) == 1)
+  {
+    return immediate[(data >> 11) & 3];
+  }
+
+  /* 010000CCCCMMMDDD */
+  if ((data >> 10) == 0x10)
+  {
+    return alu[(data >> 6) & 15];
+  }
+
+  /*
+   * 010001CCHHMMMDDD, filtered out with both H flags clear, or BX. SP, LR
+   *  and PC live outside simple_processor's register file so are not
+   *  modelled.
+   */
+  if (
+         (data >> 10) == 0x11
+      && ((data >> 8) & 3) != 3
+      && ((data >> 6) & 3)
+      && ! core_namesBanked(data)
+      )
+  {
+    return high[(data >> 8) & 3];
+  }
+
+  return CORE_NUM_OPCODES;
+}
+
+/* common allocation */
+static Core * newCore(const char *name,
+    CoreStatus (*step)(Core *self, unsigned instruction))
+{
+  Core *self = (Core *) malloc(sizeof(Core));
+
+  /* out of memory */
+  if (! self)
+  {
+    return NULL;
+  }
+
+  /* zero */
+  memset(self, 0, sizeof(Core));
+
+  /* bind methods */
+  self->name = name;
+  self->step = step;
+  self->free = Core_free;
+
+  return self;
+}
+
+/* constructor */
+Core * newThumbCore()
+{
+  return newCore("thumb", ThumbCore_step);
+}
+
+/* constructor */
+Core * newRtlCore()
+{
+  return newCore("rtl", RtlCore_step);
+}
+
+/* set N and Z from a result */
+static u32 ThumbCore_nz(CoreState *state, u32 result)
+{
+  state->n = result >> 31;
+  state->z = ! result;
+
+  return result;
+}
+
+/* a + b + carry, setting every flag */
+static u32 ThumbCore_add(CoreState *state, u32 a, u32 b, u32 carry)
+{
+  u32 result = a + b + carry;
+
+  state->c = (u32) (((unsigned long long) a + b + carry) >> 32);
+  state->v = (~(a ^ b) & (a ^ result)) >> 31;
+
+  return ThumbCore_nz(state, result);
+}
+
+/* a shift of any amount, 'kind' is one of the shift by register opcodes */
+static u32 ThumbCore_shift(CoreState *state, CoreOpcode kind, u32 a,
+    unsigned amount)
+{
+  unsigned rotate = amount & 31;
+
+  /* C is left alone */
+  if (! amount)
+  {
+    return a;
+  }
+
+  switch (kind)
+  {
+    case CORE_LSL_RD_RS:
+      state->c = amount > 32 ? 0 : (u32) (((unsigned long long) a << amount)
+          >> 32) & 1;
+      return amount >= 32 ? 0 : a << amount;
+
+    case CORE_LSR_RD_RS:
+      state->c = amount > 32 ? 0 : (a >> (amount - 1)) & 1;
+      return amount >= 32 ? 0 : a >> amount;
+
+    case CORE_ASR_RD_RS:
+      if (amount >= 32)
+      {
+        state->c = a >> 31;
+        return state->c ? 0xFFFFFFFF : 0;
+      }
+      state->c = (a >> (amount - 1)) & 1;
+      return (a >> amount) | (a >> 31 ? ~(0xFFFFFFFF >> amount) : 0);
+
+    /* ROR */
+    default:
+      a = rotate ? (a >> rotate) | (a << (32 - rotate)) : a;
+      state->c = a >> 31;
+      return a;
+  }
+}
+
+/* execute as the architecture reference manual has it */
+CoreStatus ThumbCore_step(Core *self, unsigned instruction)
+{
+  CoreState *state = &self->state;
+  u32 *r = state->r;
+  CoreOpcode op = core_opcode(instruction);
+  unsigned rd = instruction & 7;
+  unsigned rm = (instruction >> 3) & 7;
+  unsigned rn = (instruction >> 6) & 7;
+  unsigned imm5 = (instruction >> 6) & 31;
+  unsigned imm8 = instruction & 0xFF;
+  unsigned hd = rd | ((instruction >> 4) & 8);
+  unsigned hm = rm | ((instruction >> 3) & 8);
+
+  if (op == CORE_NUM_OPCODES)
+  {
+    return CORE_UNDEFINED;
+  }
+
+  switch (op)
+  {
+    /* Rd := Rm shift #, LSR and ASR #0 mean 32 */
+    case CORE_LSL_RD_RM_I:
+    case CORE_LSR_RD_RM_I:
+    case CORE_ASR_RD_RM_I:
+      r[rd] = ThumbCore_nz(state, ThumbCore_shift(state,
+            (CoreOpcode) (op + CORE_LSL_RD_RS), r[rm],
+            imm5 || op == CORE_LSL_RD_RM_I ? imm5 : 32));
+      break;
+
+    /* Rd := Rn +/- Rm, Rm is in bits 8-6 */
+    case CORE_ADD_RD_RM_RN:
+      r[rd] = ThumbCore_add(state, r[rm], r[rn], 0);
+      break;
+    case CORE_SUB_RD_RM_RN:
+      r[rd] = ThumbCore_add(state, r[rm], ~r[rn], 1);
+      break;
+
+    /* Rd := Rn +/- #3 */
+    case CORE_ADD_RD_RN_I:
+      r[rd] = ThumbCore_add(state, r[rm], rn, 0);
+      break;
+    case CORE_SUB_RD_RN_I:
+      r[rd] = ThumbCore_add(state, r[rm], ~rn, 1);
+      break;
+
+    /* Rd := Rd <op> #8, Rd is in bits 10-8 */
+    case CORE_MOV_RD_I:
+      r[(instruction >> 8) & 7] = ThumbCore_nz(state, imm8);
+      break;
+    case CORE_CMP_RN_I:
+      ThumbCore_add(state, r[(instruction >> 8) & 7], ~imm8, 1);
+      break;
+    case CORE_ADD_RD_I:
+      r[(instruction >> 8) & 7] = ThumbCore_add(state,
+          r[(instruction >> 8) & 7], imm8, 0);
+      break;
+    case CORE_SUB_RD_I:
+      r[(instruction >> 8) & 7] = ThumbCore_add(state,
+          r[(instruction >> 8) & 7], ~imm8, 1);
+      break;
+
+    /* Rd := Rd <op> Rm */
+    case CORE_AND_RD_RM:
+      r[rd] = ThumbCore_nz(state, r[rd] & r[rm]);
+      break;
+    case CORE_EOR_RD_RM:
+      r[rd] = ThumbCore_nz(state, r[rd] ^ r[rm]);
+      break;
+    case CORE_LSL_RD_RS:
+    case CORE_LSR_RD_RS:
+    case CORE_ASR_RD_RS:
+    case CORE_ROR_RD_RS:
+      r[rd] = ThumbCore_nz(state,
+          ThumbCore_shift(state, op, r[rd], r[rm] & 0xFF));
+      break;
+    case CORE_ADC_RD_RM:
+      r[rd] = ThumbCore_add(state, r[rd], r[rm], state->c);
+      break;
+    case CORE_SBC_RD_RM:
+      r[rd] = ThumbCore_add(state, r[rd], ~r[rm], state->c);
+      break;
+    case CORE_TST_RM_RN:
+      ThumbCore_nz(state, r[rd] & r[rm]);
+      break;
+    case CORE_NEG_RD_RM:
+      r[rd] = ThumbCore_add(state, 0, ~r[rm], 1);
+      break;
+    case CORE_CMP_RM_RN:
+      ThumbCore_add(state, r[rd], ~r[rm], 1);
+      break;
+    case CORE_CMN_RM_RN:
+      ThumbCore_add(state, r[rd], r[rm], 0);
+      break;
+    case CORE_ORR_RD_RM:
+      r[rd] = ThumbCore_nz(state, r[rd] | r[rm]);
+      break;
+
+    /* C and V are left alone, as on ARMv6 */
+    case CORE_MUL_RD_RM:
+      r[rd] = ThumbCore_nz(state, r[rd] * r[rm]);
+      break;
+    case CORE_BIC_RM_RN:
+      r[rd] = ThumbCore_nz(state, r[rd] & ~r[rm]);
+      break;
+    case CORE_MVN_RD_RM:
+      r[rd] = ThumbCore_nz(state, ~r[rm]);
+      break;
+
+    /* high registers, only CMP sets flags */
+    case CORE_ADD_RD_RM:
+      r[hd] += r[hm];
+      break;
+    case CORE_CMP_RM_RN_2:
+      ThumbCore_add(state, r[hd], ~r[hm], 1);
+      break;
+    default:
+      r[hd] = r[hm];
+      break;
+  }
+
+  return CORE_OK;
+}
+
+/* execute the way the decoder, muxer and alu do */
+CoreStatus RtlCore_step(Core *self, unsigned instruction)
+{
+  CoreState *state = &self->state;
+  u32 *r = state->r;
+  CoreOpcode op = core_opcode(instruction);
+  unsigned long bit = CORE_BIT(op);
+  unsigned data = instruction & 0xFFFF;
+  unsigned rm = 0, rn = 0, rs = 0, rd = 0;
+  unsigned h1 = (data >> 4) & 8, h0 = (data >> 3) & 8;
+  unsigned long long a_se, b_se, buff, upper;
+  u32 a, b, imm8 = data & 0xFF, imm8_sgn = imm8 | (imm8 & 0x80 ? ~0xFF : 0);
+
+  if (op == CORE_NUM_OPCODES)
+  {
+    return CORE_UNDEFINED;
+  }
+
+  /* decoder.vhd register fields */
+  switch (op)
+  {
+    case CORE_ADD_RD_RM_RN:
+    case CORE_SUB_RD_RM_RN:
+      rm = (data >> 6) & 7;
+      rn = (data >> 3) & 7;
+      rd = data & 7;
+      break;
+    case CORE_ADD_RD_RN_I:
+    case CORE_SUB_RD_RN_I:
+      rn = (data >> 3) & 7;
+      rd = data & 7;
+      break;
+    case CORE_MOV_RD_I:
+    case CORE_ADD_RD_I:
+    case CORE_SUB_RD_I:
+      rd = (data >> 8) & 7;
+      break;
+    case CORE_CMP_RN_I:
+      rn = (data >> 8) & 7;
+      break;
+    case CORE_LSL_RD_RS:
+    case CORE_LSR_RD_RS:
+    case CORE_ASR_RD_RS:
+    case CORE_ROR_RD_RS:
+      rs = (data >> 3) & 7;
+      rd = data & 7;
+      break;
+    case CORE_TST_RM_RN:
+    case CORE_CMP_RM_RN:
+    case CORE_CMN_RM_RN:
+    case CORE_BIC_RM_RN:
+    case CORE_CMP_RM_RN_2:
+      rm = data & 7;
+      rn = (data >> 3) & 7;
+      break;
+    default:
+      rm = (data >> 3) & 7;
+      rd = data & 7;
+      break;
+  }
+
+  /* muxer.vhd ALU inputs, immediates come off the whole low byte */
+  switch (op)
+  {
+    case CORE_LSL_RD_RM_I:
+    case CORE_LSR_RD_RM_I:
+    case CORE_ASR_RD_RM_I:
+      a = r[rm];
+      b = imm8_sgn;
+      break;
+    case CORE_ADD_RD_RN_I:
+    case CORE_SUB_RD_RN_I:
+      a = r[rn];
+      b = imm8_sgn;
+      break;
+    case CORE_MOV_RD_I:
+    case CORE_ADD_RD_I:
+    case CORE_SUB_RD_I:
+      a = r[rd];
+      b = imm8_sgn;
+      break;
+    case CORE_CMP_RN_I:
+      a = r[rn];
+      b = imm8;
+      break;
+    case CORE_LSL_RD_RS:
+    case CORE_LSR_RD_RS:
+    case CORE_ASR_RD_RS:
+    case CORE_ROR_RD_RS:
+      a = r[rd];
+      b = r[rs];
+      break;
+    case CORE_ADD_RD_RM_RN:
+    case CORE_SUB_RD_RM_RN:
+    case CORE_TST_RM_RN:
+    case CORE_CMP_RM_RN:
+    case CORE_CMN_RM_RN:
+    case CORE_BIC_RM_RN:
+      a = r[rm];
+      b = r[rn];
+      break;
+    case CORE_ADD_RD_RM:
+    case CORE_MOV_RD_RM:
+      a = r[rn + h1];
+      b = r[rm + h0];
+      break;
+    case CORE_CMP_RM_RN_2:
+      a = r[rm + h1];
+      b = r[rn + h0];
+      break;
+    default:
+      a = r[rd];
+      b = r[rm];
+      break;
+  }
+
+  /* alu.vhd DO_MATH */
+  a_se = RTL_SE(a);
+  b_se = RTL_SE(b);
+  switch (op)
+  {
+    case CORE_MUL_RD_RM:
+      buff = (unsigned long long) a * b;
+      break;
+    case CORE_NEG_RD_RM:
+    case CORE_MVN_RD_RM:
+      buff = ~a_se + 1;
+      break;
+    case CORE_ADC_RD_RM:
+      buff = a_se + b_se + state->c;
+      break;
+    case CORE_SBC_RD_RM:
+      buff = a_se + ~b_se + state->c;
+      break;
+    case CORE_ADD_RD_I:
+    case CORE_ADD_RD_RM:
+    case CORE_ADD_RD_RN_I:
+    case CORE_ADD_RD_RM_RN:
+    case CORE_CMN_RM_RN:
+    case CORE_MOV_RD_I:
+    case CORE_MOV_RD_RM:
+      buff = a_se + b_se;
+      break;
+    case CORE_CMP_RM_RN:
+    case CORE_CMP_RM_RN_2:
+    case CORE_CMP_RN_I:
+    case CORE_SUB_RD_I:
+    case CORE_SUB_RD_RN_I:
+    case CORE_SUB_RD_RM_RN:
+      buff = a_se - b_se;
+      break;
+
+    /*
+     * Shifts slice a by b, so b past 32 indexes outside the operand: a
+     *  simulator stops there and the hardware has no defined result.
+     *  The upper word holds the bits shifted out.
+     */
+    case CORE_ASR_RD_RM_I:
+    case CORE_ASR_RD_RS:
+    case CORE_LSR_RD_RM_I:
+    case CORE_LSR_RD_RS:
+    case CORE_ROR_RD_RS:
+      if (b > 32)
+      {
+        return CORE_FAULT;
+      }
+      upper = a & ((1ULL << b) - 1);
+      if (op == CORE_ROR_RD_RS)
+      {
+        buff = b % 32 ? (a >> (b % 32)) | (a << (32 - b % 32)) : a;
+      }
+      else if (op == CORE_LSR_RD_RM_I || op == CORE_LSR_RD_RS)
+      {
+        buff = (unsigned long long) a >> b;
+      }
+      else
+      {
+        buff = (a_se >> b) & 0xFFFFFFFF;
+      }
+      buff |= upper << 32;
+      break;
+    case CORE_LSL_RD_RM_I:
+    case CORE_LSL_RD_RS:
+      if (b > 32)
+      {
+        return CORE_FAULT;
+      }
+      upper = b ? (unsigned long long) a >> (32 - b) : 0;
+      buff = (((unsigned long long) a << b) & 0xFFFFFFFF) | (upper << 32);
+      break;
+
+    case CORE_AND_RD_RM:
+    case CORE_TST_RM_RN:
+      buff = a & b;
+      break;
+    case CORE_BIC_RM_RN:
+      buff = a & ~b;
+      break;
+    case CORE_EOR_RD_RM:
+      buff = a ^ b;
+      break;
+    case CORE_ORR_RD_RM:
+      buff = (a | b) | ((unsigned long long) (a >> 31 & b >> 31) << 32);
+      break;
+    default:
+      buff = a;
+      break;
+  }
+
+  /* flags, V the opposite way round from the architecture */
+  if (bit & RTL_SETS_NZ)
+  {
+    state->z = ! (u32) buff;
+    state->n = (u32) (buff >> 31) & 1;
+  }
+  if (bit & RTL_SETS_C)
+  {
+    state->c = ! ! (buff >> 32);
+  }
+  if (bit & RTL_ADD_V)
+  {
+    state->v = ! (a >> 31 == b >> 31 && a >> 31 != ((u32) buff >> 31));
+  }
+  else if (bit & RTL_SUB_V)
+  {
+    state->v = ! (a >> 31 != b >> 31 && a >> 31 != ((u32) buff >> 31));
+  }
+
+  /* muxer.vhd write enables */
+  if (op == CORE_ADD_RD_RM || op == CORE_MOV_RD_RM)
+  {
+    r[rd + h1] = (u32) buff;
+  }
+  else if (! (bit & RTL_EN_NONE))
+  {
+    r[rd] = (u32) buff;
+  }
+
+  return CORE_OK;
+}
+
+/* destructor */
+Core * Core_free(Core *self)
+{
+  free(self);
+
+  return NULL;
+}
@@ -0,0 +1,115 @@
+#ifndef __SOFT_STACK_CORE
+#define __SOFT_STACK_CORE
+
+#include "hal.h"
+
+/** Registers a Core keeps, r13-r15 are never touched by data processing */
+#define CORE_NUM_REGS 16
+
+/** simple_processor's opcodes.vhd numbering of the instructions modelled */
+typedef enum _CoreOpcode
+{
+  CORE_LSL_RD_RM_I  = 0,  CORE_LSR_RD_RM_I  = 1,  CORE_ASR_RD_RM_I  = 2,
+  CORE_ADD_RD_RM_RN = 3,  CORE_SUB_RD_RM_RN = 4,  CORE_ADD_RD_RN_I  = 5,
+  CORE_SUB_RD_RN_I  = 6,  CORE_MOV_RD_I     = 7,  CORE_CMP_RN_I     = 8,
+  CORE_ADD_RD_I     = 9,  CORE_SUB_RD_I     = 10, CORE_AND_RD_RM    = 11,
+  CORE_EOR_RD_RM    = 12, CORE_LSL_RD_RS    = 13, CORE_LSR_RD_RS    = 14,
+  CORE_ASR_RD_RS    = 15, CORE_ADC_RD_RM    = 16, CORE_SBC_RD_RM    = 17,
+  CORE_ROR_RD_RS    = 18, CORE_TST_RM_RN    = 19, CORE_NEG_RD_RM    = 20,
+  CORE_CMP_RM_RN    = 21, CORE_CMN_RM_RN    = 22, CORE_ORR_RD_RM    = 23,
+  CORE_MUL_RD_RM    = 24, CORE_BIC_RM_RN    = 25, CORE_MVN_RD_RM    = 26,
+  CORE_ADD_RD_RM    = 27, CORE_CMP_RM_RN_2  = 28, CORE_MOV_RD_RM    = 29,
+
+  /** anything else */
+  CORE_NUM_OPCODES  = 30
+
+} CoreOpcode;
+
+/** What a Core made of an instruction */
+typedef enum _CoreStatus
+{
+  /** executed */
+  CORE_OK        = 0,
+
+  /** not a data processing instruction, nothing changed */
+  CORE_UNDEFINED = 1,
+
+  /** the core would stop, e.g. the RTL indexing out of range */
+  CORE_FAULT     = 2
+
+} CoreStatus;
+
+/** Architectural state compared between cores */
+typedef struct _CoreState
+{
+  u32 r[CORE_NUM_REGS];
+
+  /** flags, 0 or 1 */
+  u32 n;
+  u32 z;
+  u32 c;
+  u32 v;
+
+} CoreState;
+
+/**
+ * A Core executes ARM Thumb data processing instructions, formats 1 to 5,
+ *  one at a time against a CoreState. Different Cores model the same
+ *  instructions different ways, so running them in lockstep shows where
+ *  they disagree.
+ */
+typedef struct _Core
+{
+  /** short name used in reports */
+  const char *name;
+
+  /** registers and flags */
+  CoreState state;
+
+  /**
+   * Execute a single instruction
+   *
+   * @param instruction 16-bit Thumb code
+   * @return a CoreStatus
+   */
+  CoreStatus (*step)(struct _Core *self, unsigned instruction);
+
+  /**
+   * Destructor
+   *
+   * @return NULL
+   */
+  struct _Core * (*free)(struct _Core *self);
+
+} Core;
+
+/** opcodes.vhd names, indexed by CoreOpcode */
+extern const char *core_opcodeNames[CORE_NUM_OPCODES];
+
+/**
+ * Decode an instruction the way decoder.vhd does
+ *
+ * @param instruction 16-bit Thumb code
+ * @return its CoreOpcode, or CORE_NUM_OPCODES if it is not modelled or the
+ *  decoder filters it out as unpredictable
+ */
+CoreOpcode core_opcode(unsigned instruction);
+
+/**
+ * Constructor for the architectural model, executing each instruction as
+ *  the ARM Architecture Reference Manual describes it
+ *
+ * @return a new Core, or NULL if out of memory
+ */
+Core * newThumbCore();
+
+/**
+ * Constructor for the RTL model, a cycle-free transcription of how
+ *  simple_processor's decoder.vhd, muxer.vhd and alu.vhd execute each
+ *  instruction, including where they differ from the architecture
+ *
+ * @return a new Core, or NULL if out of memory
+ */
+Core * newRtlCore();
+
+#endif /* __SOFT_STACK_CORE */
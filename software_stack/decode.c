@@ -0,0 +1,307 @@
+#include "decode.h"
+
+#if defined(__AVX2__) || defined(__SSE4_1__)
+#include <immintrin.h>
+#endif
+
+/* method forward decls */
+size_t Decoder_decode(Decoder *self, const unsigned char *bytes,
+    size_t count);
+Decoder * Decoder_free(Decoder *self);
+
+/* every opcode, in stack.c */
+extern ThumbISA allInstructions[64];
+
+/* opcode of every value of bits 15-6, before any randomization */
+static unsigned short decode_opcodes[DECODE_INDEX_SIZE];
+
+/*
+ * Every value of bits 15-6 as loaded: its opcode in the low halfword and
+ *  bits 15-6 as they were before randomization in the high halfword, so a
+ *  single lookup undoes the permutation and decodes
+ */
+static unsigned decode_table[DECODE_INDEX_SIZE];
+
+/* non-zero once decode_table holds a permutation, the identity or not */
+static int decode_installed = 0;
+
+/* private storage for the opcodes, filled the first time they're needed */
+static const unsigned short * decode_getOpcodes()
+{
+  static int built = 0;
+  unsigned index, binary;
+  int i;
+
+  if (! built)
+  {
+    for (index = 0; index < DECODE_INDEX_SIZE; index++)
+    {
+      binary = index << DECODE_INDEX_SHIFT;
+
+      /* the same scan newInstruction did, so the last match still wins */
+      decode_opcodes[index] = UNUSED_IM8;
+      for (i = 0; i < 64; i++)
+      {
+        if (CODE_MATCHES(binary, allInstructions[i]))
+        {
+          decode_opcodes[index] = (unsigned short) allInstructions[i];
+        }
+      }
+    }
+    built = 1;
+  }
+
+  return decode_opcodes;
+}
+
+/* the table, plain until something is randomized */
+static const unsigned * decode_getTable()
+{
+  if (! decode_installed)
+  {
+    decode_randomize(NULL);
+  }
+
+  return decode_table;
+}
+
+/* index by the loaded bits 15-6, keep the plain ones */
+void decode_randomize(const unsigned short *inverse)
+{
+  const unsigned short *opcodes = decode_getOpcodes();
+  unsigned index, plain;
+
+  for (index = 0; index < DECODE_INDEX_SIZE; index++)
+  {
+    plain = inverse ? inverse[index] & (DECODE_INDEX_SIZE - 1) : index;
+    decode_table[index] = opcodes[plain]
+      | (plain << DECODE_INDEX_SHIFT << 16);
+  }
+  decode_installed = 1;
+}
+
+/* single halfword */
+ThumbISA decode_opcode(unsigned binary)
+{
+  return (ThumbISA)
+    (decode_getTable()[(binary & 0xFFFF) >> DECODE_INDEX_SHIFT] & 0xFFFF);
+}
+
+/* single halfword, as it was before randomization */
+unsigned decode_plain(unsigned binary)
+{
+  return (decode_getTable()[(binary & 0xFFFF) >> DECODE_INDEX_SHIFT] >> 16)
+    | (binary & ((1 << DECODE_INDEX_SHIFT) - 1));
+}
+
+/* constructor */
+Decoder * newDecoder(size_t capacity)
+{
+  Decoder *self = (Decoder *) malloc(sizeof(Decoder));
+
+  /* out of memory */
+  if (! self)
+  {
+    return NULL;
+  }
+
+  /* zero */
+  memset(self, 0, sizeof(Decoder));
+
+  /* bind methods */
+  self->decode   = Decoder_decode;
+  self->free     = Decoder_free;
+  self->capacity = capacity;
+
+  /* columns */
+  if (
+         ! capacity
+      || ! (self->opcode = (unsigned short *) malloc(capacity * 2))
+      || ! (self->imm11  = (unsigned short *) malloc(capacity * 2))
+      || ! (self->lo3    = (unsigned char *) malloc(capacity))
+      || ! (self->mid3   = (unsigned char *) malloc(capacity))
+      || ! (self->hi3    = (unsigned char *) malloc(capacity))
+      || ! (self->top3   = (unsigned char *) malloc(capacity))
+      || ! (self->imm5   = (unsigned char *) malloc(capacity))
+      || ! (self->imm8   = (unsigned char *) malloc(capacity))
+      || ! (self->h      = (unsigned char *) malloc(capacity))
+      )
+  {
+    return self->free(self);
+  }
+
+  /* build the table now rather than on the first decode */
+  decode_getTable();
+
+  return self;
+}
+
+#if defined(__AVX2__)
+
+/* 16 words of a register down to 16 bytes, in order */
+static __m128i Decoder_narrow(__m256i words)
+{
+  return _mm256_castsi256_si128(
+      _mm256_permute4x64_epi64(_mm256_packus_epi16(words, words), 0xD8));
+}
+
+/* DECODE_BATCH halfwords, x86 is little-endian so they load as they are */
+static void Decoder_batch(Decoder *self, const unsigned char *bytes,
+    size_t i, const unsigned *table)
+{
+  __m256i x = _mm256_loadu_si256((const __m256i *) (bytes + 2 * i));
+  __m256i r3 = _mm256_set1_epi16(7);
+  __m256i index = _mm256_srli_epi16(x, DECODE_INDEX_SHIFT);
+  __m256i low, high;
+
+  /* look the halfwords up 8 at a time */
+  low = _mm256_i32gather_epi32((const int *) table,
+      _mm256_cvtepu16_epi32(_mm256_castsi256_si128(index)), 4);
+  high = _mm256_i32gather_epi32((const int *) table,
+      _mm256_cvtepu16_epi32(_mm256_extracti128_si256(index, 1)), 4);
+
+  /* opcodes from the low halfwords, plain bits 15-6 from the high ones */
+  _mm256_storeu_si256((__m256i *) (self->opcode + i),
+      _mm256_permute4x64_epi64(_mm256_packus_epi32(
+          _mm256_and_si256(low, _mm256_set1_epi32(0xFFFF)),
+          _mm256_and_si256(high, _mm256_set1_epi32(0xFFFF))), 0xD8));
+  x = _mm256_or_si256(
+      _mm256_permute4x64_epi64(_mm256_packus_epi32(
+          _mm256_srli_epi32(low, 16), _mm256_srli_epi32(high, 16)), 0xD8),
+      _mm256_and_si256(x, _mm256_set1_epi16(0x3F)));
+  index = _mm256_srli_epi16(x, DECODE_INDEX_SHIFT);
+
+  _mm_storeu_si128((__m128i *) (self->lo3 + i),
+      Decoder_narrow(_mm256_and_si256(x, r3)));
+  _mm_storeu_si128((__m128i *) (self->mid3 + i),
+      Decoder_narrow(_mm256_and_si256(_mm256_srli_epi16(x, 3), r3)));
+  _mm_storeu_si128((__m128i *) (self->hi3 + i),
+      Decoder_narrow(_mm256_and_si256(index, r3)));
+  _mm_storeu_si128((__m128i *) (self->top3 + i),
+      Decoder_narrow(_mm256_and_si256(_mm256_srli_epi16(x, 8), r3)));
+  _mm_storeu_si128((__m128i *) (self->imm5 + i),
+      Decoder_narrow(_mm256_and_si256(index, _mm256_set1_epi16(31))));
+  _mm_storeu_si128((__m128i *) (self->imm8 + i),
+      Decoder_narrow(_mm256_and_si256(x, _mm256_set1_epi16(0xFF))));
+  _mm_storeu_si128((__m128i *) (self->h + i),
+      Decoder_narrow(_mm256_and_si256(index, _mm256_set1_epi16(3))));
+  _mm256_storeu_si256((__m256i *) (self->imm11 + i),
+      _mm256_and_si256(x, _mm256_set1_epi16(0x7FF)));
+}
+
+#elif defined(__SSE4_1__)
+
+/* DECODE_BATCH halfwords, x86 is little-endian so they load as they are */
+static void Decoder_batch(Decoder *self, const unsigned char *bytes,
+    size_t i, const unsigned *table)
+{
+  __m128i a = _mm_loadu_si128((const __m128i *) (bytes + 2 * i));
+  __m128i b = _mm_loadu_si128((const __m128i *) (bytes + 2 * i + 16));
+  __m128i r3 = _mm_set1_epi16(7), r5 = _mm_set1_epi16(31);
+  __m128i h = _mm_set1_epi16(3), r8 = _mm_set1_epi16(0xFF);
+  __m128i r11 = _mm_set1_epi16(0x7FF), r6 = _mm_set1_epi16(0x3F);
+  __m128i ai, bi;
+  unsigned short index[DECODE_BATCH], plain[DECODE_BATCH];
+  unsigned entry, j;
+
+  /* no gather before AVX2, the halfwords are looked up one at a time */
+  _mm_storeu_si128((__m128i *) index, _mm_srli_epi16(a, DECODE_INDEX_SHIFT));
+  _mm_storeu_si128((__m128i *) (index + 8),
+      _mm_srli_epi16(b, DECODE_INDEX_SHIFT));
+  for (j = 0; j < DECODE_BATCH; j++)
+  {
+    entry = table[index[j]];
+    self->opcode[i + j] = (unsigned short) entry;
+    plain[j] = (unsigned short) (entry >> 16);
+  }
+  a = _mm_or_si128(_mm_loadu_si128((const __m128i *) plain),
+      _mm_and_si128(a, r6));
+  b = _mm_or_si128(_mm_loadu_si128((const __m128i *) (plain + 8)),
+      _mm_and_si128(b, r6));
+  ai = _mm_srli_epi16(a, DECODE_INDEX_SHIFT);
+  bi = _mm_srli_epi16(b, DECODE_INDEX_SHIFT);
+
+  _mm_storeu_si128((__m128i *) (self->lo3 + i), _mm_packus_epi16(
+        _mm_and_si128(a, r3), _mm_and_si128(b, r3)));
+  _mm_storeu_si128((__m128i *) (self->mid3 + i), _mm_packus_epi16(
+        _mm_and_si128(_mm_srli_epi16(a, 3), r3),
+        _mm_and_si128(_mm_srli_epi16(b, 3), r3)));
+  _mm_storeu_si128((__m128i *) (self->hi3 + i), _mm_packus_epi16(
+        _mm_and_si128(ai, r3), _mm_and_si128(bi, r3)));
+  _mm_storeu_si128((__m128i *) (self->top3 + i), _mm_packus_epi16(
+        _mm_and_si128(_mm_srli_epi16(a, 8), r3),
+        _mm_and_si128(_mm_srli_epi16(b, 8), r3)));
+  _mm_storeu_si128((__m128i *) (self->imm5 + i), _mm_packus_epi16(
+        _mm_and_si128(ai, r5), _mm_and_si128(bi, r5)));
+  _mm_storeu_si128((__m128i *) (self->imm8 + i), _mm_packus_epi16(
+        _mm_and_si128(a, r8), _mm_and_si128(b, r8)));
+  _mm_storeu_si128((__m128i *) (self->h + i), _mm_packus_epi16(
+        _mm_and_si128(ai, h), _mm_and_si128(bi, h)));
+  _mm_storeu_si128((__m128i *) (self->imm11 + i), _mm_and_si128(a, r11));
+  _mm_storeu_si128((__m128i *) (self->imm11 + i + 8), _mm_and_si128(b, r11));
+}
+
+#endif
+
+/* columns for as much of the image as fits */
+size_t Decoder_decode(Decoder *self, const unsigned char *bytes,
+    size_t count)
+{
+  const unsigned *table = decode_getTable();
+  unsigned binary, entry;
+  size_t i = 0;
+
+  if (count > self->capacity)
+  {
+    count = self->capacity;
+  }
+
+#if defined(__AVX2__) || defined(__SSE4_1__)
+  for (; i + DECODE_BATCH <= count; i += DECODE_BATCH)
+  {
+    Decoder_batch(self, bytes, i, table);
+  }
+#endif
+
+  /* whatever is left, or everything without a vector unit */
+  for (; i < count; i++)
+  {
+    binary = bytes[2 * i] | (bytes[2 * i + 1] << 8);
+    entry = table[binary >> DECODE_INDEX_SHIFT];
+    binary = (entry >> 16) | (binary & ((1 << DECODE_INDEX_SHIFT) - 1));
+
+    self->opcode[i] = (unsigned short) entry;
+    self->lo3[i]    = binary & 7;
+    self->mid3[i]   = (binary >> 3) & 7;
+    self->hi3[i]    = (binary >> 6) & 7;
+    self->top3[i]   = (binary >> 8) & 7;
+    self->imm5[i]   = (binary >> 6) & 31;
+    self->imm8[i]   = binary & 0xFF;
+    self->h[i]      = (binary >> 6) & 3;
+    self->imm11[i]  = binary & 0x7FF;
+  }
+
+  self->count = count;
+
+  return count;
+}
+
+/* destructor */
+Decoder * Decoder_free(Decoder *self)
+{
+  if (self)
+  {
+    free(self->opcode);
+    free(self->imm11);
+    free(self->lo3);
+    free(self->mid3);
+    free(self->hi3);
+    free(self->top3);
+    free(self->imm5);
+    free(self->imm8);
+    free(self->h);
+    free(self);
+  }
+
+  return NULL;
+}
@@ -0,0 +1,115 @@
+#ifndef __SOFT_STACK_DECODE
+#define __SOFT_STACK_DECODE
+
+#include "main.h"
+#include "isa.h"
+
+/** Halfwords decoded per pass of the vector paths */
+#define DECODE_BATCH 16
+
+/** Bits 15-6 are all any ThumbISA code tests, so they index the opcodes */
+#define DECODE_INDEX_SHIFT 6
+#define DECODE_INDEX_SIZE  (1 << (16 - DECODE_INDEX_SHIFT))
+
+/**
+ * A Decoder turns a raw program image into struct-of-arrays columns, one
+ *  entry per halfword, for loading or re-decoding large images without
+ *  building an Instruction per halfword. The operand columns are
+ *  positional; which of them an opcode uses, and as what, is spelled out
+ *  in its ThumbISA name.
+ *
+ * Images randomized with decode_randomize's permutation decode to the
+ *  same columns as the plain image, through the same single lookup.
+ *
+ * SSE4.1 and AVX2 builds decode DECODE_BATCH halfwords at a time, anything
+ *  else falls back to a scalar loop giving the same columns.
+ */
+typedef struct _Decoder
+{
+  /** most halfwords a single decode can take */
+  size_t capacity;
+
+  /** halfwords in the columns from the last decode */
+  size_t count;
+
+  /** ThumbISA of each halfword, UNUSED_IM8 if none matches */
+  unsigned short *opcode;
+
+  /** bits 2-0, RGD or the 1st register of a compare */
+  unsigned char *lo3;
+
+  /** bits 5-3, RGM, RGN or RGS */
+  unsigned char *mid3;
+
+  /** bits 8-6, RGN or IM3 */
+  unsigned char *hi3;
+
+  /** bits 10-8, RGD or RGN of the 8-bit immediate forms, or a condition */
+  unsigned char *top3;
+
+  /** bits 10-6, IM5 */
+  unsigned char *imm5;
+
+  /** bits 7-0, IM8 or a register list */
+  unsigned char *imm8;
+
+  /** bits 7-6, h flags */
+  unsigned char *h;
+
+  /** bits 10-0, the branch offset */
+  unsigned short *imm11;
+
+  /**
+   * Decode an image into the columns
+   *
+   * @param bytes little-endian halfwords
+   * @param count number of halfwords
+   * @return the number decoded, count or capacity whichever is less
+   */
+  size_t (*decode)(struct _Decoder *self, const unsigned char *bytes,
+      size_t count);
+
+  /**
+   * Destructor
+   *
+   * @return NULL
+   */
+  struct _Decoder * (*free)(struct _Decoder *self);
+
+} Decoder;
+
+/**
+ * Constructor
+ *
+ * @param capacity most halfwords a single decode can take
+ * @return a new Decoder, or NULL if out of memory
+ */
+Decoder * newDecoder(size_t capacity);
+
+/**
+ * Opcode of a single halfword, by table lookup
+ *
+ * @param binary instruction binary
+ * @return the last ThumbISA code in allInstructions it matches, as
+ *  newInstruction has always picked, or UNUSED_IM8
+ */
+ThumbISA decode_opcode(unsigned binary);
+
+/**
+ * A single halfword as it was before randomization
+ *
+ * @param binary instruction binary, as loaded
+ * @return the plain instruction binary
+ */
+unsigned decode_plain(unsigned binary);
+
+/**
+ * Install a permutation of bits 15-6 for decoding to undo, every lookup
+ *  from then on takes halfwords as the permutation left them
+ *
+ * @param inverse plain bits 15-6 of each loaded value of bits 15-6,
+ *  DECODE_INDEX_SIZE of them, or NULL to decode plain halfwords again
+ */
+void decode_randomize(const unsigned short *inverse);
+
+#endif /* __SOFT_STACK_DECODE */
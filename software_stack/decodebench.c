@@ -0,0 +1,142 @@
+/*
+ * Measures the batch decoder on a random image, after checking its
+ *  columns against decoding each halfword on its own.
+ *
+ * usage: decodebench [-n halfwords] [-c decoder capacity] [-p passes]
+ *
+ * build: cc -O2 -march=native -o decodebench decodebench.c decode.c stack.c
+ *  -march=native picks up the AVX2 or SSE4.1 path, leave it out for the
+ *  scalar one
+ */
+#include "bench.h"
+#include "decode.h"
+
+/* every opcode, in stack.c */
+extern ThumbISA allInstructions[64];
+
+/* check a decode against the slow path, returns the number of errors */
+static unsigned long decodebench_check(Decoder *decoder,
+    const unsigned char *bytes)
+{
+  unsigned long errors = 0;
+  unsigned binary;
+  ThumbISA opcode;
+  size_t i;
+  int j;
+
+  for (i = 0; i < decoder->count; i++)
+  {
+    binary = bytes[2 * i] | (bytes[2 * i + 1] << 8);
+
+    /* newInstruction's original scan */
+    opcode = UNUSED_IM8;
+    for (j = 0; j < 64; j++)
+    {
+      if (CODE_MATCHES(binary, allInstructions[j]))
+      {
+        opcode = allInstructions[j];
+      }
+    }
+
+    if (
+           decoder->opcode[i] != opcode
+        || decoder->lo3[i]    != (binary & 7)
+        || decoder->mid3[i]   != ((binary >> 3) & 7)
+        || decoder->hi3[i]    != ((binary >> 6) & 7)
+        || decoder->top3[i]   != ((binary >> 8) & 7)
+        || decoder->imm5[i]   != ((binary >> 6) & 31)
+        || decoder->imm8[i]   != (binary & 0xFF)
+        || decoder->h[i]      != ((binary >> 6) & 3)
+        || decoder->imm11[i]  != (binary & 0x7FF)
+        )
+    {
+      if (! errors++)
+      {
+        fprintf(stderr, "halfword %lu, 0x%04X, decoded wrong\n",
+            (unsigned long) i, binary);
+      }
+    }
+  }
+
+  return errors;
+}
+
+int main(int argc, char **argv)
+{
+  size_t halfwords = 1 << 24, capacity = 1 << 16, done, at;
+  unsigned long passes = 64, pass, errors = 0, sum = 0;
+  unsigned char *image;
+  Decoder *decoder;
+  double started, seconds;
+  size_t i;
+  int a;
+
+  /* options */
+  for (a = 1; a + 1 < argc && argv[a][0] == '-'; a += 2)
+  {
+    switch (argv[a][1])
+    {
+      case 'n': halfwords = strtoul(argv[a + 1], NULL, 0);  break;
+      case 'c': capacity  = strtoul(argv[a + 1], NULL, 0);  break;
+      case 'p': passes    = strtoul(argv[a + 1], NULL, 0);  break;
+      default:  a = argc;                                   break;
+    }
+  }
+  if (a != argc || ! halfwords || ! capacity || ! passes)
+  {
+    fprintf(stderr, "usage: %s [-n halfwords] [-c decoder capacity] "
+        "[-p passes]\n", argv[0]);
+    return 1;
+  }
+
+  if (
+         ! (image = (unsigned char *) malloc(2 * halfwords))
+      || ! (decoder = newDecoder(capacity))
+      )
+  {
+    fprintf(stderr, "out of memory\n");
+    return 1;
+  }
+  for (i = 0; i < 2 * halfwords; i++)
+  {
+    image[i] = (unsigned char) bench_random();
+  }
+
+  /* every column has to match before the speed means anything */
+  for (at = 0; at < halfwords; at += done)
+  {
+    done = decoder->decode(decoder, image + 2 * at, halfwords - at);
+    errors += decodebench_check(decoder, image + 2 * at);
+  }
+
+  /* decode the whole image again and again, in capacity sized chunks */
+  started = bench_now();
+  for (pass = 0; pass < passes; pass++)
+  {
+    for (at = 0; at < halfwords; at += done)
+    {
+      done = decoder->decode(decoder, image + 2 * at, halfwords - at);
+      sum += decoder->opcode[done - 1];
+    }
+  }
+  seconds = bench_now() - started;
+
+  printf("path              %s\n",
+#if defined(__AVX2__)
+      "AVX2"
+#elif defined(__SSE4_1__)
+      "SSE4.1"
+#else
+      "scalar"
+#endif
+      );
+  printf("halfwords         %lu x %lu passes, %lu wrong\n",
+      (unsigned long) halfwords, passes, errors);
+  printf("host              %.2f G halfwords/s (%lx)\n",
+      seconds > 0 ? halfwords * (double) passes / seconds / 1e9 : 0.0, sum);
+
+  decoder->free(decoder);
+  free(image);
+
+  return errors != 0;
+}
@@ -0,0 +1,585 @@
+#include "disasm.h"
+#include "decode.h"
+
+/* register names as thumb_asm.hpp reads them */
+static const char *disasm_regs[16] =
+{
+  "r0", "r1", "r2", "r3", "r4", "r5", "r6", "r7",
+  "r8", "r9", "r10", "r11", "r12", "sp", "lr", "pc"
+};
+
+/* every halfword's text on its own, one which doesn't fit its slot going
+   in a long slot whose index its slot holds, 6450 of them */
+#define DISASM_SLOT 32
+#define DISASM_LONG_SLOTS 0x2000
+static char disasm_slots[0x10000][DISASM_SLOT];
+static char disasm_long[DISASM_LONG_SLOTS][DISASM_TEXT_MAX];
+static int disasm_built = 0;
+
+/* each halfword's length, and whether it is half of a BL or BLX pair,
+   its text on its own being right only when it is not paired */
+#define DISASM_LENGTH    0x3F
+#define DISASM_LOW_HALF  0x40
+#define DISASM_HIGH_HALF 0x80
+static unsigned char disasm_lengths[0x10000];
+
+/* B<cond> mnemonics, in ConditionBits order, AL and NV being no branch */
+static const char *disasm_conds[14] =
+{
+  "BEQ", "BNE", "BCS", "BCC", "BMI", "BPL", "BVS", "BVC",
+  "BHI", "BLS", "BGE", "BLT", "BGT", "BLE"
+};
+
+static char * disasm_str(char *out, const char *s)
+{
+  while (*s)
+  {
+    *out++ = *s++;
+  }
+  return out;
+}
+
+static char * disasm_dec(char *out, unsigned value)
+{
+  char digits[10];
+  int n = 0;
+
+  do
+  {
+    digits[n++] = (char) ('0' + value % 10);
+    value /= 10;
+  } while (value);
+  while (n)
+  {
+    *out++ = digits[--n];
+  }
+  return out;
+}
+
+/* 0x and 4 hex digits */
+static char * disasm_hex(char *out, unsigned value)
+{
+  static const char hex[16] = "0123456789ABCDEF";
+
+  *out++ = '0';
+  *out++ = 'x';
+  *out++ = hex[(value >> 12) & 15];
+  *out++ = hex[(value >> 8) & 15];
+  *out++ = hex[(value >> 4) & 15];
+  *out++ = hex[value & 15];
+  return out;
+}
+
+/* ", #value" */
+static char * disasm_imm(char *out, unsigned value)
+{
+  *out++ = ',';
+  *out++ = ' ';
+  *out++ = '#';
+  return disasm_dec(out, value);
+}
+
+/* ", rN" */
+static char * disasm_reg(char *out, unsigned reg)
+{
+  *out++ = ',';
+  *out++ = ' ';
+  return disasm_str(out, disasm_regs[reg]);
+}
+
+/* mnemonic, then the first register */
+static char * disasm_op(char *out, const char *mnemonic, unsigned reg)
+{
+  out = disasm_str(out, mnemonic);
+  *out++ = ' ';
+  return disasm_str(out, disasm_regs[reg]);
+}
+
+/* ", [rN, " */
+static char * disasm_base(char *out, unsigned reg)
+{
+  *out++ = ',';
+  *out++ = ' ';
+  *out++ = '[';
+  out = disasm_str(out, disasm_regs[reg]);
+  *out++ = ',';
+  *out++ = ' ';
+  return out;
+}
+
+/* {r0-r3, r5, lr}, runs of 3 or more as a range */
+static char * disasm_list(char *out, unsigned list)
+{
+  unsigned r = 0, end;
+  int first = 1;
+
+  *out++ = '{';
+  while (r < 16)
+  {
+    if (! (list & (1u << r)))
+    {
+      r++;
+      continue;
+    }
+    for (end = r; end + 1 < 8 && (list & (1u << (end + 1))); end++);
+    if (! first)
+    {
+      *out++ = ',';
+      *out++ = ' ';
+    }
+    first = 0;
+    out = disasm_str(out, disasm_regs[r]);
+    if (end >= r + 2)
+    {
+      *out++ = '-';
+      out = disasm_str(out, disasm_regs[end]);
+      r = end;
+    }
+    r++;
+  }
+  *out++ = '}';
+  return out;
+}
+
+/* . plus or minus a byte offset */
+static char * disasm_rel(char *out, int offset)
+{
+  *out++ = '.';
+  *out++ = offset < 0 ? '-' : '+';
+  return disasm_dec(out, offset < 0 ? (unsigned) -offset : (unsigned) offset);
+}
+
+/* the 22-bit halfword offset of a BL or BLX pair */
+static int disasm_pair(unsigned high, unsigned low)
+{
+  int offset = (int) (((high & 0x7FF) << 11) | (low & 0x7FF));
+
+  return (offset ^ 0x200000) - 0x200000;
+}
+
+/* non-zero if high and low are a BL or BLX pair, in that order */
+static int disasm_paired(unsigned high, unsigned low)
+{
+  ThumbISA code;
+
+  if (high >= DISASM_NONE || low >= DISASM_NONE)
+  {
+    return 0;
+  }
+  code = decode_opcode(low);
+  return decode_opcode(high) == BLXH_IM8
+    && (code == BL_IM8 || code == BLX_IM8);
+}
+
+/* .hword and what the halfword is, for those an assembler can't spell */
+static char * disasm_hword(char *out, unsigned binary, const char *what)
+{
+  out = disasm_hex(disasm_str(out, ".hword "), binary);
+  if (what)
+  {
+    out = disasm_str(disasm_str(out, " @ "), what);
+  }
+  return out;
+}
+
+/* mnemonic of every code but the branches, lists and .hword ones */
+static const char * disasm_mnemonic(ThumbISA code)
+{
+  switch (code)
+  {
+    case LSL_IM5_RGM_RGD: case LSL_RGS_RGD:       return "LSL";
+    case LSR_IM5_RGM_RGD: case LSR_RGS_RGD:       return "LSR";
+    case ASR_IM5_RGM_RGD: case ASR_RGS_RGD:       return "ASR";
+    case ADD_RGM_RGN_RGD: case ADD_IM3_RGN_RGD:
+    case ADD_RGD_IM8:     case ADD_HF2_RGM_RGD:
+    case ADDPC_RGD_IM8:   case ADDSP_RGD_IM8:     return "ADD";
+    case SUB_RGM_RGN_RGD: case SUB_IM3_RGN_RGD:
+    case SUB_RGM_IM8:     case SUB_C11_IM7:       return "SUB";
+    case MOV_RGD_IM8:     case MOV_HF2_RGM_RGD:   return "MOV";
+    case CMP_RGN_IM8:     case CMP_RGN_RGM:
+    case CMP_HF2_RGN_RGM:                         return "CMP";
+    case AND_RGM_RGD:                             return "AND";
+    case EOR_RGM_RGD:                             return "EOR";
+    case ADC_RGM_RGD:                             return "ADC";
+    case SBC_RGM_RGD:                             return "SBC";
+    case ROR_RGS_RGD:                             return "ROR";
+    case TST_RGN_RGM:                             return "TST";
+    case NEG_RGM_RGD:                             return "NEG";
+    case CMN_RGN_RGM:                             return "CMN";
+    case ORR_RGM_RGD:                             return "ORR";
+    case MUL_RGM_RGD:                             return "MUL";
+    case BIC_RGN_RGM:                             return "BIC";
+    case MVN_RGM_RGD:                             return "MVN";
+    case BX_HF1_RGM_C30:                          return "BX";
+    case BLX_HF1_RGM_C30:                         return "BLX";
+    case STR_RGM_RGN_RGD: case STR_IM5_RGN_RGD:
+    case STRSP_RGD_IM8:                           return "STR";
+    case LDR_RGM_RGN_RGD: case LDR_IM5_RGN_RGD:
+    case LDRSP_RGD_IM8:   case LDRPC_RGD_IM8:     return "LDR";
+    case STRH_RGM_RGN_RGD: case STRH_IM5_RGN_RGD: return "STRH";
+    case LDRH_RGM_RGN_RGD: case LDRH_IM5_RGN_RGD: return "LDRH";
+    case STRB_RGM_RGN_RGD: case STRB_IM5_RGN_RGD: return "STRB";
+    case LDRB_RGM_RGN_RGD: case LDRB_IM5_RGN_RGD: return "LDRB";
+    case LDRSB_RGM_RGN_RGD:                       return "LDRSB";
+    case LDRSH_RGM_RGN_RGD:                       return "LDRSH";
+    case PUSH_HF1_IM8:                            return "PUSH";
+    case POP_HF1_IM8:                             return "POP";
+    case STMIA_RGN_IM8:                           return "STMIA";
+    case LDMIA_RGN_RL8:                           return "LDMIA";
+    case BKPT_IM8:                                return "BKPT";
+    case SWI_IM8:                                 return "SWI";
+    default:                                      return NULL;
+  }
+}
+
+/* as thumb_asm.hpp reads it */
+size_t disasm_text(unsigned binary, unsigned prev, unsigned next, char *out)
+{
+  char *start = out;
+  unsigned lo3 = binary & 7, mid3 = (binary >> 3) & 7,
+           hi3 = (binary >> 6) & 7, top3 = (binary >> 8) & 7,
+           imm5 = (binary >> 6) & 31, imm8 = binary & 0xFF,
+           h1 = (binary >> 4) & 8, h2 = (binary >> 3) & 8;
+  ThumbISA code = decode_opcode(binary);
+  const char *m = disasm_mnemonic(code);
+
+  switch (code)
+  {
+    /* rd, rm, #shift, LSR and ASR by 32 as 0 */
+    case LSL_IM5_RGM_RGD:
+    case LSR_IM5_RGM_RGD:
+    case ASR_IM5_RGM_RGD:
+      out = disasm_reg(disasm_op(out, m, lo3), mid3);
+      out = disasm_imm(out, imm5 || code == LSL_IM5_RGM_RGD ? imm5 : 32);
+      break;
+
+    case ADD_RGM_RGN_RGD:
+    case SUB_RGM_RGN_RGD:
+      out = disasm_reg(disasm_reg(disasm_op(out, m, lo3), mid3), hi3);
+      break;
+
+    case ADD_IM3_RGN_RGD:
+    case SUB_IM3_RGN_RGD:
+      out = disasm_imm(disasm_reg(disasm_op(out, m, lo3), mid3), hi3);
+      break;
+
+    case MOV_RGD_IM8:
+    case CMP_RGN_IM8:
+    case ADD_RGD_IM8:
+    case SUB_RGM_IM8:
+      out = disasm_imm(disasm_op(out, m, top3), imm8);
+      break;
+
+    /* the data processing group, rd, rm */
+    case AND_RGM_RGD: case EOR_RGM_RGD: case LSL_RGS_RGD: case LSR_RGS_RGD:
+    case ASR_RGS_RGD: case ADC_RGM_RGD: case SBC_RGM_RGD: case ROR_RGS_RGD:
+    case TST_RGN_RGM: case NEG_RGM_RGD: case CMP_RGN_RGM: case CMN_RGN_RGM:
+    case ORR_RGM_RGD: case MUL_RGM_RGD: case BIC_RGN_RGM: case MVN_RGM_RGD:
+      out = disasm_reg(disasm_op(out, m, lo3), mid3);
+      break;
+
+    /* r0-r15 through the h flags. An assembler spells a CMP of two low
+       registers as the data processing one */
+    case CMP_HF2_RGN_RGM:
+    case ADD_HF2_RGM_RGD:
+    case MOV_HF2_RGM_RGD:
+      if (code == CMP_HF2_RGN_RGM && ! h1 && ! h2)
+      {
+        out = disasm_hword(out, binary, "CMP, no high register");
+        break;
+      }
+      out = disasm_reg(disasm_op(out, m, lo3 | h1), mid3 | h2);
+      break;
+
+    case BX_HF1_RGM_C30:
+    case BLX_HF1_RGM_C30:
+      if (lo3)
+      {
+        out = disasm_hword(out, binary, code == BX_HF1_RGM_C30
+            ? "BX, bits 2-0 set" : "BLX, bits 2-0 set");
+        break;
+      }
+      out = disasm_op(out, m, mid3 | h2);
+      break;
+
+    /* rd, [rn, rm] */
+    case STR_RGM_RGN_RGD:   case STRH_RGM_RGN_RGD:  case STRB_RGM_RGN_RGD:
+    case LDRSB_RGM_RGN_RGD: case LDR_RGM_RGN_RGD:   case LDRH_RGM_RGN_RGD:
+    case LDRB_RGM_RGN_RGD:  case LDRSH_RGM_RGN_RGD:
+      out = disasm_base(disasm_op(out, m, lo3), mid3);
+      out = disasm_str(out, disasm_regs[hi3]);
+      *out++ = ']';
+      break;
+
+    /* rd, [rn, #bytes] */
+    case STR_IM5_RGN_RGD:  case LDR_IM5_RGN_RGD:
+    case STRH_IM5_RGN_RGD: case LDRH_IM5_RGN_RGD:
+    case STRB_IM5_RGN_RGD: case LDRB_IM5_RGN_RGD:
+      out = disasm_base(disasm_op(out, m, lo3), mid3);
+      *out++ = '#';
+      out = disasm_dec(out, imm5 * (m[3] == 'H' ? 2 : m[3] == 'B' ? 1 : 4));
+      *out++ = ']';
+      break;
+
+    /* rd, [sp|pc, #bytes] */
+    case LDRPC_RGD_IM8:
+    case LDRSP_RGD_IM8:
+    case STRSP_RGD_IM8:
+      out = disasm_base(disasm_op(out, m, top3),
+          code == LDRPC_RGD_IM8 ? 15 : 13);
+      *out++ = '#';
+      out = disasm_dec(out, imm8 * 4);
+      *out++ = ']';
+      break;
+
+    case ADDPC_RGD_IM8:
+    case ADDSP_RGD_IM8:
+      out = disasm_reg(disasm_op(out, m, top3),
+          code == ADDPC_RGD_IM8 ? 15 : 13);
+      out = disasm_imm(out, imm8 * 4);
+      break;
+
+    case SUB_C11_IM7:
+      out = disasm_imm(disasm_op(out, m, 13), (binary & 0x7F) * 4);
+      break;
+
+    /* register lists, which an assembler won't take empty */
+    case PUSH_HF1_IM8:
+    case POP_HF1_IM8:
+      if (! (binary & 0x1FF))
+      {
+        out = disasm_hword(out, binary, code == PUSH_HF1_IM8 ? "PUSH {}"
+            : "POP {}");
+        break;
+      }
+      out = disasm_str(out, m);
+      *out++ = ' ';
+      out = disasm_list(out, imm8 | (binary & 0x100
+            ? 1u << (code == PUSH_HF1_IM8 ? 14 : 15) : 0));
+      break;
+
+    case STMIA_RGN_IM8:
+    case LDMIA_RGN_RL8:
+      if (! imm8)
+      {
+        out = disasm_hword(out, binary, code == STMIA_RGN_IM8 ? "STMIA {}"
+            : "LDMIA {}");
+        break;
+      }
+      out = disasm_op(out, m, top3);
+      *out++ = '!';
+      *out++ = ',';
+      *out++ = ' ';
+      out = disasm_list(out, imm8);
+      break;
+
+    case BKPT_IM8:
+    case SWI_IM8:
+      out = disasm_str(out, m);
+      *out++ = ' ';
+      *out++ = '#';
+      out = disasm_dec(out, imm8);
+      break;
+
+    case BCOND_IM8:
+      out = disasm_str(out, disasm_conds[(binary >> 8) & 15]);
+      *out++ = ' ';
+      out = disasm_rel(out, 4 + 2 * (((int) imm8 ^ 0x80) - 0x80));
+      break;
+
+    case B_IM8:
+      out = disasm_rel(disasm_str(out, "B "),
+          4 + 2 * (((int) (binary & 0x7FF) ^ 0x400) - 0x400));
+      break;
+
+    /* the high half carries the whole pair */
+    case BLXH_IM8:
+      if (! disasm_paired(binary, next))
+      {
+        out = disasm_hword(out, binary, "high half of BL or BLX, alone");
+        break;
+      }
+      out = disasm_str(out, decode_opcode(next) == BL_IM8 ? "BL " : "BLX ");
+      out = disasm_rel(out, 4 + 2 * disasm_pair(binary, next));
+      break;
+
+    case BL_IM8:
+    case BLX_IM8:
+      if (disasm_paired(prev, binary))
+      {
+        out = disasm_str(out, code == BL_IM8 ? "@ low half of the BL"
+            : "@ low half of the BLX");
+        break;
+      }
+      out = disasm_hword(out, binary, code == BL_IM8 ? "low half of BL, alone"
+          : "low half of BLX, alone");
+      break;
+
+    default:
+      out = disasm_hword(out, binary, "unused");
+      break;
+  }
+
+  *out = '\0';
+
+  return (size_t) (out - start);
+}
+
+/* through the table, built the first time */
+size_t disasm_cached(unsigned binary, unsigned prev, unsigned next,
+    char *out)
+{
+  unsigned entry, length;
+  unsigned short index;
+
+  if (! disasm_built)
+  {
+    disasm_prepare();
+  }
+  binary &= 0xFFFF;
+  entry = disasm_lengths[binary];
+
+  /* half of a pair after all, as disasm_paired has it from the table */
+  if (
+         (entry & DISASM_HIGH_HALF && next < DISASM_NONE
+          && disasm_lengths[next] & DISASM_LOW_HALF)
+      || (entry & DISASM_LOW_HALF && prev < DISASM_NONE
+          && disasm_lengths[prev] & DISASM_HIGH_HALF)
+      )
+  {
+    return disasm_text(binary, prev, next, out);
+  }
+
+  /* a whole slot, less work than the exact length */
+  length = entry & DISASM_LENGTH;
+  if (length < DISASM_SLOT)
+  {
+    memcpy(out, disasm_slots[binary], DISASM_SLOT);
+    return length;
+  }
+  memcpy(&index, disasm_slots[binary], sizeof(index));
+  memcpy(out, disasm_long[index], DISASM_TEXT_MAX);
+
+  return length;
+}
+
+/* the table, every halfword on its own */
+void disasm_prepare(void)
+{
+  char text[DISASM_TEXT_MAX];
+  unsigned binary, entry;
+  unsigned short used = 0;
+  size_t length;
+  ThumbISA code;
+
+  for (binary = 0; binary < 0x10000; binary++)
+  {
+    code = decode_opcode(binary);
+    length = disasm_text(binary, DISASM_NONE, DISASM_NONE, text);
+    entry = (unsigned) length;
+    if (code == BLXH_IM8)
+    {
+      entry |= DISASM_HIGH_HALF;
+    }
+    else if (code == BL_IM8 || code == BLX_IM8)
+    {
+      entry |= DISASM_LOW_HALF;
+    }
+    disasm_lengths[binary] = (unsigned char) entry;
+
+    if (length < DISASM_SLOT)
+    {
+      memcpy(disasm_slots[binary], text, length + 1);
+      continue;
+    }
+
+    /* .hword with a long comment, mostly the halves of BL and BLX */
+    memcpy(disasm_long[used], text, length + 1);
+    memcpy(disasm_slots[binary], &used, sizeof(used));
+    used++;
+  }
+  disasm_built = 1;
+}
+
+/* where it goes */
+DisasmBranch disasm_branch(unsigned binary, unsigned prev, unsigned next,
+    int *offset)
+{
+  switch (decode_opcode(binary))
+  {
+    case BCOND_IM8:
+      *offset = 4 + 2 * (((int) (binary & 0xFF) ^ 0x80) - 0x80);
+      return DISASM_BRANCH_OFFSET;
+
+    case B_IM8:
+      *offset = 4 + 2 * (((int) (binary & 0x7FF) ^ 0x400) - 0x400);
+      return DISASM_BRANCH_OFFSET;
+
+    case BX_HF1_RGM_C30:
+    case BLX_HF1_RGM_C30:
+      return DISASM_BRANCH_REGISTER;
+
+    case BLXH_IM8:
+      if (! disasm_paired(binary, next))
+      {
+        return DISASM_BRANCH_NONE;
+      }
+      *offset = 4 + 2 * disasm_pair(binary, next);
+      return DISASM_BRANCH_OFFSET;
+
+    case BL_IM8:
+    case BLX_IM8:
+      if (! disasm_paired(prev, binary))
+      {
+        return DISASM_BRANCH_NONE;
+      }
+      *offset = 2 + 2 * disasm_pair(prev, binary);
+      return DISASM_BRANCH_OFFSET;
+
+    default:
+      return DISASM_BRANCH_NONE;
+  }
+}
+
+/* the ThumbISA identifier */
+const char * disasm_name(ThumbISA code)
+{
+#define DISASM_NAME(CODE) case CODE: return #CODE;
+  switch (code)
+  {
+    DISASM_NAME(ADC_RGM_RGD)       DISASM_NAME(ADD_HF2_RGM_RGD)
+    DISASM_NAME(ADD_IM3_RGN_RGD)   DISASM_NAME(ADD_RGD_IM8)
+    DISASM_NAME(ADD_RGM_RGN_RGD)   DISASM_NAME(ADDPC_RGD_IM8)
+    DISASM_NAME(ADDSP_RGD_IM8)     DISASM_NAME(AND_RGM_RGD)
+    DISASM_NAME(ASR_IM5_RGM_RGD)   DISASM_NAME(ASR_RGS_RGD)
+    DISASM_NAME(B_IM8)             DISASM_NAME(BCOND_IM8)
+    DISASM_NAME(BIC_RGN_RGM)       DISASM_NAME(BKPT_IM8)
+    DISASM_NAME(BL_IM8)            DISASM_NAME(BLX_HF1_RGM_C30)
+    DISASM_NAME(BLX_IM8)           DISASM_NAME(BLXH_IM8)
+    DISASM_NAME(BX_HF1_RGM_C30)    DISASM_NAME(CMN_RGN_RGM)
+    DISASM_NAME(CMP_HF2_RGN_RGM)   DISASM_NAME(CMP_RGN_IM8)
+    DISASM_NAME(CMP_RGN_RGM)       DISASM_NAME(EOR_RGM_RGD)
+    DISASM_NAME(LDMIA_RGN_RL8)     DISASM_NAME(LDR_IM5_RGN_RGD)
+    DISASM_NAME(LDR_RGM_RGN_RGD)   DISASM_NAME(LDRB_IM5_RGN_RGD)
+    DISASM_NAME(LDRB_RGM_RGN_RGD)  DISASM_NAME(LDRH_IM5_RGN_RGD)
+    DISASM_NAME(LDRH_RGM_RGN_RGD)  DISASM_NAME(LDRPC_RGD_IM8)
+    DISASM_NAME(LDRSB_RGM_RGN_RGD) DISASM_NAME(LDRSH_RGM_RGN_RGD)
+    DISASM_NAME(LDRSP_RGD_IM8)     DISASM_NAME(LSL_IM5_RGM_RGD)
+    DISASM_NAME(LSL_RGS_RGD)       DISASM_NAME(LSR_IM5_RGM_RGD)
+    DISASM_NAME(LSR_RGS_RGD)       DISASM_NAME(MOV_HF2_RGM_RGD)
+    DISASM_NAME(MOV_RGD_IM8)       DISASM_NAME(MUL_RGM_RGD)
+    DISASM_NAME(MVN_RGM_RGD)       DISASM_NAME(NEG_RGM_RGD)
+    DISASM_NAME(ORR_RGM_RGD)       DISASM_NAME(POP_HF1_IM8)
+    DISASM_NAME(PUSH_HF1_IM8)      DISASM_NAME(ROR_RGS_RGD)
+    DISASM_NAME(SBC_RGM_RGD)       DISASM_NAME(STMIA_RGN_IM8)
+    DISASM_NAME(STR_IM5_RGN_RGD)   DISASM_NAME(STR_RGM_RGN_RGD)
+    DISASM_NAME(STRB_IM5_RGN_RGD)  DISASM_NAME(STRB_RGM_RGN_RGD)
+    DISASM_NAME(STRH_IM5_RGN_RGD)  DISASM_NAME(STRH_RGM_RGN_RGD)
+    DISASM_NAME(STRSP_RGD_IM8)     DISASM_NAME(SUB_C11_IM7)
+    DISASM_NAME(SUB_IM3_RGN_RGD)   DISASM_NAME(SUB_RGM_IM8)
+    DISASM_NAME(SUB_RGM_RGN_RGD)   DISASM_NAME(SWI_IM8)
+    DISASM_NAME(TST_RGN_RGM)
+    default: return "UNUSED_IM8";
+  }
+#undef DISASM_NAME
+}
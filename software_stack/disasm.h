@@ -0,0 +1,83 @@
+#ifndef __SOFT_STACK_DISASM
+#define __SOFT_STACK_DISASM
+
+#include "main.h"
+#include "isa.h"
+
+/** Stands in for the halfword before the first or after the last */
+#define DISASM_NONE 0x10000
+
+/** Longest text disasm_text writes, with its NUL */
+#define DISASM_TEXT_MAX 48
+
+/** What disasm_branch says a halfword does to the PC */
+typedef enum _DisasmBranch
+{
+  DISASM_BRANCH_NONE = 0,
+
+  /** to a fixed offset from the halfword's own address */
+  DISASM_BRANCH_OFFSET,
+
+  /** to a register, BX and BLX */
+  DISASM_BRANCH_REGISTER
+} DisasmBranch;
+
+/**
+ * Write a halfword out as thumb_asm.hpp reads it, so a program can be
+ *  disassembled and assembled back to the same bytes. Branches go to
+ *  . plus or minus a byte offset. The high half of a BL or BLX pair is
+ *  the whole instruction, its low half a comment. Halfwords with no
+ *  instruction of their own, or whose operands an assembler would spell
+ *  another way, come out as .hword with what they are in a comment.
+ *
+ * @param binary the halfword
+ * @param prev the halfword before it, or DISASM_NONE
+ * @param next the halfword after it, or DISASM_NONE
+ * @param out at least DISASM_TEXT_MAX chars
+ * @return the length written, less the NUL
+ */
+size_t disasm_text(unsigned binary, unsigned prev, unsigned next, char *out);
+
+/**
+ * disasm_text, through a table of every halfword's text built on first
+ *  use, copying a fixed size slot rather than formatting. Only the halves
+ *  of an actual BL or BLX pair are formatted.
+ *
+ * @param binary the halfword
+ * @param prev the halfword before it, or DISASM_NONE
+ * @param next the halfword after it, or DISASM_NONE
+ * @param out at least DISASM_TEXT_MAX chars
+ * @return the length written, not always followed by a NUL
+ */
+size_t disasm_cached(unsigned binary, unsigned prev, unsigned next,
+    char *out);
+
+/**
+ * Build disasm_cached's table now, such as before forking workers so
+ *  they share it rather than each building their own
+ */
+void disasm_prepare(void);
+
+/**
+ * Where a halfword branches
+ *
+ * @param binary the halfword
+ * @param prev the halfword before it, or DISASM_NONE
+ * @param next the halfword after it, or DISASM_NONE
+ * @param offset set to the target's byte offset from binary's address,
+ *  for DISASM_BRANCH_OFFSET
+ * @return what the halfword does to the PC, both halves of a BL or BLX
+ *  pair branching to its target
+ */
+DisasmBranch disasm_branch(unsigned binary, unsigned prev, unsigned next,
+    int *offset);
+
+/**
+ * Name of a ThumbISA code
+ *
+ * @param code the code
+ * @return its identifier, such as "MUL_RGM_RGD"
+ */
+const char * disasm_name(ThumbISA code);
+
+#endif /* __SOFT_STACK_DISASM */
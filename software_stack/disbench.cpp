@@ -0,0 +1,158 @@
+/*
+ * Checks disasm.c against thumb_asm.hpp and measures how fast it formats.
+ *
+ * Every one of the 65536 halfwords, and every BL and BLX pair of -s
+ *  sampled low halves per high half, is disassembled and assembled back,
+ *  which has to give the same bytes, and disasm_cached has to give the
+ *  same text as disasm_text. Then -n random halfwords are formatted -p
+ *  times on a single core, both ways.
+ *
+ * usage: disbench [-n halfwords] [-p passes] [-s low halves per high half]
+ *
+ * build: cc -O2 -c stack.c decode.c disasm.c
+ *        c++ -O2 -std=c++17 -I . -o disbench disbench.cpp stack.o decode.o
+ *         disasm.o
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "bench.h"
+#include "thumb_asm.hpp"
+
+extern "C"
+{
+#include "disasm.h"
+}
+
+/* disassemble, assemble back, 1 if the bytes differ */
+static int disbench_trip(unsigned high, unsigned low)
+{
+  char text[2 * DISASM_TEXT_MAX + 1];
+  size_t n;
+  unsigned halfwords = low == DISASM_NONE ? 1 : 2;
+
+  n = disasm_text(high, DISASM_NONE, low, text);
+  if (low != DISASM_NONE)
+  {
+    text[n++] = '\n';
+    disasm_text(low, high, DISASM_NONE, text + n);
+  }
+
+  try
+  {
+    const thumb::Image<2> image = thumb::assemble<2>(text);
+
+    if (
+           thumb::halfwords(text) != halfwords
+        || image.instrs[0].binary != high
+        || (halfwords == 2 && image.instrs[1].binary != low)
+        )
+    {
+      printf("  %04X %04X: %s\n", high, low & 0xFFFF, text);
+      return 1;
+    }
+  }
+  catch (const thumb::AsmError &error)
+  {
+    printf("  %04X %04X: %s: %s\n", high, low & 0xFFFF, text, error.what());
+    return 1;
+  }
+  return 0;
+}
+
+int main(int argc, char **argv)
+{
+  unsigned long halfwords = 1 << 20, passes = 16, samples = 16, pass, i,
+                wrong = 0, trips = 0, differ = 0;
+  unsigned binary, *image, low;
+  unsigned long long chars = 0;
+  char text[DISASM_TEXT_MAX], cached[DISASM_TEXT_MAX];
+  double started, seconds[2];
+  size_t n;
+  int a;
+
+  /* options */
+  for (a = 1; a + 1 < argc && argv[a][0] == '-'; a += 2)
+  {
+    switch (argv[a][1])
+    {
+      case 'n': halfwords = strtoul(argv[a + 1], NULL, 0);  break;
+      case 'p': passes    = strtoul(argv[a + 1], NULL, 0);  break;
+      case 's': samples   = strtoul(argv[a + 1], NULL, 0);  break;
+      default:  a = argc;                                   break;
+    }
+  }
+  if (a != argc || ! halfwords || ! passes)
+  {
+    fprintf(stderr, "usage: %s [-n halfwords] [-p passes] "
+        "[-s low halves per high half]\n", argv[0]);
+    return 1;
+  }
+
+  /* every halfword alone, then pairs */
+  for (binary = 0; binary < 0x10000; binary++, trips++)
+  {
+    wrong += disbench_trip(binary, DISASM_NONE);
+  }
+  for (binary = 0xF000; binary < 0xF800; binary++)
+  {
+    for (i = 0; i < samples; i++, trips++)
+    {
+      low = 0xE800 | (bench_random() & 0x17FF);
+      wrong += disbench_trip(binary, low);
+    }
+  }
+
+  /* the table, each high half of a pair followed by a BL */
+  for (binary = 0; binary < 0x10000; binary++)
+  {
+    low = binary >= 0xF000 && binary < 0xF800 ? 0xF800 : DISASM_NONE;
+    n = disasm_text(binary, DISASM_NONE, low, text);
+    differ += disasm_cached(binary, DISASM_NONE, low, cached) != n
+      || memcmp(text, cached, n);
+  }
+
+  if (! (image = (unsigned *) malloc(halfwords * sizeof(unsigned))))
+  {
+    fprintf(stderr, "out of memory\n");
+    return 1;
+  }
+  for (i = 0; i < halfwords; i++)
+  {
+    image[i] = bench_random() & 0xFFFF;
+  }
+
+  started = bench_now();
+  for (pass = 0; pass < passes; pass++)
+  {
+    for (i = 0; i < halfwords; i++)
+    {
+      chars += disasm_text(image[i], i ? image[i - 1] : DISASM_NONE,
+          i + 1 < halfwords ? image[i + 1] : DISASM_NONE, text);
+    }
+  }
+  seconds[0] = bench_now() - started;
+
+  disasm_prepare();
+  started = bench_now();
+  for (pass = 0; pass < passes; pass++)
+  {
+    for (i = 0; i < halfwords; i++)
+    {
+      chars += disasm_cached(image[i], i ? image[i - 1] : DISASM_NONE,
+          i + 1 < halfwords ? image[i + 1] : DISASM_NONE, text);
+    }
+  }
+  seconds[1] = bench_now() - started;
+
+  printf("round trips       %lu, %lu wrong\n", trips, wrong);
+  printf("disasm_cached     %lu of 65536 halfwords differ, %.1f chars "
+      "a halfword\n", differ, (double) chars / halfwords / passes / 2);
+  printf("M halfwords/s     %.1f disasm_text, %.1f disasm_cached, one "
+      "core\n", halfwords * passes / seconds[0] / 1e6,
+      halfwords * passes / seconds[1] / 1e6);
+
+  free(image);
+
+  return wrong || differ;
+}
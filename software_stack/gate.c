@@ -0,0 +1,295 @@
+#include "gate.h"
+
+/* method forward decls */
+u32 GateModel_read(Device *device, u32 offset);
+void GateModel_write(Device *device, u32 offset, u32 data);
+GateModel * GateModel_setKey(GateModel *self, u32 key);
+u32 GateModel_check(GateModel *self, AxiTxn *txn);
+unsigned GateModel_irq(GateModel *self);
+GateModel * GateModel_reset(GateModel *self);
+GateModel * GateModel_free(GateModel *self);
+
+/* permissions granted by writing table register 'reg', a 32->5 encoding */
+static u32 GateModel_decode(unsigned reg)
+{
+  u32 perms = 0;
+
+  if (reg & 0x10)
+  {
+    perms |= GATE_PERM_CRIT;
+  }
+  if (reg & 0x08)
+  {
+    perms |= GATE_PERM_IO_I | GATE_PERM_IO_O | GATE_PERM_IO_T;
+  }
+  if (reg & 0x04)
+  {
+    perms |= GATE_PERM_MEM_R | GATE_PERM_MEM_W;
+  }
+  if (reg & 0x02)
+  {
+    perms |= GATE_PERM_AWUSER | GATE_PERM_ARUSER | GATE_PERM_WUSER
+      | GATE_PERM_RUSER | GATE_PERM_BUSER;
+  }
+  if (reg & 0x01)
+  {
+    perms |= GATE_PERM_IRQ;
+  }
+
+  return perms;
+}
+
+/* redo the key lookup, the highest matching entry wins as in USE_KEY_PROC */
+static void GateModel_lookup(GateModel *self)
+{
+  int i;
+
+  self->key_found = 0;
+  self->key_perms = 0;
+  for (i = GATE_NUM_KEYS - 1; i >= 0; i--)
+  {
+    if (self->keys[i] == self->key_in)
+    {
+      self->key_found = 1;
+      self->key_perms = self->perms[i];
+      break;
+    }
+  }
+  self->stale = 0;
+}
+
+/* queue a denial, dropping it if the FIFO is full */
+static void GateModel_deny(GateModel *self, u32 info, u32 addr)
+{
+  GateDenial *slot;
+
+  self->denials++;
+  if (self->deny_count == GATE_DENY_DEPTH)
+  {
+    self->deny_overflow = 1;
+    return;
+  }
+
+  slot = &self->deny[(self->deny_head + self->deny_count) % GATE_DENY_DEPTH];
+  slot->time = self->time;
+  slot->key  = self->key_in;
+  slot->info = info;
+  slot->addr = addr;
+  self->deny_count++;
+}
+
+/* constructor */
+GateModel * newGateModel(u32 base)
+{
+  GateModel *self = (GateModel *) malloc(sizeof(GateModel));
+
+  /* out of memory */
+  if (! self)
+  {
+    return NULL;
+  }
+
+  /* zero */
+  memset(self, 0, sizeof(GateModel));
+
+  /* bind methods */
+  self->device.base  = base;
+  self->device.size  = GATE_SIZE;
+  self->device.read  = GateModel_read;
+  self->device.write = GateModel_write;
+  self->setKey       = GateModel_setKey;
+  self->check        = GateModel_check;
+  self->irq          = GateModel_irq;
+  self->reset        = GateModel_reset;
+  self->free         = GateModel_free;
+
+  /* the address range is already taken */
+  if (hal_attach(&self->device))
+  {
+    free(self);
+    return NULL;
+  }
+
+  self->stale = 1;
+  return self;
+}
+
+/* read a key (sealing the table), or a denied access register */
+u32 GateModel_read(Device *device, u32 offset)
+{
+  GateModel *self = (GateModel *) device;
+  GateDenial *oldest = &self->deny[self->deny_head];
+  unsigned reg = offset / 4;
+
+  /* access control table, any read seals it */
+  if (offset < GATE_SOFT_RST_OFFSET)
+  {
+    self->loaded = GATE_NUM_KEYS;
+    return reg < GATE_NUM_KEYS ? self->keys[reg] : 0;
+  }
+
+  /* nothing readable in the soft reset space */
+  if (offset < GATE_DENY_OFFSET)
+  {
+    return 0;
+  }
+
+  switch ((offset - GATE_DENY_OFFSET) / 4)
+  {
+    case GATE_DENY_STATUS:
+      return (self->deny_count << 16) | (self->deny_overflow << 1)
+        | self->irq(self);
+
+    case GATE_DENY_CTRL:
+      return self->deny_watermark;
+
+    case GATE_DENY_TIME:
+      return self->deny_count ? oldest->time : 0;
+
+    case GATE_DENY_KEY:
+      return self->deny_count ? oldest->key : 0;
+
+    case GATE_DENY_INFO:
+      return self->deny_count ? oldest->info : 0;
+
+    /* reading ADDR finishes with the oldest event */
+    case GATE_DENY_ADDR:
+      if (self->deny_count)
+      {
+        self->deny_head = (self->deny_head + 1) % GATE_DENY_DEPTH;
+        self->deny_count--;
+        return oldest->addr;
+      }
+      return 0;
+
+    default:
+      return 0;
+  }
+}
+
+/* load a key, soft reset, or control the denied access FIFO */
+void GateModel_write(Device *device, u32 offset, u32 data)
+{
+  GateModel *self = (GateModel *) device;
+  unsigned reg = offset / 4;
+
+  /* access control table, the register number picks the permissions */
+  if (offset < GATE_SOFT_RST_OFFSET)
+  {
+    if (reg < GATE_NUM_KEYS && self->loaded < GATE_NUM_KEYS)
+    {
+      self->keys[self->loaded]  = data;
+      self->perms[self->loaded] = GateModel_decode(reg);
+      self->loaded++;
+      self->stale = 1;
+    }
+    return;
+  }
+
+  /* soft reset */
+  if (offset < GATE_DENY_OFFSET)
+  {
+    if (data == GATE_SOFT_RESET)
+    {
+      self->reset(self);
+    }
+    return;
+  }
+
+  if ((offset - GATE_DENY_OFFSET) / 4 == GATE_DENY_CTRL)
+  {
+    self->deny_watermark = data & 0xFFFF;
+    if (data & GATE_DENY_CLEAR)
+    {
+      self->deny_head = self->deny_count = 0;
+      self->deny_overflow = 0;
+    }
+  }
+}
+
+/* drive KEY_IN */
+GateModel * GateModel_setKey(GateModel *self, u32 key)
+{
+  if (key != self->key_in)
+  {
+    self->key_in = key;
+    self->stale  = 1;
+  }
+
+  return self;
+}
+
+/* gate an address phase */
+u32 GateModel_check(GateModel *self, AxiTxn *txn)
+{
+  u32 denied = 0;
+
+  if (self->stale)
+  {
+    GateModel_lookup(self);
+  }
+  self->checks++;
+
+  /* unknown keys are shut off entirely */
+  if (! self->key_found)
+  {
+    denied = GATE_DENY_NO_KEY;
+  }
+  else if (txn->prot != GATE_SAFE_PROT && ! (self->key_perms & GATE_PERM_CRIT))
+  {
+    denied = GATE_PERM_CRIT;
+  }
+
+  /* rewrite the side band signals */
+  if (! (self->key_perms & GATE_PERM_CRIT))
+  {
+    txn->prot = GATE_SAFE_PROT;
+  }
+  if (
+         ! (self->key_perms
+              & (txn->write ? GATE_PERM_AWUSER : GATE_PERM_ARUSER))
+      )
+  {
+    txn->user = 0;
+  }
+
+  if (denied)
+  {
+    GateModel_deny(self, denied | (txn->write ? GATE_DENY_WRITE : 0),
+        txn->addr);
+  }
+
+  return denied;
+}
+
+/* denied access interrupt level */
+unsigned GateModel_irq(GateModel *self)
+{
+  return self->deny_watermark && self->deny_count >= self->deny_watermark;
+}
+
+/* empty the table and the FIFO */
+GateModel * GateModel_reset(GateModel *self)
+{
+  memset(self->keys, 0, sizeof(self->keys));
+  memset(self->perms, 0, sizeof(self->perms));
+  self->loaded = 0;
+  self->deny_head = self->deny_count = 0;
+  self->deny_overflow = 0;
+  self->deny_watermark = 0;
+  self->stale = 1;
+
+  return self;
+}
+
+/* destructor */
+GateModel * GateModel_free(GateModel *self)
+{
+  if (self)
+  {
+    hal_detach(&self->device);
+    free(self);
+  }
+
+  return NULL;
+}
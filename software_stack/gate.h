@@ -0,0 +1,174 @@
+#ifndef __SOFT_STACK_GATE
+#define __SOFT_STACK_GATE
+
+#include "hal.h"
+
+/** Number of keys in the access control table, C_NUM_REG in the mpd */
+#define GATE_NUM_KEYS 32
+
+/** Bytes decoded by a trusted_gate: keys, soft reset, then denials */
+#define GATE_SIZE 0x400
+
+/** Soft reset space, and the value which triggers a reset */
+#define GATE_SOFT_RST_OFFSET 0x100
+#define GATE_SOFT_RESET      0x0000000A
+
+/** Denied access FIFO space, and its depth, C_DENY_FIFO_DEPTH in the mpd */
+#define GATE_DENY_OFFSET 0x200
+#define GATE_DENY_DEPTH  64
+
+/** AxPROT a key without GATE_PERM_CRIT is forced to */
+#define GATE_SAFE_PROT 0x2
+
+/** Permission bits, must match C_PERM_* in trusted_gate's user_logic.vhd */
+typedef enum _GatePerm
+{
+  GATE_PERM_IRQ    = 0x00000001,
+  GATE_PERM_BUSER  = 0x00000002,
+  GATE_PERM_RUSER  = 0x00000004,
+  GATE_PERM_WUSER  = 0x00000008,
+  GATE_PERM_ARUSER = 0x00000010,
+  GATE_PERM_AWUSER = 0x00000020,
+  GATE_PERM_MEM_W  = 0x00000040,
+  GATE_PERM_MEM_R  = 0x00000080,
+  GATE_PERM_IO_T   = 0x00000100,
+  GATE_PERM_IO_O   = 0x00000200,
+  GATE_PERM_IO_I   = 0x00000400,
+  GATE_PERM_CRIT   = 0x00000800,
+  GATE_DENY_NO_KEY = 0x00001000,
+  GATE_DENY_WRITE  = 0x00010000
+} GatePerm;
+
+/** Denied access FIFO registers, must match deny_fifo.vhd */
+typedef enum _GateDenyReg
+{
+  GATE_DENY_TIME = 0,
+  GATE_DENY_KEY,
+  GATE_DENY_INFO,
+  GATE_DENY_ADDR,
+  GATE_DENY_STATUS,
+  GATE_DENY_CTRL
+} GateDenyReg;
+
+/** Writing this CTRL bit empties the denied access FIFO */
+#define GATE_DENY_CLEAR 0x80000000
+
+/**
+ * A single AXI transaction, as seen on the slave side of the connector
+ */
+typedef struct _AxiTxn
+{
+  /** clock the master first raises AxVALID */
+  u32 cycle;
+
+  /** non-zero for AW/W/B, zero for AR/R */
+  unsigned write;
+
+  /** AxADDR */
+  u32 addr;
+
+  /** number of data beats, AxLEN + 1 */
+  unsigned beats;
+
+  /** AxPROT and AxUSER, rewritten in place by the gate */
+  unsigned prot;
+  u32 user;
+
+} AxiTxn;
+
+/** A denied access, as queued by deny_fifo.vhd */
+typedef struct _GateDenial
+{
+  u32 time;
+  u32 key;
+  u32 info;
+  u32 addr;
+} GateDenial;
+
+/**
+ * A GateModel models trusted_gate: the sealed table of keys and
+ *  permissions software loads through its registers, the AxPROT/AxUSER
+ *  rewriting done for whichever key trusted_key drives onto KEY_IN, and
+ *  the denied access FIFO.
+ */
+typedef struct _GateModel
+{
+  /** bus model view of this GateModel, must stay the first member */
+  Device device;
+
+  /** access control table, and the number of entries loaded */
+  u32 keys[GATE_NUM_KEYS];
+  u32 perms[GATE_NUM_KEYS];
+  unsigned loaded;
+
+  /** KEY_IN, as driven by trusted_key */
+  u32 key_in;
+
+  /** lookup result for key_in, redone whenever the key or table change */
+  unsigned key_found;
+  u32 key_perms;
+  unsigned stale;
+
+  /** clock count, stamped on denials */
+  u32 time;
+
+  /** denied access FIFO */
+  GateDenial deny[GATE_DENY_DEPTH];
+  unsigned deny_head;
+  unsigned deny_count;
+  unsigned deny_overflow;
+  unsigned deny_watermark;
+
+  /** transactions checked, and how many were denied something */
+  unsigned long checks;
+  unsigned long denials;
+
+  /**
+   * Drive KEY_IN, as trusted_key does
+   *
+   * @param key the new key
+   * @return this GateModel
+   */
+  struct _GateModel * (*setKey)(struct _GateModel *self, u32 key);
+
+  /**
+   * Pass a transaction's address phase through the gate, rewriting its
+   *  AxPROT and AxUSER, and queueing a denial if it is refused anything
+   *
+   * @param txn transaction to gate
+   * @return the denied GatePerm bits, 0 if nothing was refused
+   */
+  u32 (*check)(struct _GateModel *self, AxiTxn *txn);
+
+  /**
+   * Level of the denied access interrupt
+   *
+   * @return non-zero while at least the watermark number of events wait
+   */
+  unsigned (*irq)(struct _GateModel *self);
+
+  /**
+   * Empty the table and the denied access FIFO, as the soft reset does
+   *
+   * @return this GateModel
+   */
+  struct _GateModel * (*reset)(struct _GateModel *self);
+
+  /**
+   * Destructor, detaches this GateModel from the bus model
+   *
+   * @return NULL
+   */
+  struct _GateModel * (*free)(struct _GateModel *self);
+
+} GateModel;
+
+/**
+ * Constructor, attaches the new GateModel to the bus model
+ *
+ * @param base base address, XPAR_TRUSTED_GATE_0_BASEADDR on the ZedBoard
+ * @return a new GateModel, or NULL if out of memory or base is taken
+ */
+GateModel * newGateModel(u32 base);
+
+#endif /* __SOFT_STACK_GATE */
@@ -0,0 +1,306 @@
+/*
+ * Looks for permission escalation on trusted_gate and trusted_key. After
+ *  a boot like chase_led's, scaled down to 4 keys: MEM_R for keys 0 and
+ *  1, the gate sealed, then IO_O asked for keys 2 and 3 too late, and key
+ *  1 in use, every sequence of -l steps software can take is run: table
+ *  loads, key register loads, key selections, seals and soft resets. Any
+ *  configuration which leaves KEY_OUT on a key with permission -p that
+ *  the boot did not give it is an escalation, and the shortest ones are
+ *  printed as witnesses, each replayed on the GateModel and KeyModel.
+ *
+ * Configurations are bit-sliced GATESLICE_LANES to a word. Workers are
+ *  forked across cores, each taking every j'th batch of them, and -v
+ *  random configurations are cross-checked against the models.
+ *
+ * usage: gateexplore [-l steps] [-j workers] [-p GatePerm mask]
+ *                    [-v samples] [-w witnesses]
+ *
+ * build: cc -O2 -march=native -o gateexplore gateexplore.c gateslice.c
+ *         gate.c key.c hal.c sim.c
+ */
+#include "bench.h"
+#include "gateslice.h"
+#include "xparameters.h"
+
+/* most witnesses kept by a worker */
+#define GATEEXPLORE_MAX_WITNESSES 64
+
+/* a configuration and the step it first escalates at */
+typedef struct _GateExploreWitness
+{
+  unsigned long long config;
+  unsigned step;
+} GateExploreWitness;
+
+/* what a worker found */
+typedef struct _GateExploreStats
+{
+  unsigned long long configurations;
+  unsigned long long by_step[GATESLICE_MAX_STEPS];
+  GateExploreWitness witnesses[GATEEXPLORE_MAX_WITNESSES];
+  unsigned num_witnesses;
+} GateExploreStats;
+
+/* what the workers share, and what the parent gathers */
+typedef struct _GateExploreJob
+{
+  GateSlicer *slicer;
+  unsigned keep;
+  GateExploreStats total;
+  GateExploreWitness *witnesses;
+  unsigned num_witnesses;
+} GateExploreJob;
+
+/* the step a configuration first escalates at in its batch, 0 if none */
+static unsigned gateexplore_step(const GateSliceWord *bad, unsigned steps,
+    unsigned lane)
+{
+  unsigned p;
+
+  for (p = 0; p < steps; p++)
+  {
+    if ((bad[p][lane / 64] >> (lane % 64)) & 1)
+    {
+      return p + 1;
+    }
+  }
+
+  return 0;
+}
+
+/* where to keep a witness, a longer one it replaces, NULL if none */
+static GateExploreWitness * gateexplore_slot(GateExploreStats *stats,
+    unsigned keep, unsigned step)
+{
+  GateExploreWitness *longest = NULL;
+  unsigned i;
+
+  if (stats->num_witnesses < keep)
+  {
+    return &stats->witnesses[stats->num_witnesses++];
+  }
+  for (i = 0; i < stats->num_witnesses; i++)
+  {
+    if (stats->witnesses[i].step > (longest ? longest->step : step))
+    {
+      longest = &stats->witnesses[i];
+    }
+  }
+
+  return longest;
+}
+
+/* every j'th batch */
+static void gateexplore_work(unsigned long w, unsigned long workers,
+    void *report, void *context)
+{
+  GateExploreStats *stats = (GateExploreStats *) report;
+  GateSlicer *slicer = ((GateExploreJob *) context)->slicer;
+  unsigned keep = ((GateExploreJob *) context)->keep;
+  GateSliceWord bad[GATESLICE_MAX_STEPS], quiet[GATESLICE_MAX_STEPS], found;
+  GateExploreWitness *witness;
+  unsigned long long batch, batches, bits;
+  unsigned p, e;
+
+  batches = 1ULL << (8 * slicer->steps - GATESLICE_LANE_BITS);
+  for (batch = w; batch < batches; batch += workers)
+  {
+    stats->configurations += slicer->run(slicer, batch, bad, quiet);
+    for (p = 0; p < slicer->steps; p++)
+    {
+      found = bad[p] & quiet[p];
+      for (e = 0; e < GATESLICE_ELEMENTS; e++)
+      {
+        stats->by_step[p] += __builtin_popcountll(bad[p][e]);
+
+        /* the shortest, everything after the escalation doing nothing */
+        for (bits = found[e]; bits; bits &= bits - 1)
+        {
+          if (! (witness = gateexplore_slot(stats, keep, p + 1)))
+          {
+            break;
+          }
+          witness->config = (batch << GATESLICE_LANE_BITS)
+            | (64 * e + __builtin_ctzll(bits));
+          witness->step = p + 1;
+        }
+      }
+    }
+  }
+}
+
+/* add up a worker's stats, keeping its witnesses */
+static void gateexplore_gather(unsigned long w, const void *report,
+    void *context)
+{
+  const GateExploreStats *stats = (const GateExploreStats *) report;
+  GateExploreJob *job = (GateExploreJob *) context;
+  unsigned p;
+
+  job->total.configurations += stats->configurations;
+  for (p = 0; p < job->slicer->steps; p++)
+  {
+    job->total.by_step[p] += stats->by_step[p];
+  }
+  memcpy(job->witnesses + job->num_witnesses, stats->witnesses,
+      stats->num_witnesses * sizeof(GateExploreWitness));
+  job->num_witnesses += stats->num_witnesses;
+  (void) w;
+}
+
+/* by step, then by configuration */
+static int gateexplore_compare(const void *a, const void *b)
+{
+  const GateExploreWitness *x = a, *y = b;
+
+  if (x->step != y->step)
+  {
+    return x->step < y->step ? -1 : 1;
+  }
+
+  return x->config < y->config ? -1 : x->config > y->config;
+}
+
+int main(int argc, char **argv)
+{
+  static const unsigned char prefix[] =
+  {
+    GATESLICE_ADD(4, 0), GATESLICE_KEYSET(0, 0),
+    GATESLICE_ADD(4, 1), GATESLICE_KEYSET(1, 1),
+    GATESLICE_SEAL,
+    GATESLICE_ADD(8, 2), GATESLICE_KEYSET(2, 2),
+    GATESLICE_ADD(8, 3), GATESLICE_KEYSET(3, 3),
+    GATESLICE_USE(1)
+  };
+  unsigned long workers = sysconf(_SC_NPROCESSORS_ONLN), samples = 10000,
+                i, errors = 0;
+  unsigned steps = 3, keep = 8, p, n, step;
+  unsigned long long config, escalations = 0;
+  u32 perm = GATE_PERM_IO_O;
+  GateSliceWord bad[GATESLICE_MAX_STEPS], quiet[GATESLICE_MAX_STEPS];
+  GateExploreJob job;
+  GateSlicer *slicer;
+  GateModel *gate;
+  KeyModel *key;
+  double seconds;
+  char name[40];
+  int a, failed;
+
+  /* options */
+  for (a = 1; a + 1 < argc && argv[a][0] == '-'; a += 2)
+  {
+    switch (argv[a][1])
+    {
+      case 'l': steps   = strtoul(argv[a + 1], NULL, 0);   break;
+      case 'j': workers = strtoul(argv[a + 1], NULL, 0);   break;
+      case 'p': perm    = strtoul(argv[a + 1], NULL, 16);  break;
+      case 'v': samples = strtoul(argv[a + 1], NULL, 0);   break;
+      case 'w': keep    = strtoul(argv[a + 1], NULL, 0);   break;
+      default:  a = argc;                                  break;
+    }
+  }
+  if (
+         a != argc
+      || steps < 2
+      || steps > GATESLICE_MAX_STEPS
+      || ! workers
+      || ! perm
+      || keep > GATEEXPLORE_MAX_WITNESSES
+      )
+  {
+    fprintf(stderr, "usage: %s [-l steps, 2 to %u] [-j workers] "
+        "[-p GatePerm mask] [-v samples] [-w witnesses <= %u]\n", argv[0],
+        GATESLICE_MAX_STEPS, GATEEXPLORE_MAX_WITNESSES);
+    return 1;
+  }
+
+  if (
+         ! (gate = newGateModel(XPAR_TRUSTED_GATE_0_BASEADDR))
+      || ! (key = newKeyModel(XPAR_TRUSTED_KEY_0_BASEADDR, NULL))
+      || ! (slicer = newGateSlicer(gate, key, perm, prefix, sizeof(prefix),
+          steps))
+      || ! (job.witnesses = (GateExploreWitness *) calloc(workers * keep + 1,
+          sizeof(GateExploreWitness)))
+      )
+  {
+    fprintf(stderr, "out of memory\n");
+    return 1;
+  }
+  printf("permission        0x%03X, from register number bits 0x%02X, "
+      "keys 0x%X meant to have it\n", perm, slicer->reg_mask,
+      slicer->intended);
+
+  /* each worker reports back what it found */
+  memset(&job.total, 0, sizeof(job.total));
+  job.slicer = slicer;
+  job.keep = keep;
+  job.num_witnesses = 0;
+  seconds = bench_now();
+  failed = bench_fork(workers, sizeof(GateExploreStats), gateexplore_work,
+      gateexplore_gather, &job);
+  seconds = bench_now() - seconds;
+  if (failed)
+  {
+    return 1;
+  }
+
+  printf("configurations    %llu canonical of %llu, %u steps, %lu workers\n",
+      job.total.configurations, 1ULL << (8 * steps), steps, workers);
+  for (p = 0; p < steps; p++)
+  {
+    escalations += job.total.by_step[p];
+  }
+  printf("escalations       %llu", escalations);
+  for (p = 0; p < steps; p++)
+  {
+    printf(", %llu at step %u", job.total.by_step[p], p + 1);
+  }
+  printf("\n");
+  printf("host              %.2f M configurations/s, %u to a word\n",
+      seconds > 0 ? job.total.configurations / seconds / 1e6 : 0.0,
+      GATESLICE_LANES);
+
+  /* random canonical configurations, on the models too */
+  for (i = 0; i < samples; i++)
+  {
+    config = 0;
+    for (p = 0; p < steps; p++)
+    {
+      do
+      {
+        n = bench_random() & 0xFF;
+      }
+      while (! gateslice_canonical(n));
+      config |= (unsigned long long) n << (8 * p);
+    }
+    slicer->run(slicer, config >> GATESLICE_LANE_BITS, bad, quiet);
+    errors += gateexplore_step(bad, steps, config % GATESLICE_LANES)
+      != slicer->replay(slicer, config);
+  }
+  printf("cross-checked     %lu configurations on the models, %lu wrong\n",
+      samples, errors);
+
+  /* the shortest witnesses, each replayed */
+  qsort(job.witnesses, job.num_witnesses, sizeof(GateExploreWitness),
+      gateexplore_compare);
+  for (i = 0; i < job.num_witnesses && i < keep; i++)
+  {
+    step = slicer->replay(slicer, job.witnesses[i].config);
+    errors += step != job.witnesses[i].step;
+    printf("witness           %s", step == job.witnesses[i].step ? ""
+        : "(not on the models) ");
+    for (p = 0; p < job.witnesses[i].step; p++)
+    {
+      printf("%s%s", p ? "; " : "",
+          gateslice_name((job.witnesses[i].config >> (8 * p)) & 0xFF, name));
+    }
+    printf("\n");
+  }
+
+  free(job.witnesses);
+  slicer->free(slicer);
+  key->free(key);
+  gate->free(gate);
+
+  return errors != 0 || escalations != 0;
+}
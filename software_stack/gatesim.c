@@ -0,0 +1,228 @@
+/*
+ * Replays AXI traffic through the connector and trusted_gate model, and
+ *  reports the bandwidth achieved, the latency the gate adds, and the
+ *  permission check rate.
+ *
+ * A trace is a text file, 1 event per line, blank lines and lines
+ *  starting with # ignored, numbers in C notation:
+ *
+ *  <clock> R <addr> <beats> [prot] [user]   read burst issued
+ *  <clock> W <addr> <beats> [prot] [user]   write burst issued
+ *  <clock> K <key>                          trusted_key switches KEY_IN
+ *  <clock> T <reg> <key>                    load a table entry, the
+ *                                            register picks permissions
+ *  <clock> S                                seal the table
+ *
+ * Events must be in clock order. prot defaults to 2, user to 0.
+ *
+ * usage: gatesim [-w data bits] [-o outstanding] [-l slave latency]
+ *                [-g gate latency] [-f ACLK MHz] [-n transactions] [trace]
+ *  -n generates that many random transactions instead of reading a trace
+ *  reads standard input when neither a trace nor -n is given
+ *
+ * build: cc -O2 -o gatesim gatesim.c connector.c gate.c hal.c
+ */
+#include <time.h>
+#include "bench.h"
+#include "connector.h"
+#include "xil_io.h"
+#include "xparameters.h"
+
+/* longest trace line */
+#define GATESIM_LINE 256
+
+/* replay a trace, returns non-zero on a malformed line */
+static int gatesim_replay(ConnectorModel *connector, FILE *in)
+{
+  char line[GATESIM_LINE];
+  char *cur, *end;
+  unsigned long number = 0;
+  u32 cycle, args[4];
+  AxiTxn txn;
+  char op;
+  int n;
+
+  while (fgets(line, sizeof(line), in))
+  {
+    number++;
+
+    /* skip blanks and comments */
+    for (cur = line; *cur == ' ' || *cur == '\t'; cur++);
+    if (*cur == '#' || *cur == '\n' || ! *cur)
+    {
+      continue;
+    }
+
+    /* clock and operation */
+    cycle = (u32) strtoul(cur, &end, 0);
+    for (cur = end; *cur == ' ' || *cur == '\t'; cur++);
+    op = *cur ? *cur++ : '\0';
+
+    /* up to 4 numeric arguments */
+    for (n = 0; n < 4; n++)
+    {
+      args[n] = (u32) strtoul(cur, &end, 0);
+      if (end == cur)
+      {
+        break;
+      }
+      cur = end;
+    }
+
+    switch (op)
+    {
+      case 'R':
+      case 'W':
+        if (n < 2 || ! args[1])
+        {
+          break;
+        }
+        txn.cycle = cycle;
+        txn.write = op == 'W';
+        txn.addr  = args[0];
+        txn.beats = args[1];
+        txn.prot  = n > 2 ? args[2] : GATE_SAFE_PROT;
+        txn.user  = n > 3 ? args[3] : 0;
+        connector->transfer(connector, &txn);
+        continue;
+
+      case 'K':
+        if (n < 1)
+        {
+          break;
+        }
+        connector->setKey(connector, args[0]);
+        continue;
+
+      case 'T':
+        if (n < 2 || args[0] >= GATE_NUM_KEYS)
+        {
+          break;
+        }
+        Xil_Out32(XPAR_TRUSTED_GATE_0_BASEADDR + args[0] * 4, args[1]);
+        continue;
+
+      case 'S':
+        Xil_In32(XPAR_TRUSTED_GATE_0_BASEADDR);
+        continue;
+
+      default:
+        break;
+    }
+
+    fprintf(stderr, "line %lu: malformed event\n", number);
+    return 1;
+  }
+
+  return 0;
+}
+
+/* random bursts from 4 keys, 1 of them without CRIT, switching often */
+static void gatesim_generate(ConnectorModel *connector, unsigned long count)
+{
+  static const u32 keys[4] = { 0x1000, 0x2000, 0x3000, 0x4000 };
+  unsigned long i;
+  u32 cycle = 0, r;
+  AxiTxn txn;
+
+  /* load the table through its registers, only the last key lacks CRIT */
+  Xil_Out32(XPAR_TRUSTED_GATE_0_BASEADDR + 0x1F * 4, keys[0]);
+  Xil_Out32(XPAR_TRUSTED_GATE_0_BASEADDR + 0x16 * 4, keys[1]);
+  Xil_Out32(XPAR_TRUSTED_GATE_0_BASEADDR + 0x12 * 4, keys[2]);
+  Xil_Out32(XPAR_TRUSTED_GATE_0_BASEADDR + 0x02 * 4, keys[3]);
+  Xil_In32(XPAR_TRUSTED_GATE_0_BASEADDR);
+
+  for (i = 0; i < count; i++)
+  {
+    r = bench_random();
+
+    if (! (i & 0xFF))
+    {
+      connector->setKey(connector, keys[r & 3]);
+    }
+
+    cycle += 1 + ((r >> 2) & 7);
+    txn.cycle = cycle;
+    txn.write = (r >> 4) & 1;
+    txn.addr  = (r & 0x0FFFFFC0) | 0x10000000;
+    txn.beats = 1 << ((r >> 5) & 3);
+    txn.prot  = (r >> 7) & 7;
+    txn.user  = r;
+    connector->transfer(connector, &txn);
+  }
+}
+
+int main(int argc, char **argv)
+{
+  unsigned data_width = 32, acceptance = 8, slave_latency = 4;
+  unsigned gate_latency = 0;
+  unsigned long generate = 0;
+  double clock_mhz = 100.0, seconds;
+  ConnectorModel *connector;
+  GateModel *gate;
+  FILE *in = stdin;
+  clock_t started;
+  int i, failed = 0;
+
+  /* options */
+  for (i = 1; i < argc - 1 && argv[i][0] == '-'; i += 2)
+  {
+    switch (argv[i][1])
+    {
+      case 'w': data_width    = (unsigned) strtoul(argv[i + 1], NULL, 0); break;
+      case 'o': acceptance    = (unsigned) strtoul(argv[i + 1], NULL, 0); break;
+      case 'l': slave_latency = (unsigned) strtoul(argv[i + 1], NULL, 0); break;
+      case 'g': gate_latency  = (unsigned) strtoul(argv[i + 1], NULL, 0); break;
+      case 'f': clock_mhz     = strtod(argv[i + 1], NULL);                break;
+      case 'n': generate      = strtoul(argv[i + 1], NULL, 0);            break;
+      default:  i = argc;                                                 break;
+    }
+  }
+  if (i < argc - 1 || (i == argc - 1 && argv[i][0] == '-'))
+  {
+    fprintf(stderr, "usage: %s [-w data bits] [-o outstanding] "
+        "[-l slave latency] [-g gate latency] [-f ACLK MHz] "
+        "[-n transactions] [trace]\n", argv[0]);
+    return 1;
+  }
+  if (i == argc - 1 && ! generate && ! (in = fopen(argv[i], "r")))
+  {
+    perror(argv[i]);
+    return 1;
+  }
+
+  if (
+         ! (gate = newGateModel(XPAR_TRUSTED_GATE_0_BASEADDR))
+      || ! (connector = newConnectorModel(gate, data_width, acceptance,
+              slave_latency, gate_latency))
+      )
+  {
+    fprintf(stderr, "bad configuration\n");
+    return 1;
+  }
+
+  /* replay, timing the host */
+  started = clock();
+  if (generate)
+  {
+    gatesim_generate(connector, generate);
+  }
+  else
+  {
+    failed = gatesim_replay(connector, in);
+  }
+  seconds = (double) (clock() - started) / CLOCKS_PER_SEC;
+
+  connector->report(connector, stdout, clock_mhz * 1e6);
+  printf("host              %.2f M transactions/s\n",
+      seconds > 0 ? connector->stats.txns / seconds / 1e6 : 0.0);
+
+  if (in != stdin)
+  {
+    fclose(in);
+  }
+  connector->free(connector);
+  gate->free(gate);
+
+  return failed;
+}
@@ -0,0 +1,437 @@
+#include "gateslice.h"
+
+/* method forward decls */
+unsigned GateSlicer_run(GateSlicer *self, unsigned long long batch,
+    GateSliceWord *bad, GateSliceWord *quiet);
+unsigned GateSlicer_replay(GateSlicer *self, unsigned long long config);
+GateSlicer * GateSlicer_free(GateSlicer *self);
+
+/* every lane set to the same bits */
+static GateSliceWord gateslice_fill(unsigned long long bits)
+{
+  GateSliceWord word;
+  unsigned e;
+
+  for (e = 0; e < GATESLICE_ELEMENTS; e++)
+  {
+    word[e] = bits;
+  }
+
+  return word;
+}
+
+/* lanes where a 2 bit slice holds value */
+static GateSliceWord gateslice_is(const GateSliceWord *bits, unsigned value)
+{
+  return (value & 1 ? bits[0] : ~bits[0]) & (value & 2 ? bits[1] : ~bits[1]);
+}
+
+/* where a lane's configuration index bit is set, lanes are the low bits */
+static GateSliceWord gateslice_index(unsigned long long batch, unsigned bit)
+{
+  static const unsigned long long patterns[6] =
+  {
+    0xAAAAAAAAAAAAAAAAULL, 0xCCCCCCCCCCCCCCCCULL, 0xF0F0F0F0F0F0F0F0ULL,
+    0xFF00FF00FF00FF00ULL, 0xFFFF0000FFFF0000ULL, 0xFFFFFFFF00000000ULL
+  };
+  GateSliceWord word;
+  unsigned e;
+
+  if (bit < 6)
+  {
+    return gateslice_fill(patterns[bit]);
+  }
+  if (bit >= GATESLICE_LANE_BITS)
+  {
+    return gateslice_fill((batch >> (bit - GATESLICE_LANE_BITS)) & 1
+        ? ~0ULL : 0);
+  }
+  for (e = 0; e < GATESLICE_ELEMENTS; e++)
+  {
+    word[e] = (e >> (bit - 6)) & 1 ? ~0ULL : 0;
+  }
+
+  return word;
+}
+
+/*
+ * a step in every lane, op[i] being the lanes with bit i of their step
+ *  set. Entries from live up are known to be clear and not loaded yet.
+ */
+static void GateSlicer_step(GateSliceState *s, const GateSliceWord *op,
+    unsigned live)
+{
+  GateSliceWord add = ~op[7], set = op[7] & ~op[6];
+  GateSliceWord use = op[7] & op[6] & ~op[5], misc = op[7] & op[6] & op[5];
+  GateSliceWord seal = misc & ~op[1] & ~op[0];
+  GateSliceWord reset = misc & ~op[1] & op[0];
+  GateSliceWord clear = misc & op[1] & ~op[0];
+  GateSliceWord hit;
+  unsigned i, b, top = live < GATE_NUM_KEYS ? live : GATE_NUM_KEYS - 1;
+
+  /* a table load lands on the next entry, which moves up one */
+  for (i = 0; i < live; i++)
+  {
+    hit = add & s->at[i];
+    for (b = 0; b < 2; b++)
+    {
+      s->key[i][b] = (s->key[i][b] & ~hit) | (op[b] & hit);
+    }
+    for (b = 0; b < 5; b++)
+    {
+      s->reg[i][b] = (s->reg[i][b] & ~hit) | (op[b + 2] & hit);
+    }
+  }
+  if (live == GATE_NUM_KEYS)
+  {
+    s->at[GATE_NUM_KEYS] |= s->at[GATE_NUM_KEYS - 1] & add;
+  }
+  for (i = top; i > 0; i--)
+  {
+    s->at[i] = (s->at[i] & ~add) | (s->at[i - 1] & add);
+  }
+  s->at[0] &= ~add;
+
+  /* reading the table seals it */
+  for (i = 0; i <= top; i++)
+  {
+    s->at[i] &= ~seal;
+  }
+  s->at[GATE_NUM_KEYS] |= seal;
+
+  /* the gate's soft reset empties and reopens it */
+  for (i = 0; i < live; i++)
+  {
+    for (b = 0; b < 2; b++)
+    {
+      s->key[i][b] &= ~reset;
+    }
+    for (b = 0; b < 5; b++)
+    {
+      s->reg[i][b] &= ~reset;
+    }
+  }
+  for (i = 1; i <= top; i++)
+  {
+    s->at[i] &= ~reset;
+  }
+  s->at[GATE_NUM_KEYS] &= ~reset;
+  s->at[0] |= reset;
+
+  /* key register loads, and the key's soft reset, which keeps KEY_OUT */
+  for (i = 0; i < GATESLICE_SLOTS; i++)
+  {
+    hit = set & gateslice_is(op + 2, i);
+    for (b = 0; b < 2; b++)
+    {
+      s->slot[i][b] = ((s->slot[i][b] & ~hit) | (op[b] & hit)) & ~clear;
+    }
+  }
+
+  /* the control word picks KEY_OUT */
+  for (i = 0; i < GATESLICE_SLOTS; i++)
+  {
+    hit = use & gateslice_is(op, i);
+    for (b = 0; b < 2; b++)
+    {
+      s->out[b] = (s->out[b] & ~hit) | (s->slot[i][b] & hit);
+    }
+  }
+}
+
+/* lanes where KEY_OUT has the permission and should not */
+static GateSliceWord GateSlicer_check(GateSlicer *self, unsigned live)
+{
+  GateSliceState *s = &self->state;
+  GateSliceWord granted = gateslice_fill(0), unintended = granted, hit, has;
+  unsigned i, b;
+
+  /* the highest matching entry wins, so later matches override */
+  for (i = 0; i < live; i++)
+  {
+    hit = ~(s->key[i][0] ^ s->out[0]) & ~(s->key[i][1] ^ s->out[1]);
+    has = gateslice_fill(0);
+    for (b = 0; b < 5; b++)
+    {
+      if (self->reg_mask & (1 << b))
+      {
+        has |= s->reg[i][b];
+      }
+    }
+    granted = (granted & ~hit) | (has & hit);
+  }
+
+  /* key 0 matches the empty entries above, which grant nothing */
+  if (live < GATE_NUM_KEYS)
+  {
+    granted &= s->out[0] | s->out[1];
+  }
+
+  for (i = 0; i < GATESLICE_KEYS; i++)
+  {
+    if (! (self->intended & (1 << i)))
+    {
+      unintended |= gateslice_is(s->out, i);
+    }
+  }
+
+  return granted & unintended;
+}
+
+/* permissions the gate gives a key, none if it is not in the table */
+static u32 GateSlicer_perms(GateSlicer *self, u32 key)
+{
+  AxiTxn txn;
+
+  memset(&txn, 0, sizeof(txn));
+  txn.prot = GATE_SAFE_PROT;
+  self->gate->setKey(self->gate, key);
+  self->gate->check(self->gate, &txn);
+
+  return self->gate->key_found ? self->gate->key_perms : 0;
+}
+
+/* a step on the models, through their registers as the driver does it */
+static void GateSlicer_apply(GateSlicer *self, unsigned op)
+{
+  Device *gate = &self->gate->device, *key = &self->key->device;
+
+  if (! (op & 0x80))
+  {
+    gate->write(gate, 4 * (op >> 2), op & 3);
+  }
+  else if (! (op & 0x40))
+  {
+    key->write(key, 4 * (((op >> 2) & 3) + KEY_ID_CRIT), op & 3);
+  }
+  else if (! (op & 0x20))
+  {
+    key->write(key, 0, 1 << ((op & 3) + KEY_ID_CRIT));
+  }
+  else if ((op & 3) == (GATESLICE_SEAL & 3))
+  {
+    gate->read(gate, 0);
+  }
+  else if ((op & 3) == (GATESLICE_GATE_RESET & 3))
+  {
+    gate->write(gate, GATE_SOFT_RST_OFFSET, GATE_SOFT_RESET);
+  }
+  else if ((op & 3) == (GATESLICE_KEY_RESET & 3))
+  {
+    key->write(key, KEY_SOFT_RST_OFFSET, KEY_SOFT_RESET);
+  }
+}
+
+/* both models as out of reset, then the prefix */
+static void GateSlicer_boot(GateSlicer *self)
+{
+  unsigned i;
+
+  self->gate->reset(self->gate);
+  self->key->reset(self->key);
+  self->key->key_out = 0;
+  for (i = 0; i < self->prefix_len; i++)
+  {
+    GateSlicer_apply(self, self->prefix[i]);
+  }
+}
+
+/* constructor */
+GateSlicer * newGateSlicer(GateModel *gate, KeyModel *key, u32 perm,
+    const unsigned char *prefix, unsigned prefix_len, unsigned steps)
+{
+  GateSlicer *self;
+  GateSliceWord op[8];
+  unsigned i, b;
+
+  if (
+         ! gate
+      || ! key
+      || key->sim
+      || ! perm
+      || prefix_len > GATESLICE_MAX_PREFIX
+      || steps < 2
+      || steps > GATESLICE_MAX_STEPS
+      || posix_memalign((void **) &self, sizeof(GateSliceWord),
+          sizeof(GateSlicer))
+      )
+  {
+    return NULL;
+  }
+
+  /* zero */
+  memset(self, 0, sizeof(GateSlicer));
+
+  /* bind methods */
+  self->run    = GateSlicer_run;
+  self->replay = GateSlicer_replay;
+  self->free   = GateSlicer_free;
+
+  self->gate = gate;
+  self->key  = key;
+  self->perm = perm;
+  memcpy(self->prefix, prefix, prefix_len);
+  self->prefix_len = prefix_len;
+  self->steps = steps;
+
+  /* which register number bits grant perm, one at a time on the gate */
+  for (b = 0; b < 5; b++)
+  {
+    gate->reset(gate);
+    gate->device.write(&gate->device, 4 << b, 1);
+    gate->device.read(&gate->device, 0);
+    if (GateSlicer_perms(self, 1) & perm)
+    {
+      self->reg_mask |= 1 << b;
+    }
+  }
+
+  /* which keys the prefix means to have it */
+  GateSlicer_boot(self);
+  for (i = 0; i < GATESLICE_KEYS; i++)
+  {
+    if (GateSlicer_perms(self, i) & perm)
+    {
+      self->intended |= 1 << i;
+    }
+  }
+
+  /* the prefix, the same in every lane */
+  self->boot.at[0] = gateslice_fill(~0ULL);
+  for (i = 0; i < prefix_len; i++)
+  {
+    for (b = 0; b < 8; b++)
+    {
+      op[b] = gateslice_fill((prefix[i] >> b) & 1 ? ~0ULL : 0);
+    }
+    if (! (prefix[i] & 0x80) && self->live < GATE_NUM_KEYS)
+    {
+      self->live++;
+    }
+    GateSlicer_step(&self->boot, op, self->live);
+  }
+
+  return self;
+}
+
+/* a batch of configurations */
+unsigned GateSlicer_run(GateSlicer *self, unsigned long long batch,
+    GateSliceWord *bad, GateSliceWord *quiet)
+{
+  GateSliceWord op[GATESLICE_MAX_STEPS][8], canonical = gateslice_fill(~0ULL);
+  GateSliceWord escalated = gateslice_fill(0), nop;
+  unsigned p, b, live, count = 0;
+
+  /* each step's bits, and whether it is canonical and nothing */
+  for (p = 0; p < self->steps; p++)
+  {
+    for (b = 0; b < 8; b++)
+    {
+      op[p][b] = gateslice_index(batch, 8 * p + b);
+    }
+    canonical &= ~op[p][7]
+      | (~op[p][6] & ~op[p][5] & ~op[p][4])
+      | (op[p][6] & ~op[p][4] & ~op[p][3] & ~op[p][2]);
+  }
+  nop = gateslice_fill(~0ULL);
+  for (p = self->steps; p-- > 0; )
+  {
+    quiet[p] = nop;
+    nop &= op[p][7] & op[p][6] & op[p][5] & op[p][1] & op[p][0];
+  }
+
+  memcpy(&self->state, &self->boot, sizeof(GateSliceState));
+  for (p = 0; p < self->steps; p++)
+  {
+    live = self->live + p + 1;
+    live = live < GATE_NUM_KEYS ? live : GATE_NUM_KEYS;
+    GateSlicer_step(&self->state, op[p], live);
+    bad[p] = GateSlicer_check(self, live) & ~escalated;
+    escalated |= bad[p];
+  }
+
+  for (p = 0; p < self->steps; p++)
+  {
+    bad[p] &= canonical;
+  }
+  for (b = 0; b < GATESLICE_ELEMENTS; b++)
+  {
+    count += __builtin_popcountll(canonical[b]);
+  }
+
+  return count;
+}
+
+/* a configuration on the models */
+unsigned GateSlicer_replay(GateSlicer *self, unsigned long long config)
+{
+  unsigned p;
+  u32 out;
+
+  GateSlicer_boot(self);
+  for (p = 0; p < self->steps; p++)
+  {
+    GateSlicer_apply(self, (config >> (8 * p)) & 0xFF);
+    out = self->key->key_out;
+    if (
+           GateSlicer_perms(self, out) & self->perm
+        && (out >= GATESLICE_KEYS || ! (self->intended & (1 << out)))
+        )
+    {
+      return p + 1;
+    }
+  }
+
+  return 0;
+}
+
+/* destructor */
+GateSlicer * GateSlicer_free(GateSlicer *self)
+{
+  free(self);
+
+  return NULL;
+}
+
+/* canonical steps have their ignored bits clear */
+int gateslice_canonical(unsigned op)
+{
+  if (! (op & 0x80))
+  {
+    return 1;
+  }
+  if (! (op & 0x40))
+  {
+    return ! (op & 0x30);
+  }
+
+  return ! (op & 0x1C);
+}
+
+/* a step as the driver macro doing it */
+char * gateslice_name(unsigned op, char *out)
+{
+  static const char *misc[4] =
+  {
+    "read_gate_key(0)", "gate soft reset", "key soft reset", "nothing"
+  };
+
+  if (! (op & 0x80))
+  {
+    sprintf(out, "add_gate_permission(%u, %u)", (op >> 2) & 31, op & 3);
+  }
+  else if (! (op & 0x40))
+  {
+    sprintf(out, "add_trusted_key(%u, %u)", (op >> 2) & 3, op & 3);
+  }
+  else if (! (op & 0x20))
+  {
+    sprintf(out, "use_trusted_key(%u)", op & 3);
+  }
+  else
+  {
+    strcpy(out, misc[op & 3]);
+  }
+
+  return out;
+}
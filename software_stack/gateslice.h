@@ -0,0 +1,170 @@
+#ifndef __SOFT_STACK_GATESLICE
+#define __SOFT_STACK_GATESLICE
+
+#include "gate.h"
+#include "key.h"
+
+/** Configurations evaluated per GateSliceWord, one per bit */
+#if defined(__AVX512F__)
+#define GATESLICE_LANE_BITS 9
+#elif defined(__AVX2__)
+#define GATESLICE_LANE_BITS 8
+#else
+#define GATESLICE_LANE_BITS 7
+#endif
+#define GATESLICE_LANES (1 << GATESLICE_LANE_BITS)
+
+/** 64 bit elements of a GateSliceWord */
+#define GATESLICE_ELEMENTS (GATESLICE_LANES / 64)
+
+/** Key values and key registers modelled, 2 bits of each */
+#define GATESLICE_KEYS  4
+#define GATESLICE_SLOTS 4
+
+/** Longest prefix, and most steps, a configuration runs */
+#define GATESLICE_MAX_PREFIX 32
+#define GATESLICE_MAX_STEPS  5
+
+/**
+ * A step is a byte, a configuration being steps bytes of an index, the
+ *  first step in the low byte:
+ *
+ *  0rrrrrkk  add_gate_permission(r, k)
+ *  10..sskk  add_trusted_key(s, k)
+ *  110...ss  use_trusted_key(s)
+ *  111...oo  read_gate_key (seal), gate soft reset, key soft reset, nothing
+ *
+ * Bits shown as dots are ignored, and only bytes with them clear are
+ *  canonical, 152 of the 256.
+ */
+#define GATESLICE_ADD(reg, key)    (((reg) << 2) | (key))
+#define GATESLICE_KEYSET(slot, key) (0x80 | ((slot) << 2) | (key))
+#define GATESLICE_USE(slot)        (0xC0 | (slot))
+#define GATESLICE_SEAL             0xE0
+#define GATESLICE_GATE_RESET       0xE1
+#define GATESLICE_KEY_RESET        0xE2
+#define GATESLICE_NOP              0xE3
+
+/** One bit per configuration, GCC vector extensions pick the registers */
+typedef unsigned long long GateSliceWord
+  __attribute__((vector_size(GATESLICE_LANES / 8)));
+
+/**
+ * trusted_gate's table and trusted_key's registers across
+ *  GATESLICE_LANES configurations, a GateSliceWord per state bit
+ */
+typedef struct _GateSliceState
+{
+  /** table entries, key and register number bits */
+  GateSliceWord key[GATE_NUM_KEYS][2];
+  GateSliceWord reg[GATE_NUM_KEYS][5];
+
+  /** loaded one-hot, at[GATE_NUM_KEYS] full or sealed */
+  GateSliceWord at[GATE_NUM_KEYS + 1];
+
+  /** key registers add_trusted_key writes, and KEY_OUT */
+  GateSliceWord slot[GATESLICE_SLOTS][2];
+  GateSliceWord out[2];
+
+} GateSliceState;
+
+/**
+ * A GateSlicer looks for permission escalation: run a prefix, such as
+ *  chase_led's boot, then every sequence of steps of the table loads, key
+ *  loads, key selections, seals and soft resets software can do, and
+ *  after every step check whether KEY_OUT has a permission the prefix
+ *  did not give it. The gate's state is bit-sliced, so a lookup, first
+ *  match from the top as in USE_KEY_PROC, is a few logic operations per
+ *  entry for a whole GateSliceWord of configurations at once.
+ *
+ * Which register number bits grant the permission, and which keys the
+ *  prefix meant to have it, come from running a GateModel and a KeyModel,
+ *  and replay runs any configuration through them for cross-checking.
+ */
+typedef struct _GateSlicer
+{
+  /** permissions checked, GatePerm bits */
+  u32 perm;
+
+  /** register number bits granting perm, and keys the prefix gave it */
+  unsigned reg_mask;
+  unsigned intended;
+
+  /** boot steps, and steps per configuration */
+  unsigned char prefix[GATESLICE_MAX_PREFIX];
+  unsigned prefix_len;
+  unsigned steps;
+
+  /** entries which can be set after the prefix */
+  unsigned live;
+
+  /** state after the prefix, and the working copy */
+  GateSliceState boot;
+  GateSliceState state;
+
+  /** models to derive from and replay on, not owned */
+  GateModel *gate;
+  KeyModel *key;
+
+  /**
+   * Run a batch, configurations batch * GATESLICE_LANES and up
+   *
+   * @param batch batch number
+   * @param bad filled with steps words, the canonical configurations
+   *  first escalating at each step
+   * @param quiet filled with steps words, the configurations whose steps
+   *  after each are all GATESLICE_NOP
+   * @return number of canonical configurations in the batch
+   */
+  unsigned (*run)(struct _GateSlicer *self, unsigned long long batch,
+      GateSliceWord *bad, GateSliceWord *quiet);
+
+  /**
+   * Run a single configuration on the models
+   *
+   * @param config configuration index
+   * @return the first step escalating, from 1, or 0 if none does
+   */
+  unsigned (*replay)(struct _GateSlicer *self, unsigned long long config);
+
+  /**
+   * Destructor, leaves the models alone
+   *
+   * @return NULL
+   */
+  struct _GateSlicer * (*free)(struct _GateSlicer *self);
+
+} GateSlicer;
+
+/**
+ * Constructor
+ *
+ * @param gate a GateModel, reset by the GateSlicer whenever it likes
+ * @param key a KeyModel with no Sim, likewise
+ * @param perm permissions to check, GatePerm bits
+ * @param prefix boot steps, run once before every configuration
+ * @param prefix_len number of boot steps, up to GATESLICE_MAX_PREFIX
+ * @param steps steps per configuration, 2 to GATESLICE_MAX_STEPS
+ * @return a new GateSlicer, or NULL if out of memory or out of range
+ */
+GateSlicer * newGateSlicer(GateModel *gate, KeyModel *key, u32 perm,
+    const unsigned char *prefix, unsigned prefix_len, unsigned steps);
+
+/**
+ * Whether a step byte is canonical
+ *
+ * @param op step byte
+ * @return non-zero if canonical
+ */
+int gateslice_canonical(unsigned op);
+
+/**
+ * Name a step, as the driver macro doing it
+ *
+ * @param op step byte
+ * @param out at least 40 bytes
+ * @return out
+ */
+char * gateslice_name(unsigned op, char *out);
+
+#endif /* __SOFT_STACK_GATESLICE */
@@ -0,0 +1,110 @@
+#include "hal.h"
+
+/* every attached Device */
+static Device *hal_devices = NULL;
+
+/* private storage for the unmapped access count, 'grow' adds to it */
+static unsigned hal_changeUnmapped(unsigned grow)
+{
+  static unsigned unmapped = 0;
+
+  unmapped += grow;
+
+  return unmapped;
+}
+
+/* find the Device decoding an address */
+static Device * hal_find(u32 address)
+{
+  Device *cur;
+
+  for (cur = hal_devices; cur; cur = cur->next)
+  {
+    if (address >= cur->base && address - cur->base < cur->size)
+    {
+      return cur;
+    }
+  }
+
+  return NULL;
+}
+
+/* add a device */
+int hal_attach(Device *device)
+{
+  Device *cur;
+
+  if (! device || ! device->size)
+  {
+    return 1;
+  }
+
+  /* refuse overlaps */
+  for (cur = hal_devices; cur; cur = cur->next)
+  {
+    if (
+           device->base <= cur->base + (cur->size - 1)
+        && cur->base <= device->base + (device->size - 1)
+        )
+    {
+      return 1;
+    }
+  }
+
+  device->next = hal_devices;
+  hal_devices = device;
+
+  return 0;
+}
+
+/* remove a device */
+Device * hal_detach(Device *device)
+{
+  Device **cur;
+
+  for (cur = &hal_devices; *cur; cur = &((*cur)->next))
+  {
+    if (*cur == device)
+    {
+      *cur = device->next;
+      device->next = NULL;
+      return device;
+    }
+  }
+
+  return NULL;
+}
+
+/* number of accesses which missed every device */
+unsigned hal_unmapped()
+{
+  return hal_changeUnmapped(0);
+}
+
+/* 32-bit read */
+u32 Xil_In32(u32 address)
+{
+  Device *found = hal_find(address);
+
+  if (found && found->read)
+  {
+    return found->read(found, address - found->base);
+  }
+
+  hal_changeUnmapped(1);
+  return 0;
+}
+
+/* 32-bit write */
+void Xil_Out32(u32 address, u32 data)
+{
+  Device *found = hal_find(address);
+
+  if (found && found->write)
+  {
+    found->write(found, address - found->base, data);
+    return;
+  }
+
+  hal_changeUnmapped(1);
+}
@@ -0,0 +1,83 @@
+#ifndef __SOFT_STACK_HAL
+#define __SOFT_STACK_HAL
+
+#include "main.h"
+
+/** Xilinx BSP integer types, so SDK drivers build against this model */
+typedef unsigned int Xuint32;
+typedef unsigned int u32;
+
+/**
+ * A Device models a single memory mapped peripheral. Once attached, every
+ *  Xil_In32/Xil_Out32 inside [base, base + size) is handed to it with the
+ *  address made relative to base.
+ */
+typedef struct _Device
+{
+  /** first byte address decoded by this Device */
+  u32 base;
+
+  /** number of bytes decoded by this Device */
+  u32 size;
+
+  /** the next attached Device or NULL */
+  struct _Device *next;
+
+  /**
+   * Read a 32-bit word
+   *
+   * @param offset byte offset from base
+   * @return the word read
+   */
+  u32 (*read)(struct _Device *self, u32 offset);
+
+  /**
+   * Write a 32-bit word
+   *
+   * @param offset byte offset from base
+   * @param data the word to write
+   */
+  void (*write)(struct _Device *self, u32 offset, u32 data);
+
+} Device;
+
+/**
+ * Add a Device to the bus model
+ *
+ * @param device Device to add, must not overlap an attached Device
+ * @return 0 on success, or non-zero if the Device overlaps another one
+ */
+int hal_attach(Device *device);
+
+/**
+ * Remove a Device from the bus model
+ *
+ * @param device previously attached Device
+ * @return the removed Device, or NULL if it was never attached
+ */
+Device * hal_detach(Device *device);
+
+/**
+ * Accesses which did not decode to any attached Device
+ *
+ * @return the number of unmapped reads and writes so far
+ */
+unsigned hal_unmapped();
+
+/**
+ * Model of the BSP's 32-bit read, unmapped reads return 0
+ *
+ * @param address absolute byte address
+ * @return the word read
+ */
+u32 Xil_In32(u32 address);
+
+/**
+ * Model of the BSP's 32-bit write, unmapped writes are dropped
+ *
+ * @param address absolute byte address
+ * @param data the word to write
+ */
+void Xil_Out32(u32 address, u32 data);
+
+#endif /* __SOFT_STACK_HAL */
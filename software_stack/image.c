@@ -0,0 +1,466 @@
+#include "image.h"
+#include "decode.h"
+
+/* method forward decls */
+Image * Image_retain(Image *self);
+Image * Image_release(Image *self);
+const ImageInstr * ImageView_get(ImageView *self, unsigned address);
+ImageView * ImageView_patch(ImageView *self, unsigned address,
+    unsigned binary);
+ImageView * ImageView_push(ImageView *self, unsigned binary);
+ImageView * ImageView_pop(ImageView *self, ImageInstr *popped);
+unsigned ImageView_jump(ImageView *self, unsigned address);
+ImageView * ImageView_free(ImageView *self);
+
+/* bytes of a private page */
+#define IMAGE_PAGE_BYTES (IMAGE_PAGE_INSTRS * sizeof(ImageInstr))
+
+/* constructor */
+Image * newImage(const unsigned char *bytes, size_t count)
+{
+  Image *self = (Image *) malloc(sizeof(Image));
+  size_t i;
+
+  /* out of memory */
+  if (! self)
+  {
+    return NULL;
+  }
+
+  /* zero */
+  memset(self, 0, sizeof(Image));
+
+  /* bind methods */
+  self->retain  = Image_retain;
+  self->release = Image_release;
+  self->refs    = 1;
+
+  /* decode once, for every view */
+  if (count && ! (self->instrs = (ImageInstr *)
+        malloc(count * sizeof(ImageInstr))))
+  {
+    free(self);
+    return NULL;
+  }
+  self->count = count;
+  for (i = 0; i < count; i++)
+  {
+    self->instrs[i].binary = bytes[2 * i] | (bytes[2 * i + 1] << 8);
+    self->instrs[i].opcode = decode_opcode(self->instrs[i].binary);
+  }
+
+  return self;
+}
+
+/* another reference */
+Image * Image_retain(Image *self)
+{
+  self->refs++;
+
+  return self;
+}
+
+/* one reference fewer, destructor with the last */
+Image * Image_release(Image *self)
+{
+  if (--self->refs)
+  {
+    return self;
+  }
+
+  free(self->instrs);
+  free(self);
+
+  return NULL;
+}
+
+/* constructor */
+ImageView * newImageView(Image *image)
+{
+  ImageView *self = (ImageView *) malloc(sizeof(ImageView));
+
+  /* out of memory */
+  if (! self)
+  {
+    return NULL;
+  }
+
+  /* zero */
+  memset(self, 0, sizeof(ImageView));
+
+  /* bind methods */
+  self->get   = ImageView_get;
+  self->patch = ImageView_patch;
+  self->push  = ImageView_push;
+  self->pop   = ImageView_pop;
+  self->jump  = ImageView_jump;
+  self->free  = ImageView_free;
+
+  /* a single piece, the whole Image */
+  self->max_pieces = 4;
+  if (! (self->pieces = (ImagePiece *)
+        calloc(self->max_pieces, sizeof(ImagePiece))))
+  {
+    free(self);
+    return NULL;
+  }
+  self->image = image->retain(image);
+  self->size  = image->count;
+  self->bytes = sizeof(ImageView) + self->max_pieces * sizeof(ImagePiece);
+  if (image->count)
+  {
+    self->pieces[0].instrs = image->instrs;
+    self->pieces[0].count  = image->count;
+    self->num_pieces = 1;
+  }
+
+  return self;
+}
+
+/* piece holding an address, and the offset into it */
+static unsigned ImageView_find(ImageView *self, unsigned address,
+    unsigned *offset)
+{
+  unsigned lo = 0, hi = self->num_pieces - 1, mid;
+
+  while (lo < hi)
+  {
+    mid = (lo + hi + 1) / 2;
+    if (self->pieces[mid].start <= address)
+    {
+      lo = mid;
+    }
+    else
+    {
+      hi = mid - 1;
+    }
+  }
+  *offset = address - self->pieces[lo].start;
+
+  return lo;
+}
+
+/* room for 'more' pieces, so nothing after this can run out */
+static int ImageView_reserve(ImageView *self, unsigned more)
+{
+  ImagePiece *pieces;
+  unsigned max = self->max_pieces;
+
+  while (self->num_pieces + more > max)
+  {
+    max *= 2;
+  }
+  if (max != self->max_pieces)
+  {
+    if (! (pieces = (ImagePiece *)
+          realloc(self->pieces, max * sizeof(ImagePiece))))
+    {
+      return -1;
+    }
+    self->bytes += (max - self->max_pieces) * sizeof(ImagePiece);
+    self->pieces = pieces;
+    self->max_pieces = max;
+  }
+
+  return 0;
+}
+
+/* open 'n' pieces at index 'at', reserved beforehand */
+static ImagePiece * ImageView_open(ImageView *self, unsigned at, unsigned n)
+{
+  memmove(self->pieces + at + n, self->pieces + at,
+      (self->num_pieces - at) * sizeof(ImagePiece));
+  self->num_pieces += n;
+
+  return self->pieces + at;
+}
+
+/* close piece 'at', freeing its page */
+static void ImageView_close(ImageView *self, unsigned at)
+{
+  if (self->pieces[at].owned)
+  {
+    free(self->pieces[at].instrs);
+    self->bytes -= IMAGE_PAGE_BYTES;
+  }
+  self->num_pieces--;
+  memmove(self->pieces + at, self->pieces + at + 1,
+      (self->num_pieces - at) * sizeof(ImagePiece));
+}
+
+/* a private page */
+static ImageInstr * ImageView_page(ImageView *self)
+{
+  ImageInstr *page = (ImageInstr *) malloc(IMAGE_PAGE_BYTES);
+
+  if (page)
+  {
+    self->bytes += IMAGE_PAGE_BYTES;
+  }
+
+  return page;
+}
+
+/* start addresses from piece 'from' on */
+static void ImageView_renumber(ImageView *self, unsigned from)
+{
+  unsigned i, start = from ? self->pieces[from - 1].start
+    + self->pieces[from - 1].count : 0;
+
+  for (i = from; i < self->num_pieces; i++)
+  {
+    self->pieces[i].start = start;
+    start += self->pieces[i].count;
+  }
+}
+
+/* the instruction at an address, in whichever piece has it */
+const ImageInstr * ImageView_get(ImageView *self, unsigned address)
+{
+  unsigned i, offset;
+
+  if (address >= self->size)
+  {
+    return NULL;
+  }
+  i = ImageView_find(self, address, &offset);
+
+  return &self->pieces[i].instrs[offset];
+}
+
+/* write a private page in place, or copy a single instruction into one */
+ImageView * ImageView_patch(ImageView *self, unsigned address,
+    unsigned binary)
+{
+  ImageInstr instr, *page;
+  ImagePiece *piece;
+  unsigned i, offset;
+
+  if (address >= self->size)
+  {
+    return NULL;
+  }
+  instr.binary = binary;
+  instr.opcode = decode_opcode(binary);
+  i = ImageView_find(self, address, &offset);
+  piece = &self->pieces[i];
+
+  /* already private */
+  if (piece->owned)
+  {
+    piece->instrs[offset] = instr;
+    return self;
+  }
+
+  /* the first of a shared run, after a private page with room */
+  if (! offset && i && self->pieces[i - 1].owned
+      && self->pieces[i - 1].count < IMAGE_PAGE_INSTRS)
+  {
+    self->pieces[i - 1].instrs[self->pieces[i - 1].count++] = instr;
+    piece->instrs++;
+    piece->start++;
+    if (! --piece->count)
+    {
+      ImageView_close(self, i);
+    }
+    return self;
+  }
+
+  /* split the shared run around a new page */
+  if (ImageView_reserve(self, 2) || ! (page = ImageView_page(self)))
+  {
+    return NULL;
+  }
+  page[0] = instr;
+  if (offset)
+  {
+    piece = ImageView_open(self, ++i, 1);
+    piece[0] = piece[-1];
+    piece[-1].count = offset;
+    piece[0].instrs += offset;
+    piece[0].count -= offset;
+  }
+  piece = &self->pieces[i];
+  piece->instrs++;
+  piece->count--;
+  if (! piece->count)
+  {
+    piece->instrs = page;
+    piece->count = 1;
+    piece->owned = 1;
+  }
+  else
+  {
+    piece = ImageView_open(self, i, 1);
+    piece->instrs = page;
+    piece->count = 1;
+    piece->owned = 1;
+  }
+  ImageView_renumber(self, i ? i - 1 : 0);
+
+  return self;
+}
+
+/* insert before the PC, into a private page */
+ImageView * ImageView_push(ImageView *self, unsigned binary)
+{
+  ImageInstr instr, *page;
+  ImagePiece *piece;
+  unsigned i, offset, half;
+
+  if (self->pc > self->size)
+  {
+    return NULL;
+  }
+  instr.binary = binary;
+  instr.opcode = decode_opcode(binary);
+  if (self->pc < self->size)
+  {
+    i = ImageView_find(self, self->pc, &offset);
+  }
+  else
+  {
+    i = self->num_pieces;
+    offset = 0;
+  }
+
+  /* the end of a private page with room just before */
+  if (! offset && i && self->pieces[i - 1].owned
+      && self->pieces[i - 1].count < IMAGE_PAGE_INSTRS)
+  {
+    i--;
+    offset = self->pieces[i].count;
+  }
+
+  /* a private page, split in halves if full */
+  else if (i < self->num_pieces && self->pieces[i].owned)
+  {
+    if (self->pieces[i].count == IMAGE_PAGE_INSTRS)
+    {
+      if (ImageView_reserve(self, 1) || ! (page = ImageView_page(self)))
+      {
+        return NULL;
+      }
+      half = IMAGE_PAGE_INSTRS / 2;
+      piece = ImageView_open(self, i + 1, 1);
+      memcpy(page, piece[-1].instrs + half, half * sizeof(ImageInstr));
+      piece[-1].count = half;
+      piece[0].instrs = page;
+      piece[0].count = half;
+      piece[0].owned = 1;
+      if (offset > half)
+      {
+        i++;
+        offset -= half;
+      }
+    }
+  }
+
+  /* a new private page, splitting a shared run if the PC is inside one */
+  else
+  {
+    if (ImageView_reserve(self, 2) || ! (page = ImageView_page(self)))
+    {
+      return NULL;
+    }
+    if (offset)
+    {
+      piece = ImageView_open(self, ++i, 1);
+      piece[0] = piece[-1];
+      piece[-1].count = offset;
+      piece[0].instrs += offset;
+      piece[0].count -= offset;
+      offset = 0;
+    }
+    piece = ImageView_open(self, i, 1);
+    piece->instrs = page;
+    piece->count = 0;
+    piece->owned = 1;
+  }
+
+  piece = &self->pieces[i];
+  memmove(piece->instrs + offset + 1, piece->instrs + offset,
+      (piece->count - offset) * sizeof(ImageInstr));
+  piece->instrs[offset] = instr;
+  piece->count++;
+  self->size++;
+  ImageView_renumber(self, i);
+
+  return self;
+}
+
+/* remove at the PC, trimming or splitting a shared run without copying */
+ImageView * ImageView_pop(ImageView *self, ImageInstr *popped)
+{
+  ImagePiece *piece;
+  unsigned i, offset;
+
+  if (self->pc >= self->size || ImageView_reserve(self, 1))
+  {
+    return NULL;
+  }
+  i = ImageView_find(self, self->pc, &offset);
+  piece = &self->pieces[i];
+  if (popped)
+  {
+    *popped = piece->instrs[offset];
+  }
+
+  if (piece->owned || offset == piece->count - 1)
+  {
+    memmove(piece->instrs + offset, piece->instrs + offset + 1,
+        (piece->count - offset - 1) * sizeof(ImageInstr));
+    piece->count--;
+  }
+  else if (! offset)
+  {
+    piece->instrs++;
+    piece->count--;
+  }
+  else
+  {
+    piece = ImageView_open(self, i + 1, 1);
+    piece[0] = piece[-1];
+    piece[-1].count = offset;
+    piece[0].instrs += offset + 1;
+    piece[0].count -= offset + 1;
+  }
+
+  if (! self->pieces[i].count)
+  {
+    ImageView_close(self, i);
+  }
+  self->size--;
+  ImageView_renumber(self, i < self->num_pieces ? i : self->num_pieces);
+
+  return self;
+}
+
+/* move the PC to an instruction that exists */
+unsigned ImageView_jump(ImageView *self, unsigned address)
+{
+  const ImageInstr *instr = self->get(self, address);
+
+  if (instr)
+  {
+    self->pc = address;
+    return instr->binary;
+  }
+
+  /* 0xDEXX is the unused instruction, return if something went wrong */
+  return 0x0000DEFF;
+}
+
+/* destructor */
+ImageView * ImageView_free(ImageView *self)
+{
+  while (self->num_pieces)
+  {
+    ImageView_close(self, self->num_pieces - 1);
+  }
+  self->image->release(self->image);
+  free(self->pieces);
+  free(self);
+
+  return NULL;
+}
@@ -0,0 +1,164 @@
+#ifndef __SOFT_STACK_IMAGE
+#define __SOFT_STACK_IMAGE
+
+#include "main.h"
+#include "isa.h"
+
+/** Instructions per private page of an ImageView */
+#define IMAGE_PAGE_INSTRS 64
+
+/** A decoded instruction, as an Image and its views hold them */
+typedef struct _ImageInstr
+{
+  unsigned binary;
+  ThumbISA opcode;
+} ImageInstr;
+
+/**
+ * An Image is a program decoded once and never changed afterwards, shared
+ *  by every ImageView of it. Views hold a reference each, the last release
+ *  frees it.
+ */
+typedef struct _Image
+{
+  /** the decoded instructions, by address */
+  ImageInstr *instrs;
+  size_t count;
+
+  /** references held, 1 for the creator */
+  unsigned refs;
+
+  /**
+   * Take another reference
+   *
+   * @return this Image
+   */
+  struct _Image * (*retain)(struct _Image *self);
+
+  /**
+   * Drop a reference, freeing the Image with the last one
+   *
+   * @return this Image, or NULL once it is freed
+   */
+  struct _Image * (*release)(struct _Image *self);
+
+} Image;
+
+/** A run of consecutive instructions of an ImageView */
+typedef struct _ImagePiece
+{
+  /** the instructions, in the Image or in a private page */
+  ImageInstr *instrs;
+  unsigned count;
+
+  /** address of the first of them */
+  unsigned start;
+
+  /** non-zero if instrs is a private page of IMAGE_PAGE_INSTRS */
+  unsigned owned;
+
+} ImagePiece;
+
+/**
+ * An ImageView is one execution context's program: an Image as far as it
+ *  has not changed it, with a PC and LR of its own. The program is a list
+ *  of pieces, each either a run of the shared Image or a private page.
+ *  A view starts as a single piece, and push, pop and patch split pieces
+ *  and copy into private pages only the instructions they write, so what
+ *  a view costs grows with its changes rather than with the program.
+ */
+typedef struct _ImageView
+{
+  /** the shared Image, which this view holds a reference to */
+  Image *image;
+
+  /** pieces in address order */
+  ImagePiece *pieces;
+  unsigned num_pieces;
+  unsigned max_pieces;
+
+  /** number of instructions */
+  unsigned size;
+
+  /** Program Counter and Link Register, as a Stack keeps them */
+  unsigned pc;
+  unsigned lr;
+
+  /** heap bytes this view holds on its own, the Image not counted */
+  size_t bytes;
+
+  /**
+   * Look an instruction up
+   *
+   * @param address address of the instruction
+   * @return the instruction, or NULL past the end
+   */
+  const ImageInstr * (*get)(struct _ImageView *self, unsigned address);
+
+  /**
+   * Replace an instruction's binary
+   *
+   * @param address address of the instruction
+   * @param binary the new binary
+   * @return this ImageView, or NULL past the end or out of memory, leaving
+   *  the view as it was
+   */
+  struct _ImageView * (*patch)(struct _ImageView *self, unsigned address,
+      unsigned binary);
+
+  /**
+   * Insert an instruction at the PC, as Stack::push does, moving the
+   *  instructions from there on up an address
+   *
+   * @param binary binary of the new instruction
+   * @return this ImageView, or NULL if out of memory, leaving the view as
+   *  it was
+   */
+  struct _ImageView * (*push)(struct _ImageView *self, unsigned binary);
+
+  /**
+   * Remove the instruction at the PC, as Stack::pop does, moving the
+   *  instructions after it down an address
+   *
+   * @param popped the removed instruction is copied here, or NULL
+   * @return this ImageView, or NULL if the PC is past the end or out of
+   *  memory, leaving the view as it was
+   */
+  struct _ImageView * (*pop)(struct _ImageView *self, ImageInstr *popped);
+
+  /**
+   * Move the PC, as Stack::jump does
+   *
+   * @param address an absolute address
+   * @return the binary at that address, or 0x0000DEFF ("unused") if there
+   *  is none, leaving the PC where it was
+   */
+  unsigned (*jump)(struct _ImageView *self, unsigned address);
+
+  /**
+   * Destructor, releases the Image
+   *
+   * @return NULL
+   */
+  struct _ImageView * (*free)(struct _ImageView *self);
+
+} ImageView;
+
+/**
+ * Constructor, decodes a program once
+ *
+ * @param bytes little-endian instruction halfwords
+ * @param count number of halfwords
+ * @return a new Image holding a single reference, or NULL if out of memory
+ */
+Image * newImage(const unsigned char *bytes, size_t count);
+
+/**
+ * Constructor, a view of the whole Image with the PC and LR at 0
+ *
+ * @param image Image to view, which gains a reference
+ * @return a new ImageView, or NULL if out of memory
+ */
+ImageView * newImageView(Image *image);
+
+#endif /* __SOFT_STACK_IMAGE */
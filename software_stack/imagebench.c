@@ -0,0 +1,248 @@
+/*
+ * Measures what a fleet of simulated boards running the same firmware
+ *  costs in memory: one shared Image with an ImageView per board, each
+ *  view making a few random patches, pushes and pops, against a Stack per
+ *  board. The first -v views are checked against a plain array which
+ *  makes the same changes.
+ *
+ * usage: imagebench [-n halfwords] [-i instances] [-p changes per instance]
+ *                   [-s Stacks to measure] [-v instances to check]
+ *
+ * build: cc -O2 -o imagebench imagebench.c image.c stack.c decode.c
+ */
+#include <malloc.h>
+#include "bench.h"
+#include "image.h"
+#include "decode.h"
+#include "stack.h"
+
+/* heap bytes in use */
+static size_t imagebench_heap()
+{
+  return mallinfo2().uordblks;
+}
+
+/* a random change to a view, and the same to its reference if any */
+static int imagebench_change(ImageView *view, unsigned *ref, size_t *size)
+{
+  unsigned binary = bench_random() & 0xFFFF, kind, address;
+  ImageInstr popped;
+
+  kind = bench_random() % 3;
+  address = *size ? bench_random() % (*size + (kind == 1)) : 0;
+  switch (kind)
+  {
+    case 0:
+      if (! *size)
+      {
+        return 0;
+      }
+      if (! view->patch(view, address, binary))
+      {
+        return -1;
+      }
+      if (ref)
+      {
+        ref[address] = binary;
+      }
+      break;
+
+    case 1:
+      view->pc = address;
+      if (! view->push(view, binary))
+      {
+        return -1;
+      }
+      if (ref)
+      {
+        memmove(ref + address + 1, ref + address,
+            (*size - address) * sizeof(unsigned));
+        ref[address] = binary;
+      }
+      ++*size;
+      break;
+
+    default:
+      if (! *size)
+      {
+        return 0;
+      }
+      view->pc = address;
+      if (! view->pop(view, &popped))
+      {
+        return -1;
+      }
+      if (ref)
+      {
+        if (popped.binary != ref[address])
+        {
+          return 1;
+        }
+        memmove(ref + address, ref + address + 1,
+            (*size - address - 1) * sizeof(unsigned));
+      }
+      --*size;
+      break;
+  }
+
+  return 0;
+}
+
+int main(int argc, char **argv)
+{
+  size_t halfwords = 4096, instances = 10000, changes = 8, stacks = 10,
+         checked = 100, i, j, size, viewBytes = 0, heap, stackHeap;
+  unsigned char *image;
+  unsigned *ref = NULL;
+  unsigned long errors = 0, lookups = 0, sum = 0;
+  double started, seconds;
+  const ImageInstr *instr;
+  ImageView **views;
+  Stack **stackp;
+  Image *shared;
+  int a, result;
+
+  /* options */
+  for (a = 1; a + 1 < argc && argv[a][0] == '-'; a += 2)
+  {
+    switch (argv[a][1])
+    {
+      case 'n': halfwords = strtoul(argv[a + 1], NULL, 0);  break;
+      case 'i': instances = strtoul(argv[a + 1], NULL, 0);  break;
+      case 'p': changes   = strtoul(argv[a + 1], NULL, 0);  break;
+      case 's': stacks    = strtoul(argv[a + 1], NULL, 0);  break;
+      case 'v': checked   = strtoul(argv[a + 1], NULL, 0);  break;
+      default:  a = argc;                                   break;
+    }
+  }
+  if (a != argc || ! halfwords || ! instances || ! stacks)
+  {
+    fprintf(stderr, "usage: %s [-n halfwords] [-i instances] "
+        "[-p changes per instance] [-s Stacks to measure] "
+        "[-v instances to check]\n", argv[0]);
+    return 1;
+  }
+
+  if (
+         ! (image = (unsigned char *) malloc(2 * halfwords))
+      || ! (ref = (unsigned *) malloc((halfwords + changes + 1)
+            * sizeof(unsigned)))
+      || ! (views = (ImageView **) calloc(instances, sizeof(ImageView *)))
+      || ! (stackp = (Stack **) calloc(stacks, sizeof(Stack *)))
+      )
+  {
+    fprintf(stderr, "out of memory\n");
+    return 1;
+  }
+  for (i = 0; i < 2 * halfwords; i++)
+  {
+    image[i] = (unsigned char) bench_random();
+  }
+
+  /* a Stack per board */
+  heap = imagebench_heap();
+  for (i = 0; i < stacks; i++)
+  {
+    if (! (stackp[i] = newStack(image, halfwords)))
+    {
+      fprintf(stderr, "out of memory\n");
+      return 1;
+    }
+  }
+  stackHeap = (imagebench_heap() - heap) / stacks;
+  for (i = 0; i < stacks; i++)
+  {
+    stackp[i]->free(stackp[i]);
+  }
+
+  /* one Image, a view per board */
+  heap = imagebench_heap();
+  if (! (shared = newImage(image, halfwords)))
+  {
+    fprintf(stderr, "out of memory\n");
+    return 1;
+  }
+  started = bench_now();
+  for (i = 0; i < instances; i++)
+  {
+    if (! (views[i] = newImageView(shared)))
+    {
+      fprintf(stderr, "out of memory\n");
+      return 1;
+    }
+    for (j = 0; j < halfwords && i < checked; j++)
+    {
+      ref[j] = shared->instrs[j].binary;
+    }
+    for (size = halfwords, j = 0; j < changes; j++)
+    {
+      if ((result = imagebench_change(views[i], i < checked ? ref : NULL,
+              &size)) < 0)
+      {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+      }
+      errors += result;
+    }
+
+    /* every address of a checked view */
+    for (j = 0; i < checked && j < size; j++)
+    {
+      instr = views[i]->get(views[i], j);
+      errors += ! instr || instr->binary != ref[j]
+        || instr->opcode != decode_opcode(ref[j]);
+    }
+    errors += i < checked && (views[i]->size != size
+        || views[i]->get(views[i], size));
+    viewBytes += views[i]->bytes;
+  }
+  seconds = bench_now() - started;
+  heap = imagebench_heap() - heap;
+
+  /* lookups across the fleet */
+  started = bench_now();
+  for (i = 0; i < 1 << 22; i++)
+  {
+    j = bench_random() % instances;
+    if (
+           views[j]->size
+        && (instr = views[j]->get(views[j], bench_random()
+               % views[j]->size))
+        )
+    {
+      sum += instr->opcode;
+      lookups++;
+    }
+  }
+  started = bench_now() - started;
+
+  printf("program           %lu halfwords, %lu changes per instance, %lu "
+      "wrong\n", (unsigned long) halfwords, (unsigned long) changes,
+      errors);
+  printf("Stack             %lu bytes per instance, %.1f MB for %lu\n",
+      (unsigned long) stackHeap, stackHeap * (double) instances / (1 << 20),
+      (unsigned long) instances);
+  printf("Image             %lu bytes shared\n",
+      (unsigned long) (halfwords * sizeof(ImageInstr)));
+  printf("ImageView         %lu bytes per instance, %.1f MB for %lu with "
+      "the Image (heap %.1f MB)\n",
+      (unsigned long) (viewBytes / instances),
+      (viewBytes + halfwords * sizeof(ImageInstr)) / (double) (1 << 20),
+      (unsigned long) instances, heap / (double) (1 << 20));
+  printf("views             %.2f us to build and change each, %.1f ns a "
+      "lookup (%lx)\n", seconds * 1e6 / instances,
+      lookups ? started * 1e9 / lookups : 0,
+      sum);
+
+  for (i = 0; i < instances; i++)
+  {
+    views[i]->free(views[i]);
+  }
+  shared->release(shared);
+  free(stackp);
+  free(views);
+  free(ref);
+  free(image);
+
+  return errors != 0;
+}
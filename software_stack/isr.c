@@ -0,0 +1,124 @@
+#include "isr.h"
+#include "regfile.h"
+
+/* method forward decls */
+unsigned Isr_encode(Isr *self, unsigned binary);
+void Isr_encodeImage(Isr *self, unsigned char *bytes, size_t count);
+Stack * Isr_encodeStack(Isr *self, Stack *stack);
+Isr * Isr_install(Isr *self);
+Isr * Isr_program(Isr *self, u32 base);
+Isr * Isr_free(Isr *self);
+
+/* constructor */
+Isr * newIsr(u32 secret)
+{
+  Isr *self = (Isr *) malloc(sizeof(Isr));
+  u32 state = secret;
+  unsigned i, j;
+  unsigned short swap;
+
+  /* out of memory */
+  if (! self)
+  {
+    return NULL;
+  }
+
+  /* zero */
+  memset(self, 0, sizeof(Isr));
+
+  /* bind methods */
+  self->encode      = Isr_encode;
+  self->encodeImage = Isr_encodeImage;
+  self->encodeStack = Isr_encodeStack;
+  self->install     = Isr_install;
+  self->program     = Isr_program;
+  self->free        = Isr_free;
+  self->secret      = secret;
+
+  /* Fisher-Yates, xorshift seeded by the secret, or the identity */
+  for (i = 0; i < DECODE_INDEX_SIZE; i++)
+  {
+    self->forward[i] = (unsigned short) i;
+  }
+  for (i = DECODE_INDEX_SIZE - 1; secret && i > 0; i--)
+  {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    j = state % (i + 1);
+    swap = self->forward[i];
+    self->forward[i] = self->forward[j];
+    self->forward[j] = swap;
+  }
+  for (i = 0; i < DECODE_INDEX_SIZE; i++)
+  {
+    self->inverse[self->forward[i]] = (unsigned short) i;
+  }
+
+  return self;
+}
+
+/* permute bits 15-6, keep bits 5-0 */
+unsigned Isr_encode(Isr *self, unsigned binary)
+{
+  return (self->forward[(binary & 0xFFFF) >> DECODE_INDEX_SHIFT]
+      << DECODE_INDEX_SHIFT) | (binary & ((1 << DECODE_INDEX_SHIFT) - 1));
+}
+
+/* little-endian halfwords, in place */
+void Isr_encodeImage(Isr *self, unsigned char *bytes, size_t count)
+{
+  unsigned binary;
+  size_t i;
+
+  for (i = 0; i < count; i++)
+  {
+    binary = self->encode(self, bytes[2 * i] | (bytes[2 * i + 1] << 8));
+    bytes[2 * i]     = binary & 0xFF;
+    bytes[2 * i + 1] = (binary >> 8) & 0xFF;
+  }
+}
+
+/* every Instruction from the trunk on */
+Stack * Isr_encodeStack(Isr *self, Stack *stack)
+{
+  Instruction *instruction;
+
+  for (instruction = stack->trunk; instruction; instruction = instruction->next)
+  {
+    instruction->binary = self->encode(self, instruction->binary);
+  }
+
+  return stack;
+}
+
+/* fold the inverse into the decode table */
+Isr * Isr_install(Isr *self)
+{
+  decode_randomize(self->secret ? self->inverse : NULL);
+
+  return self;
+}
+
+/* a word per entry, the last one turns the table on */
+Isr * Isr_program(Isr *self, u32 base)
+{
+  u32 address = base + (REGFILE_USER_BASE + ISR_USER_WORD) * 4;
+  unsigned i;
+
+  for (i = 0; i < DECODE_INDEX_SIZE; i++)
+  {
+    Xil_Out32(address, (i << ISR_LOADED_SHIFT) | self->inverse[i]
+        | (i == DECODE_INDEX_SIZE - 1 && self->secret ? ISR_ENABLE : 0));
+  }
+
+  return self;
+}
+
+/* destructor */
+Isr * Isr_free(Isr *self)
+{
+  free(self);
+
+  return NULL;
+}
@@ -0,0 +1,96 @@
+#ifndef __SOFT_STACK_ISR
+#define __SOFT_STACK_ISR
+
+#include "hal.h"
+#include "decode.h"
+#include "stack.h"
+
+/** User space word of decoder.vhd's table, USR_ISR in reg_file_constants */
+#define ISR_USER_WORD 23
+
+/**
+ * Layout of a write to ISR_USER_WORD, must match decoder.vhd: plain bits
+ *  15-6 in the low bits, the loaded bits 15-6 they sit at from
+ *  ISR_LOADED_SHIFT, and ISR_ENABLE to decode through the table from then on
+ */
+#define ISR_LOADED_SHIFT 16
+#define ISR_ENABLE       0x80000000
+
+/**
+ * An Isr is a per-boot secret permutation of the Thumb opcode space for
+ *  instruction set randomization. Bits 15-6 of every halfword, everything
+ *  any ThumbISA code tests, are permuted as a whole and bits 5-0 are left
+ *  alone. A program only runs if it was encoded with the same secret the
+ *  decoder undoes, so code injected without the secret decodes to garbage.
+ *
+ * Undoing it costs nothing extra: decode_randomize folds the inverse into
+ *  the decode table, and decoder.vhd looks it up in a table of its own
+ *  before decoding, in the same DO_DECODE state.
+ */
+typedef struct _Isr
+{
+  /** secret the permutation came from, 0 for the identity */
+  u32 secret;
+
+  /** loaded bits 15-6 of each plain value, and the other way round */
+  unsigned short forward[DECODE_INDEX_SIZE];
+  unsigned short inverse[DECODE_INDEX_SIZE];
+
+  /**
+   * Randomize a single halfword
+   *
+   * @param binary plain instruction binary
+   * @return the instruction binary to load
+   */
+  unsigned (*encode)(struct _Isr *self, unsigned binary);
+
+  /**
+   * Randomize a raw program image in place, as newStack takes it
+   *
+   * @param bytes little-endian halfwords
+   * @param count number of halfwords
+   */
+  void (*encodeImage)(struct _Isr *self, unsigned char *bytes, size_t count);
+
+  /**
+   * Randomize every Instruction of a Stack, their opcodes stay as they are
+   *
+   * @param stack Stack of plain Instructions
+   * @return stack
+   */
+  Stack * (*encodeStack)(struct _Isr *self, Stack *stack);
+
+  /**
+   * Have decode_opcode, decode_plain and the Decoder undo this permutation
+   *
+   * @return this Isr
+   */
+  struct _Isr * (*install)(struct _Isr *self);
+
+  /**
+   * Load this permutation's inverse into decoder.vhd's table and enable it,
+   *  through the edkregfile user space
+   *
+   * @param base edkregfile base address, XPAR_EDKREGFILE_0_BASEADDR
+   * @return this Isr
+   */
+  struct _Isr * (*program)(struct _Isr *self, u32 base);
+
+  /**
+   * Destructor
+   *
+   * @return NULL
+   */
+  struct _Isr * (*free)(struct _Isr *self);
+
+} Isr;
+
+/**
+ * Constructor, shuffles every value of bits 15-6 seeded by the secret
+ *
+ * @param secret per-boot secret, 0 to leave halfwords as they are
+ * @return a new Isr, or NULL if out of memory
+ */
+Isr * newIsr(u32 secret);
+
+#endif /* __SOFT_STACK_ISR */
@@ -0,0 +1,191 @@
+/*
+ * Measures what instruction set randomization costs to load and to run:
+ *  a random program is loaded into a Stack and bulk decoded plain, then
+ *  again randomized under a secret, after checking both decode the same.
+ *
+ * usage: isrbench [-n halfwords] [-l halfwords per Stack] [-p passes]
+ *                 [-s secret]
+ *
+ * build: cc -O2 -march=native -o isrbench isrbench.c isr.c decode.c stack.c
+ *         hal.c
+ */
+#include "bench.h"
+#include "isr.h"
+
+/* columns of two Decoders, returns the number of halfwords which differ */
+static unsigned long isrbench_compare(Decoder *a, Decoder *b)
+{
+  unsigned long errors = 0;
+  size_t i;
+
+  for (i = 0; i < a->count; i++)
+  {
+    if (
+           a->opcode[i] != b->opcode[i]
+        || a->lo3[i]    != b->lo3[i]
+        || a->mid3[i]   != b->mid3[i]
+        || a->hi3[i]    != b->hi3[i]
+        || a->top3[i]   != b->top3[i]
+        || a->imm5[i]   != b->imm5[i]
+        || a->imm8[i]   != b->imm8[i]
+        || a->h[i]      != b->h[i]
+        || a->imm11[i]  != b->imm11[i]
+        )
+    {
+      errors++;
+    }
+  }
+
+  return errors;
+}
+
+/* load passes Stacks of an image, encoding each first if isr is set */
+static double isrbench_load(Isr *isr, const unsigned char *image,
+    unsigned char *scratch, size_t halfwords, unsigned long passes,
+    unsigned long *sum)
+{
+  double started = bench_now();
+  unsigned long pass;
+  Stack *stack;
+
+  for (pass = 0; pass < passes; pass++)
+  {
+    memcpy(scratch, image, 2 * halfwords);
+    if (isr)
+    {
+      isr->encodeImage(isr, scratch, halfwords);
+    }
+    if ((stack = newStack(scratch, halfwords)))
+    {
+      *sum += stack->trunk->opcode;
+      stack->free(stack);
+    }
+  }
+
+  return (bench_now() - started) / passes / halfwords;
+}
+
+/* bulk decode an image passes times */
+static double isrbench_run(Decoder *decoder, const unsigned char *image,
+    size_t halfwords, unsigned long passes, unsigned long *sum)
+{
+  double started = bench_now();
+  unsigned long pass;
+  size_t at, done;
+
+  for (pass = 0; pass < passes; pass++)
+  {
+    for (at = 0; at < halfwords; at += done)
+    {
+      done = decoder->decode(decoder, image + 2 * at, halfwords - at);
+      *sum += decoder->opcode[done - 1];
+    }
+  }
+
+  return (bench_now() - started) / passes / halfwords;
+}
+
+int main(int argc, char **argv)
+{
+  size_t halfwords = 1 << 20, loaded = 256, i;
+  unsigned long passes = 64, errors = 0, sum = 0;
+  unsigned char *image, *randomized, *scratch;
+  double load[2], run[2];
+  u32 secret = 0xC0DEB007;
+  Decoder *plain, *decoder;
+  Isr *isr;
+  unsigned binary;
+  int a;
+
+  /* options */
+  for (a = 1; a + 1 < argc && argv[a][0] == '-'; a += 2)
+  {
+    switch (argv[a][1])
+    {
+      case 'n': halfwords = strtoul(argv[a + 1], NULL, 0);  break;
+      case 'l': loaded    = strtoul(argv[a + 1], NULL, 0);  break;
+      case 'p': passes    = strtoul(argv[a + 1], NULL, 0);  break;
+      case 's': secret    = strtoul(argv[a + 1], NULL, 0);  break;
+      default:  a = argc;                                   break;
+    }
+  }
+  if (
+         a != argc
+      || ! halfwords
+      || ! loaded
+      || loaded > halfwords
+      || ! passes
+      || ! secret
+      )
+  {
+    fprintf(stderr, "usage: %s [-n halfwords] [-l halfwords per Stack] "
+        "[-p passes] [-s non-zero secret]\n", argv[0]);
+    return 1;
+  }
+
+  if (
+         ! (image = (unsigned char *) malloc(2 * halfwords))
+      || ! (randomized = (unsigned char *) malloc(2 * halfwords))
+      || ! (scratch = (unsigned char *) malloc(2 * loaded))
+      || ! (plain = newDecoder(halfwords))
+      || ! (decoder = newDecoder(halfwords))
+      || ! (isr = newIsr(secret))
+      )
+  {
+    fprintf(stderr, "out of memory\n");
+    return 1;
+  }
+  for (i = 0; i < 2 * halfwords; i++)
+  {
+    image[i] = (unsigned char) bench_random();
+  }
+  memcpy(randomized, image, 2 * halfwords);
+  isr->encodeImage(isr, randomized, halfwords);
+
+  /* every halfword has to come back, and decode as it did plain */
+  plain->decode(plain, image, halfwords);
+  isr->install(isr);
+  for (binary = 0; binary < 0x10000; binary++)
+  {
+    errors += decode_plain(isr->encode(isr, binary)) != binary;
+  }
+  decoder->decode(decoder, randomized, halfwords);
+  errors += isrbench_compare(plain, decoder);
+
+  /* load and run plain, then randomized */
+  decode_randomize(NULL);
+  load[0] = isrbench_load(NULL, image, scratch, loaded, passes, &sum);
+  run[0] = isrbench_run(decoder, image, halfwords, passes, &sum);
+  isr->install(isr);
+  load[1] = isrbench_load(isr, image, scratch, loaded, passes, &sum);
+  run[1] = isrbench_run(decoder, randomized, halfwords, passes, &sum);
+
+  printf("path              %s\n",
+#if defined(__AVX2__)
+      "AVX2"
+#elif defined(__SSE4_1__)
+      "SSE4.1"
+#else
+      "scalar"
+#endif
+      );
+  printf("halfwords         %lu, secret 0x%08X, %lu wrong\n",
+      (unsigned long) halfwords, secret, errors);
+  printf("                  plain      randomized\n");
+  printf("load ns/halfword  %-10.2f %-10.2f %lu halfword Stacks\n",
+      load[0] * 1e9, load[1] * 1e9, (unsigned long) loaded);
+  printf("run ns/halfword   %-10.3f %-10.3f bulk decode\n",
+      run[0] * 1e9, run[1] * 1e9);
+  printf("host              %+.1f%% to load, %+.1f%% to run (%lx)\n",
+      100.0 * (load[1] - load[0]) / load[0],
+      100.0 * (run[1] - run[0]) / run[0], sum);
+
+  isr->free(isr);
+  decoder->free(decoder);
+  plain->free(plain);
+  free(scratch);
+  free(randomized);
+  free(image);
+
+  return errors != 0;
+}
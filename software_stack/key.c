@@ -0,0 +1,196 @@
+#include "key.h"
+
+/* method forward decls */
+u32 KeyModel_read(Device *device, u32 offset);
+void KeyModel_write(Device *device, u32 offset, u32 data);
+KeyModel * KeyModel_reset(KeyModel *self);
+KeyModel * KeyModel_free(KeyModel *self);
+
+/* drive KEY_OUT */
+static void KeyModel_load(Sim *sim, void *owner, u32 key)
+{
+  KeyModel *self = (KeyModel *) owner;
+
+  (void) sim;
+
+  self->key_out = key;
+  if (self->onKey)
+  {
+    self->onKey(self, key);
+  }
+}
+
+/* drive KEY_OUT after a number of clocks */
+static void KeyModel_loadAfter(KeyModel *self, u32 key, SimTime delay)
+{
+  if (! self->sim || ! self->sim->schedule(self->sim, delay, KeyModel_load,
+      self, key))
+  {
+    KeyModel_load(self->sim, self, key);
+  }
+}
+
+/* the key register a control word picks, KEY_NUM_REGS if none */
+static unsigned KeyModel_pick(u32 ctrl)
+{
+  unsigned j;
+
+  if (ctrl & (1 << KEY_ID_NS))
+  {
+    return KEY_ID_NS;
+  }
+
+  /* the highest set bit wins */
+  for (j = KEY_NUM_REGS - 1; j >= KEY_ID_CRIT; j--)
+  {
+    if (ctrl & (1UL << j))
+    {
+      return j;
+    }
+  }
+
+  return KEY_NUM_REGS;
+}
+
+/* constructor */
+KeyModel * newKeyModel(u32 base, Sim *sim)
+{
+  KeyModel *self = (KeyModel *) malloc(sizeof(KeyModel));
+
+  /* out of memory */
+  if (! self)
+  {
+    return NULL;
+  }
+
+  /* zero */
+  memset(self, 0, sizeof(KeyModel));
+
+  /* bind methods */
+  self->device.base  = base;
+  self->device.size  = KEY_SIZE;
+  self->device.read  = KeyModel_read;
+  self->device.write = KeyModel_write;
+  self->reset        = KeyModel_reset;
+  self->free         = KeyModel_free;
+  self->sim          = sim;
+
+  /* the address range is already taken */
+  if (hal_attach(&self->device))
+  {
+    free(self);
+    return NULL;
+  }
+
+  return self;
+}
+
+/* read a key register or a bank register */
+u32 KeyModel_read(Device *device, u32 offset)
+{
+  KeyModel *self = (KeyModel *) device;
+  unsigned reg = offset / 4;
+
+  if (offset < KEY_SOFT_RST_OFFSET)
+  {
+    return reg < KEY_NUM_REGS ? self->regs[reg] : 0;
+  }
+
+  /* nothing readable in the soft reset space */
+  if (offset < KEY_BANK_OFFSET)
+  {
+    return 0;
+  }
+
+  switch ((offset - KEY_BANK_OFFSET) / 4)
+  {
+    case KEY_BANK_INDEX:
+      return self->bank_index;
+
+    case KEY_BANK_DATA:
+      return self->bank[self->bank_index];
+
+    case KEY_BANK_SELECT:
+      return self->bank_select;
+
+    case KEY_BANK_DEPTH_REG:
+      return KEY_BANK_DEPTH;
+
+    default:
+      return 0;
+  }
+}
+
+/* write a key register, the control word, or a bank register */
+void KeyModel_write(Device *device, u32 offset, u32 data)
+{
+  KeyModel *self = (KeyModel *) device;
+  unsigned reg = offset / 4, picked;
+
+  if (offset < KEY_SOFT_RST_OFFSET)
+  {
+    if (reg >= KEY_NUM_REGS)
+    {
+      return;
+    }
+
+    /* the control word loads KEY_OUT from the registers as they were */
+    if (! reg && (picked = KeyModel_pick(data)) < KEY_NUM_REGS)
+    {
+      KeyModel_loadAfter(self, self->regs[picked], 1);
+    }
+    self->regs[reg] = data;
+    return;
+  }
+
+  /* soft reset */
+  if (offset < KEY_BANK_OFFSET)
+  {
+    if (data == KEY_SOFT_RESET)
+    {
+      self->reset(self);
+    }
+    return;
+  }
+
+  switch ((offset - KEY_BANK_OFFSET) / 4)
+  {
+    case KEY_BANK_INDEX:
+      self->bank_index = data % KEY_BANK_DEPTH;
+      break;
+
+    case KEY_BANK_DATA:
+      self->bank[self->bank_index] = data;
+      self->bank_index = (self->bank_index + 1) % KEY_BANK_DEPTH;
+      break;
+
+    case KEY_BANK_SELECT:
+      self->bank_select = data % KEY_BANK_DEPTH;
+      KeyModel_loadAfter(self, self->bank[self->bank_select], 2);
+      break;
+
+    default:
+      break;
+  }
+}
+
+/* zero the registers, KEY_OUT and the bank contents are left alone */
+KeyModel * KeyModel_reset(KeyModel *self)
+{
+  memset(self->regs, 0, sizeof(self->regs));
+  self->bank_index = self->bank_select = 0;
+
+  return self;
+}
+
+/* destructor */
+KeyModel * KeyModel_free(KeyModel *self)
+{
+  if (self)
+  {
+    hal_detach(&self->device);
+    free(self);
+  }
+
+  return NULL;
+}
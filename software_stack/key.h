@@ -0,0 +1,93 @@
+#ifndef __SOFT_STACK_KEY
+#define __SOFT_STACK_KEY
+
+#include "sim.h"
+
+/** Number of key registers, register 0 being the control word */
+#define KEY_NUM_REGS 32
+
+/** Bytes decoded by a trusted_key: keys, soft reset, then the key bank */
+#define KEY_SIZE 0x400
+
+/** Soft reset space, and the value which triggers a reset */
+#define KEY_SOFT_RST_OFFSET 0x100
+#define KEY_SOFT_RESET      0x0000000A
+
+/** Key bank space, and its depth, C_KEY_BANK_DEPTH in the mpd */
+#define KEY_BANK_OFFSET 0x200
+#define KEY_BANK_DEPTH  256
+
+/** Control word bits, must match C_ID_* in trusted_key's user_logic.vhd */
+#define KEY_ID_NS   3
+#define KEY_ID_CRIT 4
+
+/** Key bank registers, must match key_bank.vhd */
+typedef enum _KeyBankReg
+{
+  KEY_BANK_INDEX = 0,
+  KEY_BANK_DATA,
+  KEY_BANK_SELECT,
+  KEY_BANK_DEPTH_REG
+} KeyBankReg;
+
+/**
+ * A KeyModel models trusted_key: the key registers, the control word
+ *  which picks one of them for KEY_OUT, and the key bank. As in hardware,
+ *  KEY_OUT follows a control word write 1 clock later, and a bank
+ *  selection 2 clocks later.
+ */
+typedef struct _KeyModel
+{
+  /** bus model view of this KeyModel, must stay the first member */
+  Device device;
+
+  /** key registers, register 0 being the control word */
+  u32 regs[KEY_NUM_REGS];
+
+  /** KEY_OUT */
+  u32 key_out;
+
+  /** key bank, with its software and selection indices */
+  u32 bank[KEY_BANK_DEPTH];
+  unsigned bank_index;
+  unsigned bank_select;
+
+  /** kernel timing KEY_OUT changes, or NULL to change at once */
+  Sim *sim;
+
+  /** model on the other side of KEY_OUT, handed back to onKey */
+  void *owner;
+
+  /**
+   * Called whenever KEY_OUT is loaded, or NULL
+   *
+   * @param key the new KEY_OUT
+   */
+  void (*onKey)(struct _KeyModel *self, u32 key);
+
+  /**
+   * Zero every register and the bank indices, as the soft reset does
+   *
+   * @return this KeyModel
+   */
+  struct _KeyModel * (*reset)(struct _KeyModel *self);
+
+  /**
+   * Destructor, detaches this KeyModel from the bus model
+   *
+   * @return NULL
+   */
+  struct _KeyModel * (*free)(struct _KeyModel *self);
+
+} KeyModel;
+
+/**
+ * Constructor, attaches the new KeyModel to the bus model
+ *
+ * @param base base address, XPAR_TRUSTED_KEY_0_BASEADDR on the ZedBoard
+ * @param sim kernel timing KEY_OUT changes, or NULL
+ * @return a new KeyModel, or NULL if out of memory or base is taken
+ */
+KeyModel * newKeyModel(u32 base, Sim *sim);
+
+#endif /* __SOFT_STACK_KEY */
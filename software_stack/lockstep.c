@@ -0,0 +1,778 @@
+/*
+ * Differential tester for simple_processor's data processing path.
+ *
+ * Runs random programs of Thumb formats 1 to 5 through the architectural
+ *  model and the RTL model in lockstep, comparing r0-r12 and the N, Z, C
+ *  and V flags after every instruction. The RTL model is core.c's C
+ *  transcription of decoder.vhd, muxer.vhd and alu.vhd, not the VHDL
+ *  itself run under a simulator, so it finds what the transcription
+ *  shows and no more. Workers are forked across cores,
+ *  each taking every j'th program. A mismatch is shrunk by dropping
+ *  instructions and simplifying the starting registers and flags while
+ *  the cores still disagree, then printed with the seed that generated
+ *  it, so -s <seed> -n 1 reruns it.
+ *
+ * The RTL is known to differ from the architecture in the ways
+ *  lockstep_expect applies to the architecture's results. Every
+ *  mismatch is counted as one, and fails the run, but those whose every
+ *  register, flag and fault are what lockstep_expect predicts are
+ *  counted as known quirks too. With -k 1 those instead put the RTL
+ *  model back in step with the architectural one and the program
+ *  carries on, so only new divergences are mismatches. The exit status
+ *  is 1 if there were any mismatches.
+ *
+ * usage: lockstep [-n programs] [-l length] [-s first seed] [-j workers]
+ *                 [-o opcode mask] [-f flags] [-r reproducers per worker]
+ *                 [-k 0|1]
+ *  -o is a hex mask of the opcodes.vhd numbers to generate, all 30 by
+ *     default, e.g. -o 0x3FFFFFF8 leaves out the shifts by immediate
+ *  -f is which flags to compare, "nzcv" by default, "-" for none
+ *  -k 1 steps over the known quirks rather than reporting them
+ *
+ * build: cc -O2 -I . -o lockstep lockstep.c core.c
+ */
+#include "bench.h"
+#include "core.h"
+
+/* longest program */
+#define LOCKSTEP_MAX_LENGTH 256
+
+/* registers compared, r13-r15 are never touched */
+#define LOCKSTEP_NUM_REGS 13
+
+/* flags compared */
+#define LOCKSTEP_N 1
+#define LOCKSTEP_Z 2
+#define LOCKSTEP_C 4
+#define LOCKSTEP_V 8
+
+/* 32-bit word sign extended to 64 bits, as alu.vhd's a_se and b_se */
+#define LOCKSTEP_SE(x) \
+  ((unsigned long long) (x) | ((x) >> 31 ? 0xFFFFFFFF00000000ULL : 0))
+
+/* a random program and where it starts from */
+typedef struct _LockstepProgram
+{
+  unsigned long seed;
+  CoreState init;
+  unsigned code[LOCKSTEP_MAX_LENGTH];
+  unsigned length;
+} LockstepProgram;
+
+/* what a worker hands back to the parent */
+typedef struct _LockstepStats
+{
+  unsigned long programs;
+  unsigned long long instructions;
+  unsigned long long known;
+  unsigned long mismatches;
+  unsigned long quirks;
+  unsigned long faults;
+
+  /* instruction each mismatch first shows on */
+  unsigned long by_opcode[CORE_NUM_OPCODES];
+} LockstepStats;
+
+/* configuration */
+static unsigned long lockstep_programs = 100000;
+static unsigned lockstep_length = 32;
+static unsigned long lockstep_seed = 1;
+static unsigned lockstep_opcodes = (1U << CORE_NUM_OPCODES) - 1;
+static unsigned lockstep_flags = LOCKSTEP_N | LOCKSTEP_Z | LOCKSTEP_C
+  | LOCKSTEP_V;
+static unsigned lockstep_reproducers = 1;
+static int lockstep_useKnown = 0;
+
+/* the cores, one pair per worker */
+static Core *lockstep_thumb;
+static Core *lockstep_rtl;
+
+/* xorshift, seeded per program so any program can be regenerated */
+static u32 lockstep_random(u32 *state)
+{
+  *state ^= *state << 13;
+  *state ^= *state >> 17;
+  *state ^= *state << 5;
+
+  return *state;
+}
+
+/* a register value, weighted toward the corners */
+static u32 lockstep_value(u32 *state)
+{
+  u32 r = lockstep_random(state);
+
+  switch (r & 7)
+  {
+    case 0:  return 0;
+    case 1:  return (r >> 3) & 31;
+    case 2:  return 0x80000000;
+    case 3:  return 0x7FFFFFFF;
+    case 4:  return 0xFFFFFFFF;
+    case 5:  return (r >> 3) & 0x3F ? 1U << ((r >> 3) & 31) : 32;
+    default: return lockstep_random(state);
+  }
+}
+
+/* an instruction decoding to a given opcode */
+static unsigned lockstep_instruction(u32 *state, CoreOpcode op)
+{
+  unsigned mask, value, instruction;
+
+  /* the bits selecting the opcode, as decoder.vhd tests them */
+  if (op <= CORE_ASR_RD_RM_I)
+  {
+    mask  = 0xF800;
+    value = op << 11;
+  }
+  else if (op <= CORE_SUB_RD_RN_I)
+  {
+    mask  = 0xFE00;
+    value = 0x1800 | (op - CORE_ADD_RD_RM_RN) << 9;
+  }
+  else if (op <= CORE_SUB_RD_I)
+  {
+    mask  = 0xF800;
+    value = 0x2000 | (op - CORE_MOV_RD_I) << 11;
+  }
+  else if (op <= CORE_MVN_RD_RM)
+  {
+    mask  = 0xFFC0;
+    value = 0x4000 | (op - CORE_AND_RD_RM) << 6;
+  }
+  else
+  {
+    mask  = 0xFF00;
+    value = 0x4400 | (op - CORE_ADD_RD_RM) << 8;
+  }
+
+  /* high register forms need a legal pair of registers */
+  do
+  {
+    instruction = (lockstep_random(state) & ~mask & 0xFFFF) | value;
+  }
+  while (core_opcode(instruction) != op);
+
+  return instruction;
+}
+
+/* build the program for a seed */
+static void lockstep_generate(LockstepProgram *program, unsigned long seed)
+{
+  u32 state = (u32) (seed * 0x9E3779B9UL) ^ 0x2545F491;
+  unsigned i, op;
+
+  if (! state)
+  {
+    state = 1;
+  }
+
+  memset(program, 0, sizeof(LockstepProgram));
+  program->seed = seed;
+  for (i = 0; i < LOCKSTEP_NUM_REGS; i++)
+  {
+    program->init.r[i] = lockstep_value(&state);
+  }
+  op = lockstep_random(&state);
+  program->init.n = op & 1;
+  program->init.z = (op >> 1) & 1;
+  program->init.c = (op >> 2) & 1;
+  program->init.v = (op >> 3) & 1;
+
+  program->length = lockstep_length;
+  for (i = 0; i < program->length; i++)
+  {
+    do
+    {
+      op = lockstep_random(&state) % CORE_NUM_OPCODES;
+    }
+    while (! (lockstep_opcodes & (1U << op)));
+    program->code[i] = lockstep_instruction(&state, (CoreOpcode) op);
+  }
+}
+
+/* flags which differ, as LOCKSTEP_ bits */
+static unsigned lockstep_flagsDiffer(CoreState *a, CoreState *b)
+{
+  return ((a->n != b->n) * LOCKSTEP_N | (a->z != b->z) * LOCKSTEP_Z
+      | (a->c != b->c) * LOCKSTEP_C | (a->v != b->v) * LOCKSTEP_V)
+    & lockstep_flags;
+}
+
+/* non-zero if two states differ in r0-r12 or the flags compared */
+static int lockstep_differ(CoreState *a, CoreState *b)
+{
+  unsigned i;
+
+  for (i = 0; i < LOCKSTEP_NUM_REGS; i++)
+  {
+    if (a->r[i] != b->r[i])
+    {
+      return 1;
+    }
+  }
+
+  return lockstep_flagsDiffer(a, b) != 0;
+}
+
+/* set N and Z from a result */
+static u32 lockstep_nz(CoreState *state, u32 result)
+{
+  state->n = result >> 31;
+  state->z = ! result;
+
+  return result;
+}
+
+/*
+ * alu.vhd's sum or difference of a and b, wide: N and Z from the low
+ *  word, C set by any bit above it rather than the carry out, and V
+ *  cleared on a signed overflow and set otherwise
+ */
+static u32 lockstep_sum(CoreState *state, u32 a, u32 b,
+    unsigned long long wide, int subtract)
+{
+  u32 result = lockstep_nz(state, (u32) wide);
+
+  state->c = (wide >> 32) != 0;
+  state->v = ! (((subtract ? (a ^ b) : ~(a ^ b)) & (a ^ result)) >> 31);
+
+  return result;
+}
+
+/*
+ * a shift as alu.vhd slices it, by all of amount rather than its low
+ *  byte, C set by any bit shifted out rather than the last of them
+ */
+static CoreStatus lockstep_slice(CoreState *state, CoreOpcode kind, u32 a,
+    u32 amount, u32 *result)
+{
+  unsigned long long out = a & ((1ULL << (amount & 63)) - 1);
+
+  /* slicing past the operand stops the simulator */
+  if (amount > 32)
+  {
+    return CORE_FAULT;
+  }
+
+  switch (kind)
+  {
+    case CORE_LSL_RD_RS:
+      out = amount ? (unsigned long long) a >> (32 - amount) : 0;
+      *result = (u32) ((unsigned long long) a << amount);
+      break;
+    case CORE_LSR_RD_RS:
+      *result = (u32) ((unsigned long long) a >> amount);
+      break;
+    case CORE_ASR_RD_RS:
+      *result = (u32) (LOCKSTEP_SE(a) >> amount);
+      break;
+    default:
+      *result = amount % 32 ? (a >> amount % 32) | (a << (32 - amount % 32))
+        : a;
+      break;
+  }
+  state->c = out != 0;
+  lockstep_nz(state, *result);
+
+  return CORE_OK;
+}
+
+/*
+ * What the RTL is known to make of an instruction: the architecture's
+ *  results in 'expect', with each quirk of decoder.vhd, muxer.vhd and
+ *  alu.vhd applied to the registers and flags it changes. Everything
+ *  else stays as the architecture has it, so the RTL has to agree.
+ *
+ * @return the status expected of the RTL, 'expect' being 'before' if it
+ *  is CORE_FAULT
+ */
+static CoreStatus lockstep_expect(unsigned instruction,
+    const CoreState *before, CoreState *expect)
+{
+  const u32 *r = before->r;
+  CoreOpcode op = core_opcode(instruction);
+  unsigned rd = instruction & 7;
+  unsigned rm = (instruction >> 3) & 7;
+  unsigned rn = (instruction >> 6) & 7;
+  unsigned r8 = (instruction >> 8) & 7;
+  unsigned h1 = (instruction >> 4) & 8;
+  u32 imm8 = instruction & 0xFF, sx8 = imm8 | (imm8 & 0x80 ? ~0xFFU : 0);
+  u32 a, b, v = expect->v;
+  CoreStatus status = CORE_OK;
+
+  switch (op)
+  {
+    /* the amount is the whole low byte, sign extended, not the 5 bit
+       field, and #0 stays 0 rather than meaning 32 */
+    case CORE_LSL_RD_RM_I:
+    case CORE_LSR_RD_RM_I:
+    case CORE_ASR_RD_RM_I:
+      status = lockstep_slice(expect, (CoreOpcode) (op + CORE_LSL_RD_RS),
+          r[rm], sx8, &expect->r[rd]);
+      break;
+
+    /* C and V as lockstep_sum, and SUB takes Rm from Rn */
+    case CORE_ADD_RD_RM_RN:
+      expect->r[rd] = lockstep_sum(expect, r[rn], r[rm],
+          LOCKSTEP_SE(r[rn]) + LOCKSTEP_SE(r[rm]), 0);
+      break;
+    case CORE_SUB_RD_RM_RN:
+      expect->r[rd] = lockstep_sum(expect, r[rn], r[rm],
+          LOCKSTEP_SE(r[rn]) - LOCKSTEP_SE(r[rm]), 1);
+      break;
+
+    /* the immediate is the whole low byte, sign extended, not the 3 or 8
+       bit field, and MOV adds it to Rd without touching V */
+    case CORE_ADD_RD_RN_I:
+      expect->r[rd] = lockstep_sum(expect, r[rm], sx8,
+          LOCKSTEP_SE(r[rm]) + LOCKSTEP_SE(sx8), 0);
+      break;
+    case CORE_SUB_RD_RN_I:
+      expect->r[rd] = lockstep_sum(expect, r[rm], sx8,
+          LOCKSTEP_SE(r[rm]) - LOCKSTEP_SE(sx8), 1);
+      break;
+    case CORE_MOV_RD_I:
+      expect->r[r8] = lockstep_sum(expect, r[r8], sx8,
+          LOCKSTEP_SE(r[r8]) + LOCKSTEP_SE(sx8), 0);
+      expect->v = v;
+      break;
+    case CORE_ADD_RD_I:
+      expect->r[r8] = lockstep_sum(expect, r[r8], sx8,
+          LOCKSTEP_SE(r[r8]) + LOCKSTEP_SE(sx8), 0);
+      break;
+    case CORE_SUB_RD_I:
+      expect->r[r8] = lockstep_sum(expect, r[r8], sx8,
+          LOCKSTEP_SE(r[r8]) - LOCKSTEP_SE(sx8), 1);
+      break;
+
+    /* CMP's immediate is not sign extended, only its C and V differ */
+    case CORE_CMP_RN_I:
+      lockstep_sum(expect, r[r8], imm8, LOCKSTEP_SE(r[r8]) - imm8, 1);
+      break;
+
+    /* AND and EOR are among the additions, clearing C and setting V */
+    case CORE_AND_RD_RM:
+      lockstep_sum(expect, r[rd], r[rm], r[rd] & r[rm], 0);
+      break;
+    case CORE_EOR_RD_RM:
+      lockstep_sum(expect, r[rd], r[rm], r[rd] ^ r[rm], 0);
+      break;
+
+    /* shifting by all of Rs, see lockstep_slice */
+    case CORE_LSL_RD_RS:
+    case CORE_LSR_RD_RS:
+    case CORE_ASR_RD_RS:
+    case CORE_ROR_RD_RS:
+      status = lockstep_slice(expect, op, r[rd], r[rm], &expect->r[rd]);
+      break;
+
+    /* C and V as lockstep_sum */
+    case CORE_ADC_RD_RM:
+      expect->r[rd] = lockstep_sum(expect, r[rd], r[rm],
+          LOCKSTEP_SE(r[rd]) + LOCKSTEP_SE(r[rm]) + before->c, 0);
+      break;
+    case CORE_SBC_RD_RM:
+      expect->r[rd] = lockstep_sum(expect, r[rd], r[rm],
+          LOCKSTEP_SE(r[rd]) + ~LOCKSTEP_SE(r[rm]) + before->c, 1);
+      break;
+    case CORE_CMP_RM_RN:
+      lockstep_sum(expect, r[rd], r[rm],
+          LOCKSTEP_SE(r[rd]) - LOCKSTEP_SE(r[rm]), 1);
+      break;
+    case CORE_CMP_RM_RN_2:
+      a = r[rd | h1];
+      b = r[rm | ((instruction >> 3) & 8)];
+      lockstep_sum(expect, a, b, LOCKSTEP_SE(a) - LOCKSTEP_SE(b), 1);
+      break;
+
+    /* and CMN's V is a subtraction's */
+    case CORE_CMN_RM_RN:
+      lockstep_sum(expect, r[rd], r[rm],
+          LOCKSTEP_SE(r[rd]) + LOCKSTEP_SE(r[rm]), 1);
+      break;
+
+    /* NEG negates Rd rather than Rm, with V from Rd and Rm */
+    case CORE_NEG_RD_RM:
+      expect->r[rd] = lockstep_sum(expect, r[rd], r[rm],
+          ~LOCKSTEP_SE(r[rd]) + 1, 0);
+      break;
+
+    /* MVN negates Rd rather than inverting Rm, flags but N and Z alone */
+    case CORE_MVN_RD_RM:
+      expect->r[rd] = lockstep_nz(expect, - r[rd]);
+      break;
+
+    /* ORR and MUL set C, from both sign bits or the high word */
+    case CORE_ORR_RD_RM:
+      expect->c = (r[rd] & r[rm]) >> 31;
+      break;
+    case CORE_MUL_RD_RM:
+      expect->c = ((unsigned long long) r[rd] * r[rm] >> 32) != 0;
+      break;
+
+    /* BIC clears C and never writes its result back */
+    case CORE_BIC_RM_RN:
+      expect->r[rd] = r[rd];
+      expect->c = 0;
+      break;
+
+    /* the high ADD and MOV add Rm to r0 or r8 rather than to Rd */
+    case CORE_ADD_RD_RM:
+    case CORE_MOV_RD_RM:
+      expect->r[rd | h1] = r[h1] + r[rm | ((instruction >> 3) & 8)];
+      break;
+
+    /* TST agrees */
+    default:
+      break;
+  }
+
+  if (status == CORE_FAULT)
+  {
+    *expect = *before;
+  }
+
+  return status;
+}
+
+/*
+ * run in lockstep, returns the index of the first mismatch or -1, 'quirk'
+ *  if not NULL set to whether it is a known one, and with -k 1 known
+ *  divergences being stepped over and added to 'known' if not NULL
+ */
+static int lockstep_run(LockstepProgram *program,
+    CoreStatus *thumb_status, CoreStatus *rtl_status,
+    unsigned long long *known, int *quirk)
+{
+  CoreState *a = &lockstep_thumb->state, *b = &lockstep_rtl->state;
+  CoreState before, expect;
+  unsigned i;
+  int explained;
+
+  *a = program->init;
+  *b = program->init;
+  for (i = 0; i < program->length; i++)
+  {
+    before = *a;
+    *thumb_status = lockstep_thumb->step(lockstep_thumb, program->code[i]);
+    *rtl_status = lockstep_rtl->step(lockstep_rtl, program->code[i]);
+    if (*thumb_status == *rtl_status && ! lockstep_differ(a, b))
+    {
+      continue;
+    }
+
+    /* known if the RTL did exactly what its quirks predict */
+    expect = *a;
+    explained = *thumb_status == CORE_OK
+      && lockstep_expect(program->code[i], &before, &expect) == *rtl_status
+      && ! lockstep_differ(&expect, b);
+    if (explained && lockstep_useKnown)
+    {
+      *b = *a;
+      if (known)
+      {
+        (*known)++;
+      }
+      continue;
+    }
+
+    if (quirk)
+    {
+      *quirk = explained;
+    }
+    return (int) i;
+  }
+
+  return -1;
+}
+
+/* shrink a failing program, returns the index it fails at */
+static int lockstep_shrink(LockstepProgram *program)
+{
+  LockstepProgram trial;
+  CoreStatus thumb_status, rtl_status;
+  int failed = lockstep_run(program, &thumb_status, &rtl_status, NULL, NULL);
+  unsigned i, bit;
+  u32 *flag[4];
+
+  /* nothing after the failure matters */
+  program->length = failed + 1;
+
+  /* drop every instruction the failure does not need */
+  for (i = 0; i + 1 < program->length; )
+  {
+    trial = *program;
+    memmove(&trial.code[i], &trial.code[i + 1],
+        sizeof(unsigned) * (trial.length - i - 1));
+    trial.length--;
+    if (
+           (failed = lockstep_run(&trial, &thumb_status, &rtl_status, NULL,
+               NULL))
+        >= 0
+        )
+    {
+      trial.length = failed + 1;
+      *program = trial;
+    }
+    else
+    {
+      i++;
+    }
+  }
+
+  /* zero registers, or failing that clear as many bits as possible */
+  for (i = 0; i < LOCKSTEP_NUM_REGS; i++)
+  {
+    trial = *program;
+    trial.init.r[i] = 0;
+    if (lockstep_run(&trial, &thumb_status, &rtl_status, NULL, NULL) >= 0)
+    {
+      *program = trial;
+      continue;
+    }
+    for (bit = 32; bit-- > 0; )
+    {
+      if (! (program->init.r[i] & (1U << bit)))
+      {
+        continue;
+      }
+      trial = *program;
+      trial.init.r[i] &= ~(1U << bit);
+      if (lockstep_run(&trial, &thumb_status, &rtl_status, NULL, NULL) >= 0)
+      {
+        *program = trial;
+      }
+    }
+  }
+
+  /* and clear flags */
+  for (i = 0; i < 4; i++)
+  {
+    trial = *program;
+    flag[0] = &trial.init.n;
+    flag[1] = &trial.init.z;
+    flag[2] = &trial.init.c;
+    flag[3] = &trial.init.v;
+    if (*flag[i])
+    {
+      *flag[i] = 0;
+      if (lockstep_run(&trial, &thumb_status, &rtl_status, NULL, NULL) >= 0)
+      {
+        *program = trial;
+      }
+    }
+  }
+
+  return lockstep_run(program, &thumb_status, &rtl_status, NULL, NULL);
+}
+
+/* print a shrunk failure in a single write, workers share stdout */
+static void lockstep_report(LockstepProgram *program, int failed)
+{
+  static const char *status[] = { "ok", "undefined", "fault" };
+  CoreState *a = &lockstep_thumb->state, *b = &lockstep_rtl->state;
+  CoreStatus thumb_status, rtl_status;
+  char text[4096];
+  int used = 0;
+  unsigned i, differ;
+
+  used += snprintf(text + used, sizeof(text) - used,
+      "seed %lu: mismatch after %d instruction%s\n  start",
+      program->seed, failed + 1, failed ? "s" : "");
+  for (i = 0; i < LOCKSTEP_NUM_REGS; i++)
+  {
+    if (program->init.r[i])
+    {
+      used += snprintf(text + used, sizeof(text) - used, " r%u=0x%X", i,
+          program->init.r[i]);
+    }
+  }
+  used += snprintf(text + used, sizeof(text) - used,
+      " nzcv=%u%u%u%u, other registers 0\n", program->init.n,
+      program->init.z, program->init.c, program->init.v);
+  for (i = 0; i < program->length; i++)
+  {
+    used += snprintf(text + used, sizeof(text) - used, "  %3u: %04X  %s\n",
+        i, program->code[i], core_opcodeNames[core_opcode(program->code[i])]);
+  }
+
+  /* rerun to leave both cores at the failure */
+  lockstep_run(program, &thumb_status, &rtl_status, NULL, NULL);
+  used += snprintf(text + used, sizeof(text) - used, "  %-5s %s",
+      lockstep_thumb->name, status[thumb_status]);
+  used += snprintf(text + used, sizeof(text) - used, ", %s %s\n",
+      lockstep_rtl->name, status[rtl_status]);
+  for (i = 0; i < LOCKSTEP_NUM_REGS; i++)
+  {
+    if (a->r[i] != b->r[i])
+    {
+      used += snprintf(text + used, sizeof(text) - used,
+          "  r%-4u 0x%08X 0x%08X\n", i, a->r[i], b->r[i]);
+    }
+  }
+  if ((differ = lockstep_flagsDiffer(a, b)))
+  {
+    used += snprintf(text + used, sizeof(text) - used,
+        "  nzcv  %u%u%u%u       %u%u%u%u\n", a->n, a->z, a->c, a->v,
+        b->n, b->z, b->c, b->v);
+  }
+
+  if (write(1, text, used < (int) sizeof(text) ? (size_t) used
+        : sizeof(text) - 1) < 0)
+  {
+    perror("write");
+  }
+}
+
+/* a worker, taking programs first, first + step, ... */
+static void lockstep_work(unsigned long first, unsigned long step,
+    void *report, void *context)
+{
+  LockstepStats *stats = (LockstepStats *) report;
+  LockstepProgram program;
+  CoreStatus thumb_status, rtl_status;
+  unsigned long i;
+  int failed, quirk;
+
+  for (i = first; i < lockstep_programs; i += step)
+  {
+    lockstep_generate(&program, lockstep_seed + i);
+    failed = lockstep_run(&program, &thumb_status, &rtl_status,
+        &stats->known, &quirk);
+    stats->programs++;
+    stats->instructions += failed < 0 ? program.length : (unsigned) failed + 1;
+    if (failed < 0)
+    {
+      continue;
+    }
+
+    stats->mismatches++;
+    stats->quirks += quirk;
+    stats->by_opcode[core_opcode(program.code[failed])]++;
+    if (rtl_status == CORE_FAULT || thumb_status == CORE_FAULT)
+    {
+      stats->faults++;
+    }
+
+    /* only the failures printed are worth shrinking */
+    if (stats->mismatches <= lockstep_reproducers)
+    {
+      lockstep_report(&program, lockstep_shrink(&program));
+    }
+  }
+  (void) context;
+}
+
+/* add a worker's stats to the total */
+static void lockstep_gather(unsigned long w, const void *report,
+    void *context)
+{
+  const LockstepStats *stats = (const LockstepStats *) report;
+  LockstepStats *total = (LockstepStats *) context;
+  int i;
+
+  total->programs     += stats->programs;
+  total->instructions += stats->instructions;
+  total->known        += stats->known;
+  total->mismatches   += stats->mismatches;
+  total->quirks       += stats->quirks;
+  total->faults       += stats->faults;
+  for (i = 0; i < CORE_NUM_OPCODES; i++)
+  {
+    total->by_opcode[i] += stats->by_opcode[i];
+  }
+  (void) w;
+}
+
+int main(int argc, char **argv)
+{
+  LockstepStats total;
+  unsigned long workers = sysconf(_SC_NPROCESSORS_ONLN);
+  int i, failed;
+  double started, seconds;
+  const char *f;
+
+  /* options */
+  for (i = 1; i + 1 < argc && argv[i][0] == '-'; i += 2)
+  {
+    switch (argv[i][1])
+    {
+      case 'n': lockstep_programs = strtoul(argv[i + 1], NULL, 0);     break;
+      case 'l': lockstep_length = strtoul(argv[i + 1], NULL, 0);       break;
+      case 's': lockstep_seed = strtoul(argv[i + 1], NULL, 0);         break;
+      case 'j': workers = strtoul(argv[i + 1], NULL, 0);               break;
+      case 'o': lockstep_opcodes = strtoul(argv[i + 1], NULL, 16);     break;
+      case 'r': lockstep_reproducers = strtoul(argv[i + 1], NULL, 0);  break;
+      case 'k': lockstep_useKnown = atoi(argv[i + 1]);                 break;
+      case 'f':
+        lockstep_flags = 0;
+        for (f = argv[i + 1]; *f; f++)
+        {
+          lockstep_flags |= (*f == 'n') * LOCKSTEP_N | (*f == 'z') * LOCKSTEP_Z
+            | (*f == 'c') * LOCKSTEP_C | (*f == 'v') * LOCKSTEP_V;
+        }
+        break;
+      default:  i = argc;                                               break;
+    }
+  }
+  lockstep_opcodes &= (1U << CORE_NUM_OPCODES) - 1;
+  if (
+         i != argc
+      || ! lockstep_length
+      || lockstep_length > LOCKSTEP_MAX_LENGTH
+      || ! lockstep_opcodes
+      || ! workers
+      )
+  {
+    fprintf(stderr, "usage: %s [-n programs] [-l length <= %u] "
+        "[-s first seed] [-j workers] [-o opcode mask] [-f flags] "
+        "[-r reproducers per worker] [-k 0|1]\n", argv[0],
+        LOCKSTEP_MAX_LENGTH);
+    return 1;
+  }
+
+  if (
+         ! (lockstep_thumb = newThumbCore())
+      || ! (lockstep_rtl = newRtlCore())
+      )
+  {
+    fprintf(stderr, "out of memory\n");
+    return 1;
+  }
+
+  /* each worker reports back its stats */
+  memset(&total, 0, sizeof(total));
+  started = bench_now();
+  failed = bench_fork(workers, sizeof(LockstepStats), lockstep_work,
+      lockstep_gather, &total);
+  seconds = bench_now() - started;
+  if (failed)
+  {
+    return 1;
+  }
+
+  printf("programs          %lu, %lu workers\n", total.programs, workers);
+  printf("instructions      %llu\n", total.instructions);
+  if (lockstep_useKnown)
+  {
+    printf("known             %llu divergences, back in step after each\n",
+        total.known);
+  }
+  printf("mismatches        %lu, %lu of them known quirks, %lu RTL faults\n",
+      total.mismatches, total.quirks, total.faults);
+  for (i = 0; i < CORE_NUM_OPCODES; i++)
+  {
+    if (total.by_opcode[i])
+    {
+      printf("  %-15s %lu\n", core_opcodeNames[i], total.by_opcode[i]);
+    }
+  }
+  printf("host              %.2f M instructions/s\n",
+      seconds > 0 ? total.instructions / seconds / 1e6 : 0.0);
+
+  lockstep_rtl->free(lockstep_rtl);
+  lockstep_thumb->free(lockstep_thumb);
+
+  return total.mismatches != 0;
+}
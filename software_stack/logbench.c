@@ -0,0 +1,300 @@
+/*
+ * Runs chase_led's log ring against the host HAL. The GateModel, the
+ *  KeyModel and a ViewerModel are loaded as chase_led's main does, then
+ *  -n wall hits each log the 32 gate permissions as chase_led's callback
+ *  does, timing every log_record on the host and counting its accesses
+ *  to the UART. Between wall hits -f microseconds of simulated time pass,
+ *  a PS7 UART model sending a byte every 10 bit times at -b baud, with
+ *  the ring drained every LOGBENCH_IDLE_US as cycle_leds does, or on its
+ *  transmit empty interrupt with -d irq. Then everything on the wire is
+ *  decoded and has to match what was queued, in order, less the drops.
+ *
+ * usage: logbench [-m binary|text] [-d idle|irq] [-n wall hits]
+ *                 [-f microseconds between wall hits] [-b baud]
+ *
+ * build: cc -O2 -I . -I <chase_led/src> -o logbench logbench.c logdec.c
+ *         <chase_led/src>/log_ring.c gate.c key.c viewer.c hal.c sim.c
+ */
+#include "bench.h"
+#include "logdec.h"
+#include "key.h"
+#include "viewer.h"
+#include "trusted_key.h"
+
+/* transmit FIFO depth of the PS7 UART */
+#define LOGBENCH_FIFO_DEPTH 64
+
+/* LED_IDLE_US, how often cycle_leds calls the idle function */
+#define LOGBENCH_IDLE_US 500
+
+/* records logged per wall hit */
+#define LOGBENCH_RECORDS 32
+
+/* bytes the callback used to print a record, "reg 00 contents: 0x..." */
+#define LOGBENCH_PRINT_BYTES 29
+
+/* the UART's transmit side, and what reached the wire */
+typedef struct _LogBenchUart
+{
+  Device device;
+  unsigned char fifo[LOGBENCH_FIFO_DEPTH];
+  unsigned head;
+  unsigned count;
+  u32 imr;
+  u32 isr;
+
+  /* microseconds a byte takes, and toward the next one going out */
+  double byte_us;
+  double credit;
+
+  unsigned char *wire;
+  size_t sent;
+  unsigned long overruns;
+  unsigned long accesses;
+} LogBenchUart;
+
+/* status and interrupt registers */
+static u32 logbench_read(Device *device, u32 offset)
+{
+  LogBenchUart *uart = (LogBenchUart *) device;
+
+  uart->accesses++;
+  switch (offset)
+  {
+    case LOG_UART_SR:
+      return (uart->count == LOGBENCH_FIFO_DEPTH ? LOG_UART_SR_TXFULL : 0)
+        | (uart->count ? 0 : LOG_UART_IXR_TEMPTY);
+    case LOG_UART_ISR:
+      return uart->isr;
+    default:
+      return 0;
+  }
+}
+
+/* the FIFO, interrupt masks, and write 1 to clear interrupt status */
+static void logbench_write(Device *device, u32 offset, u32 data)
+{
+  LogBenchUart *uart = (LogBenchUart *) device;
+
+  uart->accesses++;
+  switch (offset)
+  {
+    case LOG_UART_FIFO:
+      if (uart->count == LOGBENCH_FIFO_DEPTH)
+      {
+        uart->overruns++;
+        break;
+      }
+      uart->fifo[(uart->head + uart->count++) % LOGBENCH_FIFO_DEPTH] =
+        (unsigned char) data;
+      break;
+    case LOG_UART_IER:
+      uart->imr |= data;
+      break;
+    case LOG_UART_IDR:
+      uart->imr &= ~data;
+      break;
+    case LOG_UART_ISR:
+      uart->isr &= ~data;
+      break;
+    default:
+      break;
+  }
+}
+
+/* let time pass, the FIFO going out onto the wire */
+static void logbench_advance(LogBenchUart *uart, double us)
+{
+  uart->credit += us;
+  while (uart->count && uart->credit >= uart->byte_us)
+  {
+    uart->wire[uart->sent++] = uart->fifo[uart->head];
+    uart->head = (uart->head + 1) % LOGBENCH_FIFO_DEPTH;
+    uart->credit -= uart->byte_us;
+
+    /* an edge, set as the last byte leaves */
+    if (! --uart->count)
+    {
+      uart->isr |= LOG_UART_IXR_TEMPTY;
+    }
+  }
+
+  /* an idle line saves nothing up */
+  if (! uart->count)
+  {
+    uart->credit = 0;
+  }
+}
+
+/* time passing, drained the way chase_led would */
+static void logbench_wait(LogBenchUart *uart, LOG_DRAIN drain, double us)
+{
+  double tick = drain == LOG_DRAIN_IRQ ? uart->byte_us : LOGBENCH_IDLE_US;
+
+  for (; us > 0; us -= tick)
+  {
+    logbench_advance(uart, us < tick ? us : tick);
+    if (drain == LOG_DRAIN_IDLE)
+    {
+      log_drain();
+    }
+    else if (uart->isr & uart->imr)
+    {
+      log_isr(NULL);
+    }
+  }
+}
+
+int main(int argc, char **argv)
+{
+  unsigned long hits = 1000, gap = 700000, baud = 115200, h, n = 0,
+                producer = 0, errors = 0, queued = 0;
+  unsigned i;
+  LOG_MODE mode = LOG_MODE_BINARY;
+  LOG_DRAIN drain = LOG_DRAIN_IDLE;
+  LogRecord *expected, record;
+  LogDecoder *decoder;
+  LogBenchUart uart;
+  GateModel *gate;
+  KeyModel *key;
+  ViewerModel *viewer;
+  double seconds, longest = 0, total = 0, flush;
+  u32 value;
+  size_t s;
+  int a;
+
+  /* options */
+  for (a = 1; a + 1 < argc && argv[a][0] == '-'; a += 2)
+  {
+    switch (argv[a][1])
+    {
+      case 'm': mode  = argv[a + 1][0] == 't' ? LOG_MODE_TEXT
+                  : LOG_MODE_BINARY;                             break;
+      case 'd': drain = ! strcmp(argv[a + 1], "irq") ? LOG_DRAIN_IRQ
+                  : LOG_DRAIN_IDLE;                              break;
+      case 'n': hits  = strtoul(argv[a + 1], NULL, 0);           break;
+      case 'f': gap   = strtoul(argv[a + 1], NULL, 0);           break;
+      case 'b': baud  = strtoul(argv[a + 1], NULL, 0);           break;
+      default:  a = argc;                                        break;
+    }
+  }
+  if (a != argc || ! baud)
+  {
+    fprintf(stderr, "usage: %s [-m binary|text] [-d idle|irq] "
+        "[-n wall hits] [-f microseconds between wall hits] [-b baud]\n",
+        argv[0]);
+    return 1;
+  }
+
+  memset(&uart, 0, sizeof(uart));
+  uart.device.base  = XPAR_PS7_UART_1_BASEADDR;
+  uart.device.size  = 0x1000;
+  uart.device.read  = logbench_read;
+  uart.device.write = logbench_write;
+  uart.byte_us = 10 * 1e6 / baud;
+  if (
+         ! (expected = (LogRecord *) calloc(hits * LOGBENCH_RECORDS + 1,
+             sizeof(LogRecord)))
+      || ! (uart.wire = (unsigned char *) malloc(hits * LOGBENCH_RECORDS
+             * LOG_TEXT_BYTES + 1))
+      || ! (decoder = newLogDecoder(mode))
+      )
+  {
+    fprintf(stderr, "out of memory\n");
+    return 1;
+  }
+  if (
+         ! (gate = newGateModel(XPAR_TRUSTED_GATE_0_BASEADDR))
+      || ! (key = newKeyModel(XPAR_TRUSTED_KEY_0_BASEADDR, NULL))
+      || ! (viewer = newViewerModel(XPAR_GATE_VIEWER_0_BASEADDR, gate))
+      || hal_attach(&uart.device)
+      )
+  {
+    fprintf(stderr, "cannot map the peripherals\n");
+    return 1;
+  }
+
+  /* chase_led's main */
+  log_init(mode, drain);
+  for (i = 0; i < TRUSTED_KEY_ID_HCE; i++)
+  {
+    add_gate_permission(TRUSTED_KEY_ID_MEM_R, i);
+    add_trusted_key(i, i);
+  }
+  read_gate_key(3);
+  for (i = TRUSTED_KEY_ID_HCE; i <= TRUSTED_KEY_ID_IRQM; i++)
+  {
+    add_gate_permission(TRUSTED_KEY_PERM_IO_O, i);
+    add_trusted_key(i, i);
+  }
+  use_trusted_key(TRUSTED_KEY_ID_SIF);
+
+  /* chase_led's callback on every wall hit, then the frames after it */
+  for (h = 0; h < hits; h++)
+  {
+    for (i = 0; i < LOGBENCH_RECORDS; i++)
+    {
+      add_gate_permission(TRUSTED_KEY_PERM_IO_O, 0xFEDCBA98);
+      value = read_gate_permission(i);
+
+      producer -= uart.accesses;
+      seconds = bench_now();
+      if (! log_record(LOG_ID_GATE_PERM, i, value))
+      {
+        expected[n].id = LOG_ID_GATE_PERM;
+        expected[n].a  = i;
+        expected[n++].b = value;
+      }
+      seconds = bench_now() - seconds;
+      producer += uart.accesses;
+
+      total += seconds;
+      longest = seconds > longest ? seconds : longest;
+      queued++;
+    }
+    logbench_wait(&uart, drain, gap);
+  }
+
+  /* whatever is left */
+  for (flush = 0; log_pending() || uart.count; flush += LOGBENCH_IDLE_US)
+  {
+    logbench_wait(&uart, drain, LOGBENCH_IDLE_US);
+  }
+
+  /* the wire has to decode to what was queued */
+  for (s = 0, i = 0; s < uart.sent; s++)
+  {
+    if (decoder->push(decoder, uart.wire[s], &record))
+    {
+      errors += i >= n || record.id != expected[i].id
+        || record.a != expected[i].a || record.b != expected[i].b;
+      i++;
+    }
+  }
+  errors += i != n || decoder->skipped || decoder->have || uart.overruns;
+
+  printf("records           %lu queued, %lu dropped, %s, drained %s\n",
+      queued, (unsigned long) log_dropped(),
+      mode == LOG_MODE_TEXT ? "text" : "binary",
+      drain == LOG_DRAIN_IRQ ? "on the interrupt" : "while idle");
+  printf("wire              %lu bytes, %.1f a record, %lu baud, %.1f ms "
+      "to flush\n", (unsigned long) uart.sent, n ? (double) uart.sent / n
+      : 0.0, baud, flush / 1000);
+  printf("log_record        %.1f ns mean, %.1f ns longest, %lu UART "
+      "accesses\n", total * 1e9 / (queued ? queued : 1), longest * 1e9,
+      producer);
+  printf("blocking print    %.1f ms a wall hit at %lu baud\n",
+      LOGBENCH_RECORDS * LOGBENCH_PRINT_BYTES * uart.byte_us / 1000, baud);
+  printf("decoded           %lu records, %lu bytes skipped, %lu wrong\n",
+      decoder->records, decoder->skipped, errors);
+
+  hal_detach(&uart.device);
+  viewer->free(viewer);
+  key->free(key);
+  gate->free(gate);
+  decoder->free(decoder);
+  free(uart.wire);
+  free(expected);
+
+  return errors != 0;
+}
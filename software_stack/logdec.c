@@ -0,0 +1,157 @@
+#include "logdec.h"
+
+/* method forward decls */
+int LogDecoder_push(LogDecoder *self, unsigned char byte, LogRecord *record);
+LogDecoder * LogDecoder_free(LogDecoder *self);
+
+/* constructor */
+LogDecoder * newLogDecoder(LOG_MODE mode)
+{
+  LogDecoder *self = (LogDecoder *) malloc(sizeof(LogDecoder));
+
+  /* out of memory */
+  if (! self)
+  {
+    return NULL;
+  }
+
+  /* zero */
+  memset(self, 0, sizeof(LogDecoder));
+
+  /* bind methods */
+  self->push = LogDecoder_push;
+  self->free = LogDecoder_free;
+
+  self->mode = mode;
+
+  return self;
+}
+
+/* a little endian word */
+static u32 LogDecoder_word(const unsigned char *bytes)
+{
+  return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16)
+    | ((u32) bytes[3] << 24);
+}
+
+/* 8 hex digits, non-zero if they are not */
+static int LogDecoder_hex(const unsigned char *digits, u32 *word)
+{
+  unsigned i;
+
+  *word = 0;
+  for (i = 0; i < 8; i++)
+  {
+    if (digits[i] >= '0' && digits[i] <= '9')
+    {
+      *word = (*word << 4) | (digits[i] - '0');
+    }
+    else if (digits[i] >= 'A' && digits[i] <= 'F')
+    {
+      *word = (*word << 4) | (digits[i] - 'A' + 10);
+    }
+    else
+    {
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
+/* a whole text line, non-zero if it is not a record */
+static int LogDecoder_line(LogDecoder *self, LogRecord *record)
+{
+  unsigned char *line = self->pending;
+  unsigned id;
+
+  if (
+         self->have != LOG_TEXT_BYTES
+      || line[LOG_NAME_CHARS + 8] != ' '
+      || line[LOG_TEXT_BYTES - 2] != '\r'
+      || LogDecoder_hex(line + LOG_NAME_CHARS, &record->a)
+      || LogDecoder_hex(line + LOG_NAME_CHARS + 9, &record->b)
+      )
+  {
+    return -1;
+  }
+  for (id = 0; id < LOG_NUM_IDS; id++)
+  {
+    if (! memcmp(line, log_names[id], LOG_NAME_CHARS))
+    {
+      record->id = (LOG_ID) id;
+      return 0;
+    }
+  }
+
+  return -1;
+}
+
+/* a byte, resynchronizing on a sync byte or a line end */
+int LogDecoder_push(LogDecoder *self, unsigned char byte, LogRecord *record)
+{
+  if (self->mode == LOG_MODE_TEXT)
+  {
+    if (self->have < LOG_TEXT_BYTES)
+    {
+      self->pending[self->have] = byte;
+    }
+    self->have++;
+    if (byte != '\n')
+    {
+      return 0;
+    }
+    if (LogDecoder_line(self, record))
+    {
+      self->skipped += self->have;
+      self->have = 0;
+      return 0;
+    }
+    self->have = 0;
+    self->records++;
+    return 1;
+  }
+
+  /* frames start with LOG_SYNC and name a known id */
+  if (
+         (self->have == 0 && byte != LOG_SYNC)
+      || (self->have == 1 && byte >= LOG_NUM_IDS)
+      )
+  {
+    self->skipped += self->have + (byte != LOG_SYNC);
+    self->have = byte == LOG_SYNC;
+    self->pending[0] = byte;
+    return 0;
+  }
+  self->pending[self->have++] = byte;
+  if (self->have < LOG_RECORD_BYTES)
+  {
+    return 0;
+  }
+
+  record->id = (LOG_ID) self->pending[1];
+  record->a = LogDecoder_word(self->pending + 2);
+  record->b = LogDecoder_word(self->pending + 6);
+  self->have = 0;
+  self->records++;
+
+  return 1;
+}
+
+/* destructor */
+LogDecoder * LogDecoder_free(LogDecoder *self)
+{
+  free(self);
+
+  return NULL;
+}
+
+/* name, then both words in hex */
+char * logdec_format(const LogRecord *record, char *out)
+{
+  sprintf(out, "%.*s%08X %08X", LOG_NAME_CHARS,
+      log_names[record->id < LOG_NUM_IDS ? record->id : LOG_ID_NONE],
+      record->a, record->b);
+
+  return out;
+}
@@ -0,0 +1,70 @@
+#ifndef __SOFT_STACK_LOGDEC
+#define __SOFT_STACK_LOGDEC
+
+#include "main.h"
+#include "log_ring.h"
+
+/** A record as chase_led's log_record queued it */
+typedef struct _LogRecord
+{
+  LOG_ID id;
+  u32 a;
+  u32 b;
+} LogRecord;
+
+/**
+ * A LogDecoder turns the bytes log_ring sends back into records, a byte
+ *  at a time so it can sit on a serial port or a capture file alike.
+ *  Anything which is not a record, such as the tail of a record the
+ *  capture started part way through, is skipped and counted.
+ */
+typedef struct _LogDecoder
+{
+  /** binary frames or text lines */
+  LOG_MODE mode;
+
+  /** the record so far */
+  unsigned char pending[LOG_TEXT_BYTES];
+  unsigned have;
+
+  /** records decoded, and bytes skipped */
+  unsigned long records;
+  unsigned long skipped;
+
+  /**
+   * Decode the next byte
+   *
+   * @param byte the byte
+   * @param record filled in when a record is complete
+   * @return 1 if it completed a record, 0 if not
+   */
+  int (*push)(struct _LogDecoder *self, unsigned char byte,
+      LogRecord *record);
+
+  /**
+   * Destructor
+   *
+   * @return NULL
+   */
+  struct _LogDecoder * (*free)(struct _LogDecoder *self);
+
+} LogDecoder;
+
+/**
+ * Constructor
+ *
+ * @param mode how log_init was told to send records
+ * @return a new LogDecoder, or NULL if out of memory
+ */
+LogDecoder * newLogDecoder(LOG_MODE mode);
+
+/**
+ * Format a record as log_ring's text mode does, less the CR LF
+ *
+ * @param record the record
+ * @param out at least LOG_TEXT_BYTES bytes
+ * @return out
+ */
+char * logdec_format(const LogRecord *record, char *out);
+
+#endif /* __SOFT_STACK_LOGDEC */
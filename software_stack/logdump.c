@@ -0,0 +1,73 @@
+/*
+ * Turns what chase_led's log ring sent over the UART, as captured from
+ *  the serial port, into readable records.
+ *
+ * Binary captures are LOG_RECORD_BYTES frames: LOG_SYNC, the record id,
+ *  then 2 little endian 32-bit words. Text captures are log_ring's own
+ *  lines, checked and re-read. Bytes which are neither, such as a frame
+ *  the capture started part way through, are skipped and counted.
+ *
+ * usage: logdump [-t] [capture file]
+ *  -t reads a text mode capture, binary frames are the default
+ *  reads standard input when no file is given
+ *
+ * build: cc -O2 -I . -I <chase_led/src> -o logdump logdump.c logdec.c
+ *         <chase_led/src>/log_ring.c hal.c
+ */
+#include "logdec.h"
+
+int main(int argc, char **argv)
+{
+  LOG_MODE mode = LOG_MODE_BINARY;
+  LogDecoder *decoder;
+  LogRecord record;
+  char line[LOG_TEXT_BYTES];
+  FILE *in = stdin;
+  int a = 1, c;
+
+  if (a < argc && ! strcmp(argv[a], "-t"))
+  {
+    mode = LOG_MODE_TEXT;
+    a++;
+  }
+  if (argc - a > 1 || (a < argc && argv[a][0] == '-'))
+  {
+    fprintf(stderr, "usage: %s [-t] [capture file]\n", argv[0]);
+    return 1;
+  }
+  if (a < argc && ! (in = fopen(argv[a], "rb")))
+  {
+    perror(argv[a]);
+    return 1;
+  }
+  if (! (decoder = newLogDecoder(mode)))
+  {
+    fprintf(stderr, "out of memory\n");
+    return 1;
+  }
+
+  printf("%-8s %s\n", "#", "RECORD");
+  while ((c = fgetc(in)) != EOF)
+  {
+    if (decoder->push(decoder, (unsigned char) c, &record))
+    {
+      printf("%-8lu %s\n", decoder->records - 1,
+          logdec_format(&record, line));
+    }
+  }
+
+  /* a capture cut short, or with something else on the line */
+  if (decoder->skipped || decoder->have)
+  {
+    fprintf(stderr, "ignoring %lu bytes\n", decoder->skipped
+        + decoder->have);
+  }
+
+  if (in != stdin)
+  {
+    fclose(in);
+  }
+  decoder->free(decoder);
+
+  return 0;
+}
@@ -1,70 +1,71 @@
 #include "stack.h"
 
+/* every opcode once, asmbench.cpp has it as mnemonics */
 unsigned char test_instructions[] = {
-  0xCA, 0x07, /* LSL i5 m d */
-  0xCA, 0x0F, /* LSR i5 m d */
-  0xCA, 0x17, /* ASR i5 m d */
-  0x53, 0x18, /* ADD m n d */
-  0x53, 0x1A, /* SUB m n d */
-  0xCA, 0x1D, /* ADD i3 n d */
-  0xCA, 0x1F, /* SUB i3 n d */
-  0xFF, 0x21, /* MOV d i8 */
-  0xFF, 0x29, /* CMP n i8 */
-  0xFF, 0x31, /* ADD d i8 */
-  0xFF, 0x39, /* SUB d i8 */
-  0x0A, 0x40, /* AND m d */
-  0x4A, 0x40, /* EOR m d */
-  0x8A, 0x40, /* LSL s d */
-  0xCA, 0x40, /* LSR s d */
-  0x0A, 0x41, /* ASR s d */
-  0x4A, 0x41, /* ADC m d */
-  0x8A, 0x41, /* SBC m d */
-  0xCA, 0x41, /* ROR s d */
-  0x0A, 0x42, /* TST n m */
-  0x4A, 0x42, /* NEG m d */
-  0x8A, 0x42, /* CMP n m */
-  0xCA, 0x42, /* CMN n m */
-  0x0A, 0x43, /* ORR m d */
-  0x4A, 0x43, /* MUL m d */
-  0x8A, 0x43, /* BIC n m */
-  0xCA, 0x43, /* MVN m d */
-  0xCA, 0x44, /* ADD h2 m d */
-  0xCA, 0x45, /* CMP h2 n m */
-  0xCA, 0x46, /* MOV h2 m d */
-  0x48, 0x47, /* BX h1 m 93 */ /* <------------ */ /* X */
-  0xC8, 0x47, /* LDR d i8 */
-  0xFF, 0x49, /* STR m n d */
-  0x53, 0x50, /* STRH m n d */
-  0x53, 0x52, /* STRB m n d */
-  0x53, 0x54, /* STRB m n d */
-  0x53, 0x56, /* LDRSB m n d */
-  0x53, 0x58, /* LDR m n d */
-  0x53, 0x5A, /* LDRH m n d */
-  0x53, 0x5C, /* LDRB m n d */
-  0x53, 0x5E, /* LDRSH m n d */
-  0xCA, 0x67, /* STR i5 n d */
-  0xCA, 0x6F, /* LDR i5 n d */
-  0xCA, 0x77, /* STRB i5 n d */
-  0xCA, 0x7F, /* LDRB i5 n d */
-  0xCA, 0x87, /* STRH i5 n d */
-  0xCA, 0x8F, /* LDRH i5 n d */
-  0xFF, 0x91, /* STR d i8 */
-  0xFF, 0x99, /* LDR d i8 */
-  0xFF, 0xA1, /* ADD-PC d i8 */
-  0xFF, 0xA9, /* ADD-SP d i8 */
-  0xFF, 0xB0, /* SUB-SP 1 i7 */
-  0xFF, 0xB5, /* PUSH f1 rl8 */
-  0xFF, 0xBD, /* POP f1 rl8 */
-  0xFF, 0xBE, /* BKPT i8 */
-  0xFF, 0xC1, /* STMIA n rl8 */
-  0xFF, 0xC9, /* LDMIA n rl8 */
-  0xFF, 0xDD, /* B_COND i8 */ /* <------------ */ /* CONDITIONAL */
-  0xFF, 0xDE, /* UNUSED */
-  0xFF, 0xDF, /* SWI i8 */
-  0xFF, 0xE7, /* B i8 */ /* <------------ */
-  0xFF, 0xEF, /* BLX i8 */ /* <------------ */ /* AND LINK */ /* X */
-  0xFF, 0xF7, /* BLXH i8 */ /* <------------ */ /* AND LINK */ /* X */ /* H */
-  0xFF, 0xFF  /* BL i8 */ /* <------------ */ /* AND LINK */
+  0xCA, 0x07, /* LSL r2, r1, #31 */
+  0xCA, 0x0F, /* LSR r2, r1, #31 */
+  0xCA, 0x17, /* ASR r2, r1, #31 */
+  0x53, 0x18, /* ADD r3, r2, r1 */
+  0x53, 0x1A, /* SUB r3, r2, r1 */
+  0xCA, 0x1D, /* ADD r2, r1, #7 */
+  0xCA, 0x1F, /* SUB r2, r1, #7 */
+  0xFF, 0x21, /* MOV r1, #255 */
+  0xFF, 0x29, /* CMP r1, #255 */
+  0xFF, 0x31, /* ADD r1, #255 */
+  0xFF, 0x39, /* SUB r1, #255 */
+  0x0A, 0x40, /* AND r2, r1 */
+  0x4A, 0x40, /* EOR r2, r1 */
+  0x8A, 0x40, /* LSL r2, r1 */
+  0xCA, 0x40, /* LSR r2, r1 */
+  0x0A, 0x41, /* ASR r2, r1 */
+  0x4A, 0x41, /* ADC r2, r1 */
+  0x8A, 0x41, /* SBC r2, r1 */
+  0xCA, 0x41, /* ROR r2, r1 */
+  0x0A, 0x42, /* TST r2, r1 */
+  0x4A, 0x42, /* NEG r2, r1 */
+  0x8A, 0x42, /* CMP r2, r1 */
+  0xCA, 0x42, /* CMN r2, r1 */
+  0x0A, 0x43, /* ORR r2, r1 */
+  0x4A, 0x43, /* MUL r2, r1 */
+  0x8A, 0x43, /* BIC r2, r1 */
+  0xCA, 0x43, /* MVN r2, r1 */
+  0xCA, 0x44, /* ADD r10, r9 */
+  0xCA, 0x45, /* CMP r10, r9 */
+  0xCA, 0x46, /* MOV r10, r9 */
+  0x48, 0x47, /* BX r9 */
+  0xC8, 0x47, /* BLX r9 */
+  0xFF, 0x49, /* LDR r1, [pc, #1020] */
+  0x53, 0x50, /* STR r3, [r2, r1] */
+  0x53, 0x52, /* STRH r3, [r2, r1] */
+  0x53, 0x54, /* STRB r3, [r2, r1] */
+  0x53, 0x56, /* LDRSB r3, [r2, r1] */
+  0x53, 0x58, /* LDR r3, [r2, r1] */
+  0x53, 0x5A, /* LDRH r3, [r2, r1] */
+  0x53, 0x5C, /* LDRB r3, [r2, r1] */
+  0x53, 0x5E, /* LDRSH r3, [r2, r1] */
+  0xCA, 0x67, /* STR r2, [r1, #124] */
+  0xCA, 0x6F, /* LDR r2, [r1, #124] */
+  0xCA, 0x77, /* STRB r2, [r1, #31] */
+  0xCA, 0x7F, /* LDRB r2, [r1, #31] */
+  0xCA, 0x87, /* STRH r2, [r1, #62] */
+  0xCA, 0x8F, /* LDRH r2, [r1, #62] */
+  0xFF, 0x91, /* STR r1, [sp, #1020] */
+  0xFF, 0x99, /* LDR r1, [sp, #1020] */
+  0xFF, 0xA1, /* ADD r1, pc, #1020 */
+  0xFF, 0xA9, /* ADD r1, sp, #1020 */
+  0xFF, 0xB0, /* SUB sp, #508 */
+  0xFF, 0xB5, /* PUSH {r0-r7, lr} */
+  0xFF, 0xBD, /* POP {r0-r7, pc} */
+  0xFF, 0xBE, /* BKPT #255 */
+  0xFF, 0xC1, /* STMIA r1!, {r0-r7} */
+  0xFF, 0xC9, /* LDMIA r1!, {r0-r7} */
+  0xFF, 0xDD, /* BLE .+2 */
+  0xFF, 0xDE, /* unused */
+  0xFF, 0xDF, /* SWI #255 */
+  0xFF, 0xE7, /* B .+2 */
+  0xFF, 0xEF, /* low half of a BLX, alone */
+  0xFF, 0xF7, /* BL .+2, high half */
+  0xFF, 0xFF /* BL .+2, low half */
 };
 
 int main(int argc, char **argv)
@@ -0,0 +1,290 @@
+/*
+ * Runs chase_led's peripheral traffic through pl_dev_driver.h built with
+ *  PL_DEV_TRACE, against the host HAL. The GateModel, the KeyModel and a
+ *  ViewerModel are reset and loaded as chase_led's main does, then -n
+ *  wall hits each write and read back the 32 gate permissions as its
+ *  callback does, the trace being collected after every wall hit. Each
+ *  access the trace holds has to be one made, in the order made, with
+ *  the register and value it was made with, less those dropped. Then -p
+ *  reads of a gate permission are timed traced, with tracing stopped,
+ *  and as a plain Xil_In32, which is what PL_DEV_mReadReg is built
+ *  without PL_DEV_TRACE, and the histograms printed.
+ *
+ * usage: mmiobench [-n wall hits] [-p reads]
+ *
+ * build: cc -O2 -DPL_DEV_TRACE -I . -I <chase_led/src>
+ *         -I ../pl_dev_trace/src -o mmiobench mmiobench.c
+ *         ../pl_dev_trace/src/pl_dev_trace.c gate.c key.c viewer.c hal.c
+ *         sim.c
+ */
+#include "bench.h"
+#include "key.h"
+#include "viewer.h"
+#include "trusted_key.h"
+
+#ifndef PL_DEV_TRACE
+#error "mmiobench measures the traced macros, build with -DPL_DEV_TRACE"
+#endif
+
+/* registers the callback reads back per wall hit */
+#define MMIOBENCH_RECORDS 32
+
+/* an access the way the trace should hold it */
+typedef struct _MmioBenchAccess
+{
+  u32 kind;
+  u32 base;
+  u32 reg;
+  u32 value;
+} MmioBenchAccess;
+
+/* every access made, in order */
+static MmioBenchAccess *mmiobench_made = NULL;
+static unsigned long mmiobench_n = 0;
+
+/* note an access the macros have just made */
+static u32 mmiobench_note(u32 kind, u32 base, u32 reg, u32 value)
+{
+  MmioBenchAccess *access = &mmiobench_made[mmiobench_n++];
+
+  access->kind  = kind;
+  access->base  = base;
+  access->reg   = reg;
+  access->value = value;
+
+  return value;
+}
+
+/* name of a peripheral */
+static const char * mmiobench_name(u32 base)
+{
+  switch (base)
+  {
+    case XPAR_TRUSTED_KEY_0_BASEADDR:  return "trusted_key";
+    case XPAR_TRUSTED_GATE_0_BASEADDR: return "trusted_gate";
+    case XPAR_GATE_VIEWER_0_BASEADDR:  return "gate_viewer";
+    default:                           return "?";
+  }
+}
+
+/* a histogram's registers if it sums several, counts and latency, then
+   its non-empty buckets */
+static void mmiobench_print(const char *label, unsigned regs,
+    const PlDevTraceHistogram *h)
+{
+  u32 n = h->count[PL_DEV_TRACE_READ] + h->count[PL_DEV_TRACE_WRITE]
+    + h->count[PL_DEV_TRACE_RESET];
+  int b;
+
+  printf("%-18s", label);
+  if (regs)
+  {
+    printf("%u regs, ", regs);
+  }
+  printf("%u reads, %u writes, %u resets, cycles %u min, %.1f mean, "
+      "%u max\n", h->count[PL_DEV_TRACE_READ],
+      h->count[PL_DEV_TRACE_WRITE], h->count[PL_DEV_TRACE_RESET],
+      n ? h->min_cycles : 0, n ? (double) h->total_cycles / n : 0.0,
+      h->max_cycles);
+  printf("%-18s", "");
+  for (b = 0; b < PL_DEV_TRACE_BUCKETS; b++)
+  {
+    if (h->buckets[b])
+    {
+      printf(" <%u: %u", 1u << b, h->buckets[b]);
+    }
+  }
+  printf("\n");
+}
+
+int main(int argc, char **argv)
+{
+  unsigned long hits = 1000, reads = 1000000, h, i, checked = 0,
+                wrong = 0, collected = 0, skipped;
+  unsigned regs, r;
+  PlDevTraceEntry *entries;
+  const PlDevTraceHistogram *histograms;
+  PlDevTraceHistogram sum;
+  const u32 bases[] = {
+    XPAR_TRUSTED_KEY_0_BASEADDR, XPAR_TRUSTED_GATE_0_BASEADDR,
+    XPAR_GATE_VIEWER_0_BASEADDR
+  };
+  GateModel *gate;
+  KeyModel *key;
+  ViewerModel *viewer;
+  double started, seconds[3];
+  char label[32];
+  u32 value = 0;
+  int a, n, e, best;
+
+  /* options */
+  for (a = 1; a + 1 < argc && argv[a][0] == '-'; a += 2)
+  {
+    switch (argv[a][1])
+    {
+      case 'n': hits  = strtoul(argv[a + 1], NULL, 0);  break;
+      case 'p': reads = strtoul(argv[a + 1], NULL, 0);  break;
+      default:  a = argc;                               break;
+    }
+  }
+  if (a != argc || ! reads)
+  {
+    fprintf(stderr, "usage: %s [-n wall hits] [-p reads]\n", argv[0]);
+    return 1;
+  }
+
+  if (
+         ! (mmiobench_made = (MmioBenchAccess *) malloc((hits + 1)
+             * (2 * MMIOBENCH_RECORDS + 2 * TRUSTED_KEY_ID_IRQM + 8)
+             * sizeof(MmioBenchAccess)))
+      || ! (entries = (PlDevTraceEntry *) malloc(PL_DEV_TRACE_CPUS
+             * PL_DEV_TRACE_ENTRIES * sizeof(PlDevTraceEntry)))
+      )
+  {
+    fprintf(stderr, "out of memory\n");
+    return 1;
+  }
+  if (
+         ! (gate = newGateModel(XPAR_TRUSTED_GATE_0_BASEADDR))
+      || ! (key = newKeyModel(XPAR_TRUSTED_KEY_0_BASEADDR, NULL))
+      || ! (viewer = newViewerModel(XPAR_GATE_VIEWER_0_BASEADDR, gate))
+      )
+  {
+    fprintf(stderr, "cannot map the peripherals\n");
+    return 1;
+  }
+
+  /* chase_led's main */
+  pl_dev_trace_start();
+  init_trusted_key();
+  mmiobench_note(PL_DEV_TRACE_RESET, XPAR_TRUSTED_KEY_0_BASEADDR,
+      PL_DEV_SOFT_RST_SPACE_OFFSET / 4, PL_DEV_SOFT_RESET);
+  init_trusted_gate();
+  mmiobench_note(PL_DEV_TRACE_RESET, XPAR_TRUSTED_GATE_0_BASEADDR,
+      PL_DEV_SOFT_RST_SPACE_OFFSET / 4, PL_DEV_SOFT_RESET);
+  for (r = 0; r <= TRUSTED_KEY_ID_IRQM; r++)
+  {
+    value = r < TRUSTED_KEY_ID_HCE ? TRUSTED_KEY_ID_MEM_R
+      : TRUSTED_KEY_PERM_IO_O;
+    add_gate_permission(value, r);
+    mmiobench_note(PL_DEV_TRACE_WRITE, XPAR_TRUSTED_GATE_0_BASEADDR,
+        value, r);
+    add_trusted_key(r, r);
+    mmiobench_note(PL_DEV_TRACE_WRITE, XPAR_TRUSTED_KEY_0_BASEADDR,
+        r + 4, r);
+  }
+  use_trusted_key(TRUSTED_KEY_ID_SIF);
+  mmiobench_note(PL_DEV_TRACE_WRITE, XPAR_TRUSTED_KEY_0_BASEADDR, 0,
+      TRUSTED_KEY_TZ | (1 << (TRUSTED_KEY_ID_SIF + 4)));
+
+  /* chase_led's callback on every wall hit, collecting after each */
+  for (h = 0, skipped = 0; h <= hits; h++)
+  {
+    n = pl_dev_trace_collect(entries, PL_DEV_TRACE_CPUS
+        * PL_DEV_TRACE_ENTRIES);
+
+    /* what the trace holds has to be what was made, in order */
+    for (e = 0; e < n; e++, checked++)
+    {
+      const MmioBenchAccess *made = &mmiobench_made[checked];
+
+      wrong += entries[e].kind != made->kind || entries[e].cpu
+        || entries[e].base != made->base || entries[e].reg != made->reg
+        || entries[e].value != made->value
+        || (e && (int) (entries[e].stamp - entries[e - 1].stamp) < 0);
+    }
+    collected += n;
+    if (h == hits)
+    {
+      break;
+    }
+
+    for (i = 0; i < MMIOBENCH_RECORDS; i++)
+    {
+      add_gate_permission(TRUSTED_KEY_PERM_IO_O, 0xFEDCBA98);
+      mmiobench_note(PL_DEV_TRACE_WRITE, XPAR_TRUSTED_GATE_0_BASEADDR,
+          TRUSTED_KEY_PERM_IO_O, 0xFEDCBA98);
+      mmiobench_note(PL_DEV_TRACE_READ, XPAR_GATE_VIEWER_0_BASEADDR, i,
+          read_gate_permission(i));
+    }
+  }
+  skipped = mmiobench_n - collected;
+  wrong += skipped != pl_dev_trace_dropped();
+
+  /* traced, stopped, and what the macro is without PL_DEV_TRACE */
+  started = bench_now();
+  for (i = 0; i < reads; i++)
+  {
+    value += read_gate_permission(i & 31);
+    if ((i & (PL_DEV_TRACE_ENTRIES - 1)) == PL_DEV_TRACE_ENTRIES - 1)
+    {
+      pl_dev_trace_collect(NULL, 0);
+    }
+  }
+  seconds[0] = bench_now() - started;
+
+  pl_dev_trace_enable(0);
+  started = bench_now();
+  for (i = 0; i < reads; i++)
+  {
+    value += read_gate_permission(i & 31);
+  }
+  seconds[1] = bench_now() - started;
+
+  started = bench_now();
+  for (i = 0; i < reads; i++)
+  {
+    value += Xil_In32(XPAR_GATE_VIEWER_0_BASEADDR + 4 * (i & 31));
+  }
+  seconds[2] = bench_now() - started;
+  pl_dev_trace_collect(NULL, 0);
+
+  printf("accesses          %lu made, %lu collected, %lu dropped, %lu "
+      "wrong\n", mmiobench_n, collected, skipped, wrong);
+  printf("ns/read           %.1f traced, %.1f stopped, %.1f untraced\n",
+      seconds[0] * 1e9 / reads, seconds[1] * 1e9 / reads,
+      seconds[2] * 1e9 / reads);
+
+  /* per peripheral, then its busiest register */
+  n = pl_dev_trace_histograms(&histograms);
+  for (r = 0; r < sizeof(bases) / sizeof(bases[0]); r++)
+  {
+    regs = (unsigned) pl_dev_trace_peripheral(bases[r], &sum);
+    snprintf(label, sizeof(label), "%s", mmiobench_name(bases[r]));
+    mmiobench_print(label, regs, &sum);
+    for (e = 0, best = -1; e < n; e++)
+    {
+      if (
+             histograms[e].base == bases[r]
+          && (best < 0 || histograms[e].count[PL_DEV_TRACE_READ]
+               + histograms[e].count[PL_DEV_TRACE_WRITE]
+               > histograms[best].count[PL_DEV_TRACE_READ]
+               + histograms[best].count[PL_DEV_TRACE_WRITE])
+          )
+      {
+        best = e;
+      }
+    }
+    if (best >= 0)
+    {
+      snprintf(label, sizeof(label), " busiest reg %u",
+          histograms[best].reg);
+      mmiobench_print(label, 0, &histograms[best]);
+    }
+  }
+  printf("unbinned          %lu\n", (unsigned long) pl_dev_trace_unbinned());
+
+  /* keep the reads from being optimized away */
+  if (! value)
+  {
+    printf("\n");
+  }
+
+  viewer->free(viewer);
+  key->free(key);
+  gate->free(gate);
+  free(entries);
+  free(mmiobench_made);
+
+  return wrong != 0;
+}
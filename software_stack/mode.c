@@ -0,0 +1,255 @@
+#include "mode.h"
+
+/* method forward decls */
+CoreStatus ModeCore_step(ModeCore *self, unsigned instruction);
+ModeCore * ModeCore_interrupt(ModeCore *self, ModeId mode);
+ModeCore * ModeCore_ret(ModeCore *self);
+u32 ModeCore_get(ModeCore *self, unsigned reg);
+void ModeCore_set(ModeCore *self, unsigned reg, u32 value);
+u32 ModeCore_cpsr(ModeCore *self);
+ModeCore * ModeCore_setCpsr(ModeCore *self, u32 psr);
+ModeCore * ModeCore_free(ModeCore *self);
+
+/* flags, which live in the Core */
+#define MODE_PSR_FLAGS (MODE_PSR_N | MODE_PSR_Z | MODE_PSR_C | MODE_PSR_V)
+
+/* r8-r12 are shared by all but FIQ, SP and LR by User and System only */
+static const ModeBank mode_user =
+  { MODE_USER,    { 8, 9, 10, 11, 12, MODE_USRSP_REG, MODE_USRLR_REG }, 0, 0 };
+static const ModeBank mode_system =
+  { MODE_SYSTEM,  { 8, 9, 10, 11, 12, MODE_USRSP_REG, MODE_USRLR_REG }, 0, 0 };
+static const ModeBank mode_fiq =
+  { MODE_FIQ,     { MODE_FIQ8_REG, MODE_FIQ8_REG + 1, MODE_FIQ8_REG + 2,
+      MODE_FIQ8_REG + 3, MODE_FIQ8_REG + 4, MODE_FIQSP_REG, MODE_FIQLR_REG },
+    MODE_FIQSS_REG, 4 };
+static const ModeBank mode_irq =
+  { MODE_IRQ,     { 8, 9, 10, 11, 12, MODE_IRQSP_REG, MODE_IRQLR_REG },
+    MODE_IRQSS_REG, 4 };
+static const ModeBank mode_svc =
+  { MODE_SVC,     { 8, 9, 10, 11, 12, MODE_SVCSP_REG, MODE_SVCLR_REG },
+    MODE_SVCSS_REG, 0 };
+static const ModeBank mode_monitor =
+  { MODE_MONITOR, { 8, 9, 10, 11, 12, MODE_MONSP_REG, MODE_MONLR_REG },
+    MODE_MONSS_REG, 0 };
+static const ModeBank mode_abort =
+  { MODE_ABORT,   { 8, 9, 10, 11, 12, MODE_ABOSP_REG, MODE_ABOLR_REG },
+    MODE_ABOSS_REG, 4 };
+static const ModeBank mode_undef =
+  { MODE_UNDEF,   { 8, 9, 10, 11, 12, MODE_UNDSP_REG, MODE_UNDLR_REG },
+    MODE_UNDSS_REG, 0 };
+
+/* by mode bits, NULL where they are not a mode */
+static const ModeBank *mode_banks[32] =
+{
+  [MODE_USER]    = &mode_user,
+  [MODE_FIQ]     = &mode_fiq,
+  [MODE_IRQ]     = &mode_irq,
+  [MODE_SVC]     = &mode_svc,
+  [MODE_MONITOR] = &mode_monitor,
+  [MODE_ABORT]   = &mode_abort,
+  [MODE_UNDEF]   = &mode_undef,
+  [MODE_SYSTEM]  = &mode_system
+};
+
+/* look a mode up */
+const ModeBank * mode_bank(unsigned mode)
+{
+  return mode_banks[mode & MODE_PSR_M];
+}
+
+/* constructor */
+ModeCore * newModeCore(Core *core)
+{
+  ModeCore *self;
+
+  if (! core || ! (self = (ModeCore *) malloc(sizeof(ModeCore))))
+  {
+    return NULL;
+  }
+
+  /* zero */
+  memset(self, 0, sizeof(ModeCore));
+
+  /* bind methods */
+  self->step      = ModeCore_step;
+  self->interrupt = ModeCore_interrupt;
+  self->ret       = ModeCore_ret;
+  self->get       = ModeCore_get;
+  self->set       = ModeCore_set;
+  self->cpsr      = ModeCore_cpsr;
+  self->setCpsr   = ModeCore_setCpsr;
+  self->free      = ModeCore_free;
+
+  /* as out of reset */
+  self->core = core;
+  self->setCpsr(self, MODE_SVC | MODE_PSR_I | MODE_PSR_F | MODE_PSR_T);
+
+  return self;
+}
+
+/*
+ * take an exception: the CPSR into the new mode's SPSR, a pointer switch
+ *  to its bank, the return address into its LR. Handlers run Thumb, as
+ *  with SCTLR.TE set, since Thumb is all this model executes.
+ */
+static void ModeCore_enter(ModeCore *self, ModeId mode, u32 vector, u32 lr)
+{
+  const ModeBank *bank = mode_banks[mode];
+
+  self->file[bank->spsr] = self->cpsr(self);
+  self->bank = bank;
+  self->file[bank->reg[6]] = lr;
+  self->file[MODE_CPSR_REG] = (self->file[MODE_CPSR_REG] & MODE_PSR_F)
+    | (mode == MODE_FIQ ? MODE_PSR_F : 0) | MODE_PSR_I | MODE_PSR_T | mode;
+  self->file[MODE_SYSPC_REG] = self->vectors + vector;
+  self->entries++;
+}
+
+/* exceptions by their instructions, the rest on the Core */
+CoreStatus ModeCore_step(ModeCore *self, unsigned instruction)
+{
+  CoreState *state = &self->core->state;
+  u32 pc = self->file[MODE_SYSPC_REG], a, b, result;
+  unsigned hd = (instruction & 7) | ((instruction >> 4) & 8);
+  unsigned hm = ((instruction >> 3) & 7) | ((instruction >> 3) & 8);
+  CoreStatus status;
+
+  /* SWI to Supervisor, LR the next instruction */
+  if ((instruction & 0xFF00) == 0xDF00)
+  {
+    ModeCore_enter(self, MODE_SVC, MODE_VECTOR_SWI, pc + 2);
+    return CORE_OK;
+  }
+
+  /* BKPT is a prefetch abort, LR the BKPT + 4 */
+  if ((instruction & 0xFF00) == 0xBE00)
+  {
+    ModeCore_enter(self, MODE_ABORT, MODE_VECTOR_PABT, pc + 4);
+    return CORE_OK;
+  }
+
+  /* the high register operations go through the bank */
+  switch (core_opcode(instruction))
+  {
+    case CORE_ADD_RD_RM:
+      self->set(self, hd, self->get(self, hd) + self->get(self, hm));
+      break;
+    case CORE_CMP_RM_RN_2:
+      a = self->get(self, hd);
+      b = ~self->get(self, hm);
+      result = a + b + 1;
+      state->c = (u32) (((unsigned long long) a + b + 1) >> 32);
+      state->v = (~(a ^ b) & (a ^ result)) >> 31;
+      state->n = result >> 31;
+      state->z = ! result;
+      break;
+    case CORE_MOV_RD_RM:
+      self->set(self, hd, self->get(self, hm));
+      break;
+    default:
+      if ((status = self->core->step(self->core, instruction)) != CORE_OK)
+      {
+        return status;
+      }
+      break;
+  }
+  self->file[MODE_SYSPC_REG] = pc + 2;
+
+  return CORE_OK;
+}
+
+/* IRQ and FIQ, LR the next instruction + 4 */
+ModeCore * ModeCore_interrupt(ModeCore *self, ModeId mode)
+{
+  u32 control = self->file[MODE_CPSR_REG];
+
+  if (
+         (mode != MODE_IRQ && mode != MODE_FIQ)
+      || (mode == MODE_IRQ && control & MODE_PSR_I)
+      || (mode == MODE_FIQ && control & MODE_PSR_F)
+      )
+  {
+    return NULL;
+  }
+  ModeCore_enter(self, mode, mode == MODE_IRQ ? MODE_VECTOR_IRQ
+      : MODE_VECTOR_FIQ, self->file[MODE_SYSPC_REG] + 4);
+
+  return self;
+}
+
+/* MOVS PC, LR or SUBS PC, LR, #4, by mode */
+ModeCore * ModeCore_ret(ModeCore *self)
+{
+  const ModeBank *bank = self->bank;
+  u32 pc = self->file[bank->reg[6]] - bank->lr_offset;
+
+  if (! bank->spsr || ! self->setCpsr(self, self->file[bank->spsr]))
+  {
+    return NULL;
+  }
+  self->file[MODE_SYSPC_REG] = pc;
+  self->returns++;
+
+  return self;
+}
+
+/* r0-r7 from the Core, the rest through the bank */
+u32 ModeCore_get(ModeCore *self, unsigned reg)
+{
+  if (reg < 8)
+  {
+    return self->core->state.r[reg];
+  }
+
+  return self->file[reg < 15 ? self->bank->reg[reg - 8] : MODE_SYSPC_REG];
+}
+
+/* r0-r7 to the Core, the rest through the bank */
+void ModeCore_set(ModeCore *self, unsigned reg, u32 value)
+{
+  if (reg < 8)
+  {
+    self->core->state.r[reg] = value;
+    return;
+  }
+
+  self->file[reg < 15 ? self->bank->reg[reg - 8] : MODE_SYSPC_REG] = value;
+}
+
+/* flags from the Core, the rest as kept */
+u32 ModeCore_cpsr(ModeCore *self)
+{
+  CoreState *state = &self->core->state;
+
+  return (state->n << 31) | (state->z << 30) | (state->c << 29)
+    | (state->v << 28) | self->file[MODE_CPSR_REG];
+}
+
+/* flags to the Core, the rest kept, and the bank of the mode */
+ModeCore * ModeCore_setCpsr(ModeCore *self, u32 psr)
+{
+  CoreState *state = &self->core->state;
+  const ModeBank *bank = mode_banks[psr & MODE_PSR_M];
+
+  if (! bank)
+  {
+    return NULL;
+  }
+  state->n = (psr >> 31) & 1;
+  state->z = (psr >> 30) & 1;
+  state->c = (psr >> 29) & 1;
+  state->v = (psr >> 28) & 1;
+  self->file[MODE_CPSR_REG] = psr & ~MODE_PSR_FLAGS;
+  self->bank = bank;
+
+  return self;
+}
+
+/* destructor */
+ModeCore * ModeCore_free(ModeCore *self)
+{
+  self->core->free(self->core);
+  free(self);
+
+  return NULL;
+}
@@ -0,0 +1,197 @@
+#ifndef __SOFT_STACK_MODE
+#define __SOFT_STACK_MODE
+
+#include "core.h"
+
+/**
+ * Registers of reg_file_constants.vhd a ModeCore keeps, indexed the same
+ *  way: USRSP_REG 13 to ABOSS_REG 41, as CHECKPOINT_REG_WORDS counts them
+ */
+#define MODE_FILE_REGS     42
+#define MODE_USRSP_REG     13
+#define MODE_USRLR_REG     14
+#define MODE_SYSPC_REG     15
+#define MODE_FIQ8_REG      17
+#define MODE_FIQSP_REG     22
+#define MODE_FIQLR_REG     23
+#define MODE_IRQSP_REG     24
+#define MODE_IRQLR_REG     25
+#define MODE_SVCSP_REG     26
+#define MODE_SVCLR_REG     27
+#define MODE_MONSP_REG     28
+#define MODE_MONLR_REG     29
+#define MODE_ABOSP_REG     30
+#define MODE_ABOLR_REG     31
+#define MODE_UNDSP_REG     32
+#define MODE_UNDLR_REG     33
+#define MODE_CPSR_REG      34
+#define MODE_FIQSS_REG     36
+#define MODE_IRQSS_REG     37
+#define MODE_SVCSS_REG     38
+#define MODE_MONSS_REG     39
+#define MODE_UNDSS_REG     40
+#define MODE_ABOSS_REG     41
+
+/** Program status register bits, PSR_* of reg_file_constants.vhd */
+#define MODE_PSR_N     0x80000000
+#define MODE_PSR_Z     0x40000000
+#define MODE_PSR_C     0x20000000
+#define MODE_PSR_V     0x10000000
+#define MODE_PSR_I     0x00000080
+#define MODE_PSR_F     0x00000040
+#define MODE_PSR_T     0x00000020
+#define MODE_PSR_M     0x0000001F
+
+/** Exception vectors, bytes from ModeCore::vectors */
+#define MODE_VECTOR_UNDEF 0x04
+#define MODE_VECTOR_SWI   0x08
+#define MODE_VECTOR_PABT  0x0C
+#define MODE_VECTOR_IRQ   0x18
+#define MODE_VECTOR_FIQ   0x1C
+
+/** Processor modes, PM_* of reg_file_constants.vhd */
+typedef enum _ModeId
+{
+  MODE_USER    = 0x10,
+  MODE_FIQ     = 0x11,
+  MODE_IRQ     = 0x12,
+  MODE_SVC     = 0x13,
+  MODE_MONITOR = 0x16,
+  MODE_ABORT   = 0x17,
+  MODE_UNDEF   = 0x1B,
+  MODE_SYSTEM  = 0x1F
+
+} ModeId;
+
+/**
+ * Where a mode's r8-r14 and SPSR are in the register file. There is one
+ *  of these per mode, never written, and switching modes is pointing at
+ *  another: nothing is copied in or out of a bank.
+ */
+typedef struct _ModeBank
+{
+  ModeId mode;
+
+  /** file index of r8 to r14 */
+  unsigned char reg[7];
+
+  /** file index of the SPSR, 0 for User and System, which have none */
+  unsigned char spsr;
+
+  /** what the return from an exception taken to this mode takes off LR */
+  unsigned char lr_offset;
+
+} ModeBank;
+
+/**
+ * A ModeCore is a Core with ARM processor modes. r0-r7 and the flags are
+ *  the Core's, which executes data processing on them as it does alone;
+ *  r8-r14, the PC, CPSR and SPSRs are in a register file laid out like
+ *  the RTL's, reached through the current mode's ModeBank. SWI and BKPT
+ *  are taken to SVC and Abort mode, and IRQ and FIQ come in from outside.
+ *  Thumb has no exception return, so ret does what MOVS PC, LR or SUBS
+ *  PC, LR, #4 would in the mode's handler.
+ */
+typedef struct _ModeCore
+{
+  /** the Core executing data processing, which this ModeCore owns */
+  Core *core;
+
+  /** the register file, by reg_file_constants.vhd index */
+  u32 file[MODE_FILE_REGS];
+
+  /** the current mode's bank, always that of the CPSR's mode bits */
+  const ModeBank *bank;
+
+  /** byte address of the vector table, 0 or the high vectors */
+  u32 vectors;
+
+  /** exceptions taken and returned from */
+  unsigned long long entries;
+  unsigned long long returns;
+
+  /**
+   * Execute a single instruction at the PC: SWI and BKPT enter their
+   *  exception, data processing runs on the Core, through the bank for
+   *  r8-r12, and moves the PC on
+   *
+   * @param instruction 16-bit Thumb code
+   * @return CORE_OK, or CORE_UNDEFINED leaving everything as it was
+   */
+  CoreStatus (*step)(struct _ModeCore *self, unsigned instruction);
+
+  /**
+   * Take an external interrupt between instructions
+   *
+   * @param mode MODE_IRQ or MODE_FIQ
+   * @return this ModeCore, or NULL if the CPSR masks it
+   */
+  struct _ModeCore * (*interrupt)(struct _ModeCore *self, ModeId mode);
+
+  /**
+   * Return from the current mode's exception: CPSR from the SPSR, PC from
+   *  LR less the mode's offset
+   *
+   * @return this ModeCore, or NULL in User or System mode
+   */
+  struct _ModeCore * (*ret)(struct _ModeCore *self);
+
+  /**
+   * Read a register of the current mode
+   *
+   * @param reg 0 to 15
+   * @return its value
+   */
+  u32 (*get)(struct _ModeCore *self, unsigned reg);
+
+  /**
+   * Write a register of the current mode
+   *
+   * @param reg 0 to 15
+   * @param value value to write
+   */
+  void (*set)(struct _ModeCore *self, unsigned reg, u32 value);
+
+  /**
+   * The CPSR, flags from the Core
+   *
+   * @return N, Z, C and V at the top, I, F, T and the mode at the bottom
+   */
+  u32 (*cpsr)(struct _ModeCore *self);
+
+  /**
+   * Write the CPSR as MSR would, switching banks if the mode changes
+   *
+   * @param psr new value, a mode the ModeId list has
+   * @return this ModeCore, or NULL leaving the CPSR as it was if the mode
+   *  bits are not a mode
+   */
+  struct _ModeCore * (*setCpsr)(struct _ModeCore *self, u32 psr);
+
+  /**
+   * Destructor, frees the Core as well
+   *
+   * @return NULL
+   */
+  struct _ModeCore * (*free)(struct _ModeCore *self);
+
+} ModeCore;
+
+/**
+ * The bank of a mode
+ *
+ * @param mode mode bits, the low five of a PSR
+ * @return its ModeBank, or NULL if the bits are not a mode
+ */
+const ModeBank * mode_bank(unsigned mode);
+
+/**
+ * Constructor, in Supervisor mode with IRQ and FIQ masked as out of reset,
+ *  everything else 0
+ *
+ * @param core Core to execute data processing, the ModeCore takes it over
+ * @return a new ModeCore, or NULL if core is NULL or out of memory
+ */
+ModeCore * newModeCore(Core *core);
+
+#endif /* __SOFT_STACK_MODE */
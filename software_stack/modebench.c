@@ -0,0 +1,312 @@
+/*
+ * Measures exception entry and return on a ModeCore, where a mode switch
+ *  points at another bank, against a model which keeps a single set of
+ *  r0-r15 and copies r8-r14 out and in on every switch. Both first run
+ *  -n random operations in lockstep: data processing including the high
+ *  registers, SWI, BKPT, IRQ, FIQ, returns, register writes and CPSR
+ *  writes, and have to agree on every register, the CPSR and the SPSR
+ *  after each. Then -p rounds of SWI, IRQ and FIQ entries, each with its
+ *  return, are timed each way.
+ *
+ * usage: modebench [-n operations] [-p rounds]
+ *
+ * build: cc -O2 -o modebench modebench.c mode.c core.c
+ */
+#include "bench.h"
+#include "mode.h"
+
+/* the flat model: r8-r14 of the current mode in the Core, saved by mode */
+typedef struct _ModeCopy
+{
+  Core *core;
+  u32 usr_hi[5];
+  u32 fiq_hi[5];
+  u32 sp[32];
+  u32 lr[32];
+  u32 spsr[32];
+  u32 control;
+  u32 pc;
+} ModeCopy;
+
+/* where the flat model saves a register of a mode */
+static u32 * modebench_slot(ModeCopy *copy, unsigned mode, unsigned reg)
+{
+  if (reg < 13)
+  {
+    return mode == MODE_FIQ ? &copy->fiq_hi[reg - 8] : &copy->usr_hi[reg - 8];
+  }
+  mode = mode == MODE_SYSTEM ? MODE_USER : mode;
+
+  return reg == 13 ? &copy->sp[mode] : &copy->lr[mode];
+}
+
+/* the flat model's CPSR */
+static u32 modebench_cpsr(ModeCopy *copy)
+{
+  CoreState *state = &copy->core->state;
+
+  return (state->n << 31) | (state->z << 30) | (state->c << 29)
+    | (state->v << 28) | copy->control;
+}
+
+/* the flat model's MSR: copy r8-r14 out to the old mode and in from the new */
+static int modebench_setCpsr(ModeCopy *copy, u32 psr)
+{
+  CoreState *state = &copy->core->state;
+  unsigned from = copy->control & MODE_PSR_M, to = psr & MODE_PSR_M, reg;
+
+  if (! mode_bank(to))
+  {
+    return -1;
+  }
+  for (reg = 8; reg < 15; reg++)
+  {
+    *modebench_slot(copy, from, reg) = state->r[reg];
+  }
+  for (reg = 8; reg < 15; reg++)
+  {
+    state->r[reg] = *modebench_slot(copy, to, reg);
+  }
+  state->n = (psr >> 31) & 1;
+  state->z = (psr >> 30) & 1;
+  state->c = (psr >> 29) & 1;
+  state->v = (psr >> 28) & 1;
+  copy->control = psr & 0x0FFFFFFF;
+
+  return 0;
+}
+
+/* the flat model's exception entry */
+static void modebench_enter(ModeCopy *copy, ModeId mode, u32 vector, u32 lr)
+{
+  u32 cpsr = modebench_cpsr(copy);
+
+  modebench_setCpsr(copy, (cpsr & (0xF0000000 | MODE_PSR_F))
+      | (mode == MODE_FIQ ? MODE_PSR_F : 0) | MODE_PSR_I | MODE_PSR_T | mode);
+  copy->spsr[mode] = cpsr;
+  copy->core->state.r[14] = lr;
+  copy->pc = vector;
+}
+
+/* the flat model's step, the Core running the high registers itself */
+static CoreStatus modebench_step(ModeCopy *copy, unsigned instruction)
+{
+  CoreStatus status;
+
+  if ((instruction & 0xFF00) == 0xDF00)
+  {
+    modebench_enter(copy, MODE_SVC, MODE_VECTOR_SWI, copy->pc + 2);
+    return CORE_OK;
+  }
+  if ((instruction & 0xFF00) == 0xBE00)
+  {
+    modebench_enter(copy, MODE_ABORT, MODE_VECTOR_PABT, copy->pc + 4);
+    return CORE_OK;
+  }
+  if ((status = copy->core->step(copy->core, instruction)) == CORE_OK)
+  {
+    copy->pc += 2;
+  }
+
+  return status;
+}
+
+/* the flat model's IRQ and FIQ */
+static int modebench_interrupt(ModeCopy *copy, ModeId mode)
+{
+  if (copy->control & (mode == MODE_IRQ ? MODE_PSR_I : MODE_PSR_F))
+  {
+    return -1;
+  }
+  modebench_enter(copy, mode, mode == MODE_IRQ ? MODE_VECTOR_IRQ
+      : MODE_VECTOR_FIQ, copy->pc + 4);
+
+  return 0;
+}
+
+/* the flat model's return */
+static int modebench_ret(ModeCopy *copy)
+{
+  unsigned mode = copy->control & MODE_PSR_M;
+  u32 pc = copy->core->state.r[14] - mode_bank(mode)->lr_offset;
+
+  if (mode_bank(mode)->spsr == 0 || modebench_setCpsr(copy, copy->spsr[mode]))
+  {
+    return -1;
+  }
+  copy->pc = pc;
+
+  return 0;
+}
+
+/* a data processing instruction the Core models, high registers r8-r12 */
+static unsigned modebench_op()
+{
+  unsigned instruction;
+
+  do
+  {
+    instruction = bench_random() % 0x4700;
+  }
+  while (core_opcode(instruction) == CORE_NUM_OPCODES);
+
+  return instruction;
+}
+
+/* every register, the CPSR and the current SPSR, returns differences */
+static unsigned long modebench_compare(ModeCore *banked, ModeCopy *copy)
+{
+  unsigned long errors = 0;
+  unsigned reg, mode = copy->control & MODE_PSR_M;
+
+  for (reg = 0; reg < 15; reg++)
+  {
+    errors += banked->get(banked, reg) != copy->core->state.r[reg];
+  }
+  errors += banked->get(banked, 15) != copy->pc;
+  errors += banked->cpsr(banked) != modebench_cpsr(copy);
+  errors += banked->bank->spsr
+    && banked->file[banked->bank->spsr] != copy->spsr[mode];
+
+  return errors;
+}
+
+int main(int argc, char **argv)
+{
+  static const ModeId modes[8] =
+  {
+    MODE_USER, MODE_FIQ, MODE_IRQ, MODE_SVC,
+    MODE_MONITOR, MODE_ABORT, MODE_UNDEF, MODE_SYSTEM
+  };
+  unsigned long operations = 1000000, rounds = 10000000, i, errors = 0;
+  unsigned instruction, reg;
+  double seconds[2][3];
+  ModeCore *banked;
+  ModeCopy copy;
+  u32 value;
+  int a, kind, ok[2];
+
+  /* options */
+  for (a = 1; a + 1 < argc && argv[a][0] == '-'; a += 2)
+  {
+    switch (argv[a][1])
+    {
+      case 'n': operations = strtoul(argv[a + 1], NULL, 0);  break;
+      case 'p': rounds     = strtoul(argv[a + 1], NULL, 0);  break;
+      default:  a = argc;                                    break;
+    }
+  }
+  if (a != argc || ! rounds)
+  {
+    fprintf(stderr, "usage: %s [-n operations] [-p rounds]\n", argv[0]);
+    return 1;
+  }
+
+  memset(&copy, 0, sizeof(copy));
+  if (
+         ! (banked = newModeCore(newThumbCore()))
+      || ! (copy.core = newThumbCore())
+      )
+  {
+    fprintf(stderr, "out of memory\n");
+    return 1;
+  }
+  copy.control = MODE_SVC | MODE_PSR_I | MODE_PSR_F | MODE_PSR_T;
+
+  /* both ways in lockstep */
+  for (i = 0; i < operations; i++)
+  {
+    kind = bench_random() % 16;
+    switch (kind)
+    {
+      case 9:
+      case 10:
+        instruction = (kind == 9 ? 0xDF00 : 0xBE00)
+          | (bench_random() & 0xFF);
+        ok[0] = banked->step(banked, instruction) == CORE_OK;
+        ok[1] = modebench_step(&copy, instruction) == CORE_OK;
+        break;
+      case 11:
+      case 12:
+        ok[0] = banked->interrupt(banked, kind == 11 ? MODE_IRQ : MODE_FIQ)
+          != NULL;
+        ok[1] = ! modebench_interrupt(&copy, kind == 11 ? MODE_IRQ
+            : MODE_FIQ);
+        break;
+      case 13:
+        ok[0] = banked->ret(banked) != NULL;
+        ok[1] = ! modebench_ret(&copy);
+        break;
+      case 14:
+        reg = 8 + bench_random() % 7;
+        value = bench_random();
+        banked->set(banked, reg, value);
+        copy.core->state.r[reg] = value;
+        ok[0] = ok[1] = 1;
+        break;
+      case 15:
+        value = (bench_random() & ~MODE_PSR_M)
+          | modes[bench_random() % 8];
+        ok[0] = banked->setCpsr(banked, value) != NULL;
+        ok[1] = ! modebench_setCpsr(&copy, value);
+        break;
+      default:
+        instruction = modebench_op();
+        ok[0] = banked->step(banked, instruction) == CORE_OK;
+        ok[1] = modebench_step(&copy, instruction) == CORE_OK;
+        break;
+    }
+    errors += ok[0] != ok[1] || modebench_compare(banked, &copy);
+  }
+  printf("lockstep          %lu operations, %llu exceptions taken, %llu "
+      "returns, %lu wrong\n", operations, banked->entries, banked->returns,
+      errors);
+
+  /* entry and return, from User mode with both interrupts unmasked */
+  banked->setCpsr(banked, MODE_USER | MODE_PSR_T);
+  modebench_setCpsr(&copy, MODE_USER | MODE_PSR_T);
+  for (kind = 0; kind < 3; kind++)
+  {
+    seconds[0][kind] = bench_now();
+    for (i = 0; i < rounds; i++)
+    {
+      if (kind == 0)
+      {
+        banked->step(banked, 0xDF00);
+      }
+      else
+      {
+        banked->interrupt(banked, kind == 1 ? MODE_IRQ : MODE_FIQ);
+      }
+      banked->ret(banked);
+    }
+    seconds[0][kind] = bench_now() - seconds[0][kind];
+
+    seconds[1][kind] = bench_now();
+    for (i = 0; i < rounds; i++)
+    {
+      if (kind == 0)
+      {
+        modebench_step(&copy, 0xDF00);
+      }
+      else
+      {
+        modebench_interrupt(&copy, kind == 1 ? MODE_IRQ : MODE_FIQ);
+      }
+      modebench_ret(&copy);
+    }
+    seconds[1][kind] = bench_now() - seconds[1][kind];
+  }
+  errors += modebench_compare(banked, &copy);
+  printf("SWI               %.2f ns banked, %.2f ns copying, entry and "
+      "return\n", seconds[0][0] * 1e9 / rounds, seconds[1][0] * 1e9 / rounds);
+  printf("IRQ               %.2f ns banked, %.2f ns copying\n",
+      seconds[0][1] * 1e9 / rounds, seconds[1][1] * 1e9 / rounds);
+  printf("FIQ               %.2f ns banked, %.2f ns copying\n",
+      seconds[0][2] * 1e9 / rounds, seconds[1][2] * 1e9 / rounds);
+
+  banked->free(banked);
+  copy.core->free(copy.core);
+
+  return errors != 0;
+}
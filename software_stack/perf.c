@@ -0,0 +1,125 @@
+#include "perf.h"
+
+/* method forward decls */
+PerfModel * PerfModel_count(PerfModel *self, PerfCounter counter, u32 n);
+PerfModel * PerfModel_cycle(PerfModel *self, unsigned state,
+    unsigned stalled);
+PerfModel * PerfModel_control(PerfModel *self, u32 ctrl);
+PerfModel * PerfModel_free(PerfModel *self);
+void PerfModel_onUser(RegFile *regfile, unsigned reg, u32 data);
+
+/* copy the snapshot into the RegFile's status words */
+static void PerfModel_publish(PerfModel *self)
+{
+  int i;
+
+  self->regfile->status[PERF_USER_CTRL] =
+    (self->snapshots << 16) | (self->frozen ? PERF_FREEZE : 0);
+  for (i = 0; i < PERF_N; i++)
+  {
+    self->regfile->status[PERF_USER_COUNTERS + i] = self->snap[i];
+  }
+}
+
+/* constructor */
+PerfModel * newPerfModel(RegFile *regfile)
+{
+  PerfModel *self = regfile ? (PerfModel *) malloc(sizeof(PerfModel)) : NULL;
+
+  /* out of memory */
+  if (! self)
+  {
+    return NULL;
+  }
+
+  /* zero */
+  memset(self, 0, sizeof(PerfModel));
+
+  /* bind methods */
+  self->count   = PerfModel_count;
+  self->cycle   = PerfModel_cycle;
+  self->control = PerfModel_control;
+  self->free    = PerfModel_free;
+
+  /* take over the user space */
+  self->regfile     = regfile;
+  self->chained     = regfile->onUser;
+  regfile->onUser   = PerfModel_onUser;
+  regfile->owner    = self;
+  PerfModel_publish(self);
+
+  return self;
+}
+
+/* bump a live counter */
+PerfModel * PerfModel_count(PerfModel *self, PerfCounter counter, u32 n)
+{
+  if (! self->frozen && counter < PERF_N)
+  {
+    self->live[counter] += n;
+  }
+
+  return self;
+}
+
+/* a single cycle in a state */
+PerfModel * PerfModel_cycle(PerfModel *self, unsigned state,
+    unsigned stalled)
+{
+  if (state >= 1 && state <= PERF_N_STATES)
+  {
+    self->count(self, PERF_STATES + state - 1, 1);
+  }
+  if (stalled)
+  {
+    self->count(self, PERF_STALLS, 1);
+  }
+
+  return self;
+}
+
+/* software control, snapshot before clearing */
+PerfModel * PerfModel_control(PerfModel *self, u32 ctrl)
+{
+  self->frozen = ctrl & PERF_FREEZE;
+  if (ctrl & PERF_SNAPSHOT)
+  {
+    memcpy(self->snap, self->live, sizeof(self->snap));
+    self->snapshots = (self->snapshots + 1) & 0xFFFF;
+  }
+  if (ctrl & PERF_CLEAR)
+  {
+    memset(self->live, 0, sizeof(self->live));
+  }
+  PerfModel_publish(self);
+
+  return self;
+}
+
+/* user space writes from software */
+void PerfModel_onUser(RegFile *regfile, unsigned reg, u32 data)
+{
+  PerfModel *self = (PerfModel *) regfile->owner;
+
+  if (reg == PERF_USER_CTRL)
+  {
+    self->control(self, data);
+  }
+  else if (self->chained)
+  {
+    self->chained(regfile, reg, data);
+  }
+}
+
+/* destructor */
+PerfModel * PerfModel_free(PerfModel *self)
+{
+  if (self)
+  {
+    self->regfile->onUser = self->chained;
+    self->regfile->owner  = NULL;
+    free(self);
+  }
+
+  return NULL;
+}
@@ -0,0 +1,102 @@
+#ifndef __SOFT_STACK_PERF
+#define __SOFT_STACK_PERF
+
+#include "regfile.h"
+
+/** Number of state machine states with a cycle counter, states 1 and up */
+#define PERF_N_STATES 9
+
+/** User space words, must match USR_PERF_* in reg_file_constants.vhd */
+#define PERF_USER_CTRL     5
+#define PERF_USER_COUNTERS 6
+
+/** Control word bits, must match perf_counters.vhd */
+typedef enum _PerfControl
+{
+  PERF_FREEZE   = 0x00000001,
+  PERF_SNAPSHOT = 0x00000002,
+  PERF_CLEAR    = 0x00000004
+} PerfControl;
+
+/** Counters, in user space order starting at PERF_USER_COUNTERS */
+typedef enum _PerfCounter
+{
+  PERF_RETIRED = 0,
+  PERF_BRANCHES,
+  PERF_LOADS,
+  PERF_STORES,
+  PERF_STALLS,
+  PERF_STATES,
+  PERF_N = PERF_STATES + PERF_N_STATES
+} PerfCounter;
+
+/**
+ * A PerfModel models simple_processor's performance counters. Processor
+ *  models bump the live counters, and software snapshots them through
+ *  the RegFile it is attached to, exactly as with perf_counters.vhd.
+ */
+typedef struct _PerfModel
+{
+  /** live counters, and the copy software reads */
+  u32 live[PERF_N];
+  u32 snap[PERF_N];
+
+  /** non-zero while counting is frozen */
+  unsigned frozen;
+
+  /** number of snapshots taken */
+  unsigned snapshots;
+
+  /** RegFile this PerfModel is attached to */
+  RegFile *regfile;
+
+  /** user space handler which was installed before this one, or NULL */
+  void (*chained)(RegFile *regfile, unsigned reg, u32 data);
+
+  /**
+   * Add to a live counter, unless frozen
+   *
+   * @param counter counter to add to
+   * @param n amount to add
+   * @return this PerfModel
+   */
+  struct _PerfModel * (*count)(struct _PerfModel *self, PerfCounter counter,
+      u32 n);
+
+  /**
+   * Account for a single cycle spent in a state, unless frozen
+   *
+   * @param state state machine state, 1 through PERF_N_STATES
+   * @param stalled non-zero if the cycle was spent waiting
+   * @return this PerfModel
+   */
+  struct _PerfModel * (*cycle)(struct _PerfModel *self, unsigned state,
+      unsigned stalled);
+
+  /**
+   * Apply a control word, as if software had written it
+   *
+   * @param ctrl PerfControl bits
+   * @return this PerfModel
+   */
+  struct _PerfModel * (*control)(struct _PerfModel *self, u32 ctrl);
+
+  /**
+   * Destructor, restores the RegFile's previous user space handler
+   *
+   * @return NULL
+   */
+  struct _PerfModel * (*free)(struct _PerfModel *self);
+
+} PerfModel;
+
+/**
+ * Constructor, takes over the control word and counter words of a
+ *  RegFile's user space
+ *
+ * @param regfile RegFile software reads the counters through
+ * @return a new PerfModel, or NULL if out of memory
+ */
+PerfModel * newPerfModel(RegFile *regfile);
+
+#endif /* __SOFT_STACK_PERF */
@@ -0,0 +1,171 @@
+#include "regfile.h"
+
+/* method forward decls */
+u32 RegFile_read(Device *device, u32 offset);
+void RegFile_write(Device *device, u32 offset, u32 data);
+RegFile * RegFile_reset(RegFile *self);
+RegFile * RegFile_free(RegFile *self);
+
+/* constructor */
+RegFile * newRegFile(u32 base, unsigned num_regs)
+{
+  RegFile *self = (RegFile *) malloc(sizeof(RegFile));
+
+  /* out of memory */
+  if (! self)
+  {
+    return NULL;
+  }
+
+  /* zero */
+  memset(self, 0, sizeof(RegFile));
+
+  if (! num_regs || ! (self->mem = (u32 *) calloc(num_regs, sizeof(u32))))
+  {
+    free(self);
+    return NULL;
+  }
+  self->num_regs = num_regs;
+
+  /* bind methods */
+  self->device.base  = base;
+  self->device.size  = REGFILE_SIZE;
+  self->device.read  = RegFile_read;
+  self->device.write = RegFile_write;
+  self->reset        = RegFile_reset;
+  self->free         = RegFile_free;
+
+  /* the address range is already taken */
+  if (hal_attach(&self->device))
+  {
+    free(self->mem);
+    free(self);
+    return NULL;
+  }
+
+  return self;
+}
+
+/* read through the side channel, or from the user space */
+u32 RegFile_read(Device *device, u32 offset)
+{
+  RegFile *self = (RegFile *) device;
+  unsigned code = offset / 4;
+
+  /* nothing readable in the soft reset space */
+  if (offset >= REGFILE_SOFT_RST_OFFSET)
+  {
+    return 0;
+  }
+
+  /* status words from the hardware model */
+  if (code >= REGFILE_USER_BASE)
+  {
+    return code - REGFILE_USER_BASE < REGFILE_USER_N_REGS
+      ? self->status[code - REGFILE_USER_BASE]
+      : 0;
+  }
+
+  /* memory is only read through PERFORM_OP, the result sticks around */
+  if (code == REGFILE_PERFORM_OP)
+  {
+    self->data_out = self->mem[
+        self->address < self->num_regs ? self->address : self->num_regs - 1
+        ];
+  }
+
+  return self->data_out;
+}
+
+/* write through the side channel, or into the user space */
+void RegFile_write(Device *device, u32 offset, u32 data)
+{
+  RegFile *self = (RegFile *) device;
+  unsigned code = offset / 4, index;
+
+  /* soft reset */
+  if (offset >= REGFILE_SOFT_RST_OFFSET)
+  {
+    if (data == REGFILE_SOFT_RESET)
+    {
+      self->reset(self);
+    }
+    return;
+  }
+
+  switch (code)
+  {
+    case REGFILE_SET_ADDRESS:
+      self->address = data;
+      break;
+
+    case REGFILE_SET_DATA:
+      self->data = data;
+      break;
+
+    case REGFILE_PERFORM_OP:
+      index = self->address < self->num_regs ? self->address
+        : self->num_regs - 1;
+      self->mem[index] = self->data;
+      if (self->dirty)
+      {
+        index >>= REGFILE_PAGE_SHIFT;
+        self->dirty[index / 64] |= 1ULL << (index % 64);
+      }
+      break;
+
+    case REGFILE_CLEAR:
+      self->address = self->data = 0;
+      self->pulse = 0;
+      break;
+
+    case REGFILE_PULSE:
+      self->pulse ^= 1;
+      if (self->onPulse)
+      {
+        self->onPulse(self, self->pulse);
+      }
+      break;
+
+    default:
+      if (
+             code >= REGFILE_USER_BASE
+          && code - REGFILE_USER_BASE < REGFILE_USER_N_REGS
+          && self->onUser
+          )
+      {
+        self->onUser(self, code - REGFILE_USER_BASE, data);
+      }
+      break;
+  }
+}
+
+/* zero memory and side channel */
+RegFile * RegFile_reset(RegFile *self)
+{
+  unsigned page;
+
+  memset(self->mem, 0, self->num_regs * sizeof(u32));
+  for (page = 0; self->dirty && page * REGFILE_PAGE_WORDS < self->num_regs;
+      page++)
+  {
+    self->dirty[page / 64] |= 1ULL << (page % 64);
+  }
+  self->address = self->data = self->data_out = 0;
+  self->pulse = 0;
+
+  return self;
+}
+
+/* destructor */
+RegFile * RegFile_free(RegFile *self)
+{
+  if (self)
+  {
+    hal_detach(&self->device);
+    free(self->mem);
+    free(self);
+  }
+
+  return NULL;
+}
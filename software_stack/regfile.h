@@ -0,0 +1,110 @@
+#ifndef __SOFT_STACK_REGFILE
+#define __SOFT_STACK_REGFILE
+
+#include "hal.h"
+
+/** Side channel codes, must match edkregfile's user_logic.vhd */
+typedef enum _RegFileCode
+{
+  REGFILE_NO_ACTION = 0,
+  REGFILE_SET_ADDRESS,
+  REGFILE_SET_DATA,
+  REGFILE_PERFORM_OP,
+  REGFILE_CLEAR,
+  REGFILE_PULSE,
+  REGFILE_USER_BASE
+} RegFileCode;
+
+/** Number of user space words, codes REGFILE_USER_BASE and up */
+#define REGFILE_USER_N_REGS 26
+
+/** Bytes decoded by an edkregfile: user space then soft reset space */
+#define REGFILE_SIZE 0x200
+
+/** Soft reset space, and the value which triggers a reset */
+#define REGFILE_SOFT_RST_OFFSET 0x100
+#define REGFILE_SOFT_RESET      0x0000000A
+
+/** Memory words per page, the unit a RegFile tracks writes in */
+#define REGFILE_PAGE_SHIFT 6
+#define REGFILE_PAGE_WORDS (1 << REGFILE_PAGE_SHIFT)
+
+/**
+ * A RegFile models an edkregfile peripheral: NUM_REGS words reached
+ *  through the side channel codes, plus the user space status words
+ *  driven by the hardware on its other side.
+ */
+typedef struct _RegFile
+{
+  /** bus model view of this RegFile, must stay the first member */
+  Device device;
+
+  /** memory words */
+  u32 *mem;
+
+  /** number of memory words */
+  unsigned num_regs;
+
+  /** side channel address and data latched by software */
+  u32 address;
+  u32 data;
+
+  /** last word read through PERFORM_OP, returned by every read */
+  u32 data_out;
+
+  /** state of the outbound clock */
+  unsigned pulse;
+
+  /**
+   * Bit per memory page written since whoever owns this bitmap last
+   *  cleared it, or NULL to track nothing
+   */
+  unsigned long long *dirty;
+
+  /** user space status words, set by the hardware model */
+  u32 status[REGFILE_USER_N_REGS];
+
+  /** hardware model on the other side, handed back to the hooks */
+  void *owner;
+
+  /**
+   * Called whenever software toggles the outbound clock, or NULL
+   *
+   * @param level new level of the outbound clock
+   */
+  void (*onPulse)(struct _RegFile *self, unsigned level);
+
+  /**
+   * Called whenever software writes the user space, or NULL
+   *
+   * @param reg user space word, 0 through REGFILE_USER_N_REGS-1
+   * @param data the word written
+   */
+  void (*onUser)(struct _RegFile *self, unsigned reg, u32 data);
+
+  /**
+   * Zero memory and the side channel, as the soft reset does
+   *
+   * @return this RegFile
+   */
+  struct _RegFile * (*reset)(struct _RegFile *self);
+
+  /**
+   * Destructor, detaches this RegFile from the bus model
+   *
+   * @return NULL
+   */
+  struct _RegFile * (*free)(struct _RegFile *self);
+
+} RegFile;
+
+/**
+ * Constructor, attaches the new RegFile to the bus model
+ *
+ * @param base base address, XPAR_EDKREGFILE_0_BASEADDR on the ZedBoard
+ * @param num_regs number of memory words, NUM_REGS in the mpd
+ * @return a new RegFile, or NULL if out of memory or base is taken
+ */
+RegFile * newRegFile(u32 base, unsigned num_regs);
+
+#endif /* __SOFT_STACK_REGFILE */
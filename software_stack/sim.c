@@ -0,0 +1,323 @@
+#include "sim.h"
+
+/* method forward decls */
+SimEvent * Sim_schedule(Sim *self, SimTime delay,
+    void (*fire)(Sim *sim, void *owner, u32 data), void *owner, u32 data);
+Sim * Sim_cancel(Sim *self, SimEvent *event);
+unsigned long long Sim_run(Sim *self, SimTime until);
+Sim * Sim_free(Sim *self);
+
+/* file an event in the slot covering its clock */
+static void Sim_insert(Sim *self, SimEvent *event)
+{
+  SimTime delta = event->time - self->now;
+  unsigned level = 0, index;
+  SimSlot *slot;
+
+  while (level < SIM_LEVELS - 1
+      && delta >> (SIM_SLOT_BITS * (level + 1)))
+  {
+    level++;
+  }
+  index = (unsigned) (event->time >> (SIM_SLOT_BITS * level))
+    & (SIM_SLOTS - 1);
+  slot = &self->wheel[level][index];
+
+  /* append, keeping events on the same clock in order */
+  event->slot = slot;
+  event->next = NULL;
+  event->prev = slot->tail;
+  if (slot->tail)
+  {
+    slot->tail->next = event;
+  }
+  else
+  {
+    slot->head = event;
+  }
+  slot->tail = event;
+
+  self->occupied[level][index / 64] |= 1ULL << (index % 64);
+}
+
+/* take an event out of its slot */
+static void Sim_remove(Sim *self, SimEvent *event)
+{
+  SimSlot *slot = event->slot;
+  unsigned index, level;
+
+  if (event->prev)
+  {
+    event->prev->next = event->next;
+  }
+  else
+  {
+    slot->head = event->next;
+  }
+  if (event->next)
+  {
+    event->next->prev = event->prev;
+  }
+  else
+  {
+    slot->tail = event->prev;
+  }
+
+  /* slot emptied */
+  if (! slot->head)
+  {
+    index = (unsigned) (slot - self->wheel[0]);
+    level = index / SIM_SLOTS;
+    index %= SIM_SLOTS;
+    self->occupied[level][index / 64] &= ~(1ULL << (index % 64));
+  }
+
+  event->slot = NULL;
+}
+
+/* first occupied slot of a level at or after 'from', SIM_SLOTS if none */
+static unsigned Sim_nextSlot(Sim *self, unsigned level, unsigned from)
+{
+  unsigned long long *occupied = self->occupied[level];
+  unsigned word = from / 64;
+  unsigned long long bits;
+
+  if (from >= SIM_SLOTS)
+  {
+    return SIM_SLOTS;
+  }
+
+  bits = occupied[word] & (~0ULL << (from % 64));
+  while (! bits)
+  {
+    if (++word == SIM_SLOTS / 64)
+    {
+      return SIM_SLOTS;
+    }
+    bits = occupied[word];
+  }
+
+  return word * 64 + (unsigned) __builtin_ctzll(bits);
+}
+
+/*
+ * The next clock anything can cascade on, once level 0 has nothing left
+ *  this turn. Every level below the one found is empty, so the clock can
+ *  jump straight there.
+ */
+static SimTime Sim_nextCascade(Sim *self)
+{
+  unsigned level, shift, index, found;
+
+  for (level = 0; level < SIM_LEVELS; level++)
+  {
+    shift = SIM_SLOT_BITS * level;
+    index = (unsigned) (self->now >> shift) & (SIM_SLOTS - 1);
+
+    /* an occupied slot later in this turn, level 0 was searched already */
+    if (level && (found = Sim_nextSlot(self, level, index + 1)) < SIM_SLOTS)
+    {
+      return ((self->now >> (shift + SIM_SLOT_BITS))
+          << (shift + SIM_SLOT_BITS)) + ((SimTime) found << shift);
+    }
+
+    /* slots left behind belong to the next turn */
+    if (Sim_nextSlot(self, level, 0) < SIM_SLOTS)
+    {
+      return ((self->now >> (shift + SIM_SLOT_BITS)) + 1)
+        << (shift + SIM_SLOT_BITS);
+    }
+  }
+
+  /* only reached with nothing pending */
+  return self->now + 1;
+}
+
+/* move the slots the clock has just reached down a level */
+static void Sim_cascade(Sim *self)
+{
+  SimEvent *cur, *next;
+  SimSlot *slot;
+  int level;
+
+  /* highest level first, so events can fall more than 1 level */
+  for (level = SIM_LEVELS - 1; level > 0; level--)
+  {
+    if (self->now & ((1ULL << (SIM_SLOT_BITS * level)) - 1))
+    {
+      continue;
+    }
+
+    slot = &self->wheel[level][
+        (self->now >> (SIM_SLOT_BITS * level)) & (SIM_SLOTS - 1)
+        ];
+    cur = slot->head;
+    slot->head = slot->tail = NULL;
+    self->occupied[level][(slot - self->wheel[level]) / 64] &=
+      ~(1ULL << ((slot - self->wheel[level]) % 64));
+    for (; cur; cur = next)
+    {
+      next = cur->next;
+      Sim_insert(self, cur);
+    }
+  }
+}
+
+/* constructor */
+Sim * newSim(unsigned max_events)
+{
+  Sim *self = (Sim *) malloc(sizeof(Sim));
+  unsigned i;
+
+  /* out of memory */
+  if (! self)
+  {
+    return NULL;
+  }
+
+  /* zero */
+  memset(self, 0, sizeof(Sim));
+
+  if (
+         ! max_events
+      || ! (self->pool = (SimEvent *) calloc(max_events, sizeof(SimEvent)))
+      )
+  {
+    free(self);
+    return NULL;
+  }
+  self->pool_size = max_events;
+
+  /* every event starts out spare */
+  for (i = 0; i < max_events; i++)
+  {
+    self->pool[i].next = self->spare;
+    self->spare = &self->pool[i];
+  }
+
+  /* bind methods */
+  self->schedule = Sim_schedule;
+  self->cancel   = Sim_cancel;
+  self->run      = Sim_run;
+  self->free     = Sim_free;
+
+  return self;
+}
+
+/* take a spare event and file it */
+SimEvent * Sim_schedule(Sim *self, SimTime delay,
+    void (*fire)(Sim *sim, void *owner, u32 data), void *owner, u32 data)
+{
+  SimEvent *event = self->spare;
+
+  /* pool exhausted, or beyond the top wheel */
+  if (! event || delay > SIM_MAX_DELAY)
+  {
+    return NULL;
+  }
+  self->spare = event->next;
+
+  event->time  = self->now + delay;
+  event->fire  = fire;
+  event->owner = owner;
+  event->data  = data;
+  Sim_insert(self, event);
+  self->pending++;
+
+  return event;
+}
+
+/* unschedule */
+Sim * Sim_cancel(Sim *self, SimEvent *event)
+{
+  if (event && event->slot)
+  {
+    Sim_remove(self, event);
+    event->next = self->spare;
+    self->spare = event;
+    self->pending--;
+  }
+
+  return self;
+}
+
+/* fire events in order up to and including 'until' */
+unsigned long long Sim_run(Sim *self, SimTime until)
+{
+  unsigned long long fired = self->fired;
+  unsigned index, found;
+  SimTime next;
+  SimSlot *slot;
+  SimEvent *event;
+
+  while (self->pending && self->now <= until)
+  {
+    index = (unsigned) (self->now & (SIM_SLOTS - 1));
+    found = Sim_nextSlot(self, 0, index);
+
+    /* nothing more this turn of level 0, jump to the next cascade */
+    if (found == SIM_SLOTS)
+    {
+      next = Sim_nextCascade(self);
+      if (next > until)
+      {
+        self->now = until;
+        break;
+      }
+      self->now = next;
+      Sim_cascade(self);
+      continue;
+    }
+
+    /* skip to the occupied slot */
+    if (found - index > until - self->now)
+    {
+      self->now = until;
+      break;
+    }
+    self->now += found - index;
+
+    /* fire everything due, including events added while firing */
+    slot = &self->wheel[0][found];
+    while ((event = slot->head))
+    {
+      Sim_remove(self, event);
+      event->next = self->spare;
+      self->spare = event;
+      self->pending--;
+      self->fired++;
+      event->fire(self, event->owner, event->data);
+    }
+
+    /* step past this clock, unless it was the last one wanted */
+    if (self->now == until)
+    {
+      break;
+    }
+    self->now++;
+    if (! (self->now & (SIM_SLOTS - 1)))
+    {
+      Sim_cascade(self);
+    }
+  }
+
+  /* nothing left to do, time still passes */
+  if (! self->pending && self->now < until)
+  {
+    self->now = until;
+  }
+
+  return self->fired - fired;
+}
+
+/* destructor */
+Sim * Sim_free(Sim *self)
+{
+  if (self)
+  {
+    free(self->pool);
+    free(self);
+  }
+
+  return NULL;
+}
@@ -0,0 +1,131 @@
+#ifndef __SOFT_STACK_SIM
+#define __SOFT_STACK_SIM
+
+#include "hal.h"
+
+/** Timing wheel shape: SIM_LEVELS wheels of SIM_SLOTS clocks each */
+#define SIM_LEVELS     4
+#define SIM_SLOT_BITS  8
+#define SIM_SLOTS      (1 << SIM_SLOT_BITS)
+
+/** Longest delay an event can be scheduled with, in clocks */
+#define SIM_MAX_DELAY  0xFFFFFFFFUL
+
+/** Simulated time, in clocks */
+typedef unsigned long long SimTime;
+
+struct _Sim;
+struct _SimSlot;
+
+/**
+ * A SimEvent is a callback due at a given clock. Events come out of a pool
+ *  allocated once by newSim, so scheduling never touches the heap.
+ */
+typedef struct _SimEvent
+{
+  /** clock this event fires on */
+  SimTime time;
+
+  /** neighbours in its wheel slot, and the slot itself */
+  struct _SimEvent *next;
+  struct _SimEvent *prev;
+  struct _SimSlot *slot;
+
+  /**
+   * Called when the event is due, the event is back in the pool by then
+   *  so the callback may schedule again straight away
+   *
+   * @param sim kernel running the event
+   * @param owner model the event was scheduled for
+   * @param data word the event was scheduled with
+   */
+  void (*fire)(struct _Sim *sim, void *owner, u32 data);
+
+  /** handed back to fire */
+  void *owner;
+  u32 data;
+
+} SimEvent;
+
+/** Events due in the same wheel slot, oldest first */
+typedef struct _SimSlot
+{
+  SimEvent *head;
+  SimEvent *tail;
+} SimSlot;
+
+/**
+ * A Sim is a discrete event kernel. Pending events sit in a hierarchical
+ *  timing wheel: level 0 holds the next SIM_SLOTS clocks one slot per
+ *  clock, and each level above covers SIM_SLOTS times as much, cascading
+ *  down a slot at a time as the clock reaches it. Empty stretches are
+ *  skipped a slot at a time on whichever level is occupied, so idle time
+ *  costs next to nothing. Events due on the same clock fire in the order
+ *  they were scheduled.
+ */
+typedef struct _Sim
+{
+  /** current clock */
+  SimTime now;
+
+  /** the wheels, and which of their slots hold anything */
+  SimSlot wheel[SIM_LEVELS][SIM_SLOTS];
+  unsigned long long occupied[SIM_LEVELS][SIM_SLOTS / 64];
+
+  /** every event, and those not scheduled */
+  SimEvent *pool;
+  SimEvent *spare;
+  unsigned pool_size;
+
+  /** events scheduled, and events fired since construction */
+  unsigned pending;
+  unsigned long long fired;
+
+  /**
+   * Schedule a callback
+   *
+   * @param delay clocks from now, 0 fires later during this clock
+   * @param fire callback
+   * @param owner handed back to fire
+   * @param data handed back to fire
+   * @return the event, or NULL if the pool is empty or delay is too long
+   */
+  SimEvent * (*schedule)(struct _Sim *self, SimTime delay,
+      void (*fire)(struct _Sim *sim, void *owner, u32 data),
+      void *owner, u32 data);
+
+  /**
+   * Take back a scheduled event before it fires
+   *
+   * @param event event returned by schedule, which has not fired yet
+   * @return this Sim
+   */
+  struct _Sim * (*cancel)(struct _Sim *self, SimEvent *event);
+
+  /**
+   * Fire events in order until none are left or the next one is due
+   *  after a given clock, leaving now at that clock
+   *
+   * @param until last clock to simulate
+   * @return the number of events fired
+   */
+  unsigned long long (*run)(struct _Sim *self, SimTime until);
+
+  /**
+   * Destructor
+   *
+   * @return NULL
+   */
+  struct _Sim * (*free)(struct _Sim *self);
+
+} Sim;
+
+/**
+ * Constructor
+ *
+ * @param max_events most events ever scheduled at once
+ * @return a new Sim, or NULL if out of memory
+ */
+Sim * newSim(unsigned max_events);
+
+#endif /* __SOFT_STACK_SIM */
@@ -0,0 +1,245 @@
+/*
+ * Measures fork-server resets for fuzzing. A program is loaded and the
+ *  gate and key booted, then every run feeds a random input of -l words
+ *  to the models: RegFile stores through the side channel, writes to any
+ *  gate or key register, and patched Instructions, with a gate check
+ *  after each. Between runs the machine goes back to how it booted two
+ *  ways: a Snapshot reset, and the way it is done without one, freeing
+ *  the Stack, newStack, and copying memory and models back whole. Every
+ *  -v'th run the state is checked against the boot state.
+ *
+ * usage: snapbench [-m memory words] [-c halfwords] [-l input words]
+ *                  [-n runs] [-v verify every]
+ *
+ * build: cc -O2 -o snapbench snapbench.c snapshot.c checkpoint.c stack.c
+ *         decode.c regfile.c gate.c key.c sim.c hal.c
+ */
+#include "bench.h"
+#include "snapshot.h"
+
+/* where the models sit on the bus */
+#define SNAP_REGFILE_BASE 0x40000000
+#define SNAP_GATE_BASE    0x41000000
+#define SNAP_KEY_BASE     0x42000000
+
+/* a run: an input word each, by its low bits */
+static void snapbench_run(Snapshot *snapshot, RegFile *regfile,
+    GateModel *gate, Stack *stack, size_t halfwords, unsigned length)
+{
+  AxiTxn txn;
+  unsigned i, word, index = 0;
+  Instruction *instruction;
+
+  memset(&txn, 0, sizeof(txn));
+  for (i = 0; i < length; i++)
+  {
+    word = bench_random();
+    switch (word & 3)
+    {
+      case 0:
+        Xil_Out32(SNAP_REGFILE_BASE + REGFILE_SET_ADDRESS * 4,
+            (word >> 2) % regfile->num_regs);
+        Xil_Out32(SNAP_REGFILE_BASE + REGFILE_SET_DATA * 4,
+            bench_random());
+        Xil_Out32(SNAP_REGFILE_BASE + REGFILE_PERFORM_OP * 4, 0);
+        break;
+
+      case 1:
+        Xil_Out32(SNAP_GATE_BASE + ((word >> 2) % GATE_SIZE & ~3),
+            bench_random());
+        break;
+
+      case 2:
+        Xil_Out32(SNAP_KEY_BASE + ((word >> 2) % KEY_SIZE & ~3),
+            bench_random());
+        break;
+
+      default:
+        index = (word >> 2) % halfwords;
+        if (snapshot)
+        {
+          snapshot->patch(snapshot, index, bench_random() & 0xFFFF);
+        }
+        else
+        {
+          for (instruction = stack->trunk; index--;
+              instruction = instruction->next);
+          instruction->binary = bench_random() & 0xFFFF;
+        }
+        break;
+    }
+
+    txn.addr = bench_random();
+    txn.write = word >> 31;
+    txn.beats = 1;
+    gate->check(gate, &txn);
+  }
+}
+
+/* fields which differ from the boot state */
+static unsigned long snapbench_compare(Snapshot *boot, Stack *stack,
+    RegFile *regfile, GateModel *gate, KeyModel *key)
+{
+  CheckpointRegFile saved_regfile;
+  CheckpointGate saved_gate;
+  CheckpointKey saved_key;
+  Instruction *instruction;
+  unsigned long errors = 0;
+  size_t i = 0;
+
+  for (instruction = stack->trunk; instruction;
+      instruction = instruction->next, i++)
+  {
+    errors += i >= boot->halfwords || instruction->binary != boot->binary[i];
+  }
+  errors += i != boot->halfwords;
+  errors += !! memcmp(regfile->mem, boot->mem,
+      regfile->num_regs * sizeof(u32));
+
+  memset(&saved_regfile, 0, sizeof(saved_regfile));
+  memset(&saved_gate, 0, sizeof(saved_gate));
+  memset(&saved_key, 0, sizeof(saved_key));
+  checkpoint_saveRegFile(&saved_regfile, regfile);
+  checkpoint_saveGate(&saved_gate, gate);
+  checkpoint_saveKey(&saved_key, key);
+  errors += !! memcmp(&saved_regfile, &boot->saved_regfile,
+      sizeof(saved_regfile));
+  errors += !! memcmp(&saved_gate, &boot->saved_gate, sizeof(saved_gate));
+  errors += !! memcmp(&saved_key, &boot->saved_key, sizeof(saved_key));
+
+  return errors;
+}
+
+int main(int argc, char **argv)
+{
+  unsigned long words = 1 << 16, runs = 100000, verify = 1000, errors = 0,
+                dirtied = 0, r;
+  size_t halfwords = 4096, i;
+  unsigned length = 16;
+  double started, fast, slow, running = 0;
+  unsigned char *image;
+  RegFile *regfile;
+  GateModel *gate;
+  KeyModel *key;
+  Stack *stack;
+  Snapshot *snapshot;
+  int a;
+
+  /* options */
+  for (a = 1; a + 1 < argc && argv[a][0] == '-'; a += 2)
+  {
+    switch (argv[a][1])
+    {
+      case 'm': words     = strtoul(argv[a + 1], NULL, 0);  break;
+      case 'c': halfwords = strtoul(argv[a + 1], NULL, 0);  break;
+      case 'l': length    = strtoul(argv[a + 1], NULL, 0);  break;
+      case 'n': runs      = strtoul(argv[a + 1], NULL, 0);  break;
+      case 'v': verify    = strtoul(argv[a + 1], NULL, 0);  break;
+      default:  a = argc;                                   break;
+    }
+  }
+  if (a != argc || ! words || ! halfwords || ! runs || ! verify)
+  {
+    fprintf(stderr, "usage: %s [-m memory words] [-c halfwords] "
+        "[-l input words] [-n runs] [-v verify every]\n", argv[0]);
+    return 1;
+  }
+
+  if (
+         ! (image = (unsigned char *) malloc(2 * halfwords))
+      || ! (regfile = newRegFile(SNAP_REGFILE_BASE, words))
+      || ! (gate = newGateModel(SNAP_GATE_BASE))
+      || ! (key = newKeyModel(SNAP_KEY_BASE, NULL))
+      )
+  {
+    fprintf(stderr, "out of memory\n");
+    return 1;
+  }
+  for (i = 0; i < 2 * halfwords; i++)
+  {
+    image[i] = (unsigned char) bench_random();
+  }
+  for (i = 0; i < words; i++)
+  {
+    regfile->mem[i] = bench_random();
+  }
+  for (i = 1; i < KEY_NUM_REGS; i++)
+  {
+    Xil_Out32(SNAP_KEY_BASE + i * 4, bench_random());
+    Xil_Out32(SNAP_GATE_BASE + (i % GATE_NUM_KEYS) * 4, key->regs[i]);
+  }
+  if (
+         ! (stack = newStack(image, halfwords))
+      || ! (snapshot = newSnapshot(stack, regfile, gate, key))
+      )
+  {
+    fprintf(stderr, "out of memory\n");
+    return 1;
+  }
+
+  /* snapshot resets */
+  fast = 0;
+  for (r = 1; r <= runs; r++)
+  {
+    started = bench_now();
+    snapbench_run(snapshot, regfile, gate, stack, halfwords, length);
+    running += bench_now() - started;
+    dirtied += snapshot->dirtied(snapshot);
+
+    started = bench_now();
+    snapshot->reset(snapshot);
+    fast += bench_now() - started;
+
+    if (r % verify == 0)
+    {
+      errors += snapbench_compare(snapshot, stack, regfile, gate, key);
+    }
+  }
+
+  /* the Snapshot keeps the boot state, the old way copies it back whole */
+  regfile->dirty = NULL;
+  slow = 0;
+  for (r = 1; r <= runs / 1000 + 1; r++)
+  {
+    snapbench_run(NULL, regfile, gate, stack, halfwords, length);
+
+    started = bench_now();
+    stack->free(stack);
+    stack = newStack(image, halfwords);
+    memcpy(regfile->mem, snapshot->mem, words * sizeof(u32));
+    checkpoint_loadRegFile(regfile, &snapshot->saved_regfile);
+    checkpoint_loadGate(gate, &snapshot->saved_gate);
+    checkpoint_loadKey(key, &snapshot->saved_key);
+    slow += bench_now() - started;
+
+    if (! stack)
+    {
+      fprintf(stderr, "out of memory\n");
+      return 1;
+    }
+    if (r % verify == 0)
+    {
+      errors += snapbench_compare(snapshot, stack, regfile, gate, key);
+    }
+  }
+  slow /= runs / 1000 + 1;
+  regfile->dirty = snapshot->dirty;
+
+  printf("machine           %lu memory words, %lu halfwords, %u input "
+      "words a run\n", words, (unsigned long) halfwords, length);
+  printf("dirtied           %.2f pages and instructions a run, %lu wrong\n",
+      (double) dirtied / runs, errors);
+  printf("snapshot reset    %.1f ns, %.0f resets/s (run %.1f ns)\n",
+      fast * 1e9 / runs, runs / fast, running * 1e9 / runs);
+  printf("newStack reset    %.1f ns, %.0f resets/s\n",
+      slow * 1e9, 1 / slow);
+
+  snapshot->free(snapshot);
+  stack->free(stack);
+  key->free(key);
+  gate->free(gate);
+  regfile->free(regfile);
+  free(image);
+
+  return errors != 0;
+}
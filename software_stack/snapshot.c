@@ -0,0 +1,233 @@
+#include "snapshot.h"
+#include "decode.h"
+
+/* method forward decls */
+Snapshot * Snapshot_take(Snapshot *self);
+int Snapshot_patch(Snapshot *self, size_t index, unsigned binary);
+unsigned Snapshot_dirtied(Snapshot *self);
+Snapshot * Snapshot_reset(Snapshot *self);
+Snapshot * Snapshot_free(Snapshot *self);
+
+/* words in the dirty page bitmap */
+static unsigned snapshot_bitmapWords(Snapshot *self)
+{
+  return (self->pages + 63) / 64;
+}
+
+/* constructor */
+Snapshot * newSnapshot(Stack *stack, RegFile *regfile, GateModel *gate,
+    KeyModel *key)
+{
+  Snapshot *self = (regfile && regfile->dirty) ? NULL
+    : (Snapshot *) malloc(sizeof(Snapshot));
+  Instruction *instruction;
+
+  /* out of memory, or someone else tracks the RegFile */
+  if (! self)
+  {
+    return NULL;
+  }
+
+  /* zero */
+  memset(self, 0, sizeof(Snapshot));
+
+  /* bind methods */
+  self->take    = Snapshot_take;
+  self->patch   = Snapshot_patch;
+  self->dirtied = Snapshot_dirtied;
+  self->reset   = Snapshot_reset;
+  self->free    = Snapshot_free;
+  self->stack   = stack;
+  self->regfile = regfile;
+  self->gate    = gate;
+  self->key     = key;
+
+  /* room for the list, fixed from now on */
+  for (instruction = stack ? stack->trunk : NULL; instruction;
+      instruction = instruction->next)
+  {
+    self->halfwords++;
+  }
+  if (
+         self->halfwords
+      && (
+             ! (self->code = (Instruction **)
+                calloc(self->halfwords, sizeof(Instruction *)))
+          || ! (self->binary = (unsigned *)
+                calloc(self->halfwords, sizeof(unsigned)))
+          || ! (self->opcode = (ThumbISA *)
+                calloc(self->halfwords, sizeof(ThumbISA)))
+          || ! (self->patched = (unsigned *)
+                calloc(self->halfwords, sizeof(unsigned)))
+          || ! (self->is_patched = (unsigned char *)
+                calloc(self->halfwords, 1))
+         )
+      )
+  {
+    return self->free(self);
+  }
+
+  /* room for memory, and the bitmap the RegFile marks */
+  if (regfile)
+  {
+    self->pages = (regfile->num_regs + REGFILE_PAGE_WORDS - 1)
+      >> REGFILE_PAGE_SHIFT;
+    if (
+           ! (self->mem = (u32 *) malloc(regfile->num_regs * sizeof(u32)))
+        || ! (self->dirty = (unsigned long long *)
+              calloc(snapshot_bitmapWords(self), sizeof(unsigned long long)))
+        )
+    {
+      return self->free(self);
+    }
+    regfile->dirty = self->dirty;
+  }
+
+  return self->take(self);
+}
+
+/* copy everything */
+Snapshot * Snapshot_take(Snapshot *self)
+{
+  Instruction *instruction;
+  size_t i = 0;
+
+  for (instruction = self->stack ? self->stack->trunk : NULL;
+      instruction && i < self->halfwords; instruction = instruction->next)
+  {
+    self->code[i]   = instruction;
+    self->binary[i] = instruction->binary;
+    self->opcode[i] = instruction->opcode;
+    i++;
+  }
+  while (self->num_patched)
+  {
+    self->is_patched[self->patched[--self->num_patched]] = 0;
+  }
+  self->pc = self->stack ? self->stack->PC() : 0;
+
+  if (self->regfile)
+  {
+    memcpy(self->mem, self->regfile->mem,
+        self->regfile->num_regs * sizeof(u32));
+    memset(self->dirty, 0,
+        snapshot_bitmapWords(self) * sizeof(unsigned long long));
+    checkpoint_saveRegFile(&self->saved_regfile, self->regfile);
+  }
+  if (self->gate)
+  {
+    checkpoint_saveGate(&self->saved_gate, self->gate);
+  }
+  if (self->key)
+  {
+    checkpoint_saveKey(&self->saved_key, self->key);
+  }
+
+  return self;
+}
+
+/* change an Instruction, remembering it */
+int Snapshot_patch(Snapshot *self, size_t index, unsigned binary)
+{
+  if (index >= self->halfwords)
+  {
+    return -1;
+  }
+
+  if (! self->is_patched[index])
+  {
+    self->is_patched[index] = 1;
+    self->patched[self->num_patched++] = index;
+  }
+  self->code[index]->binary = binary;
+  self->code[index]->opcode = decode_opcode(binary);
+
+  return 0;
+}
+
+/* popcount of the bitmap, plus the patch list */
+unsigned Snapshot_dirtied(Snapshot *self)
+{
+  unsigned pages = 0, w;
+
+  for (w = 0; self->dirty && w < snapshot_bitmapWords(self); w++)
+  {
+    pages += __builtin_popcountll(self->dirty[w]);
+  }
+
+  return pages + self->num_patched;
+}
+
+/* copy back what changed */
+Snapshot * Snapshot_reset(Snapshot *self)
+{
+  unsigned long long bits;
+  unsigned w, page, words;
+  size_t index;
+
+  /* Instructions */
+  while (self->num_patched)
+  {
+    index = self->patched[--self->num_patched];
+    self->is_patched[index] = 0;
+    self->code[index]->binary = self->binary[index];
+    self->code[index]->opcode = self->opcode[index];
+    self->restored++;
+  }
+  if (self->stack && self->stack->PC() != self->pc)
+  {
+    self->stack->jump(self->stack, self->pc);
+  }
+
+  /* memory pages, a bitmap word at a time */
+  for (w = 0; self->dirty && w < snapshot_bitmapWords(self); w++)
+  {
+    for (bits = self->dirty[w]; bits; bits &= bits - 1)
+    {
+      page = w * 64 + __builtin_ctzll(bits);
+      words = self->regfile->num_regs - (page << REGFILE_PAGE_SHIFT);
+      memcpy(self->regfile->mem + (page << REGFILE_PAGE_SHIFT),
+          self->mem + (page << REGFILE_PAGE_SHIFT),
+          (words < REGFILE_PAGE_WORDS ? words : REGFILE_PAGE_WORDS)
+          * sizeof(u32));
+      self->restored++;
+    }
+    self->dirty[w] = 0;
+  }
+
+  /* the rest is small enough to copy whole */
+  if (self->regfile)
+  {
+    checkpoint_loadRegFile(self->regfile, &self->saved_regfile);
+  }
+  if (self->gate)
+  {
+    checkpoint_loadGate(self->gate, &self->saved_gate);
+  }
+  if (self->key)
+  {
+    checkpoint_loadKey(self->key, &self->saved_key);
+  }
+  self->resets++;
+
+  return self;
+}
+
+/* destructor */
+Snapshot * Snapshot_free(Snapshot *self)
+{
+  if (self->regfile && self->regfile->dirty == self->dirty)
+  {
+    self->regfile->dirty = NULL;
+  }
+  free(self->dirty);
+  free(self->mem);
+  free(self->is_patched);
+  free(self->patched);
+  free(self->opcode);
+  free(self->binary);
+  free(self->code);
+  free(self);
+
+  return NULL;
+}
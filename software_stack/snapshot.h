@@ -0,0 +1,110 @@
+#ifndef __SOFT_STACK_SNAPSHOT
+#define __SOFT_STACK_SNAPSHOT
+
+#include "checkpoint.h"
+
+/**
+ * A Snapshot is a fork server's view of a Stack, a RegFile, a GateModel
+ *  and a KeyModel: their state is taken once, a run is free to change
+ *  them, and reset puts back only what the run dirtied. The RegFile marks
+ *  the memory pages it writes in a bitmap the Snapshot installs, and code
+ *  changes go through patch, so a reset costs a copy of each page and
+ *  Instruction touched plus the two small peripheral models, rather than
+ *  newStack and a full copy.
+ *
+ * The shape of the Instruction list is not tracked: a run must patch
+ *  Instructions rather than push or pop them.
+ */
+typedef struct _Snapshot
+{
+  /** models put back by reset, any of them NULL */
+  Stack *stack;
+  RegFile *regfile;
+  GateModel *gate;
+  KeyModel *key;
+
+  /** Instructions in list order, with their binaries and opcodes as taken */
+  Instruction **code;
+  unsigned *binary;
+  ThumbISA *opcode;
+  size_t halfwords;
+
+  /** the Stack's PC as taken */
+  unsigned pc;
+
+  /** Instructions patched since the last reset, and a flag per Instruction */
+  unsigned *patched;
+  size_t num_patched;
+  unsigned char *is_patched;
+
+  /** RegFile memory as taken, and the dirty page bitmap installed in it */
+  u32 *mem;
+  unsigned long long *dirty;
+  unsigned pages;
+
+  /** everything else in the models, as taken */
+  CheckpointRegFile saved_regfile;
+  CheckpointGate saved_gate;
+  CheckpointKey saved_key;
+
+  /** resets so far, and pages plus Instructions they copied back */
+  unsigned long long resets;
+  unsigned long long restored;
+
+  /**
+   * Take the models' state as it is now, reset returns to it from then on
+   *
+   * @return this Snapshot
+   */
+  struct _Snapshot * (*take)(struct _Snapshot *self);
+
+  /**
+   * Replace an Instruction's binary and opcode, for reset to undo
+   *
+   * @param index position of the Instruction in the list as taken
+   * @param binary the new instruction binary
+   * @return 0, or non-zero if there is no such Instruction
+   */
+  int (*patch)(struct _Snapshot *self, size_t index, unsigned binary);
+
+  /**
+   * How much the run since the last reset changed, cheap enough to call
+   *  every run as a coverage hint
+   *
+   * @return the number of dirty memory pages plus patched Instructions
+   */
+  unsigned (*dirtied)(struct _Snapshot *self);
+
+  /**
+   * Put back every dirty memory page, every patched Instruction, the PC,
+   *  the RegFile side channel and user space, and the GateModel and
+   *  KeyModel
+   *
+   * @return this Snapshot
+   */
+  struct _Snapshot * (*reset)(struct _Snapshot *self);
+
+  /**
+   * Destructor, removes the dirty page bitmap from the RegFile and leaves
+   *  the models as they are
+   *
+   * @return NULL
+   */
+  struct _Snapshot * (*free)(struct _Snapshot *self);
+
+} Snapshot;
+
+/**
+ * Constructor, takes the models' state
+ *
+ * @param stack Stack, or NULL
+ * @param regfile RegFile, or NULL, which must not already be tracked
+ * @param gate GateModel, or NULL
+ * @param key KeyModel, or NULL
+ * @return a new Snapshot, or NULL if out of memory or the RegFile is
+ *  already tracked
+ */
+Snapshot * newSnapshot(Stack *stack, RegFile *regfile, GateModel *gate,
+    KeyModel *key);
+
+#endif /* __SOFT_STACK_SNAPSHOT */
@@ -1,5 +1,6 @@
 #include "stack.h"
 #include "isa.h"
+#include "decode.h"
 
 /* method forward decls */
 unsigned Stack_PC();
@@ -69,7 +70,6 @@ static unsigned Stack_moveLR(char move)
 Instruction * newInstruction(unsigned binary)
 {
   Instruction *self = (Instruction *) malloc(sizeof(Instruction));
-  int i;
 
   /* out of memory */
   if (! self)
@@ -87,14 +87,7 @@ Instruction * newInstruction(unsigned binary)
   self->binary = binary;
 
   /* get the instruction opcode */
-  self->opcode = UNUSED_IM8;
-  for (i = 0; i < 64; i++)
-  {
-    if (CODE_MATCHES(binary, allInstructions[i]))
-    {
-      self->opcode = allInstructions[i];
-    }
-  }
+  self->opcode = decode_opcode(binary);
 
   /* bind methods */
   self->free        = Instruction_free;
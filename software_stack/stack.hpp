@@ -0,0 +1,326 @@
+#ifndef __SOFT_STACK_STACK_HPP
+#define __SOFT_STACK_STACK_HPP
+
+/**
+ * C++17 view of the software stack, header only. Nothing here replaces
+ *  the C API: a thumb::Stack owns a ::Stack and hands it back on request,
+ *  and a thumb::Program is a flat copy of one for fast iteration.
+ *
+ *   thumb::Program program(bytes, count);
+ *   for (const thumb::Instr &instr : program)
+ *   {
+ *     thumb::visit(thumb::overloaded {
+ *         [&](thumb::Op<MUL_RGM_RGD>, const thumb::Instr &) { ++muls; },
+ *         [&](auto, const thumb::Instr &) { ++others; }
+ *       }, instr);
+ *   }
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <utility>
+
+extern "C"
+{
+#include "stack.h"
+#include "decode.h"
+}
+
+namespace thumb
+{
+
+/** A ThumbISA code as a type, what visitors overload on */
+template <ThumbISA Code>
+struct Op
+{
+  static constexpr ThumbISA code = Code;
+};
+
+/** Lets a set of lambdas act as a single visitor */
+template <typename... Handlers>
+struct overloaded : Handlers...
+{
+  using Handlers::operator()...;
+};
+
+template <typename... Handlers>
+overloaded(Handlers...) -> overloaded<Handlers...>;
+
+namespace detail
+{
+
+/*
+ * Every ThumbISA code but UNUSED_IM8, the catch-all. A real switch, so the
+ *  compiler builds jump tables over each cluster of codes.
+ */
+#define THUMB_VISIT_CASE(CODE) \
+  case CODE: return visitor(Op<CODE>{}, instr);
+
+template <typename Visitor, typename Instruction>
+inline decltype(auto) dispatch(Visitor &visitor, const Instruction &instr)
+{
+  switch (instr.opcode)
+  {
+    THUMB_VISIT_CASE(ADC_RGM_RGD)       THUMB_VISIT_CASE(ADD_HF2_RGM_RGD)
+    THUMB_VISIT_CASE(ADD_IM3_RGN_RGD)   THUMB_VISIT_CASE(ADD_RGD_IM8)
+    THUMB_VISIT_CASE(ADD_RGM_RGN_RGD)   THUMB_VISIT_CASE(ADDPC_RGD_IM8)
+    THUMB_VISIT_CASE(ADDSP_RGD_IM8)     THUMB_VISIT_CASE(AND_RGM_RGD)
+    THUMB_VISIT_CASE(ASR_IM5_RGM_RGD)   THUMB_VISIT_CASE(ASR_RGS_RGD)
+    THUMB_VISIT_CASE(B_IM8)             THUMB_VISIT_CASE(BCOND_IM8)
+    THUMB_VISIT_CASE(BIC_RGN_RGM)       THUMB_VISIT_CASE(BKPT_IM8)
+    THUMB_VISIT_CASE(BL_IM8)            THUMB_VISIT_CASE(BLX_HF1_RGM_C30)
+    THUMB_VISIT_CASE(BLX_IM8)           THUMB_VISIT_CASE(BLXH_IM8)
+    THUMB_VISIT_CASE(BX_HF1_RGM_C30)    THUMB_VISIT_CASE(CMN_RGN_RGM)
+    THUMB_VISIT_CASE(CMP_HF2_RGN_RGM)   THUMB_VISIT_CASE(CMP_RGN_IM8)
+    THUMB_VISIT_CASE(CMP_RGN_RGM)       THUMB_VISIT_CASE(EOR_RGM_RGD)
+    THUMB_VISIT_CASE(LDMIA_RGN_RL8)     THUMB_VISIT_CASE(LDR_IM5_RGN_RGD)
+    THUMB_VISIT_CASE(LDR_RGM_RGN_RGD)   THUMB_VISIT_CASE(LDRB_IM5_RGN_RGD)
+    THUMB_VISIT_CASE(LDRB_RGM_RGN_RGD)  THUMB_VISIT_CASE(LDRH_IM5_RGN_RGD)
+    THUMB_VISIT_CASE(LDRH_RGM_RGN_RGD)  THUMB_VISIT_CASE(LDRPC_RGD_IM8)
+    THUMB_VISIT_CASE(LDRSB_RGM_RGN_RGD) THUMB_VISIT_CASE(LDRSH_RGM_RGN_RGD)
+    THUMB_VISIT_CASE(LDRSP_RGD_IM8)     THUMB_VISIT_CASE(LSL_IM5_RGM_RGD)
+    THUMB_VISIT_CASE(LSL_RGS_RGD)       THUMB_VISIT_CASE(LSR_IM5_RGM_RGD)
+    THUMB_VISIT_CASE(LSR_RGS_RGD)       THUMB_VISIT_CASE(MOV_HF2_RGM_RGD)
+    THUMB_VISIT_CASE(MOV_RGD_IM8)       THUMB_VISIT_CASE(MUL_RGM_RGD)
+    THUMB_VISIT_CASE(MVN_RGM_RGD)       THUMB_VISIT_CASE(NEG_RGM_RGD)
+    THUMB_VISIT_CASE(ORR_RGM_RGD)       THUMB_VISIT_CASE(POP_HF1_IM8)
+    THUMB_VISIT_CASE(PUSH_HF1_IM8)      THUMB_VISIT_CASE(ROR_RGS_RGD)
+    THUMB_VISIT_CASE(SBC_RGM_RGD)       THUMB_VISIT_CASE(STMIA_RGN_IM8)
+    THUMB_VISIT_CASE(STR_IM5_RGN_RGD)   THUMB_VISIT_CASE(STR_RGM_RGN_RGD)
+    THUMB_VISIT_CASE(STRB_IM5_RGN_RGD)  THUMB_VISIT_CASE(STRB_RGM_RGN_RGD)
+    THUMB_VISIT_CASE(STRH_IM5_RGN_RGD)  THUMB_VISIT_CASE(STRH_RGM_RGN_RGD)
+    THUMB_VISIT_CASE(STRSP_RGD_IM8)     THUMB_VISIT_CASE(SUB_C11_IM7)
+    THUMB_VISIT_CASE(SUB_IM3_RGN_RGD)   THUMB_VISIT_CASE(SUB_RGM_IM8)
+    THUMB_VISIT_CASE(SUB_RGM_RGN_RGD)   THUMB_VISIT_CASE(SWI_IM8)
+    THUMB_VISIT_CASE(TST_RGN_RGM)
+    default: return visitor(Op<UNUSED_IM8>{}, instr);
+  }
+}
+
+#undef THUMB_VISIT_CASE
+
+} /* namespace detail */
+
+/**
+ * Call the visitor's handler for an instruction's opcode, picked at
+ *  compile time per opcode so each handler can be inlined
+ *
+ * @param visitor callable as visitor(Op<CODE>{}, instr) for every code,
+ *  every overload returning the same type
+ * @param instr anything with a ThumbISA opcode member, codes matching
+ *  nothing go to the UNUSED_IM8 handler
+ * @return what the handler returned
+ */
+template <typename Visitor, typename Instruction>
+inline decltype(auto) visit(Visitor &&visitor, const Instruction &instr)
+{
+  return detail::dispatch(visitor, instr);
+}
+
+/** A single instruction by value, as a Program holds them */
+struct Instr
+{
+  unsigned address;
+  unsigned binary;
+  ThumbISA opcode;
+};
+
+/**
+ * Owns a ::Stack, freeing it on destruction. Move-only, like the pointer
+ *  it wraps has only ever had a single owner. Iterates the Instruction
+ *  list in order, which is as far as a linked list goes.
+ */
+class Stack
+{
+public:
+
+  /** Walks ::Instruction next pointers */
+  class iterator
+  {
+  public:
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type        = ::Instruction;
+    using difference_type   = std::ptrdiff_t;
+    using pointer           = ::Instruction *;
+    using reference         = ::Instruction &;
+
+    iterator(::Instruction *at = nullptr, ::Instruction *trunk = nullptr)
+      : at_(at), trunk_(trunk) {}
+
+    reference operator*() const { return *at_; }
+    pointer operator->() const { return at_; }
+    iterator &operator++() { at_ = at_->next; return *this; }
+    iterator operator++(int) { iterator was = *this; ++*this; return was; }
+    iterator &operator--()
+    {
+      if (at_)
+      {
+        at_ = at_->prev;
+      }
+      else
+      {
+        /* stepping back from end(), find the tail */
+        for (at_ = trunk_; at_ && at_->next; at_ = at_->next);
+      }
+      return *this;
+    }
+    iterator operator--(int) { iterator was = *this; --*this; return was; }
+    bool operator==(const iterator &other) const { return at_ == other.at_; }
+    bool operator!=(const iterator &other) const { return at_ != other.at_; }
+
+  private:
+    ::Instruction *at_;
+
+    /* so end() can step back */
+    ::Instruction *trunk_;
+  };
+
+  Stack() noexcept : stack_(nullptr) {}
+
+  /** Adopt a ::Stack, which this Stack frees */
+  explicit Stack(::Stack *stack) noexcept : stack_(stack) {}
+
+  /** newStack, empty if count is 0 or out of memory */
+  Stack(const unsigned char *bytes, std::size_t count) noexcept
+    : stack_(count ? newStack(const_cast<unsigned char *>(bytes), count)
+        : nullptr) {}
+
+  Stack(Stack &&other) noexcept : stack_(other.release()) {}
+
+  Stack &operator=(Stack &&other) noexcept
+  {
+    if (this != &other)
+    {
+      reset(other.release());
+    }
+    return *this;
+  }
+
+  Stack(const Stack &) = delete;
+  Stack &operator=(const Stack &) = delete;
+
+  ~Stack() { reset(); }
+
+  /** false if empty, or newStack ran out of memory */
+  explicit operator bool() const noexcept { return stack_ != nullptr; }
+
+  /** The ::Stack, still owned by this Stack */
+  ::Stack *get() const noexcept { return stack_; }
+
+  /** The ::Stack, which the caller now has to free */
+  ::Stack *release() noexcept
+  {
+    ::Stack *stack = stack_;
+    stack_ = nullptr;
+    return stack;
+  }
+
+  /** Free the ::Stack held and adopt another */
+  void reset(::Stack *stack = nullptr) noexcept
+  {
+    if (stack_)
+    {
+      stack_->free(stack_);
+    }
+    stack_ = stack;
+  }
+
+  iterator begin() const
+  {
+    return iterator(stack_ ? stack_->trunk : nullptr);
+  }
+
+  iterator end() const
+  {
+    return iterator(nullptr, stack_ ? stack_->trunk : nullptr);
+  }
+
+  /** Instructions, counted rather than asked of the shared size() */
+  std::size_t size() const
+  {
+    return static_cast<std::size_t>(std::distance(begin(), end()));
+  }
+
+private:
+  ::Stack *stack_;
+};
+
+/**
+ * A flat, move-only copy of a program, for random access and tight loops
+ *  over its instructions without chasing pointers
+ */
+class Program
+{
+public:
+  using value_type     = Instr;
+  using iterator       = const Instr *;
+  using const_iterator = const Instr *;
+
+  Program() noexcept : size_(0) {}
+
+  /** Decode a raw image, addresses counting up from 0 */
+  Program(const unsigned char *bytes, std::size_t count)
+    : instrs_(new Instr[count]), size_(count)
+  {
+    unsigned binary;
+
+    for (std::size_t i = 0; i < count; i++)
+    {
+      binary = bytes[2 * i] | (bytes[2 * i + 1] << 8);
+      instrs_[i] = Instr { static_cast<unsigned>(i), binary,
+        decode_opcode(binary) };
+    }
+  }
+
+  /** Copy instructions decoded ahead of time, such as a thumb::Image's */
+  Program(const Instr *instrs, std::size_t count)
+    : instrs_(new Instr[count]), size_(count)
+  {
+    std::copy(instrs, instrs + count, instrs_.get());
+  }
+
+  /** Copy a Stack's Instructions, in list order */
+  explicit Program(const Stack &stack)
+    : instrs_(new Instr[stack.size()]), size_(0)
+  {
+    for (const ::Instruction &instruction : stack)
+    {
+      instrs_[size_++] = Instr { instruction.address, instruction.binary,
+        instruction.opcode };
+    }
+  }
+
+  Program(Program &&) noexcept = default;
+  Program &operator=(Program &&) noexcept = default;
+  Program(const Program &) = delete;
+  Program &operator=(const Program &) = delete;
+
+  /** Back to a Stack, for the C API */
+  Stack toStack() const
+  {
+    std::unique_ptr<unsigned char[]> bytes(new unsigned char[2 * size_]);
+
+    for (std::size_t i = 0; i < size_; i++)
+    {
+      bytes[2 * i]     = instrs_[i].binary & 0xFF;
+      bytes[2 * i + 1] = (instrs_[i].binary >> 8) & 0xFF;
+    }
+    return Stack(bytes.get(), size_);
+  }
+
+  iterator begin() const noexcept { return instrs_.get(); }
+  iterator end() const noexcept { return instrs_.get() + size_; }
+  const Instr &operator[](std::size_t i) const noexcept { return instrs_[i]; }
+  std::size_t size() const noexcept { return size_; }
+  bool empty() const noexcept { return ! size_; }
+
+private:
+  std::unique_ptr<Instr[]> instrs_;
+  std::size_t size_;
+};
+
+} /* namespace thumb */
+
+#endif /* __SOFT_STACK_STACK_HPP */
@@ -0,0 +1,255 @@
+/*
+ * Measures the C++ facade against the function pointer path. The same
+ *  per-opcode tally runs over a random program three ways: through
+ *  stack->get and a table of handler pointers, walking the Instruction
+ *  list with the same handlers, and over a thumb::Program with
+ *  thumb::visit, after checking all three agree.
+ *
+ * usage: stackbench [-n halfwords] [-p passes]
+ *
+ * build: cc -O2 -c stack.c decode.c
+ *        c++ -O2 -std=c++17 -I . -o stackbench stackbench.cpp stack.o
+ *         decode.o
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "bench.h"
+#include "stack.hpp"
+
+/* every opcode, in stack.c */
+extern "C" ThumbISA allInstructions[64];
+
+/* what the tally counts an opcode as */
+enum Kind
+{
+  KIND_ALU = 0,
+  KIND_LOAD,
+  KIND_STORE,
+  KIND_BRANCH,
+  KIND_UNUSED
+};
+
+/* tallies of a pass, registers summed so the handlers do some work */
+struct Tally
+{
+  unsigned long kinds[KIND_UNUSED + 1];
+  unsigned long muls;
+  unsigned long regs;
+
+  bool operator==(const Tally &other) const
+  {
+    return ! memcmp(this, &other, sizeof(Tally));
+  }
+};
+
+/* usable at compile time by the visitor, and at run time for the table */
+static constexpr Kind stackbench_kind(ThumbISA code)
+{
+  switch (code)
+  {
+    case LDMIA_RGN_RL8:    case LDR_IM5_RGN_RGD:   case LDR_RGM_RGN_RGD:
+    case LDRB_IM5_RGN_RGD: case LDRB_RGM_RGN_RGD:  case LDRH_IM5_RGN_RGD:
+    case LDRH_RGM_RGN_RGD: case LDRPC_RGD_IM8:     case LDRSB_RGM_RGN_RGD:
+    case LDRSH_RGM_RGN_RGD: case LDRSP_RGD_IM8:    case POP_HF1_IM8:
+      return KIND_LOAD;
+
+    case STMIA_RGN_IM8:    case STR_IM5_RGN_RGD:   case STR_RGM_RGN_RGD:
+    case STRB_IM5_RGN_RGD: case STRB_RGM_RGN_RGD:  case STRH_IM5_RGN_RGD:
+    case STRH_RGM_RGN_RGD: case STRSP_RGD_IM8:     case PUSH_HF1_IM8:
+      return KIND_STORE;
+
+    case B_IM8:            case BCOND_IM8:         case BKPT_IM8:
+    case BL_IM8:           case BLX_HF1_RGM_C30:   case BLX_IM8:
+    case BLXH_IM8:         case BX_HF1_RGM_C30:    case SWI_IM8:
+      return KIND_BRANCH;
+
+    case UNUSED_IM8:
+      return KIND_UNUSED;
+
+    default:
+      return KIND_ALU;
+  }
+}
+
+/* the function pointer path, a handler per kind and a slot per code */
+typedef void (*Handler)(Tally *tally, unsigned binary);
+
+static void stackbench_alu(Tally *tally, unsigned binary)
+{
+  tally->kinds[KIND_ALU]++;
+  tally->regs += binary & 7;
+}
+
+static void stackbench_mul(Tally *tally, unsigned binary)
+{
+  tally->kinds[KIND_ALU]++;
+  tally->muls++;
+  tally->regs += binary & 7;
+}
+
+static void stackbench_load(Tally *tally, unsigned binary)
+{
+  tally->kinds[KIND_LOAD]++;
+  tally->regs += binary & 7;
+}
+
+static void stackbench_store(Tally *tally, unsigned binary)
+{
+  tally->kinds[KIND_STORE]++;
+  tally->regs += binary & 7;
+}
+
+static void stackbench_branch(Tally *tally, unsigned)
+{
+  tally->kinds[KIND_BRANCH]++;
+}
+
+static void stackbench_unused(Tally *tally, unsigned)
+{
+  tally->kinds[KIND_UNUSED]++;
+}
+
+static Handler stackbench_handlers[64];
+static unsigned char stackbench_slots[0x10000];
+
+/* handler of every opcode, by its position in allInstructions */
+static void stackbench_bind()
+{
+  static const Handler byKind[] =
+  {
+    stackbench_alu, stackbench_load, stackbench_store, stackbench_branch,
+    stackbench_unused
+  };
+  int i;
+
+  memset(stackbench_slots, 63, sizeof(stackbench_slots));
+  for (i = 0; i < 64; i++)
+  {
+    stackbench_slots[allInstructions[i] & 0xFFFF] = (unsigned char) i;
+    stackbench_handlers[i] = allInstructions[i] == MUL_RGM_RGD
+      ? stackbench_mul : byKind[stackbench_kind(allInstructions[i])];
+  }
+}
+
+int main(int argc, char **argv)
+{
+  size_t halfwords = 4096, i;
+  unsigned long passes = 16, pass;
+  double started, seconds[3];
+  Tally tally[3];
+  unsigned char *image;
+  Instruction *instruction;
+  unsigned address;
+  int a;
+
+  /* options */
+  for (a = 1; a + 1 < argc && argv[a][0] == '-'; a += 2)
+  {
+    switch (argv[a][1])
+    {
+      case 'n': halfwords = strtoul(argv[a + 1], NULL, 0);  break;
+      case 'p': passes    = strtoul(argv[a + 1], NULL, 0);  break;
+      default:  a = argc;                                   break;
+    }
+  }
+  if (a != argc || ! halfwords || ! passes)
+  {
+    fprintf(stderr, "usage: %s [-n halfwords] [-p passes]\n", argv[0]);
+    return 1;
+  }
+
+  if (! (image = (unsigned char *) malloc(2 * halfwords)))
+  {
+    fprintf(stderr, "out of memory\n");
+    return 1;
+  }
+  for (i = 0; i < 2 * halfwords; i++)
+  {
+    image[i] = (unsigned char) bench_random();
+  }
+  stackbench_bind();
+
+  /* the C API owns the list, the facade owns the C API */
+  thumb::Stack stack(image, halfwords);
+  if (! stack)
+  {
+    fprintf(stderr, "out of memory\n");
+    return 1;
+  }
+  thumb::Program program(stack);
+  memset(tally, 0, sizeof(tally));
+
+  /* stack->get per address, a handler pointer per instruction */
+  started = bench_now();
+  for (pass = 0; pass < passes; pass++)
+  {
+    for (address = 0; address < program.size(); address++)
+    {
+      instruction = stack.get()->get(stack.get(), program[address].address);
+      stackbench_handlers[stackbench_slots[instruction->opcode & 0xFFFF]](
+          &tally[0], instruction->binary);
+    }
+  }
+  seconds[0] = bench_now() - started;
+
+  /* the same handlers, walking next pointers */
+  started = bench_now();
+  for (pass = 0; pass < passes; pass++)
+  {
+    for (instruction = stack.get()->trunk; instruction;
+        instruction = instruction->next)
+    {
+      stackbench_handlers[stackbench_slots[instruction->opcode & 0xFFFF]](
+          &tally[1], instruction->binary);
+    }
+  }
+  seconds[1] = bench_now() - started;
+
+  /* a flat Program, handlers picked and inlined at compile time */
+  auto visitor = thumb::overloaded {
+    [&](thumb::Op<MUL_RGM_RGD>, const thumb::Instr &instr)
+    {
+      tally[2].kinds[KIND_ALU]++;
+      tally[2].muls++;
+      tally[2].regs += instr.binary & 7;
+    },
+    [&](auto op, const thumb::Instr &instr)
+    {
+      constexpr Kind kind = stackbench_kind(decltype(op)::code);
+
+      tally[2].kinds[kind]++;
+      if constexpr (kind != KIND_BRANCH && kind != KIND_UNUSED)
+      {
+        tally[2].regs += instr.binary & 7;
+      }
+    }
+  };
+  started = bench_now();
+  for (pass = 0; pass < passes; pass++)
+  {
+    for (const thumb::Instr &instr : program)
+    {
+      thumb::visit(visitor, instr);
+    }
+  }
+  seconds[2] = bench_now() - started;
+
+  printf("instructions      %lu x %lu passes, tallies %s\n",
+      (unsigned long) program.size(), passes,
+      tally[0] == tally[1] && tally[1] == tally[2] ? "agree" : "DIFFER");
+  printf("  alu %lu, load %lu, store %lu, branch %lu, unused %lu, mul %lu\n",
+      tally[2].kinds[KIND_ALU] / passes, tally[2].kinds[KIND_LOAD] / passes,
+      tally[2].kinds[KIND_STORE] / passes,
+      tally[2].kinds[KIND_BRANCH] / passes,
+      tally[2].kinds[KIND_UNUSED] / passes, tally[2].muls / passes);
+  printf("ns/instruction    %.2f stack->get, %.2f list walk, %.2f "
+      "thumb::visit\n",
+      seconds[0] * 1e9 / passes / program.size(),
+      seconds[1] * 1e9 / passes / program.size(),
+      seconds[2] * 1e9 / passes / program.size());
+
+  free(image);
+
+  return ! (tally[0] == tally[1] && tally[1] == tally[2]);
+}
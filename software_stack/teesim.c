@@ -0,0 +1,296 @@
+/*
+ * Runs the TEE peripherals together on the discrete event kernel.
+ *
+ * Software drives the models only through the chase_led drivers in
+ *  trusted_key.h, so every access goes through the same registers it does
+ *  on the board. KEY_OUT reaches the gate's KEY_IN with trusted_key's
+ *  timing, gate_viewer reads TABLE_OUT, and a DMA master streams AXI
+ *  bursts through the connector and gate the whole time.
+ *
+ * Scenarios:
+ *
+ *  boot    reset both peripherals, load a secure and a normal world key
+ *          into trusted_key and the gate, seal the table, check every
+ *          permission through gate_viewer, then enter the normal world
+ *  switch  boot, then switch worlds every period, with an interrupt
+ *          handler draining the gate's denied access FIFO
+ *
+ * usage: teesim [-s boot|switch] [-c clocks] [-a access clocks]
+ *               [-p switch period] [-g mean DMA gap]
+ *
+ * build: cc -O2 -I . -I <chase_led/src> -o teesim teesim.c sim.c key.c
+ *         gate.c viewer.c connector.c hal.c
+ */
+#include "bench.h"
+#include "connector.h"
+#include "key.h"
+#include "viewer.h"
+#include "trusted_key.h"
+
+/* keys, and the gate registers which grant their permissions */
+#define TEE_SECURE_KEY   0x5EC0E000
+#define TEE_SECURE_PERMS 0x1F
+#define TEE_NORMAL_KEY   0x0000A5A5
+#define TEE_NORMAL_PERMS TRUSTED_KEY_PERM_USER_AW
+
+/* denials waiting before the gate interrupts, and clocks between polls */
+#define TEE_WATERMARK 16
+#define TEE_IRQ_POLL  64
+
+/* most events in flight */
+#define TEE_MAX_EVENTS 64
+
+/* everything wired together */
+typedef struct _TeeBench
+{
+  Sim *sim;
+  KeyModel *key;
+  GateModel *gate;
+  ViewerModel *viewer;
+  ConnectorModel *connector;
+
+  /* configuration */
+  int switching;
+  SimTime end;
+  SimTime access;
+  SimTime period;
+  unsigned gap;
+
+  /* results */
+  SimTime booted;
+  unsigned long faults;
+  unsigned long switches;
+  unsigned long drained;
+} TeeBench;
+
+/* KEY_OUT is wired to KEY_IN */
+static void tee_keyOut(KeyModel *key, u32 value)
+{
+  ConnectorModel *connector = (ConnectorModel *) key->owner;
+
+  connector->setKey(connector, value);
+}
+
+/* a single secure boot access, returns 0 once booted */
+static int tee_bootStep(TeeBench *bench, unsigned step)
+{
+  switch (step)
+  {
+    case 0:
+      init_trusted_key();
+      return 1;
+
+    case 1:
+      init_trusted_gate();
+      return 1;
+
+    case 2:
+      add_gate_permission(TEE_SECURE_PERMS, TEE_SECURE_KEY);
+      return 1;
+
+    case 3:
+      add_trusted_key(TRUSTED_KEY_ID_CRIT, TEE_SECURE_KEY);
+      return 1;
+
+    case 4:
+      add_gate_permission(TEE_NORMAL_PERMS, TEE_NORMAL_KEY);
+      return 1;
+
+    case 5:
+      add_trusted_key(TRUSTED_KEY_ID_SIF, TEE_NORMAL_KEY);
+      return 1;
+
+    /* the first read seals the gate */
+    case 6:
+      if (read_gate_key(0) != TEE_SECURE_KEY)
+      {
+        bench->faults++;
+      }
+      return 1;
+
+    case 7:
+      if (read_gate_permission(0) != 0xFFF)
+      {
+        bench->faults++;
+      }
+      return 1;
+
+    case 8:
+      if (
+             read_gate_permission(1)
+          != (GATE_PERM_AWUSER | GATE_PERM_ARUSER | GATE_PERM_WUSER
+                | GATE_PERM_RUSER | GATE_PERM_BUSER)
+          )
+      {
+        bench->faults++;
+      }
+      return 1;
+
+    case 9:
+      set_gate_deny_watermark(TEE_WATERMARK);
+      return 1;
+
+    case 10:
+      use_trusted_key(TRUSTED_KEY_ID_SIF);
+      return 1;
+
+    default:
+      return 0;
+  }
+}
+
+/* switch worlds, 'data' is non-zero going into the secure world */
+static void tee_switch(Sim *sim, void *owner, u32 data)
+{
+  TeeBench *bench = (TeeBench *) owner;
+
+  use_trusted_key(data ? TRUSTED_KEY_ID_CRIT : TRUSTED_KEY_ID_SIF);
+  bench->switches++;
+  if (sim->now + bench->period <= bench->end)
+  {
+    sim->schedule(sim, bench->period, tee_switch, bench, ! data);
+  }
+}
+
+/* the processor, 'data' is its next boot access */
+static void tee_cpu(Sim *sim, void *owner, u32 data)
+{
+  TeeBench *bench = (TeeBench *) owner;
+
+  if (tee_bootStep(bench, data))
+  {
+    sim->schedule(sim, bench->access, tee_cpu, bench, data + 1);
+    return;
+  }
+
+  bench->booted = sim->now;
+  if (bench->switching)
+  {
+    sim->schedule(sim, bench->period, tee_switch, bench, 1);
+  }
+}
+
+/* the interrupt handler, draining denials while the gate interrupts */
+static void tee_irq(Sim *sim, void *owner, u32 data)
+{
+  TeeBench *bench = (TeeBench *) owner;
+
+  (void) data;
+
+  if (bench->gate->irq(bench->gate))
+  {
+    while (gate_denials_held())
+    {
+      read_gate_deny(TRUSTED_GATE_DENY_TIME);
+      read_gate_deny(TRUSTED_GATE_DENY_KEY);
+      read_gate_deny(TRUSTED_GATE_DENY_INFO);
+      read_gate_deny(TRUSTED_GATE_DENY_ADDR);
+      bench->drained++;
+    }
+  }
+  if (sim->now + TEE_IRQ_POLL <= bench->end)
+  {
+    sim->schedule(sim, TEE_IRQ_POLL, tee_irq, bench, 0);
+  }
+}
+
+/* the DMA master, issuing secure bursts whichever world is running */
+static void tee_dma(Sim *sim, void *owner, u32 data)
+{
+  TeeBench *bench = (TeeBench *) owner;
+  u32 r = bench_random();
+  AxiTxn txn;
+
+  (void) data;
+
+  txn.cycle = (u32) sim->now;
+  txn.write = r & 1;
+  txn.addr  = 0x10000000 | (r & 0x00FFFFC0);
+  txn.beats = 1 + ((r >> 1) & 15);
+  txn.prot  = 0;
+  txn.user  = r;
+  bench->connector->transfer(bench->connector, &txn);
+
+  if (sim->now < bench->end)
+  {
+    sim->schedule(sim, 1 + (r >> 8) % (2 * bench->gap), tee_dma, bench, 0);
+  }
+}
+
+int main(int argc, char **argv)
+{
+  TeeBench bench;
+  unsigned long long fired;
+  double seconds;
+  double started;
+  int i;
+
+  memset(&bench, 0, sizeof(bench));
+  bench.end    = 10000000;
+  bench.access = 20;
+  bench.period = 5000;
+  bench.gap    = 4;
+
+  /* options */
+  for (i = 1; i + 1 < argc && argv[i][0] == '-'; i += 2)
+  {
+    switch (argv[i][1])
+    {
+      case 's': bench.switching = ! strcmp(argv[i + 1], "switch");     break;
+      case 'c': bench.end       = strtoull(argv[i + 1], NULL, 0);      break;
+      case 'a': bench.access    = strtoull(argv[i + 1], NULL, 0);      break;
+      case 'p': bench.period    = strtoull(argv[i + 1], NULL, 0);      break;
+      case 'g': bench.gap       = (unsigned) strtoul(argv[i + 1], NULL, 0);
+                                                                       break;
+      default:  i = argc;                                              break;
+    }
+  }
+  if (i != argc || ! bench.access || ! bench.period || ! bench.gap)
+  {
+    fprintf(stderr, "usage: %s [-s boot|switch] [-c clocks] "
+        "[-a access clocks] [-p switch period] [-g mean DMA gap]\n",
+        argv[0]);
+    return 1;
+  }
+
+  /* wire everything up */
+  if (
+         ! (bench.sim = newSim(TEE_MAX_EVENTS))
+      || ! (bench.gate = newGateModel(XPAR_TRUSTED_GATE_0_BASEADDR))
+      || ! (bench.key = newKeyModel(XPAR_TRUSTED_KEY_0_BASEADDR, bench.sim))
+      || ! (bench.viewer = newViewerModel(XPAR_GATE_VIEWER_0_BASEADDR,
+              bench.gate))
+      || ! (bench.connector = newConnectorModel(bench.gate, 32, 8, 4, 0))
+      )
+  {
+    fprintf(stderr, "out of memory\n");
+    return 1;
+  }
+  bench.key->owner = bench.connector;
+  bench.key->onKey = tee_keyOut;
+
+  /* start the processor, the interrupt handler and the DMA master */
+  bench.sim->schedule(bench.sim, 0, tee_cpu, &bench, 0);
+  bench.sim->schedule(bench.sim, TEE_IRQ_POLL, tee_irq, &bench, 0);
+  bench.sim->schedule(bench.sim, 0, tee_dma, &bench, 0);
+
+  started = bench_now();
+  fired = bench.sim->run(bench.sim, bench.end);
+  seconds = bench_now() - started;
+
+  printf("booted at clock   %llu, %lu faults\n", bench.booted, bench.faults);
+  printf("world switches    %lu\n", bench.switches);
+  printf("denials drained   %lu\n", bench.drained);
+  bench.connector->report(bench.connector, stdout, 100e6);
+  printf("events            %llu over %llu clocks\n", fired, bench.sim->now);
+  printf("host              %.2f M events/s\n",
+      seconds > 0 ? fired / seconds / 1e6 : 0.0);
+
+  bench.connector->free(bench.connector);
+  bench.viewer->free(bench.viewer);
+  bench.key->free(bench.key);
+  bench.gate->free(bench.gate);
+  bench.sim->free(bench.sim);
+
+  return bench.faults != 0;
+}
@@ -0,0 +1,1076 @@
+#ifndef __SOFT_STACK_THUMB_ASM_HPP
+#define __SOFT_STACK_THUMB_ASM_HPP
+
+/**
+ * Compile-time Thumb assembler, header only. Source text goes in, and out
+ *  come the little-endian bytes newStack takes and the Instrs a Program
+ *  holds, already decoded, all as constant data:
+ *
+ *   static constexpr char source[] = R"(
+ *     loop:  MUL   r3, r2        @ r3 = r3 * r2
+ *            SUB   r1, #1
+ *            BNE   loop
+ *            BX    lr
+ *   )";
+ *   static constexpr auto image = THUMB_ASSEMBLE(source);
+ *
+ *   for (const thumb::Instr &instr : image) thumb::visit(visitor, instr);
+ *
+ * A mnemonic that does not exist, an operand wider than its field, a
+ *  misaligned offset, a high register where only r0-r7 fit, or a halfword
+ *  which decode_opcode would take for some other instruction fails the
+ *  build, naming the problem. Assembled at run time instead, the same
+ *  mistakes throw a thumb::AsmError.
+ *
+ * The syntax is the pre-UAL ARM one, one instruction per line:
+ *  - registers r0-r15, sp, lr and pc, in any case, as are mnemonics
+ *  - immediates #n, decimal or 0x hex, byte offsets for loads, stores and
+ *    sp or pc arithmetic, scaled down to the field and checked for it
+ *  - branches to a label, or to . plus or minus a byte offset
+ *  - BL and BLX to a label are the two halfword pair
+ *  - .hword n places any halfword as is
+ *  - @ or ; starts a comment
+ */
+
+#include <array>
+#include <cstddef>
+#include <stdexcept>
+#include <string_view>
+#include "stack.hpp"
+
+namespace thumb
+{
+
+/** Why assembling at run time failed, and on which line */
+class AsmError : public std::invalid_argument
+{
+public:
+  AsmError(const char *what, unsigned line)
+    : std::invalid_argument(what), line_(line) {}
+
+  /** 1 for the first line of the source */
+  unsigned line() const noexcept { return line_; }
+
+private:
+  unsigned line_;
+};
+
+/**
+ * Opcode of a halfword, as decode_opcode gives it: the last code in
+ *  allInstructions which matches, or UNUSED_IM8
+ *
+ * @param binary instruction binary
+ * @return its ThumbISA code
+ */
+constexpr ThumbISA opcode_of(unsigned binary)
+{
+  /* allInstructions, in its order, since the last match wins */
+  constexpr ThumbISA codes[64] = {
+    ADC_RGM_RGD,      ADD_HF2_RGM_RGD,   ADD_IM3_RGN_RGD,  ADD_RGD_IM8,
+    ADD_RGM_RGN_RGD,  ADDPC_RGD_IM8,     ADDSP_RGD_IM8,    AND_RGM_RGD,
+    ASR_IM5_RGM_RGD,  ASR_RGS_RGD,       B_IM8,            BCOND_IM8,
+    BIC_RGN_RGM,      BKPT_IM8,          BL_IM8,           BLX_HF1_RGM_C30,
+    BLX_IM8,          BLXH_IM8,          BX_HF1_RGM_C30,   CMN_RGN_RGM,
+    CMP_HF2_RGN_RGM,  CMP_RGN_IM8,       CMP_RGN_RGM,      EOR_RGM_RGD,
+    LDMIA_RGN_RL8,    LDR_IM5_RGN_RGD,   LDR_RGM_RGN_RGD,  LDRB_IM5_RGN_RGD,
+    LDRB_RGM_RGN_RGD, LDRH_IM5_RGN_RGD,  LDRH_RGM_RGN_RGD, LDRPC_RGD_IM8,
+    LDRSB_RGM_RGN_RGD,LDRSH_RGM_RGN_RGD, LDRSP_RGD_IM8,    LSL_IM5_RGM_RGD,
+    LSL_RGS_RGD,      LSR_IM5_RGM_RGD,   LSR_RGS_RGD,      MOV_HF2_RGM_RGD,
+    MOV_RGD_IM8,      MUL_RGM_RGD,       MVN_RGM_RGD,      NEG_RGM_RGD,
+    ORR_RGM_RGD,      POP_HF1_IM8,       PUSH_HF1_IM8,     ROR_RGS_RGD,
+    SBC_RGM_RGD,      STMIA_RGN_IM8,     STR_IM5_RGN_RGD,  STR_RGM_RGN_RGD,
+    STRB_IM5_RGN_RGD, STRB_RGM_RGN_RGD,  STRH_IM5_RGN_RGD, STRH_RGM_RGN_RGD,
+    STRSP_RGD_IM8,    SUB_C11_IM7,       SUB_IM3_RGN_RGD,  SUB_RGM_IM8,
+    SUB_RGM_RGN_RGD,  SWI_IM8,           TST_RGN_RGM,      UNUSED_IM8
+  };
+  ThumbISA opcode = UNUSED_IM8;
+
+  for (ThumbISA code : codes)
+  {
+    if (CODE_MATCHES(binary, static_cast<unsigned>(code)))
+    {
+      opcode = code;
+    }
+  }
+  return opcode;
+}
+
+/**
+ * An assembled program: its image and the same halfwords decoded, both
+ *  built by the compiler when the Image is constexpr
+ */
+template <std::size_t N>
+struct Image
+{
+  /** little-endian halfwords, as newStack and Program take them */
+  std::array<unsigned char, 2 * N> bytes;
+
+  /** every halfword decoded, addresses counting up from 0 */
+  std::array<Instr, N> instrs;
+
+  constexpr std::size_t size() const noexcept { return N; }
+  constexpr const Instr *begin() const noexcept { return instrs.data(); }
+  constexpr const Instr *end() const noexcept { return instrs.data() + N; }
+  constexpr const Instr &operator[](std::size_t i) const noexcept
+  {
+    return instrs[i];
+  }
+
+  /** A Program copied from the decoded table, no decoding */
+  Program program() const { return Program(instrs.data(), N); }
+
+  /** A Stack built from the image, for the C API */
+  Stack stack() const { return Stack(bytes.data(), N); }
+};
+
+namespace detail
+{
+
+/*
+ * Not constexpr, so reaching any of these while assembling at compile
+ *  time fails the build, the error naming the function
+ */
+[[noreturn]] inline void syntax_error(unsigned line)
+{
+  throw AsmError("syntax error", line);
+}
+
+[[noreturn]] inline void unknown_mnemonic(unsigned line)
+{
+  throw AsmError("unknown mnemonic", line);
+}
+
+[[noreturn]] inline void operands_do_not_fit_mnemonic(unsigned line)
+{
+  throw AsmError("operands do not fit the mnemonic", line);
+}
+
+[[noreturn]] inline void operand_out_of_range(unsigned line)
+{
+  throw AsmError("operand out of range", line);
+}
+
+[[noreturn]] inline void operand_misaligned(unsigned line)
+{
+  throw AsmError("operand misaligned", line);
+}
+
+[[noreturn]] inline void low_register_expected(unsigned line)
+{
+  throw AsmError("only r0-r7 fit here", line);
+}
+
+[[noreturn]] inline void undefined_label(unsigned line)
+{
+  throw AsmError("undefined label", line);
+}
+
+[[noreturn]] inline void duplicate_label(unsigned line)
+{
+  throw AsmError("label defined twice", line);
+}
+
+[[noreturn]] inline void decodes_as_another_opcode(unsigned line)
+{
+  throw AsmError("encoding decodes as another opcode", line);
+}
+
+/* what an operand was written as */
+enum Kind
+{
+  KIND_NONE = 0,
+  KIND_REG,      /* r3, or r3! */
+  KIND_IMM,      /* #12 */
+  KIND_MEM_REG,  /* [r2, r1] */
+  KIND_MEM_IMM,  /* [r2, #4] or [r2] */
+  KIND_LIST,     /* {r0-r3, lr} */
+  KIND_TARGET    /* label, or . +/- bytes */
+};
+
+struct Operand
+{
+  Kind kind = KIND_NONE;
+  unsigned reg = 0;
+  unsigned index = 0;
+  long imm = 0;
+  unsigned list = 0;
+  bool writeback = false;
+  std::string_view label;
+};
+
+/* a source line, split up */
+struct Line
+{
+  unsigned number = 0;
+  std::string_view label;
+  std::string_view mnemonic;
+  Operand ops[3];
+  unsigned count = 0;
+};
+
+constexpr bool is_space(char c)
+{
+  return c == ' ' || c == '\t' || c == '\r';
+}
+
+constexpr bool is_word(char c)
+{
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')
+    || (c >= '0' && c <= '9') || c == '_' || c == '.';
+}
+
+constexpr char lower(char c)
+{
+  return c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c;
+}
+
+/* case-insensitive, against a lower case name */
+constexpr bool named(std::string_view word, std::string_view name)
+{
+  if (word.size() != name.size())
+  {
+    return false;
+  }
+  for (std::size_t i = 0; i < word.size(); i++)
+  {
+    if (lower(word[i]) != name[i])
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+/* walks a single line, which ends at a comment */
+struct Cursor
+{
+  std::string_view text;
+  std::size_t at;
+  unsigned line;
+
+  constexpr char peek()
+  {
+    while (at < text.size() && is_space(text[at]))
+    {
+      at++;
+    }
+    if (
+           at >= text.size()
+        || text[at] == '@'
+        || text[at] == ';'
+        )
+    {
+      return '\0';
+    }
+    return text[at];
+  }
+
+  constexpr void expect(char c)
+  {
+    if (peek() != c)
+    {
+      syntax_error(line);
+    }
+    at++;
+  }
+
+  constexpr std::string_view word()
+  {
+    std::size_t from = 0;
+
+    peek();
+    for (from = at; at < text.size() && is_word(text[at]); at++);
+    if (at == from)
+    {
+      syntax_error(line);
+    }
+    return text.substr(from, at - from);
+  }
+
+  /* decimal, or hex after 0x, either with a leading - */
+  constexpr long number()
+  {
+    long value = 0;
+    bool negative = false, any = false;
+    unsigned base = 10, digit = 0;
+
+    if (peek() == '-' || peek() == '+')
+    {
+      negative = text[at++] == '-';
+    }
+    if (
+           at + 1 < text.size()
+        && text[at] == '0'
+        && lower(text[at + 1]) == 'x'
+        )
+    {
+      base = 16;
+      at += 2;
+    }
+    for (; at < text.size(); at++, any = true)
+    {
+      if (text[at] >= '0' && text[at] <= '9')
+      {
+        digit = text[at] - '0';
+      }
+      else if (base == 16 && lower(text[at]) >= 'a' && lower(text[at]) <= 'f')
+      {
+        digit = lower(text[at]) - 'a' + 10;
+      }
+      else
+      {
+        break;
+      }
+      value = value * base + digit;
+      if (value > 0xFFFFFFFFL)
+      {
+        operand_out_of_range(line);
+      }
+    }
+    if (! any)
+    {
+      syntax_error(line);
+    }
+    return negative ? -value : value;
+  }
+};
+
+/* r0-r15, sp, lr or pc, -1 if the word is none of them */
+constexpr int register_of(std::string_view word)
+{
+  if (named(word, "sp"))
+  {
+    return 13;
+  }
+  if (named(word, "lr"))
+  {
+    return 14;
+  }
+  if (named(word, "pc"))
+  {
+    return 15;
+  }
+  if (word.size() == 2 && lower(word[0]) == 'r' && word[1] >= '0'
+      && word[1] <= '9')
+  {
+    return word[1] - '0';
+  }
+  if (word.size() == 3 && lower(word[0]) == 'r' && word[1] == '1'
+      && word[2] >= '0' && word[2] <= '5')
+  {
+    return 10 + word[2] - '0';
+  }
+  return -1;
+}
+
+constexpr unsigned expect_register(Cursor &cursor)
+{
+  int reg = register_of(cursor.word());
+
+  if (reg < 0)
+  {
+    syntax_error(cursor.line);
+  }
+  return static_cast<unsigned>(reg);
+}
+
+constexpr Operand parse_operand(Cursor &cursor)
+{
+  Operand op;
+  unsigned first = 0, last = 0;
+  int reg = 0;
+
+  switch (cursor.peek())
+  {
+    case '#':
+      cursor.at++;
+      op.kind = KIND_IMM;
+      op.imm = cursor.number();
+      return op;
+
+    case '[':
+      cursor.at++;
+      op.reg = expect_register(cursor);
+      op.kind = KIND_MEM_IMM;
+      if (cursor.peek() == ',')
+      {
+        cursor.at++;
+        if (cursor.peek() == '#')
+        {
+          cursor.at++;
+          op.imm = cursor.number();
+        }
+        else
+        {
+          op.kind = KIND_MEM_REG;
+          op.index = expect_register(cursor);
+        }
+      }
+      cursor.expect(']');
+      return op;
+
+    case '{':
+      cursor.at++;
+      op.kind = KIND_LIST;
+      for (;;)
+      {
+        first = last = expect_register(cursor);
+        if (cursor.peek() == '-')
+        {
+          cursor.at++;
+          last = expect_register(cursor);
+        }
+        if (last < first)
+        {
+          syntax_error(cursor.line);
+        }
+        for (; first <= last; first++)
+        {
+          op.list |= 1u << first;
+        }
+        if (cursor.peek() != ',')
+        {
+          break;
+        }
+        cursor.at++;
+      }
+      cursor.expect('}');
+      return op;
+
+    case '.':
+      cursor.at++;
+      op.kind = KIND_TARGET;
+      op.label = ".";
+      if (cursor.peek() == '+' || cursor.peek() == '-')
+      {
+        op.imm = cursor.number();
+      }
+      return op;
+
+    case '-':
+      op.kind = KIND_IMM;
+      op.imm = cursor.number();
+      return op;
+
+    default:
+      if (cursor.peek() >= '0' && cursor.peek() <= '9')
+      {
+        op.kind = KIND_IMM;
+        op.imm = cursor.number();
+        return op;
+      }
+      op.label = cursor.word();
+      if ((reg = register_of(op.label)) < 0)
+      {
+        op.kind = KIND_TARGET;
+        return op;
+      }
+      op.kind = KIND_REG;
+      op.reg = static_cast<unsigned>(reg);
+      if (cursor.peek() == '!')
+      {
+        cursor.at++;
+        op.writeback = true;
+      }
+      return op;
+  }
+}
+
+constexpr Line parse_line(std::string_view text, unsigned number)
+{
+  Cursor cursor { text, 0, number };
+  Line line;
+  std::string_view word;
+
+  line.number = number;
+  if (! cursor.peek())
+  {
+    return line;
+  }
+  word = cursor.word();
+  if (cursor.peek() == ':')
+  {
+    cursor.at++;
+    line.label = word;
+    if (! cursor.peek())
+    {
+      return line;
+    }
+    word = cursor.word();
+  }
+  line.mnemonic = word;
+
+  while (cursor.peek())
+  {
+    if (line.count == 3)
+    {
+      operands_do_not_fit_mnemonic(number);
+    }
+    line.ops[line.count++] = parse_operand(cursor);
+    if (cursor.peek())
+    {
+      cursor.expect(',');
+    }
+  }
+  return line;
+}
+
+/* halfwords a line assembles to, 2 only for BL and BLX to a label */
+constexpr unsigned halfwords_of(const Line &line)
+{
+  if (line.mnemonic.empty())
+  {
+    return 0;
+  }
+  if (
+         (named(line.mnemonic, "bl") || named(line.mnemonic, "blx"))
+      && line.count == 1
+      && line.ops[0].kind == KIND_TARGET
+      )
+  {
+    return 2;
+  }
+  return 1;
+}
+
+/* each line in turn, numbered from 1 */
+struct Lines
+{
+  std::string_view source;
+  std::size_t at = 0;
+  unsigned number = 0;
+
+  constexpr bool next(Line &line)
+  {
+    std::size_t end = 0;
+
+    if (at > source.size())
+    {
+      return false;
+    }
+    end = source.find('\n', at);
+    end = end == std::string_view::npos ? source.size() : end;
+    line = parse_line(source.substr(at, end - at), ++number);
+    at = end + 1;
+    return true;
+  }
+};
+
+/* halfword address of a label, checking it is defined exactly once */
+constexpr long address_of(std::string_view source, std::string_view label,
+    unsigned number)
+{
+  Lines lines { source };
+  Line line;
+  long at = 0, found = -1;
+
+  while (lines.next(line))
+  {
+    if (line.label == label)
+    {
+      if (found >= 0)
+      {
+        duplicate_label(line.number);
+      }
+      found = at;
+    }
+    at += halfwords_of(line);
+  }
+  if (found < 0)
+  {
+    undefined_label(number);
+  }
+  return found;
+}
+
+/* an unsigned field value, checked against its width */
+constexpr unsigned field(long value, unsigned bits, unsigned line)
+{
+  if (value < 0 || value >= (1L << bits))
+  {
+    operand_out_of_range(line);
+  }
+  return static_cast<unsigned>(value);
+}
+
+/* a byte offset scaled down to a field, which has to divide it */
+constexpr unsigned scaled(long value, unsigned scale, unsigned bits,
+    unsigned line)
+{
+  if (value % scale)
+  {
+    operand_misaligned(line);
+  }
+  return field(value / scale, bits, line);
+}
+
+/* a signed halfword offset, two's complement in the field */
+constexpr unsigned offset(long value, unsigned bits, unsigned line)
+{
+  if (value < -(1L << (bits - 1)) || value >= (1L << (bits - 1)))
+  {
+    operand_out_of_range(line);
+  }
+  return static_cast<unsigned>(value) & ((1u << bits) - 1);
+}
+
+constexpr unsigned low(unsigned reg, unsigned line)
+{
+  if (reg > 7)
+  {
+    low_register_expected(line);
+  }
+  return reg;
+}
+
+/* the bits a ThumbISA code fixes, in place at the top of the halfword */
+constexpr unsigned prefix(ThumbISA code)
+{
+  return (code & 0x0FFF) << (16 - ((code & 0xF000) >> 12));
+}
+
+/* r0-r15 as a low register and the h flag for the given bit */
+constexpr unsigned high(unsigned reg, unsigned shift)
+{
+  return (reg & 7) | ((reg >> 3) << shift);
+}
+
+/* B<cond> condition names, in ConditionBits order */
+constexpr int condition_of(std::string_view name)
+{
+  constexpr std::string_view names[16] = {
+    "eq", "ne", "cs", "cc", "mi", "pl", "vs", "vc",
+    "hi", "ls", "ge", "lt", "gt", "le", "hs", "lo"
+  };
+  constexpr int bits[16] = {
+    CB_EQ, CB_NE, CB_CS, CB_CC, CB_MI, CB_PL, CB_VS, CB_VC,
+    CB_HI, CB_LS, CB_GE, CB_LT, CB_GT, CB_LE, CB_HS, CB_LO
+  };
+
+  for (int i = 0; i < 16; i++)
+  {
+    if (named(name, names[i]))
+    {
+      return bits[i];
+    }
+  }
+  return -1;
+}
+
+/* a halfword and the code it has to decode as */
+struct Encoded
+{
+  unsigned binary[2];
+  ThumbISA code[2];
+  unsigned count;
+};
+
+constexpr Encoded one(ThumbISA code, unsigned fields)
+{
+  return Encoded { { prefix(code) | fields, 0 }, { code, UNUSED_IM8 }, 1 };
+}
+
+/* true if the operands are exactly these kinds */
+constexpr bool shaped(const Line &line, Kind a, Kind b = KIND_NONE,
+    Kind c = KIND_NONE)
+{
+  const Kind kinds[3] = { a, b, c };
+
+  for (unsigned i = 0; i < 3; i++)
+  {
+    if ((i < line.count ? line.ops[i].kind : KIND_NONE) != kinds[i])
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+/* branch offset in halfwords, from the PC a halfword at `at` reads */
+constexpr long branch(std::string_view source, const Line &line, long at)
+{
+  const Operand &target = line.ops[0];
+  long to = 0;
+
+  if (target.label == ".")
+  {
+    if (target.imm % 2)
+    {
+      operand_misaligned(line.number);
+    }
+    to = at + target.imm / 2;
+  }
+  else
+  {
+    to = address_of(source, target.label, line.number);
+  }
+  return to - (at + 2);
+}
+
+/* rd, rm, #shift, or rd, rs */
+constexpr Encoded shift(const Line &line, ThumbISA byImm, ThumbISA byReg,
+    long least)
+{
+  const Operand *op = line.ops;
+  unsigned n = line.number;
+
+  if (shaped(line, KIND_REG, KIND_REG, KIND_IMM))
+  {
+    if (op[2].imm < least || op[2].imm > least + 31)
+    {
+      operand_out_of_range(n);
+    }
+    return one(byImm, (static_cast<unsigned>(op[2].imm) & 31) << 6
+        | low(op[1].reg, n) << 3 | low(op[0].reg, n));
+  }
+  if (shaped(line, KIND_REG, KIND_REG))
+  {
+    return one(byReg, low(op[1].reg, n) << 3 | low(op[0].reg, n));
+  }
+  operands_do_not_fit_mnemonic(n);
+}
+
+/* rd, rm, both low, for the data processing group */
+constexpr Encoded alu(const Line &line, ThumbISA code)
+{
+  if (! shaped(line, KIND_REG, KIND_REG))
+  {
+    operands_do_not_fit_mnemonic(line.number);
+  }
+  return one(code, low(line.ops[1].reg, line.number) << 3
+      | low(line.ops[0].reg, line.number));
+}
+
+/* the data processing group which only ever takes rd, rm */
+struct Mnemonic
+{
+  std::string_view name;
+  ThumbISA code;
+};
+
+constexpr Mnemonic alu_ops[] = {
+  { "and", AND_RGM_RGD }, { "eor", EOR_RGM_RGD }, { "adc", ADC_RGM_RGD },
+  { "sbc", SBC_RGM_RGD }, { "ror", ROR_RGS_RGD }, { "tst", TST_RGN_RGM },
+  { "neg", NEG_RGM_RGD }, { "cmn", CMN_RGN_RGM }, { "orr", ORR_RGM_RGD },
+  { "mul", MUL_RGM_RGD }, { "bic", BIC_RGN_RGM }, { "mvn", MVN_RGM_RGD }
+};
+
+/* rd, [rn, rm] */
+constexpr Encoded indexed(const Line &line, ThumbISA code)
+{
+  const Operand *op = line.ops;
+  unsigned n = line.number;
+
+  if (! shaped(line, KIND_REG, KIND_MEM_REG))
+  {
+    operands_do_not_fit_mnemonic(n);
+  }
+  return one(code, low(op[1].index, n) << 6 | low(op[1].reg, n) << 3
+      | low(op[0].reg, n));
+}
+
+/* rd, [rn, rm], rd, [rn, #bytes], and for words rd, [sp|pc, #bytes] */
+constexpr Encoded memory(const Line &line, ThumbISA byReg, ThumbISA byImm,
+    unsigned scale, ThumbISA bySp, ThumbISA byPc)
+{
+  const Operand *op = line.ops;
+  unsigned n = line.number;
+
+  if (shaped(line, KIND_REG, KIND_MEM_REG))
+  {
+    return indexed(line, byReg);
+  }
+  if (! shaped(line, KIND_REG, KIND_MEM_IMM))
+  {
+    operands_do_not_fit_mnemonic(n);
+  }
+  if (op[1].reg == 13 && bySp != UNUSED_IM8)
+  {
+    return one(bySp, low(op[0].reg, n) << 8 | scaled(op[1].imm, 4, 8, n));
+  }
+  if (op[1].reg == 15 && byPc != UNUSED_IM8)
+  {
+    return one(byPc, low(op[0].reg, n) << 8 | scaled(op[1].imm, 4, 8, n));
+  }
+  return one(byImm, scaled(op[1].imm, scale, 5, n) << 6
+      | low(op[1].reg, n) << 3 | low(op[0].reg, n));
+}
+
+/* ADD or SUB in all their forms */
+constexpr Encoded add_sub(const Line &line, bool add)
+{
+  const Operand *op = line.ops;
+  unsigned n = line.number;
+
+  if (shaped(line, KIND_REG, KIND_REG, KIND_REG))
+  {
+    return one(add ? ADD_RGM_RGN_RGD : SUB_RGM_RGN_RGD,
+        low(op[2].reg, n) << 6 | low(op[1].reg, n) << 3 | low(op[0].reg, n));
+  }
+  if (shaped(line, KIND_REG, KIND_REG, KIND_IMM))
+  {
+    if (add && (op[1].reg == 13 || op[1].reg == 15))
+    {
+      return one(op[1].reg == 13 ? ADDSP_RGD_IM8 : ADDPC_RGD_IM8,
+          low(op[0].reg, n) << 8 | scaled(op[2].imm, 4, 8, n));
+    }
+    return one(add ? ADD_IM3_RGN_RGD : SUB_IM3_RGN_RGD,
+        field(op[2].imm, 3, n) << 6 | low(op[1].reg, n) << 3
+        | low(op[0].reg, n));
+  }
+  if (shaped(line, KIND_REG, KIND_IMM))
+  {
+    if (op[0].reg == 13 && ! add)
+    {
+      return one(SUB_C11_IM7, scaled(op[1].imm, 4, 7, n));
+    }
+    return one(add ? ADD_RGD_IM8 : SUB_RGM_IM8,
+        low(op[0].reg, n) << 8 | field(op[1].imm, 8, n));
+  }
+  if (add && shaped(line, KIND_REG, KIND_REG))
+  {
+    return one(ADD_HF2_RGM_RGD, high(op[1].reg, 3) << 3 | high(op[0].reg, 7));
+  }
+  operands_do_not_fit_mnemonic(n);
+}
+
+/* one mnemonic, `at` its halfword address */
+constexpr Encoded encode(std::string_view source, const Line &line, long at)
+{
+  const Operand *op = line.ops;
+  std::string_view m = line.mnemonic;
+  unsigned n = line.number;
+  long to = 0;
+  int cond = -1;
+
+  if (named(m, ".hword"))
+  {
+    if (! shaped(line, KIND_IMM))
+    {
+      operands_do_not_fit_mnemonic(n);
+    }
+    return Encoded { { field(op[0].imm, 16, n), 0 },
+      { opcode_of(static_cast<unsigned>(op[0].imm)), UNUSED_IM8 }, 1 };
+  }
+
+  for (const Mnemonic &ops : alu_ops)
+  {
+    if (named(m, ops.name))
+    {
+      return alu(line, ops.code);
+    }
+  }
+  if (named(m, "lsl"))
+  {
+    return shift(line, LSL_IM5_RGM_RGD, LSL_RGS_RGD, 0);
+  }
+  if (named(m, "lsr"))
+  {
+    return shift(line, LSR_IM5_RGM_RGD, LSR_RGS_RGD, 1);
+  }
+  if (named(m, "asr"))
+  {
+    return shift(line, ASR_IM5_RGM_RGD, ASR_RGS_RGD, 1);
+  }
+  if (named(m, "add") || named(m, "sub"))
+  {
+    return add_sub(line, named(m, "add"));
+  }
+
+  if (named(m, "mov") || named(m, "cmp"))
+  {
+    if (shaped(line, KIND_REG, KIND_IMM))
+    {
+      return one(named(m, "mov") ? MOV_RGD_IM8 : CMP_RGN_IM8,
+          low(op[0].reg, n) << 8 | field(op[1].imm, 8, n));
+    }
+    if (named(m, "cmp") && shaped(line, KIND_REG, KIND_REG)
+        && op[0].reg < 8 && op[1].reg < 8)
+    {
+      return alu(line, CMP_RGN_RGM);
+    }
+    if (shaped(line, KIND_REG, KIND_REG))
+    {
+      return one(named(m, "mov") ? MOV_HF2_RGM_RGD : CMP_HF2_RGN_RGM,
+          high(op[1].reg, 3) << 3 | high(op[0].reg, 7));
+    }
+    operands_do_not_fit_mnemonic(n);
+  }
+
+  if (named(m, "bx") || (named(m, "blx") && shaped(line, KIND_REG)))
+  {
+    if (! shaped(line, KIND_REG))
+    {
+      operands_do_not_fit_mnemonic(n);
+    }
+    return one(named(m, "bx") ? BX_HF1_RGM_C30 : BLX_HF1_RGM_C30,
+        high(op[0].reg, 3) << 3);
+  }
+
+  if (named(m, "str"))
+  {
+    return memory(line, STR_RGM_RGN_RGD, STR_IM5_RGN_RGD, 4, STRSP_RGD_IM8,
+        UNUSED_IM8);
+  }
+  if (named(m, "ldr"))
+  {
+    return memory(line, LDR_RGM_RGN_RGD, LDR_IM5_RGN_RGD, 4, LDRSP_RGD_IM8,
+        LDRPC_RGD_IM8);
+  }
+  if (named(m, "strh"))
+  {
+    return memory(line, STRH_RGM_RGN_RGD, STRH_IM5_RGN_RGD, 2, UNUSED_IM8,
+        UNUSED_IM8);
+  }
+  if (named(m, "ldrh"))
+  {
+    return memory(line, LDRH_RGM_RGN_RGD, LDRH_IM5_RGN_RGD, 2, UNUSED_IM8,
+        UNUSED_IM8);
+  }
+  if (named(m, "strb"))
+  {
+    return memory(line, STRB_RGM_RGN_RGD, STRB_IM5_RGN_RGD, 1, UNUSED_IM8,
+        UNUSED_IM8);
+  }
+  if (named(m, "ldrb"))
+  {
+    return memory(line, LDRB_RGM_RGN_RGD, LDRB_IM5_RGN_RGD, 1, UNUSED_IM8,
+        UNUSED_IM8);
+  }
+  if (named(m, "ldrsb") || named(m, "ldrsh"))
+  {
+    return indexed(line, named(m, "ldrsb") ? LDRSB_RGM_RGN_RGD
+        : LDRSH_RGM_RGN_RGD);
+  }
+
+  if (named(m, "push") || named(m, "pop"))
+  {
+    if (
+           ! shaped(line, KIND_LIST)
+        || op[0].list & ~(0xFFu | 1u << (named(m, "push") ? 14 : 15))
+        )
+    {
+      operands_do_not_fit_mnemonic(n);
+    }
+    return one(named(m, "push") ? PUSH_HF1_IM8 : POP_HF1_IM8,
+        (op[0].list & 0xFF) | (op[0].list > 0xFF) << 8);
+  }
+  if (named(m, "stmia") || named(m, "ldmia"))
+  {
+    if (! shaped(line, KIND_REG, KIND_LIST) || ! op[0].writeback)
+    {
+      operands_do_not_fit_mnemonic(n);
+    }
+    if (op[1].list > 0xFF)
+    {
+      low_register_expected(n);
+    }
+    return one(named(m, "stmia") ? STMIA_RGN_IM8 : LDMIA_RGN_RL8,
+        low(op[0].reg, n) << 8 | op[1].list);
+  }
+
+  if (named(m, "bkpt") || named(m, "swi"))
+  {
+    if (! shaped(line, KIND_IMM))
+    {
+      operands_do_not_fit_mnemonic(n);
+    }
+    return one(named(m, "bkpt") ? BKPT_IM8 : SWI_IM8, field(op[0].imm, 8, n));
+  }
+
+  /* everything left branches to a target */
+  cond = m.size() == 3 && lower(m[0]) == 'b' ? condition_of(m.substr(1))
+    : -1;
+  if (! named(m, "b") && ! named(m, "bl") && ! named(m, "blx") && cond < 0)
+  {
+    unknown_mnemonic(n);
+  }
+  if (! shaped(line, KIND_TARGET))
+  {
+    operands_do_not_fit_mnemonic(n);
+  }
+  to = branch(source, line, at);
+  if (cond >= 0)
+  {
+    return one(BCOND_IM8, static_cast<unsigned>(cond) << 8 | offset(to, 8, n));
+  }
+  if (named(m, "b"))
+  {
+    return one(B_IM8, offset(to, 11, n));
+  }
+
+  /* the high half, then the low half saying BL or BLX */
+  offset(to, 22, n);
+  return Encoded {
+    { prefix(BLXH_IM8) | ((static_cast<unsigned>(to) >> 11) & 0x7FF),
+      prefix(named(m, "bl") ? BL_IM8 : BLX_IM8)
+        | (static_cast<unsigned>(to) & 0x7FF) },
+    { BLXH_IM8, named(m, "bl") ? BL_IM8 : BLX_IM8 }, 2 };
+}
+
+} /* namespace detail */
+
+/**
+ * Halfwords a source assembles to, the size of its Image
+ *
+ * @param source the program text
+ * @return the count, which assemble takes as its template argument
+ */
+constexpr std::size_t halfwords(std::string_view source)
+{
+  detail::Lines lines { source };
+  detail::Line line;
+  std::size_t count = 0;
+
+  while (lines.next(line))
+  {
+    count += detail::halfwords_of(line);
+  }
+  return count;
+}
+
+/**
+ * Assemble a program, checking every halfword decodes as the instruction
+ *  it was written as
+ *
+ * @param source the program text
+ * @return the image and its decoded instructions
+ */
+template <std::size_t N>
+constexpr Image<N> assemble(std::string_view source)
+{
+  detail::Lines lines { source };
+  detail::Line line;
+  detail::Encoded encoded {};
+  Image<N> image {};
+  std::size_t at = 0;
+
+  while (lines.next(line))
+  {
+    if (line.mnemonic.empty())
+    {
+      continue;
+    }
+    encoded = detail::encode(source, line, static_cast<long>(at));
+    for (unsigned i = 0; i < encoded.count; i++, at++)
+    {
+      if (opcode_of(encoded.binary[i]) != encoded.code[i])
+      {
+        detail::decodes_as_another_opcode(line.number);
+      }
+      image.bytes[2 * at]     = encoded.binary[i] & 0xFF;
+      image.bytes[2 * at + 1] = (encoded.binary[i] >> 8) & 0xFF;
+      image.instrs[at] = Instr { static_cast<unsigned>(at),
+        encoded.binary[i], encoded.code[i] };
+    }
+  }
+  return image;
+}
+
+} /* namespace thumb */
+
+/** Assemble a constexpr char array or string_view, sizing the Image */
+#define THUMB_ASSEMBLE(source) \
+  thumb::assemble<thumb::halfwords(source)>(source)
+
+#endif /* __SOFT_STACK_THUMB_ASM_HPP */
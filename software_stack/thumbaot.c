@@ -0,0 +1,366 @@
+/*
+ * Translates Thumb programs ahead of time and checks them against the
+ *  interpreter. A loop of -n random data processing instructions on r0-r5,
+ *  each result summed into r8 and r8 added back into r0-r5 every pass so
+ *  cc can neither drop nor hoist any of them, counted down in r7 for -l
+ *  iterations and left through a BX r6, is timed both ways, and the sum
+ *  has to match; then -r random programs of -s halfwords mixing data
+ *  processing, B, B<cond>, BX, BLX and undefined halfwords run from random
+ *  registers, with random budgets that end inside blocks, and have to
+ *  leave the same registers, flags, PC and step count both ways. Every
+ *  program goes into one C file, built with cc and loaded back.
+ *
+ * usage: thumbaot [-n loop body] [-l iterations] [-r random programs]
+ *                 [-s halfwords] [-o output prefix] [-I core.h directory]
+ *  -I defaults to the directory thumbaot.c was built from, as __FILE__
+ *     names it
+ *
+ * build: cc -O2 -o thumbaot thumbaot.c aot.c core.c stack.c decode.c -ldl
+ */
+#include <dlfcn.h>
+#include "bench.h"
+#include "aot.h"
+
+/* most random steps, the random programs may never leave */
+#define THUMBAOT_BUDGET 20000
+
+/* longest -I directory */
+#define THUMBAOT_MAX_INCLUDE 1024
+
+/* a data processing instruction touching no register above 'top' */
+static unsigned thumbaot_op(unsigned top)
+{
+  unsigned instruction;
+
+  do
+  {
+    instruction = bench_random() % 0x4400;
+  }
+  while (
+         core_opcode(instruction) == CORE_NUM_OPCODES
+      || (instruction & 7) > top
+      || ((instruction >> 3) & 7) > top
+      || (instruction < 0x2000 && instruction >= 0x1800
+          && ((instruction >> 6) & 7) > top)
+      || (instruction >= 0x2000 && instruction < 0x4000
+          && ((instruction >> 8) & 7) > top)
+      );
+
+  return instruction;
+}
+
+/* the register a data processing instruction writes, 8 for flags only */
+static unsigned thumbaot_destination(unsigned instruction)
+{
+  unsigned op = (instruction >> 6) & 0xF;
+
+  if (instruction >= 0x2000 && instruction < 0x4000)
+  {
+    return (instruction & 0x1800) == 0x0800 ? 8 : (instruction >> 8) & 7;
+  }
+  if (instruction >= 0x4000 && (op == 8 || op == 10 || op == 11))
+  {
+    return 8;
+  }
+
+  return instruction & 7;
+}
+
+/* anything the translator has to handle */
+static unsigned thumbaot_any(unsigned address, unsigned count)
+{
+  unsigned kind = bench_random() % 20;
+  int offset = (int) (bench_random() % (count + 8)) - (int) address / 2
+    - 2;
+
+  if (kind < 12)
+  {
+    return bench_random() & 1 ? thumbaot_op(7)
+      : 0x4400 | (bench_random() & 0x3FF);
+  }
+  if (kind < 15)
+  {
+    return 0xD000 | ((bench_random() % 14) << 8) | (offset & 0xFF);
+  }
+  if (kind < 17)
+  {
+    return 0xE000 | (offset & 0x7FF);
+  }
+  if (kind < 18)
+  {
+    return 0x4700 | (bench_random() & 0xF8);
+  }
+
+  return bench_random() & 0xFFFF;
+}
+
+/* halfwords as newAot takes them */
+static void thumbaot_bytes(unsigned char *bytes, const unsigned *code,
+    unsigned count)
+{
+  unsigned i;
+
+  for (i = 0; i < count; i++)
+  {
+    bytes[2 * i]     = code[i] & 0xFF;
+    bytes[2 * i + 1] = code[i] >> 8;
+  }
+}
+
+/* run one way, from a starting state */
+static unsigned long long thumbaot_run(Aot *aot, Core *core,
+    const CoreState *start, u32 *pc, unsigned long long steps, int translated)
+{
+  core->state = *start;
+  *pc = 0;
+  if (translated)
+  {
+    return aot->run(aot, core, pc, steps);
+  }
+
+  return aot_interpret(core, aot->code, aot->count, pc, steps);
+}
+
+int main(int argc, char **argv)
+{
+  unsigned body = 32, programs = 100, halfwords = 64, i, j, count, rd, pass;
+  unsigned long long loops = 100000, ran[2], budget;
+  unsigned long errors = 0, steps = 0;
+  const char *prefix = "thumbaot_out", *include = NULL, *slash;
+  char c_path[256], so_path[256], symbol[32];
+  char cflags[THUMBAOT_MAX_INCLUDE + 16];
+  unsigned *code;
+  unsigned char *bytes;
+  double seconds[2];
+  CoreState start, after;
+  Core *core[2];
+  Aot **aot;
+  void *library;
+  FILE *out;
+  u32 pc[2];
+  int a, status;
+
+  /* options */
+  for (a = 1; a + 1 < argc && argv[a][0] == '-'; a += 2)
+  {
+    switch (argv[a][1])
+    {
+      case 'n': body      = strtoul(argv[a + 1], NULL, 0);   break;
+      case 'l': loops     = strtoull(argv[a + 1], NULL, 0);  break;
+      case 'r': programs  = strtoul(argv[a + 1], NULL, 0);   break;
+      case 's': halfwords = strtoul(argv[a + 1], NULL, 0);   break;
+      case 'o': prefix    = argv[a + 1];                     break;
+      case 'I': include   = argv[a + 1];                     break;
+      default:  a = argc;                                    break;
+    }
+  }
+  if (
+         a != argc || ! body || body > 120 || ! loops || ! halfwords
+      || strlen(prefix) > 200
+      || (include && (! *include || strlen(include) > THUMBAOT_MAX_INCLUDE
+          || strchr(include, '\'')))
+      )
+  {
+    fprintf(stderr, "usage: %s [-n loop body, up to 120] [-l iterations] "
+        "[-r random programs] [-s halfwords] [-o output prefix] "
+        "[-I core.h directory]\n", argv[0]);
+    return 1;
+  }
+  sprintf(c_path, "%s.c", prefix);
+  sprintf(so_path, "%s.so", prefix);
+
+  /* core.h sits beside thumbaot.c unless told otherwise */
+  if (include)
+  {
+    snprintf(cflags, sizeof(cflags), "-O2 -I'%s'", include);
+  }
+  else if ((slash = strrchr(__FILE__, '/')))
+  {
+    snprintf(cflags, sizeof(cflags), "-O2 -I'%.*s'",
+        (int) (slash - __FILE__), __FILE__);
+  }
+  else
+  {
+    snprintf(cflags, sizeof(cflags), "-O2 -I.");
+  }
+
+  count = 2 * body + 14 > halfwords ? 2 * body + 14 : halfwords;
+  if (
+         ! (code = (unsigned *) malloc(count * sizeof(unsigned)))
+      || ! (bytes = (unsigned char *) malloc(2 * count))
+      || ! (aot = (Aot **) calloc(programs + 1, sizeof(Aot *)))
+      || ! (core[0] = newThumbCore())
+      || ! (core[1] = newThumbCore())
+      )
+  {
+    fprintf(stderr, "out of memory\n");
+    return 1;
+  }
+
+  /*
+   * the loop: body with an ADD r8, Rd after each instruction writing a
+   *  register, ADD r0-r5, r8 so no register's value repeats across passes,
+   *  SUB r7, #1, BEQ over a B to 0, BX r6 over a gap to the tail
+   */
+  for (i = j = 0; j < body; j++)
+  {
+    code[i++] = thumbaot_op(5);
+    if ((rd = thumbaot_destination(code[i - 1])) < 8)
+    {
+      code[i++] = 0x4480 | (rd << 3);
+    }
+  }
+  for (j = 0; j < 6; j++)
+  {
+    code[i++] = 0x4440 | j;
+  }
+  pass = i + 3;
+  code[i++] = 0x3F01;
+  code[i++] = 0xD000;
+  code[i] = 0xE000 | ((-(int) (i + 2)) & 0x7FF);
+  i++;
+  code[i++] = 0x4730;
+  code[i++] = 0xDEFF;
+  code[i++] = thumbaot_op(5);
+  code[i++] = thumbaot_op(5);
+  thumbaot_bytes(bytes, code, i);
+  if (! (aot[0] = newAot(bytes, i)))
+  {
+    fprintf(stderr, "out of memory\n");
+    return 1;
+  }
+
+  /* random programs */
+  for (i = 1; i <= programs; i++)
+  {
+    for (j = 0; j < halfwords; j++)
+    {
+      code[j] = thumbaot_any(2 * j, halfwords);
+    }
+    thumbaot_bytes(bytes, code, halfwords);
+    if (! (aot[i] = newAot(bytes, halfwords)))
+    {
+      fprintf(stderr, "out of memory\n");
+      return 1;
+    }
+  }
+
+  /* translate, build, and bind back */
+  if (! (out = fopen(c_path, "w")) || aot_preamble(out))
+  {
+    fprintf(stderr, "cannot write %s\n", c_path);
+    return 1;
+  }
+  for (i = 0; i <= programs; i++)
+  {
+    sprintf(symbol, "thumbaot_%u", i);
+    if (aot[i]->translate(aot[i], out, symbol))
+    {
+      fprintf(stderr, "cannot write %s\n", c_path);
+      return 1;
+    }
+  }
+  fclose(out);
+  seconds[0] = bench_now();
+  if (! (library = aot_compile(c_path, so_path, cflags, &status)))
+  {
+    if (status < 0)
+    {
+      fprintf(stderr, "cannot build %s: cc could not be run\n", so_path);
+    }
+    else if (status && WIFEXITED(status))
+    {
+      fprintf(stderr, "cannot build %s: cc %s exited with %d\n", so_path,
+          cflags, WEXITSTATUS(status));
+    }
+    else if (status)
+    {
+      fprintf(stderr, "cannot build %s: cc %s was killed\n", so_path,
+          cflags);
+    }
+    else
+    {
+      fprintf(stderr, "cannot load %s: %s\n", so_path, dlerror());
+    }
+    return 1;
+  }
+  seconds[0] = bench_now() - seconds[0];
+  for (i = 0; i <= programs; i++)
+  {
+    sprintf(symbol, "thumbaot_%u", i);
+    if (! aot[i]->bind(aot[i], library, symbol))
+    {
+      fprintf(stderr, "no %s in %s\n", symbol, so_path);
+      return 1;
+    }
+  }
+  printf("built             %s, %u programs in %.2f s\n", so_path,
+      programs + 1, seconds[0]);
+
+  /* the loop both ways */
+  memset(&start, 0, sizeof(start));
+  for (j = 0; j < 6; j++)
+  {
+    start.r[j] = bench_random();
+  }
+  start.r[6] = (2 * (pass + 2)) | 1;
+  start.r[7] = (u32) loops;
+  for (i = 0; i < 2; i++)
+  {
+    seconds[i] = bench_now();
+    ran[i] = thumbaot_run(aot[0], core[i], &start, &pc[i], ~0ULL, i);
+    seconds[i] = bench_now() - seconds[i];
+  }
+  errors += ran[0] != ran[1] || pc[0] != pc[1]
+    || memcmp(&core[0]->state, &core[1]->state, sizeof(CoreState));
+  printf("loop              %u instructions a pass, %llu passes, %llu "
+      "steps, r8 0x%08X, %s\n", pass, loops, ran[0],
+      core[0]->state.r[8], errors ? "wrong" : "right");
+  printf("interpreted       %.2f ns a step\n", seconds[0] * 1e9 / ran[0]);
+  printf("translated        %.2f ns a step, %.1fx\n",
+      seconds[1] * 1e9 / ran[1], seconds[0] / seconds[1]);
+
+  /* random programs, from random registers, with random budgets */
+  for (i = 1; i <= programs; i++)
+  {
+    for (j = 0; j < CORE_NUM_REGS; j++)
+    {
+      start.r[j] = bench_random() % 5 ? bench_random()
+        : (bench_random() % halfwords) * 2 + 1;
+    }
+    start.n = bench_random() & 1;
+    start.z = bench_random() & 1;
+    start.c = bench_random() & 1;
+    start.v = bench_random() & 1;
+    budget = bench_random() % THUMBAOT_BUDGET;
+    for (j = 0; j < 2; j++)
+    {
+      ran[j] = thumbaot_run(aot[i], core[j], &start, &pc[j], budget, j);
+    }
+    after = core[1]->state;
+    if (
+           ran[0] != ran[1] || pc[0] != pc[1]
+        || memcmp(&core[0]->state, &after, sizeof(CoreState))
+        )
+    {
+      fprintf(stderr, "thumbaot_%u: %llu steps to 0x%X interpreted, %llu to "
+          "0x%X translated\n", i, ran[0], pc[0], ran[1], pc[1]);
+      errors++;
+    }
+    steps += ran[0];
+  }
+  printf("random            %u programs of %u halfwords, %lu steps, %lu "
+      "wrong\n", programs, halfwords, steps, errors);
+
+  for (i = 0; i <= programs; i++)
+  {
+    aot[i]->free(aot[i]);
+  }
+  core[0]->free(core[0]);
+  core[1]->free(core[1]);
+  free(aot);
+  free(bytes);
+  free(code);
+
+  return errors != 0;
+}
@@ -0,0 +1,445 @@
+/*
+ * Disassembles program images and simple_processor trace dumps, however
+ *  large, as text thumb_asm.hpp can read back or as JSON lines.
+ *
+ * An image is little endian halfwords, addressed from -b. A trace dump is
+ *  tracedump's: entries of 3 little endian 32-bit words, the PC, the raw
+ *  instruction in bits 31-16, and the ALU result, the target for branches.
+ *
+ * The file is mapped rather than read, and cut into chunks of -c units.
+ *  Workers are forked, each formatting every j'th chunk into one of its 2
+ *  shared buffers while the parent writes out the chunks in order, so a
+ *  slow reader holds the workers back at most 2 chunks each.
+ *
+ * usage: thumbdis [-s] [-f image|trace] [-o text|json] [-j workers]
+ *                 [-b base address] [-c units per chunk] file
+ *  -s prints instructions and time taken to standard error
+ *
+ * build: cc -O2 -I . -o thumbdis thumbdis.c disasm.c decode.c stack.c
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "bench.h"
+#include "disasm.h"
+#include "decode.h"
+
+/* bytes of a trace entry, must match tracedump's */
+#define THUMBDIS_ENTRY_BYTES 12
+
+/* longest line of any format, with its newline */
+#define THUMBDIS_LINE_MAX 192
+
+/* the text column's width, when a comment or result follows it */
+#define THUMBDIS_TEXT_WIDTH 24
+
+/* what to disassemble, and how */
+typedef struct _ThumbdisInput
+{
+  const unsigned char *bytes;
+  size_t units;
+  int trace;
+  int json;
+  unsigned base;
+} ThumbdisInput;
+
+/* a worker's output buffer, in memory shared with the parent */
+typedef struct _ThumbdisSlot
+{
+  size_t length;
+  char text[1];
+} ThumbdisSlot;
+
+/* what a worker formats, and where */
+typedef struct _ThumbdisJob
+{
+  const ThumbdisInput *in;
+  unsigned char *shared;
+  size_t slotBytes;
+  unsigned long chunk;
+  unsigned long chunks;
+  unsigned long workers;
+} ThumbdisJob;
+
+static const char thumbdis_hex[16] = "0123456789ABCDEF";
+
+/* a little endian word */
+static unsigned thumbdis_word(const unsigned char *bytes)
+{
+  return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16)
+    | ((unsigned) bytes[3] << 24);
+}
+
+/* digits hex digits */
+static char * thumbdis_hexN(char *out, unsigned value, int digits)
+{
+  while (digits--)
+  {
+    *out++ = thumbdis_hex[(value >> (4 * digits)) & 15];
+  }
+  return out;
+}
+
+static char * thumbdis_dec(char *out, unsigned value)
+{
+  char digits[10];
+  int n = 0;
+
+  do
+  {
+    digits[n++] = (char) ('0' + value % 10);
+    value /= 10;
+  } while (value);
+  while (n)
+  {
+    *out++ = digits[--n];
+  }
+  return out;
+}
+
+static char * thumbdis_str(char *out, const char *s)
+{
+  while (*s)
+  {
+    *out++ = *s++;
+  }
+  return out;
+}
+
+/* the halfword of a unit, and its address */
+static unsigned thumbdis_unit(const ThumbdisInput *in, size_t i,
+    unsigned *address)
+{
+  const unsigned char *at;
+
+  if (in->trace)
+  {
+    at = in->bytes + i * THUMBDIS_ENTRY_BYTES;
+    *address = thumbdis_word(at);
+    return (unsigned) at[6] | (at[7] << 8);
+  }
+  *address = in->base + 2 * (unsigned) i;
+  return in->bytes[2 * i] | (in->bytes[2 * i + 1] << 8);
+}
+
+/* the halfword next to unit i, by delta, if it is next to it in memory */
+static unsigned thumbdis_neighbour(const ThumbdisInput *in, size_t i,
+    int delta, unsigned address)
+{
+  unsigned binary, at;
+
+  if ((delta < 0 && ! i) || (delta > 0 && i + 1 >= in->units))
+  {
+    return DISASM_NONE;
+  }
+  binary = thumbdis_unit(in, i + delta, &at);
+
+  return at == address + 2 * delta ? binary : DISASM_NONE;
+}
+
+/* units from up to to, as lines */
+static size_t thumbdis_format(const ThumbdisInput *in, size_t from,
+    size_t to, char *out)
+{
+  char *start = out;
+  unsigned binary, address, result = 0;
+  size_t i, length;
+  DisasmBranch branch;
+  unsigned prev, next;
+  int offset = 0;
+
+  for (i = from; i < to; i++)
+  {
+    binary = thumbdis_unit(in, i, &address);
+    prev   = thumbdis_neighbour(in, i, -1, address);
+    next   = thumbdis_neighbour(in, i, 1, address);
+    branch = disasm_branch(binary, prev, next, &offset);
+    if (in->trace)
+    {
+      result = thumbdis_word(in->bytes + i * THUMBDIS_ENTRY_BYTES + 8);
+    }
+
+    if (in->json)
+    {
+      out = thumbdis_dec(thumbdis_str(out, "{\"address\":"), address);
+      out = thumbdis_dec(thumbdis_str(out, ",\"binary\":"), binary);
+      out = thumbdis_str(thumbdis_str(out, ",\"opcode\":\""),
+          disasm_name(decode_opcode(binary)));
+      out = thumbdis_str(out, "\",\"text\":\"");
+      out += disasm_cached(binary, prev, next, out);
+      *out++ = '"';
+      if (branch == DISASM_BRANCH_OFFSET)
+      {
+        out = thumbdis_dec(thumbdis_str(out, ",\"target\":"),
+            address + offset);
+      }
+      if (in->trace)
+      {
+        out = thumbdis_dec(thumbdis_str(out, ",\"result\":"), result);
+      }
+      *out++ = '}';
+      *out++ = '\n';
+      continue;
+    }
+
+    /* address  halfword  text, then a target or the trace's result */
+    out = thumbdis_hexN(out, address, 8);
+    *out++ = ' ';
+    *out++ = ' ';
+    out = thumbdis_hexN(out, binary, 4);
+    *out++ = ' ';
+    *out++ = ' ';
+    length = disasm_cached(binary, prev, next, out);
+    out += length;
+    if (in->trace || branch == DISASM_BRANCH_OFFSET)
+    {
+      for (; length < THUMBDIS_TEXT_WIDTH; length++)
+      {
+        *out++ = ' ';
+      }
+      *out++ = ' ';
+      out = thumbdis_str(out, in->trace ? (branch ? "-> 0x" : "   0x")
+          : "@ 0x");
+      out = thumbdis_hexN(out, in->trace ? result : address + offset, 8);
+    }
+    *out++ = '\n';
+  }
+
+  return (size_t) (out - start);
+}
+
+/* all of it, unless the reader has gone */
+static int thumbdis_write(const char *text, size_t length)
+{
+  ssize_t wrote;
+
+  while (length)
+  {
+    if ((wrote = write(STDOUT_FILENO, text, length)) < 0)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      return -1;
+    }
+    text += wrote;
+    length -= (size_t) wrote;
+  }
+  return 0;
+}
+
+/*
+ * Worker w, formatting chunks w, w + workers, ... into its 2 slots in
+ *  turn: a token up when a chunk is formatted, and one down before
+ *  reusing a slot once its chunk has been written out
+ */
+static int thumbdis_work(unsigned long w, int up, int down, void *context)
+{
+  const ThumbdisJob *job = (const ThumbdisJob *) context;
+  ThumbdisSlot *slot;
+  unsigned long c, k;
+  char token = 0;
+
+  for (k = 0, c = w; c < job->chunks; k++, c += job->workers)
+  {
+    if (k >= 2 && read(down, &token, 1) != 1)
+    {
+      return 1;
+    }
+    slot = (ThumbdisSlot *) (job->shared + (2 * w + k % 2) * job->slotBytes);
+    slot->length = thumbdis_format(job->in, c * job->chunk,
+        c + 1 < job->chunks ? (c + 1) * job->chunk : job->in->units,
+        slot->text);
+    if (write(up, &token, 1) != 1)
+    {
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+int main(int argc, char **argv)
+{
+  ThumbdisInput in;
+  ThumbdisJob job;
+  ThumbdisSlot *slot;
+  BenchWorker *children = NULL;
+  unsigned long workers = 0, chunk = 1 << 15, w, c, chunks, spawned = 0;
+  unsigned long long written = 0;
+  size_t slotBytes, unitBytes;
+  unsigned char *shared = NULL;
+  double started;
+  struct stat st;
+  int a, fd, stats = 0, failed = 0;
+  char token = 0;
+
+  memset(&in, 0, sizeof(in));
+  a = 1;
+  if (a < argc && ! strcmp(argv[a], "-s"))
+  {
+    stats = 1;
+    a++;
+  }
+
+  /* options */
+  for (; a + 1 < argc && argv[a][0] == '-'; a += 2)
+  {
+    switch (argv[a][1])
+    {
+      case 'f': in.trace = ! strcmp(argv[a + 1], "trace");          break;
+      case 'o': in.json  = ! strcmp(argv[a + 1], "json");           break;
+      case 'j': workers  = strtoul(argv[a + 1], NULL, 0);           break;
+      case 'b': in.base  = (unsigned) strtoul(argv[a + 1], NULL, 0); break;
+      case 'c': chunk    = strtoul(argv[a + 1], NULL, 0);           break;
+      default:  a = argc;                                           break;
+    }
+  }
+  if (a + 1 != argc || ! chunk)
+  {
+    fprintf(stderr, "usage: %s [-s] [-f image|trace] [-o text|json] "
+        "[-j workers] [-b base address] [-c units per chunk] file\n",
+        argv[0]);
+    return 1;
+  }
+  if (! workers)
+  {
+    workers = (unsigned long) sysconf(_SC_NPROCESSORS_ONLN);
+    workers = workers ? workers : 1;
+  }
+
+  /* map the whole file, the kernel reads it in as it is touched */
+  if ((fd = open(argv[a], O_RDONLY)) < 0 || fstat(fd, &st))
+  {
+    perror(argv[a]);
+    return 1;
+  }
+  unitBytes = in.trace ? THUMBDIS_ENTRY_BYTES : 2;
+  in.units = (size_t) st.st_size / unitBytes;
+  if (
+         in.units
+      && (in.bytes = (const unsigned char *) mmap(NULL, (size_t) st.st_size,
+             PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED
+      )
+  {
+    perror(argv[a]);
+    return 1;
+  }
+  close(fd);
+  if (in.units)
+  {
+    madvise((void *) in.bytes, (size_t) st.st_size, MADV_SEQUENTIAL);
+  }
+  if ((size_t) st.st_size % unitBytes)
+  {
+    fprintf(stderr, "ignoring %lu trailing bytes\n",
+        (unsigned long) ((size_t) st.st_size % unitBytes));
+  }
+
+  /* the table before forking, so the workers share it */
+  disasm_prepare();
+  chunks = (in.units + chunk - 1) / chunk;
+  workers = workers < chunks ? workers : chunks ? chunks : 1;
+  slotBytes = (offsetof(ThumbdisSlot, text) + chunk * THUMBDIS_LINE_MAX
+      + 63) & ~(size_t) 63;
+  started = bench_now();
+
+  if (
+         (shared = (unsigned char *) mmap(NULL, 2 * workers * slotBytes,
+             PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0))
+           == MAP_FAILED
+      || ! (children = (BenchWorker *) calloc(workers, sizeof(BenchWorker)))
+      )
+  {
+    fprintf(stderr, "out of memory\n");
+    return 1;
+  }
+
+  /* a single worker is the parent itself */
+  if (workers == 1)
+  {
+    slot = (ThumbdisSlot *) shared;
+    for (c = 0; c < chunks && ! failed; c++)
+    {
+      slot->length = thumbdis_format(&in, c * chunk,
+          c + 1 < chunks ? (c + 1) * chunk : in.units, slot->text);
+      failed = thumbdis_write(slot->text, slot->length);
+      written += slot->length;
+    }
+  }
+  else
+  {
+    /* fork the workers, a pipe up and one down each */
+    job.in        = &in;
+    job.shared    = shared;
+    job.slotBytes = slotBytes;
+    job.chunk     = chunk;
+    job.chunks    = chunks;
+    job.workers   = workers;
+    fflush(stdout);
+    for (; spawned < workers; spawned++)
+    {
+      if (bench_spawn(&children[spawned], spawned, thumbdis_work, &job))
+      {
+        perror("fork");
+        failed = 1;
+        break;
+      }
+    }
+
+    /* write the chunks out in order */
+    for (c = 0; c < chunks && ! failed; c++)
+    {
+      w = c % workers;
+      if (read(children[w].up, &token, 1) != 1)
+      {
+        fprintf(stderr, "worker %lu died\n", w);
+        failed = 1;
+        break;
+      }
+      slot = (ThumbdisSlot *) (shared + (2 * w + (c / workers) % 2)
+          * slotBytes);
+      failed = thumbdis_write(slot->text, slot->length);
+      written += slot->length;
+      if (
+             c + 2 * workers < chunks
+          && write(children[w].down, &token, 1) != 1
+          )
+      {
+        failed = 1;
+      }
+    }
+
+    for (w = 0; w < spawned; w++)
+    {
+      if (bench_reap(&children[w], failed) && ! failed)
+      {
+        fprintf(stderr, "worker %lu failed\n", w);
+        failed = 1;
+      }
+    }
+  }
+
+  if (stats)
+  {
+    started = bench_now() - started;
+    fprintf(stderr, "instructions      %lu, %lu workers\n",
+        (unsigned long) in.units, workers);
+    fprintf(stderr, "output            %.1f MB, %.1f bytes a line\n",
+        written / 1e6, in.units ? (double) written / in.units : 0.0);
+    fprintf(stderr, "host              %.1f M instructions/s, %.1f s\n",
+        started > 0 ? in.units / started / 1e6 : 0.0, started);
+  }
+
+  munmap(shared, 2 * workers * slotBytes);
+  if (in.units)
+  {
+    munmap((void *) in.bytes, (size_t) st.st_size);
+  }
+  free(children);
+
+  return failed;
+}
@@ -0,0 +1,109 @@
+/*
+ * Turns a dump of simple_processor's trace buffer, as drained by the
+ *  helloworld trace driver, into a readable instruction trace.
+ *
+ * A dump is a sequence of entries, each 3 little endian 32-bit words:
+ *  the PC, the raw instruction in bits 31-16 with its opcode in bits 5-0,
+ *  and the ALU result, which for branches is the branch target.
+ *
+ * usage: tracedump [dump file]
+ *  reads standard input when no file is given
+ */
+#include <stdio.h>
+
+/* words per entry, must match trace_buffer.vhd */
+#define TRACE_ENTRY_WORDS 3
+
+/* opcode names, indexed as in opcodes.vhd */
+static const char *opcode_names[64] =
+{
+  "LSL Rd, Rm, #i",  "LSR Rd, Rm, #i",  "ASR Rd, Rm, #i",  "ADD Rd, Rm, Rn",
+  "SUB Rd, Rm, Rn",  "ADD Rd, Rn, #i",  "SUB Rd, Rn, #i",  "MOV Rd, #i",
+  "CMP Rn, #i",      "ADD Rd, #i",      "SUB Rd, #i",      "AND Rd, Rm",
+  "EOR Rd, Rm",      "LSL Rd, Rs",      "LSR Rd, Rs",      "ASR Rd, Rs",
+  "ADC Rd, Rm",      "SBC Rd, Rm",      "ROR Rd, Rs",      "TST Rm, Rn",
+  "NEG Rd, Rm",      "CMP Rm, Rn",      "CMN Rm, Rn",      "ORR Rd, Rm",
+  "MUL Rd, Rm",      "BIC Rm, Rn",      "MVN Rd, Rm",      "ADD Rd, Rm",
+  "CMP Rm, Rn",      "MOV Rd, Rm",      "BX Rm",           "BLX Rm",
+  "LDR Rd, [PC, #i]", "STR Rd, [Rn, Rm]", "STRH Rd, [Rn, Rm]",
+  "STRB Rd, [Rn, Rm]", "LDRSB Rd, [Rn, Rm]", "LDR Rd, [Rn, Rm]",
+  "LDRH Rd, [Rn, Rm]", "LDRB Rd, [Rn, Rm]", "LDRSH Rd, [Rn, Rm]",
+  "STR Rd, [Rn, #i]", "LDR Rd, [Rn, #i]", "STRB Rd, [Rn, #i]",
+  "LDRB Rd, [Rn, #i]", "STRH Rd, [Rn, #i]", "LDRH Rd, [Rn, #i]",
+  "STR Rd, [SP, #i]", "LDR Rd, [SP, #i]", "ADD Rd, PC, #i",
+  "ADD Rd, SP, #i",  "SUB SP, #i",      "PUSH {Rl, LR}",   "POP {Rl, PC}",
+  "BKPT #i",         "STMIA Rn!, {Rl}", "LDMIA Rn!, {Rl}", "B<cond> #i",
+  "UNUSED",          "SWI #i",          "B #i",            "BLX #i (low)",
+  "BLX #i (high)",   "BL #i"
+};
+
+/* opcodes whose ALU result is a branch target */
+static int is_branch(unsigned opcode)
+{
+  return opcode == 30 || opcode == 31 || opcode == 53 || opcode == 57
+    || (opcode >= 60 && opcode <= 63);
+}
+
+/* assemble a little endian word */
+static unsigned long word_at(const unsigned char *bytes)
+{
+  return (unsigned long) bytes[0]
+    | ((unsigned long) bytes[1] << 8)
+    | ((unsigned long) bytes[2] << 16)
+    | ((unsigned long) bytes[3] << 24);
+}
+
+int main(int argc, char **argv)
+{
+  unsigned char entry[TRACE_ENTRY_WORDS * 4];
+  unsigned long pc;
+  unsigned long inst;
+  unsigned long result;
+  unsigned long n = 0;
+  size_t got;
+  FILE *in = stdin;
+
+  if (argc > 2)
+  {
+    fprintf(stderr, "usage: %s [dump file]\n", argv[0]);
+    return 1;
+  }
+  if (argc == 2 && ! (in = fopen(argv[1], "rb")))
+  {
+    perror(argv[1]);
+    return 1;
+  }
+
+  printf("%-8s %-10s %-6s %-22s %s\n",
+      "#", "PC", "INST", "OPCODE", "RESULT");
+  while ((got = fread(entry, 1, sizeof(entry), in)) == sizeof(entry))
+  {
+    pc     = word_at(entry);
+    inst   = word_at(entry + 4);
+    result = word_at(entry + 8);
+
+    printf("%-8lu 0x%08lX 0x%04lX %-22s ",
+        n++, pc, inst >> 16, opcode_names[inst & 0x3F]);
+    if (is_branch(inst & 0x3F))
+    {
+      printf("-> 0x%08lX\n", result);
+    }
+    else
+    {
+      printf("0x%08lX\n", result);
+    }
+  }
+
+  /* a dump cut short part way through an entry */
+  if (got)
+  {
+    fprintf(stderr, "ignoring %lu trailing bytes\n", (unsigned long) got);
+  }
+
+  if (in != stdin)
+  {
+    fclose(in);
+  }
+
+  return 0;
+}
@@ -0,0 +1,58 @@
+#include "viewer.h"
+
+/* method forward decls */
+u32 ViewerModel_read(Device *device, u32 offset);
+ViewerModel * ViewerModel_free(ViewerModel *self);
+
+/* constructor */
+ViewerModel * newViewerModel(u32 base, GateModel *gate)
+{
+  ViewerModel *self = gate ? (ViewerModel *) malloc(sizeof(ViewerModel))
+    : NULL;
+
+  /* out of memory */
+  if (! self)
+  {
+    return NULL;
+  }
+
+  /* zero */
+  memset(self, 0, sizeof(ViewerModel));
+
+  /* bind methods, nothing is writable */
+  self->device.base = base;
+  self->device.size = VIEWER_SIZE;
+  self->device.read = ViewerModel_read;
+  self->free        = ViewerModel_free;
+  self->gate        = gate;
+
+  /* the address range is already taken */
+  if (hal_attach(&self->device))
+  {
+    free(self);
+    return NULL;
+  }
+
+  return self;
+}
+
+/* read a permission word off TABLE_OUT */
+u32 ViewerModel_read(Device *device, u32 offset)
+{
+  ViewerModel *self = (ViewerModel *) device;
+  unsigned reg = offset / 4;
+
+  return reg < GATE_NUM_KEYS ? self->gate->perms[reg] : 0;
+}
+
+/* destructor */
+ViewerModel * ViewerModel_free(ViewerModel *self)
+{
+  if (self)
+  {
+    hal_detach(&self->device);
+    free(self);
+  }
+
+  return NULL;
+}
@@ -0,0 +1,39 @@
+#ifndef __SOFT_STACK_VIEWER
+#define __SOFT_STACK_VIEWER
+
+#include "gate.h"
+
+/** Bytes decoded by a gate_viewer: permissions then soft reset space */
+#define VIEWER_SIZE 0x200
+
+/**
+ * A ViewerModel models gate_viewer, which reads a trusted_gate's
+ *  permissions straight off its TABLE_OUT port.
+ */
+typedef struct _ViewerModel
+{
+  /** bus model view of this ViewerModel, must stay the first member */
+  Device device;
+
+  /** gate whose TABLE_OUT is wired to TABLE_IN */
+  GateModel *gate;
+
+  /**
+   * Destructor, detaches this ViewerModel from the bus model
+   *
+   * @return NULL
+   */
+  struct _ViewerModel * (*free)(struct _ViewerModel *self);
+
+} ViewerModel;
+
+/**
+ * Constructor, attaches the new ViewerModel to the bus model
+ *
+ * @param base base address, XPAR_GATE_VIEWER_0_BASEADDR on the ZedBoard
+ * @param gate gate to view
+ * @return a new ViewerModel, or NULL if out of memory or base is taken
+ */
+ViewerModel * newViewerModel(u32 base, GateModel *gate);
+
+#endif /* __SOFT_STACK_VIEWER */
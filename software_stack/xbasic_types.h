@@ -0,0 +1,7 @@
+#ifndef __SOFT_STACK_XBASIC_TYPES
+#define __SOFT_STACK_XBASIC_TYPES
+
+/* host stand-in for the Xilinx BSP header, types live in the bus model */
+#include "hal.h"
+
+#endif /* __SOFT_STACK_XBASIC_TYPES */
@@ -0,0 +1,7 @@
+#ifndef __SOFT_STACK_XIL_IO
+#define __SOFT_STACK_XIL_IO
+
+/* host stand-in for the Xilinx BSP header, I/O goes to the bus model */
+#include "hal.h"
+
+#endif /* __SOFT_STACK_XIL_IO */
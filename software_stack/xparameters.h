@@ -0,0 +1,10 @@
+#ifndef __SOFT_STACK_XPARAMETERS
+#define __SOFT_STACK_XPARAMETERS
+
+/* host stand-in for the generated Xilinx BSP header */
+#define XPAR_EDKREGFILE_0_BASEADDR   0x43C00000
+#define XPAR_TRUSTED_KEY_0_BASEADDR  0x69800000
+#define XPAR_GATE_VIEWER_0_BASEADDR  0x6E000000
+#define XPAR_TRUSTED_GATE_0_BASEADDR 0x7FA00000
+
+#endif /* __SOFT_STACK_XPARAMETERS */
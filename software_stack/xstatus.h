@@ -0,0 +1,8 @@
+#ifndef __SOFT_STACK_XSTATUS
+#define __SOFT_STACK_XSTATUS
+
+/* host stand-in for the Xilinx BSP header */
+#define XST_SUCCESS 0L
+#define XST_FAILURE 1L
+
+#endif /* __SOFT_STACK_XSTATUS */
@@ -0,0 +1,174 @@
+/*****************************************************************************
+* Filename:          edkregfile.h
+* Version:           1.00.a
+* Description:       Register codes and status words of the EDK register file
+* Date:              Sun, Oct 18, 2026  1:21:37 PM
+*****************************************************************************/
+
+#ifndef EDKREGFILE_H
+#define EDKREGFILE_H
+
+#include "pl_dev_driver.h"
+
+/** Base address of the EDK register file */
+#define EDKREGFILE_BASEADDR XPAR_EDKREGFILE_0_BASEADDR
+
+/** Side channel codes, used as register offsets */
+typedef enum _EDKREGFILE_CODES
+{
+  EDKREGFILE_NO_ACTION = 0,
+  EDKREGFILE_SET_ADDRESS,
+  EDKREGFILE_SET_DATA,
+  EDKREGFILE_PERFORM_OP,
+  EDKREGFILE_CLEAR,
+  EDKREGFILE_PULSE,
+  EDKREGFILE_USER_BASE
+} EDKREGFILE_CODES;
+
+/** Status words in the user space, must match reg_file_constants.vhd */
+typedef enum _EDKREGFILE_USER_REGS
+{
+  EDKREGFILE_DCACHE_HITS = 0,
+  EDKREGFILE_DCACHE_MISSES,
+  EDKREGFILE_DCACHE_WBACKS,
+  EDKREGFILE_INST_FIFO,
+  EDKREGFILE_INST_UNDERFLOWS,
+  EDKREGFILE_PERF_CTRL,
+  EDKREGFILE_PERF_RETIRED,
+  EDKREGFILE_PERF_BRANCHES,
+  EDKREGFILE_PERF_LOADS,
+  EDKREGFILE_PERF_STORES,
+  EDKREGFILE_PERF_STALLS,
+  EDKREGFILE_PERF_STATES,
+  EDKREGFILE_TRACE_CTRL = 20,
+  EDKREGFILE_TRACE_DATA,
+  EDKREGFILE_TRACE_TRIG_OP,
+  EDKREGFILE_DCACHE_ERRORS = 24,
+  EDKREGFILE_USER_N_REGS = 26
+} EDKREGFILE_USER_REGS;
+
+/**
+ * Read a status word out of the user space.
+ *
+ * @param   Reg one of EDKREGFILE_USER_REGS
+ * @return  the status word
+ */
+#define EDKREGFILE_mReadUser(Reg) \
+  PL_DEV_mReadReg(EDKREGFILE_BASEADDR, (EDKREGFILE_USER_BASE + (Reg)))
+
+/**
+ * Write a word into the user space.
+ *
+ * @param   Reg one of EDKREGFILE_USER_REGS
+ * @param   Data data to write
+ * @return  None.
+ */
+#define EDKREGFILE_mWriteUser(Reg, Data) \
+  PL_DEV_mWriteReg(EDKREGFILE_BASEADDR, (EDKREGFILE_USER_BASE + (Reg)), Data)
+
+/** Loads and stores served by the data cache without an AXI transfer */
+#define read_dcache_hits() \
+  EDKREGFILE_mReadUser(EDKREGFILE_DCACHE_HITS)
+
+/** Loads and stores which had to refill a line */
+#define read_dcache_misses() \
+  EDKREGFILE_mReadUser(EDKREGFILE_DCACHE_MISSES)
+
+/** Dirty lines written back before being replaced */
+#define read_dcache_writebacks() \
+  EDKREGFILE_mReadUser(EDKREGFILE_DCACHE_WBACKS)
+
+/** Write backs and refills the slave refused, each left unserved */
+#define read_dcache_errors() \
+  EDKREGFILE_mReadUser(EDKREGFILE_DCACHE_ERRORS)
+
+/** Queue 2 packed instructions, low halfword runs first */
+#define push_inst_pair(x) \
+  EDKREGFILE_mWriteUser(EDKREGFILE_INST_FIFO, x)
+
+/** Words queued in the instruction prefetch FIFO */
+#define read_inst_fifo_occupancy() \
+  EDKREGFILE_mReadUser(EDKREGFILE_INST_FIFO)
+
+/** Instruction fetches which found the prefetch FIFO empty */
+#define read_inst_fifo_underflows() \
+  EDKREGFILE_mReadUser(EDKREGFILE_INST_UNDERFLOWS)
+
+/** Empty the instruction prefetch FIFO and zero its underflow count */
+#define flush_inst_fifo() \
+  EDKREGFILE_mWriteUser(EDKREGFILE_INST_UNDERFLOWS, 0)
+
+/** Performance counter control word bits */
+typedef enum _EDKREGFILE_PERF_BITS
+{
+  EDKREGFILE_PERF_FREEZE = 0x00000001,
+  EDKREGFILE_PERF_SNAPSHOT = 0x00000002,
+  EDKREGFILE_PERF_CLEAR = 0x00000004
+} EDKREGFILE_PERF_BITS;
+
+/** Number of state machine states with a cycle counter, states 1 and up */
+#define EDKREGFILE_PERF_N_STATES 9
+
+/** Write the performance counter control word */
+#define write_perf_ctrl(x) \
+  EDKREGFILE_mWriteUser(EDKREGFILE_PERF_CTRL, x)
+
+/** Freeze bit in 0, number of snapshots taken in 31-16 */
+#define read_perf_ctrl() \
+  EDKREGFILE_mReadUser(EDKREGFILE_PERF_CTRL)
+
+/**
+ * Read a performance counter snapshot
+ *
+ * @param x one of the EDKREGFILE_PERF_* counters
+ * @return the counter value as of the last snapshot
+ */
+#define read_perf_counter(x) \
+  EDKREGFILE_mReadUser(x)
+
+/**
+ * Read the snapshot of cycles spent in a state machine state
+ *
+ * @param x state, 1 through EDKREGFILE_PERF_N_STATES
+ * @return the cycle count as of the last snapshot
+ */
+#define read_perf_state_cycles(x) \
+  EDKREGFILE_mReadUser(EDKREGFILE_PERF_STATES + (x) - 1)
+
+/** Trace buffer control word bits, must match trace_buffer.vhd */
+typedef enum _EDKREGFILE_TRACE_BITS
+{
+  EDKREGFILE_TRACE_ENABLE = 0x00000001,
+  EDKREGFILE_TRACE_ADDR_TRIG = 0x00000002,
+  EDKREGFILE_TRACE_OP_TRIG = 0x00000004,
+  EDKREGFILE_TRACE_CLEAR = 0x00000008
+} EDKREGFILE_TRACE_BITS;
+
+/** Words making up a single trace buffer entry */
+#define EDKREGFILE_TRACE_ENTRY_WORDS 3
+
+/** Write the trace buffer control word */
+#define write_trace_ctrl(x) \
+  EDKREGFILE_mWriteUser(EDKREGFILE_TRACE_CTRL, x)
+
+/** Enabled in bit 0, triggered in bit 1, entries held in 31-16 */
+#define read_trace_ctrl() \
+  EDKREGFILE_mReadUser(EDKREGFILE_TRACE_CTRL)
+
+/** PC which stops recording while EDKREGFILE_TRACE_ADDR_TRIG is set */
+#define write_trace_trig_pc(x) \
+  EDKREGFILE_mWriteUser(EDKREGFILE_TRACE_DATA, x)
+
+/** Opcode which stops recording while EDKREGFILE_TRACE_OP_TRIG is set */
+#define write_trace_trig_op(x) \
+  EDKREGFILE_mWriteUser(EDKREGFILE_TRACE_TRIG_OP, x)
+
+/** Pop the next word of the oldest trace buffer entry */
+#define read_trace_data() \
+  EDKREGFILE_mReadUser(EDKREGFILE_TRACE_DATA)
+
+/** Entries recorded since the trace buffer was last cleared */
+#define read_trace_captured() \
+  EDKREGFILE_mReadUser(EDKREGFILE_TRACE_TRIG_OP)
+
+#endif /** EDKREGFILE_H */
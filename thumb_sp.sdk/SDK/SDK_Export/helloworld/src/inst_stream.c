@@ -0,0 +1,68 @@
+#include "inst_stream.h"
+
+/* pack up to INST_STREAM_HALF words, returning the next unpacked Instruction */
+static Instruction * pack_half(Instruction *cur, Xuint32 *buffer,
+        unsigned *words, int *sent)
+{
+    Xuint32 low;
+
+    *words = 0;
+    while (cur && *words < INST_STREAM_HALF)
+    {
+        /* low halfword executes first */
+        low = cur->binary & 0x0000FFFF;
+        (*sent)++;
+
+        /* odd instruction out gets padded */
+        if ((cur = cur->next))
+        {
+            buffer[(*words)++] = low | ((cur->binary & 0x0000FFFF) << 16);
+            (*sent)++;
+            cur = cur->next;
+        }
+        else
+        {
+            buffer[(*words)++] = low | (INST_STREAM_PAD << 16);
+        }
+    }
+
+    return cur;
+}
+
+/// send a whole Stack through the prefetch FIFO
+int stream_stack(Stack *stack)
+{
+    static Xuint32 buffers[2][INST_STREAM_HALF];
+    Instruction *cur = stack ? stack->trunk : NULL;
+    unsigned words[2] = { 0, 0 }, i;
+    int active = 0, sent = 0;
+
+    if (! stack)
+    {
+        return -1;
+    }
+
+    /* start from the bottom of the Stack */
+    while (cur && cur->prev && (cur = cur->prev));
+
+    /* prime the first buffer */
+    cur = pack_half(cur, buffers[active], &words[active], &sent);
+
+    while (words[active])
+    {
+        /* wait for the processor to free up half of the FIFO */
+        while (read_inst_fifo_occupancy() > INST_FIFO_DEPTH - INST_STREAM_HALF);
+
+        /* back-to-back writes to the push register */
+        for (i = 0; i < words[active]; i++)
+        {
+            push_inst_pair(buffers[active][i]);
+        }
+
+        /* pack the other buffer while this one drains */
+        active ^= 1;
+        cur = pack_half(cur, buffers[active], &words[active], &sent);
+    }
+
+    return sent;
+}
@@ -0,0 +1,40 @@
+/**
+ * @file inst_stream.h
+ * Streams a software_stack Stack into simple_processor's instruction
+ *   prefetch FIFO.
+ *
+ * Copyright (c) 2026 Assured Information Security
+ *   All rights reserved.
+ *
+ * @author agent <agent@local>
+ * @version 1.00
+ */
+#include "edkregfile.h"
+#include "stack.h"
+
+#ifndef INST_STREAM_H
+#define INST_STREAM_H
+
+/** Prefetch FIFO depth in words, must match C_INST_FIFO_DEPTH */
+#define INST_FIFO_DEPTH 64
+
+/** Words packed per buffer, each buffer refills half of the FIFO */
+#define INST_STREAM_HALF (INST_FIFO_DEPTH / 2)
+
+/** Pads an odd instruction count, 0xDEFF is the unused instruction */
+#define INST_STREAM_PAD 0x0000DEFF
+
+/**
+ * Send every Instruction in a Stack to the prefetch FIFO, in address
+ *   order, without modifying the Stack.
+ *
+ * Instructions are packed 2 to a word into one of 2 buffers while the
+ *   other buffer's words are being pushed, and a buffer is only pushed
+ *   once the processor has drained at least half of the FIFO.
+ *
+ * @param stack Stack to send
+ * @return the number of instructions sent, or -1 if stack is NULL
+ */
+int stream_stack(Stack *stack);
+
+#endif /* INST_STREAM_H */
@@ -0,0 +1,41 @@
+#include "perf_counters.h"
+
+/* keep freeze state across snapshots, the control word sets every bit */
+static Xuint32 perf_frozen = 0;
+
+/// stop or restart counting
+void perf_freeze(int frozen)
+{
+    perf_frozen = frozen ? EDKREGFILE_PERF_FREEZE : 0;
+    write_perf_ctrl(perf_frozen);
+}
+
+/// snapshot, optionally clear, and read back every counter
+int perf_snapshot(PerfCounters *out, int clear)
+{
+    int i;
+
+    if (! out)
+    {
+        return 1;
+    }
+
+    write_perf_ctrl(
+            perf_frozen
+            | EDKREGFILE_PERF_SNAPSHOT
+            | (clear ? EDKREGFILE_PERF_CLEAR : 0)
+            );
+
+    out->sequence = read_perf_ctrl() >> 16;
+    out->retired  = read_perf_counter(EDKREGFILE_PERF_RETIRED);
+    out->branches = read_perf_counter(EDKREGFILE_PERF_BRANCHES);
+    out->loads    = read_perf_counter(EDKREGFILE_PERF_LOADS);
+    out->stores   = read_perf_counter(EDKREGFILE_PERF_STORES);
+    out->stalls   = read_perf_counter(EDKREGFILE_PERF_STALLS);
+    for (i = 0; i < EDKREGFILE_PERF_N_STATES; i++)
+    {
+        out->state_cycles[i] = read_perf_state_cycles(i + 1);
+    }
+
+    return 0;
+}
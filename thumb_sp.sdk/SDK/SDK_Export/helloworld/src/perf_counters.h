@@ -0,0 +1,56 @@
+/**
+ * @file perf_counters.h
+ * Driver for simple_processor's performance counters.
+ *
+ * Copyright (c) 2026 Assured Information Security
+ *   All rights reserved.
+ *
+ * @author agent <agent@local>
+ * @version 1.00
+ */
+#include "edkregfile.h"
+
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+/** One consistent copy of every counter */
+typedef struct _PerfCounters
+{
+    /** snapshots taken so far, including this one */
+    Xuint32 sequence;
+
+    /** instructions which reached DO_LOAD_STORE */
+    Xuint32 retired;
+
+    /** taken branches */
+    Xuint32 branches;
+
+    /** loads and stores, including PUSH/POP and LDMIA/STMIA */
+    Xuint32 loads;
+    Xuint32 stores;
+
+    /** cycles spent waiting on the prefetch FIFO or the data cache */
+    Xuint32 stalls;
+
+    /** cycles spent in each state, index 0 is state 1 */
+    Xuint32 state_cycles[EDKREGFILE_PERF_N_STATES];
+} PerfCounters;
+
+/**
+ * Stop or restart counting. Frozen counters can be snapshotted repeatedly
+ *   without drifting.
+ *
+ * @param frozen non-zero to freeze, zero to count
+ */
+void perf_freeze(int frozen);
+
+/**
+ * Take a snapshot of the counters and read it back.
+ *
+ * @param out where to store the snapshot
+ * @param clear non-zero to zero the live counters once the snapshot is taken
+ * @return zero, or a non-zero error code if out is NULL
+ */
+int perf_snapshot(PerfCounters *out, int clear);
+
+#endif /* PERF_COUNTERS_H */
@@ -0,0 +1,56 @@
+#include "trace.h"
+
+/* keep the enable and trigger bits, the control word sets every bit */
+static Xuint32 trace_ctrl = 0;
+
+/// clear, arm the triggers, and record
+void trace_start(int trig_pc, Xuint32 pc, int trig_op, Xuint32 opcode)
+{
+    write_trace_trig_pc(pc);
+    write_trace_trig_op(opcode);
+
+    trace_ctrl = EDKREGFILE_TRACE_ENABLE
+        | (trig_pc ? EDKREGFILE_TRACE_ADDR_TRIG : 0)
+        | (trig_op ? EDKREGFILE_TRACE_OP_TRIG : 0);
+    write_trace_ctrl(trace_ctrl | EDKREGFILE_TRACE_CLEAR);
+}
+
+/// stop recording
+void trace_stop(void)
+{
+    trace_ctrl = 0;
+    write_trace_ctrl(trace_ctrl);
+}
+
+/// check whether a trigger has fired
+int trace_triggered(void)
+{
+    return (read_trace_ctrl() >> 1) & 1;
+}
+
+/// pop entries back to back, the AXI4-Lite slave does not burst
+int trace_drain(Xuint32 *words, int max_entries)
+{
+    int entries;
+    int i;
+
+    if (! words || max_entries <= 0)
+    {
+        return 0;
+    }
+
+    /* only entries held now, stop recording first if the buffer could
+       wrap while draining, or the oldest entry moves underneath us */
+    entries = read_trace_ctrl() >> 16;
+    if (entries > max_entries)
+    {
+        entries = max_entries;
+    }
+
+    for (i = 0; i < entries * EDKREGFILE_TRACE_ENTRY_WORDS; i++)
+    {
+        words[i] = read_trace_data();
+    }
+
+    return entries;
+}
@@ -0,0 +1,49 @@
+/**
+ * @file trace.h
+ * Driver for simple_processor's instruction trace buffer.
+ *
+ * Copyright (c) 2026 Assured Information Security
+ *   All rights reserved.
+ *
+ * @author agent <agent@local>
+ * @version 1.00
+ */
+#include "edkregfile.h"
+
+#ifndef TRACE_H
+#define TRACE_H
+
+/**
+ * Empty the trace buffer and start recording.
+ *
+ * @param trig_pc non-zero to stop recording once the instruction at pc
+ *   retires
+ * @param pc address to stop at
+ * @param trig_op non-zero to stop recording once an instruction with
+ *   opcode retires
+ * @param opcode opcode to stop at, numbered as in opcodes.vhd
+ */
+void trace_start(int trig_pc, Xuint32 pc, int trig_op, Xuint32 opcode);
+
+/**
+ * Stop recording, keeping every entry held.
+ */
+void trace_stop(void);
+
+/**
+ * @return non-zero once a trigger has stopped recording
+ */
+int trace_triggered(void);
+
+/**
+ * Drain the oldest entries, EDKREGFILE_TRACE_ENTRY_WORDS words each, in the
+ *   layout the host side tracedump decoder reads. Call trace_stop() or wait
+ *   for a trigger first if the buffer may fill up while draining.
+ *
+ * @param words where to store the entries
+ * @param max_entries room in words, in entries
+ * @return number of entries drained
+ */
+int trace_drain(Xuint32 *words, int max_entries);
+
+#endif /* TRACE_H */
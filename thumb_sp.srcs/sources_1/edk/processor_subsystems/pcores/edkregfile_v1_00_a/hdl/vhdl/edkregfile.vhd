@@ -123,6 +123,9 @@ entity edkregfile is
     -- Number of clock controlled I/O channels exposed to other hardware
     NUM_CHANNELS                   : integer              := 32;
 
+    -- Number of status words readable through the user space codes
+    NUM_USER_REGS                  : integer              := 26;
+
     -- ADD USER GENERICS ABOVE THIS LINE ---------------
 
     -- DO NOT EDIT BELOW THIS LINE ---------------------
@@ -178,6 +181,19 @@ entity edkregfile is
     -- exposed and inverted AXI reset signal
     reset_out     : out   std_logic;
 
+    -- status words from other hardware, readable at codes 6 and up
+    status_in     : in    std_logic_vector (
+        NUM_USER_REGS*C_SLV_DWIDTH-1 downto 0
+        );
+
+    -- software data written at codes 6 and up, with a one clock strobe
+    --  for the user space word it was written to
+    user_data     : out   std_logic_vector(C_SLV_DWIDTH-1 downto 0);
+    user_wr       : out   std_logic_vector(NUM_USER_REGS-1 downto 0);
+
+    -- one clock strobe for the user space word software has just read
+    user_rd       : out   std_logic_vector(NUM_USER_REGS-1 downto 0);
+
     -- ADD USER PORTS ABOVE THIS LINE ------------------
 
     -- DO NOT EDIT BELOW THIS LINE ---------------------
@@ -374,6 +390,7 @@ begin
       -- MAP USER GENERICS BELOW THIS LINE ---------------
       NUM_REGS                       => NUM_REGS,
       NUM_CHANNELS                   => NUM_CHANNELS,
+      NUM_USER_REGS                  => NUM_USER_REGS,
       -- MAP USER GENERICS ABOVE THIS LINE ---------------
 
       C_NUM_REG                      => USER_NUM_REG,
@@ -391,6 +408,10 @@ begin
       wr_ack                         => wr_ack,
       pulse                          => pulse,
       reset_out                      => reset_out,
+      status_in                      => status_in,
+      user_data                      => user_data,
+      user_wr                        => user_wr,
+      user_rd                        => user_rd,
       -- MAP USER PORTS ABOVE THIS LINE ------------------
 
       Bus2IP_Clk                     => ipif_Bus2IP_Clk,
@@ -42,7 +42,7 @@
 --                    block memory both to Xilinx EDK(R) software and other
 --                    in-fabric hardware
 -- Date Created:      Tue, Dec 17, 2013 15:20:13
--- Last Modified:     Thu, Dec 19, 2013 15:20:28
+-- Last Modified:     Sun, Oct 18, 2026 15:16:02
 -- VHDL Standard:     VHDL'93
 -- Author:            Sean McClain <mcclains@ainfosec.com>,
 --                    Contains code generated by Create and Import Peripheral
@@ -144,6 +144,9 @@ entity user_logic is
     -- Number of clock controlled I/O channels exposed to other hardware
     NUM_CHANNELS                   : integer              := 32;
 
+    -- Number of status words readable through the user space codes
+    NUM_USER_REGS                  : integer              := 26;
+
     -- ADD USER GENERICS ABOVE THIS LINE ---------------
 
     -- DO NOT EDIT BELOW THIS LINE ---------------------
@@ -189,6 +192,19 @@ entity user_logic is
     -- exposed and inverted AXI reset signal
     reset_out     : out   std_logic;
 
+    -- status words from other hardware, readable at codes 6 and up
+    status_in     : in    std_logic_vector (
+        NUM_USER_REGS*C_SLV_DWIDTH-1 downto 0
+        );
+
+    -- software data written at codes 6 and up, with a one clock strobe
+    --  for the user space word it was written to
+    user_data     : out   std_logic_vector(C_SLV_DWIDTH-1 downto 0);
+    user_wr       : out   std_logic_vector(NUM_USER_REGS-1 downto 0);
+
+    -- one clock strobe for the user space word software has just read
+    user_rd       : out   std_logic_vector(NUM_USER_REGS-1 downto 0);
+
     -- ADD USER PORTS ABOVE THIS LINE ------------------
 
     -- DO NOT EDIT BELOW THIS LINE ---------------------
@@ -231,6 +247,9 @@ architecture IMP of user_logic is
   constant CODE_CLEAR       : integer := 4;
   constant CODE_PULSE       : integer := 5;
 
+  -- first of the user space codes, one per status word
+  constant CODE_USER_BASE   : integer := 6;
+
   -- used to synthesize a C_NUM_REG -> log_2(C_NUM_REG) encoder
   type encoder_type is array(C_NUM_REG downto 0)
     of integer;
@@ -262,6 +281,13 @@ architecture IMP of user_logic is
   -- keep the state of the outbound clock
   signal out_clk           : std_logic;
 
+  -- status word selected by the current read code
+  signal user_data_out     : std_logic_vector(C_SLV_DWIDTH-1 downto 0);
+
+  -- read acknowledgement during the last clock, so a read is only
+  --  strobed once however long software holds it
+  signal last_read_ack     : std_logic;
+
 begin
 
   --USER logic implementation added here
@@ -284,9 +310,21 @@ begin
     '0' when '1',
     slv_write_ack(C_NUM_REG) when others;
 
+  -- pick out a status word, unmapped codes read back as 0
+  user_data_out <=
+    status_in (
+        (read_address(C_NUM_REG)-CODE_USER_BASE+1)*C_SLV_DWIDTH-1
+        downto (read_address(C_NUM_REG)-CODE_USER_BASE)*C_SLV_DWIDTH
+        )
+      when read_address(C_NUM_REG) >= CODE_USER_BASE and
+        read_address(C_NUM_REG) < CODE_USER_BASE+NUM_USER_REGS
+    else (others => '0');
+
   -- drive signals outbound to AXI4-Lite(R)
   IP2Bus_Data  <=
-    side_data_out when slv_read_ack(C_NUM_REG) = '1'
+    user_data_out when slv_read_ack(C_NUM_REG) = '1' and
+      read_address(C_NUM_REG) >= CODE_USER_BASE
+    else side_data_out when slv_read_ack(C_NUM_REG) = '1'
     else (others => '0');
   IP2Bus_WrAck <= slv_write_ack(C_NUM_REG);
   IP2Bus_RdAck <= slv_read_ack(C_NUM_REG);
@@ -346,10 +384,16 @@ begin
   -- | 3 | Perform operation |
   -- | 4 | Clear             |
   -- | 5 | Pulse             |
+  -- | 6+| User space        |
   -- +---+-------------------+
   --
   -- "Pulse" turns on an outbound clock
   --
+  -- Reads from the user space return status word (code - 6) from status_in
+  --  and strobe user_rd(code - 6) for one clock once the word has been
+  --  handed to AXI4-Lite(R), writes strobe user_wr(code - 6) for one clock
+  --  with the data on user_data
+  --
   -- Note that AXI4-Lite(R) inputs are clock synced. Data read out to the
   -- AXI4-Lite(R) bus, however, is async and on demand.
   ---
@@ -361,6 +405,19 @@ begin
     CLOCK_SYNC : if ( Bus2IP_Clk'event  and Bus2IP_Clk = '1' )
     then
 
+      -- user space strobes only last a single clock
+      user_wr <= (others => '0');
+      user_rd <= (others => '0');
+
+      -- a user space word has just been read out
+      last_read_ack <= slv_read_ack(C_NUM_REG);
+      if slv_read_ack(C_NUM_REG) = '1' and last_read_ack = '0' and
+        read_address(C_NUM_REG) >= CODE_USER_BASE and
+        read_address(C_NUM_REG) < CODE_USER_BASE+NUM_USER_REGS
+      then
+        user_rd(read_address(C_NUM_REG)-CODE_USER_BASE) <= '1';
+      end if;
+
       -- use the incoming 5-bit address to decide how to handle software data
       case write_address(C_NUM_REG) is
 
@@ -383,9 +440,15 @@ begin
           out_clk <= '1' xor out_clk;
           pulse <= out_clk;
 
-      -- code not accounted for
+      -- software data goes to other hardware through the user space,
+      --  any other code is not accounted for
         when others =>
-          null;
+          if write_address(C_NUM_REG) >= CODE_USER_BASE and
+            write_address(C_NUM_REG) < CODE_USER_BASE+NUM_USER_REGS
+          then
+            user_data <= Bus2IP_Data;
+            user_wr(write_address(C_NUM_REG)-CODE_USER_BASE) <= '1';
+          end if;
 
       end case;
 
@@ -0,0 +1,508 @@
+-- Filename:          dcache.vhd
+-- Version:           1.00.a
+-- Description:       direct-mapped, write-back data cache in front of an
+--                    AXI4 master port
+-- Date Created:      Sun, Oct 18, 2026 12:52:40
+-- Last Modified:     Sun, Oct 18, 2026 21:14:37
+-- VHDL Standard:     VHDL'93
+-- Author:            agent <agent@local>
+-- Copyright:         (c) 2026 Assured Information Security, All Rights Reserved
+
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+
+library simple_processor_v1_00_a;
+use simple_processor_v1_00_a.reg_file_constants.all;
+
+---
+-- Direct-mapped, write-back data cache
+--
+-- Byte, halfword, and word loads and stores are served out of
+--  C_DCACHE_LINES lines of C_DCACHE_LINE_WORDS words each. A miss on a
+--  dirty line first writes the victim back with a single INCR burst, then
+--  refills the line with another burst before the request is replayed.
+--
+-- Requests use a 4-phase handshake: req_rd or req_wr is held high until
+--  resp_ack goes high, and resp_ack stays high until the request drops.
+--  resp_rdata holds the last load's result until the next request.
+--  req_rd and req_wr pass through two flip-flops into M_AXI_ACLK, so the
+--  requester may run on another clock as long as it holds the rest of the
+--  request steady while either is high and synchronizes resp_ack itself.
+--
+-- A SLVERR or DECERR response fails the request: a refused write back
+--  leaves the victim valid and dirty, a refused refill leaves the line
+--  invalid. Either way the request is acknowledged without being served,
+--  a load returns 0, and the errors count goes up.
+---
+entity dcache
+is
+  generic
+  (
+    -- number of cache lines, must be a power of 2
+    C_DCACHE_LINES      : integer          := 256;
+
+    -- number of 32-bit words in a single line, must be a power of 2
+    C_DCACHE_LINE_WORDS : integer          := 4
+  );
+  port
+  (
+    -- byte address of the requested load or store
+    req_addr      : in    std_logic_vector(DATA_WIDTH-1 downto 0);
+
+    -- data to store, right justified for bytes and halfwords
+    req_wdata     : in    std_logic_vector(DATA_WIDTH-1 downto 0);
+
+    -- access width, "00" byte, "01" halfword, "10" word
+    req_size      : in    std_logic_vector(1 downto 0);
+
+    -- sign extend loaded bytes and halfwords
+    req_signed    : in    std_logic;
+
+    -- load or store requested
+    req_rd        : in    std_logic;
+    req_wr        : in    std_logic;
+
+    -- loaded data, zero or sign extended to DATA_WIDTH
+    resp_rdata    : out   std_logic_vector(DATA_WIDTH-1 downto 0);
+
+    -- acknowledge a request has been served
+    resp_ack      : out   std_logic;
+
+    -- running totals of hits, misses, dirty lines written back, and
+    --  bursts the slave answered with an error
+    hits          : out   std_logic_vector(DATA_WIDTH-1 downto 0);
+    misses        : out   std_logic_vector(DATA_WIDTH-1 downto 0);
+    writebacks    : out   std_logic_vector(DATA_WIDTH-1 downto 0);
+    errors        : out   std_logic_vector(DATA_WIDTH-1 downto 0);
+
+    -- AXI4 master, write address channel
+    M_AXI_AWADDR  : out   std_logic_vector(DATA_WIDTH-1 downto 0);
+    M_AXI_AWLEN   : out   std_logic_vector(7 downto 0);
+    M_AXI_AWSIZE  : out   std_logic_vector(2 downto 0);
+    M_AXI_AWBURST : out   std_logic_vector(1 downto 0);
+    M_AXI_AWVALID : out   std_logic;
+    M_AXI_AWREADY : in    std_logic;
+
+    -- AXI4 master, write data channel
+    M_AXI_WDATA   : out   std_logic_vector(DATA_WIDTH-1 downto 0);
+    M_AXI_WSTRB   : out   std_logic_vector(DATA_WIDTH/8-1 downto 0);
+    M_AXI_WLAST   : out   std_logic;
+    M_AXI_WVALID  : out   std_logic;
+    M_AXI_WREADY  : in    std_logic;
+
+    -- AXI4 master, write response channel
+    M_AXI_BRESP   : in    std_logic_vector(1 downto 0);
+    M_AXI_BVALID  : in    std_logic;
+    M_AXI_BREADY  : out   std_logic;
+
+    -- AXI4 master, read address channel
+    M_AXI_ARADDR  : out   std_logic_vector(DATA_WIDTH-1 downto 0);
+    M_AXI_ARLEN   : out   std_logic_vector(7 downto 0);
+    M_AXI_ARSIZE  : out   std_logic_vector(2 downto 0);
+    M_AXI_ARBURST : out   std_logic_vector(1 downto 0);
+    M_AXI_ARVALID : out   std_logic;
+    M_AXI_ARREADY : in    std_logic;
+
+    -- AXI4 master, read data channel
+    M_AXI_RDATA   : in    std_logic_vector(DATA_WIDTH-1 downto 0);
+    M_AXI_RRESP   : in    std_logic_vector(1 downto 0);
+    M_AXI_RLAST   : in    std_logic;
+    M_AXI_RVALID  : in    std_logic;
+    M_AXI_RREADY  : out   std_logic;
+
+    -- AXI clock and active low reset
+    M_AXI_ACLK    : in    std_logic;
+    M_AXI_ARESETN : in    std_logic
+  );
+
+end entity dcache;
+
+architecture IMP of dcache
+is
+
+  -- number of bits needed to index x things
+  function bits_for(x : integer) return integer is
+    variable n : integer;
+  begin
+    n := 0;
+    while 2**n < x
+    loop
+      n := n + 1;
+    end loop;
+    return n;
+  end function bits_for;
+
+  -- byte address breakdown: | tag | line index | word offset | byte |
+  constant OFF_BITS  : integer := bits_for(C_DCACHE_LINE_WORDS);
+  constant IDX_BITS  : integer := bits_for(C_DCACHE_LINES);
+  constant OFF_LOW   : integer := 2;
+  constant IDX_LOW   : integer := OFF_LOW + OFF_BITS;
+  constant TAG_LOW   : integer := IDX_LOW + IDX_BITS;
+  constant TAG_BITS  : integer := DATA_WIDTH - TAG_LOW;
+
+  -- cache controller states
+  constant C_IDLE      : integer := 0;
+  constant C_LOOKUP    : integer := 1;
+  constant C_WB_ADDR   : integer := 2;
+  constant C_WB_DATA   : integer := 3;
+  constant C_WB_RESP   : integer := 4;
+  constant C_FILL_ADDR : integer := 5;
+  constant C_FILL_DATA : integer := 6;
+  constant C_DONE      : integer := 7;
+
+  -- line data, tags, and per-line state bits
+  type data_type is array(0 to C_DCACHE_LINES*C_DCACHE_LINE_WORDS-1)
+    of std_logic_vector(DATA_WIDTH-1 downto 0);
+  type tag_type is array(0 to C_DCACHE_LINES-1)
+    of std_logic_vector(TAG_BITS-1 downto 0);
+  signal data          : data_type;
+  signal tags          : tag_type;
+  signal valid         : std_logic_vector(C_DCACHE_LINES-1 downto 0);
+  signal dirty         : std_logic_vector(C_DCACHE_LINES-1 downto 0);
+
+  -- current controller state
+  signal cs            : integer range C_IDLE to C_DONE;
+
+  -- request strobes, synchronized into M_AXI_ACLK
+  signal rd_meta       : std_logic;
+  signal rd_sync       : std_logic;
+  signal wr_meta       : std_logic;
+  signal wr_sync       : std_logic;
+
+  -- latched request
+  signal addr_l        : std_logic_vector(DATA_WIDTH-1 downto 0);
+  signal wdata_l       : std_logic_vector(DATA_WIDTH-1 downto 0);
+  signal size_l        : std_logic_vector(1 downto 0);
+  signal signed_l      : std_logic;
+  signal write_l       : std_logic;
+
+  -- set after a refill so the replayed lookup is not counted as a hit
+  signal replay        : std_logic;
+
+  -- burst beat counter
+  signal beat          : integer range 0 to C_DCACHE_LINE_WORDS-1;
+
+  -- set once any beat of the current refill came back with an error
+  signal fill_err      : std_logic;
+
+  -- counters
+  signal hits_cnt      : unsigned(DATA_WIDTH-1 downto 0);
+  signal misses_cnt    : unsigned(DATA_WIDTH-1 downto 0);
+  signal wbacks_cnt    : unsigned(DATA_WIDTH-1 downto 0);
+  signal errors_cnt    : unsigned(DATA_WIDTH-1 downto 0);
+
+  -- pull a byte or halfword out of a little endian word and extend it
+  function extract(
+      word : std_logic_vector(DATA_WIDTH-1 downto 0);
+      lo   : std_logic_vector(1 downto 0);
+      size : std_logic_vector(1 downto 0);
+      sgn  : std_logic
+      ) return std_logic_vector is
+    variable part : std_logic_vector(15 downto 0);
+    variable ret  : std_logic_vector(DATA_WIDTH-1 downto 0);
+  begin
+    case size
+    is
+      when "00" =>
+        case lo
+        is
+          when "00"   => part(7 downto 0) := word(7  downto 0);
+          when "01"   => part(7 downto 0) := word(15 downto 8);
+          when "10"   => part(7 downto 0) := word(23 downto 16);
+          when others => part(7 downto 0) := word(31 downto 24);
+        end case;
+        ret(7 downto 0) := part(7 downto 0);
+        ret(DATA_WIDTH-1 downto 8) := (others => sgn and part(7));
+      when "01" =>
+        if lo(1) = '0'
+        then
+          part := word(15 downto 0);
+        else
+          part := word(31 downto 16);
+        end if;
+        ret(15 downto 0) := part;
+        ret(DATA_WIDTH-1 downto 16) := (others => sgn and part(15));
+      when others =>
+        ret := word;
+    end case;
+    return ret;
+  end function extract;
+
+  -- merge a byte, halfword, or word into a little endian word
+  function merge(
+      word  : std_logic_vector(DATA_WIDTH-1 downto 0);
+      wdata : std_logic_vector(DATA_WIDTH-1 downto 0);
+      lo    : std_logic_vector(1 downto 0);
+      size  : std_logic_vector(1 downto 0)
+      ) return std_logic_vector is
+    variable ret : std_logic_vector(DATA_WIDTH-1 downto 0);
+  begin
+    ret := word;
+    case size
+    is
+      when "00" =>
+        case lo
+        is
+          when "00"   => ret(7  downto 0)  := wdata(7 downto 0);
+          when "01"   => ret(15 downto 8)  := wdata(7 downto 0);
+          when "10"   => ret(23 downto 16) := wdata(7 downto 0);
+          when others => ret(31 downto 24) := wdata(7 downto 0);
+        end case;
+      when "01" =>
+        if lo(1) = '0'
+        then
+          ret(15 downto 0)  := wdata(15 downto 0);
+        else
+          ret(31 downto 16) := wdata(15 downto 0);
+        end if;
+      when others =>
+        ret := wdata;
+    end case;
+    return ret;
+  end function merge;
+
+begin
+
+  -- fixed burst shape: full width INCR bursts of exactly one line
+  M_AXI_AWLEN   <= std_logic_vector(to_unsigned(C_DCACHE_LINE_WORDS-1, 8));
+  M_AXI_ARLEN   <= std_logic_vector(to_unsigned(C_DCACHE_LINE_WORDS-1, 8));
+  M_AXI_AWSIZE  <= "010";
+  M_AXI_ARSIZE  <= "010";
+  M_AXI_AWBURST <= "01";
+  M_AXI_ARBURST <= "01";
+  M_AXI_WSTRB   <= (others => '1');
+
+  -- send counters out
+  hits       <= std_logic_vector(hits_cnt);
+  misses     <= std_logic_vector(misses_cnt);
+  writebacks <= std_logic_vector(wbacks_cnt);
+  errors     <= std_logic_vector(errors_cnt);
+
+  ---
+  -- Look up, write back, and refill lines
+  ---
+  DO_UPDATE : process ( M_AXI_ACLK )
+  is
+    variable idx  : integer range 0 to C_DCACHE_LINES-1;
+    variable off  : integer range 0 to C_DCACHE_LINE_WORDS-1;
+    variable tag  : std_logic_vector(TAG_BITS-1 downto 0);
+    variable slot : integer range 0 to C_DCACHE_LINES*C_DCACHE_LINE_WORDS-1;
+    variable base : std_logic_vector(DATA_WIDTH-1 downto 0);
+  begin
+
+    CLOCK_SYNC : if M_AXI_ACLK'event and M_AXI_ACLK = '1'
+    then
+
+      -- bring the request strobes into this clock domain
+      rd_meta <= req_rd;
+      rd_sync <= rd_meta;
+      wr_meta <= req_wr;
+      wr_sync <= wr_meta;
+
+      -- break the latched address down
+      idx := to_integer(unsigned(addr_l(TAG_LOW-1 downto IDX_LOW)));
+      if OFF_BITS > 0
+      then
+        off := to_integer(unsigned(addr_l(IDX_LOW-1 downto OFF_LOW)));
+      else
+        off := 0;
+      end if;
+      tag  := addr_l(DATA_WIDTH-1 downto TAG_LOW);
+      slot := idx*C_DCACHE_LINE_WORDS + off;
+
+      -- reset requested, invalidate everything
+      if M_AXI_ARESETN = '0'
+      then
+        valid         <= (others => '0');
+        dirty         <= (others => '0');
+        hits_cnt      <= (others => '0');
+        misses_cnt    <= (others => '0');
+        wbacks_cnt    <= (others => '0');
+        errors_cnt    <= (others => '0');
+        resp_ack      <= '0';
+        replay        <= '0';
+        M_AXI_AWVALID <= '0';
+        M_AXI_WVALID  <= '0';
+        M_AXI_WLAST   <= '0';
+        M_AXI_BREADY  <= '0';
+        M_AXI_ARVALID <= '0';
+        M_AXI_RREADY  <= '0';
+        cs            <= C_IDLE;
+
+      else
+        case cs
+        is
+
+          -- wait for and latch a new request
+          when C_IDLE =>
+            if rd_sync = '1' or wr_sync = '1'
+            then
+              addr_l   <= req_addr;
+              wdata_l  <= req_wdata;
+              size_l   <= req_size;
+              signed_l <= req_signed;
+              write_l  <= wr_sync;
+              replay   <= '0';
+              cs       <= C_LOOKUP;
+            end if;
+
+          -- serve a hit, or start replacing the line
+          when C_LOOKUP =>
+            if valid(idx) = '1' and tags(idx) = tag
+            then
+              if replay = '0'
+              then
+                hits_cnt <= hits_cnt + 1;
+              end if;
+              if write_l = '1'
+              then
+                data(slot) <= merge(data(slot), wdata_l, addr_l(1 downto 0),
+                    size_l);
+                dirty(idx) <= '1';
+              else
+                resp_rdata <= extract(data(slot), addr_l(1 downto 0),
+                    size_l, signed_l);
+              end if;
+              cs <= C_DONE;
+
+            else
+              misses_cnt <= misses_cnt + 1;
+              beat       <= 0;
+              fill_err   <= '0';
+
+              -- dirty victim, write it back first
+              if valid(idx) = '1' and dirty(idx) = '1'
+              then
+                base := (others => '0');
+                base(DATA_WIDTH-1 downto TAG_LOW)  := tags(idx);
+                base(TAG_LOW-1 downto IDX_LOW)     :=
+                  addr_l(TAG_LOW-1 downto IDX_LOW);
+                M_AXI_AWADDR  <= base;
+                M_AXI_AWVALID <= '1';
+                cs            <= C_WB_ADDR;
+
+              -- clean victim, refill right away
+              else
+                base := (others => '0');
+                base(DATA_WIDTH-1 downto IDX_LOW) :=
+                  addr_l(DATA_WIDTH-1 downto IDX_LOW);
+                M_AXI_ARADDR  <= base;
+                M_AXI_ARVALID <= '1';
+                cs            <= C_FILL_ADDR;
+              end if;
+            end if;
+
+          -- write back address accepted, start sending the line
+          when C_WB_ADDR =>
+            if M_AXI_AWREADY = '1'
+            then
+              M_AXI_AWVALID <= '0';
+              M_AXI_WDATA   <= data(idx*C_DCACHE_LINE_WORDS);
+              M_AXI_WVALID  <= '1';
+              if C_DCACHE_LINE_WORDS = 1
+              then
+                M_AXI_WLAST <= '1';
+              else
+                M_AXI_WLAST <= '0';
+              end if;
+              cs <= C_WB_DATA;
+            end if;
+
+          -- send one beat per accepted transfer
+          when C_WB_DATA =>
+            if M_AXI_WREADY = '1'
+            then
+              if beat = C_DCACHE_LINE_WORDS-1
+              then
+                M_AXI_WVALID <= '0';
+                M_AXI_WLAST  <= '0';
+                M_AXI_BREADY <= '1';
+                cs           <= C_WB_RESP;
+              else
+                M_AXI_WDATA <= data(idx*C_DCACHE_LINE_WORDS + beat + 1);
+                if beat + 1 = C_DCACHE_LINE_WORDS-1
+                then
+                  M_AXI_WLAST <= '1';
+                end if;
+                beat <= beat + 1;
+              end if;
+            end if;
+
+          -- line written back, refill it
+          when C_WB_RESP =>
+            if M_AXI_BVALID = '1' and M_AXI_BRESP(1) = '1'
+            then
+              M_AXI_BREADY  <= '0';
+              errors_cnt    <= errors_cnt + 1;
+              resp_rdata    <= (others => '0');
+              cs            <= C_DONE;
+            elsif M_AXI_BVALID = '1'
+            then
+              M_AXI_BREADY  <= '0';
+              wbacks_cnt    <= wbacks_cnt + 1;
+              dirty(idx)    <= '0';
+              beat          <= 0;
+              base := (others => '0');
+              base(DATA_WIDTH-1 downto IDX_LOW) :=
+                addr_l(DATA_WIDTH-1 downto IDX_LOW);
+              M_AXI_ARADDR  <= base;
+              M_AXI_ARVALID <= '1';
+              cs            <= C_FILL_ADDR;
+            end if;
+
+          -- refill address accepted, start taking in the line
+          when C_FILL_ADDR =>
+            if M_AXI_ARREADY = '1'
+            then
+              M_AXI_ARVALID <= '0';
+              M_AXI_RREADY  <= '1';
+              cs            <= C_FILL_DATA;
+            end if;
+
+          -- store one beat per transfer, replay the request when done
+          --  or give it up if any beat failed
+          when C_FILL_DATA =>
+            if M_AXI_RVALID = '1'
+            then
+              data(idx*C_DCACHE_LINE_WORDS + beat) <= M_AXI_RDATA;
+              if M_AXI_RLAST = '1' or beat = C_DCACHE_LINE_WORDS-1
+              then
+                M_AXI_RREADY <= '0';
+                dirty(idx)   <= '0';
+                tags(idx)    <= tag;
+                if fill_err = '1' or M_AXI_RRESP(1) = '1'
+                then
+                  valid(idx) <= '0';
+                  errors_cnt <= errors_cnt + 1;
+                  resp_rdata <= (others => '0');
+                  cs         <= C_DONE;
+                else
+                  valid(idx) <= '1';
+                  replay     <= '1';
+                  cs         <= C_LOOKUP;
+                end if;
+              else
+                fill_err <= fill_err or M_AXI_RRESP(1);
+                beat <= beat + 1;
+              end if;
+            end if;
+
+          -- hold the acknowledgement until the request is dropped
+          when others =>
+            if rd_sync = '0' and wr_sync = '0'
+            then
+              resp_ack <= '0';
+              cs       <= C_IDLE;
+            else
+              resp_ack <= '1';
+            end if;
+
+        end case;
+      end if;
+
+    end if CLOCK_SYNC;
+
+  end process DO_UPDATE;
+
+end IMP;
@@ -2,7 +2,7 @@
 -- Version:           1.00.a
 -- Description:       takes a binary function and turns it into fetched data
 -- Date Created:      Wed, Nov 13, 2013 20:59:21
--- Last Modified:     Tue, Dec 24, 2013 16:19:37
+-- Last Modified:     Sun, Oct 18, 2026 16:02:11
 -- VHDL Standard:     VHDL'93
 -- Author:            Sean McClain <mcclains@ainfosec.com>
 -- Copyright:         (c) 2013 Assured Information Security, All Rights Reserved
@@ -22,9 +22,30 @@ use simple_processor_v1_00_a.reg_file_constants.all;
 ---
 -- Converts a 16 bit ARM Thumb instruction in binary format into
 --  an opcode and a series of arguments.
+--
+-- With C_USE_ISR = 1, bits 15-6 of the instruction first go through a
+--  table undoing the instruction set randomization permutation software
+--  encoded the program with, in the same DO_DECODE state. Software loads
+--  the table a word at a time:
+--
+-- +-------+---------+------------------------------------------------+
+-- | Bits  | Name    | Contents                                       |
+-- +-------+---------+------------------------------------------------+
+-- | 9-0   | PLAIN   | bits 15-6 as they were before randomization    |
+-- | 25-16 | LOADED  | bits 15-6 as loaded, the table entry to write  |
+-- | 31    | ENABLE  | decode through the table from the next decode  |
+-- +-------+---------+------------------------------------------------+
+--
+-- so the table is off while it is loaded and goes on with the last write.
+--  Reading the status word returns ENABLE in bit 0.
 ---
 entity decoder
 is
+  generic
+  (
+    -- 1 to undo instruction set randomization
+    C_USE_ISR  : integer          := 0
+  );
   port
   (
     -- 16 bit binary instruction
@@ -74,7 +95,17 @@ is
     decode_ack : out   std_logic;
 
     -- lets us know when to trigger a decode event
-    state      : in    integer range STATE_MIN to STATE_MAX
+    state      : in    integer range STATE_MIN to STATE_MAX;
+
+    -- randomization table word written by software, its one clock strobe,
+    --  and the status word
+    isr_data   : in    std_logic_vector(DATA_WIDTH-1 downto 0);
+    isr_wr     : in    std_logic;
+    isr_status : out   std_logic_vector(DATA_WIDTH-1 downto 0);
+
+    -- clock and active high reset for loading the randomization table
+    Clk        : in    std_logic;
+    Reset      : in    std_logic
   );
 
 end entity decoder;
@@ -82,21 +113,81 @@ end entity decoder;
 architecture IMP of decoder
 is
 
+  -- plain bits 15-6 of every value of bits 15-6 as loaded
+  type isr_table_type is array(0 to 1023) of std_logic_vector(9 downto 0);
+
+  -- the table starts out as the identity
+  function isr_identity return isr_table_type
+  is
+    variable table : isr_table_type;
+  begin
+    for i in table'range
+    loop
+      table(i) := std_logic_vector(to_unsigned(i, 10));
+    end loop;
+    return table;
+  end function isr_identity;
+
+  signal isr_table : isr_table_type := isr_identity;
+  signal isr_on    : std_logic;
+
+  -- the instruction as it was before randomization
+  signal plain     : std_logic_vector(15 downto 0);
+
 begin
+
+  ---
+  -- Instruction set randomization table, loaded by software
+  ---
+  ISR_GEN : if C_USE_ISR = 1
+  generate
+
+    ISR_LOAD : process ( Clk )
+    is
+    begin
+      if rising_edge(Clk)
+      then
+        if Reset = '1'
+        then
+          isr_on <= '0';
+        elsif isr_wr = '1'
+        then
+          isr_table(to_integer(unsigned(isr_data(25 downto 16)))) <=
+            isr_data(9 downto 0);
+          isr_on <= isr_data(31);
+        end if;
+      end if;
+    end process ISR_LOAD;
+
+    plain <= isr_table(to_integer(unsigned(data(15 downto 6))))
+        & data(5 downto 0)
+      when isr_on = '1'
+      else data;
+
+  end generate ISR_GEN;
+
+  NO_ISR_GEN : if C_USE_ISR /= 1
+  generate
+    isr_on <= '0';
+    plain  <= data;
+  end generate NO_ISR_GEN;
+
+  isr_status <= (0 => isr_on, others => '0');
+
   -- decode condition
   DECODE_CONDITION: for i in 15 downto 0 generate
     condition(i) <= '1'
-      when  data(11 downto 8) = std_logic_vector(to_unsigned(i, 4))
+      when  plain(11 downto 8) = std_logic_vector(to_unsigned(i, 4))
       else '0';
   end generate DECODE_CONDITION;
 
   -- pull out immediate values and flags
-  Imm_3      <= data(8 downto 6);
-  Imm_5      <= data(10 downto 6);
-  Imm_8      <= data(7 downto 0);
-  Imm_11     <= data(10 downto 0);
-  flag_lr_pc <= data(8);
-  flags_h    <= data(7 downto 6);
+  Imm_3      <= plain(8 downto 6);
+  Imm_5      <= plain(10 downto 6);
+  Imm_8      <= plain(7 downto 0);
+  Imm_11     <= plain(10 downto 0);
+  flag_lr_pc <= plain(8);
+  flags_h    <= plain(7 downto 6);
 
   -- decode data and opcodes
   DATA_DECODER : process ( state )
@@ -123,15 +214,15 @@ begin
 
       -- filter out unused and unpredictable opcodes
       if   unclean = '1'
-        or data(15 downto 6) = "0100010000"
-        or data(15 downto 6) = "0100010100"
-        or data(15 downto 6) = "0100011000"
-        or (data(15 downto 8) = "01000111" and data(2) = '1')
-        or data(15 downto 8) = "10110001"
-        or (data(15 downto 11) = "10110" and data(9) = '1')
-        or data(15 downto 10) = "101110"
-        or data(15 downto 8) = "10111111"
-        or data(15 downto 8) = "11011110"
+        or plain(15 downto 6) = "0100010000"
+        or plain(15 downto 6) = "0100010100"
+        or plain(15 downto 6) = "0100011000"
+        or (plain(15 downto 8) = "01000111" and plain(2) = '1')
+        or plain(15 downto 8) = "10110001"
+        or (plain(15 downto 11) = "10110" and plain(9) = '1')
+        or plain(15 downto 10) = "101110"
+        or plain(15 downto 8) = "10111111"
+        or plain(15 downto 8) = "11011110"
       then
         opcode  <= UNUSED;
         Rm_l := (others => '0');
@@ -141,14 +232,14 @@ begin
 
       -- valid opcode, go ahead and decode
       else
-        case data(15 downto 13)
+        case plain(15 downto 13)
         is
 
           -- 000CCIIIIIMMMDDD LSL, LSR, ASR
           -- 00011CCMMMNNNDDD ADD, SUB
           -- 00011CCIIINNNDDD ADD, SUB
           when "000"  =>
-            case data(12 downto 11)
+            case plain(12 downto 11)
             is
 
               -- 000CCIIIIIMMMDDD LSL, LSR, ASR
@@ -156,31 +247,31 @@ begin
               -- LSL
               when "00"   =>
                 opcode  <= LSL_Rd_Rm_I;
-                Rm_l := data(5 downto 3);
+                Rm_l := plain(5 downto 3);
                 Rn_l := (others => '0');
                 Rs_l := (others => '0');
-                Rd_l := data(2 downto 0);
+                Rd_l := plain(2 downto 0);
 
               -- LSR
               when "01"   =>
                 opcode  <= LSR_Rd_Rm_I;
-                Rm_l := data(5 downto 3);
+                Rm_l := plain(5 downto 3);
                 Rn_l := (others => '0');
                 Rs_l := (others => '0');
-                Rd_l := data(2 downto 0);
+                Rd_l := plain(2 downto 0);
 
               -- ASR
               when "10"   =>
                 opcode  <= ASR_Rd_Rm_I;
-                Rm_l := data(5 downto 3);
+                Rm_l := plain(5 downto 3);
                 Rn_l := (others => '0');
                 Rs_l := (others => '0');
-                Rd_l := data(2 downto 0);
+                Rd_l := plain(2 downto 0);
 
               -- 00011CCMMMNNNDDD ADD, SUB
               -- 00011CCIIINNNDDD ADD, SUB
               when others =>
-                case data(10 downto 9)
+                case plain(10 downto 9)
                 is
 
                   -- 00011CCMMMNNNDDD ADD, SUB
@@ -188,18 +279,18 @@ begin
                   -- ADD
                   when "00"   =>
                     opcode  <= ADD_Rd_Rm_Rn;
-                    Rm_l := data(8 downto 6);
-                    Rn_l := data(5 downto 3);
+                    Rm_l := plain(8 downto 6);
+                    Rn_l := plain(5 downto 3);
                     Rs_l := (others => '0');
-                    Rd_l := data(2 downto 0);
+                    Rd_l := plain(2 downto 0);
 
                   -- SUB
                   when "01"   =>
                     opcode  <= SUB_Rd_Rm_Rn;
-                    Rm_l := data(8 downto 6);
-                    Rn_l := data(5 downto 3);
+                    Rm_l := plain(8 downto 6);
+                    Rn_l := plain(5 downto 3);
                     Rs_l := (others => '0');
-                    Rd_l := data(2 downto 0);
+                    Rd_l := plain(2 downto 0);
 
                   -- 00011CCIIINNNDDD ADD, SUB
 
@@ -207,17 +298,17 @@ begin
                   when "10"   =>
                     opcode  <= ADD_Rd_Rn_I;
                     Rm_l := (others => '0');
-                    Rn_l := data(5 downto 3);
+                    Rn_l := plain(5 downto 3);
                     Rs_l := (others => '0');
-                    Rd_l := data(2 downto 0);
+                    Rd_l := plain(2 downto 0);
 
                   -- SUB
                   when others =>
                     opcode  <= SUB_Rd_Rn_I;
                     Rm_l := (others => '0');
-                    Rn_l := data(5 downto 3);
+                    Rn_l := plain(5 downto 3);
                     Rs_l := (others => '0');
-                    Rd_l := data(2 downto 0);
+                    Rd_l := plain(2 downto 0);
 
                 end case;
             end case;
@@ -225,7 +316,7 @@ begin
           -- 001CCDDDIIIIIIII MOV, ADD, SUB
           -- 001CCNNNIIIIIIII CMP
           when "001"  =>
-            case data(12 downto 11)
+            case plain(12 downto 11)
             is
 
               -- 001CCDDDIIIIIIII MOV
@@ -236,7 +327,7 @@ begin
                 Rm_l := (others => '0');
                 Rn_l := (others => '0');
                 Rs_l := (others => '0');
-                Rd_l := data(10 downto 8);
+                Rd_l := plain(10 downto 8);
 
               -- 001CCNNNIIIIIIII CMP
 
@@ -244,7 +335,7 @@ begin
               when "01"   =>
                 opcode  <= CMP_Rn_I;
                 Rm_l := (others => '0');
-                Rn_l := data(10 downto 8);
+                Rn_l := plain(10 downto 8);
                 Rs_l := (others => '0');
                 Rd_l := (others => '0');
 
@@ -256,7 +347,7 @@ begin
                 Rm_l := (others => '0');
                 Rn_l := (others => '0');
                 Rs_l := (others => '0');
-                Rd_l := data(10 downto 8);
+                Rd_l := plain(10 downto 8);
 
               -- SUB
               when others =>
@@ -264,7 +355,7 @@ begin
                 Rm_l := (others => '0');
                 Rn_l := (others => '0');
                 Rs_l := (others => '0');
-                Rd_l := data(10 downto 8);
+                Rd_l := plain(10 downto 8);
 
             end case;
 
@@ -277,7 +368,7 @@ begin
           -- 01001DDDIIIIIIII LDR
           -- 0101CCCMMMNNNDDD STR, STRH, STRB, LDRSB, LDR, LDRH, LDRB, LDRSH
           when "010"  =>
-            case data(12 downto 10)
+            case plain(12 downto 10)
             is
 
               -- 010000000CMMMDDD AND, EOR
@@ -291,7 +382,7 @@ begin
               -- 0100001110NNNMMM BIC
               -- 0100001111MMMDDD MVN
               when "000" =>
-                case data(9 downto 6)
+                case plain(9 downto 6)
                 is
 
                   -- 010000000CMMMDDD AND, EOR
@@ -299,18 +390,18 @@ begin
                   -- AND
                   when "0000" =>
                     opcode  <= AND_Rd_Rm;
-                    Rm_l := data(5 downto 3);
+                    Rm_l := plain(5 downto 3);
                     Rn_l := (others => '0');
                     Rs_l := (others => '0');
-                    Rd_l := data(2 downto 0);
+                    Rd_l := plain(2 downto 0);
 
                   -- EOR
                   when "0001" =>
                     opcode  <= EOR_Rd_Rm;
-                    Rm_l := data(5 downto 3);
+                    Rm_l := plain(5 downto 3);
                     Rn_l := (others => '0');
                     Rs_l := (others => '0');
-                    Rd_l := data(2 downto 0);
+                    Rd_l := plain(2 downto 0);
 
                   -- 0100000CCCSSSDDD LSL, LSR, ASR
 
@@ -319,42 +410,42 @@ begin
                     opcode  <= LSL_Rd_Rs;
                     Rm_l := (others => '0');
                     Rn_l := (others => '0');
-                    Rs_l := data(5 downto 3);
-                    Rd_l := data(2 downto 0);
+                    Rs_l := plain(5 downto 3);
+                    Rd_l := plain(2 downto 0);
 
                   -- LSR
                   when "0011" =>
                     opcode  <= LSR_Rd_Rs;
                     Rm_l := (others => '0');
                     Rn_l := (others => '0');
-                    Rs_l := data(5 downto 3);
-                    Rd_l := data(2 downto 0);
+                    Rs_l := plain(5 downto 3);
+                    Rd_l := plain(2 downto 0);
 
                   -- ASR
                   when "0100" =>
                     opcode  <= ASR_Rd_Rs;
                     Rm_l := (others => '0');
                     Rn_l := (others => '0');
-                    Rs_l := data(5 downto 3);
-                    Rd_l := data(2 downto 0);
+                    Rs_l := plain(5 downto 3);
+                    Rd_l := plain(2 downto 0);
 
                   -- 010000CCCCMMMDDD ADC, SBC
 
                   -- ADC
                   when "0101" =>
                     opcode  <= ADC_Rd_Rm;
-                    Rm_l := data(5 downto 3);
+                    Rm_l := plain(5 downto 3);
                     Rn_l := (others => '0');
                     Rs_l := (others => '0');
-                    Rd_l := data(2 downto 0);
+                    Rd_l := plain(2 downto 0);
 
                   -- SBC
                   when "0110" =>
                     opcode  <= SBC_Rd_Rm;
-                    Rm_l := data(5 downto 3);
+                    Rm_l := plain(5 downto 3);
                     Rn_l := (others => '0');
                     Rs_l := (others => '0');
-                    Rd_l := data(2 downto 0);
+                    Rd_l := plain(2 downto 0);
 
                   -- 0100000111SSSDDD ROR
 
@@ -363,16 +454,16 @@ begin
                     opcode  <= ROR_Rd_Rs;
                     Rm_l := (others => '0');
                     Rn_l := (others => '0');
-                    Rs_l := data(5 downto 3);
-                    Rd_l := data(2 downto 0);
+                    Rs_l := plain(5 downto 3);
+                    Rd_l := plain(2 downto 0);
 
                   -- 0100001000NNNMMM TST
 
                   -- TST
                   when "1000" =>
                     opcode  <= TST_Rm_Rn;
-                    Rm_l := data(2 downto 0);
-                    Rn_l := data(5 downto 3);
+                    Rm_l := plain(2 downto 0);
+                    Rn_l := plain(5 downto 3);
                     Rs_l := (others => '0');
                     Rd_l := (others => '0');
 
@@ -381,26 +472,26 @@ begin
                   -- NEG
                   when "1001" =>
                     opcode  <= NEG_Rd_Rm;
-                    Rm_l := data(5 downto 3);
+                    Rm_l := plain(5 downto 3);
                     Rn_l := (others => '0');
                     Rs_l := (others => '0');
-                    Rd_l := data(2 downto 0);
+                    Rd_l := plain(2 downto 0);
 
                   -- 010000101CNNNMMM CMP, CMN
 
                   -- CMP
                   when "1010" =>
                     opcode  <= CMP_Rm_Rn;
-                    Rm_l := data(2 downto 0);
-                    Rn_l := data(5 downto 3);
+                    Rm_l := plain(2 downto 0);
+                    Rn_l := plain(5 downto 3);
                     Rs_l := (others => '0');
                     Rd_l := (others => '0');
 
                   -- CMN
                   when "1011" =>
                     opcode  <= CMN_Rm_Rn;
-                    Rm_l := data(2 downto 0);
-                    Rn_l := data(5 downto 3);
+                    Rm_l := plain(2 downto 0);
+                    Rn_l := plain(5 downto 3);
                     Rs_l := (others => '0');
                     Rd_l := (others => '0');
 
@@ -409,26 +500,26 @@ begin
                   -- ORR
                   when "1100" =>
                     opcode  <= ORR_Rd_Rm;
-                    Rm_l := data(5 downto 3);
+                    Rm_l := plain(5 downto 3);
                     Rn_l := (others => '0');
                     Rs_l := (others => '0');
-                    Rd_l := data(2 downto 0);
+                    Rd_l := plain(2 downto 0);
 
                   -- MUL
                   when "1101" =>
                     opcode  <= MUL_Rd_Rm;
-                    Rm_l := data(5 downto 3);
+                    Rm_l := plain(5 downto 3);
                     Rn_l := (others => '0');
                     Rs_l := (others => '0');
-                    Rd_l := data(2 downto 0);
+                    Rd_l := plain(2 downto 0);
 
                   -- 0100001110NNNMMM BIC
 
                   -- BIC
                   when "1110" =>
                     opcode  <= BIC_Rm_Rn;
-                    Rm_l := data(2 downto 0);
-                    Rn_l := data(5 downto 3);
+                    Rm_l := plain(2 downto 0);
+                    Rn_l := plain(5 downto 3);
                     Rs_l := (others => '0');
                     Rd_l := (others => '0');
 
@@ -437,10 +528,10 @@ begin
                   -- MVN
                   when others =>
                     opcode  <= MVN_Rd_Rm;
-                    Rm_l := data(5 downto 3);
+                    Rm_l := plain(5 downto 3);
                     Rn_l := (others => '0');
                     Rs_l := (others => '0');
-                    Rd_l := data(2 downto 0);
+                    Rd_l := plain(2 downto 0);
 
                 end case;
 
@@ -448,7 +539,7 @@ begin
               -- 01000101HHNNNDDD CMP
               -- 01000110HHMMMDDD MOV
               when "001" =>
-                case data(9 downto 8)
+                case plain(9 downto 8)
                 is
 
                   -- 01000100HHMMMDDD ADD
@@ -456,18 +547,18 @@ begin
                   -- ADD
                   when "00"   =>
                     opcode  <= ADD_Rd_Rm;
-                    Rm_l := data(5 downto 3);
+                    Rm_l := plain(5 downto 3);
                     Rn_l := (others => '0');
                     Rs_l := (others => '0');
-                    Rd_l := data(2 downto 0);
+                    Rd_l := plain(2 downto 0);
 
                   -- 01000101HHNNNDDD CMP
 
                   -- CMP
                   when "01"   =>
                     opcode  <= CMP_Rm_Rn_2;
-                    Rm_l := data(2 downto 0);
-                    Rn_l := data(5 downto 3);
+                    Rm_l := plain(2 downto 0);
+                    Rn_l := plain(5 downto 3);
                     Rs_l := (others => '0');
                     Rd_l := (others => '0');
 
@@ -476,14 +567,14 @@ begin
                   -- MOV
                   when "10"   =>
                     opcode  <= MOV_Rd_Rm;
-                    Rm_l := data(5 downto 3);
+                    Rm_l := plain(5 downto 3);
                     Rn_l := (others => '0');
                     Rs_l := (others => '0');
-                    Rd_l := data(2 downto 0);
+                    Rd_l := plain(2 downto 0);
 
                   -- 01000111CHMMM000 BX, BLX
                   when others =>
-                    case data(7)
+                    case plain(7)
                     is
 
                       -- 01000111CHMMM000 BX, BLX
@@ -491,7 +582,7 @@ begin
                       -- BX
                       when '0' =>
                         opcode  <= BX_Rm;
-                        Rm_l := data(5 downto 3);
+                        Rm_l := plain(5 downto 3);
                         Rn_l := (others => '0');
                         Rs_l := (others => '0');
                         Rd_l := (others => '0');
@@ -499,7 +590,7 @@ begin
                       -- BLX
                       when others =>
                         opcode  <= BLX_Rm;
-                        Rm_l := data(5 downto 3);
+                        Rm_l := plain(5 downto 3);
                         Rn_l := (others => '0');
                         Rs_l := (others => '0');
                         Rd_l := (others => '0');
@@ -515,7 +606,7 @@ begin
                 Rm_l := (others => '0');
                 Rn_l := (others => '0');
                 Rs_l := (others => '0');
-                Rd_l := data(10 downto 8);
+                Rd_l := plain(10 downto 8);
 
               -- LDR (again, HDL has no flow-through in case statements)
               when "011" =>
@@ -523,76 +614,76 @@ begin
                 Rm_l := (others => '0');
                 Rn_l := (others => '0');
                 Rs_l := (others => '0');
-                Rd_l := data(10 downto 8);
+                Rd_l := plain(10 downto 8);
 
               -- 0101CCCMMMNNNDDD STR, STRH, STRB, LDRSB, LDR, LDRH, LDRB, LDRSH
               when others =>
-                case data(11 downto 9)
+                case plain(11 downto 9)
                 is
 
                   -- STR
                   when "000"  =>
                     opcode  <= STR_Rd_Rm_Rn;
-                    Rm_l := data(8 downto 6);
-                    Rn_l := data(5 downto 3);
+                    Rm_l := plain(8 downto 6);
+                    Rn_l := plain(5 downto 3);
                     Rs_l := (others => '0');
-                    Rd_l := data(2 downto 0);
+                    Rd_l := plain(2 downto 0);
 
                   -- STRH
                   when "001"  =>
                     opcode  <= STRH_Rd_Rm_Rn;
-                    Rm_l := data(8 downto 6);
-                    Rn_l := data(5 downto 3);
+                    Rm_l := plain(8 downto 6);
+                    Rn_l := plain(5 downto 3);
                     Rs_l := (others => '0');
-                    Rd_l := data(2 downto 0);
+                    Rd_l := plain(2 downto 0);
 
                   -- STRB
                   when "010"  =>
                     opcode  <= STRB_Rd_Rm_Rn;
-                    Rm_l := data(8 downto 6);
-                    Rn_l := data(5 downto 3);
+                    Rm_l := plain(8 downto 6);
+                    Rn_l := plain(5 downto 3);
                     Rs_l := (others => '0');
-                    Rd_l := data(2 downto 0);
+                    Rd_l := plain(2 downto 0);
 
                   -- LDRSB
                   when "011"  =>
                     opcode  <= LDRSB_Rd_Rm_Rn;
-                    Rm_l := data(8 downto 6);
-                    Rn_l := data(5 downto 3);
+                    Rm_l := plain(8 downto 6);
+                    Rn_l := plain(5 downto 3);
                     Rs_l := (others => '0');
-                    Rd_l := data(2 downto 0);
+                    Rd_l := plain(2 downto 0);
 
                   -- LDR
                   when "100"  =>
                     opcode  <= LDR_Rd_Rm_Rn;
-                    Rm_l := data(8 downto 6);
-                    Rn_l := data(5 downto 3);
+                    Rm_l := plain(8 downto 6);
+                    Rn_l := plain(5 downto 3);
                     Rs_l := (others => '0');
-                    Rd_l := data(2 downto 0);
+                    Rd_l := plain(2 downto 0);
 
                   -- LDRH
                   when "101"  =>
                     opcode  <= LDRH_Rd_Rm_Rn;
-                    Rm_l := data(8 downto 6);
-                    Rn_l := data(5 downto 3);
+                    Rm_l := plain(8 downto 6);
+                    Rn_l := plain(5 downto 3);
                     Rs_l := (others => '0');
-                    Rd_l := data(2 downto 0);
+                    Rd_l := plain(2 downto 0);
 
                   -- LDRB
                   when "110"  =>
                     opcode  <= LDRB_Rd_Rm_Rn;
-                    Rm_l := data(8 downto 6);
-                    Rn_l := data(5 downto 3);
+                    Rm_l := plain(8 downto 6);
+                    Rn_l := plain(5 downto 3);
                     Rs_l := (others => '0');
-                    Rd_l := data(2 downto 0);
+                    Rd_l := plain(2 downto 0);
 
                   -- LDRSH
                   when others =>
                     opcode  <= LDRSH_Rd_Rm_Rn;
-                    Rm_l := data(8 downto 6);
-                    Rn_l := data(5 downto 3);
+                    Rm_l := plain(8 downto 6);
+                    Rn_l := plain(5 downto 3);
                     Rs_l := (others => '0');
-                    Rd_l := data(2 downto 0);
+                    Rd_l := plain(2 downto 0);
 
                 end case;
 
@@ -600,46 +691,46 @@ begin
 
           -- 011CCIIIIINNNDDD STR, LDR, STRB, LDRB
           when "011"  =>
-            case data(12 downto 11)
+            case plain(12 downto 11)
             is
 
               -- STR
               when "00"   =>
                 opcode  <= STR_Rd_Rn_I;
                 Rm_l := (others => '0');
-                Rn_l := data(5 downto 3);
+                Rn_l := plain(5 downto 3);
                 Rs_l := (others => '0');
-                Rd_l := data(2 downto 0);
+                Rd_l := plain(2 downto 0);
 
               -- LDR
               when "01"   =>
                 opcode  <= LDR_Rd_Rn_I;
                 Rm_l := (others => '0');
-                Rn_l := data(5 downto 3);
+                Rn_l := plain(5 downto 3);
                 Rs_l := (others => '0');
-                Rd_l := data(2 downto 0);
+                Rd_l := plain(2 downto 0);
 
               -- STRB
               when "10"   =>
                 opcode  <= STRB_Rd_Rn_I;
                 Rm_l := (others => '0');
-                Rn_l := data(5 downto 3);
+                Rn_l := plain(5 downto 3);
                 Rs_l := (others => '0');
-                Rd_l := data(2 downto 0);
+                Rd_l := plain(2 downto 0);
 
               -- LDRB
               when others =>
                 opcode  <= LDRB_Rd_Rn_I;
                 Rm_l := (others => '0');
-                Rn_l := data(5 downto 3);
+                Rn_l := plain(5 downto 3);
                 Rs_l := (others => '0');
-                Rd_l := data(2 downto 0);
+                Rd_l := plain(2 downto 0);
             end case;
 
           -- 100CCIIIIINNNDDD STRH, LDRH
           -- 100CCDDDIIIIIIII STR, LDR
           when "100"  =>
-            case data(12 downto 11)
+            case plain(12 downto 11)
             is
 
               -- 100CCIIIIINNNDDD STRH, LDRH
@@ -648,17 +739,17 @@ begin
               when "00"   =>
                 opcode  <= STRH_Rd_Rn_I;
                 Rm_l := (others => '0');
-                Rn_l := data(5 downto 3);
+                Rn_l := plain(5 downto 3);
                 Rs_l := (others => '0');
-                Rd_l := data(2 downto 0);
+                Rd_l := plain(2 downto 0);
 
               -- LDRH
               when "01"   =>
                 opcode  <= LDRH_Rd_Rn_I;
                 Rm_l := (others => '0');
-                Rn_l := data(5 downto 3);
+                Rn_l := plain(5 downto 3);
                 Rs_l := (others => '0');
-                Rd_l := data(2 downto 0);
+                Rd_l := plain(2 downto 0);
 
               -- 100CCDDDIIIIIIII STR, LDR
 
@@ -668,7 +759,7 @@ begin
                 Rm_l := (others => '0');
                 Rn_l := (others => '0');
                 Rs_l := (others => '0');
-                Rd_l := data(10 downto 8);
+                Rd_l := plain(10 downto 8);
 
               -- LDR
               when others =>
@@ -676,7 +767,7 @@ begin
                 Rm_l := (others => '0');
                 Rn_l := (others => '0');
                 Rs_l := (others => '0');
-                Rd_l := data(10 downto 8);
+                Rd_l := plain(10 downto 8);
 
             end case;
 
@@ -684,7 +775,7 @@ begin
           -- 1011CCCCIIIIIIII SUB, BKPT
           -- 1011C10FIIIIIIII PUSH, POP
           when "101"  =>
-            case data(12 downto 11)
+            case plain(12 downto 11)
             is
 
               -- 1010CDDDIIIIIIII ADD, ADD
@@ -695,7 +786,7 @@ begin
                 Rm_l := (others => '0');
                 Rn_l := (others => '0');
                 Rs_l := (others => '0');
-                Rd_l := data(10 downto 8);
+                Rd_l := plain(10 downto 8);
 
               -- ADD
               when "01"   =>
@@ -703,12 +794,12 @@ begin
                 Rm_l := (others => '0');
                 Rn_l := (others => '0');
                 Rs_l := (others => '0');
-                Rd_l := data(10 downto 8);
+                Rd_l := plain(10 downto 8);
 
               -- 1011CCCCIIIIIIII SUB, BKPT
               -- 1011C10FIIIIIIII PUSH, POP
               when others =>
-                case data(11 downto 9)
+                case plain(11 downto 9)
                 is
 
                   -- 101100001IIIIIII SUB
@@ -755,7 +846,7 @@ begin
           -- 1100CNNNIIIIIIII STMIA, LDMIA
           -- 1101CCCCIIIIIIII B_COND, SWI
           when "110"  =>
-            case data(12 downto 11)
+            case plain(12 downto 11)
             is
 
               -- 1100CNNNIIIIIIII STMIA, LDMIA
@@ -764,7 +855,7 @@ begin
               when "00"   =>
                 opcode  <= STMIA_RN_RL;
                 Rm_l := (others => '0');
-                Rn_l := data(10 downto 8);
+                Rn_l := plain(10 downto 8);
                 Rs_l := (others => '0');
                 Rd_l := (others => '0');
 
@@ -772,13 +863,13 @@ begin
               when "01"   =>
                 opcode  <= LDMIA_RN_RL;
                 Rm_l := (others => '0');
-                Rn_l := data(10 downto 8);
+                Rn_l := plain(10 downto 8);
                 Rs_l := (others => '0');
                 Rd_l := (others => '0');
 
               -- 1101CCCCIIIIIIII B_COND, SWI
               when others =>
-                case data(11 downto 8)
+                case plain(11 downto 8)
                 is
 
                   -- SWI
@@ -809,7 +900,7 @@ begin
             Rs_l := (others => '0');
             Rd_l := (others => '0');
 
-            case data(12 downto 11)
+            case plain(12 downto 11)
             is
 
               -- B_ADDR
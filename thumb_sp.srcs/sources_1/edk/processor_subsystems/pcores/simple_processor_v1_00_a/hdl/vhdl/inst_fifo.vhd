@@ -0,0 +1,192 @@
+-- Filename:          inst_fifo.vhd
+-- Version:           1.00.a
+-- Description:       instruction prefetch FIFO filled by software through
+--                    the EDK register file
+-- Date Created:      Sun, Oct 18, 2026 13:42:10
+-- Last Modified:     Sun, Oct 18, 2026 21:52:18
+-- VHDL Standard:     VHDL'93
+-- Author:            agent <agent@local>
+-- Copyright:         (c) 2026 Assured Information Security, All Rights Reserved
+
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+
+library simple_processor_v1_00_a;
+use simple_processor_v1_00_a.reg_file_constants.all;
+
+---
+-- Instruction prefetch FIFO
+--
+-- Software pushes 32-bit words, each packing 2 ARM Thumb(R) instructions,
+--  low halfword first. The processor pops 1 instruction per request using
+--  a 4-phase handshake: pop_req is held high until pop_ack goes high, and
+--  pop_ack stays high until pop_req drops.
+--
+-- Clk is the EDK register file's clock, which the state machine does not
+--  run on, so pop_req passes through two flip-flops first, and pop_data
+--  is settled a clock before pop_ack rises.
+--
+-- Pushes into a full FIFO are dropped. A request made while the FIFO is
+--  empty waits for the next push and counts as 1 underflow.
+---
+entity inst_fifo
+is
+  generic
+  (
+    -- number of 32-bit words held, must be a power of 2
+    C_INST_FIFO_DEPTH : integer          := 64
+  );
+  port
+  (
+    -- a pair of packed instructions, and its one clock push strobe
+    push_data  : in    std_logic_vector(DATA_WIDTH-1 downto 0);
+    push       : in    std_logic;
+
+    -- drop everything queued and zero the underflow counter
+    flush      : in    std_logic;
+
+    -- instruction request from the processor
+    pop_req    : in    std_logic;
+
+    -- popped instruction, and acknowledgement it is valid
+    pop_data   : out   std_logic_vector(15 downto 0);
+    pop_ack    : out   std_logic;
+
+    -- words currently queued, and requests made while empty
+    occupancy  : out   std_logic_vector(DATA_WIDTH-1 downto 0);
+    underflows : out   std_logic_vector(DATA_WIDTH-1 downto 0);
+
+    -- clock and active high reset
+    Clk        : in    std_logic;
+    Reset      : in    std_logic
+  );
+
+end entity inst_fifo;
+
+architecture IMP of inst_fifo
+is
+
+  -- queued words
+  type fifo_type is array(0 to C_INST_FIFO_DEPTH-1)
+    of std_logic_vector(DATA_WIDTH-1 downto 0);
+  signal fifo          : fifo_type;
+
+  -- read and write pointers, and number of words queued
+  signal rd_ptr        : integer range 0 to C_INST_FIFO_DEPTH-1;
+  signal wr_ptr        : integer range 0 to C_INST_FIFO_DEPTH-1;
+  signal count         : integer range 0 to C_INST_FIFO_DEPTH;
+
+  -- '1' once the low halfword of the head word has been popped
+  signal half          : std_logic;
+
+  -- pop_req, synchronized into Clk
+  signal req_meta      : std_logic;
+  signal req_sync      : std_logic;
+
+  -- a request is being served, or has already been counted as an underflow
+  signal served        : std_logic;
+  signal starved       : std_logic;
+
+  -- underflow counter
+  signal underflow_cnt : unsigned(DATA_WIDTH-1 downto 0);
+
+begin
+
+  -- send counters out
+  occupancy  <= std_logic_vector(to_unsigned(count, DATA_WIDTH));
+  underflows <= std_logic_vector(underflow_cnt);
+
+  ---
+  -- Push words in, pop halfwords out
+  ---
+  DO_UPDATE : process ( Clk )
+  is
+    variable do_push : boolean;
+    variable do_pop  : boolean;
+  begin
+
+    CLOCK_SYNC : if Clk'event and Clk = '1'
+    then
+
+      -- bring the request into this clock domain
+      req_meta <= pop_req;
+      req_sync <= req_meta;
+
+      -- reset requested, empty out
+      if Reset = '1' or flush = '1'
+      then
+        rd_ptr        <= 0;
+        wr_ptr        <= 0;
+        count         <= 0;
+        half          <= '0';
+        served        <= '0';
+        starved       <= '0';
+        pop_ack       <= '0';
+        underflow_cnt <= (others => '0');
+
+      else
+
+        -- pushes into a full FIFO are dropped
+        do_push := push = '1' and count < C_INST_FIFO_DEPTH;
+
+        -- serve a new request, words are only retired once both
+        --  halfwords have gone out
+        do_pop  := false;
+        if req_sync = '1' and served = '0'
+        then
+          if count > 0
+          then
+            if half = '0'
+            then
+              pop_data <= fifo(rd_ptr)(15 downto 0);
+              half     <= '1';
+            else
+              pop_data <= fifo(rd_ptr)(31 downto 16);
+              half     <= '0';
+              do_pop   := true;
+            end if;
+            served  <= '1';
+            starved <= '0';
+          elsif starved = '0'
+          then
+            underflow_cnt <= underflow_cnt + 1;
+            starved       <= '1';
+          end if;
+
+        -- pop_data went out last clock, acknowledge it
+        elsif req_sync = '1'
+        then
+          pop_ack <= '1';
+
+        -- request dropped, get ready for the next one
+        else
+          served  <= '0';
+          pop_ack <= '0';
+        end if;
+
+        -- update pointers
+        if do_push
+        then
+          fifo(wr_ptr) <= push_data;
+          wr_ptr       <= (wr_ptr + 1) mod C_INST_FIFO_DEPTH;
+        end if;
+        if do_pop
+        then
+          rd_ptr <= (rd_ptr + 1) mod C_INST_FIFO_DEPTH;
+        end if;
+        if do_push and not do_pop
+        then
+          count <= count + 1;
+        elsif do_pop and not do_push
+        then
+          count <= count - 1;
+        end if;
+
+      end if;
+
+    end if CLOCK_SYNC;
+
+  end process DO_UPDATE;
+
+end IMP;
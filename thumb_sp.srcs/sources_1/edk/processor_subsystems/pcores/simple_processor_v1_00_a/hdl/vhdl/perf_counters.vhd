@@ -0,0 +1,273 @@
+-- Filename:          perf_counters.vhd
+-- Version:           1.00.a
+-- Description:       performance counters for simple_processor
+-- Date Created:      Sun, Oct 18, 2026 14:31:26
+-- Last Modified:     Sun, Oct 18, 2026 22:20:45
+-- VHDL Standard:     VHDL'93
+-- Author:            agent <agent@local>
+-- Copyright:         (c) 2026 Assured Information Security, All Rights Reserved
+
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+
+library simple_processor_v1_00_a;
+use simple_processor_v1_00_a.opcodes.all;
+use simple_processor_v1_00_a.states.all;
+use simple_processor_v1_00_a.reg_file_constants.all;
+
+---
+-- Performance counters
+--
+-- Counts retired instructions, taken branches, loads, stores, stall cycles,
+--  and cycles spent in every state of the state machine. Cycles are clocks
+--  of Clk, the EDK register file's clock, which the state machine does
+--  not run on.
+--
+-- state and stall pass through two flip-flops, and state is only taken
+--  once two clocks in a row agree on it, so a state caught changing is
+--  never counted. Retirement arrives as a toggle, also through two
+--  flip-flops, with the retired instruction's opcode, condition, and
+--  flags held steady until the next one retires. Counts lag the state
+--  machine by a few clocks.
+--
+-- Software reads a snapshot of the counters, never the live counters.
+--  Writing the control word:
+--
+-- +-----+----------+---------------------------------------------+
+-- | Bit | Name     | Effect                                      |
+-- +-----+----------+---------------------------------------------+
+-- | 0   | FREEZE   | live counters hold their values while set   |
+-- | 1   | SNAPSHOT | copy the live counters into the snapshot    |
+-- | 2   | CLEAR    | zero the live counters, after any snapshot  |
+-- +-----+----------+---------------------------------------------+
+--
+-- Reading the control word returns FREEZE in bit 0 and the number of
+--  snapshots taken in bits 31-16.
+---
+entity perf_counters
+is
+  port
+  (
+    -- control word written by software, and its one clock strobe
+    ctrl_data    : in    std_logic_vector(DATA_WIDTH-1 downto 0);
+    ctrl_wr      : in    std_logic;
+
+    -- what the processor is doing
+    state        : in    integer range STATE_MIN to STATE_MAX;
+
+    -- flips once per retired instruction, and that instruction's opcode,
+    --  condition, and flags
+    retire       : in    std_logic;
+    opcode       : in    integer;
+    condition    : in    std_logic_vector(15 downto 0);
+    flag_n       : in    std_logic;
+    flag_z       : in    std_logic;
+    flag_c       : in    std_logic;
+    flag_v       : in    std_logic;
+
+    -- the current state is waiting on memory or the prefetch FIFO
+    stall        : in    std_logic;
+
+    -- control word read back, and snapshot of every counter
+    ctrl_status  : out   std_logic_vector(DATA_WIDTH-1 downto 0);
+    retired      : out   std_logic_vector(DATA_WIDTH-1 downto 0);
+    branches     : out   std_logic_vector(DATA_WIDTH-1 downto 0);
+    loads        : out   std_logic_vector(DATA_WIDTH-1 downto 0);
+    stores       : out   std_logic_vector(DATA_WIDTH-1 downto 0);
+    stalls       : out   std_logic_vector(DATA_WIDTH-1 downto 0);
+    state_cycles : out   std_logic_vector(DATA_WIDTH*STATE_MAX-1 downto 0);
+
+    -- clock and active high reset
+    Clk          : in    std_logic;
+    Reset        : in    std_logic
+  );
+
+end entity perf_counters;
+
+architecture IMP of perf_counters
+is
+
+  -- control word bits
+  constant PERF_FREEZE   : integer := 0;
+  constant PERF_SNAPSHOT : integer := 1;
+  constant PERF_CLEAR    : integer := 2;
+
+  -- counter indices, state cycle counters follow the event counters
+  constant CNT_RETIRED   : integer := 0;
+  constant CNT_BRANCHES  : integer := 1;
+  constant CNT_LOADS     : integer := 2;
+  constant CNT_STORES    : integer := 3;
+  constant CNT_STALLS    : integer := 4;
+  constant CNT_STATES    : integer := 5;
+  constant CNT_N         : integer := CNT_STATES + STATE_MAX;
+
+  type counter_type is array(0 to CNT_N-1)
+    of unsigned(DATA_WIDTH-1 downto 0);
+
+  -- live counters, and the copy software reads
+  signal live          : counter_type;
+  signal snap          : counter_type;
+
+  -- control state
+  signal frozen        : std_logic;
+  signal snapshots     : unsigned(15 downto 0);
+
+  -- state and stall synchronized into Clk, state during the last clock,
+  --  and the state counted
+  signal state_meta    : integer range STATE_MIN to STATE_MAX;
+  signal state_sync    : integer range STATE_MIN to STATE_MAX;
+  signal state_last    : integer range STATE_MIN to STATE_MAX;
+  signal state_seen    : integer range STATE_MIN to STATE_MAX;
+  signal stall_meta    : std_logic;
+  signal stall_sync    : std_logic;
+
+  -- retire synchronized into Clk, and its value during the last clock
+  signal retire_meta   : std_logic;
+  signal retire_sync   : std_logic;
+  signal retire_last   : std_logic;
+
+  -- whether a condition code passes given the current flags
+  function cond_pass(
+      condition : std_logic_vector(15 downto 0);
+      n, z, c, v : std_logic
+      ) return boolean is
+  begin
+    if    condition(EQ) = '1' then return z = '1';
+    elsif condition(NE) = '1' then return z = '0';
+    elsif condition(HS) = '1' then return c = '1';
+    elsif condition(LO) = '1' then return c = '0';
+    elsif condition(MI) = '1' then return n = '1';
+    elsif condition(PL) = '1' then return n = '0';
+    elsif condition(VS) = '1' then return v = '1';
+    elsif condition(VC) = '1' then return v = '0';
+    elsif condition(HI) = '1' then return c = '1' and z = '0';
+    elsif condition(LS) = '1' then return c = '0' or z = '1';
+    elsif condition(GE) = '1' then return n = v;
+    elsif condition(LT) = '1' then return n /= v;
+    elsif condition(GT) = '1' then return z = '0' and n = v;
+    elsif condition(LE) = '1' then return z = '1' or n /= v;
+    else                           return true;
+    end if;
+  end function cond_pass;
+
+begin
+
+  -- send the snapshot out
+  ctrl_status(0)             <= frozen;
+  ctrl_status(15 downto 1)   <= (others => '0');
+  ctrl_status(31 downto 16)  <= std_logic_vector(snapshots);
+  retired                    <= std_logic_vector(snap(CNT_RETIRED));
+  branches                   <= std_logic_vector(snap(CNT_BRANCHES));
+  loads                      <= std_logic_vector(snap(CNT_LOADS));
+  stores                     <= std_logic_vector(snap(CNT_STORES));
+  stalls                     <= std_logic_vector(snap(CNT_STALLS));
+  STATE_CYCLES_GEN : for i in 1 to STATE_MAX
+  generate
+    state_cycles(i*DATA_WIDTH-1 downto (i-1)*DATA_WIDTH) <=
+      std_logic_vector(snap(CNT_STATES+i-1));
+  end generate STATE_CYCLES_GEN;
+
+  ---
+  -- Count events, take snapshots
+  ---
+  DO_UPDATE : process ( Clk )
+  is
+    variable next_live : counter_type;
+  begin
+
+    CLOCK_SYNC : if Clk'event and Clk = '1'
+    then
+
+      -- bring the state machine's signals into this clock domain
+      state_meta  <= state;
+      state_sync  <= state_meta;
+      state_last  <= state_sync;
+      stall_meta  <= stall;
+      stall_sync  <= stall_meta;
+      retire_meta <= retire;
+      retire_sync <= retire_meta;
+      retire_last <= retire_sync;
+
+      -- reset requested
+      if Reset = '1'
+      then
+        live       <= (others => (others => '0'));
+        snap       <= (others => (others => '0'));
+        frozen     <= '0';
+        snapshots  <= (others => '0');
+        state_seen <= STATE_MIN;
+
+      else
+        if state_sync = state_last
+        then
+          state_seen <= state_sync;
+        end if;
+        next_live := live;
+
+        -- count
+        if frozen = '0'
+        then
+
+          -- time spent in each state
+          if state_seen /= STATE_MIN
+          then
+            next_live(CNT_STATES+state_seen-1) :=
+              next_live(CNT_STATES+state_seen-1) + 1;
+          end if;
+          if stall_sync = '1'
+          then
+            next_live(CNT_STALLS) := next_live(CNT_STALLS) + 1;
+          end if;
+
+          -- an instruction retired
+          if retire_sync /= retire_last
+          then
+            next_live(CNT_RETIRED) := next_live(CNT_RETIRED) + 1;
+            case opcode
+            is
+              when B_I | BL_I | BLX_L_I | BLX_H_I | BX_Rm | BLX_Rm =>
+                next_live(CNT_BRANCHES) := next_live(CNT_BRANCHES) + 1;
+              when B_COND_I =>
+                if cond_pass(condition, flag_n, flag_z, flag_c, flag_v)
+                then
+                  next_live(CNT_BRANCHES) := next_live(CNT_BRANCHES) + 1;
+                end if;
+              when LDR_Rd_IPC    | LDRSB_Rd_Rm_Rn | LDR_Rd_Rm_Rn   |
+                   LDRH_Rd_Rm_Rn | LDRB_Rd_Rm_Rn  | LDRSH_Rd_Rm_Rn |
+                   LDR_Rd_Rn_I   | LDRB_Rd_Rn_I   | LDRH_Rd_Rn_I   |
+                   LDR_Rd_ISP    | POP_RL_PC      | LDMIA_RN_RL    =>
+                next_live(CNT_LOADS) := next_live(CNT_LOADS) + 1;
+              when STR_Rd_Rm_Rn  | STRH_Rd_Rm_Rn  | STRB_Rd_Rm_Rn  |
+                   STR_Rd_Rn_I   | STRB_Rd_Rn_I   | STRH_Rd_Rn_I   |
+                   STR_Rd_I      | PUSH_RL_LR     | STMIA_RN_RL    =>
+                next_live(CNT_STORES) := next_live(CNT_STORES) + 1;
+              when others =>
+                null;
+            end case;
+          end if;
+        end if;
+
+        -- software control, snapshot before clearing
+        if ctrl_wr = '1'
+        then
+          frozen <= ctrl_data(PERF_FREEZE);
+          if ctrl_data(PERF_SNAPSHOT) = '1'
+          then
+            snap      <= next_live;
+            snapshots <= snapshots + 1;
+          end if;
+          if ctrl_data(PERF_CLEAR) = '1'
+          then
+            next_live := (others => (others => '0'));
+          end if;
+        end if;
+
+        live <= next_live;
+      end if;
+
+    end if CLOCK_SYNC;
+
+  end process DO_UPDATE;
+
+end IMP;
@@ -2,7 +2,7 @@
 -- Version:           1.00.a
 -- Description:       Contains the ids used by the state_machine
 -- Date Created:      Wed, Dec 04, 2013 01:17:21
--- Last Modified:     Tue, Dec 24, 2013 15:08:30
+-- Last Modified:     Sun, Oct 18, 2026 21:14:37
 -- VHDL Standard:     VHDL'93
 -- Author:            Sean McClain <mcclains@ainfosec.com>
 -- Copyright:         (c) 2013 Assured Information Security, All Rights Reserved
@@ -141,6 +141,26 @@ package reg_file_constants is
   constant MEMIO_LRREG       : integer := 15;
   constant MEMIO_N_CHANNELS  : integer := 16;
 
+  -- indices of status words within the EDK register file's user space
+  constant USR_DCACHE_HITS   : integer := 0;
+  constant USR_DCACHE_MISSES : integer := 1;
+  constant USR_DCACHE_WBACKS : integer := 2;
+  constant USR_INST_FIFO     : integer := 3;
+  constant USR_INST_UNDERFLOWS : integer := 4;
+  constant USR_PERF_CTRL     : integer := 5;
+  constant USR_PERF_RETIRED  : integer := 6;
+  constant USR_PERF_BRANCHES : integer := 7;
+  constant USR_PERF_LOADS    : integer := 8;
+  constant USR_PERF_STORES   : integer := 9;
+  constant USR_PERF_STALLS   : integer := 10;
+  constant USR_PERF_STATES   : integer := 11;
+  constant USR_TRACE_CTRL    : integer := 20;
+  constant USR_TRACE_DATA    : integer := 21;
+  constant USR_TRACE_TRIG_OP : integer := 22;
+  constant USR_ISR           : integer := 23;
+  constant USR_DCACHE_ERRORS : integer := 24;
+  constant USR_N_REGS        : integer := 26;
+
   -- 4-byte or 8-byte word-addressable memory
   type regs_type is array(NUM_REGS-1 downto 0)
     of std_logic_vector(DATA_WIDTH-1 downto 0);
@@ -153,6 +173,10 @@ package reg_file_constants is
   type mem_address is array(15 downto 0)
     of integer range NUM_REGS-1 downto 0;
 
+  -- status words exposed through the EDK register file's user space
+  type usr_regs_type is array(USR_N_REGS-1 downto 0)
+    of std_logic_vector(DATA_WIDTH-1 downto 0);
+
 end package reg_file_constants;
 
 package body reg_file_constants is
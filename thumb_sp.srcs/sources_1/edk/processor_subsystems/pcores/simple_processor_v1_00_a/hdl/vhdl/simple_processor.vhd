@@ -2,7 +2,7 @@
 -- Version:           1.00.a
 -- Description:       Simple ARM Thumb(R) processor
 -- Date Created:      Wed, Nov 13, 2013 20:59:21
--- Last Modified:     Thu, Dec 26, 2013 17:40:49
+-- Last Modified:     Sun, Oct 18, 2026 21:14:37
 -- VHDL Standard:     VHDL'93
 -- Author:            Sean McClain <mcclains@ainfosec.com>
 -- Copyright:         (c) 2013 Assured Information Security, All Rights Reserved
@@ -18,6 +18,9 @@ use proc_common_v3_00_a.soft_reset;
 
 library simple_processor_v1_00_a;
 use simple_processor_v1_00_a.alu;
+use simple_processor_v1_00_a.dcache;
+use simple_processor_v1_00_a.inst_fifo;
+use simple_processor_v1_00_a.perf_counters;
 use simple_processor_v1_00_a.decoder;
 use simple_processor_v1_00_a.reg_file;
 use simple_processor_v1_00_a.state_machine;
@@ -34,7 +37,33 @@ is
   generic
   (
     -- number of comm channels owned by EDK register file
-    NUM_CHANNELS  : integer          := 32
+    NUM_CHANNELS        : integer          := 32;
+
+    -- 1 to serve loads and stores in the cached range over M_AXI
+    C_USE_DCACHE        : integer          := 0;
+
+    -- data cache geometry, lines and 32-bit words per line
+    C_DCACHE_LINES      : integer          := 256;
+    C_DCACHE_LINE_WORDS : integer          := 4;
+
+    -- byte address range served by the data cache
+    C_DCACHE_BASEADDR   : std_logic_vector := X"40000000";
+    C_DCACHE_HIGHADDR   : std_logic_vector := X"7FFFFFFF";
+
+    -- 1 to fetch instructions from the prefetch FIFO instead of INSTR_REG
+    C_USE_INST_FIFO     : integer          := 0;
+
+    -- prefetch FIFO depth in 32-bit words, 2 instructions each
+    C_INST_FIFO_DEPTH   : integer          := 64;
+
+    -- 1 to record retired instructions in the trace buffer
+    C_USE_TRACE         : integer          := 0;
+
+    -- trace buffer depth in entries, 3 words each
+    C_TRACE_DEPTH       : integer          := 512;
+
+    -- 1 to decode through the instruction set randomization table
+    C_USE_ISR           : integer          := 0
   );
   port
   (
@@ -53,6 +82,51 @@ is
     rd_ack        : in    std_logic;
     wr_ack        : in    std_logic;
 
+    -- status words readable from the EDK register file's user space
+    status        : out   std_logic_vector (
+        DATA_WIDTH*USR_N_REGS-1 downto 0
+        );
+
+    -- words written to the EDK register file's user space, and the one
+    --  clock strobes saying which word was written
+    user_data     : in    std_logic_vector(DATA_WIDTH-1 downto 0);
+    user_wr       : in    std_logic_vector(USR_N_REGS-1 downto 0);
+
+    -- one clock strobes saying which user space word software just read
+    user_rd       : in    std_logic_vector(USR_N_REGS-1 downto 0);
+
+    -- clock of the EDK register file, runs the user space logic
+    Bus_Clk       : in    std_logic;
+
+    -- AXI4 master used by the data cache
+    M_AXI_AWADDR  : out   std_logic_vector(DATA_WIDTH-1 downto 0);
+    M_AXI_AWLEN   : out   std_logic_vector(7 downto 0);
+    M_AXI_AWSIZE  : out   std_logic_vector(2 downto 0);
+    M_AXI_AWBURST : out   std_logic_vector(1 downto 0);
+    M_AXI_AWVALID : out   std_logic;
+    M_AXI_AWREADY : in    std_logic;
+    M_AXI_WDATA   : out   std_logic_vector(DATA_WIDTH-1 downto 0);
+    M_AXI_WSTRB   : out   std_logic_vector(DATA_WIDTH/8-1 downto 0);
+    M_AXI_WLAST   : out   std_logic;
+    M_AXI_WVALID  : out   std_logic;
+    M_AXI_WREADY  : in    std_logic;
+    M_AXI_BRESP   : in    std_logic_vector(1 downto 0);
+    M_AXI_BVALID  : in    std_logic;
+    M_AXI_BREADY  : out   std_logic;
+    M_AXI_ARADDR  : out   std_logic_vector(DATA_WIDTH-1 downto 0);
+    M_AXI_ARLEN   : out   std_logic_vector(7 downto 0);
+    M_AXI_ARSIZE  : out   std_logic_vector(2 downto 0);
+    M_AXI_ARBURST : out   std_logic_vector(1 downto 0);
+    M_AXI_ARVALID : out   std_logic;
+    M_AXI_ARREADY : in    std_logic;
+    M_AXI_RDATA   : in    std_logic_vector(DATA_WIDTH-1 downto 0);
+    M_AXI_RRESP   : in    std_logic_vector(1 downto 0);
+    M_AXI_RLAST   : in    std_logic;
+    M_AXI_RVALID  : in    std_logic;
+    M_AXI_RREADY  : out   std_logic;
+    M_AXI_ACLK    : in    std_logic;
+    M_AXI_ARESETN : in    std_logic;
+
     -- clock and reset
     Clk           : in    std_logic;
     Reset         : in    std_logic
@@ -71,6 +145,14 @@ is
   signal load_ack            : std_logic;
   signal math_ack            : std_logic;
   signal store_ack           : std_logic;
+  signal dcache_ack          : std_logic;
+
+  -- instruction sources, INSTR_REG in the register file or the FIFO
+  signal rf_instruction      : std_logic_vector(15 downto 0);
+  signal rf_send_inst_ack    : std_logic;
+  signal fifo_instruction    : std_logic_vector(15 downto 0);
+  signal fifo_send_inst_ack  : std_logic;
+  signal fifo_pop_req        : std_logic;
 
   -- raw binary for the current instruction
   signal raw_instruction     : std_logic_vector(15 downto 0);
@@ -138,6 +220,55 @@ is
   -- current processing state
   signal state               : integer range STATE_MIN to STATE_MAX;
 
+  -- data cache request, set while a cached load or store is outstanding
+  signal dc_addr             : std_logic_vector(DATA_WIDTH-1 downto 0);
+  signal dc_size             : std_logic_vector(1 downto 0);
+  signal dc_signed           : std_logic;
+  signal dc_load             : std_logic;
+  signal dc_store            : std_logic;
+  signal dc_active           : std_logic;
+  signal dc_rd               : std_logic;
+  signal dc_wr               : std_logic;
+  signal dc_rdata            : std_logic_vector(DATA_WIDTH-1 downto 0);
+  signal dc_ack              : std_logic;
+
+  -- registered cache request, whether the state machine wants one, and
+  --  the cache's acknowledgement brought over from M_AXI_ACLK
+  signal dc_req_q            : std_logic;
+  signal dc_want             : std_logic;
+  signal dc_want_meta        : std_logic;
+  signal dc_want_sync        : std_logic;
+  signal dc_ack_meta         : std_logic;
+  signal dc_ack_sync         : std_logic;
+
+  -- what the register file sees once cached accesses are folded in
+  signal reg_alu_out         : std_logic_vector(DATA_WIDTH-1 downto 0);
+  signal reg_wr_en           : std_logic_vector(WR_EN_SIZEOF-1 downto 0);
+
+  -- status words, indexed by USR_* in reg_file_constants
+  signal status_regs         : usr_regs_type;
+
+  -- flips each time an instruction retires, with what the performance
+  --  counters and trace buffer need about it held until the next one
+  --  retires
+  signal retire_toggle       : std_logic := '0';
+  signal retired_pc          : std_logic_vector(DATA_WIDTH-1 downto 0);
+  signal retired_instruction : std_logic_vector(15 downto 0);
+  signal retired_result      : std_logic_vector(DATA_WIDTH-1 downto 0);
+  signal retired_opcode      : integer;
+  signal retired_condition   : std_logic_vector(15 downto 0);
+  signal retired_n           : std_logic;
+  signal retired_z           : std_logic;
+  signal retired_c           : std_logic;
+  signal retired_v           : std_logic;
+
+  -- performance counter inputs
+  signal perf_stall          : std_logic;
+  signal perf_state_cycles   : std_logic_vector(DATA_WIDTH*STATE_MAX-1 downto 0);
+
+  -- address of the current instruction, for the trace buffer
+  signal trace_pc            : std_logic_vector(DATA_WIDTH-1 downto 0);
+
 begin
 
   ---
@@ -153,6 +284,7 @@ begin
       load_ack               => load_ack,
       math_ack               => math_ack,
       store_ack              => store_ack,
+      dcache_ack             => dcache_ack,
       state                  => state,
       Clk                    => Clk,
       Reset                  => Reset
@@ -185,14 +317,14 @@ begin
       Imm_11                 => Imm_11,
       flag_lr_pc             => flag_lr_pc,
       flags_h                => flags_h,
-      alu_out                => alu_out,
-      alu_wr_en              => alu_wr_en,
+      alu_out                => reg_alu_out,
+      alu_wr_en              => reg_wr_en,
       flag_n                 => flag_n,
       flag_z                 => flag_z,
       flag_c                 => flag_c,
       flag_v                 => flag_v,
       reg_file_reset_ack     => reg_file_reset_ack,
-      send_inst_ack          => send_inst_ack,
+      send_inst_ack          => rf_send_inst_ack,
       load_ack               => load_ack,
       store_ack              => store_ack,
       sp_plus_off            => sp_plus_off,
@@ -214,10 +346,63 @@ begin
       sp_val                 => sp,
       pc_val                 => pc,
       lr_val                 => lr,
-      instruction            => raw_instruction,
+      instruction            => rf_instruction,
       state                  => state
     );
 
+  ---
+  -- Optional instruction prefetch FIFO, filled by software through the
+  --  EDK register file's user space
+  ---
+  INST_FIFO_GEN : if C_USE_INST_FIFO = 1
+  generate
+
+    -- held until the FIFO acknowledges on Bus_Clk; the next request
+    --  needs another Clk pulse from software, long after the FIFO has
+    --  seen this one drop
+    fifo_pop_req <= '1' when state = DO_SEND_INST else '0';
+
+    INST_FIFO_I : entity simple_processor_v1_00_a.inst_fifo
+      generic map
+      (
+        C_INST_FIFO_DEPTH    => C_INST_FIFO_DEPTH
+      )
+      port map
+      (
+        push_data            => user_data,
+        push                 => user_wr(USR_INST_FIFO),
+        flush                => user_wr(USR_INST_UNDERFLOWS),
+        pop_req              => fifo_pop_req,
+        pop_data             => fifo_instruction,
+        pop_ack              => fifo_send_inst_ack,
+        occupancy            => status_regs(USR_INST_FIFO),
+        underflows           => status_regs(USR_INST_UNDERFLOWS),
+        Clk                  => Bus_Clk,
+        Reset                => Reset
+      );
+
+    raw_instruction <= fifo_instruction;
+    send_inst_ack   <= fifo_send_inst_ack;
+
+  end generate INST_FIFO_GEN;
+
+  ---
+  -- No prefetch FIFO, instructions come from INSTR_REG
+  ---
+  NO_INST_FIFO_GEN : if C_USE_INST_FIFO /= 1
+  generate
+
+    fifo_pop_req     <= '0';
+    fifo_instruction <= (others => '0');
+
+    status_regs(USR_INST_FIFO)       <= (others => '0');
+    status_regs(USR_INST_UNDERFLOWS) <= (others => '0');
+
+    raw_instruction <= rf_instruction;
+    send_inst_ack   <= rf_send_inst_ack;
+
+  end generate NO_INST_FIFO_GEN;
+
   ---
   -- Selects 2 register file outputs to send into the ALU,
   --  and selects which write enables are on in the register file
@@ -255,6 +440,10 @@ begin
   -- ARM Thumb(R) decoder
   ---
   DECODER_I : entity simple_processor_v1_00_a.decoder
+    generic map
+    (
+      C_USE_ISR              => C_USE_ISR
+    )
     port map
     (
       data                   => raw_instruction,
@@ -271,7 +460,12 @@ begin
       flag_lr_pc             => flag_lr_pc,
       flags_h                => flags_h,
       decode_ack             => decode_ack,
-      state                  => state
+      state                  => state,
+      isr_data               => user_data,
+      isr_wr                 => user_wr(USR_ISR),
+      isr_status             => status_regs(USR_ISR),
+      Clk                    => Bus_Clk,
+      Reset                  => Reset
     );
 
   ---
@@ -293,4 +487,314 @@ begin
       state                  => state
   );
 
+  ---
+  -- Work out the width, signedness, and byte address of load/store opcodes
+  ---
+  with opcode select dc_size <=
+    "00" when STRB_Rd_Rm_Rn | LDRSB_Rd_Rm_Rn | LDRB_Rd_Rm_Rn |
+              STRB_Rd_Rn_I  | LDRB_Rd_Rn_I,
+    "01" when STRH_Rd_Rm_Rn | LDRH_Rd_Rm_Rn  | LDRSH_Rd_Rm_Rn |
+              STRH_Rd_Rn_I  | LDRH_Rd_Rn_I,
+    "10" when others;
+
+  with opcode select dc_signed <=
+    '1' when LDRSB_Rd_Rm_Rn | LDRSH_Rd_Rm_Rn,
+    '0' when others;
+
+  with opcode select dc_load <=
+    '1' when LDRSB_Rd_Rm_Rn | LDR_Rd_Rm_Rn | LDRH_Rd_Rm_Rn |
+             LDRB_Rd_Rm_Rn  | LDRSH_Rd_Rm_Rn |
+             LDR_Rd_Rn_I    | LDRB_Rd_Rn_I   | LDRH_Rd_Rn_I,
+    '0' when others;
+
+  with opcode select dc_store <=
+    '1' when STR_Rd_Rm_Rn | STRH_Rd_Rm_Rn | STRB_Rd_Rm_Rn |
+             STR_Rd_Rn_I  | STRB_Rd_Rn_I  | STRH_Rd_Rn_I,
+    '0' when others;
+
+  -- [Rn, #Imm_5] scales the offset by the access size, [Rn, Rm] does not
+  with opcode select dc_addr <=
+    std_logic_vector(unsigned(rn_reg) + unsigned(rm_reg))
+      when STR_Rd_Rm_Rn | STRH_Rd_Rm_Rn | STRB_Rd_Rm_Rn | LDRSB_Rd_Rm_Rn |
+           LDR_Rd_Rm_Rn | LDRH_Rd_Rm_Rn | LDRB_Rd_Rm_Rn | LDRSH_Rd_Rm_Rn,
+    std_logic_vector(unsigned(rn_reg) + shift_left(resize(unsigned(Imm_5),
+        DATA_WIDTH), 2))
+      when STR_Rd_Rn_I | LDR_Rd_Rn_I,
+    std_logic_vector(unsigned(rn_reg) + shift_left(resize(unsigned(Imm_5),
+        DATA_WIDTH), 1))
+      when STRH_Rd_Rn_I | LDRH_Rd_Rn_I,
+    std_logic_vector(unsigned(rn_reg) + resize(unsigned(Imm_5), DATA_WIDTH))
+      when others;
+
+  -- only accesses inside the cached range leave the register file
+  dc_active <= '1' when C_USE_DCACHE = 1 and
+      (dc_load = '1' or dc_store = '1') and
+      unsigned(dc_addr) >= unsigned(C_DCACHE_BASEADDR) and
+      unsigned(dc_addr) <= unsigned(C_DCACHE_HIGHADDR)
+    else '0';
+
+  ---
+  -- Optional write-back data cache
+  ---
+  DCACHE_GEN : if C_USE_DCACHE = 1
+  generate
+
+    dc_want <= '1' when state = DO_DCACHE and dc_active = '1' else '0';
+
+    ---
+    -- Hold a request up until the synchronized acknowledgement arrives and
+    --  do not raise the next one until the last acknowledgement has
+    --  dropped, so the request crosses into M_AXI_ACLK as a clean 4-phase
+    --  handshake. Clk only steps the state machine, so this runs on
+    --  Bus_Clk.
+    ---
+    DC_REQUEST : process ( Bus_Clk )
+    is
+    begin
+
+      CLOCK_SYNC : if Bus_Clk'event and Bus_Clk = '1'
+      then
+        dc_want_meta <= dc_want;
+        dc_want_sync <= dc_want_meta;
+        dc_ack_meta  <= dc_ack;
+        dc_ack_sync  <= dc_ack_meta;
+
+        if Reset = '1'
+        then
+          dc_req_q <= '0';
+        elsif dc_want_sync = '1' and dc_ack_sync = '0'
+        then
+          dc_req_q <= '1';
+        elsif dc_ack_sync = '1'
+        then
+          dc_req_q <= '0';
+        end if;
+      end if CLOCK_SYNC;
+
+    end process DC_REQUEST;
+
+    dc_rd <= dc_req_q and dc_load;
+    dc_wr <= dc_req_q and dc_store;
+
+    DCACHE_I : entity simple_processor_v1_00_a.dcache
+      generic map
+      (
+        C_DCACHE_LINES       => C_DCACHE_LINES,
+        C_DCACHE_LINE_WORDS  => C_DCACHE_LINE_WORDS
+      )
+      port map
+      (
+        req_addr             => dc_addr,
+        req_wdata            => rd_reg,
+        req_size             => dc_size,
+        req_signed           => dc_signed,
+        req_rd               => dc_rd,
+        req_wr               => dc_wr,
+        resp_rdata           => dc_rdata,
+        resp_ack             => dc_ack,
+        hits                 => status_regs(USR_DCACHE_HITS),
+        misses               => status_regs(USR_DCACHE_MISSES),
+        writebacks           => status_regs(USR_DCACHE_WBACKS),
+        errors               => status_regs(USR_DCACHE_ERRORS),
+        M_AXI_AWADDR         => M_AXI_AWADDR,
+        M_AXI_AWLEN          => M_AXI_AWLEN,
+        M_AXI_AWSIZE         => M_AXI_AWSIZE,
+        M_AXI_AWBURST        => M_AXI_AWBURST,
+        M_AXI_AWVALID        => M_AXI_AWVALID,
+        M_AXI_AWREADY        => M_AXI_AWREADY,
+        M_AXI_WDATA          => M_AXI_WDATA,
+        M_AXI_WSTRB          => M_AXI_WSTRB,
+        M_AXI_WLAST          => M_AXI_WLAST,
+        M_AXI_WVALID         => M_AXI_WVALID,
+        M_AXI_WREADY         => M_AXI_WREADY,
+        M_AXI_BRESP          => M_AXI_BRESP,
+        M_AXI_BVALID         => M_AXI_BVALID,
+        M_AXI_BREADY         => M_AXI_BREADY,
+        M_AXI_ARADDR         => M_AXI_ARADDR,
+        M_AXI_ARLEN          => M_AXI_ARLEN,
+        M_AXI_ARSIZE         => M_AXI_ARSIZE,
+        M_AXI_ARBURST        => M_AXI_ARBURST,
+        M_AXI_ARVALID        => M_AXI_ARVALID,
+        M_AXI_ARREADY        => M_AXI_ARREADY,
+        M_AXI_RDATA          => M_AXI_RDATA,
+        M_AXI_RRESP          => M_AXI_RRESP,
+        M_AXI_RLAST          => M_AXI_RLAST,
+        M_AXI_RVALID         => M_AXI_RVALID,
+        M_AXI_RREADY         => M_AXI_RREADY,
+        M_AXI_ACLK           => M_AXI_ACLK,
+        M_AXI_ARESETN        => M_AXI_ARESETN
+      );
+
+  end generate DCACHE_GEN;
+
+  ---
+  -- No data cache, keep the AXI master idle
+  ---
+  NO_DCACHE_GEN : if C_USE_DCACHE /= 1
+  generate
+
+    dc_rd       <= '0';
+    dc_wr       <= '0';
+    dc_rdata    <= (others => '0');
+    dc_ack      <= '0';
+    dc_req_q    <= '0';
+    dc_ack_sync <= '0';
+
+    status_regs(USR_DCACHE_HITS)   <= (others => '0');
+    status_regs(USR_DCACHE_MISSES) <= (others => '0');
+    status_regs(USR_DCACHE_WBACKS) <= (others => '0');
+    status_regs(USR_DCACHE_ERRORS) <= (others => '0');
+
+    M_AXI_AWADDR  <= (others => '0');
+    M_AXI_AWLEN   <= (others => '0');
+    M_AXI_AWSIZE  <= (others => '0');
+    M_AXI_AWBURST <= (others => '0');
+    M_AXI_AWVALID <= '0';
+    M_AXI_WDATA   <= (others => '0');
+    M_AXI_WSTRB   <= (others => '0');
+    M_AXI_WLAST   <= '0';
+    M_AXI_WVALID  <= '0';
+    M_AXI_BREADY  <= '0';
+    M_AXI_ARADDR  <= (others => '0');
+    M_AXI_ARLEN   <= (others => '0');
+    M_AXI_ARSIZE  <= (others => '0');
+    M_AXI_ARBURST <= (others => '0');
+    M_AXI_ARVALID <= '0';
+    M_AXI_RREADY  <= '0';
+
+  end generate NO_DCACHE_GEN;
+
+  -- cached loads write the cache's data back to Rd, cached stores
+  --  never touch the register file
+  reg_alu_out <= dc_rdata when dc_active = '1' and dc_load = '1'
+    else alu_out;
+  reg_wr_en   <= (others => '0') when dc_active = '1' and dc_store = '1'
+    else alu_wr_en;
+
+  -- acknowledge DO_DCACHE once the cache has served this request,
+  --  or right away when the access does not go through the cache
+  dcache_ack <= '1' when state = DO_DCACHE and
+      (dc_active = '0' or (dc_req_q = '1' and dc_ack_sync = '1'))
+    else '0';
+
+  -- waiting on the prefetch FIFO or the data cache
+  perf_stall <= '1' when
+      (state = DO_SEND_INST and send_inst_ack = '0') or
+      (state = DO_DCACHE and dcache_ack = '0')
+    else '0';
+
+  ---
+  -- Latch each retiring instruction as the state machine leaves
+  --  DO_LOAD_STORE, for the performance counters and trace buffer on
+  --  Bus_Clk to pick up once they see retire_toggle flip
+  ---
+  RETIRE : process ( store_ack )
+  is
+  begin
+
+    if state = DO_LOAD_STORE
+      and (store_ack'event and store_ack = '1')
+    then
+      retire_toggle       <= not retire_toggle;
+      retired_pc          <= trace_pc;
+      retired_instruction <= raw_instruction;
+      retired_result      <= alu_out;
+      retired_opcode      <= opcode;
+      retired_condition   <= condition;
+      retired_n           <= flag_n;
+      retired_z           <= flag_z;
+      retired_c           <= flag_c;
+      retired_v           <= flag_v;
+    end if;
+
+  end process RETIRE;
+
+  ---
+  -- Performance counters, controlled and read through the EDK register
+  --  file's user space
+  ---
+  PERF_COUNTERS_I : entity simple_processor_v1_00_a.perf_counters
+    port map
+    (
+      ctrl_data              => user_data,
+      ctrl_wr                => user_wr(USR_PERF_CTRL),
+      state                  => state,
+      retire                 => retire_toggle,
+      opcode                 => retired_opcode,
+      condition              => retired_condition,
+      flag_n                 => retired_n,
+      flag_z                 => retired_z,
+      flag_c                 => retired_c,
+      flag_v                 => retired_v,
+      stall                  => perf_stall,
+      ctrl_status            => status_regs(USR_PERF_CTRL),
+      retired                => status_regs(USR_PERF_RETIRED),
+      branches               => status_regs(USR_PERF_BRANCHES),
+      loads                  => status_regs(USR_PERF_LOADS),
+      stores                 => status_regs(USR_PERF_STORES),
+      stalls                 => status_regs(USR_PERF_STALLS),
+      state_cycles           => perf_state_cycles,
+      Clk                    => Bus_Clk,
+      Reset                  => Reset
+    );
+
+  PERF_STATES_GEN : for i in 0 to STATE_MAX-1
+  generate
+    status_regs(USR_PERF_STATES+i) <=
+      perf_state_cycles((i+1)*DATA_WIDTH-1 downto i*DATA_WIDTH);
+  end generate PERF_STATES_GEN;
+
+  -- the register file's pc_reg output lands on lr_reg, see REG_FILE_I
+  trace_pc <= lr_reg;
+
+  ---
+  -- Optional trace buffer, records every retired instruction for
+  --  software to drain through the EDK register file's user space
+  ---
+  TRACE_GEN : if C_USE_TRACE = 1
+  generate
+
+    TRACE_BUFFER_I : entity simple_processor_v1_00_a.trace_buffer
+      generic map
+      (
+        C_TRACE_DEPTH        => C_TRACE_DEPTH
+      )
+      port map
+      (
+        ctrl_data            => user_data,
+        ctrl_wr              => user_wr(USR_TRACE_CTRL),
+        trig_pc_wr           => user_wr(USR_TRACE_DATA),
+        trig_op_wr           => user_wr(USR_TRACE_TRIG_OP),
+        pop                  => user_rd(USR_TRACE_DATA),
+        retire               => retire_toggle,
+        pc                   => retired_pc,
+        opcode               => retired_opcode,
+        instruction          => retired_instruction,
+        result               => retired_result,
+        status               => status_regs(USR_TRACE_CTRL),
+        data_out             => status_regs(USR_TRACE_DATA),
+        captured             => status_regs(USR_TRACE_TRIG_OP),
+        Clk                  => Bus_Clk,
+        Reset                => Reset
+      );
+
+  end generate TRACE_GEN;
+
+  NO_TRACE_GEN : if C_USE_TRACE /= 1
+  generate
+    status_regs(USR_TRACE_CTRL)    <= (others => '0');
+    status_regs(USR_TRACE_DATA)    <= (others => '0');
+    status_regs(USR_TRACE_TRIG_OP) <= (others => '0');
+  end generate NO_TRACE_GEN;
+
+  -- unused status words read back as 0
+  status_regs(USR_N_REGS-1 downto USR_DCACHE_ERRORS+1) <=
+    (others => (others => '0'));
+
+  -- pack status words for the EDK register file
+  STATUS_GEN : for i in USR_N_REGS-1 downto 0
+  generate
+    status((i+1)*DATA_WIDTH-1 downto i*DATA_WIDTH) <= status_regs(i);
+  end generate STATUS_GEN;
+
 end IMP;
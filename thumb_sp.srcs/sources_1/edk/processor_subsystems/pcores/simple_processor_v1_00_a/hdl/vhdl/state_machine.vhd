@@ -2,7 +2,7 @@
 -- Version:           0.01
 -- Description:       Controls event ordering
 -- Date Created:      Tue, Nov 19, 2013 16:00:21
--- Last Modified:     Fri, Dec 20, 2013 00:00:34
+-- Last Modified:     Sun, Oct 18, 2026 12:43:51
 -- VHDL Standard:     VHDL '93
 -- Author:            Sean McClain <mcclains@ainfosec.com>
 -- Copyright:         (c) 2013 Assured Information Security, All Rights Reserved
@@ -32,6 +32,7 @@ is
     decode_ack         : in    std_logic;
     load_ack           : in    std_logic;
     math_ack           : in    std_logic;
+    dcache_ack         : in    std_logic;
     store_ack          : in    std_logic;
 
     -- main state variable, used in a manner similar to a clock
@@ -56,7 +57,8 @@ begin
   DO_UPDATE : process (
       Clk, state,
       reg_file_reset_ack, alu_reset_ack,
-      send_inst_ack, decode_ack, load_ack, math_ack, store_ack
+      send_inst_ack, decode_ack, load_ack, math_ack, dcache_ack,
+      store_ack
       )
   is
   begin
@@ -95,6 +97,10 @@ begin
       state <= DO_MATH;
     elsif state = DO_MATH
       and (math_ack'event and math_ack = '1')
+    then
+      state <= DO_DCACHE;
+    elsif state = DO_DCACHE
+      and (dcache_ack'event and dcache_ack = '1')
     then
       state <= DO_LOAD_STORE;
     elsif state = DO_LOAD_STORE
@@ -2,7 +2,7 @@
 -- Version:           1.00.a
 -- Description:       Contains the ids used by the state_machine
 -- Date Created:      Wed, Nov 13, 2013 20:59:21
--- Last Modified:     Fri, Dec 06, 2013 00:21:07
+-- Last Modified:     Sun, Oct 18, 2026 12:41:05
 -- VHDL Standard:     VHDL'93
 -- Author:            Sean McClain <mcclains@ainfosec.com>
 -- Copyright:         (c) 2013 Assured Information Security, All Rights Reserved
@@ -20,7 +20,8 @@ package states is
   constant DO_MATH              : integer          := 6;
   constant DO_LOAD_STORE        : integer          := 7;
   constant DO_CLEAR_FLAGS       : integer          := 8;
-  constant STATE_MAX            : integer          := 8;
+  constant DO_DCACHE            : integer          := 9;
+  constant STATE_MAX            : integer          := 9;
 
 end package states;
 
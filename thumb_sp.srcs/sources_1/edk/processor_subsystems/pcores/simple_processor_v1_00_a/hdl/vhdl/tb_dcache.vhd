@@ -0,0 +1,608 @@
+-- Filename:          tb_dcache.vhd
+-- Version:           1.00.a
+-- Description:       simulation testbench for dcache, against a simulated
+--                    BRAM behind an AXI4 slave
+-- Date Created:      Sun, Oct 18, 2026 18:10:05
+-- Last Modified:     Sun, Oct 18, 2026 21:14:37
+-- VHDL Standard:     VHDL'93
+-- Author:            agent <agent@local>
+-- Copyright:         (c) 2026 Assured Information Security, All Rights Reserved
+--
+-- Simulation only, not listed in the .pao. With GHDL, from this directory:
+--
+--   ghdl -a --work=simple_processor_v1_00_a reg_file_constants.vhd \
+--     dcache.vhd tb_dcache.vhd
+--   ghdl -e --work=simple_processor_v1_00_a tb_dcache
+--   ghdl -r --work=simple_processor_v1_00_a tb_dcache
+--
+-- Generics can be overridden on the run line, such as -gC_BRAM_LATENCY=8.
+
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+
+library simple_processor_v1_00_a;
+use simple_processor_v1_00_a.reg_file_constants.all;
+
+---
+-- Drives dcache through five access patterns, every load checked against
+--  a shadow copy of memory:
+--
+--   sweep    word loads across twice the cache, twice over
+--   reuse    word loads across a quarter of the cache, 4 times over
+--   dirty    word stores across twice the cache, then loads of it all,
+--            so every line is written back and refilled
+--   random   C_RANDOM loads and stores, 1 in 4 a store, bytes,
+--            halfwords and words, anywhere in the BRAM
+--   refuse   a write back and a refill answered with SLVERR, each must
+--            come back as 0 and count an error, leaving the dirty victim
+--            in place and the refused line invalid
+--
+--  and reports each pattern's hits, misses, write backs, hit rate, and
+--  average clocks from raising req_rd to seeing resp_ack. Any wrong load
+--  fails the simulation.
+---
+entity tb_dcache
+is
+  generic
+  (
+    -- cache shape, as on dcache
+    C_DCACHE_LINES      : integer          := 256;
+    C_DCACHE_LINE_WORDS : integer          := 4;
+
+    -- 32-bit words of simulated BRAM, a power of 2
+    C_BRAM_WORDS        : integer          := 8192;
+
+    -- clocks the BRAM slave waits between a read address and its data
+    C_BRAM_LATENCY      : integer          := 2;
+
+    -- accesses made by the random pattern
+    C_RANDOM            : integer          := 20000
+  );
+end entity tb_dcache;
+
+architecture IMP of tb_dcache
+is
+
+  -- where the BRAM sits
+  constant BRAM_BASE   : unsigned(DATA_WIDTH-1 downto 0) := X"40000000";
+
+  constant CLK_PERIOD  : time := 10 ns;
+
+  type mem_type is array(0 to C_BRAM_WORDS-1)
+    of std_logic_vector(DATA_WIDTH-1 downto 0);
+
+  -- what a BRAM word holds out of reset
+  function init_word(i : integer) return std_logic_vector is
+  begin
+    return X"A5" & std_logic_vector(to_unsigned(i, 24));
+  end function init_word;
+
+  -- word index of a byte address into the BRAM
+  function word_of(addr : std_logic_vector) return integer is
+  begin
+    return to_integer(unsigned(addr(DATA_WIDTH-1 downto 2)))
+      mod C_BRAM_WORDS;
+  end function word_of;
+
+  signal clk           : std_logic := '0';
+  signal resetn        : std_logic := '0';
+  signal done          : std_logic := '0';
+
+  -- dcache request side
+  signal req_addr      : std_logic_vector(DATA_WIDTH-1 downto 0)
+    := (others => '0');
+  signal req_wdata     : std_logic_vector(DATA_WIDTH-1 downto 0)
+    := (others => '0');
+  signal req_size      : std_logic_vector(1 downto 0) := "10";
+  signal req_signed    : std_logic := '0';
+  signal req_rd        : std_logic := '0';
+  signal req_wr        : std_logic := '0';
+  signal resp_rdata    : std_logic_vector(DATA_WIDTH-1 downto 0);
+  signal resp_ack      : std_logic;
+  signal hits          : std_logic_vector(DATA_WIDTH-1 downto 0);
+  signal misses        : std_logic_vector(DATA_WIDTH-1 downto 0);
+  signal writebacks    : std_logic_vector(DATA_WIDTH-1 downto 0);
+  signal axi_errors    : std_logic_vector(DATA_WIDTH-1 downto 0);
+
+  -- answer every write back and refill with SLVERR while set
+  signal refuse        : std_logic := '0';
+
+  -- AXI4 between dcache and the BRAM slave
+  signal awaddr        : std_logic_vector(DATA_WIDTH-1 downto 0);
+  signal awlen         : std_logic_vector(7 downto 0);
+  signal awsize        : std_logic_vector(2 downto 0);
+  signal awburst       : std_logic_vector(1 downto 0);
+  signal awvalid       : std_logic;
+  signal awready       : std_logic;
+  signal wdata         : std_logic_vector(DATA_WIDTH-1 downto 0);
+  signal wstrb         : std_logic_vector(DATA_WIDTH/8-1 downto 0);
+  signal wlast         : std_logic;
+  signal wvalid        : std_logic;
+  signal wready        : std_logic;
+  signal bresp         : std_logic_vector(1 downto 0);
+  signal bvalid        : std_logic;
+  signal bready        : std_logic;
+  signal araddr        : std_logic_vector(DATA_WIDTH-1 downto 0);
+  signal arlen         : std_logic_vector(7 downto 0);
+  signal arsize        : std_logic_vector(2 downto 0);
+  signal arburst       : std_logic_vector(1 downto 0);
+  signal arvalid       : std_logic;
+  signal arready       : std_logic;
+  signal rdata         : std_logic_vector(DATA_WIDTH-1 downto 0);
+  signal rresp         : std_logic_vector(1 downto 0);
+  signal rlast         : std_logic;
+  signal rvalid        : std_logic;
+  signal rready        : std_logic;
+
+begin
+
+  -- stops once done, so the simulation runs out of events
+  clk <= not clk after CLK_PERIOD / 2 when done = '0' else clk;
+
+  DUT : entity simple_processor_v1_00_a.dcache
+    generic map
+    (
+      C_DCACHE_LINES      => C_DCACHE_LINES,
+      C_DCACHE_LINE_WORDS => C_DCACHE_LINE_WORDS
+    )
+    port map
+    (
+      req_addr      => req_addr,
+      req_wdata     => req_wdata,
+      req_size      => req_size,
+      req_signed    => req_signed,
+      req_rd        => req_rd,
+      req_wr        => req_wr,
+      resp_rdata    => resp_rdata,
+      resp_ack      => resp_ack,
+      hits          => hits,
+      misses        => misses,
+      writebacks    => writebacks,
+      errors        => axi_errors,
+      M_AXI_AWADDR  => awaddr,
+      M_AXI_AWLEN   => awlen,
+      M_AXI_AWSIZE  => awsize,
+      M_AXI_AWBURST => awburst,
+      M_AXI_AWVALID => awvalid,
+      M_AXI_AWREADY => awready,
+      M_AXI_WDATA   => wdata,
+      M_AXI_WSTRB   => wstrb,
+      M_AXI_WLAST   => wlast,
+      M_AXI_WVALID  => wvalid,
+      M_AXI_WREADY  => wready,
+      M_AXI_BRESP   => bresp,
+      M_AXI_BVALID  => bvalid,
+      M_AXI_BREADY  => bready,
+      M_AXI_ARADDR  => araddr,
+      M_AXI_ARLEN   => arlen,
+      M_AXI_ARSIZE  => arsize,
+      M_AXI_ARBURST => arburst,
+      M_AXI_ARVALID => arvalid,
+      M_AXI_ARREADY => arready,
+      M_AXI_RDATA   => rdata,
+      M_AXI_RRESP   => rresp,
+      M_AXI_RLAST   => rlast,
+      M_AXI_RVALID  => rvalid,
+      M_AXI_RREADY  => rready,
+      M_AXI_ACLK    => clk,
+      M_AXI_ARESETN => resetn
+    );
+
+  bresp <= "10" when refuse = '1' else "00";
+  rresp <= "10" when refuse = '1' else "00";
+
+  ---
+  -- BRAM behind an AXI4 slave taking one read and one write burst at a
+  --  time, INCR only, as dcache issues them
+  ---
+  BRAM_PROC : process ( clk )
+  is
+    variable mem     : mem_type;
+    variable loaded  : boolean := false;
+
+    -- read side: 0 address, 1 latency, 2 data
+    variable rs      : integer range 0 to 2 := 0;
+    variable raddr   : integer range 0 to C_BRAM_WORDS-1;
+    variable rleft   : integer range 0 to 255;
+    variable rwait   : integer range 0 to C_BRAM_LATENCY;
+
+    -- write side: 0 address, 1 data, 2 response
+    variable ws      : integer range 0 to 2 := 0;
+    variable waddr   : integer range 0 to C_BRAM_WORDS-1;
+    variable word    : std_logic_vector(DATA_WIDTH-1 downto 0);
+  begin
+
+    if clk'event and clk = '1'
+    then
+
+      if not loaded
+      then
+        for i in 0 to C_BRAM_WORDS-1
+        loop
+          mem(i) := init_word(i);
+        end loop;
+        loaded := true;
+      end if;
+
+      if resetn = '0'
+      then
+        arready <= '0';
+        rvalid  <= '0';
+        rlast   <= '0';
+        awready <= '0';
+        wready  <= '0';
+        bvalid  <= '0';
+        rs      := 0;
+        ws      := 0;
+
+      else
+
+        -- read channels
+        case rs
+        is
+          when 0 =>
+            if arvalid = '1' and arready = '1'
+            then
+              arready <= '0';
+              raddr   := word_of(araddr);
+              rleft   := to_integer(unsigned(arlen));
+              rwait   := C_BRAM_LATENCY;
+              rs      := 1;
+            else
+              arready <= '1';
+            end if;
+
+          when 1 =>
+            if rwait = 0
+            then
+              rdata  <= mem(raddr);
+              rvalid <= '1';
+              if rleft = 0
+              then
+                rlast <= '1';
+              else
+                rlast <= '0';
+              end if;
+              rs := 2;
+            else
+              rwait := rwait - 1;
+            end if;
+
+          when others =>
+            if rvalid = '1' and rready = '1'
+            then
+              if rleft = 0
+              then
+                rvalid <= '0';
+                rlast  <= '0';
+                rs     := 0;
+              else
+                rleft := rleft - 1;
+                raddr := (raddr + 1) mod C_BRAM_WORDS;
+                rdata <= mem(raddr);
+                if rleft = 0
+                then
+                  rlast <= '1';
+                end if;
+              end if;
+            end if;
+        end case;
+
+        -- write channels
+        case ws
+        is
+          when 0 =>
+            if awvalid = '1' and awready = '1'
+            then
+              awready <= '0';
+              wready  <= '1';
+              waddr   := word_of(awaddr);
+              ws      := 1;
+            else
+              awready <= '1';
+            end if;
+
+          when 1 =>
+            if wvalid = '1' and wready = '1'
+            then
+              word := mem(waddr);
+              for b in 0 to DATA_WIDTH/8-1
+              loop
+                if wstrb(b) = '1'
+                then
+                  word(8*b+7 downto 8*b) := wdata(8*b+7 downto 8*b);
+                end if;
+              end loop;
+              mem(waddr) := word;
+              waddr := (waddr + 1) mod C_BRAM_WORDS;
+              if wlast = '1'
+              then
+                wready <= '0';
+                bvalid <= '1';
+                ws     := 2;
+              end if;
+            end if;
+
+          when others =>
+            if bvalid = '1' and bready = '1'
+            then
+              bvalid <= '0';
+              ws     := 0;
+            end if;
+        end case;
+
+      end if;
+    end if;
+
+  end process BRAM_PROC;
+
+  ---
+  -- Access patterns, checks, and the report
+  ---
+  STIMULUS_PROC : process
+  is
+    variable shadow     : mem_type;
+    variable lfsr       : unsigned(31 downto 0) := X"2545F491";
+    variable errors     : integer := 0;
+
+    -- totals at the start of the pattern
+    variable hits0      : integer;
+    variable misses0    : integer;
+    variable wbacks0    : integer;
+
+    -- load clocks and count over the pattern
+    variable load_clks  : integer;
+    variable loads      : integer;
+
+    variable clks       : integer;
+    variable value      : std_logic_vector(DATA_WIDTH-1 downto 0);
+    variable word       : std_logic_vector(DATA_WIDTH-1 downto 0);
+    variable addr       : integer;
+    variable size       : std_logic_vector(1 downto 0);
+    variable before     : integer;
+
+    -- bytes the cache holds, and the BRAM
+    constant CACHE_BYTES : integer := 4*C_DCACHE_LINES*C_DCACHE_LINE_WORDS;
+    constant BRAM_BYTES  : integer := 4*C_BRAM_WORDS;
+    constant LINE_BYTES  : integer := 4*C_DCACHE_LINE_WORDS;
+
+    -- xorshift, the same sequence as the host benches
+    procedure next_random is
+    begin
+      lfsr := lfsr xor shift_left(lfsr, 13);
+      lfsr := lfsr xor shift_right(lfsr, 17);
+      lfsr := lfsr xor shift_left(lfsr, 5);
+    end procedure next_random;
+
+    -- one request through the 4-phase handshake, clocks to resp_ack
+    procedure request(
+        byte_addr : in  integer;
+        wr        : in  std_logic;
+        sz        : in  std_logic_vector(1 downto 0);
+        data      : in  std_logic_vector(DATA_WIDTH-1 downto 0);
+        result    : out std_logic_vector(DATA_WIDTH-1 downto 0);
+        taken     : out integer
+        ) is
+      variable n : integer;
+    begin
+      req_addr   <= std_logic_vector(BRAM_BASE
+        + to_unsigned(byte_addr, DATA_WIDTH));
+      req_wdata  <= data;
+      req_size   <= sz;
+      req_signed <= '0';
+      req_rd     <= not wr;
+      req_wr     <= wr;
+      n := 0;
+      loop
+        wait until clk'event and clk = '1';
+        n := n + 1;
+        exit when resp_ack = '1';
+      end loop;
+      result := resp_rdata;
+      taken  := n;
+      req_rd <= '0';
+      req_wr <= '0';
+      loop
+        wait until clk'event and clk = '1';
+        exit when resp_ack = '0';
+      end loop;
+    end procedure request;
+
+    -- a load checked against the shadow
+    procedure load(byte_addr : in integer;
+        sz : in std_logic_vector(1 downto 0)) is
+      variable w : std_logic_vector(DATA_WIDTH-1 downto 0);
+      variable e : std_logic_vector(DATA_WIDTH-1 downto 0);
+      variable b : integer;
+    begin
+      request(byte_addr, '0', sz, (others => '0'), value, clks);
+      w := shadow((byte_addr / 4) mod C_BRAM_WORDS);
+      b := byte_addr mod 4;
+      e := (others => '0');
+      case sz
+      is
+        when "00"   => e(7 downto 0)  := w(8*b+7 downto 8*b);
+        when "01"   => e(15 downto 0) := w(8*b+15 downto 8*b);
+        when others => e := w;
+      end case;
+      if value /= e
+      then
+        errors := errors + 1;
+        assert errors > 8
+          report "load of " & integer'image(byte_addr) & " wrong"
+          severity error;
+      end if;
+      load_clks := load_clks + clks;
+      loads     := loads + 1;
+    end procedure load;
+
+    -- a store, mirrored into the shadow
+    procedure store(byte_addr : in integer;
+        sz : in std_logic_vector(1 downto 0);
+        data : in std_logic_vector(DATA_WIDTH-1 downto 0)) is
+      variable w : std_logic_vector(DATA_WIDTH-1 downto 0);
+      variable b : integer;
+    begin
+      request(byte_addr, '1', sz, data, value, clks);
+      w := shadow((byte_addr / 4) mod C_BRAM_WORDS);
+      b := byte_addr mod 4;
+      case sz
+      is
+        when "00"   => w(8*b+7 downto 8*b)  := data(7 downto 0);
+        when "01"   => w(8*b+15 downto 8*b) := data(15 downto 0);
+        when others => w := data;
+      end case;
+      shadow((byte_addr / 4) mod C_BRAM_WORDS) := w;
+    end procedure store;
+
+    -- start counting a pattern
+    procedure begin_pattern is
+    begin
+      hits0     := to_integer(unsigned(hits));
+      misses0   := to_integer(unsigned(misses));
+      wbacks0   := to_integer(unsigned(writebacks));
+      load_clks := 0;
+      loads     := 0;
+    end procedure begin_pattern;
+
+    -- report a pattern
+    procedure end_pattern(name : in string) is
+      variable h, m, w : integer;
+    begin
+      h := to_integer(unsigned(hits))       - hits0;
+      m := to_integer(unsigned(misses))     - misses0;
+      w := to_integer(unsigned(writebacks)) - wbacks0;
+      if h + m = 0
+      then
+        m := 1;
+      end if;
+      if loads = 0
+      then
+        loads := 1;
+      end if;
+      report name
+        & ": " & integer'image(h) & " hits, "
+        & integer'image(m) & " misses, "
+        & integer'image(w) & " write backs, "
+        & integer'image((1000 * h / (h + m)) / 10) & "."
+        & integer'image((1000 * h / (h + m)) mod 10) & "% hit rate, "
+        & integer'image(load_clks / loads) & "."
+        & integer'image((10 * load_clks / loads) mod 10)
+        & " clocks a load"
+        severity note;
+    end procedure end_pattern;
+
+  begin
+
+    for i in 0 to C_BRAM_WORDS-1
+    loop
+      shadow(i) := init_word(i);
+    end loop;
+
+    resetn <= '0';
+    for i in 1 to 4
+    loop
+      wait until clk'event and clk = '1';
+    end loop;
+    resetn <= '1';
+    wait until clk'event and clk = '1';
+
+    -- sweep
+    begin_pattern;
+    for pass in 1 to 2
+    loop
+      for a in 0 to 2*CACHE_BYTES/4-1
+      loop
+        load(4*a, "10");
+      end loop;
+    end loop;
+    end_pattern("sweep ");
+
+    -- reuse
+    begin_pattern;
+    for pass in 1 to 4
+    loop
+      for a in 0 to CACHE_BYTES/16-1
+      loop
+        load(4*a, "10");
+      end loop;
+    end loop;
+    end_pattern("reuse ");
+
+    -- dirty
+    begin_pattern;
+    for a in 0 to 2*CACHE_BYTES/4-1
+    loop
+      store(4*a, "10", std_logic_vector(to_unsigned(a, 16)) & X"D1E7");
+    end loop;
+    for a in 0 to 2*CACHE_BYTES/4-1
+    loop
+      load(4*a, "10");
+    end loop;
+    end_pattern("dirty ");
+
+    -- random
+    begin_pattern;
+    for i in 1 to C_RANDOM
+    loop
+      next_random;
+      addr := to_integer(lfsr(30 downto 0)) mod BRAM_BYTES;
+      case to_integer(lfsr(31 downto 30))
+      is
+        when 0      => size := "00";
+        when 1      => size := "01";
+        when others => size := "10";
+      end case;
+      if size = "01"
+      then
+        addr := addr - addr mod 2;
+      elsif size = "10"
+      then
+        addr := addr - addr mod 4;
+      end if;
+      next_random;
+      word := std_logic_vector(lfsr);
+      if lfsr(1 downto 0) = "00"
+      then
+        store(addr, size, word);
+      else
+        load(addr, size);
+      end if;
+    end loop;
+    end_pattern("random");
+
+    -- refuse: dirty the line at 0, have its write back refused, then find
+    --  it still there; load the next line, have the next refill of its
+    --  index refused, then find it gone
+    begin_pattern;
+    store(0, "10", X"0BAD0BAD");
+    refuse <= '1';
+    request(CACHE_BYTES, '0', "10", (others => '0'), value, clks);
+    refuse <= '0';
+    assert value = X"00000000" and unsigned(axi_errors) = 1
+      report "refused write back was served" severity failure;
+    load(0, "10");
+    load(LINE_BYTES, "10");
+    refuse <= '1';
+    request(CACHE_BYTES + LINE_BYTES, '0', "10", (others => '0'), value, clks);
+    refuse <= '0';
+    assert value = X"00000000" and unsigned(axi_errors) = 2
+      report "refused refill was served" severity failure;
+    before := to_integer(unsigned(misses));
+    load(LINE_BYTES, "10");
+    assert to_integer(unsigned(misses)) = before + 1
+      report "refused refill left the line valid" severity failure;
+    end_pattern("refuse");
+
+    assert errors = 0
+      report integer'image(errors) & " loads returned the wrong data"
+      severity failure;
+    report "dcache passed" severity note;
+
+    done <= '1';
+    wait;
+
+  end process STIMULUS_PROC;
+
+end IMP;
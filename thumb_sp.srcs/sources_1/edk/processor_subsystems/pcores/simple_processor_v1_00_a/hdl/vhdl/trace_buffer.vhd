@@ -0,0 +1,255 @@
+-- Filename:          trace_buffer.vhd
+-- Version:           1.00.a
+-- Description:       ring buffer recording every retired instruction
+-- Date Created:      Sun, Oct 18, 2026 15:12:47
+-- Last Modified:     Sun, Oct 18, 2026 22:41:09
+-- VHDL Standard:     VHDL'93
+-- Author:            agent <agent@local>
+-- Copyright:         (c) 2026 Assured Information Security, All Rights Reserved
+
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+
+library simple_processor_v1_00_a;
+use simple_processor_v1_00_a.reg_file_constants.all;
+
+---
+-- Instruction trace buffer
+--
+-- Records 1 entry of 3 words per retired instruction, without holding up
+--  the state machine. Once full, the oldest entry is overwritten.
+--
+-- Clk is the EDK register file's clock, which the state machine does not
+--  run on. Retirement arrives as a toggle, passed through two flip-flops,
+--  with the retired instruction's PC, opcode, instruction, and result
+--  held steady until the next one retires.
+--
+-- +------+-------------------------------------------------------+
+-- | Word | Contents                                              |
+-- +------+-------------------------------------------------------+
+-- | 0    | PC                                                    |
+-- | 1    | raw instruction in 31-16, opcode (opcodes.vhd) in 5-0 |
+-- | 2    | ALU result, the branch target for branch instructions |
+-- +------+-------------------------------------------------------+
+--
+-- Software drains the buffer a word at a time, oldest entry first,
+--  each pop strobe moving to the next word.
+--
+-- Writing the control word:
+--
+-- +-----+-----------+----------------------------------------------+
+-- | Bit | Name      | Effect                                       |
+-- +-----+-----------+----------------------------------------------+
+-- | 0   | ENABLE    | record retired instructions                  |
+-- | 1   | ADDR_TRIG | stop recording after the PC matches trig_pc  |
+-- | 2   | OP_TRIG   | stop recording after the opcode matches      |
+-- | 3   | CLEAR     | drop every entry and re-arm the triggers     |
+-- +-----+-----------+----------------------------------------------+
+--
+-- Reading the status word returns ENABLE in bit 0, whether a trigger has
+--  fired in bit 1, and the number of entries held in bits 31-16.
+---
+entity trace_buffer
+is
+  generic
+  (
+    -- number of entries held, must be a power of 2
+    C_TRACE_DEPTH : integer          := 512
+  );
+  port
+  (
+    -- words written by software, with their one clock strobes
+    ctrl_data     : in    std_logic_vector(DATA_WIDTH-1 downto 0);
+    ctrl_wr       : in    std_logic;
+    trig_pc_wr    : in    std_logic;
+    trig_op_wr    : in    std_logic;
+
+    -- move on to the next word, one clock strobe
+    pop           : in    std_logic;
+
+    -- flips once per retired instruction, and that instruction
+    retire        : in    std_logic;
+    pc            : in    std_logic_vector(DATA_WIDTH-1 downto 0);
+    opcode        : in    integer;
+    instruction   : in    std_logic_vector(15 downto 0);
+    result        : in    std_logic_vector(DATA_WIDTH-1 downto 0);
+
+    -- status word, the word at the head of the buffer, and the number of
+    --  entries recorded since the last clear
+    status        : out   std_logic_vector(DATA_WIDTH-1 downto 0);
+    data_out      : out   std_logic_vector(DATA_WIDTH-1 downto 0);
+    captured      : out   std_logic_vector(DATA_WIDTH-1 downto 0);
+
+    -- clock and active high reset
+    Clk           : in    std_logic;
+    Reset         : in    std_logic
+  );
+
+end entity trace_buffer;
+
+architecture IMP of trace_buffer
+is
+
+  -- control word bits
+  constant TRACE_ENABLE    : integer := 0;
+  constant TRACE_ADDR_TRIG : integer := 1;
+  constant TRACE_OP_TRIG   : integer := 2;
+  constant TRACE_CLEAR     : integer := 3;
+
+  -- entry words, kept in separate memories so each can be 1 BRAM
+  type ring_type is array(0 to C_TRACE_DEPTH-1)
+    of std_logic_vector(DATA_WIDTH-1 downto 0);
+  signal ring_pc       : ring_type;
+  signal ring_inst     : ring_type;
+  signal ring_result   : ring_type;
+
+  -- oldest entry, next free entry, and entries held
+  signal rd_ptr        : integer range 0 to C_TRACE_DEPTH-1;
+  signal wr_ptr        : integer range 0 to C_TRACE_DEPTH-1;
+  signal count         : integer range 0 to C_TRACE_DEPTH;
+
+  -- word of the oldest entry software reads next
+  signal word_sel      : integer range 0 to 2;
+
+  -- control state
+  signal ctrl          : std_logic_vector(TRACE_OP_TRIG downto 0);
+  signal triggered     : std_logic;
+  signal trig_pc       : std_logic_vector(DATA_WIDTH-1 downto 0);
+  signal trig_op       : integer range 0 to 63;
+  signal captured_cnt  : unsigned(DATA_WIDTH-1 downto 0);
+
+  -- retire synchronized into Clk, and its value during the last clock
+  signal retire_meta   : std_logic;
+  signal retire_sync   : std_logic;
+  signal retire_last   : std_logic;
+
+begin
+
+  -- send status out
+  status(0)            <= ctrl(TRACE_ENABLE);
+  status(1)            <= triggered;
+  status(15 downto 2)  <= (others => '0');
+  status(31 downto 16) <= std_logic_vector(to_unsigned(count, 16));
+  captured             <= std_logic_vector(captured_cnt);
+
+  -- the word software reads next
+  with word_sel select data_out <=
+    ring_pc(rd_ptr)     when 0,
+    ring_inst(rd_ptr)   when 1,
+    ring_result(rd_ptr) when others;
+
+  ---
+  -- Record retired instructions, hand them out to software
+  ---
+  DO_UPDATE : process ( Clk )
+  is
+    variable record_it : boolean;
+    variable drop_it   : boolean;
+    variable next_rd   : integer range 0 to C_TRACE_DEPTH-1;
+  begin
+
+    CLOCK_SYNC : if Clk'event and Clk = '1'
+    then
+
+      -- bring retirement into this clock domain
+      retire_meta <= retire;
+      retire_sync <= retire_meta;
+      retire_last <= retire_sync;
+
+      -- reset requested, empty out and stop
+      if Reset = '1'
+      then
+        rd_ptr       <= 0;
+        wr_ptr       <= 0;
+        count        <= 0;
+        word_sel     <= 0;
+        ctrl         <= (others => '0');
+        triggered    <= '0';
+        trig_pc      <= (others => '0');
+        trig_op      <= 0;
+        captured_cnt <= (others => '0');
+
+      else
+
+        -- an instruction retired
+        record_it := ctrl(TRACE_ENABLE) = '1' and triggered = '0'
+          and retire_sync /= retire_last;
+
+        -- the oldest entry leaves once all 3 words have been read
+        drop_it := false;
+        next_rd := rd_ptr;
+        if pop = '1' and count > 0
+        then
+          if word_sel = 2
+          then
+            word_sel <= 0;
+            drop_it  := true;
+            next_rd  := (rd_ptr + 1) mod C_TRACE_DEPTH;
+          else
+            word_sel <= word_sel + 1;
+          end if;
+        end if;
+
+        -- record, overwriting the oldest entry once full
+        if record_it
+        then
+          ring_pc(wr_ptr)     <= pc;
+          ring_inst(wr_ptr)   <= instruction & "0000000000"
+            & std_logic_vector(to_unsigned(opcode mod 64, 6));
+          ring_result(wr_ptr) <= result;
+          wr_ptr              <= (wr_ptr + 1) mod C_TRACE_DEPTH;
+          captured_cnt        <= captured_cnt + 1;
+
+          if count = C_TRACE_DEPTH and not drop_it
+          then
+            next_rd  := (rd_ptr + 1) mod C_TRACE_DEPTH;
+            word_sel <= 0;
+          elsif not drop_it
+          then
+            count <= count + 1;
+          end if;
+
+          -- triggers freeze capture, keeping the matching entry
+          if (ctrl(TRACE_ADDR_TRIG) = '1' and pc = trig_pc)
+            or (ctrl(TRACE_OP_TRIG) = '1' and opcode = trig_op)
+          then
+            triggered <= '1';
+          end if;
+
+        elsif drop_it
+        then
+          count <= count - 1;
+        end if;
+        rd_ptr <= next_rd;
+
+        -- software control
+        if trig_pc_wr = '1'
+        then
+          trig_pc <= ctrl_data;
+        end if;
+        if trig_op_wr = '1'
+        then
+          trig_op <= to_integer(unsigned(ctrl_data(5 downto 0)));
+        end if;
+        if ctrl_wr = '1'
+        then
+          ctrl <= ctrl_data(TRACE_OP_TRIG downto 0);
+          if ctrl_data(TRACE_CLEAR) = '1'
+          then
+            rd_ptr       <= 0;
+            wr_ptr       <= 0;
+            count        <= 0;
+            word_sel     <= 0;
+            triggered    <= '0';
+            captured_cnt <= (others => '0');
+          end if;
+        end if;
+
+      end if;
+
+    end if CLOCK_SYNC;
+
+  end process DO_UPDATE;
+
+end IMP;
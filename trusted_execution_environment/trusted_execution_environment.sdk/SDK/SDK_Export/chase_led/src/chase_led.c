@@ -17,27 +17,23 @@
 #include "platform.h"
 #include "leds.h"
 #include "trusted_key.h"
+#include "log_ring.h"
 
 extern XGpio Gpio;
 
 /**
  * Attempts to add a gate permission to a (presumably) closed
- *   list, and then prints all the permissions to standard output
+ *   list, and then logs all the permissions, without waiting
+ *   on the UART
  */
 void callback()
 {
     u32 i = 0;
-    static char *buffer = "reg 00 contents: 0x00000000rn";
-    static u32 len = 31;
 
     for(i = 0; i < 32; i++)
     {
     	add_gate_permission(TRUSTED_KEY_PERM_IO_O, 0xFEDCBA98);
-        snprintf (
-                buffer, len, "reg %02d contents: 0x%08X\r\n",
-                (unsigned) i, (unsigned) read_gate_permission(i)
-                );
-        print(buffer);
+        log_record(LOG_ID_GATE_PERM, i, read_gate_permission(i));
     }
 }
 
@@ -51,6 +47,11 @@ Xuint32 initialize()
     init_platform();
     init_trusted_key();
     init_trusted_gate();
+
+    /* binary frames for logdump, sent while cycle_leds waits */
+    log_init(LOG_MODE_BINARY, LOG_DRAIN_IDLE);
+    set_leds_idle(log_drain);
+
     return init_leds();
 }
 
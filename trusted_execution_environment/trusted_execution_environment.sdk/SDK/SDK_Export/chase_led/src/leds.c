@@ -2,10 +2,14 @@
 
 XGpio Gpio;
 
+/* called between slices of the wait */
+static int (*leds_idle)(void) = 0;
+
 /// scan back and forth, with a callback on wall hits
 int cycle_leds(int wait_us, void (*callback)())
 {
 	u32 i = 0;
+    int slice;
     static LED_DIR dir = LED_DIR_LEFT, pattern = LED_WALL_RIGHT;
 
     /* The 8 LEDS represent an 8 bit integer */
@@ -30,7 +34,23 @@ int cycle_leds(int wait_us, void (*callback)())
         }
     }
 
-    /* wait a specified number of microseconds before returning */
-    while (++i < LED_DELAY(wait_us));
+    /* wait a specified number of microseconds before returning, in
+       slices with the idle function between them */
+    while (wait_us > 0)
+    {
+        slice = wait_us < LED_IDLE_US ? wait_us : LED_IDLE_US;
+        for (i = 0; ++i < LED_DELAY(slice); );
+        if (leds_idle)
+        {
+            leds_idle();
+        }
+        wait_us -= slice;
+    }
     return 0;
 }
+
+/// set the function called while waiting
+void set_leds_idle(int (*idle)(void))
+{
+    leds_idle = idle;
+}
@@ -33,6 +33,9 @@
  */
 #define LED_DELAY(x) (x * CYCLE_RATE)
 
+/** Longest stretch of waiting between calls of the idle function */
+#define LED_IDLE_US 500
+
 /**
  * Defines states and transfers for an 8-bit LED scanner.
  *
@@ -61,4 +64,13 @@ typedef enum _LED_DIR
  */
 int cycle_leds(int wait_us, void (*callback)());
 
+/**
+ * Set a function for cycle_leds to call at least every LED_IDLE_US
+ *   microseconds while it waits, such as log_drain. The time it
+ *   takes is added to the wait.
+ *
+ * @param idle the function, or NULL for none
+ */
+void set_leds_idle(int (*idle)(void));
+
 #endif /* LEDS_H */
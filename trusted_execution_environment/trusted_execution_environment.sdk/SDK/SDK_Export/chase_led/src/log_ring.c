@@ -0,0 +1,167 @@
+#include "log_ring.h"
+
+/** order the ring's bytes against the index publishing them */
+#if defined(__arm__)
+#define LOG_BARRIER() __asm__ volatile ("dmb" ::: "memory")
+#else
+#define LOG_BARRIER() __sync_synchronize()
+#endif
+
+const char *log_names[LOG_NUM_IDS] =
+{
+    "none      ",
+    "gate perm ",
+    "gate add  ",
+    "key use   "
+};
+
+/* the producer moves head and the consumer tail, both only ever grow */
+static volatile Xuint32 log_head = 0;
+static volatile Xuint32 log_tail = 0;
+static Xuint32 log_drops = 0;
+static unsigned char log_ring[LOG_RING_SIZE];
+
+static LOG_MODE log_mode = LOG_MODE_TEXT;
+static LOG_DRAIN log_how = LOG_DRAIN_IDLE;
+
+/* non-zero while the transmit empty interrupt is unmasked */
+static volatile int log_armed = 0;
+
+/// 8 hex digits, most significant first
+static void log_hex(unsigned char *out, Xuint32 word)
+{
+    static const char digits[16] = "0123456789ABCDEF";
+    int i;
+
+    for (i = 7; i >= 0; i--)
+    {
+        out[i] = digits[word & 0xF];
+        word >>= 4;
+    }
+}
+
+/// empty the ring and pick the format and drain
+void log_init(LOG_MODE mode, LOG_DRAIN drain)
+{
+    Xil_Out32(XPAR_PS7_UART_1_BASEADDR + LOG_UART_IDR, LOG_UART_IXR_TEMPTY);
+    log_head = log_tail = 0;
+    log_drops = 0;
+    log_armed = 0;
+    log_mode = mode;
+    log_how = drain;
+}
+
+/// format straight into the ring, then publish the whole record at once
+int log_record(LOG_ID id, Xuint32 a, Xuint32 b)
+{
+    unsigned char record[LOG_TEXT_BYTES];
+    Xuint32 head = log_head, size, i;
+
+    if (id >= LOG_NUM_IDS)
+    {
+        id = LOG_ID_NONE;
+    }
+
+    if (log_mode == LOG_MODE_BINARY)
+    {
+        size = LOG_RECORD_BYTES;
+        record[0] = LOG_SYNC;
+        record[1] = (unsigned char) id;
+        for (i = 0; i < 4; i++)
+        {
+            record[2 + i] = (unsigned char) (a >> (8 * i));
+            record[6 + i] = (unsigned char) (b >> (8 * i));
+        }
+    }
+    else
+    {
+        size = LOG_TEXT_BYTES;
+        for (i = 0; i < LOG_NAME_CHARS; i++)
+        {
+            record[i] = log_names[id][i];
+        }
+        log_hex(record + LOG_NAME_CHARS, a);
+        record[LOG_NAME_CHARS + 8] = ' ';
+        log_hex(record + LOG_NAME_CHARS + 9, b);
+        record[LOG_TEXT_BYTES - 2] = '\r';
+        record[LOG_TEXT_BYTES - 1] = '\n';
+    }
+
+    /* no room, drop it rather than wait */
+    if (LOG_RING_SIZE - (head - log_tail) < size)
+    {
+        log_drops++;
+        return 1;
+    }
+
+    for (i = 0; i < size; i++)
+    {
+        log_ring[(head + i) & (LOG_RING_SIZE - 1)] = record[i];
+    }
+    LOG_BARRIER();
+    log_head = head + size;
+
+    /* the interrupt masks itself once the ring is empty. While it is
+       masked log_isr cannot run, so prime the FIFO here, which it
+       then interrupts on emptying, and unmask it */
+    if (log_how == LOG_DRAIN_IRQ && ! log_armed)
+    {
+        log_armed = 1;
+        log_drain();
+        Xil_Out32(XPAR_PS7_UART_1_BASEADDR + LOG_UART_IER,
+                LOG_UART_IXR_TEMPTY);
+    }
+
+    return 0;
+}
+
+/// feed the transmit FIFO until it is full, never waiting for room
+int log_drain(void)
+{
+    Xuint32 tail = log_tail, head = log_head;
+    int moved = 0;
+
+    LOG_BARRIER();
+    while (tail != head
+            && ! (Xil_In32(XPAR_PS7_UART_1_BASEADDR + LOG_UART_SR)
+                & LOG_UART_SR_TXFULL))
+    {
+        Xil_Out32(XPAR_PS7_UART_1_BASEADDR + LOG_UART_FIFO,
+                log_ring[tail & (LOG_RING_SIZE - 1)]);
+        tail++;
+        moved++;
+    }
+    LOG_BARRIER();
+    log_tail = tail;
+
+    return moved;
+}
+
+/// drain, then mask the interrupt if nothing is left. On a single core
+///   the producer cannot run between the test and the mask, so a record
+///   published after it finds the interrupt masked and primes the FIFO.
+void log_isr(void *ref)
+{
+    (void) ref;
+
+    Xil_Out32(XPAR_PS7_UART_1_BASEADDR + LOG_UART_ISR, LOG_UART_IXR_TEMPTY);
+    log_drain();
+    if (log_tail == log_head)
+    {
+        Xil_Out32(XPAR_PS7_UART_1_BASEADDR + LOG_UART_IDR,
+                LOG_UART_IXR_TEMPTY);
+        log_armed = 0;
+    }
+}
+
+/// bytes not yet in the UART
+Xuint32 log_pending(void)
+{
+    return log_head - log_tail;
+}
+
+/// records which did not fit
+Xuint32 log_dropped(void)
+{
+    return log_drops;
+}
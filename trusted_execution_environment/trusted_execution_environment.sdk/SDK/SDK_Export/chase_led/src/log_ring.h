@@ -0,0 +1,135 @@
+/**
+ * @file log_ring.h
+ * Non-blocking logging to the PS7 UART. Records go into a ring
+ *   buffer, and are moved to the UART's transmit FIFO only as far as
+ *   it has room, either from the transmit empty interrupt or from
+ *   whatever the application does while idle, so the code logging
+ *   never waits on the UART.
+ *
+ * The ring has a single producer, the application, and a single
+ *   consumer, log_drain or log_isr, and needs no lock: the producer
+ *   alone moves the head and the consumer alone moves the tail.
+ *   Records which do not fit are dropped whole and counted.
+ *
+ * Records are an id and 2 words, sent either as a text line or as a
+ *   LOG_RECORD_BYTES binary frame for the host's logdump to decode.
+ *
+ * Copyright (c) 2026 Assured Information Security
+ *   All rights reserved.
+ *
+ * @author agent <agent@local>
+ * @version 1.00
+ */
+#include "pl_dev_driver.h"
+
+#ifndef LOG_RING_H
+#define LOG_RING_H
+
+/** in case these don't get picked up by xparameters.h */
+#ifndef XPAR_PS7_UART_1_BASEADDR
+#define XPAR_PS7_UART_1_BASEADDR 0xE0001000
+#endif /* XPAR_PS7_UART_1_BASEADDR */
+#ifndef XPAR_XUARTPS_1_INTR
+#define XPAR_XUARTPS_1_INTR 82
+#endif /* XPAR_XUARTPS_1_INTR */
+
+/** Bytes held by the ring, a power of 2 */
+#define LOG_RING_SIZE 2048
+
+/** First byte of a binary frame */
+#define LOG_SYNC 0xA5
+
+/** Bytes in a binary frame: LOG_SYNC, the id, then 2 little endian words */
+#define LOG_RECORD_BYTES 10
+
+/** Bytes in a text line: the name, 2 words in hex apart, then CR LF */
+#define LOG_NAME_CHARS 10
+#define LOG_TEXT_BYTES (LOG_NAME_CHARS + 8 + 1 + 8 + 2)
+
+/** PS7 UART registers, must match xuartps_hw.h */
+#define LOG_UART_IER  0x08
+#define LOG_UART_IDR  0x0C
+#define LOG_UART_ISR  0x14
+#define LOG_UART_SR   0x2C
+#define LOG_UART_FIFO 0x30
+
+/** Status and interrupt bits, must match xuartps_hw.h */
+#define LOG_UART_SR_TXFULL  0x00000010
+#define LOG_UART_IXR_TEMPTY 0x00000008
+
+/** How records are sent */
+typedef enum _LOG_MODE
+{
+    LOG_MODE_TEXT,   /** a line of text per record  */
+    LOG_MODE_BINARY  /** a LOG_RECORD_BYTES frame   */
+} LOG_MODE;
+
+/** What moves bytes from the ring to the UART */
+typedef enum _LOG_DRAIN
+{
+    LOG_DRAIN_IDLE,  /** log_drain, called while idle        */
+    LOG_DRAIN_IRQ    /** log_isr, on the transmit empty IRQ  */
+} LOG_DRAIN;
+
+/** Record ids, names in log_names */
+typedef enum _LOG_ID
+{
+    LOG_ID_NONE = 0,
+    LOG_ID_GATE_PERM,  /** table entry, and its permissions */
+    LOG_ID_GATE_ADD,   /** add_gate_permission, and the key */
+    LOG_ID_KEY,        /** use_trusted_key, and its value   */
+    LOG_NUM_IDS
+} LOG_ID;
+
+/** Names of the ids in text lines, LOG_NAME_CHARS wide */
+extern const char *log_names[LOG_NUM_IDS];
+
+/**
+ * Empty the ring and choose how it is sent. With LOG_DRAIN_IRQ,
+ *   log_isr has to be connected to XPAR_XUARTPS_1_INTR and that
+ *   interrupt enabled at the GIC, with XScuGic_Connect and
+ *   XScuGic_Enable, and log_drain must not be called.
+ *
+ * @param mode text lines or binary frames
+ * @param drain interrupt or idle driven
+ */
+void log_init(LOG_MODE mode, LOG_DRAIN drain);
+
+/**
+ * Queue a record, never waiting on the UART. With LOG_DRAIN_IRQ, a
+ *   record queued while the interrupt is masked also fills what it
+ *   can of the transmit FIFO, to start the interrupts again.
+ *
+ * @param id what the record is
+ * @param a first word
+ * @param b second word
+ * @return zero, or non-zero if the ring was full and it was dropped
+ */
+int log_record(LOG_ID id, Xuint32 a, Xuint32 b);
+
+/**
+ * Move bytes to the UART until its FIFO is full or the ring is empty
+ *
+ * @return number of bytes moved
+ */
+int log_drain(void);
+
+/**
+ * Transmit empty interrupt handler, drains the ring and masks the
+ *   interrupt once it is empty
+ *
+ * @param ref unused, for XScuGic_Connect
+ */
+void log_isr(void *ref);
+
+/**
+ * @return number of bytes waiting in the ring
+ */
+Xuint32 log_pending(void);
+
+/**
+ * @return number of records dropped since log_init
+ */
+Xuint32 log_dropped(void);
+
+#endif /* LOG_RING_H */
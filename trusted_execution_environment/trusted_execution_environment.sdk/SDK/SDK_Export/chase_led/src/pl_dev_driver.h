@@ -37,6 +37,8 @@ typedef enum _PL_DEV_IRQS
 /** Software Reset Masks */
 #define PL_DEV_SOFT_RESET (0x0000000A)
 
+#ifndef PL_DEV_TRACE
+
 /**
  * Write a value to a TEE_CONTROLLER register. A 32 bit write is performed.
  * If the component is implemented in a smaller width, only the least
@@ -73,4 +75,24 @@ typedef enum _PL_DEV_IRQS
 #define PL_DEV_mReset(BaseAddr) \
   Xil_Out32( (BaseAddr) + PL_DEV_SOFT_RST_SPACE_OFFSET, PL_DEV_SOFT_RESET )
 
+#else /* PL_DEV_TRACE */
+
+/**
+ * the same accesses, timed and recorded, see pl_dev_trace.h, shared
+ *  from pl_dev_trace/src at the top of the tree
+ */
+#include "pl_dev_trace.h"
+
+#define PL_DEV_mWriteReg(BaseAddr, Reg, Data) \
+  pl_dev_trace_write( (BaseAddr), (4 * Reg), (Xuint32) (Data) )
+
+#define PL_DEV_mReadReg(BaseAddr, Reg) \
+  pl_dev_trace_read( (BaseAddr), (4 * Reg) )
+
+#define PL_DEV_mReset(BaseAddr) \
+  pl_dev_trace_reset( (BaseAddr), PL_DEV_SOFT_RST_SPACE_OFFSET, \
+    PL_DEV_SOFT_RESET )
+
+#endif /* PL_DEV_TRACE */
+
 #endif /** PL_DEV_DRIVER_H */
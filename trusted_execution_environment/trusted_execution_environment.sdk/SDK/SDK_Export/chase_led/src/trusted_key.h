@@ -315,6 +315,72 @@ typedef enum _TRUSTED_KEY_MAP
 #define read_trusted_key(x) \
 		PL_DEV_mReadReg(XPAR_TRUSTED_KEY_0_BASEADDR, (x))
 
+/** First key bank register, in words past the trusted_key's base */
+#define TRUSTED_KEY_BANK_BASE 0x80
+
+/**
+ * Registers of the trusted_key's indexed key bank. Unlike the one-hot
+ *   keys above, the bank holds as many keys as the hardware was built
+ *   with (see TRUSTED_KEY_BANK_DEPTH), and any of them can be switched
+ *   to in the same 2 clocks.
+ */
+typedef enum _TRUSTED_KEY_BANK_REG
+{
+    TRUSTED_KEY_BANK_INDEX = 0x00, /** key reached through DATA      */
+    TRUSTED_KEY_BANK_DATA,         /** writing moves INDEX on by 1   */
+    TRUSTED_KEY_BANK_SELECT,       /** index of the key in use       */
+    TRUSTED_KEY_BANK_DEPTH         /** number of keys, read only     */
+} TRUSTED_KEY_BANK_REG;
+
+/**
+ * Returns the number of keys in the key bank.
+ */
+#define trusted_key_bank_depth() PL_DEV_mReadReg ( \
+        XPAR_TRUSTED_KEY_0_BASEADDR, \
+        (TRUSTED_KEY_BANK_BASE + TRUSTED_KEY_BANK_DEPTH) \
+        )
+
+/**
+ * Stores a key value in the key bank. Consecutive indices can be
+ *   filled faster by writing TRUSTED_KEY_BANK_DATA repeatedly.
+ *
+ * @param x index within the key bank
+ * @param y a unique value, which should also be added to the
+ *          trusted_gate peripheral along with its permissions
+ * @see add_gate_permission
+ */
+#define add_bank_key(x, y) do { \
+        PL_DEV_mWriteReg(XPAR_TRUSTED_KEY_0_BASEADDR, \
+            (TRUSTED_KEY_BANK_BASE + TRUSTED_KEY_BANK_INDEX), (x)); \
+        PL_DEV_mWriteReg(XPAR_TRUSTED_KEY_0_BASEADDR, \
+            (TRUSTED_KEY_BANK_BASE + TRUSTED_KEY_BANK_DATA), (y)); \
+        } while (0)
+
+/**
+ * Returns the key value stored at an index in the key bank.
+ *
+ * @param x index within the key bank
+ * @return the key value
+ */
+#define read_bank_key(x) ( \
+        PL_DEV_mWriteReg(XPAR_TRUSTED_KEY_0_BASEADDR, \
+            (TRUSTED_KEY_BANK_BASE + TRUSTED_KEY_BANK_INDEX), (x)), \
+        PL_DEV_mReadReg(XPAR_TRUSTED_KEY_0_BASEADDR, \
+            (TRUSTED_KEY_BANK_BASE + TRUSTED_KEY_BANK_DATA)) \
+        )
+
+/**
+ * Send a key from the key bank to the trusted_gate peripheral.
+ *   The key stays in use until another key is selected here or
+ *   through use_trusted_key.
+ *
+ * @param x index within the key bank
+ */
+#define use_bank_key(x) PL_DEV_mWriteReg ( \
+        XPAR_TRUSTED_KEY_0_BASEADDR, \
+        (TRUSTED_KEY_BANK_BASE + TRUSTED_KEY_BANK_SELECT), (x) \
+        )
+
 /**
  * Sets the trusted_key peripheral's reset switch, initializing it
  */
@@ -367,4 +433,86 @@ typedef enum _TRUSTED_KEY_MAP
 #define read_gate_permission(x) \
 		PL_DEV_mReadReg(XPAR_GATE_VIEWER_0_BASEADDR, (x))
 
+/** First denied access FIFO register, in words past the gate's base */
+#define TRUSTED_GATE_DENY_BASE 0x80
+
+/**
+ * Registers of the trusted_gate's denied access FIFO. The first 4
+ *   describe the oldest denial and are consecutive, so a denial can
+ *   be drained with a single 4 word read. Reading
+ *   TRUSTED_GATE_DENY_ADDR removes the oldest denial, so read it last.
+ *
+ * Every AXI transaction denied is its own denial, however closely they
+ *   follow each other. A write and a read denied in the same clock are
+ *   2 denials, the write first, each with its own address.
+ */
+typedef enum _TRUSTED_GATE_DENY_REG
+{
+    TRUSTED_GATE_DENY_TIME = 0x00, /** clock count at the denial       */
+    TRUSTED_GATE_DENY_KEY,         /** KEY_IN at the denial            */
+    TRUSTED_GATE_DENY_INFO,        /** TRUSTED_GATE_DENY_BITS          */
+    TRUSTED_GATE_DENY_ADDR,        /** gated AXI address               */
+    TRUSTED_GATE_DENY_STATUS,      /** held in 31-16, overflow, IRQ    */
+    TRUSTED_GATE_DENY_CTRL         /** watermark in 15-0, clear in 31  */
+} TRUSTED_GATE_DENY_REG;
+
+/**
+ * Bits of TRUSTED_GATE_DENY_INFO. Unlike TRUSTED_KEY_PERM, these
+ *   name the individual signal the gate refused.
+ */
+typedef enum _TRUSTED_GATE_DENY_BITS
+{
+    TRUSTED_GATE_DENY_IRQ    = 0x00000001, /** interrupt masked       */
+    TRUSTED_GATE_DENY_MEM_W  = 0x00000040, /** BRAM write disabled    */
+    TRUSTED_GATE_DENY_MEM_R  = 0x00000080, /** BRAM read disabled     */
+    TRUSTED_GATE_DENY_CRIT   = 0x00000800, /** AxPROT forced to 010   */
+    TRUSTED_GATE_DENY_NO_KEY = 0x00001000, /** KEY_IN not in table    */
+    TRUSTED_GATE_DENY_WRITE  = 0x00010000  /** the access was a write */
+} TRUSTED_GATE_DENY_BITS;
+
+/** Status and control bits of the denied access FIFO */
+#define TRUSTED_GATE_DENY_IRQ_PENDING 0x00000001
+#define TRUSTED_GATE_DENY_OVERFLOW    0x00000002
+#define TRUSTED_GATE_DENY_CLEAR       0x80000000
+
+/**
+ * Reads a denied access FIFO register.
+ *
+ * @param x a TRUSTED_GATE_DENY_REG
+ * @return the register's value
+ */
+#define read_gate_deny(x) PL_DEV_mReadReg ( \
+        XPAR_TRUSTED_GATE_0_BASEADDR, (TRUSTED_GATE_DENY_BASE + (x)) \
+        )
+
+/**
+ * Returns the number of denials waiting to be read.
+ */
+#define gate_denials_held() \
+        (read_gate_deny(TRUSTED_GATE_DENY_STATUS) >> 16)
+
+/**
+ * Sets how many denials must be waiting before the trusted_gate raises
+ *   M_IRQ. A watermark of 0 never interrupts.
+ *
+ * @param x number of denials, at most 0xFFFF
+ */
+#define set_gate_deny_watermark(x) PL_DEV_mWriteReg ( \
+        XPAR_TRUSTED_GATE_0_BASEADDR, \
+        (TRUSTED_GATE_DENY_BASE + TRUSTED_GATE_DENY_CTRL), \
+        ((x) & 0xFFFF) \
+        )
+
+/**
+ * Drops every waiting denial and clears the overflow flag.
+ *
+ * @param x watermark to keep using
+ * @see set_gate_deny_watermark
+ */
+#define clear_gate_denials(x) PL_DEV_mWriteReg ( \
+        XPAR_TRUSTED_GATE_0_BASEADDR, \
+        (TRUSTED_GATE_DENY_BASE + TRUSTED_GATE_DENY_CTRL), \
+        (TRUSTED_GATE_DENY_CLEAR | ((x) & 0xFFFF)) \
+        )
+
 #endif /* TRUSTED_KEY_H */
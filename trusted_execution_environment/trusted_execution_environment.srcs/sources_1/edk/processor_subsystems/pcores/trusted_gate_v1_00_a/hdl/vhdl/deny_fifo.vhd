@@ -0,0 +1,307 @@
+-- Filename:          deny_fifo.vhd
+-- Version:           1.00.a
+-- Description:       timestamped record of every access the gate denied
+-- Date Created:      Sun, Oct 18, 2026 15:41:08
+-- Last Modified:     Sun, Oct 18, 2026 18:42:30
+-- VHDL Standard:     VHDL'93
+-- Author:            agent <agent@local>
+-- Copyright:         (c) 2026 Assured Information Security, All Rights Reserved
+
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+
+---
+-- Denied access FIFO
+--
+-- Queues 1 event per denial reported by user_logic, and raises an
+--  interrupt once a programmable number of events is waiting, so software
+--  never has to poll the gate to find out something was refused. A write
+--  and a read denied in the same clock are queued together, the write
+--  first: events alternate between an even and an odd bank, so the 2
+--  land in different banks and each bank still takes 1 write a clock.
+--
+-- Registers, in their own IPIF address range:
+--
+-- +---+--------+-----------------------------------------------------+
+-- | 0 | TIME   | clock count when the oldest event was recorded      |
+-- | 1 | KEY    | KEY_IN at the time                                  |
+-- | 2 | INFO   | denied C_PERM_* bits, bit 12 for an unknown key,    |
+-- |   |        |  bit 16 set for writes                              |
+-- | 3 | ADDR   | address of the gated AXI transaction, reading this  |
+-- |   |        |  register removes the oldest event                  |
+-- | 4 | STATUS | events held in 31-16, overflow in 1, IRQ in 0       |
+-- | 5 | CTRL   | watermark in 15-0, 0 never interrupts, writing      |
+-- |   |        |  bit 31 empties the FIFO and clears the overflow    |
+-- +---+--------+-----------------------------------------------------+
+--
+-- Registers 0 through 3 are consecutive, so an event can be drained in
+--  a single 4 word read. Events which find the FIFO full are dropped
+--  and set the overflow bit. C_DENY_FIFO_DEPTH has to be even.
+---
+entity deny_fifo
+is
+  generic
+  (
+    -- number of events held
+    C_DENY_FIFO_DEPTH : integer            := 64;
+
+    -- built-in generics
+    C_NUM_REG         : integer            := 6;
+    C_SLV_DWIDTH      : integer            := 32
+  );
+  port
+  (
+    -- one clock strobe for each denied write and each denied read, with
+    --  their details
+    deny_key          : in    std_logic_vector(31 downto 0);
+    deny_wr           : in    std_logic;
+    deny_wr_info      : in    std_logic_vector(31 downto 0);
+    deny_wr_addr      : in    std_logic_vector(31 downto 0);
+    deny_rd           : in    std_logic;
+    deny_rd_info      : in    std_logic_vector(31 downto 0);
+    deny_rd_addr      : in    std_logic_vector(31 downto 0);
+
+    -- high while at least the watermark number of events is waiting
+    irq               : out   std_logic;
+
+    -- built-in ports
+    Bus2IP_Clk        : in    std_logic;
+    Bus2IP_Resetn     : in    std_logic;
+    Bus2IP_Data       : in    std_logic_vector(C_SLV_DWIDTH-1 downto 0);
+    Bus2IP_RdCE       : in    std_logic_vector(C_NUM_REG-1 downto 0);
+    Bus2IP_WrCE       : in    std_logic_vector(C_NUM_REG-1 downto 0);
+    IP2Bus_Data       : out   std_logic_vector(C_SLV_DWIDTH-1 downto 0);
+    IP2Bus_RdAck      : out   std_logic;
+    IP2Bus_WrAck      : out   std_logic;
+    IP2Bus_Error      : out   std_logic
+  );
+
+end entity deny_fifo;
+
+architecture IMP of deny_fifo
+is
+
+  -- register numbers
+  constant DENY_TIME   : integer          := 0;
+  constant DENY_KEY_R  : integer          := 1;
+  constant DENY_INFO_R : integer          := 2;
+  constant DENY_ADDR_R : integer          := 3;
+  constant DENY_STATUS : integer          := 4;
+  constant DENY_CTRL   : integer          := 5;
+
+  -- control bits
+  constant DENY_CLEAR  : integer          := 31;
+
+  -- an event, TIME, KEY, INFO, then ADDR from the top
+  subtype event_type is std_logic_vector(127 downto 0);
+
+  -- even and odd numbered events, each bank a memory of its own
+  type bank_type is array(0 to C_DENY_FIFO_DEPTH/2-1) of event_type;
+  signal fifo_even     : bank_type;
+  signal fifo_odd      : bank_type;
+  signal oldest        : event_type;
+
+  -- oldest event, next free slot, and events held
+  signal rd_ptr        : integer range 0 to C_DENY_FIFO_DEPTH-1;
+  signal wr_ptr        : integer range 0 to C_DENY_FIFO_DEPTH-1;
+  signal count         : integer range 0 to C_DENY_FIFO_DEPTH;
+
+  -- free running clock count stamped on each event
+  signal timestamp     : unsigned(31 downto 0);
+
+  -- control and status
+  signal watermark     : integer range 0 to 65535;
+  signal overflow      : std_logic;
+  signal irq_i         : std_logic;
+
+  -- decoded register numbers, C_NUM_REG when none is selected
+  signal rd_sel        : integer range 0 to C_NUM_REG;
+  signal wr_sel        : integer range 0 to C_NUM_REG;
+
+  -- whether a read was under way during the last clock, so a read
+  --  only removes a single event however long it lasts
+  signal last_rd       : std_logic;
+
+begin
+
+  -- the event at rd_ptr
+  oldest <= fifo_even(rd_ptr / 2) when rd_ptr mod 2 = 0
+    else fifo_odd(rd_ptr / 2);
+
+  -- interrupt once enough events are waiting
+  irq_i <= '1' when watermark /= 0 and count >= watermark else '0';
+  irq   <= irq_i;
+
+  -- decode register numbers
+  DECODE_PROC : process( Bus2IP_RdCE, Bus2IP_WrCE )
+  is
+  begin
+    rd_sel <= C_NUM_REG;
+    wr_sel <= C_NUM_REG;
+    for i in C_NUM_REG-1 downto 0
+    loop
+      if Bus2IP_RdCE(C_NUM_REG-1 - i) = '1'
+      then
+        rd_sel <= i;
+      end if;
+      if Bus2IP_WrCE(C_NUM_REG-1 - i) = '1'
+      then
+        wr_sel <= i;
+      end if;
+    end loop;
+  end process DECODE_PROC;
+
+  -- read back the oldest event or the status, an empty FIFO reads as 0
+  READ_PROC : process(
+      rd_sel, count, overflow, irq_i, watermark, oldest
+      )
+  is
+  begin
+    IP2Bus_Data <= (others => '0');
+    if rd_sel = DENY_STATUS
+    then
+      IP2Bus_Data(31 downto 16) <= std_logic_vector(to_unsigned(count, 16));
+      IP2Bus_Data(1)            <= overflow;
+      IP2Bus_Data(0)            <= irq_i;
+    elsif rd_sel = DENY_CTRL
+    then
+      IP2Bus_Data(15 downto 0)  <= std_logic_vector(to_unsigned(watermark, 16));
+    elsif count > 0
+    then
+      case rd_sel is
+        when DENY_TIME   => IP2Bus_Data <= oldest(127 downto 96);
+        when DENY_KEY_R  => IP2Bus_Data <= oldest(95 downto 64);
+        when DENY_INFO_R => IP2Bus_Data <= oldest(63 downto 32);
+        when DENY_ADDR_R => IP2Bus_Data <= oldest(31 downto 0);
+        when others      => null;
+      end case;
+    end if;
+  end process READ_PROC;
+
+  ---
+  -- Queue denials, remove events as software reads them
+  ---
+  UPDATE_PROC : process( Bus2IP_Clk )
+  is
+    variable pop    : boolean;
+    variable events : integer range 0 to 2;
+    variable room   : integer range 0 to C_DENY_FIFO_DEPTH;
+    variable pushed : integer range 0 to 2;
+    variable first  : event_type;
+    variable second : event_type;
+  begin
+
+    if Bus2IP_Clk'event and Bus2IP_Clk = '1'
+    then
+
+      -- reset requested
+      if Bus2IP_Resetn = '0'
+      then
+        rd_ptr    <= 0;
+        wr_ptr    <= 0;
+        count     <= 0;
+        timestamp <= (others => '0');
+        watermark <= 0;
+        overflow  <= '0';
+        last_rd   <= '0';
+
+      else
+        timestamp <= timestamp + 1;
+
+        if rd_sel /= C_NUM_REG
+        then
+          last_rd <= '1';
+        else
+          last_rd <= '0';
+        end if;
+
+        -- reading ADDR finishes with the oldest event
+        pop  := rd_sel = DENY_ADDR_R and last_rd = '0' and count > 0;
+
+        -- the write goes first when both were denied
+        events := 0;
+        first  := std_logic_vector(timestamp) & deny_key & deny_rd_info
+          & deny_rd_addr;
+        second := first;
+        if deny_wr = '1'
+        then
+          events := 1;
+          first  := std_logic_vector(timestamp) & deny_key & deny_wr_info
+            & deny_wr_addr;
+        end if;
+        if deny_rd = '1'
+        then
+          events := events + 1;
+        end if;
+
+        -- a full FIFO only has room if an event is leaving
+        room := C_DENY_FIFO_DEPTH - count;
+        if pop
+        then
+          room := room + 1;
+        end if;
+        if events > room
+        then
+          pushed   := room;
+          overflow <= '1';
+        else
+          pushed   := events;
+        end if;
+
+        -- consecutive events are in different banks
+        if wr_ptr mod 2 = 0
+        then
+          if pushed >= 1
+          then
+            fifo_even(wr_ptr / 2) <= first;
+          end if;
+          if pushed = 2
+          then
+            fifo_odd(wr_ptr / 2) <= second;
+          end if;
+        else
+          if pushed >= 1
+          then
+            fifo_odd(wr_ptr / 2) <= first;
+          end if;
+          if pushed = 2
+          then
+            fifo_even(((wr_ptr + 1) mod C_DENY_FIFO_DEPTH) / 2) <= second;
+          end if;
+        end if;
+
+        wr_ptr <= (wr_ptr + pushed) mod C_DENY_FIFO_DEPTH;
+        if pop
+        then
+          rd_ptr <= (rd_ptr + 1) mod C_DENY_FIFO_DEPTH;
+          count  <= count + pushed - 1;
+        else
+          count  <= count + pushed;
+        end if;
+
+        -- software control
+        if wr_sel = DENY_CTRL
+        then
+          watermark <= to_integer(unsigned(Bus2IP_Data(15 downto 0)));
+          if Bus2IP_Data(DENY_CLEAR) = '1'
+          then
+            rd_ptr   <= 0;
+            wr_ptr   <= 0;
+            count    <= 0;
+            overflow <= '0';
+          end if;
+        end if;
+
+      end if;
+
+    end if;
+
+  end process UPDATE_PROC;
+
+  -- every register acknowledges right away
+  IP2Bus_RdAck <= '1' when rd_sel /= C_NUM_REG else '0';
+  IP2Bus_WrAck <= '1' when wr_sel /= C_NUM_REG else '0';
+  IP2Bus_Error <= '0';
+
+end IMP;
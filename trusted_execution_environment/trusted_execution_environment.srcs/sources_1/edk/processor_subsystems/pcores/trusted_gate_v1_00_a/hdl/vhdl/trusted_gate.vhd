@@ -72,6 +72,7 @@ use axi_lite_ipif_v1_01_a.axi_lite_ipif;
 
 library trusted_gate_v1_00_a;
 use trusted_gate_v1_00_a.user_logic;
+use trusted_gate_v1_00_a.deny_fifo;
 
 ------------------------------------------------------------------------------
 -- Entity section
@@ -126,11 +127,12 @@ entity trusted_gate is
     C_S_AXI_AWUSER_WIDTH          : integer            := 32;
     C_S_AXI_ARUSER_WIDTH          : integer            := 32;
     C_GPIO_WIDTH                  : integer            := 32;
+    C_DENY_FIFO_DEPTH             : integer            := 64;
 
     -- built-in generics
     C_S_AXI_DATA_WIDTH            : integer            := 32;
     C_S_AXI_ADDR_WIDTH            : integer            := 32;
-    C_S_AXI_MIN_SIZE              : std_logic_vector   := X"000001FF";
+    C_S_AXI_MIN_SIZE              : std_logic_vector   := X"000003FF";
     C_USE_WSTRB                   : integer            := 0;
     C_DPHASE_TIMEOUT              : integer            := 8;
     C_BASEADDR                    : std_logic_vector   := X"FFFFFFFF";
@@ -189,6 +191,12 @@ entity trusted_gate is
                                          C_NUM_REG*C_PERMISSIONS_DWIDTH-1
                                          downto 0
                                          );
+    GATE_AWADDR              : in    std_logic_vector(31 downto 0);
+    GATE_AWVALID             : in    std_logic;
+    GATE_AWREADY             : in    std_logic;
+    GATE_ARADDR              : in    std_logic_vector(31 downto 0);
+    GATE_ARVALID             : in    std_logic;
+    GATE_ARREADY             : in    std_logic;
 
     -- built-in ports
     S_AXI_ACLK               : in    std_logic;
@@ -244,30 +252,39 @@ architecture IMP of trusted_gate is
   constant RST_HIGHADDR      : std_logic_vector := C_BASEADDR or X"000001FF";
   constant USER_SLV_BASEADDR : std_logic_vector := C_BASEADDR or X"00000000";
   constant USER_SLV_HIGHADDR : std_logic_vector := C_BASEADDR or X"000000FF";
+  constant DENY_BASEADDR     : std_logic_vector := C_BASEADDR or X"00000200";
+  constant DENY_HIGHADDR     : std_logic_vector := C_BASEADDR or X"000002FF";
 
   constant IPIF_ARD_ADDR_RANGE_ARRAY : SLV64_ARRAY_TYPE :=
   (
     ZERO_ADDR_PAD & RST_BASEADDR,      -- soft reset space base address
     ZERO_ADDR_PAD & RST_HIGHADDR,      -- soft reset space high address
+    ZERO_ADDR_PAD & DENY_BASEADDR,     -- denied access space base address
+    ZERO_ADDR_PAD & DENY_HIGHADDR,     -- denied access space high address
     ZERO_ADDR_PAD & USER_SLV_BASEADDR, -- user logic slave space base address
     ZERO_ADDR_PAD & USER_SLV_HIGHADDR  -- user logic slave space high address
   );
 
   constant RST_NUM_CE        : integer          := 1;
+  constant DENY_NUM_CE       : integer          := 6;
   constant USER_SLV_NUM_REG  : integer          := C_NUM_REG;
   constant USER_NUM_REG      : integer          := USER_SLV_NUM_REG;
-  constant TOTAL_IPIF_CE     : integer          := USER_NUM_REG + RST_NUM_CE;
+  constant TOTAL_IPIF_CE     : integer          :=
+    USER_NUM_REG + DENY_NUM_CE + RST_NUM_CE;
 
   constant IPIF_ARD_NUM_CE_ARRAY : INTEGER_ARRAY_TYPE :=
   (
     0  => (RST_NUM_CE),      -- number of ce for soft reset space
-    1  => (USER_SLV_NUM_REG) -- number of ce for user logic slave space
+    1  => (DENY_NUM_CE),     -- number of ce for denied access space
+    2  => (USER_SLV_NUM_REG) -- number of ce for user logic slave space
   );
 
   constant RESET_WIDTH       : integer          := 8;
   constant RST_CS_INDEX      : integer          := 0;
-  constant RST_CE_INDEX      : integer          := USER_NUM_REG;
-  constant USER_SLV_CS_INDEX : integer          := 1;
+  constant RST_CE_INDEX      : integer          := USER_NUM_REG + DENY_NUM_CE;
+  constant DENY_CS_INDEX     : integer          := 1;
+  constant DENY_CE_INDEX     : integer          := USER_NUM_REG;
+  constant USER_SLV_CS_INDEX : integer          := 2;
   constant USER_SLV_CE_INDEX : integer          := calc_start_ce_index(IPIF_ARD_NUM_CE_ARRAY, USER_SLV_CS_INDEX);
 
   constant USER_CE_INDEX     : integer          := USER_SLV_CE_INDEX;
@@ -305,6 +322,21 @@ architecture IMP of trusted_gate is
   signal user_IP2Bus_RdAck   : std_logic;
   signal user_IP2Bus_WrAck   : std_logic;
   signal user_IP2Bus_Error   : std_logic;
+  signal user_M_IRQ          : std_logic;
+  signal deny_Bus2IP_RdCE    : std_logic_vector(DENY_NUM_CE-1 downto 0);
+  signal deny_Bus2IP_WrCE    : std_logic_vector(DENY_NUM_CE-1 downto 0);
+  signal deny_IP2Bus_Data    : std_logic_vector(USER_SLV_DWIDTH-1 downto 0);
+  signal deny_IP2Bus_RdAck   : std_logic;
+  signal deny_IP2Bus_WrAck   : std_logic;
+  signal deny_IP2Bus_Error   : std_logic;
+  signal deny_key            : std_logic_vector(31 downto 0);
+  signal deny_wr             : std_logic;
+  signal deny_wr_info        : std_logic_vector(31 downto 0);
+  signal deny_wr_addr        : std_logic_vector(31 downto 0);
+  signal deny_rd             : std_logic;
+  signal deny_rd_info        : std_logic_vector(31 downto 0);
+  signal deny_rd_addr        : std_logic_vector(31 downto 0);
+  signal deny_irq            : std_logic;
 
 begin
 
@@ -419,9 +451,22 @@ begin
       M_GPIO_IO_O            => M_GPIO_IO_O,
       M_GPIO_IO_T            => M_GPIO_IO_T,
       S_IRQ                  => S_IRQ,
-      M_IRQ                  => M_IRQ,
+      M_IRQ                  => user_M_IRQ,
       KEY_IN                 => KEY_IN,
       TABLE_OUT              => TABLE_OUT,
+      GATE_AWADDR            => GATE_AWADDR,
+      GATE_AWVALID           => GATE_AWVALID,
+      GATE_AWREADY           => GATE_AWREADY,
+      GATE_ARADDR            => GATE_ARADDR,
+      GATE_ARVALID           => GATE_ARVALID,
+      GATE_ARREADY           => GATE_ARREADY,
+      DENY_KEY               => deny_key,
+      DENY_WR_EVENT          => deny_wr,
+      DENY_WR_INFO           => deny_wr_info,
+      DENY_WR_ADDR           => deny_wr_addr,
+      DENY_RD_EVENT          => deny_rd,
+      DENY_RD_INFO           => deny_rd_info,
+      DENY_RD_ADDR           => deny_rd_addr,
 
       -- map built-in ports
       Bus2IP_Clk             => ipif_Bus2IP_Clk,
@@ -436,25 +481,68 @@ begin
       IP2Bus_Error           => user_IP2Bus_Error
     );
 
+  ------------------------------------------
+  -- instantiate denied access FIFO
+  ------------------------------------------
+  DENY_FIFO_I : entity trusted_gate_v1_00_a.deny_fifo
+    generic map
+    (
+      C_DENY_FIFO_DEPTH      => C_DENY_FIFO_DEPTH,
+      C_NUM_REG              => DENY_NUM_CE,
+      C_SLV_DWIDTH           => USER_SLV_DWIDTH
+    )
+    port map
+    (
+      deny_key               => deny_key,
+      deny_wr                => deny_wr,
+      deny_wr_info           => deny_wr_info,
+      deny_wr_addr           => deny_wr_addr,
+      deny_rd                => deny_rd,
+      deny_rd_info           => deny_rd_info,
+      deny_rd_addr           => deny_rd_addr,
+      irq                    => deny_irq,
+      Bus2IP_Clk             => ipif_Bus2IP_Clk,
+      Bus2IP_Resetn          => rst_Bus2IP_Reset_tmp,
+      Bus2IP_Data            => ipif_Bus2IP_Data,
+      Bus2IP_RdCE            => deny_Bus2IP_RdCE,
+      Bus2IP_WrCE            => deny_Bus2IP_WrCE,
+      IP2Bus_Data            => deny_IP2Bus_Data,
+      IP2Bus_RdAck           => deny_IP2Bus_RdAck,
+      IP2Bus_WrAck           => deny_IP2Bus_WrAck,
+      IP2Bus_Error           => deny_IP2Bus_Error
+    );
+
   ------------------------------------------
   -- connect internal signals
   ------------------------------------------
-  IP2BUS_DATA_MUX_PROC : process( ipif_Bus2IP_CS, user_IP2Bus_Data ) is
+  IP2BUS_DATA_MUX_PROC : process(
+      ipif_Bus2IP_CS, user_IP2Bus_Data, deny_IP2Bus_Data
+      ) is
   begin
 
-    case ipif_Bus2IP_CS (1 downto 0)  is
-      when "01"   => ipif_IP2Bus_Data <= user_IP2Bus_Data;
-      when "10"   => ipif_IP2Bus_Data <= (others => '0');
+    case ipif_Bus2IP_CS (2 downto 0)  is
+      when "001"  => ipif_IP2Bus_Data <= user_IP2Bus_Data;
+      when "010"  => ipif_IP2Bus_Data <= deny_IP2Bus_Data;
+      when "100"  => ipif_IP2Bus_Data <= (others => '0');
       when others => ipif_IP2Bus_Data <= (others => '0');
     end case;
 
   end process IP2BUS_DATA_MUX_PROC;
 
-  ipif_IP2Bus_WrAck    <= user_IP2Bus_WrAck or rst_IP2Bus_WrAck;
-  ipif_IP2Bus_RdAck    <= user_IP2Bus_RdAck;
-  ipif_IP2Bus_Error    <= user_IP2Bus_Error or rst_IP2Bus_Error;
+  ipif_IP2Bus_WrAck    <= user_IP2Bus_WrAck or deny_IP2Bus_WrAck or
+                          rst_IP2Bus_WrAck;
+  ipif_IP2Bus_RdAck    <= user_IP2Bus_RdAck or deny_IP2Bus_RdAck;
+  ipif_IP2Bus_Error    <= user_IP2Bus_Error or deny_IP2Bus_Error or
+                          rst_IP2Bus_Error;
   user_Bus2IP_RdCE     <= ipif_Bus2IP_RdCE(USER_NUM_REG-1 downto 0);
   user_Bus2IP_WrCE     <= ipif_Bus2IP_WrCE(USER_NUM_REG-1 downto 0);
+  deny_Bus2IP_RdCE     <= ipif_Bus2IP_RdCE(
+                            DENY_CE_INDEX+DENY_NUM_CE-1 downto DENY_CE_INDEX
+                            );
+  deny_Bus2IP_WrCE     <= ipif_Bus2IP_WrCE(
+                            DENY_CE_INDEX+DENY_NUM_CE-1 downto DENY_CE_INDEX
+                            );
+  M_IRQ                <= user_M_IRQ or deny_irq;
   ipif_Bus2IP_Reset    <= not ipif_Bus2IP_Resetn;
   rst_Bus2IP_Reset_tmp <= not rst_Bus2IP_Reset;
 
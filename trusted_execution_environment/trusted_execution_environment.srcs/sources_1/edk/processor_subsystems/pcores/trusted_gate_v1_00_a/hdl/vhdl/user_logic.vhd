@@ -148,6 +148,24 @@ is
                                          downto 0
                                          );
 
+    -- address channels of the gated AXI transactions, on Bus2IP_Clk
+    GATE_AWADDR              : in    std_logic_vector(31 downto 0);
+    GATE_AWVALID             : in    std_logic;
+    GATE_AWREADY             : in    std_logic;
+    GATE_ARADDR              : in    std_logic_vector(31 downto 0);
+    GATE_ARVALID             : in    std_logic;
+    GATE_ARREADY             : in    std_logic;
+
+    -- one clock strobe for each denied write and each denied read, both
+    --  in the same clock when both were denied, with their details
+    DENY_KEY                 : out   std_logic_vector(31 downto 0);
+    DENY_WR_EVENT            : out   std_logic;
+    DENY_WR_INFO             : out   std_logic_vector(31 downto 0);
+    DENY_WR_ADDR             : out   std_logic_vector(31 downto 0);
+    DENY_RD_EVENT            : out   std_logic;
+    DENY_RD_INFO             : out   std_logic_vector(31 downto 0);
+    DENY_RD_ADDR             : out   std_logic_vector(31 downto 0);
+
     -- built-in ports
     Bus2IP_Clk               : in    std_logic;
     Bus2IP_Resetn            : in    std_logic;
@@ -173,7 +191,8 @@ end entity user_logic;
 architecture IMP of user_logic
 is
 
-  -- bit offsets for permissions
+  -- bit offsets for permissions, C_PERM_NUM also flags unknown keys
+  --  in denial reports
   constant C_PERM_NUM        : integer          := 12;
   constant C_PERM_CRIT       : integer          := 11;
   constant C_PERM_IO_I       : integer          := 10;
@@ -188,6 +207,9 @@ is
   constant C_PERM_BUSER      : integer          := 1;
   constant C_PERM_IRQ        : integer          := 0;
 
+  -- denial report bit set for writes
+  constant C_DENY_WRITE      : integer          := 16;
+
   type slv_regs_type is array(C_NUM_REG-1 downto 0)
     of std_logic_vector(C_SLV_DWIDTH-1 downto 0);
   signal keys                : slv_regs_type;
@@ -196,6 +218,21 @@ is
   signal slv_read_ack        : std_logic;
   signal slv_write_ack       : std_logic;
   signal stack_ptr           : integer;
+
+  -- result of the key lookup, permissions are 0 for unknown keys
+  signal key_found           : std_logic;
+  signal key_perms           : std_logic_vector(C_SLV_DWIDTH-1 downto 0);
+
+  -- AXI address handshakes being denied this clock
+  signal aw_deny_mask        : std_logic_vector(C_PERM_NUM downto 0);
+  signal ar_deny_mask        : std_logic_vector(C_PERM_NUM downto 0);
+
+  -- BRAM and interrupt levels being denied right now, and during the
+  --  last clock
+  signal wr_deny_mask        : std_logic_vector(C_PERM_NUM downto 0);
+  signal rd_deny_mask        : std_logic_vector(C_PERM_NUM downto 0);
+  signal last_wr_deny_mask   : std_logic_vector(C_PERM_NUM downto 0);
+  signal last_rd_deny_mask   : std_logic_vector(C_PERM_NUM downto 0);
 begin
 
   -- send the state of the table constantly
@@ -335,6 +372,15 @@ begin
       end if;
     end loop;
 
+    -- report the lookup for denial tracking
+    key_found <= fr;
+    if fr = '1'
+    then
+      key_perms <= permissions(fid);
+    else
+      key_perms <= (others => '0');
+    end if;
+
     -- if we don't have a matching key, shut everything off
     if fr = '0'
     then
@@ -411,6 +457,121 @@ begin
 
   end process USE_KEY_PROC;
 
+  -- work out which attempted accesses the current key is refused
+  DENY_MASK_PROC : process (
+      key_found, key_perms, GATE_AWVALID, GATE_AWREADY, GATE_ARVALID,
+      GATE_ARREADY, S_AXI_AWPROT, S_AXI_ARPROT, S_BRAM_RE, S_BRAM_WE, S_IRQ
+      )
+  is
+    variable aw : std_logic_vector(C_PERM_NUM downto 0);
+    variable ar : std_logic_vector(C_PERM_NUM downto 0);
+    variable wr : std_logic_vector(C_PERM_NUM downto 0);
+    variable rd : std_logic_vector(C_PERM_NUM downto 0);
+  begin
+
+    aw := (others => '0');
+    ar := (others => '0');
+    wr := (others => '0');
+    rd := (others => '0');
+
+    -- unknown keys are refused anything they attempt
+    if key_found = '0'
+    then
+      aw(C_PERM_NUM) := GATE_AWVALID and GATE_AWREADY;
+      ar(C_PERM_NUM) := GATE_ARVALID and GATE_ARREADY;
+      wr(C_PERM_NUM) := S_BRAM_WE;
+      rd(C_PERM_NUM) := S_BRAM_RE or S_IRQ;
+
+    -- known keys are refused what their permissions leave out, each
+    --  AXI transaction once, as its address is accepted
+    else
+      if GATE_AWVALID = '1' and GATE_AWREADY = '1' and
+        S_AXI_AWPROT /= "010" and key_perms(C_PERM_CRIT) = '0'
+      then
+        aw(C_PERM_CRIT) := '1';
+      end if;
+      if GATE_ARVALID = '1' and GATE_ARREADY = '1' and
+        S_AXI_ARPROT /= "010" and key_perms(C_PERM_CRIT) = '0'
+      then
+        ar(C_PERM_CRIT) := '1';
+      end if;
+      if S_BRAM_WE = '1' and key_perms(C_PERM_MEM_W) = '0'
+      then
+        wr(C_PERM_MEM_W) := '1';
+      end if;
+      if S_BRAM_RE = '1' and key_perms(C_PERM_MEM_R) = '0'
+      then
+        rd(C_PERM_MEM_R) := '1';
+      end if;
+      if S_IRQ = '1' and key_perms(C_PERM_IRQ) = '0'
+      then
+        rd(C_PERM_IRQ) := '1';
+      end if;
+    end if;
+
+    aw_deny_mask <= aw;
+    ar_deny_mask <= ar;
+    wr_deny_mask <= wr;
+    rd_deny_mask <= rd;
+
+  end process DENY_MASK_PROC;
+
+  ---
+  -- Report every denied AXI handshake, and each BRAM or interrupt denial
+  --  once, when it starts. Writes and reads are reported separately, so a
+  --  write and a read denied in the same clock are both kept, each with
+  --  its own address.
+  ---
+  DENY_EVENT_PROC : process( Bus2IP_Clk )
+  is
+    variable wr : std_logic_vector(C_PERM_NUM downto 0);
+    variable rd : std_logic_vector(C_PERM_NUM downto 0);
+  begin
+
+    if Bus2IP_Clk'event and Bus2IP_Clk = '1'
+    then
+
+      -- reset requested
+      if Bus2IP_Resetn = '0'
+      then
+        last_wr_deny_mask <= (others => '0');
+        last_rd_deny_mask <= (others => '0');
+        DENY_WR_EVENT     <= '0';
+        DENY_RD_EVENT     <= '0';
+
+      else
+        wr := aw_deny_mask or (wr_deny_mask and not last_wr_deny_mask);
+        rd := ar_deny_mask or (rd_deny_mask and not last_rd_deny_mask);
+        last_wr_deny_mask <= wr_deny_mask;
+        last_rd_deny_mask <= rd_deny_mask;
+
+        if wr /= (wr'range => '0')
+        then
+          DENY_WR_EVENT <= '1';
+        else
+          DENY_WR_EVENT <= '0';
+        end if;
+        if rd /= (rd'range => '0')
+        then
+          DENY_RD_EVENT <= '1';
+        else
+          DENY_RD_EVENT <= '0';
+        end if;
+
+        DENY_KEY     <= KEY_IN;
+        DENY_WR_INFO <= (others => '0');
+        DENY_WR_INFO(C_PERM_NUM downto 0) <= wr;
+        DENY_WR_INFO(C_DENY_WRITE) <= '1';
+        DENY_WR_ADDR <= GATE_AWADDR;
+        DENY_RD_INFO <= (others => '0');
+        DENY_RD_INFO(C_PERM_NUM downto 0) <= rd;
+        DENY_RD_ADDR <= GATE_ARADDR;
+      end if;
+
+    end if;
+
+  end process DENY_EVENT_PROC;
+
   -- send data back out to the world
   IP2Bus_Data  <= slv_ip2bus_data when slv_read_ack = '1' else (others => '0');
   IP2Bus_WrAck <= slv_write_ack;
@@ -0,0 +1,193 @@
+-- Filename:          key_bank.vhd
+-- Version:           1.00.a
+-- Description:       block RAM bank of keys, selected by index
+-- Date Created:      Sun, Oct 18, 2026 16:02:33
+-- Last Modified:     Sun, Oct 18, 2026 16:02:33
+-- VHDL Standard:     VHDL'93
+-- Author:            agent <agent@local>
+-- Copyright:         (c) 2026 Assured Information Security, All Rights Reserved
+
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+
+---
+-- Indexed key bank
+--
+-- Holds C_KEY_BANK_DEPTH keys in a dual port block RAM. Software fills the
+--  bank through one port, and selecting a key reads it through the other,
+--  so switching keys always takes 2 clocks whatever the bank size:
+--  1 to read the block RAM, 1 for user_logic to load KEY_OUT.
+--
+-- Registers, in their own IPIF address range:
+--
+-- +---+--------+------------------------------------------------------+
+-- | 0 | INDEX  | key read and written through DATA                    |
+-- | 1 | DATA   | the key at INDEX, writing it moves INDEX on by 1     |
+-- | 2 | SELECT | writing an index sends that key out on KEY_OUT,      |
+-- |   |        |  reading returns the index last selected             |
+-- | 3 | DEPTH  | C_KEY_BANK_DEPTH, read only                          |
+-- +---+--------+------------------------------------------------------+
+---
+entity key_bank
+is
+  generic
+  (
+    -- number of keys held, must be a power of 2
+    C_KEY_BANK_DEPTH : integer            := 256;
+
+    -- built-in generics
+    C_NUM_REG        : integer            := 4;
+    C_SLV_DWIDTH     : integer            := 32
+  );
+  port
+  (
+    -- the selected key, and a one clock strobe once it is valid
+    key              : out   std_logic_vector(31 downto 0);
+    key_load         : out   std_logic;
+
+    -- built-in ports
+    Bus2IP_Clk       : in    std_logic;
+    Bus2IP_Resetn    : in    std_logic;
+    Bus2IP_Data      : in    std_logic_vector(C_SLV_DWIDTH-1 downto 0);
+    Bus2IP_RdCE      : in    std_logic_vector(C_NUM_REG-1 downto 0);
+    Bus2IP_WrCE      : in    std_logic_vector(C_NUM_REG-1 downto 0);
+    IP2Bus_Data      : out   std_logic_vector(C_SLV_DWIDTH-1 downto 0);
+    IP2Bus_RdAck     : out   std_logic;
+    IP2Bus_WrAck     : out   std_logic;
+    IP2Bus_Error     : out   std_logic
+  );
+
+end entity key_bank;
+
+architecture IMP of key_bank
+is
+
+  -- register numbers
+  constant BANK_INDEX  : integer          := 0;
+  constant BANK_DATA   : integer          := 1;
+  constant BANK_SELECT : integer          := 2;
+  constant BANK_DEPTH  : integer          := 3;
+
+  type bank_type is array(0 to C_KEY_BANK_DEPTH-1)
+    of std_logic_vector(31 downto 0);
+  signal bank          : bank_type;
+
+  -- software port address and registered read
+  signal index         : integer range 0 to C_KEY_BANK_DEPTH-1;
+  signal index_key     : std_logic_vector(31 downto 0);
+
+  -- selection port address, and whether a selection is being read out
+  signal sel_index     : integer range 0 to C_KEY_BANK_DEPTH-1;
+  signal sel_pending   : std_logic;
+
+  -- decoded register numbers, C_NUM_REG when none is selected
+  signal rd_sel        : integer range 0 to C_NUM_REG;
+  signal wr_sel        : integer range 0 to C_NUM_REG;
+
+begin
+
+  -- decode register numbers
+  DECODE_PROC : process( Bus2IP_RdCE, Bus2IP_WrCE )
+  is
+  begin
+    rd_sel <= C_NUM_REG;
+    wr_sel <= C_NUM_REG;
+    for i in C_NUM_REG-1 downto 0
+    loop
+      if Bus2IP_RdCE(C_NUM_REG-1 - i) = '1'
+      then
+        rd_sel <= i;
+      end if;
+      if Bus2IP_WrCE(C_NUM_REG-1 - i) = '1'
+      then
+        wr_sel <= i;
+      end if;
+    end loop;
+  end process DECODE_PROC;
+
+  -- read back registers, the key at INDEX is already registered
+  with rd_sel select IP2Bus_Data <=
+    std_logic_vector(to_unsigned(index, C_SLV_DWIDTH))     when BANK_INDEX,
+    index_key                                              when BANK_DATA,
+    std_logic_vector(to_unsigned(sel_index, C_SLV_DWIDTH)) when BANK_SELECT,
+    std_logic_vector(to_unsigned(C_KEY_BANK_DEPTH, C_SLV_DWIDTH))
+                                                           when BANK_DEPTH,
+    (others => '0')                                        when others;
+
+  ---
+  -- Software port, fills the bank
+  ---
+  BANK_WRITE_PROC : process( Bus2IP_Clk )
+  is
+  begin
+
+    if Bus2IP_Clk'event and Bus2IP_Clk = '1'
+    then
+
+      -- block RAM write first, then registered read
+      if wr_sel = BANK_DATA
+      then
+        bank(index) <= Bus2IP_Data;
+      end if;
+      index_key <= bank(index);
+
+      -- reset requested
+      if Bus2IP_Resetn = '0'
+      then
+        index <= 0;
+
+      elsif wr_sel = BANK_INDEX
+      then
+        index <= to_integer(unsigned(Bus2IP_Data)) mod C_KEY_BANK_DEPTH;
+
+      elsif wr_sel = BANK_DATA
+      then
+        index <= (index + 1) mod C_KEY_BANK_DEPTH;
+      end if;
+
+    end if;
+
+  end process BANK_WRITE_PROC;
+
+  ---
+  -- Selection port, sends a key out 1 clock after it is selected
+  ---
+  BANK_SELECT_PROC : process( Bus2IP_Clk )
+  is
+  begin
+
+    if Bus2IP_Clk'event and Bus2IP_Clk = '1'
+    then
+
+      -- registered block RAM read
+      key <= bank(sel_index);
+
+      -- reset requested
+      if Bus2IP_Resetn = '0'
+      then
+        sel_index   <= 0;
+        sel_pending <= '0';
+        key_load    <= '0';
+
+      else
+        key_load    <= sel_pending;
+        sel_pending <= '0';
+        if wr_sel = BANK_SELECT
+        then
+          sel_index   <=
+            to_integer(unsigned(Bus2IP_Data)) mod C_KEY_BANK_DEPTH;
+          sel_pending <= '1';
+        end if;
+      end if;
+
+    end if;
+
+  end process BANK_SELECT_PROC;
+
+  -- every register acknowledges right away
+  IP2Bus_RdAck <= '1' when rd_sel /= C_NUM_REG else '0';
+  IP2Bus_WrAck <= '1' when wr_sel /= C_NUM_REG else '0';
+  IP2Bus_Error <= '0';
+
+end IMP;
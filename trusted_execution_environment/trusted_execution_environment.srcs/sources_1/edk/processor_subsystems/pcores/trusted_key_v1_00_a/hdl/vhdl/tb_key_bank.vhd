@@ -0,0 +1,328 @@
+-- Filename:          tb_key_bank.vhd
+-- Version:           1.00.a
+-- Description:       simulation testbench timing key bank selections
+--                    through to KEY_OUT across bank depths
+-- Date Created:      Sun, Oct 18, 2026 19:05:12
+-- Last Modified:     Sun, Oct 18, 2026 19:05:12
+-- VHDL Standard:     VHDL'93
+-- Author:            agent <agent@local>
+-- Copyright:         (c) 2026 Assured Information Security, All Rights Reserved
+--
+-- Simulation only, not listed in the .pao. user_logic needs
+--  proc_common_pkg from EDK's proc_common_v3_00_a, and std_logic_arith.
+--  With GHDL, from this directory:
+--
+--   ghdl -a -fsynopsys --work=proc_common_v3_00_a \
+--     <EDK>/hw/XilinxProcessorIPLib/pcores/proc_common_v3_00_a/hdl/vhdl/proc_common_pkg.vhd
+--   ghdl -a -fsynopsys --work=trusted_key_v1_00_a key_bank.vhd \
+--     user_logic.vhd tb_key_bank.vhd
+--   ghdl -e -fsynopsys --work=trusted_key_v1_00_a tb_key_bank
+--   ghdl -r -fsynopsys --work=trusted_key_v1_00_a tb_key_bank
+
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+
+library trusted_key_v1_00_a;
+use trusted_key_v1_00_a.key_bank;
+use trusted_key_v1_00_a.user_logic;
+
+---
+-- One bank depth
+--
+-- Fills a C_KEY_BANK_DEPTH key bank through INDEX and DATA, then selects
+--  the first, last and middle keys followed by C_SELECTS others spread
+--  by an xorshift, and counts the clocks from the edge taking each
+--  SELECT write to the edge loading the key into user_logic's KEY_OUT.
+--  Reports the least, mean and most, and fails if KEY_OUT ever gets the
+--  wrong key or takes other than C_EXPECTED clocks.
+---
+entity tb_key_bank_depth
+is
+  generic
+  (
+    C_KEY_BANK_DEPTH : integer            := 256;
+
+    -- selections timed after the first, last and middle keys
+    C_SELECTS        : integer            := 64;
+
+    -- clocks key_bank promises whatever the depth
+    C_EXPECTED       : integer            := 2
+  );
+end entity tb_key_bank_depth;
+
+architecture IMP of tb_key_bank_depth
+is
+
+  constant CLK_PERIOD  : time := 10 ns;
+
+  -- user_logic's registers as the system instantiates it
+  constant USER_NUM_REG : integer := 32;
+
+  -- key_bank register numbers
+  constant BANK_INDEX  : integer := 0;
+  constant BANK_DATA   : integer := 1;
+  constant BANK_SELECT : integer := 2;
+  constant BANK_NUM_CE : integer := 4;
+
+  -- the key stored at an index, never 0 and never another index's
+  function bank_key_at(i : integer) return std_logic_vector is
+  begin
+    return X"CE" & std_logic_vector(to_unsigned(i, 24));
+  end function bank_key_at;
+
+  signal clk           : std_logic := '0';
+  signal resetn        : std_logic := '0';
+  signal done          : std_logic := '0';
+
+  signal bus2ip_data   : std_logic_vector(31 downto 0) := (others => '0');
+  signal bank_wrce     : std_logic_vector(BANK_NUM_CE-1 downto 0)
+    := (others => '0');
+  signal bank_rdce     : std_logic_vector(BANK_NUM_CE-1 downto 0)
+    := (others => '0');
+  signal user_wrce     : std_logic_vector(USER_NUM_REG-1 downto 0)
+    := (others => '0');
+  signal user_rdce     : std_logic_vector(USER_NUM_REG-1 downto 0)
+    := (others => '0');
+  signal bank_data     : std_logic_vector(31 downto 0);
+  signal bank_rdack    : std_logic;
+  signal bank_wrack    : std_logic;
+  signal bank_error    : std_logic;
+  signal user_data     : std_logic_vector(31 downto 0);
+  signal user_rdack    : std_logic;
+  signal user_wrack    : std_logic;
+  signal user_error    : std_logic;
+
+  signal bank_key      : std_logic_vector(31 downto 0);
+  signal bank_load     : std_logic;
+  signal key_out       : std_logic_vector(31 downto 0);
+
+  signal awprot        : std_logic_vector(2 downto 0);
+  signal arprot        : std_logic_vector(2 downto 0);
+  signal awuser        : std_logic_vector(31 downto 0);
+  signal aruser        : std_logic_vector(31 downto 0);
+  signal wuser         : std_logic_vector(31 downto 0);
+
+begin
+
+  -- stops once done, so the simulation runs out of events
+  clk <= not clk after CLK_PERIOD / 2 when done = '0' else clk;
+
+  KEY_BANK_I : entity trusted_key_v1_00_a.key_bank
+    generic map
+    (
+      C_KEY_BANK_DEPTH       => C_KEY_BANK_DEPTH,
+      C_NUM_REG              => BANK_NUM_CE,
+      C_SLV_DWIDTH           => 32
+    )
+    port map
+    (
+      key                    => bank_key,
+      key_load               => bank_load,
+      Bus2IP_Clk             => clk,
+      Bus2IP_Resetn          => resetn,
+      Bus2IP_Data            => bus2ip_data,
+      Bus2IP_RdCE            => bank_rdce,
+      Bus2IP_WrCE            => bank_wrce,
+      IP2Bus_Data            => bank_data,
+      IP2Bus_RdAck           => bank_rdack,
+      IP2Bus_WrAck           => bank_wrack,
+      IP2Bus_Error           => bank_error
+    );
+
+  USER_LOGIC_I : entity trusted_key_v1_00_a.user_logic
+    generic map
+    (
+      C_M_USER_WIDTH         => 32,
+      C_NUM_REG              => USER_NUM_REG,
+      C_SLV_DWIDTH           => 32
+    )
+    port map
+    (
+      S_AXI_AWPROT           => "000",
+      S_AXI_ARPROT           => "000",
+      M_AXI_AWPROT           => awprot,
+      M_AXI_ARPROT           => arprot,
+      M_AXI_AWUSER           => awuser,
+      M_AXI_ARUSER           => aruser,
+      M_AXI_WUSER            => wuser,
+      M_AXI_RUSER            => X"00000000",
+      M_AXI_BUSER            => X"00000000",
+      KEY_OUT                => key_out,
+      BANK_KEY               => bank_key,
+      BANK_LOAD              => bank_load,
+      Bus2IP_Clk             => clk,
+      Bus2IP_Resetn          => resetn,
+      Bus2IP_Data            => bus2ip_data,
+      Bus2IP_BE              => "1111",
+      Bus2IP_RdCE            => user_rdce,
+      Bus2IP_WrCE            => user_wrce,
+      IP2Bus_Data            => user_data,
+      IP2Bus_RdAck           => user_rdack,
+      IP2Bus_WrAck           => user_wrack,
+      IP2Bus_Error           => user_error
+    );
+
+  ---
+  -- Fill, select, and time
+  ---
+  STIMULUS_PROC : process
+  is
+    variable lfsr     : unsigned(31 downto 0) := X"2545F491";
+    variable index    : integer;
+    variable last     : integer := -1;
+    variable clks     : integer;
+    variable least    : integer := integer'high;
+    variable most     : integer := 0;
+    variable total    : integer := 0;
+    variable selects  : integer := 0;
+    variable errors   : integer := 0;
+
+    -- one IPIF write to a key_bank register, held for the edge taking it
+    procedure bank_write(reg : in integer; data : in integer) is
+    begin
+      bus2ip_data <= std_logic_vector(to_unsigned(data, 32));
+      bank_wrce   <= (others => '0');
+      bank_wrce(BANK_NUM_CE-1 - reg) <= '1';
+      wait until clk'event and clk = '1';
+      bank_wrce   <= (others => '0');
+    end procedure bank_write;
+
+    procedure bank_fill(i : in integer) is
+    begin
+      bus2ip_data <= bank_key_at(i);
+      bank_wrce   <= (others => '0');
+      bank_wrce(BANK_NUM_CE-1 - BANK_DATA) <= '1';
+      wait until clk'event and clk = '1';
+      bank_wrce   <= (others => '0');
+    end procedure bank_fill;
+
+  begin
+
+    resetn <= '0';
+    for i in 1 to 4
+    loop
+      wait until clk'event and clk = '1';
+    end loop;
+    resetn <= '1';
+    wait until clk'event and clk = '1';
+
+    -- fill the bank, DATA moving INDEX on after every key
+    bank_write(BANK_INDEX, 0);
+    for i in 0 to C_KEY_BANK_DEPTH-1
+    loop
+      bank_fill(i);
+    end loop;
+
+    for s in 0 to C_SELECTS+2
+    loop
+
+      -- first, last and middle keys, then spread by an xorshift
+      case s
+      is
+        when 0      => index := 0;
+        when 1      => index := C_KEY_BANK_DEPTH-1;
+        when 2      => index := C_KEY_BANK_DEPTH/2;
+        when others =>
+          lfsr  := lfsr xor shift_left(lfsr, 13);
+          lfsr  := lfsr xor shift_right(lfsr, 17);
+          lfsr  := lfsr xor shift_left(lfsr, 5);
+          index := to_integer(lfsr(23 downto 0)) mod C_KEY_BANK_DEPTH;
+      end case;
+
+      -- selecting the key already out would change nothing to time
+      if index /= last
+      then
+
+        -- clocks after the edge taking SELECT until KEY_OUT has the key,
+        --  looked at between edges
+        bank_write(BANK_SELECT, index);
+        clks := 0;
+        loop
+          wait until clk'event and clk = '0';
+          exit when key_out = bank_key_at(index) or clks > 16;
+          wait until clk'event and clk = '1';
+          clks := clks + 1;
+        end loop;
+
+        if key_out /= bank_key_at(index) or clks /= C_EXPECTED
+        then
+          errors := errors + 1;
+          assert errors > 8
+            report "depth " & integer'image(C_KEY_BANK_DEPTH) & ": key "
+              & integer'image(index) & " took "
+              & integer'image(clks) & " clocks"
+            severity error;
+        end if;
+
+        if clks < least
+        then
+          least := clks;
+        end if;
+        if clks > most
+        then
+          most := clks;
+        end if;
+        total   := total + clks;
+        selects := selects + 1;
+        last    := index;
+
+        wait until clk'event and clk = '1';
+      end if;
+
+    end loop;
+
+    report "depth " & integer'image(C_KEY_BANK_DEPTH) & ": "
+      & integer'image(selects) & " selects, SELECT write to KEY_OUT "
+      & integer'image(least) & " min, "
+      & integer'image(total / selects) & "."
+      & integer'image((10 * total / selects) mod 10) & " mean, "
+      & integer'image(most) & " max clocks"
+      severity note;
+    assert errors = 0
+      report "depth " & integer'image(C_KEY_BANK_DEPTH) & ": "
+        & integer'image(errors) & " selects wrong or not "
+        & integer'image(C_EXPECTED) & " clocks"
+      severity failure;
+
+    done <= '1';
+    wait;
+
+  end process STIMULUS_PROC;
+
+end IMP;
+
+library ieee;
+use ieee.std_logic_1164.all;
+
+library trusted_key_v1_00_a;
+use trusted_key_v1_00_a.tb_key_bank_depth;
+
+---
+-- Key bank depth sweep
+--
+-- Runs tb_key_bank_depth side by side for each depth in DEPTHS, so one
+--  run shows whether selection time depends on the bank size.
+---
+entity tb_key_bank
+is
+end entity tb_key_bank;
+
+architecture IMP of tb_key_bank
+is
+
+  type depth_list is array(natural range <>) of integer;
+  constant DEPTHS : depth_list := (16, 256, 4096);
+
+begin
+
+  SWEEP : for i in DEPTHS'range
+  generate
+    DEPTH_I : entity trusted_key_v1_00_a.tb_key_bank_depth
+      generic map
+      (
+        C_KEY_BANK_DEPTH => DEPTHS(i)
+      );
+  end generate SWEEP;
+
+end IMP;
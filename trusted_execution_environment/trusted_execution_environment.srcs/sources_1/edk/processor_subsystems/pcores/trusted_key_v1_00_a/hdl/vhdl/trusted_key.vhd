@@ -72,6 +72,7 @@ use axi_lite_ipif_v1_01_a.axi_lite_ipif;
 
 library trusted_key_v1_00_a;
 use trusted_key_v1_00_a.user_logic;
+use trusted_key_v1_00_a.key_bank;
 
 ------------------------------------------------------------------------------
 -- Entity section
@@ -122,11 +123,12 @@ entity trusted_key is
   (
     -- user generics
     C_M_USER_WIDTH           : integer            := 32;
+    C_KEY_BANK_DEPTH         : integer            := 256;
 
     -- built-in generics
     C_S_AXI_DATA_WIDTH       : integer            := 32;
     C_S_AXI_ADDR_WIDTH       : integer            := 32;
-    C_S_AXI_MIN_SIZE         : std_logic_vector   := X"000001FF";
+    C_S_AXI_MIN_SIZE         : std_logic_vector   := X"000003FF";
     C_USE_WSTRB              : integer            := 0;
     C_DPHASE_TIMEOUT         : integer            := 8;
     C_BASEADDR               : std_logic_vector   := X"FFFFFFFF";
@@ -215,30 +217,39 @@ architecture IMP of trusted_key is
   constant RST_HIGHADDR      : std_logic_vector := C_BASEADDR or X"000001FF";
   constant USER_SLV_BASEADDR : std_logic_vector := C_BASEADDR or X"00000000";
   constant USER_SLV_HIGHADDR : std_logic_vector := C_BASEADDR or X"000000FF";
+  constant BANK_BASEADDR     : std_logic_vector := C_BASEADDR or X"00000200";
+  constant BANK_HIGHADDR     : std_logic_vector := C_BASEADDR or X"000002FF";
 
   constant IPIF_ARD_ADDR_RANGE_ARRAY : SLV64_ARRAY_TYPE :=
   (
     ZERO_ADDR_PAD & RST_BASEADDR,      -- soft reset space base address
     ZERO_ADDR_PAD & RST_HIGHADDR,      -- soft reset space high address
+    ZERO_ADDR_PAD & BANK_BASEADDR,     -- key bank space base address
+    ZERO_ADDR_PAD & BANK_HIGHADDR,     -- key bank space high address
     ZERO_ADDR_PAD & USER_SLV_BASEADDR, -- user logic slave space base address
     ZERO_ADDR_PAD & USER_SLV_HIGHADDR  -- user logic slave space high address
   );
 
   constant RST_NUM_CE        : integer := 1;
+  constant BANK_NUM_CE       : integer := 4;
   constant USER_SLV_NUM_REG  : integer := C_NUM_REG;
   constant USER_NUM_REG      : integer := USER_SLV_NUM_REG;
-  constant TOTAL_IPIF_CE     : integer := USER_NUM_REG + RST_NUM_CE;
+  constant TOTAL_IPIF_CE     : integer :=
+    USER_NUM_REG + BANK_NUM_CE + RST_NUM_CE;
 
   constant IPIF_ARD_NUM_CE_ARRAY : INTEGER_ARRAY_TYPE :=
   (
     0  => (RST_NUM_CE),      -- number of ce for soft reset space
-    1  => (USER_SLV_NUM_REG) -- number of ce for user logic slave space
+    1  => (BANK_NUM_CE),     -- number of ce for key bank space
+    2  => (USER_SLV_NUM_REG) -- number of ce for user logic slave space
   );
 
   constant RESET_WIDTH       : integer          := 8;
   constant RST_CS_INDEX      : integer          := 0;
-  constant RST_CE_INDEX      : integer          := USER_NUM_REG;
-  constant USER_SLV_CS_INDEX : integer          := 1;
+  constant RST_CE_INDEX      : integer          := USER_NUM_REG + BANK_NUM_CE;
+  constant BANK_CS_INDEX     : integer          := 1;
+  constant BANK_CE_INDEX     : integer          := USER_NUM_REG;
+  constant USER_SLV_CS_INDEX : integer          := 2;
   constant USER_SLV_CE_INDEX : integer          := calc_start_ce_index(IPIF_ARD_NUM_CE_ARRAY, USER_SLV_CS_INDEX);
 
   constant USER_CE_INDEX     : integer          := USER_SLV_CE_INDEX;
@@ -276,6 +287,14 @@ architecture IMP of trusted_key is
   signal user_IP2Bus_RdAck   : std_logic;
   signal user_IP2Bus_WrAck   : std_logic;
   signal user_IP2Bus_Error   : std_logic;
+  signal bank_Bus2IP_RdCE    : std_logic_vector(BANK_NUM_CE-1 downto 0);
+  signal bank_Bus2IP_WrCE    : std_logic_vector(BANK_NUM_CE-1 downto 0);
+  signal bank_IP2Bus_Data    : std_logic_vector(USER_SLV_DWIDTH-1 downto 0);
+  signal bank_IP2Bus_RdAck   : std_logic;
+  signal bank_IP2Bus_WrAck   : std_logic;
+  signal bank_IP2Bus_Error   : std_logic;
+  signal bank_key            : std_logic_vector(31 downto 0);
+  signal bank_load           : std_logic;
 
 begin
 
@@ -378,6 +397,8 @@ begin
       M_AXI_RUSER            => M_AXI_RUSER,
       M_AXI_BUSER            => M_AXI_BUSER,
       KEY_OUT                => KEY_OUT,
+      BANK_KEY               => bank_key,
+      BANK_LOAD              => bank_load,
 
       -- map built-in ports
       Bus2IP_Clk             => ipif_Bus2IP_Clk,
@@ -392,25 +413,61 @@ begin
       IP2Bus_Error           => user_IP2Bus_Error
     );
 
+  ------------------------------------------
+  -- instantiate key bank
+  ------------------------------------------
+  KEY_BANK_I : entity trusted_key_v1_00_a.key_bank
+    generic map
+    (
+      C_KEY_BANK_DEPTH       => C_KEY_BANK_DEPTH,
+      C_NUM_REG              => BANK_NUM_CE,
+      C_SLV_DWIDTH           => USER_SLV_DWIDTH
+    )
+    port map
+    (
+      key                    => bank_key,
+      key_load               => bank_load,
+      Bus2IP_Clk             => ipif_Bus2IP_Clk,
+      Bus2IP_Resetn          => rst_Bus2IP_Reset_tmp,
+      Bus2IP_Data            => ipif_Bus2IP_Data,
+      Bus2IP_RdCE            => bank_Bus2IP_RdCE,
+      Bus2IP_WrCE            => bank_Bus2IP_WrCE,
+      IP2Bus_Data            => bank_IP2Bus_Data,
+      IP2Bus_RdAck           => bank_IP2Bus_RdAck,
+      IP2Bus_WrAck           => bank_IP2Bus_WrAck,
+      IP2Bus_Error           => bank_IP2Bus_Error
+    );
+
   ------------------------------------------
   -- connect internal signals
   ------------------------------------------
-  IP2BUS_DATA_MUX_PROC : process( ipif_Bus2IP_CS, user_IP2Bus_Data ) is
+  IP2BUS_DATA_MUX_PROC : process(
+      ipif_Bus2IP_CS, user_IP2Bus_Data, bank_IP2Bus_Data
+      ) is
   begin
 
-    case ipif_Bus2IP_CS (1 downto 0)  is
-      when "01"   => ipif_IP2Bus_Data <= user_IP2Bus_Data;
-      when "10"   => ipif_IP2Bus_Data <= (others => '0');
+    case ipif_Bus2IP_CS (2 downto 0)  is
+      when "001"  => ipif_IP2Bus_Data <= user_IP2Bus_Data;
+      when "010"  => ipif_IP2Bus_Data <= bank_IP2Bus_Data;
+      when "100"  => ipif_IP2Bus_Data <= (others => '0');
       when others => ipif_IP2Bus_Data <= (others => '0');
     end case;
 
   end process IP2BUS_DATA_MUX_PROC;
 
-  ipif_IP2Bus_WrAck    <= user_IP2Bus_WrAck or rst_IP2Bus_WrAck;
-  ipif_IP2Bus_RdAck    <= user_IP2Bus_RdAck;
-  ipif_IP2Bus_Error    <= user_IP2Bus_Error or rst_IP2Bus_Error;
+  ipif_IP2Bus_WrAck    <= user_IP2Bus_WrAck or bank_IP2Bus_WrAck or
+                          rst_IP2Bus_WrAck;
+  ipif_IP2Bus_RdAck    <= user_IP2Bus_RdAck or bank_IP2Bus_RdAck;
+  ipif_IP2Bus_Error    <= user_IP2Bus_Error or bank_IP2Bus_Error or
+                          rst_IP2Bus_Error;
   user_Bus2IP_RdCE     <= ipif_Bus2IP_RdCE(USER_NUM_REG-1 downto 0);
   user_Bus2IP_WrCE     <= ipif_Bus2IP_WrCE(USER_NUM_REG-1 downto 0);
+  bank_Bus2IP_RdCE     <= ipif_Bus2IP_RdCE(
+                            BANK_CE_INDEX+BANK_NUM_CE-1 downto BANK_CE_INDEX
+                            );
+  bank_Bus2IP_WrCE     <= ipif_Bus2IP_WrCE(
+                            BANK_CE_INDEX+BANK_NUM_CE-1 downto BANK_CE_INDEX
+                            );
   ipif_Bus2IP_Reset    <= not ipif_Bus2IP_Resetn;
   rst_Bus2IP_Reset_tmp <= not rst_Bus2IP_Reset;
 
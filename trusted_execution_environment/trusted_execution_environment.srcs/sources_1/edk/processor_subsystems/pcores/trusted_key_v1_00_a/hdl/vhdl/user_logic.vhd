@@ -120,6 +120,10 @@ entity user_logic is
                                          );
     KEY_OUT                  : out   std_logic_vector(31 downto 0);
 
+    -- key selected from the key bank, loaded into KEY_OUT on the strobe
+    BANK_KEY                 : in    std_logic_vector(31 downto 0);
+    BANK_LOAD                : in    std_logic;
+
     -- built-in ports
     Bus2IP_Clk               : in    std_logic;
     Bus2IP_Resetn            : in    std_logic;
@@ -269,6 +273,11 @@ begin
           arprot(1) <= bus2ip_data(C_ID_UARPROT);
 
         end if;
+
+      -- swap the output key with one selected from the key bank
+      elsif BANK_LOAD = '1'
+      then
+        KEY_OUT <= BANK_KEY;
       end if;
     end if;
 